@@ -55,6 +55,10 @@
 #include "DeviceFactory.h"
 #include "jsinterface.h"
 
+/** Local history of the DCU values
+ */
+#include "DcuHistoryStore.h"
+
 // Interface to send the messages
 #include "XPditor.h"
 
@@ -158,6 +162,22 @@ class DcuFilter: public TrackerCommandSender,public JsInterface {
    */
   xdata::UnsignedLong blockDpToBeSent_ ;
 
+  /** Directory of the local history of the DCU raw values, no history if empty
+   */
+  xdata::String dcuHistoryDirectory_ ;
+
+  /** Deadband in ADC counts: a DCU is significant if one of its channels moved by more than this value
+   */
+  xdata::UnsignedLong dcuDeadband_ ;
+
+  /** Compression deviation of the history in ADC counts
+   */
+  xdata::UnsignedLong dcuCompressionDeviation_ ;
+
+  /** Upload only the significant DCUs in file and in database (the history must be set)
+   */
+  xdata::Boolean uploadOnlySignificant_ ;
+
   /** Machine name for PVSS
    */
   xdata::String pvssClassName_ ;
@@ -382,6 +402,10 @@ class DcuFilter: public TrackerCommandSender,public JsInterface {
    */
   toolbox::BSem *mutexVectorQueue_ ;
 
+  /** Local history of the DCU values, created in the upload work loop
+   */
+  DcuHistoryStore *dcuHistory_ ;
+
   /** Number of FecSupervisors
    */
   unsigned int fecSupervisorNumbers_ ;
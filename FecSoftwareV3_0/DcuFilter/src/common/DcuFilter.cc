@@ -161,6 +161,10 @@ XDAQ_INSTANTIATOR_IMPL( DcuFilter );
  * <li><i>fireItemAvailable(std::string("TimePVSSSend"),&timePVSSSend_)</i>: Time between 2 DCUs send to PVSS in case of the channels did not change
  * <li><i>fireItemAvailable(std::string("PourcentDifferenceForPVSS"),&pourcentDifferenceForPVSS_)</i>: to set a level of difference in the DCU raw data to be sent to PVSS. If the level is reach in the DCU raw data then the values are sent to PVSS.
  * <li><i>fireItemAvailable(std::string("BlockDpToBeSent"),&blockDpToBeSent_)</i>: the performance of the send of DPs set in block but the block should be limitated. So this value give the maximum size.
+ * <li><i>fireItemAvailable(std::string("DcuHistoryDirectory"),&dcuHistoryDirectory_)</i>: directory of the compressed history of the DCU raw data, no history if empty
+ * <li><i>fireItemAvailable(std::string("DcuDeadband"),&dcuDeadband_)</i>: a DCU is significant if one channel moved by more than this number of ADC counts since the last time it was significant
+ * <li><i>fireItemAvailable(std::string("DcuCompressionDeviation"),&dcuCompressionDeviation_)</i>: maximum difference in ADC counts between the values received and the history
+ * <li><i>fireItemAvailable(std::string("UploadOnlySignificant"),&uploadOnlySignificant_)</i>: upload only the significant DCUs in file and in database
  * <li><i>fireItemAvailable(std::string("DirectoryDcuDataName"),&directoryDcuDataName_)</i>: directory where the file with raw should be put
 * <li><i>->fireItemAvailable(std::string("TKCCTest"),&tkccTest_);</i>: is it a tkcc test?
  * <lu>
@@ -233,6 +237,11 @@ DcuFilter::DcuFilter ( xdaq::ApplicationStub* stub ): TrackerCommandSender(stub)
   soapActionString_   = SOAPACTIONSTRING ; 
   pvssInstance_       = PVSS_APPLICATION_INSTANCE ; 
   pourcentDifferenceForPVSS_ = 10 ; 
+  dcuHistoryDirectory_ = "" ;
+  dcuDeadband_ = 0 ;
+  dcuCompressionDeviation_ = 0 ;
+  uploadOnlySignificant_ = false ;
+  dcuHistory_ = NULL ;
   pvssPoint_ = "SliceTestDCUS" ; 
   runNumberSent_ = 0 ; runNumber_ = 0 ; 
 #ifdef TKCC
@@ -447,6 +456,10 @@ DcuFilter::DcuFilter ( xdaq::ApplicationStub* stub ): TrackerCommandSender(stub)
   getApplicationInfoSpace()->fireItemAvailable(std::string("SOAPActionString"), &soapActionString_) ;
   getApplicationInfoSpace()->fireItemAvailable(std::string("PVSSInstance"), &pvssInstance_) ;
   getApplicationInfoSpace()->fireItemAvailable(std::string("PourcentDifferenceForPVSS"),&pourcentDifferenceForPVSS_);
+  getApplicationInfoSpace()->fireItemAvailable(std::string("DcuHistoryDirectory"),&dcuHistoryDirectory_);
+  getApplicationInfoSpace()->fireItemAvailable(std::string("DcuDeadband"),&dcuDeadband_);
+  getApplicationInfoSpace()->fireItemAvailable(std::string("DcuCompressionDeviation"),&dcuCompressionDeviation_);
+  getApplicationInfoSpace()->fireItemAvailable(std::string("UploadOnlySignificant"),&uploadOnlySignificant_);
   getApplicationInfoSpace()->fireItemAvailable(std::string("PVSSPoint"),&pvssPoint_) ;   // Where the DCS datapoints is set
   getApplicationInfoSpace()->fireItemAvailable(std::string("RunNumber"),&runNumber_) ;
   getApplicationInfoSpace()->fireItemAvailable(std::string("TKCCTest"),&tkccTest_);
@@ -475,6 +488,10 @@ DcuFilter::DcuFilter ( xdaq::ApplicationStub* stub ): TrackerCommandSender(stub)
   getApplicationInfoSpace()->fireItemAvailable(std::string("SOAPActionString"), &soapActionString_) ;
   getApplicationInfoSpace()->fireItemAvailable(std::string("PVSSInstance"), &pvssInstance_) ;
   getApplicationInfoSpace()->fireItemAvailable(std::string("PourcentDifferenceForPVSS"),&pourcentDifferenceForPVSS_);
+  getApplicationInfoSpace()->fireItemAvailable(std::string("DcuHistoryDirectory"),&dcuHistoryDirectory_);
+  getApplicationInfoSpace()->fireItemAvailable(std::string("DcuDeadband"),&dcuDeadband_);
+  getApplicationInfoSpace()->fireItemAvailable(std::string("DcuCompressionDeviation"),&dcuCompressionDeviation_);
+  getApplicationInfoSpace()->fireItemAvailable(std::string("UploadOnlySignificant"),&uploadOnlySignificant_);
   getApplicationInfoSpace()->fireItemAvailable(std::string("PVSSPoint"),&pvssPoint_) ;   // Where the DCS datapoints is set
   getApplicationInfoSpace()->fireItemAvailable(std::string("RunNumber"),&runNumber_) ;
   getApplicationInfoSpace()->fireItemAvailable(std::string("TKCCTest"),&tkccTest_);
@@ -526,6 +543,9 @@ DcuFilter::~DcuFilter ( ) {
   // Delete the mutex
   delete mutexVectorQueue_ ;
 
+  // Close the history of the DCU values
+  delete dcuHistory_ ;
+
   // Delete the map of the conversion factors
   for (DcuConversionsHashMapType::iterator p = dcuConversionFactorsMap_.begin() ; p != dcuConversionFactorsMap_.end() ; p ++) {
     delete p->second ;
@@ -1291,12 +1311,30 @@ bool DcuFilter::uploadWorkLoop (toolbox::task::WorkLoop* wl) {
     // }
     // else 
     
+    // Local history of the DCU values, the DCUs which did not move more than the deadband are not significant
+    deviceVector significant ;
+    deviceVector *vUpload = vDevice ;
+    if (dcuHistoryDirectory_.toString() != "") {
+      try {
+	if (dcuHistory_ == NULL) {
+	  dcuHistory_ = new DcuHistoryStore (dcuHistoryDirectory_.toString()) ;
+	  dcuHistory_->setDeadband ((tscType16)dcuDeadband_) ;
+	  dcuHistory_->setCompressionDeviation ((tscType16)dcuCompressionDeviation_) ;
+	}
+	dcuHistory_->add (*vDevice, significant) ;
+	if (uploadOnlySignificant_) vUpload = &significant ;
+      }
+      catch (FecExceptionHandler &e) {
+	errorReportLogger_->errorReport ("Cannot store the DCU values in the history " + dcuHistoryDirectory_.toString(), e, LOGERROR) ;
+      }
+    }
+
     // Upload in file (only if no conversion has been applied)
-    if (doUploadInFile_) {
+    if (doUploadInFile_ && (vUpload->size() > 0)) {
       mutexAppStatus_->take();
       xdaqApplicationStatus_ = errorReportLogger_->getStrProcess ( ) + ": Upload work loop: store a file with the DCU raw data"  ;
       mutexAppStatus_->give();
-      uploadDcuToFile ( *vDevice ) ;
+      uploadDcuToFile ( *vUpload ) ;
     }
 
     // Upload to PVSS (only if no conversion has been applied)
@@ -1317,12 +1355,12 @@ bool DcuFilter::uploadWorkLoop (toolbox::task::WorkLoop* wl) {
     }
     
     // Upload in database
-    if (doUploadInDatabase_ && databaseAccess_) {
+    if (doUploadInDatabase_ && databaseAccess_ && (vUpload->size() > 0)) {
       mutexAppStatus_->take();
       xdaqApplicationStatus_ = errorReportLogger_->getStrProcess ( ) + ": Upload work loop: upload the DCU raw data to the configuration database"  ;
       mutexAppStatus_->give();
       errorReportLogger_->errorReport ("Before uploadDcuToDatabase()", LOGDEBUG) ;
-      uploadDcuToDatabase ( *vDevice ) ;
+      uploadDcuToDatabase ( *vUpload ) ;
       errorReportLogger_->errorReport ("After uploadDcuToDatabase()", LOGDEBUG) ;
     }
 
@@ -283,6 +283,24 @@ typedef DD_TYPE_PCI_BASE_ADDRESS dd_device_base_addresses_array[DD_NBR_OF_PCI_BA
 
 
 
+/*!
+Geometry of the FEC registers (PLX BAR2) mapped in user space with mmap(),
+returned by the ioctl DD_IOC_GET_FEC_MAP_INFO.
+- map_size : bytes to map from offset 0, multiple of the page size
+- page_offset : offset of the FEC registers in the first page mapped
+- fifoxxx_offset : offsets of the fifos from the FEC registers
+- fifo_item_size : 16 or 32 bits
+*/
+typedef struct dd_fec_map_info {
+	unsigned long map_size;
+	unsigned long page_offset;
+	unsigned long fifotra_offset;
+	unsigned long fiforec_offset;
+	unsigned long fiforet_offset;
+	int fifo_item_size;
+} DD_FEC_MAP_INFO;
+
+
 /*!
 Structure used as container for ioctl() calls.
 */
@@ -609,6 +609,22 @@ END_TAG
 #define DD_FIFOTRA_RUNNING_FLAG_IS_ALWAYS_ON					72
 
 
+/*!
+BEGIN_TAG
+The PLX interrupts cannot be enabled while the FEC registers are mapped in user space. Unmap the registers first.
+END_TAG
+*/
+#define DD_FEC_REGISTERS_ARE_MAPPED					73
+
+
+/*!
+BEGIN_TAG
+The FEC registers cannot be mapped in user space. Either the PLX interrupts are enabled, or the driver loaded does not support mmap().
+END_TAG
+*/
+#define DD_CANNOT_MAP_FEC_REGISTERS					74
+
+
 
 
 /*!
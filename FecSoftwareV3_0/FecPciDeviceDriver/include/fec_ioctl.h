@@ -463,6 +463,9 @@ choice of a magic number used for PLX IOCTL's commands
 
 #define DD_IOC_GET_DEVICE_ID _IOR(DD_IOC_MAGIC_FEC,29, unsigned short)
 
+// geometry of the FEC registers for mmap()
+#define DD_IOC_GET_FEC_MAP_INFO _IOR(DD_IOC_MAGIC_FEC,30, DD_FEC_MAP_INFO)
+
 
 #ifdef __cplusplus
 }
@@ -780,6 +780,46 @@ DD_TYPE_ERROR glue_fec_get_vendor_id(int param_fd, unsigned short *param_vendor_
 DD_TYPE_ERROR glue_fec_get_device_id(int param_fd, unsigned short *param_device_id);
 
 
+
+/*!
+<b>FUNCTION : glue_fec_map_registers</b>
+- Job
+	- Maps the FEC registers and fifos in the address space of the process.
+	The registers are then read and written without any ioctl() call.
+- I/O
+	- Inputs
+		- int fd : file descriptor of the device driver
+	- Outputs
+		- DD_FEC_MAP_INFO *param_info : geometry of the mapping, see datatypes.h
+		- volatile void **param_registers : address of the FEC register at offset 0,
+		the register at offset X is at (char *)*param_registers + X
+		- Error Code returned by the function
+- Notes
+	- The PLX interrupts must be disabled : the interrupt manager of the driver
+	reads the fifo receive, and cannot be enabled while the registers are mapped.
+	- Each access is a PCI access ; the pages are not cached.
+	- A process that maps the registers does not get the frames through the
+	driver : it has to use the fifos itself.
+- Error Management & Values returned
+	- Operation successful :
+		- DD_RETURN_OK
+	- Errors :
+		- DD_CANNOT_MAP_FEC_REGISTERS
+		- ioctl() errors
+- Sub-functions calls
+	- ioctl, mmap		(system)
+*/
+DD_TYPE_ERROR glue_fec_map_registers(int param_fd, DD_FEC_MAP_INFO *param_info, volatile void **param_registers);
+
+
+/*!
+<b>FUNCTION : glue_fec_unmap_registers</b>
+- Job
+	- Releases a mapping done by glue_fec_map_registers.
+*/
+DD_TYPE_ERROR glue_fec_unmap_registers(DD_FEC_MAP_INFO *param_info, volatile void *param_registers);
+
+
 #ifdef __cplusplus
 }
 #endif
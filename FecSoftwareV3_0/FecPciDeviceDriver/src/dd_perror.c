@@ -292,6 +292,12 @@ DD_TYPE_ERROR dd_decode_error ( DD_TYPE_ERROR param_code, char *param_errormessa
 		case DD_FIFOTRA_RUNNING_FLAG_IS_ALWAYS_ON:
 			snprintf (param_errormessage, (DD_MAX_DECODED_ERROR_MSG_LENGTH-1),"The FIFO TRANSMIT RUNNING bit of FEC register STATUS0 is always on. You will certainly have to reset your FEC.");
 		break;
+		case DD_FEC_REGISTERS_ARE_MAPPED:
+			snprintf (param_errormessage, (DD_MAX_DECODED_ERROR_MSG_LENGTH-1),"The PLX interrupts cannot be enabled while the FEC registers are mapped in user space. Unmap the registers first.");
+		break;
+		case DD_CANNOT_MAP_FEC_REGISTERS:
+			snprintf (param_errormessage, (DD_MAX_DECODED_ERROR_MSG_LENGTH-1),"The FEC registers cannot be mapped in user space. Either the PLX interrupts are enabled, or the driver loaded does not support mmap().");
+		break;
 		case DD_CANNOT_OPEN_FEC_DRIVER:
 			snprintf (param_errormessage, (DD_MAX_DECODED_ERROR_MSG_LENGTH-1),"The FEC driver cannot be opened. Either the driver is not loaded, or your /dev/fecpmcxx file is has improper permissions.");
 		break;
@@ -248,6 +248,13 @@ Flag ON/OFF used to store the current interrupt status of the driver
 static int glb_irq_status;
 
 
+/*!
+Number of mappings of the FEC registers in user space (see dd_fecpmc_mmap).
+The PLX interrupts cannot be enabled while the registers are mapped.
+*/
+static atomic_t glb_fec_mappings = ATOMIC_INIT(0);
+
+
 static WAIT_QUEUE(glb_wq_devices_warning);
 
 static DD_FEC_STD_WORD glb_warning_buf[DD_USER_MAX_MSG_LENGTH];
@@ -1967,15 +1974,19 @@ static void dd_internal_write_to_plx(DD_PLX_ADDRESS param_offset, DD_PLX_DATA pa
 	- Void
 - Error Management & Values returned
 	- Operation successful :
-		- void
+		- DD_RETURN_OK
 	- Errors :
-		- void
+		- DD_FEC_REGISTERS_ARE_MAPPED
 - Sub-functions calls
 	- dd_internal_write_to_plx
 */
-static void dd_ioc_enable_plx_interrupts(void)
+static DD_TYPE_ERROR dd_ioc_enable_plx_interrupts(void)
 {
 #ifdef DD_ENABLE_IRQMANAGER
+	/* The interrupt manager reads the fifo receive : it cannot share the
+	FEC with a process accessing the registers through a mapping */
+	if (atomic_read(&glb_fec_mappings) > 0) return DD_FEC_REGISTERS_ARE_MAPPED;
+
 	/* Invalidation des interruptions PLX */
 	dd_internal_write_to_plx(DD_PLX9080_IRQREG_OFFSET, DD_PLX_IRQ_ENABLED_VALUE);
 
@@ -1983,6 +1994,8 @@ static void dd_ioc_enable_plx_interrupts(void)
 	ioctl() function is locked when called. */
 	glb_irq_status = DD_FLAG_IS_ENABLED;
 #endif
+
+return DD_RETURN_OK;
 }
 
 
@@ -2073,7 +2086,7 @@ static DD_TYPE_ERROR dd_give_handle_to_plx_ioctl(struct dd_ioctl_data * param_io
 		break;
 
 		case DD_IOC_ENABLE_PLX_INTERRUPTS:
-			dd_ioc_enable_plx_interrupts();
+			return dd_ioc_enable_plx_interrupts();
 		break;
 
 		case DD_IOC_PLX_HARD_RESET_MODULE:
@@ -3372,10 +3385,13 @@ printk("DEBUG:fecpmc00 : STATUS0 is : 0x%x\n",lcl_fec_value);
 	#endif
 
 
-	/*! Re-Validation des interruptions PLX */
+	/*! Re-Validation des interruptions PLX, except if the registers are mapped in user space */
 	#ifdef DD_ENABLE_IRQMANAGER
-		dd_internal_write_to_plx(DD_PLX9080_IRQREG_OFFSET, DD_PLX_IRQ_ENABLED_VALUE);
-		glb_irq_status = DD_FLAG_IS_ENABLED;
+		if (atomic_read(&glb_fec_mappings) == 0)
+		{
+			dd_internal_write_to_plx(DD_PLX9080_IRQREG_OFFSET, DD_PLX_IRQ_ENABLED_VALUE);
+			glb_irq_status = DD_FLAG_IS_ENABLED;
+		}
 	#endif
 
 	/*! release flag */
@@ -4056,10 +4072,9 @@ return DD_RETURN_OK;
 
 
 
-static DD_TYPE_ERROR dd_get_fifo_item_size(struct dd_ioctl_data * param_ioctl_data)
+static int dd_fifo_item_size(void)
 {
 int lcl_size;
-DD_TYPE_ERROR lcl_err;
 
 	//lcl_size = sizeof(DD_FEC_FIFO_DATA);
 	//if (sizeof(DD_FEC_FIFO_DATA) == 2)
@@ -4077,6 +4092,18 @@ DD_TYPE_ERROR lcl_err;
 		}
 		else lcl_size = 0;
 	}
+
+return lcl_size;
+}
+
+
+
+static DD_TYPE_ERROR dd_get_fifo_item_size(struct dd_ioctl_data * param_ioctl_data)
+{
+int lcl_size;
+DD_TYPE_ERROR lcl_err;
+
+	lcl_size = dd_fifo_item_size();
 	lcl_err = __copy_to_user((int *)param_ioctl_data->ioctl_address, &(lcl_size), (sizeof(int)*1));
 	if (lcl_err != DD_RETURN_OK) return DD_KS_CANNOT_WRITE_FRAME_BACK_TO_US_POS1;
 
@@ -4120,6 +4147,36 @@ return DD_RETURN_OK;
 }
 
 
+
+/*!
+Size to mmap for the FEC registers : the pages covering the FEC base address
+*/
+static unsigned long dd_get_fec_map_size(void)
+{
+	return PAGE_ALIGN((glb_plx_ba_array[DD_PLX_FEC_INDEX] & ~PAGE_MASK) + glb_plx_rmapsize_ba_array[DD_PLX_FEC_INDEX]);
+}
+
+
+
+static DD_TYPE_ERROR dd_get_fec_map_info(struct dd_ioctl_data * param_ioctl_data)
+{
+DD_FEC_MAP_INFO lcl_info;
+DD_TYPE_ERROR lcl_err;
+
+	lcl_info.map_size = dd_get_fec_map_size();
+	lcl_info.page_offset = (glb_plx_ba_array[DD_PLX_FEC_INDEX] & ~PAGE_MASK);
+	lcl_info.fifotra_offset = dd_fec_fifotra_offset;
+	lcl_info.fiforec_offset = dd_fec_fiforec_offset;
+	lcl_info.fiforet_offset = dd_fec_fiforet_offset;
+	lcl_info.fifo_item_size = dd_fifo_item_size();
+
+	lcl_err = __copy_to_user((DD_FEC_MAP_INFO *)param_ioctl_data->ioctl_address, &(lcl_info), sizeof(DD_FEC_MAP_INFO));
+	if (lcl_err != DD_RETURN_OK) return DD_KS_CANNOT_WRITE_FRAME_BACK_TO_US_POS1;
+
+return DD_RETURN_OK;
+}
+
+
 /*!
 <b>FUNCTION 0200	: dd_0200_give_handle_to_fec_ioctl</b>
 - Job
@@ -4311,6 +4368,11 @@ static DD_TYPE_ERROR dd_0200_give_handle_to_fec_ioctl(struct dd_ioctl_data * par
 		break;
 
 
+		case DD_IOC_GET_FEC_MAP_INFO:
+			return dd_get_fec_map_info(param_ioctl_data);
+		break;
+
+
 		default:
 			return DD_FEC_COMMAND_NOT_ASSOCIATED;
 
@@ -5351,10 +5413,107 @@ return (DD_TYPE_RELEASE_RETURN)DD_RETURN_OK;
 
 
 
-/*! Declare system functions OPEN, IOCTL and RELEASE redefined for this driver */
+/*!
+Count the mappings of the FEC registers, a mapping is inherited on fork()
+*/
+static void dd_fecpmc_vma_open(struct vm_area_struct *vma)
+{
+	atomic_inc(&glb_fec_mappings);
+}
+
+static void dd_fecpmc_vma_close(struct vm_area_struct *vma)
+{
+	atomic_dec(&glb_fec_mappings);
+}
+
+static struct vm_operations_struct dd_fecpmc_vm_ops={
+	open:dd_fecpmc_vma_open,
+	close:dd_fecpmc_vma_close,
+};
+
+
+
+/*!
+<b>FUNCTION	: dd_fecpmc_mmap</b>
+- Job
+	- Map the FEC registers (PLX BAR2) in the address space of the process,
+	so that the control/status registers and the fifos are accessed without
+	any ioctl() call.
+- Inputs
+	- file_pointer and the virtual memory area to fill
+- Outputs
+	- 0 or a negative system error code
+- Notes
+	- The area must start at offset 0 and must not be larger than the size
+	given by DD_IOC_GET_FEC_MAP_INFO ; the FEC registers begin at the
+	page_offset given by this ioctl.
+	- The pages are not cached : each load/store of the process is a
+	PCI access.
+	- The interrupt manager reads the fifo receive when a frame is received :
+	the mapping is refused while the PLX interrupts are enabled, and the PLX
+	interrupts cannot be enabled while a mapping exists. The process has to
+	disable the interrupts, then map the registers.
+- Error Management & Values returned
+	- Errors
+		- -ENODEV : no FEC detected
+		- -EINVAL : area out of the FEC registers
+		- -EBUSY : the PLX interrupts are enabled
+		- -EAGAIN : the pages cannot be mapped
+*/
+int dd_fecpmc_mmap(struct file *filep, struct vm_area_struct *vma)
+{
+unsigned long lcl_physical;
+unsigned long lcl_size;
+int lcl_err;
+
+	if (fec_detected == 0) return -ENODEV;
+
+	lcl_size = vma->vm_end - vma->vm_start;
+	if ( (vma->vm_pgoff != 0) || (lcl_size > dd_get_fec_map_size()) ) return -EINVAL;
+	lcl_physical = glb_plx_ba_array[DD_PLX_FEC_INDEX] & PAGE_MASK;
+
+	/* Same lock as the ioctl() entrypoint, where the interrupts are enabled */
+	if (down_interruptible(&(glb_ioctl_lock)) ) return -ERESTARTSYS;
+
+	if (glb_irq_status == DD_FLAG_IS_ENABLED)
+	{
+		up(&(glb_ioctl_lock));
+		return -EBUSY;
+	}
+
+	vma->vm_flags |= (VM_IO | VM_RESERVED);
+	vma->vm_page_prot = pgprot_noncached(vma->vm_page_prot);
+
+	#if LINUX_VERSION_CODE >= KERNEL_VERSION(2,6,10)
+		lcl_err = io_remap_pfn_range(vma, vma->vm_start, lcl_physical >> PAGE_SHIFT, lcl_size, vma->vm_page_prot);
+	#elif LINUX_VERSION_CODE >= KERNEL_VERSION(2,6,0)
+		lcl_err = io_remap_page_range(vma, vma->vm_start, lcl_physical, lcl_size, vma->vm_page_prot);
+	#else
+		lcl_err = io_remap_page_range(vma->vm_start, lcl_physical, lcl_size, vma->vm_page_prot);
+	#endif
+	if (lcl_err)
+	{
+		up(&(glb_ioctl_lock));
+		return -EAGAIN;
+	}
+
+	vma->vm_ops = &dd_fecpmc_vm_ops;
+	dd_fecpmc_vma_open(vma);
+
+	up(&(glb_ioctl_lock));
+
+return 0;
+}
+
+
+
+
+
+/*! Declare system functions OPEN, IOCTL, MMAP and RELEASE redefined for this driver */
 struct file_operations fecpmc_fops={
 	open:dd_open_fecdriver,
 	ioctl:dd_ioctl_entrypoint,
+	mmap:dd_fecpmc_mmap,
 	release:dd_release_fecdriver,
 };
 
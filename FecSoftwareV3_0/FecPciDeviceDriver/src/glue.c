@@ -44,6 +44,7 @@
 #include <sys/ioctl.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <sys/mman.h>
 
 
 
@@ -3132,6 +3133,39 @@ DD_TYPE_ERROR glue_fec_get_device_id(int param_fd, unsigned short *param_device_
 }
 
 
+
+/*!
+See the public file glue.h for this API description.
+*/
+DD_TYPE_ERROR glue_fec_map_registers(int param_fd, DD_FEC_MAP_INFO *param_info, volatile void **param_registers)
+{
+DD_TYPE_ERROR lcl_err;
+void *lcl_base;
+
+	lcl_err = ioctl(param_fd, DD_IOC_GET_FEC_MAP_INFO, param_info);
+	if (lcl_err != DD_RETURN_OK) return lcl_err;
+
+	lcl_base = mmap(NULL, param_info->map_size, (PROT_READ | PROT_WRITE), MAP_SHARED, param_fd, 0);
+	if (lcl_base == MAP_FAILED) return DD_CANNOT_MAP_FEC_REGISTERS;
+
+	*param_registers = (volatile void *)((char *)lcl_base + param_info->page_offset);
+
+return DD_RETURN_OK;
+}
+
+
+
+/*!
+See the public file glue.h for this API description.
+*/
+DD_TYPE_ERROR glue_fec_unmap_registers(DD_FEC_MAP_INFO *param_info, volatile void *param_registers)
+{
+	munmap((char *)param_registers - param_info->page_offset, param_info->map_size);
+
+return DD_RETURN_OK;
+}
+
+
 /*!
 Glue functions ; names are explicit.
 */
@@ -0,0 +1,129 @@
+#ifndef _FECUSB_PIPE_H
+#define _FECUSB_PIPE_H
+
+#include "fec_usb.h"
+
+/*
+   Pipelined accesses to the USB FEC / CREPE.
+
+   fec_usb_rw_unified sends one command and waits for its reply: each
+   register access costs a full USB round trip. A pipe queues the commands,
+   packs them in bulk-out transfers of at most FECUSB_PIPE_TRANSFER_LENGTH
+   bytes and keeps at most max_in_flight transfers without reply before
+   reading the replies. The protocol has no tag: the board answers the
+   commands in order, so each read keeps its destination and the position
+   of its reply in the stream, and the replies are dispatched while they
+   are received.
+
+   The data of a read is available after fec_usb_pipe_flush. The words
+   written are copied when the command is queued.
+   A pipe is not thread safe and must not be used while fec_usb_rw_unified
+   accesses the same device.
+*/
+
+#define FECUSB_PIPE_TRANSFER_LENGTH 4096
+#define FECUSB_PIPE_MAX_IN_FLIGHT 8
+
+/* access mode of a device, see fec_usb_open */
+struct fec_usb_mode {
+  int crepe ;
+  int crepe_detection_done ;
+  int fec ;
+  int fec_detection_done ;
+  int access_version ;
+} ;
+
+/* byte transfer used by a pipe:
+   write returns the number of bytes sent or < 0 on error,
+   read returns the number of bytes available (0 if none yet) or < 0 on error */
+typedef int (*fec_usb_pipe_io)(void *context, fecusbType8 *buffer, int count) ;
+
+/* read queued in a pipe: destination and length of its reply */
+struct fec_usb_pipe_read {
+  fecusbType32 *data ;   /* NULL: reply of a write, dropped */
+  int words ;
+  int reply ;            /* bytes */
+} ;
+
+struct fec_usb_pipe {
+  fec_usb_pipe_io write ;
+  fec_usb_pipe_io read ;
+  void *context ;
+  struct fec_usb_mode mode ;
+  int max_in_flight ;
+  int timeout ;          /* in ms, without any byte received */
+
+  /* addresses of the fifos, set by fec_usb_pipe_open */
+  fecusbType16 fifo_transmit ;
+  fecusbType16 fifo_receive ;
+  fecusbType16 fifo_return ;
+
+  /* transfer being filled */
+  fecusbType8 *tx ;
+  int tx_length ;
+  int tx_size ;
+  int tx_reply ;         /* bytes of reply expected for the transfer */
+
+  /* replies expected: one entry per command queued since the last flush */
+  struct fec_usb_pipe_read *replies ;
+  int reply_count ;
+  int reply_size ;
+  int rx_reply ;         /* command receiving its reply */
+  int rx_byte ;          /* bytes already received for this command */
+
+  /* end of the reply of each transfer in flight, in bytes since the last flush */
+  long *in_flight ;
+  int in_flight_first ;
+  int in_flight_count ;
+  long rx_total ;
+  long rx_expected ;
+
+  FECUSB_TYPE_ERROR error ;
+
+  /* statistics since the creation */
+  unsigned long transfers ;
+  unsigned long commands ;
+  unsigned long bytes_out ;
+  unsigned long bytes_in ;
+  int max_in_flight_seen ;
+} ;
+
+#ifdef __cplusplus
+  extern "C" {
+#endif
+
+    /* command sent for the mode of the device: FECUSB_OPER_READ/WRITE become the
+       emulator accesses on a CREPE, the emulator accesses become the FEC accesses
+       on a FEC and the CREPE commands are refused on a FEC */
+    FECUSB_TYPE_ERROR fec_usb_map_cmd(const struct fec_usb_mode *mode, int cmd, int *cmd_local) ;
+
+    /* encode one frame of a command already mapped, return the number of bytes:
+       FECUSB_OPER_READ/WRITE encode one word, the emulator accesses encode the block */
+    int fec_usb_encode_frame(int cmd_local, fecusbType16 address, fecusbType32 *data, int words, fecusbType8 *buffer) ;
+
+    /* length in bytes of the reply to a command already mapped */
+    int fec_usb_reply_length(int cmd_local, int words, int access_version) ;
+
+    struct fec_usb_pipe *fec_usb_pipe_create(fec_usb_pipe_io write, fec_usb_pipe_io read, void *context,
+					     const struct fec_usb_mode *mode,
+					     int max_in_flight, int timeout) ;
+    void fec_usb_pipe_destroy(struct fec_usb_pipe *pipe) ;
+
+    /* pipe on a device opened by fec_usb_open */
+    FECUSB_TYPE_ERROR fec_usb_pipe_open(int dev, int max_in_flight, struct fec_usb_pipe **pipe) ;
+    void fec_usb_pipe_close(struct fec_usb_pipe *pipe) ;
+
+    FECUSB_TYPE_ERROR fec_usb_pipe_write(struct fec_usb_pipe *pipe, int cmd, fecusbType16 address,
+					 fecusbType32 *data, int words) ;
+    FECUSB_TYPE_ERROR fec_usb_pipe_read(struct fec_usb_pipe *pipe, int cmd, fecusbType16 address,
+					fecusbType32 *data, int words) ;
+
+    /* send the commands queued and wait for all the replies. After an error the
+       queue is emptied, the reads queued are not valid */
+    FECUSB_TYPE_ERROR fec_usb_pipe_flush(struct fec_usb_pipe *pipe) ;
+
+#ifdef __cplusplus
+  }
+#endif
+
+#endif
@@ -17,6 +17,7 @@
 
 #include "fec_usb.h"
 #include "fec_usb_defines.h"
+#include "fec_usb_pipe.h"
 
 
 #define FECUSB_READ_MAX_RETRY 10
@@ -553,6 +554,15 @@ FECUSB_TYPE_ERROR fec_usb_set_read_chunk_size(int dev, int val) {
 
 
 
+/* access mode found by fec_usb_open */
+static void fec_usb_get_mode(struct devInfo *ptr, struct fec_usb_mode *mode) { 
+  mode->crepe = ptr->crepe ; 
+  mode->crepe_detection_done = ptr->crepe_detection_done ; 
+  mode->fec = ptr->fec ; 
+  mode->fec_detection_done = ptr->fec_detection_done ; 
+  mode->access_version = ptr->access_version ; 
+} 
+
 //new unique transfer function
 
 
@@ -577,6 +587,7 @@ FECUSB_TYPE_ERROR fec_usb_rw_unified(struct devInfo *ptr, int cmd,
 	int paddle_with_ff = 0 ; 
 	struct timeval start_time, stop_time, diff_time ;
 	int cmd_local ; 
+	struct fec_usb_mode mode ;
  
   assert(ptr!=NULL);
 
@@ -586,133 +597,22 @@ FECUSB_TYPE_ERROR fec_usb_rw_unified(struct devInfo *ptr, int cmd,
 
 
 
-  /* if it is a crepe*/
-      if (ptr->crepe || !ptr->crepe_detection_done) { 
-	 cmd_local =  cmd ; /* by default is the same*/
-	 if (cmd==FECUSB_OPER_WRITE) { 
-	   cmd_local = FECUSB_OPER_WRITE_EMU ; /* for crepe: we profit for new access type*/
-	 } 
-	 
-	 if (cmd==FECUSB_OPER_READ) { 
-	    cmd_local = FECUSB_OPER_READ_EMU ; /* for crepe: we profit for new access type*/
-	 } 	 
-      
-      }
-     else { 
-
-       if (ptr->fec || !ptr->fec_detection_done) { 
-
-       cmd_local = cmd ; /* by default is the same*/
-         if (cmd==FECUSB_OPER_WRITE_EMU) { 
-	   cmd_local = FECUSB_OPER_WRITE ; /* no crepe:  old access type*/
-	 } 
-	 
-	 if (cmd==FECUSB_OPER_READ_EMU) { 
-	    cmd_local = FECUSB_OPER_READ ; /* no crepe: old access type*/
-	 } 
-
-	 if (cmd_local==FECUSB_OPER_WRITE || cmd_local==FECUSB_OPER_READ) {
-	   /* ok, do nothing*/
-	 } else  { /* we are not crepe but request was for crepe cmd.. and not fec access*/
-		return  FECUSB_ERROR_OPER_NOT_PERMITTED ;
-	}
-
-       } else { 
-	 return  FECUSB_ERROR_OPER_NOT_PERMITTED ;
-       } 
-     }
-  
-  
+  /* the command depends on the board: crepe or fec */
+  fec_usb_get_mode(ptr,&mode) ;
+  if (fec_usb_map_cmd(&mode,cmd,&cmd_local)!=FECUSB_RETURN_OK) return  FECUSB_ERROR_OPER_NOT_PERMITTED ;
 
   /* assembling the packet frame */ 
   if (cmd_local==FECUSB_OPER_WRITE || cmd_local==FECUSB_OPER_READ) { 
     /* treat like collated old block transfer.. */
-    for(j=0;j<(words);j++) { 
-
-        buffer[index+0] = 0;  // sync byte
-        buffer[index+2] = cmd_local;  //cmd  == 1  -> write , == 2 => read
-        buffer[index+3] = address & 0xff;
-        buffer[index+4] = (address & 0xff00) >> 8;
- 
-        switch (cmd_local) {
-        case FECUSB_OPER_WRITE :
-          buffer[index+1] = 9 ; // writing
-          buffer[index+5] = 0;  //address
-          buffer[index+6] = 0;  //address
-          buffer[index+7] = (*(data+j)) & 0xff ;
-          buffer[index+8] = ((*(data+j)) & 0xff00) >> 8;
-          buffer[index+9] = ((*(data+j)) & 0xff0000) >> 16 ;
-          buffer[index+10] = ((*(data+j)) & 0xff000000) >> 24 ; // data
-          dwBytesToWrite += 11 ;
-	  index += 11 ; 
-          break ;
-        case FECUSB_OPER_READ :
-          dwBytesToWrite += 7;    // reading
-          buffer[index+1] = 5;
-	  buffer[index+5] = 0;  //address
-          buffer[index+6] = 0;  //address
-	  index += 7 ; 
-          break ;
-        default : return FECUSB_ERROR_OPER_NOT_PERMITTED ;
- 
-        }
-
-    }
-    a_lire = (4*words); /* old methode: reply is always words*4 bytes */
+    for(j=0;j<(words);j++) 
+      index += fec_usb_encode_frame(cmd_local,address,data+j,1,buffer+index) ;
   } else { 
     /* use new emualtor/crepe access */
-        buffer[index+0] = 0;  // sync byte
-        buffer[index+2] = cmd_local;  //cmd  == 1  -> write , == 2 => read
-        buffer[index+3] = address & 0xff;
-        buffer[index+4] = (address & 0xff00) >> 8;
-
- 
-        switch (cmd_local) {
-	case FECUSB_OPER_HEARTBEAT:
-        case FECUSB_OPER_WRITE_EMU :
-	case FECUSB_OPER_WRITE_EMU_LOCAL:
-	case FECUSB_OPER_WRITE_EMU_LOCAL_INC:
-
-	   a_lire = (ptr->access_version>0) ? 4 : (4*words) ; 
-	   /* answer for write is 1 word only for crepe > 0x2008*/
-	 
-          buffer[index+1] = 9; // writing
-          buffer[index+5] = 0;  //address
-          buffer[index+6] = 0;  //address
-	  index += 7 ; 
-	  dwBytesToWrite += 7 ;
-	  buffer[index++] = ( words & 0x00ff) ; 
-	  buffer[index++] = (words & 0xff00) >> 8 ; 
-	  dwBytesToWrite += 2 ;
-
-	  for(j=0;j<words;j++) { 
-          buffer[index++] = (*(data+j)) & 0xff ;
-          buffer[index++] = ((*(data+j)) & 0xff00) >> 8;
-          buffer[index++] = ((*(data+j)) & 0xff0000) >> 16 ;
-          buffer[index++] = ((*(data+j)) & 0xff000000) >> 24 ; // data
-	  dwBytesToWrite += 4 ;
-	  }
-
- 
-          break ;
-        case FECUSB_OPER_READ_EMU :
-        case FECUSB_OPER_READ_EMU_LOCAL:
-        case FECUSB_OPER_READ_EMU_LOCAL_INC:
-	   a_lire = (words*4); /* answer is words*4 bytes long*/
-          dwBytesToWrite += 7;    // reading
-          buffer[index+1] = 5;
-	  buffer[index+5] = 0;  //address
-          buffer[index+6] = 0;  //address
-	  index += 7 ;
-	  buffer[index++] = ( words & 0x00ff) ; 
-	  buffer[index++] = (words & 0xff00) >> 8 ; 
-	  dwBytesToWrite += 2 ;	  
-          break ;
-        default : return FECUSB_ERROR_OPER_NOT_PERMITTED ;
- 
-        }
-
+    index = fec_usb_encode_frame(cmd_local,address,data,words,buffer) ;
+    if (index<0) return FECUSB_ERROR_OPER_NOT_PERMITTED ;
   }
+  dwBytesToWrite = index ;
+  a_lire = fec_usb_reply_length(cmd_local,words,ptr->access_version) ;
 
 	if (paddle_with_ff) { 
 
@@ -788,8 +688,6 @@ FECUSB_TYPE_ERROR fec_usb_rw_unified(struct devInfo *ptr, int cmd,
  
 	// testing performance with padding 0xff
 
-	if (cmd==FECUSB_OPER_HEARTBEAT) a_lire = 62 ; 
-
         tmp = rxbuffer  ;
 	rx_count = 0 ; 
 	gettimeofday(&start_time,NULL);
@@ -1077,6 +975,52 @@ FECUSB_TYPE_ERROR  fec_usb_read_raw(int dev, fecusbType8 *val,
 
 
 
+/* pipelined accesses, see fec_usb_pipe.h */
+
+static int fec_usb_pipe_write_dev(void *context, fecusbType8 *buffer, int count) { 
+  struct devInfo *ptr = (struct devInfo*) context ; 
+#ifdef FECUSELIBUSB
+  return ftdi_write_data(ptr->ftdi,buffer,count);
+#else
+  return ftdipio_write(ptr->desc,buffer,count); 
+#endif 
+} 
+
+static int fec_usb_pipe_read_dev(void *context, fecusbType8 *buffer, int count) { 
+  struct devInfo *ptr = (struct devInfo*) context ; 
+#ifdef FECUSELIBUSB
+  return ftdi_read_data(ptr->ftdi,buffer,count);
+#else
+  return ftdipio_read(ptr->desc,buffer,count);
+#endif 
+} 
+
+/* the mode of the device is taken at the opening of the pipe */
+FECUSB_TYPE_ERROR fec_usb_pipe_open(int dev, int max_in_flight, struct fec_usb_pipe **pipe) { 
+  struct fec_usb_mode mode ; 
+  struct devInfo *ptr = NULL ; 
+
+  assert(dev>=0 && dev<FECUSB_MAX_DEV);  
+  ptr = devtab[dev] ;
+  if (ptr==NULL) return FECUSB_ERROR_DEVICE_CONTEXT_NULL ; 
+
+  fec_usb_get_mode(ptr,&mode) ; 
+  (*pipe) = fec_usb_pipe_create(fec_usb_pipe_write_dev,fec_usb_pipe_read_dev,ptr,
+				&mode,max_in_flight,ptr->fpga_timeout) ; 
+  if ((*pipe)==NULL) return FECUSB_ERROR_DEVICE_CONTEXT_NO_MEMORY ; 
+
+  (*pipe)->fifo_transmit = ptr->fifoTransmitAddress ; 
+  (*pipe)->fifo_receive = ptr->fifoReceiveAddress ; 
+  (*pipe)->fifo_return = ptr->fifoReturnAddress ; 
+
+  return FECUSB_RETURN_OK ; 
+} 
+
+void fec_usb_pipe_close(struct fec_usb_pipe *pipe) { 
+  fec_usb_pipe_destroy(pipe) ; 
+} 
+
+
 //new cmd function:
 FECUSB_TYPE_ERROR fec_usb_rw(struct devInfo *ptr, int cmd, 
 				   fecusbType16 address, 
@@ -0,0 +1,360 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sched.h>
+#include <sys/time.h>
+
+#include "fec_usb.h"
+#include "fec_usb_defines.h"
+#include "fec_usb_pipe.h"
+
+
+FECUSB_TYPE_ERROR fec_usb_map_cmd(const struct fec_usb_mode *mode, int cmd, int *cmd_local) {
+
+  /* if it is a crepe*/
+  if (mode->crepe || !mode->crepe_detection_done) {
+    (*cmd_local) = cmd ; /* by default is the same*/
+    if (cmd==FECUSB_OPER_WRITE) (*cmd_local) = FECUSB_OPER_WRITE_EMU ; /* for crepe: we profit for new access type*/
+    if (cmd==FECUSB_OPER_READ) (*cmd_local) = FECUSB_OPER_READ_EMU ;
+    return FECUSB_RETURN_OK ;
+  }
+
+  if (mode->fec || !mode->fec_detection_done) {
+    (*cmd_local) = cmd ; /* by default is the same*/
+    if (cmd==FECUSB_OPER_WRITE_EMU) (*cmd_local) = FECUSB_OPER_WRITE ; /* no crepe:  old access type*/
+    if (cmd==FECUSB_OPER_READ_EMU) (*cmd_local) = FECUSB_OPER_READ ;
+
+    /* we are not crepe but request was for crepe cmd.. and not fec access*/
+    if ((*cmd_local)==FECUSB_OPER_WRITE || (*cmd_local)==FECUSB_OPER_READ) return FECUSB_RETURN_OK ;
+  }
+
+  return FECUSB_ERROR_OPER_NOT_PERMITTED ;
+}
+
+static void fec_usb_encode_word(fecusbType8 *buffer, fecusbType32 data) {
+  buffer[0] = data & 0xff ;
+  buffer[1] = (data & 0xff00) >> 8 ;
+  buffer[2] = (data & 0xff0000) >> 16 ;
+  buffer[3] = (data & 0xff000000) >> 24 ;
+}
+
+int fec_usb_encode_frame(int cmd_local, fecusbType16 address, fecusbType32 *data, int words, fecusbType8 *buffer) {
+
+  int j, index = 0 ;
+
+  buffer[0] = 0 ;  // sync byte
+  buffer[2] = cmd_local ;
+  buffer[3] = address & 0xff ;
+  buffer[4] = (address & 0xff00) >> 8 ;
+  buffer[5] = 0 ;
+  buffer[6] = 0 ;
+
+  switch (cmd_local) {
+  case FECUSB_OPER_WRITE :
+    buffer[1] = 9 ;
+    fec_usb_encode_word(buffer+7,*data) ;
+    return 11 ;
+  case FECUSB_OPER_READ :
+    buffer[1] = 5 ;
+    return 7 ;
+  case FECUSB_OPER_HEARTBEAT:
+  case FECUSB_OPER_WRITE_EMU :
+  case FECUSB_OPER_WRITE_EMU_LOCAL:
+  case FECUSB_OPER_WRITE_EMU_LOCAL_INC:
+    buffer[1] = 9 ;
+    buffer[7] = (words & 0x00ff) ;
+    buffer[8] = (words & 0xff00) >> 8 ;
+    index = 9 ;
+    for(j=0;j<words;j++) {
+      fec_usb_encode_word(buffer+index,data[j]) ;
+      index += 4 ;
+    }
+    return index ;
+  case FECUSB_OPER_READ_EMU :
+  case FECUSB_OPER_READ_EMU_LOCAL:
+  case FECUSB_OPER_READ_EMU_LOCAL_INC:
+    buffer[1] = 5 ;
+    buffer[7] = (words & 0x00ff) ;
+    buffer[8] = (words & 0xff00) >> 8 ;
+    return 9 ;
+  }
+
+  return FECUSB_ERROR_OPER_NOT_PERMITTED ;
+}
+
+int fec_usb_reply_length(int cmd_local, int words, int access_version) {
+
+  switch (cmd_local) {
+  case FECUSB_OPER_HEARTBEAT:
+    return 62 ;
+  case FECUSB_OPER_WRITE_EMU :
+  case FECUSB_OPER_WRITE_EMU_LOCAL:
+  case FECUSB_OPER_WRITE_EMU_LOCAL_INC:
+    /* answer for write is 1 word only for crepe > 0x2008*/
+    return (access_version>0) ? 4 : (4*words) ;
+  }
+
+  /* old methode: reply is always words*4 bytes */
+  return 4*words ;
+}
+
+
+struct fec_usb_pipe *fec_usb_pipe_create(fec_usb_pipe_io write, fec_usb_pipe_io read, void *context,
+					 const struct fec_usb_mode *mode,
+					 int max_in_flight, int timeout) {
+
+  struct fec_usb_pipe *pipe ;
+
+  if (max_in_flight<1) max_in_flight = 1 ;
+
+  pipe = (struct fec_usb_pipe*) malloc(sizeof(struct fec_usb_pipe)) ;
+  if (pipe==NULL) return NULL ;
+  memset(pipe,0x00,sizeof(struct fec_usb_pipe)) ;
+
+  pipe->write = write ;
+  pipe->read = read ;
+  pipe->context = context ;
+  pipe->mode = (*mode) ;
+  pipe->max_in_flight = max_in_flight ;
+  pipe->timeout = timeout ;
+  pipe->fifo_transmit = FECUSB_FIFOTRA_OFFSET_UNIQUE ;
+  pipe->fifo_receive = FECUSB_FIFOREC_OFFSET_UNIQUE ;
+  pipe->fifo_return = FECUSB_FIFORET_OFFSET_UNIQUE ;
+
+  pipe->tx_size = FECUSB_PIPE_TRANSFER_LENGTH ;
+  pipe->tx = (fecusbType8*) malloc(pipe->tx_size) ;
+  pipe->reply_size = 256 ;
+  pipe->replies = (struct fec_usb_pipe_read*) malloc(pipe->reply_size*sizeof(struct fec_usb_pipe_read)) ;
+  pipe->in_flight = (long*) malloc(max_in_flight*sizeof(long)) ;
+
+  if (pipe->tx==NULL || pipe->replies==NULL || pipe->in_flight==NULL) {
+    fec_usb_pipe_destroy(pipe) ;
+    return NULL ;
+  }
+
+  return pipe ;
+}
+
+void fec_usb_pipe_destroy(struct fec_usb_pipe *pipe) {
+
+  if (pipe==NULL) return ;
+  free(pipe->tx) ;
+  free(pipe->replies) ;
+  free(pipe->in_flight) ;
+  free(pipe) ;
+}
+
+/* empty the queue, after a flush or an error */
+static void fec_usb_pipe_reset(struct fec_usb_pipe *pipe) {
+
+  pipe->tx_length = 0 ;
+  pipe->tx_reply = 0 ;
+  pipe->reply_count = 0 ;
+  pipe->rx_reply = 0 ;
+  pipe->rx_byte = 0 ;
+  pipe->in_flight_first = 0 ;
+  pipe->in_flight_count = 0 ;
+  pipe->rx_total = 0 ;
+  pipe->rx_expected = 0 ;
+  pipe->error = FECUSB_RETURN_OK ;
+}
+
+/* give the bytes received to the reads, in the order of the commands */
+static void fec_usb_pipe_dispatch(struct fec_usb_pipe *pipe, fecusbType8 *buffer, int count) {
+
+  int i ;
+
+  for(i=0;i<count && pipe->rx_reply<pipe->reply_count;i++) {
+
+    struct fec_usb_pipe_read *reply = pipe->replies + pipe->rx_reply ;
+
+    /* the words are sent MSB first */
+    if (reply->data!=NULL && (pipe->rx_byte>>2)<reply->words) {
+      fecusbType32 *word = reply->data + (pipe->rx_byte>>2) ;
+      int shift = 24 - 8*(pipe->rx_byte&3) ;
+      if (shift==24) (*word) = 0 ;
+      (*word) |= ((fecusbType32) buffer[i]) << shift ;
+    }
+
+    if (++pipe->rx_byte==reply->reply) {
+      pipe->rx_reply++ ;
+      pipe->rx_byte = 0 ;
+    }
+  }
+}
+
+/* read the replies until at most keep transfers are in flight */
+static FECUSB_TYPE_ERROR fec_usb_pipe_wait(struct fec_usb_pipe *pipe, int keep) {
+
+  fecusbType8 rxbuffer[FECUSB_PIPE_TRANSFER_LENGTH] ;
+  struct timeval start_time, stop_time, diff_time ;
+  int ft_status, a_lire ;
+
+  gettimeofday(&start_time,NULL);
+  while (pipe->in_flight_count>keep) {
+
+    a_lire = pipe->rx_expected - pipe->rx_total ;
+    if (a_lire>FECUSB_PIPE_TRANSFER_LENGTH) a_lire = FECUSB_PIPE_TRANSFER_LENGTH ;
+
+    ft_status = pipe->read(pipe->context,rxbuffer,a_lire) ;
+    if (ft_status<0) {
+      printf("fec_usb_pipe: usb error in read: %d \n",ft_status);
+      return ft_status ;
+    }
+
+    if (ft_status==0) {
+      // give a breath to the cpu...
+      sched_yield();
+      gettimeofday(&stop_time,NULL);
+      timersub(&stop_time,&start_time,&diff_time);
+      if ((diff_time.tv_sec * 1000 + diff_time.tv_usec/1000) > pipe->timeout) {
+	printf("fec_usb_pipe: timeout occurred. (%d msec), %ld/%ld bytes received\n",
+	       pipe->timeout,pipe->rx_total,pipe->rx_expected);
+	return (-ETIME);
+      }
+      continue ;
+    }
+
+    fec_usb_pipe_dispatch(pipe,rxbuffer,ft_status) ;
+    pipe->rx_total += ft_status ;
+    pipe->bytes_in += ft_status ;
+
+    /* transfers fully answered */
+    while (pipe->in_flight_count>0 && pipe->in_flight[pipe->in_flight_first]<=pipe->rx_total) {
+      pipe->in_flight_first = (pipe->in_flight_first+1) % pipe->max_in_flight ;
+      pipe->in_flight_count-- ;
+    }
+
+    gettimeofday(&start_time,NULL);
+  }
+
+  return FECUSB_RETURN_OK ;
+}
+
+/* send the transfer being filled, when the window allows it */
+static FECUSB_TYPE_ERROR fec_usb_pipe_send(struct fec_usb_pipe *pipe) {
+
+  FECUSB_TYPE_ERROR status ;
+  int sent = 0 ;
+
+  if (pipe->tx_length==0) return FECUSB_RETURN_OK ;
+
+  status = fec_usb_pipe_wait(pipe,pipe->max_in_flight-1) ;
+  if (status!=FECUSB_RETURN_OK) return status ;
+
+  while (sent<pipe->tx_length) {
+    int ft_status = pipe->write(pipe->context,pipe->tx+sent,pipe->tx_length-sent) ;
+    if (ft_status<=0) {
+      printf("fec_usb_pipe: usb error in write: %d (%d/%d bytes sent)\n",ft_status,sent,pipe->tx_length);
+      return (ft_status<0) ? ft_status : FECUSB_ERROR_UNKNOWN ;
+    }
+    sent += ft_status ;
+  }
+
+  pipe->rx_expected += pipe->tx_reply ;
+  pipe->in_flight[(pipe->in_flight_first+pipe->in_flight_count) % pipe->max_in_flight] = pipe->rx_expected ;
+  pipe->in_flight_count++ ;
+  if (pipe->in_flight_count>pipe->max_in_flight_seen) pipe->max_in_flight_seen = pipe->in_flight_count ;
+
+  pipe->transfers++ ;
+  pipe->bytes_out += pipe->tx_length ;
+  pipe->tx_length = 0 ;
+  pipe->tx_reply = 0 ;
+
+  return FECUSB_RETURN_OK ;
+}
+
+/* add a frame to the transfer and its reply to the replies expected */
+static FECUSB_TYPE_ERROR fec_usb_pipe_queue(struct fec_usb_pipe *pipe, int cmd_local, fecusbType16 address,
+					    fecusbType32 *data, int words, fecusbType32 *destination) {
+
+  int length = ((cmd_local==FECUSB_OPER_WRITE || cmd_local==FECUSB_OPER_READ) ? 11 : 9 + 4*words) ;
+  struct fec_usb_pipe_read *reply ;
+
+  if (pipe->tx_length+length>FECUSB_PIPE_TRANSFER_LENGTH) {
+    FECUSB_TYPE_ERROR status = fec_usb_pipe_send(pipe) ;
+    if (status!=FECUSB_RETURN_OK) return status ;
+  }
+
+  /* a block larger than a transfer is sent alone */
+  if (length>pipe->tx_size) {
+    fecusbType8 *tx = (fecusbType8*) realloc(pipe->tx,length) ;
+    if (tx==NULL) return FECUSB_ERROR_DEVICE_CONTEXT_NO_MEMORY ;
+    pipe->tx = tx ;
+    pipe->tx_size = length ;
+  }
+
+  if (pipe->reply_count==pipe->reply_size) {
+    reply = (struct fec_usb_pipe_read*) realloc(pipe->replies,2*pipe->reply_size*sizeof(struct fec_usb_pipe_read)) ;
+    if (reply==NULL) return FECUSB_ERROR_DEVICE_CONTEXT_NO_MEMORY ;
+    pipe->replies = reply ;
+    pipe->reply_size *= 2 ;
+  }
+
+  length = fec_usb_encode_frame(cmd_local,address,data,words,pipe->tx+pipe->tx_length) ;
+  if (length<0) return length ;
+
+  reply = pipe->replies + pipe->reply_count++ ;
+  reply->data = destination ;
+  reply->words = words ;
+  reply->reply = fec_usb_reply_length(cmd_local,words,pipe->mode.access_version) ;
+
+  pipe->tx_length += length ;
+  pipe->tx_reply += reply->reply ;
+  pipe->commands++ ;
+
+  return FECUSB_RETURN_OK ;
+}
+
+/* map the command and queue it, word by word for the FEC accesses */
+static FECUSB_TYPE_ERROR fec_usb_pipe_command(struct fec_usb_pipe *pipe, int cmd, fecusbType16 address,
+					      fecusbType32 *data, int words, int read) {
+
+  FECUSB_TYPE_ERROR status ;
+  int cmd_local, j ;
+
+  if (pipe==NULL) return FECUSB_ERROR_DEVICE_CONTEXT_NULL ;
+  if (pipe->error!=FECUSB_RETURN_OK) return pipe->error ;
+  if (!(words>0) || data==NULL) return FECUSB_ERROR_OPER_NOT_PERMITTED ;
+
+  status = fec_usb_map_cmd(&pipe->mode,cmd,&cmd_local) ;
+  if (status!=FECUSB_RETURN_OK) return status ;
+
+  if (cmd_local==FECUSB_OPER_WRITE || cmd_local==FECUSB_OPER_READ) {
+    for(j=0;j<words && status==FECUSB_RETURN_OK;j++)
+      status = fec_usb_pipe_queue(pipe,cmd_local,address,data+j,1,read ? data+j : NULL) ;
+  } else {
+    status = fec_usb_pipe_queue(pipe,cmd_local,address,data,words,read ? data : NULL) ;
+  }
+
+  /* the commands already sent wait for their replies, the flush reports the error */
+  if (status!=FECUSB_RETURN_OK && status!=FECUSB_ERROR_OPER_NOT_PERMITTED) pipe->error = status ;
+
+  return status ;
+}
+
+FECUSB_TYPE_ERROR fec_usb_pipe_write(struct fec_usb_pipe *pipe, int cmd, fecusbType16 address,
+				     fecusbType32 *data, int words) {
+  return fec_usb_pipe_command(pipe,cmd,address,data,words,0) ;
+}
+
+FECUSB_TYPE_ERROR fec_usb_pipe_read(struct fec_usb_pipe *pipe, int cmd, fecusbType16 address,
+				    fecusbType32 *data, int words) {
+  return fec_usb_pipe_command(pipe,cmd,address,data,words,1) ;
+}
+
+FECUSB_TYPE_ERROR fec_usb_pipe_flush(struct fec_usb_pipe *pipe) {
+
+  FECUSB_TYPE_ERROR status ;
+
+  if (pipe==NULL) return FECUSB_ERROR_DEVICE_CONTEXT_NULL ;
+
+  status = pipe->error ;
+  if (status==FECUSB_RETURN_OK) status = fec_usb_pipe_send(pipe) ;
+  if (status==FECUSB_RETURN_OK) status = fec_usb_pipe_wait(pipe,0) ;
+
+  fec_usb_pipe_reset(pipe) ;
+  return status ;
+}
@@ -0,0 +1,390 @@
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "fec_usb.h"
+#include "fec_usb_defines.h"
+#include "fec_usb_pipe.h"
+
+/*
+   Test of the pipelined accesses without board: the USB link is a
+   socketpair and a loopback thread decodes the frames of the FTDI byte
+   protocol and answers them like the FEC / CREPE firmware, with a
+   register map and the FIFO transmit / receive.
+*/
+
+#define LOOPBACK_FIFO 100000
+
+struct loopback {
+  int fd ;
+  int access_version ;
+  int mute ;                      /* drop the replies */
+  fecusbType32 reg[0x10000] ;
+  fecusbType32 transmit[LOOPBACK_FIFO] ;
+  int transmit_count ;
+  fecusbType32 receive[LOOPBACK_FIFO] ;
+  int receive_first, receive_count ;
+  unsigned long frames ;
+} ;
+
+/* byte transfer of the test: one write is one bulk-out transfer */
+struct usb_link {
+  int fd ;
+  struct fec_usb_pipe *pipe ;
+  unsigned long transfers ;
+  int latency ;                   /* us per transfer */
+  int window_error ;
+} ;
+
+static int errors = 0 ;
+
+static void check(int condition, const char *message) {
+  if (!condition) {
+    printf("ERROR: %s\n",message) ;
+    errors++ ;
+  }
+}
+
+static fecusbType32 loopback_word(fecusbType8 *buffer) {
+  return buffer[0] + (buffer[1]<<8) + (buffer[2]<<16) + ((fecusbType32) buffer[3]<<24) ;
+}
+
+static void loopback_reply(struct loopback *lb, fecusbType8 *reply, int *length, fecusbType32 value) {
+  reply[(*length)++] = (value & 0xff000000) >> 24 ;
+  reply[(*length)++] = (value & 0xff0000) >> 16 ;
+  reply[(*length)++] = (value & 0xff00) >> 8 ;
+  reply[(*length)++] = value & 0xff ;
+}
+
+static void loopback_write(struct loopback *lb, fecusbType16 address, fecusbType32 value) {
+  if (address==FECUSB_FIFOTRA_OFFSET_UNIQUE) {
+    if (lb->transmit_count<LOOPBACK_FIFO) lb->transmit[lb->transmit_count++] = value ;
+  }
+  else lb->reg[address] = value ;
+}
+
+static fecusbType32 loopback_read(struct loopback *lb, fecusbType16 address) {
+  if (address==FECUSB_FIFOREC_OFFSET_UNIQUE) {
+    if (lb->receive_first==lb->receive_count) return 0 ;
+    return lb->receive[lb->receive_first++] ;
+  }
+  return lb->reg[address] ;
+}
+
+/* decode the frames received and answer them in order */
+static void *loopback_run(void *arg) {
+
+  struct loopback *lb = (struct loopback*) arg ;
+  static fecusbType8 buffer[4*FECUSB_TXBUFLENGTH], reply[4*FECUSB_RXBUFLENGTH] ;
+  int length = 0 ;
+
+  for (;;) {
+    int status = read(lb->fd,buffer+length,sizeof(buffer)-length) ;
+    int index = 0, replyLength = 0 ;
+    if (status<=0) break ;
+    length += status ;
+
+    for (;;) {
+      fecusbType8 *frame = buffer+index ;
+      int left = length-index, size, words = 1, j ;
+      fecusbType16 address ;
+
+      if (left<7) break ;
+      address = frame[3] + (frame[4]<<8) ;
+      if (frame[2]==FECUSB_OPER_WRITE) size = 11 ;
+      else if (frame[2]==FECUSB_OPER_READ) size = 7 ;
+      else {
+	if (left<9) break ;
+	words = frame[7] + (frame[8]<<8) ;
+	size = (frame[1]==9) ? 9+4*words : 9 ;
+      }
+      if (left<size) break ;
+
+      switch (frame[2]) {
+      case FECUSB_OPER_WRITE:
+	loopback_write(lb,address,loopback_word(frame+7)) ;
+	loopback_reply(lb,reply,&replyLength,loopback_word(frame+7)) ;
+	break ;
+      case FECUSB_OPER_READ:
+	loopback_reply(lb,reply,&replyLength,loopback_read(lb,address)) ;
+	break ;
+      case FECUSB_OPER_HEARTBEAT:
+	for (j=0;j<62;j++) reply[replyLength++] = 0 ;
+	break ;
+      case FECUSB_OPER_WRITE_EMU:
+	for (j=0;j<words;j++) loopback_write(lb,address,loopback_word(frame+9+4*j)) ;
+	if (lb->access_version>0) loopback_reply(lb,reply,&replyLength,0xf000) ;
+	else for (j=0;j<words;j++) loopback_reply(lb,reply,&replyLength,loopback_word(frame+9+4*j)) ;
+	break ;
+      case FECUSB_OPER_READ_EMU:
+	for (j=0;j<words;j++) loopback_reply(lb,reply,&replyLength,loopback_read(lb,address)) ;
+	break ;
+      default:
+	printf("ERROR: loopback received an unknown command %d\n",frame[2]) ;
+	errors++ ;
+      }
+      lb->frames++ ;
+      index += size ;
+    }
+
+    memmove(buffer,buffer+index,length-index) ;
+    length -= index ;
+    if (replyLength && !lb->mute) write(lb->fd,reply,replyLength) ;
+  }
+
+  close(lb->fd) ;
+  return NULL ;
+}
+
+static int link_write(void *context, fecusbType8 *buffer, int count) {
+  struct usb_link *usb = (struct usb_link*) context ;
+  /* the window must have room for this transfer */
+  if (usb->pipe && usb->pipe->in_flight_count>=usb->pipe->max_in_flight) usb->window_error++ ;
+  usb->transfers++ ;
+  if (usb->latency) usleep(usb->latency) ;
+  return write(usb->fd,buffer,count) ;
+}
+
+static int link_read(void *context, fecusbType8 *buffer, int count) {
+  struct usb_link *usb = (struct usb_link*) context ;
+  int status = recv(usb->fd,buffer,count,MSG_DONTWAIT) ;
+  if (status<0 && (errno==EAGAIN || errno==EWOULDBLOCK)) return 0 ;
+  return status ;
+}
+
+static struct loopback lb ;
+static struct usb_link usb ;
+static pthread_t thread ;
+
+/* new loopback and pipe, crepe or fec board */
+static struct fec_usb_pipe *setup(int crepe, int access_version, int max_in_flight) {
+
+  struct fec_usb_mode mode = { crepe, 1, !crepe, 1, access_version } ;
+  int fds[2] ;
+
+  memset(&lb,0x00,sizeof(lb)) ;
+  memset(&usb,0x00,sizeof(usb)) ;
+  socketpair(AF_UNIX,SOCK_STREAM,0,fds) ;
+  lb.fd = fds[0] ;
+  lb.access_version = access_version ;
+  usb.fd = fds[1] ;
+  pthread_create(&thread,NULL,loopback_run,&lb) ;
+
+  usb.pipe = fec_usb_pipe_create(link_write,link_read,&usb,&mode,max_in_flight,200) ;
+  return usb.pipe ;
+}
+
+static void teardown(struct fec_usb_pipe *pipe) {
+  close(usb.fd) ;
+  pthread_join(thread,NULL) ;
+  fec_usb_pipe_destroy(pipe) ;
+}
+
+static void test_encoding() {
+
+  fecusbType8 buffer[64] ;
+  fecusbType32 data[3] = { 0x12345678, 2, 3 } ;
+  fecusbType8 write[11] = { 0, 9, FECUSB_OPER_WRITE, 0x04, 0x00, 0, 0, 0x78, 0x56, 0x34, 0x12 } ;
+  fecusbType8 read[7] = { 0, 5, FECUSB_OPER_READ, 0x20, 0x10, 0, 0 } ;
+  fecusbType8 readEmu[9] = { 0, 5, FECUSB_OPER_READ_EMU, 0x28, 0x00, 0, 0, 3, 0 } ;
+  struct fec_usb_mode crepe = { 1, 1, 0, 1, 1 }, fec = { 0, 1, 1, 1, 0 }, unknown = { 0, 0, 0, 0, 0 } ;
+  int cmd ;
+
+  check(fec_usb_encode_frame(FECUSB_OPER_WRITE,FECUSB_CTRL1_OFFSET,data,1,buffer)==11 && !memcmp(buffer,write,11),
+	"wrong frame for a write") ;
+  check(fec_usb_encode_frame(FECUSB_OPER_READ,0x1020,data,1,buffer)==7 && !memcmp(buffer,read,7),
+	"wrong frame for a read") ;
+  check(fec_usb_encode_frame(FECUSB_OPER_READ_EMU,FECUSB_FIFOREC_OFFSET_UNIQUE,data,3,buffer)==9 && !memcmp(buffer,readEmu,9),
+	"wrong frame for an emulator read") ;
+  check(fec_usb_encode_frame(FECUSB_OPER_WRITE_EMU,0,data,3,buffer)==21 && buffer[7]==3 && buffer[17]==3,
+	"wrong frame for an emulator write") ;
+  check(fec_usb_reply_length(FECUSB_OPER_WRITE_EMU,10,1)==4 && fec_usb_reply_length(FECUSB_OPER_WRITE_EMU,10,0)==40 &&
+	fec_usb_reply_length(FECUSB_OPER_HEARTBEAT,1,1)==62 && fec_usb_reply_length(FECUSB_OPER_WRITE,1,1)==4,
+	"wrong length of the replies") ;
+
+  check(fec_usb_map_cmd(&crepe,FECUSB_OPER_WRITE,&cmd)==FECUSB_RETURN_OK && cmd==FECUSB_OPER_WRITE_EMU,
+	"a crepe must use the emulator write") ;
+  check(fec_usb_map_cmd(&fec,FECUSB_OPER_READ_EMU,&cmd)==FECUSB_RETURN_OK && cmd==FECUSB_OPER_READ,
+	"a fec must use the fec read") ;
+  check(fec_usb_map_cmd(&fec,FECUSB_OPER_WRITE_EMU_LOCAL,&cmd)==FECUSB_ERROR_OPER_NOT_PERMITTED,
+	"a fec must refuse the crepe commands") ;
+  check(fec_usb_map_cmd(&unknown,FECUSB_OPER_READ,&cmd)==FECUSB_RETURN_OK && cmd==FECUSB_OPER_READ_EMU,
+	"a board not detected must use the emulator access") ;
+}
+
+/* registers written and read back in one flush, against one command per round trip */
+static void test_registers() {
+
+  static fecusbType32 values[1000], readback[1000] ;
+  struct fec_usb_pipe *pipe = setup(0,0,FECUSB_PIPE_MAX_IN_FLIGHT) ;
+  int i, ok = 1 ;
+
+  for (i=0;i<1000;i++) {
+    values[i] = 0xa5000000 + i*7 ;
+    readback[i] = 0 ;
+    check(fec_usb_pipe_write(pipe,FECUSB_OPER_WRITE,0x100+i,values+i,1)==FECUSB_RETURN_OK,"write not queued") ;
+    check(fec_usb_pipe_read(pipe,FECUSB_OPER_READ,0x100+i,readback+i,1)==FECUSB_RETURN_OK,"read not queued") ;
+  }
+  /* the words written are copied when the command is queued */
+  memset(values,0x00,sizeof(values)) ;
+
+  check(fec_usb_pipe_flush(pipe)==FECUSB_RETURN_OK,"flush of the registers failed") ;
+  for (i=0;i<1000;i++) ok &= (readback[i]==0xa5000000+i*7) ;
+  check(ok,"wrong values read back") ;
+  check(lb.frames==2000,"wrong number of frames received") ;
+  check(usb.transfers==(1000*18+FECUSB_PIPE_TRANSFER_LENGTH-1)/FECUSB_PIPE_TRANSFER_LENGTH,"commands not packed in the transfers") ;
+  check(pipe->bytes_out==1000*18 && pipe->bytes_in==2000*4,"wrong number of bytes") ;
+  check(usb.window_error==0 && pipe->max_in_flight_seen<=FECUSB_PIPE_MAX_IN_FLIGHT,"too many transfers in flight") ;
+
+  /* one command per flush as fec_usb_rw_unified */
+  usb.transfers = 0 ;
+  for (i=0;i<100;i++) {
+    fec_usb_pipe_read(pipe,FECUSB_OPER_READ,0x100+i,readback+i,1) ;
+    check(fec_usb_pipe_flush(pipe)==FECUSB_RETURN_OK,"flush of a read failed") ;
+  }
+  check(usb.transfers==100,"one transfer expected per flush") ;
+
+  teardown(pipe) ;
+}
+
+/* FIFO blocks through a small window */
+static void test_fifos() {
+
+  static fecusbType32 frames[5000], words[500] ;
+  struct fec_usb_pipe *pipe = setup(0,0,2) ;
+  int i, ok = 1 ;
+
+  for (i=0;i<5000;i++) frames[i] = i ;
+  check(fec_usb_pipe_write(pipe,FECUSB_OPER_WRITE,pipe->fifo_transmit,frames,5000)==FECUSB_RETURN_OK,"FIFO transmit not queued") ;
+  check(usb.transfers>0,"the transfers must be sent while the block is queued") ;
+  check(fec_usb_pipe_flush(pipe)==FECUSB_RETURN_OK,"flush of the FIFO transmit failed") ;
+  check(lb.transmit_count==5000,"wrong number of words in the FIFO transmit") ;
+  for (i=0;i<lb.transmit_count;i++) ok &= (lb.transmit[i]==i) ;
+  check(ok,"wrong words in the FIFO transmit") ;
+  check(usb.window_error==0 && pipe->max_in_flight_seen==2,"window of 2 transfers not used") ;
+
+  for (i=0;i<500;i++) lb.receive[i] = 0xc0000000 | i ;
+  lb.receive_count = 500 ;
+  check(fec_usb_pipe_read(pipe,FECUSB_OPER_READ,pipe->fifo_receive,words,500)==FECUSB_RETURN_OK,"FIFO receive not queued") ;
+  check(fec_usb_pipe_flush(pipe)==FECUSB_RETURN_OK,"flush of the FIFO receive failed") ;
+  ok = 1 ;
+  for (i=0;i<500;i++) ok &= (words[i]==(0xc0000000|i)) ;
+  check(ok,"wrong words read in the FIFO receive") ;
+
+  teardown(pipe) ;
+}
+
+/* crepe: the commands use the emulator access, one frame per block */
+static void test_crepe(int access_version) {
+
+  static fecusbType32 frames[100], words[50], value = 0 ;
+  struct fec_usb_pipe *pipe = setup(1,access_version,FECUSB_PIPE_MAX_IN_FLIGHT) ;
+  fecusbType32 cr0 = 0x1234 ;
+  int i, ok = 1 ;
+
+  for (i=0;i<100;i++) frames[i] = 0x77000000 + i ;
+  for (i=0;i<50;i++) lb.receive[i] = i ;
+  lb.receive_count = 50 ;
+
+  fec_usb_pipe_write(pipe,FECUSB_OPER_WRITE,pipe->fifo_transmit,frames,100) ;
+  fec_usb_pipe_write(pipe,FECUSB_OPER_WRITE,FECUSB_CTRL0_OFFSET,&cr0,1) ;
+  fec_usb_pipe_read(pipe,FECUSB_OPER_READ,FECUSB_CTRL0_OFFSET,&value,1) ;
+  fec_usb_pipe_read(pipe,FECUSB_OPER_READ,pipe->fifo_receive,words,50) ;
+  check(fec_usb_pipe_flush(pipe)==FECUSB_RETURN_OK,"flush on the crepe failed") ;
+
+  check(lb.frames==4,"a block must be one frame on a crepe") ;
+  check(usb.transfers==1,"one transfer expected on the crepe") ;
+  check(value==0x1234,"wrong CR0 read on the crepe") ;
+  for (i=0;i<50;i++) ok &= (words[i]==i) ;
+  for (i=0;i<100;i++) ok &= (lb.transmit[i]==0x77000000+i) ;
+  check(ok && lb.transmit_count==100,"wrong FIFO on the crepe") ;
+
+  teardown(pipe) ;
+}
+
+/* errors: refused command, no reply */
+static void test_errors() {
+
+  fecusbType32 value = 1 ;
+  struct fec_usb_pipe *pipe = setup(0,0,FECUSB_PIPE_MAX_IN_FLIGHT) ;
+  struct timeval start, stop, diff ;
+
+  check(fec_usb_pipe_write(pipe,FECUSB_OPER_WRITE_EMU_LOCAL,0,&value,1)==FECUSB_ERROR_OPER_NOT_PERMITTED,
+	"crepe command accepted on a fec") ;
+  check(fec_usb_pipe_read(pipe,FECUSB_OPER_READ,0,NULL,1)==FECUSB_ERROR_OPER_NOT_PERMITTED,"read without data accepted") ;
+  check(fec_usb_pipe_flush(pipe)==FECUSB_RETURN_OK,"a refused command must not fail the pipe") ;
+
+  lb.mute = 1 ;
+  fec_usb_pipe_read(pipe,FECUSB_OPER_READ,FECUSB_STAT0_OFFSET,&value,1) ;
+  gettimeofday(&start,NULL) ;
+  check(fec_usb_pipe_flush(pipe)==-ETIME,"no timeout without reply") ;
+  gettimeofday(&stop,NULL) ;
+  timersub(&stop,&start,&diff) ;
+  check(diff.tv_sec==0 && diff.tv_usec>=200000,"wrong timeout") ;
+
+  lb.mute = 0 ;
+  lb.reg[FECUSB_STAT0_OFFSET] = 0x4321 ;
+  fec_usb_pipe_read(pipe,FECUSB_OPER_READ,FECUSB_STAT0_OFFSET,&value,1) ;
+  check(fec_usb_pipe_flush(pipe)==FECUSB_RETURN_OK && value==0x4321,"the pipe must work after a timeout") ;
+
+  teardown(pipe) ;
+}
+
+/* time of the accesses of a frame sent on the ring: FIFO, CR1, CR0 and SR0 */
+static void benchmark() {
+
+  static fecusbType32 frame[8], cr = 0, sr0 = 0 ;
+  struct fec_usb_pipe *pipe = setup(0,0,FECUSB_PIPE_MAX_IN_FLIGHT) ;
+  struct timeval start, stop, diff[2] ;
+  unsigned long transfers[2] ;
+  int i, batch ;
+
+  usb.latency = 125 ;  /* one USB micro frame */
+  for (batch=0;batch<2;batch++) {
+    usb.transfers = 0 ;
+    gettimeofday(&start,NULL) ;
+    for (i=0;i<200;i++) {
+      fec_usb_pipe_write(pipe,FECUSB_OPER_WRITE,pipe->fifo_transmit,frame,8) ;
+      if (!batch) fec_usb_pipe_flush(pipe) ;
+      fec_usb_pipe_write(pipe,FECUSB_OPER_WRITE,FECUSB_CTRL1_OFFSET,&cr,1) ;
+      if (!batch) fec_usb_pipe_flush(pipe) ;
+      fec_usb_pipe_write(pipe,FECUSB_OPER_WRITE,FECUSB_CTRL0_OFFSET,&cr,1) ;
+      if (!batch) fec_usb_pipe_flush(pipe) ;
+      fec_usb_pipe_read(pipe,FECUSB_OPER_READ,FECUSB_STAT0_OFFSET,&sr0,1) ;
+      fec_usb_pipe_flush(pipe) ;
+    }
+    gettimeofday(&stop,NULL) ;
+    timersub(&stop,&start,diff+batch) ;
+    transfers[batch] = usb.transfers ;
+  }
+
+  printf("200 frames sent: %lu transfers in %ld.%06ld s one access per flush, %lu transfers in %ld.%06ld s batched\n",
+	 transfers[0],(long)diff[0].tv_sec,(long)diff[0].tv_usec,transfers[1],(long)diff[1].tv_sec,(long)diff[1].tv_usec) ;
+  check(transfers[0]==200*4 && transfers[1]==200,"wrong number of transfers in the benchmark") ;
+
+  teardown(pipe) ;
+}
+
+int main(int argc, char *argv[]) {
+
+  test_encoding() ;
+  test_registers() ;
+  test_fifos() ;
+  test_crepe(1) ;
+  test_crepe(0) ;
+  test_errors() ;
+  benchmark() ;
+
+  if (errors) {
+    printf("%d error(s)\n",errors) ;
+    return 1 ;
+  }
+  printf("All tests passed\n") ;
+  return 0 ;
+}
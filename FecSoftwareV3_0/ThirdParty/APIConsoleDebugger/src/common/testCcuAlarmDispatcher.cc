@@ -0,0 +1,307 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Copyright 2002 - 2003, Frederic DROUHIN - Universite de Haute-Alsace, Mulhouse-France
+*/
+#include <iostream>
+#include <deque>
+#include <list>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+
+#include <pthread.h>
+#include <unistd.h>     // usleep
+
+#include "CcuAlarmDispatcher.h"
+#include "TestFecRingDevice.h"
+
+/** Firmware of the fake FEC: the block transfer mode (setBlockDevicesBltMode) is not emulated
+ */
+#define FAKEFIRMWAREVERSION 0x15
+
+/**
+ * Ring where the frames are acknowledged by the CCUs (direct acknowledge with no error).
+ * CCU alarm frames can be injected in the FIFO receive with the acknowledges of a download
+ * or when the ring is idle.
+ */
+class FecAlarmRingDevice: public FecFakeRingDevice {
+
+ public:
+
+  FecAlarmRingDevice ( tscType8 fecSlot, tscType8 ringSlot ):
+    FecFakeRingDevice (fecSlot, ringSlot, FAKEFIRMWAREVERSION), alarmsPerSend_(0) {
+  }
+
+  /** Alarm frame: DST (FEC) SRC (CCU) LEN CHANNEL TRANSACTION (0) STATUS + status of the FEC
+   */
+  static std::vector<tscType8> buildAlarmFrame ( tscType8 ccu, tscType8 channel, tscType8 status ) {
+    tscType8 frame[] = { FRAMEFECNUMBER, ccu, 0x3, channel, 0x0, status, FECACKNOERROR32 } ;
+    return std::vector<tscType8> (frame, frame + sizeof(frame)) ;
+  }
+
+  /** The alarms are put in the FIFO receive after the first direct acknowledge of each send
+   */
+  void setDownloadAlarms ( const std::deque< std::vector<tscType8> > &alarms, unsigned int alarmsPerSend ) {
+    pthread_mutex_lock (&mutex_) ;
+    downloadAlarms_ = alarms ;
+    alarmsPerSend_ = alarmsPerSend ;
+    pthread_mutex_unlock (&mutex_) ;
+  }
+
+  unsigned int getDownloadAlarmsLeft ( ) { return downloadAlarms_.size() ; }
+
+ protected:
+
+  /** Direct acknowledge with no error, followed by the alarms of the download for the first frame
+   */
+  void answerFrame ( std::vector<tscType8> &frame, bool first ) {
+    frame.push_back (FECACKNOERROR32) ;
+    pushFrame (frame) ;
+
+    if (first) {
+      for (unsigned int i = 0 ; (i < alarmsPerSend_) && !downloadAlarms_.empty() ; i ++) {
+	pushFrame (downloadAlarms_.front()) ;
+	downloadAlarms_.pop_front() ;
+      }
+    }
+  }
+
+ private:
+
+  std::deque< std::vector<tscType8> > downloadAlarms_ ;
+  unsigned int alarmsPerSend_ ;
+} ;
+
+/** Check the bounded queue alone
+ */
+static int checkQueue ( ) {
+
+  int error = 0 ;
+  CcuAlarmQueue queue (3) ; // rounded to 4
+  CcuAlarmEvent event ;
+  for (unsigned int i = 0 ; i < 5 ; i ++) {
+    event.index = i ;
+    bool pushed = queue.push (event) ;
+    if (pushed != (i < 4)) {
+      std::cerr << "ERROR: queue push " << i << " returns " << pushed << std::endl ;
+      error ++ ;
+    }
+  }
+  if (queue.getLost() != 1) {
+    std::cerr << "ERROR: " << queue.getLost() << " events lost in the queue instead of 1" << std::endl ;
+    error ++ ;
+  }
+  for (unsigned int i = 0 ; i < 4 ; i ++) {
+    if (!queue.pop(event) || (event.index != i)) {
+      std::cerr << "ERROR: queue pop " << i << " returns the index " << event.index << std::endl ;
+      error ++ ;
+    }
+  }
+  if (queue.pop(event)) {
+    std::cerr << "ERROR: queue not empty" << std::endl ;
+    error ++ ;
+  }
+
+  return error ;
+}
+
+/** Wait for a number of events on a subscriber (2 s at most)
+ */
+static std::vector<CcuAlarmEvent> waitForEvents ( CcuAlarmDispatcher &dispatcher, unsigned int subscriber, unsigned int number ) {
+
+  std::vector<CcuAlarmEvent> events ;
+  CcuAlarmEvent event ;
+  for (unsigned int loop = 0 ; (loop < 2000) && (events.size() < number) ; loop ++) {
+    while (dispatcher.getEvent (subscriber, event)) events.push_back (event) ;
+    if (events.size() < number) usleep (1000) ;
+  }
+  // Nothing more should arrive
+  usleep (20000) ;
+  while (dispatcher.getEvent (subscriber, event)) events.push_back (event) ;
+
+  return events ;
+}
+
+/** Display the usage
+ */
+static void help ( char *program ) {
+
+  std::cout << program << " [-alarms <number>] [-help]" << std::endl ;
+  std::cout << "\t-alarms <number>: number of alarms injected during the download (default 12)" << std::endl ;
+}
+
+/**
+ * Download an I2C and PIA block on a fake ring while CCU alarms and PIA interrupts are injected
+ * in the FIFO receive and check that the download is not disturbed and that each subscriber of the
+ * dispatcher receives the events of its sources.
+ */
+int main ( int argc, char **argv ) {
+
+  unsigned int nAlarms = 12 ;
+  for (int i = 1 ; i < argc ; i ++) {
+    if (!strcmp(argv[i], "-alarms") && (i+1 < argc)) nAlarms = atoi(argv[++i]) ;
+    else {
+      help (argv[0]) ;
+      return 0 ;
+    }
+  }
+
+  int error = checkQueue() ;
+
+  tscType8 fecSlot = 3 ;
+  FecAlarmRingDevice ring0 (fecSlot, 0), ring1 (fecSlot, 1) ;
+
+  // Dispatcher on the two rings of the FEC
+  CcuAlarmDispatcher dispatcher ;
+  dispatcher.addRing (&ring0) ;
+  dispatcher.addRing (&ring1) ;
+  dispatcher.setPollingPeriod (50, 2000) ;
+
+  FecAlarmRingDevice otherFec (fecSlot+1, 0) ;
+  try {
+    dispatcher.addRing (&otherFec) ;
+    std::cerr << "ERROR: a ring of another FEC is accepted" << std::endl ;
+    error ++ ;
+  }
+  catch (FecExceptionHandler &e) { }
+
+  tscType8 suspectCcu = 0x12 ;
+  unsigned int all = dispatcher.subscribe (0, CCUALARMFILTERALL) ;
+  unsigned int piaCcu = dispatcher.subscribe (buildCompleteKey(fecSlot, 0, suspectCcu, 0, 0), CCUALARMFILTERCCU, PIAINTERRUPT) ;
+  unsigned int alarmsRing1 = dispatcher.subscribe (buildFecRingKey(fecSlot, 1), CCUALARMFILTERRING, CCUALARMINPUT) ;
+  dispatcher.start() ;
+
+  // -------------------------------------------------------------------------
+  // Alarms during a download on ring 0: PIA interrupts on all the CCUs and one CCU alarm
+  std::deque< std::vector<tscType8> > alarms ;
+  unsigned int nPiaSuspect = 0 ;
+  for (unsigned int i = 0 ; i < nAlarms ; i ++) {
+    tscType8 ccu = 0x10 + (i % 4) ;
+    if (i == nAlarms - 1) alarms.push_back (FecAlarmRingDevice::buildAlarmFrame (ccu, 0x0, 0x5)) ;
+    else {
+      alarms.push_back (FecAlarmRingDevice::buildAlarmFrame (ccu, 0x30 + (i % 4), 1 << (i % 8))) ;
+      if (ccu == suspectCcu) nPiaSuspect ++ ;
+    }
+  }
+  ring0.setDownloadAlarms (alarms, nAlarms / 4 + 1) ;
+
+  std::list<accessDeviceType> download ;
+  for (tscType8 ccu = 0x10 ; ccu < 0x14 ; ccu ++) {
+    for (tscType8 channel = 0x10 ; channel < 0x14 ; channel ++) {
+      for (tscType8 address = 0x20 ; address < 0x26 ; address ++) {
+	accessDeviceType access = { buildCompleteKey(fecSlot, 0, ccu, channel, address), NORMALMODE, MODE_WRITE, 0, address, false, 0, 0, 0, NULL } ;
+	download.push_back (access) ;
+      }
+    }
+    accessDeviceType access = { buildCompleteKey(fecSlot, 0, ccu, 0x30, 0), 0, MODE_WRITE, 0, 0xFF, false, 0, 0, 0, NULL } ;
+    download.push_back (access) ;
+  }
+
+  try {
+    ring0.setBlockDevices (download, false) ;
+  }
+  catch (FecExceptionHandler &e) {
+    std::cerr << "ERROR: download failed: " << e.what() << std::endl ;
+    error ++ ;
+  }
+
+  unsigned int downloadErrors = 0 ;
+  for (std::list<accessDeviceType>::iterator it = download.begin() ; it != download.end() ; it ++) {
+    if ((it->e != NULL) || (it->dAck != FECACKNOERROR32)) downloadErrors ++ ;
+  }
+  if (downloadErrors) {
+    std::cerr << "ERROR: " << downloadErrors << " frames of the download have an error" << std::endl ;
+    error += downloadErrors ;
+  }
+  if (ring0.getDownloadAlarmsLeft()) {
+    std::cerr << "ERROR: only " << nAlarms - ring0.getDownloadAlarmsLeft() << " alarms injected in " << ring0.getNumberOfSends() << " sends" << std::endl ;
+    error ++ ;
+  }
+  std::cout << download.size() << " frames downloaded in " << ring0.getNumberOfSends() << " sends with " << nAlarms << " alarms" << std::endl ;
+
+  // -------------------------------------------------------------------------
+  // Alarms on ring 1 when it is idle, after the late answer of a read (transaction 5) which must be reported
+  tscType8 lateAnswer[] = { FRAMEFECNUMBER, 0x20, 0x3, 0x10, 0x5, 0xAB, FECACKNOERROR32 } ;
+  ring1.injectFrame (std::vector<tscType8> (lateAnswer, lateAnswer + sizeof(lateAnswer))) ;
+  usleep (500) ;
+  unsigned int nIdle = 5 ;
+  for (unsigned int i = 0 ; i < nIdle ; i ++) {
+    ring1.injectFrame (FecAlarmRingDevice::buildAlarmFrame (0x20 + i, 0x0, 0x1 << (i % 4))) ;
+    usleep (500) ;
+  }
+
+  // -------------------------------------------------------------------------
+  // Check the subscribers
+  std::vector<CcuAlarmEvent> events = waitForEvents (dispatcher, all, nAlarms + nIdle) ;
+  if (events.size() != nAlarms + nIdle) {
+    std::cerr << "ERROR: " << events.size() << " events received instead of " << nAlarms + nIdle << std::endl ;
+    error ++ ;
+  }
+  else {
+    // Events of a ring are delivered in the order of arrival
+    unsigned int ring0Events = 0 ;
+    for (unsigned int i = 0 ; i < events.size() ; i ++) {
+      if (getRingKey(events[i].index) != 0) continue ;
+      std::vector<tscType8> &frame = alarms[ring0Events ++] ;
+      CcuAlarmEvent expected ;
+      CcuAlarmDispatcher::decodeFrame (buildFecRingKey(fecSlot, 0), &frame[0], expected) ;
+      if ((events[i].index != expected.index) || (events[i].type != expected.type) || (events[i].status != expected.status)) {
+	char msg[80] ; decodeKey (msg, events[i].index) ;
+	std::cerr << "ERROR: event " << i << " on " << msg << " status 0x" << std::hex << (int)events[i].status << std::dec << " not expected" << std::endl ;
+	error ++ ;
+      }
+    }
+  }
+
+  events = waitForEvents (dispatcher, piaCcu, nPiaSuspect) ;
+  if (events.size() != nPiaSuspect) {
+    std::cerr << "ERROR: " << events.size() << " PIA interrupts on the CCU 0x" << std::hex << (int)suspectCcu << std::dec << " instead of " << nPiaSuspect << std::endl ;
+    error ++ ;
+  }
+  for (unsigned int i = 0 ; i < events.size() ; i ++) {
+    if ((getCcuKey(events[i].index) != suspectCcu) || (events[i].type != PIAINTERRUPT)) {
+      std::cerr << "ERROR: event not filtered for the CCU 0x" << std::hex << (int)suspectCcu << std::dec << std::endl ;
+      error ++ ;
+    }
+  }
+
+  events = waitForEvents (dispatcher, alarmsRing1, nIdle) ;
+  if (events.size() != nIdle) {
+    std::cerr << "ERROR: " << events.size() << " CCU alarms on ring 1 instead of " << nIdle << std::endl ;
+    error ++ ;
+  }
+
+  dispatcher.stop() ;
+
+  if (dispatcher.getNumberOfUnexpectedFrames() != 1) {
+    std::cerr << "ERROR: " << dispatcher.getNumberOfUnexpectedFrames() << " unexpected frames reported instead of 1" << std::endl ;
+    error ++ ;
+  }
+
+  if (dispatcher.getNumberOfErrors() || ring0.getCcuAlarmFramesLost() || dispatcher.getEventsLost(all)) {
+    std::cerr << "ERROR: " << dispatcher.getNumberOfErrors() << " dispatcher errors, " << ring0.getCcuAlarmFramesLost() << " frames lost, "
+	      << dispatcher.getEventsLost(all) << " events lost" << std::endl ;
+    error ++ ;
+  }
+  std::cout << dispatcher.getNumberOfEvents() << " events dispatched" << std::endl ;
+
+  if (error) std::cerr << error << " error(s)" << std::endl ;
+  else std::cout << "All tests passed" << std::endl ;
+
+  return error ? -1 : 0 ;
+}
@@ -0,0 +1,426 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Copyright 2002 - 2003, Frederic DROUHIN - Universite de Haute-Alsace, Mulhouse-France
+*/
+#include <iostream>
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "FecDeviceDriftAuditor.h"
+
+/** Registers of the fake APV, in the order of the reads
+ */
+static const char *apvRegisters[] = { "apvMode", "latency", "muxGain", "ipre", "ipcasc", "ipsf", "isha", "issf",
+				      "ipsp", "imuxin", "ical", "ispare", "vfp", "vfs", "vpsp", "cdrv", "csel" } ;
+#define FAKEAPVREGISTERS (sizeof(apvRegisters)/sizeof(const char *))
+
+/** Registers of the fake PLL
+ */
+static const char *pllRegisters[] = { "clockPhase", "triggerDelay" } ;
+#define FAKEPLLREGISTERS (sizeof(pllRegisters)/sizeof(const char *))
+
+/** Device simulated: reference and hardware values of each register
+ */
+typedef struct {
+  enumDeviceType deviceType ;
+  std::vector<std::string> names ;
+  std::vector<unsigned int> reference, hardware ;
+  std::set<std::string> stuck ;
+  bool hasReference ;
+  bool failing ;
+} fakeDeviceType ;
+
+/**
+ * Devices without hardware. A register in the stuck set ignores the writes, a failing device raises
+ * an exception on each read. The reads and writes are counted and the ring lock is checked on each access.
+ */
+class FakeDriftAccess: public FecDeviceDriftAccess {
+
+ public:
+
+  FakeDriftAccess ( ): lockErrors_(0), registerWrites_(0), deviceWrites_(0) { }
+
+  void addDevice ( keyType index, enumDeviceType deviceType, const char **names, unsigned int number, bool hasReference = true ) {
+
+    fakeDeviceType device ;
+    device.deviceType = deviceType ;
+    for (unsigned int i = 0 ; i < number ; i ++) {
+      device.names.push_back (names[i]) ;
+      device.reference.push_back (i + 10) ;
+      device.hardware.push_back (i + 10) ;
+    }
+    device.hasReference = hasReference ;
+    device.failing = false ;
+    devices_[index] = device ;
+    order_.push_back (index) ;
+  }
+
+  fakeDeviceType &getDevice ( keyType index ) { return devices_[index] ; }
+
+  void setHardware ( keyType index, const std::string &name, unsigned int value ) {
+    fakeDeviceType &device = devices_[index] ;
+    for (unsigned int i = 0 ; i < device.names.size() ; i ++) if (device.names[i] == name) device.hardware[i] = value ;
+  }
+
+  unsigned int getHardware ( keyType index, const std::string &name ) {
+    fakeDeviceType &device = devices_[index] ;
+    for (unsigned int i = 0 ; i < device.names.size() ; i ++) if (device.names[i] == name) return device.hardware[i] ;
+    return 0 ;
+  }
+
+  void setBusy ( keyType ringIndex, bool busy ) {
+    if (busy) busy_.insert (ringIndex) ;
+    else busy_.erase (ringIndex) ;
+  }
+
+  void getDevices ( std::vector< std::pair<enumDeviceType, keyType> > &devices ) {
+    for (std::vector<keyType>::iterator it = order_.begin() ; it != order_.end() ; it ++)
+      devices.push_back (std::make_pair(devices_[*it].deviceType, *it)) ;
+  }
+
+  bool tryLockRing ( keyType ringIndex ) {
+    if (busy_.find(ringIndex) != busy_.end()) return false ;
+    if (locked_.find(ringIndex) != locked_.end()) lockErrors_ ++ ;
+    locked_.insert (ringIndex) ;
+    return true ;
+  }
+
+  void unlockRing ( keyType ringIndex ) {
+    if (locked_.erase (ringIndex) != 1) lockErrors_ ++ ;
+  }
+
+  bool readRegisters ( enumDeviceType deviceType, keyType index, std::vector<driftRegisterType> &registers ) throw (FecExceptionHandler) {
+
+    checkLock (index) ;
+    fakeDeviceType &device = devices_[index] ;
+    if (!device.hasReference) return false ;
+    if (device.failing) RAISEFECEXCEPTIONHANDLER_HARDPOSITION (TSCFEC_REGISTERACCESS, "Fake device not answering", ERRORCODE, index) ;
+
+    reads_[index] ++ ;
+    for (unsigned int i = 0 ; i < device.names.size() ; i ++) {
+      driftRegisterType reg = { device.names[i].c_str(), device.reference[i], device.hardware[i] } ;
+      registers.push_back (reg) ;
+    }
+    return true ;
+  }
+
+  void writeRegister ( enumDeviceType deviceType, keyType index, const char *registerName, unsigned int value ) throw (FecExceptionHandler) {
+
+    checkLock (index) ;
+    registerWrites_ ++ ;
+    if (devices_[index].stuck.find(registerName) == devices_[index].stuck.end()) setHardware (index, registerName, value) ;
+  }
+
+  void writeDevice ( enumDeviceType deviceType, keyType index ) throw (FecExceptionHandler) {
+
+    checkLock (index) ;
+    deviceWrites_ ++ ;
+    fakeDeviceType &device = devices_[index] ;
+    for (unsigned int i = 0 ; i < device.names.size() ; i ++)
+      if (device.stuck.find(device.names[i]) == device.stuck.end()) device.hardware[i] = device.reference[i] ;
+  }
+
+  unsigned int getReads ( keyType index ) { return reads_[index] ; }
+  unsigned int getRegisterWrites ( ) { return registerWrites_ ; }
+  unsigned int getDeviceWrites ( ) { return deviceWrites_ ; }
+  unsigned int getLockErrors ( ) { return lockErrors_ + locked_.size() ; }
+  void clearCounters ( ) { reads_.clear() ; registerWrites_ = deviceWrites_ = 0 ; }
+
+ private:
+
+  /** The device must be accessed with the lock of its ring
+   */
+  void checkLock ( keyType index ) {
+    if (locked_.find(getFecKeyRingKey(index)) == locked_.end()) lockErrors_ ++ ;
+  }
+
+  std::map<keyType, fakeDeviceType> devices_ ;
+  std::vector<keyType> order_ ;
+  std::set<keyType> busy_, locked_ ;
+  unsigned int lockErrors_ ;
+  std::map<keyType, unsigned int> reads_ ;
+  unsigned int registerWrites_, deviceWrites_ ;
+} ;
+
+/** Delete the errors and return their number
+ */
+static unsigned int clearErrors ( std::list<FecExceptionHandler *> &errorList, unsigned int code = 0, unsigned int *withCode = NULL ) {
+
+  unsigned int number = errorList.size() ;
+  if (withCode != NULL) *withCode = 0 ;
+  for (std::list<FecExceptionHandler *>::iterator it = errorList.begin() ; it != errorList.end() ; it ++) {
+    if ((withCode != NULL) && ((*it)->getErrorCode() == code)) (*withCode) ++ ;
+    delete *it ;
+  }
+  errorList.clear() ;
+  return number ;
+}
+
+/** Audit until all the devices are audited once more
+ */
+static void auditPass ( FecDeviceDriftAuditor &auditor, std::list<FecExceptionHandler *> &errorList ) {
+
+  unsigned long passes = auditor.getNumberOfPasses() ;
+  for (unsigned int i = 0 ; (i < 100) && (auditor.getNumberOfPasses() == passes) ; i ++) auditor.auditStep (errorList) ;
+}
+
+int main ( int argc, char **argv ) {
+
+  int error = 0 ;
+
+  // Ring 0: 4 APVs, ring 1: 6 PLLs and one PLL without reference
+  keyType ring0 = buildFecRingKey(1,0) ;
+  std::vector<keyType> apvs, plls ;
+  FakeDriftAccess access ;
+  for (unsigned int i = 0 ; i < 4 ; i ++) {
+    apvs.push_back (buildCompleteKey(1,0,(0x10+i),0x10,0x20)) ;
+    access.addDevice (apvs.back(), APV25, apvRegisters, FAKEAPVREGISTERS) ;
+  }
+  for (unsigned int i = 0 ; i < 6 ; i ++) {
+    plls.push_back (buildCompleteKey(1,1,(0x10+i),0x10,0x44)) ;
+    access.addDevice (plls.back(), PLL, pllRegisters, FAKEPLLREGISTERS) ;
+  }
+  keyType noReference = buildCompleteKey(1,1,0x20,0x10,0x44) ;
+  access.addDevice (noReference, PLL, pllRegisters, FAKEPLLREGISTERS, false) ;
+
+  std::list<FecExceptionHandler *> errorList ;
+
+  // ---------------------------------------------------------- Budgets
+  {
+    FecDeviceDriftAuditor auditor (access) ;
+    if (auditor.getNumberOfDevices() != 11) {
+      std::cerr << "ERROR: " << auditor.getNumberOfDevices() << " devices to be audited instead of 11" << std::endl ;
+      error ++ ;
+    }
+
+    // Frame budget: one APV (at least one device) on ring 0, 3 PLLs on ring 1
+    auditor.setBudget (1000000, 5) ;
+    unsigned int audited = auditor.auditStep (errorList) ;
+    if ((audited != 4) || (auditor.getNumberOfReads() != FAKEAPVREGISTERS + 3 * FAKEPLLREGISTERS)) {
+      std::cerr << "ERROR: frame budget of 5: " << audited << " devices audited and " << auditor.getNumberOfReads() << " registers read" << std::endl ;
+      error ++ ;
+    }
+    if ((access.getReads(apvs[0]) != 1) || (access.getReads(apvs[1]) != 0) || (access.getReads(plls[2]) != 1) || (access.getReads(plls[3]) != 0)) {
+      std::cerr << "ERROR: frame budget of 5: wrong devices audited" << std::endl ;
+      error ++ ;
+    }
+
+    // The next step continues where the previous one stopped
+    auditor.auditStep (errorList) ;
+    if ((access.getReads(apvs[1]) != 1) || (access.getReads(plls[5]) != 1) || (access.getReads(plls[0]) != 1)) {
+      std::cerr << "ERROR: the audit does not continue from the last device audited" << std::endl ;
+      error ++ ;
+    }
+
+    // No time budget: one device per ring
+    access.clearCounters() ;
+    auditor.setBudget (0, 1000) ;
+    audited = auditor.auditStep (errorList) ;
+    if (audited != 2) {
+      std::cerr << "ERROR: " << audited << " devices audited without time budget instead of one per ring" << std::endl ;
+      error ++ ;
+    }
+
+    // A busy ring is skipped, the other one is audited
+    access.clearCounters() ;
+    access.setBusy (ring0, true) ;
+    auditor.setBudget (1000000, 1000) ;
+    unsigned long yields = auditor.getNumberOfYields() ;
+    audited = auditor.auditStep (errorList) ;
+    for (unsigned int i = 0 ; i < apvs.size() ; i ++) if (access.getReads(apvs[i])) {
+      std::cerr << "ERROR: APV audited while its ring is busy" << std::endl ;
+      error ++ ;
+      break ;
+    }
+    if ((audited != 7) || (auditor.getNumberOfYields() != yields + 1)) {
+      std::cerr << "ERROR: busy ring: " << audited << " devices audited and " << auditor.getNumberOfYields() - yields << " yields" << std::endl ;
+      error ++ ;
+    }
+    access.setBusy (ring0, false) ;
+
+    // Passes are counted on the slowest ring: 4 steps for the 4 APVs
+    FecDeviceDriftAuditor passAuditor (access) ;
+    passAuditor.setBudget (1000000, FAKEAPVREGISTERS) ;
+    for (unsigned int i = 0 ; i < 3 ; i ++) passAuditor.auditStep (errorList) ;
+    if (passAuditor.getNumberOfPasses() != 0) {
+      std::cerr << "ERROR: " << passAuditor.getNumberOfPasses() << " passes after 3 steps instead of 0" << std::endl ;
+      error ++ ;
+    }
+    passAuditor.auditStep (errorList) ;
+    if (passAuditor.getNumberOfPasses() != 1) {
+      std::cerr << "ERROR: " << passAuditor.getNumberOfPasses() << " passes after 4 steps instead of 1" << std::endl ;
+      error ++ ;
+    }
+    if (access.getReads(noReference) != 0) {
+      std::cerr << "ERROR: device without reference audited" << std::endl ;
+      error ++ ;
+    }
+    if (clearErrors (errorList)) {
+      std::cerr << "ERROR: errors found on devices without drift" << std::endl ;
+      error ++ ;
+    }
+  }
+
+  // ---------------------------------------------------------- Drift database
+  {
+    FecDeviceDriftAuditor auditor (access, DRIFTREPORT) ;
+    access.clearCounters() ;
+    access.setHardware (apvs[2], "latency", 0x99) ;
+
+    auditPass (auditor, errorList) ;
+    unsigned int comparisons = 0 ;
+    unsigned int errors = clearErrors (errorList, XDAQFEC_ERRORINCOMPARISON, &comparisons) ;
+    if ((errors != 1) || (comparisons != 1)) {
+      std::cerr << "ERROR: " << errors << " errors and " << comparisons << " comparison errors for the first drift instead of 1" << std::endl ;
+      error ++ ;
+    }
+
+    deviceDriftType drift ;
+    if (!auditor.getDrift (apvs[2], "latency", drift)) {
+      std::cerr << "ERROR: drift of the latency not in the database" << std::endl ;
+      error ++ ;
+    }
+    else if ((drift.index != apvs[2]) || (drift.deviceType != APV25) || (drift.expected != access.getDevice(apvs[2]).reference[1]) ||
+	     (drift.read != 0x99) || (drift.count != 1) || (drift.rewrites != 0) || !drift.active || (drift.firstSeen != drift.lastSeen)) {
+      std::cerr << "ERROR: wrong drift of the latency: expected 0x" << std::hex << drift.expected << " read 0x" << drift.read << std::dec
+		<< " count " << drift.count << " rewrites " << drift.rewrites << " active " << drift.active << std::endl ;
+      error ++ ;
+    }
+
+    // Found again: counted but not reported, nothing written with DRIFTREPORT
+    auditPass (auditor, errorList) ;
+    if (clearErrors (errorList)) {
+      std::cerr << "ERROR: drift reported twice" << std::endl ;
+      error ++ ;
+    }
+    auditor.getDrift (apvs[2], "latency", drift) ;
+    if ((drift.count != 2) || (drift.lastSeen < drift.firstSeen)) {
+      std::cerr << "ERROR: drift count " << drift.count << " instead of 2" << std::endl ;
+      error ++ ;
+    }
+    if (access.getRegisterWrites() || access.getDeviceWrites() || auditor.getNumberOfRewrites() || (access.getHardware(apvs[2], "latency") != 0x99)) {
+      std::cerr << "ERROR: register written with the policy DRIFTREPORT" << std::endl ;
+      error ++ ;
+    }
+
+    // Back to the reference: the drift is kept but not active
+    access.setHardware (apvs[2], "latency", access.getDevice(apvs[2]).reference[1]) ;
+    auditPass (auditor, errorList) ;
+    if ((auditor.getDrifts(true).size() != 0) || (auditor.getDrifts().size() != 1)) {
+      std::cerr << "ERROR: " << auditor.getDrifts(true).size() << " active drifts and " << auditor.getDrifts().size() << " drifts instead of 0 and 1" << std::endl ;
+      error ++ ;
+    }
+    auditor.clearDrifts() ;
+    if (auditor.getDrifts().size() || auditor.getDrift (apvs[2], "latency", drift)) {
+      std::cerr << "ERROR: drift database not cleared" << std::endl ;
+      error ++ ;
+    }
+
+    // A device not answering is reported and the other devices are audited
+    access.getDevice(plls[1]).failing = true ;
+    access.setHardware (plls[4], "clockPhase", 0x3) ;
+    access.clearCounters() ;
+    auditPass (auditor, errorList) ;
+    unsigned int errorsAccess = 0 ;
+    errors = clearErrors (errorList, TSCFEC_REGISTERACCESS, &errorsAccess) ;
+    if ((errors != 2) || (errorsAccess != 1) || !auditor.getDrift (plls[4], "clockPhase", drift)) {
+      std::cerr << "ERROR: device not answering: " << errors << " errors, " << errorsAccess << " access errors" << std::endl ;
+      error ++ ;
+    }
+    access.getDevice(plls[1]).failing = false ;
+    access.setHardware (plls[4], "clockPhase", access.getDevice(plls[4]).reference[0]) ;
+  }
+
+  // ---------------------------------------------------------- Rewrite policy
+  {
+    // APV registers written one by one
+    FecDeviceDriftAuditor auditor (access, DRIFTREWRITEREGISTER) ;
+    access.clearCounters() ;
+    access.setHardware (apvs[0], "vfp", 0) ;
+    access.setHardware (apvs[0], "ical", 0) ;
+    auditPass (auditor, errorList) ;
+    clearErrors (errorList) ;
+    if ((access.getRegisterWrites() != 2) || access.getDeviceWrites() || (auditor.getNumberOfRewrites() != 2)) {
+      std::cerr << "ERROR: DRIFTREWRITEREGISTER on an APV: " << access.getRegisterWrites() << " register writes, "
+		<< access.getDeviceWrites() << " device writes" << std::endl ;
+      error ++ ;
+    }
+    auditPass (auditor, errorList) ;
+    clearErrors (errorList) ;
+    deviceDriftType drift ;
+    if ((access.getRegisterWrites() != 2) || !auditor.getDrift (apvs[0], "vfp", drift) || drift.active || (drift.count != 1) || (drift.rewrites != 1)) {
+      std::cerr << "ERROR: APV register not restored by DRIFTREWRITEREGISTER" << std::endl ;
+      error ++ ;
+    }
+
+    // Register which cannot be restored: only reported after the maximum number of rewrites
+    auditor.setPolicy (DRIFTREWRITEREGISTER, 2) ;
+    access.clearCounters() ;
+    access.getDevice(apvs[3]).stuck.insert ("isha") ;
+    access.setHardware (apvs[3], "isha", 0) ;
+    for (unsigned int i = 0 ; i < 5 ; i ++) auditPass (auditor, errorList) ;
+    clearErrors (errorList) ;
+    if ((access.getRegisterWrites() != 2) || !auditor.getDrift (apvs[3], "isha", drift) || (drift.count != 5) || (drift.rewrites != 2) || !drift.active) {
+      std::cerr << "ERROR: stuck register written " << access.getRegisterWrites() << " times instead of 2, found "
+		<< drift.count << " times" << std::endl ;
+      error ++ ;
+    }
+    access.getDevice(apvs[3]).stuck.clear() ;
+    access.setHardware (apvs[3], "isha", access.getDevice(apvs[3]).reference[6]) ;
+
+    // Other devices are downloaded completly
+    access.clearCounters() ;
+    access.setHardware (plls[2], "triggerDelay", 0) ;
+    auditPass (auditor, errorList) ;
+    clearErrors (errorList) ;
+    if ((access.getDeviceWrites() != 1) || access.getRegisterWrites() || (access.getHardware(plls[2], "triggerDelay") != access.getDevice(plls[2]).reference[1])) {
+      std::cerr << "ERROR: DRIFTREWRITEREGISTER on a PLL: " << access.getDeviceWrites() << " device writes, "
+		<< access.getRegisterWrites() << " register writes" << std::endl ;
+      error ++ ;
+    }
+
+    // APV downloaded once for all its registers
+    FecDeviceDriftAuditor deviceAuditor (access, DRIFTREWRITEDEVICE) ;
+    access.clearCounters() ;
+    access.setHardware (apvs[1], "vpsp", 0) ;
+    access.setHardware (apvs[1], "cdrv", 0) ;
+    access.setHardware (apvs[1], "csel", 0) ;
+    auditPass (deviceAuditor, errorList) ;
+    unsigned int comparisons = 0 ;
+    clearErrors (errorList, XDAQFEC_ERRORINCOMPARISON, &comparisons) ;
+    if ((comparisons != 3) || (access.getDeviceWrites() != 1) || access.getRegisterWrites() || (deviceAuditor.getNumberOfRewrites() != 1) ||
+	(access.getHardware(apvs[1], "csel") != access.getDevice(apvs[1]).reference[16])) {
+      std::cerr << "ERROR: DRIFTREWRITEDEVICE on an APV: " << comparisons << " drifts, " << access.getDeviceWrites() << " device writes, "
+		<< access.getRegisterWrites() << " register writes" << std::endl ;
+      error ++ ;
+    }
+  }
+
+  if (access.getLockErrors()) {
+    std::cerr << "ERROR: " << access.getLockErrors() << " accesses without the lock of the ring" << std::endl ;
+    error ++ ;
+  }
+
+  if (error) std::cerr << error << " error(s)" << std::endl ;
+  else std::cout << "All tests passed" << std::endl ;
+
+  return error ? -1 : 0 ;
+}
@@ -0,0 +1,351 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Copyright 2002 - 2003, Frederic DROUHIN - Universite de Haute-Alsace, Mulhouse-France
+*/
+#include <iostream>
+#include <deque>
+#include <list>
+#include <set>
+#include <cstdlib>
+#include <cstring>
+
+#include <pthread.h>
+
+#include "FecErrorRecorder.h"
+#include "TestFecRingDevice.h"
+#include "TestTime.h"
+
+/** Firmware of the fake FEC: block transfer with the number of words in the SR0
+ */
+#define FAKEFIRMWAREVERSION MINFIRMWAREVERSION
+
+/** Status of the direct acknowledge given by the bad CCU
+ */
+#define FAKEBADACKNOWLEDGE 0x09
+
+/**
+ * Ring where the CCU answers to each frame with a bad direct acknowledge.
+ * The bus and the ring take no time so only the software is measured.
+ */
+class FecFailingRingDevice: public FecFakeRingDevice {
+
+ public:
+
+  FecFailingRingDevice ( tscType8 fecSlot, tscType8 ringSlot ):
+    FecFakeRingDevice (fecSlot, ringSlot, FAKEFIRMWAREVERSION) {
+  }
+
+ protected:
+
+  void answerFrame ( std::vector<tscType8> &frame, bool first ) {
+    frame.push_back (FAKEBADACKNOWLEDGE) ;
+    pushFrame (frame) ;
+  }
+} ;
+
+/** Download of the latency of all the APVs of a ring: one module per i2c channel of each CCU
+ */
+static void buildDownload ( tscType8 fecSlot, unsigned int nCcu, accessDeviceTypeList &vAccessDevices ) {
+
+  for (unsigned int ccu = 0x1 ; ccu <= nCcu ; ccu ++)
+    for (unsigned int channel = 0x10 ; channel <= 0x1F ; channel ++)
+      for (unsigned int address = 0x20 ; address <= 0x25 ; address ++) {
+	accessDeviceType access = { buildCompleteKey(fecSlot, 0, ccu, channel, address), RALMODE, MODE_WRITE, 0x04, 0x20, false, 0, 0, 0, NULL } ;
+	vAccessDevices.push_back (access) ;
+      }
+}
+
+/** Order of the records, records lost and message
+ */
+static int checkRecorder ( ) {
+
+  int error = 0 ;
+  FecErrorRecorder errorRecorder (4) ;
+  accessDeviceType access = { buildCompleteKey(1, 0, 0x10, 0x10, 0x20), RALMODE, MODE_WRITE, 0, 0, false, 0, 0, 0, NULL } ;
+  for (unsigned int i = 0 ; i < 6 ; i ++) {
+    access.tnum = i ;
+    if (NEWFRAMEERROR (&errorRecorder, DD_DATA_CORRUPT_ON_WRITE, "Bad status in frame", (i == 2) ? CRITICALERRORCODE : ERRORCODE,
+		       access.index, access, "Status of frame", i) != FecErrorRecorder::getRecordedError()) {
+      std::cerr << "ERROR: the error was not recorded" << std::endl ;
+      error ++ ;
+    }
+  }
+  errorRecorder.addException (NEWFECEXCEPTIONHANDLER (TSCFEC_SR0NOTNOMINAL, "Ring lost", WARNINGCODE)) ;
+
+  if ((errorRecorder.getNumberOfErrors() != 7) || (errorRecorder.getNumberOfRecords() != 4) || (errorRecorder.getNumberOfLostRecords() != 2)) {
+    std::cerr << "ERROR: " << errorRecorder.getNumberOfErrors() << " errors, " << errorRecorder.getNumberOfRecords() << " records, "
+	      << errorRecorder.getNumberOfLostRecords() << " lost" << std::endl ;
+    error ++ ;
+  }
+  if ((errorRecorder.getRecord(0).transaction != 2) || (errorRecorder.getRecord(3).transaction != 5)) {
+    std::cerr << "ERROR: the oldest records are not the ones lost" << std::endl ;
+    error ++ ;
+  }
+  if (errorRecorder.getMessage(0).find ("Status of frame") == std::string::npos) {
+    std::cerr << "ERROR: message of the record: " << errorRecorder.getMessage(0) << std::endl ;
+    error ++ ;
+  }
+
+  try {
+    errorRecorder.raise() ;
+    std::cerr << "ERROR: no exception raised" << std::endl ;
+    error ++ ;
+  }
+  catch (FecExceptionHandler &e) {
+    if ((e.getFaultSeverity() != CRITICALERRORCODE) || (e.getInformationSup() != 2)) {
+      std::cerr << "ERROR: the most severe error was not raised: " << e.what() << std::endl ;
+      error ++ ;
+    }
+  }
+
+  // exception of the ring, 4 records and the records lost
+  std::list<FecExceptionHandler *> errorList ;
+  if ((errorRecorder.getErrorList (errorList) != 6) || (errorList.size() != 6) || (errorList.front()->getErrorCode() != TSCFEC_SR0NOTNOMINAL)) {
+    std::cerr << "ERROR: conversion in a list of " << errorList.size() << " exceptions" << std::endl ;
+    error ++ ;
+  }
+  for (std::list<FecExceptionHandler *>::iterator it = errorList.begin() ; it != errorList.end() ; it ++) delete *it ;
+
+  errorRecorder.clear() ;
+  try {
+    errorRecorder.raise() ;
+  }
+  catch (FecExceptionHandler &e) {
+    std::cerr << "ERROR: exception raised without error" << std::endl ;
+    error ++ ;
+  }
+
+  return error ;
+}
+
+/** The error of a ring is one exception kept by the recorder for all the frames
+ */
+static int checkRingError ( ) {
+
+  int error = 0 ;
+  FecErrorRecorder errorRecorder ;
+  FecErrorRecorder *noRecorder = NULL ;
+  keyType ringKey = buildFecRingKey(1,0) ;
+
+  FecExceptionHandler *first = NEWRINGERROR (&errorRecorder, TSCFEC_SR0NOTNOMINAL, "Fails on sending a frame, ring lost", CRITICALERRORCODE, ringKey, "FEC status register 0", 0) ;
+  FecExceptionHandler *second = NEWRINGERROR (&errorRecorder, TSCFEC_SR0NOTNOMINAL, "Fails on sending a frame, ring lost", CRITICALERRORCODE, ringKey, "FEC status register 0", 0) ;
+  FecExceptionHandler *other = NEWRINGERROR (&errorRecorder, TSCFEC_SR0NOTNOMINAL, "Fails on sending a frame, ring lost", CRITICALERRORCODE, buildFecRingKey(1,1), "FEC status register 0", 0) ;
+  if ((first == FecErrorRecorder::getRecordedError()) || (first != second) || (first == other) ||
+      (errorRecorder.getExceptions().size() != 2) || errorRecorder.getNumberOfRecords()) {
+    std::cerr << "ERROR: " << errorRecorder.getExceptions().size() << " exceptions kept for the ring lost on two rings" << std::endl ;
+    error ++ ;
+  }
+
+  // Each frame of the block gives the same exception to the recorder
+  accessDeviceTypeList vAccessDevices ;
+  accessDeviceType access = { buildCompleteKey(1, 0, 0x10, 0x10, 0x20), RALMODE, MODE_WRITE, 0, 0, false, 0, 0, 0, NULL } ;
+  for (unsigned int i = 0 ; i < 3 ; i ++) {
+    access.e = first ;
+    vAccessDevices.push_back (access) ;
+  }
+  if ((DeviceFrame::decodeErrorFrame (vAccessDevices, errorRecorder) != 3) || (errorRecorder.getExceptions().size() != 2)) {
+    std::cerr << "ERROR: the exception of the ring is kept several times" << std::endl ;
+    error ++ ;
+  }
+
+  // Without recorder each frame has its exception as before
+  FecExceptionHandler *e1 = NEWRINGERROR (noRecorder, TSCFEC_SR0NOTNOMINAL, "Fails on sending a frame, ring lost", CRITICALERRORCODE, ringKey, "FEC status register 0", 0) ;
+  FecExceptionHandler *e2 = NEWRINGERROR (noRecorder, TSCFEC_SR0NOTNOMINAL, "Fails on sending a frame, ring lost", CRITICALERRORCODE, ringKey, "FEC status register 0", 0) ;
+  if ((e1 == e2) || (e1->getErrorCode() != TSCFEC_SR0NOTNOMINAL) || (e1->getHardPosition() != ringKey)) {
+    std::cerr << "ERROR: no new exception for the ring lost without recorder" << std::endl ;
+    error ++ ;
+  }
+  delete e1 ;
+  delete e2 ;
+
+  return error ;
+}
+
+/** Download on a ring with or without recorder
+ */
+typedef struct {
+  FecRingDevice *ring ;
+  bool recorder ;
+  unsigned int nCcu ;
+  unsigned int recordedErrors ;
+  unsigned int errors ;
+} downloadThreadType ;
+
+/** Downloads on a thread, the errors of a download without recorder must never be the shared marker of the recorder
+ */
+static void *downloadThread ( void *arg ) {
+
+  downloadThreadType *download = (downloadThreadType *)arg ;
+  for (unsigned int i = 0 ; i < 20 ; i ++) {
+    accessDeviceTypeList vAccessDevices ;
+    buildDownload (download->ring->getFecSlot(), download->nCcu, vAccessDevices) ;
+    if (download->recorder) {
+      FecErrorRecorder errorRecorder ;
+      download->ring->setBlockDevices (vAccessDevices, false, &errorRecorder) ;
+      download->errors += DeviceFrame::decodeErrorFrame (vAccessDevices, errorRecorder) ;
+    }
+    else {
+      std::list<FecExceptionHandler *> errorList ;
+      download->ring->setBlockDevices (vAccessDevices, false) ;
+      download->errors += DeviceFrame::decodeErrorFrame (vAccessDevices, errorList) ;
+      for (std::list<FecExceptionHandler *>::iterator it = errorList.begin() ; it != errorList.end() ; it ++) {
+	if (*it == FecErrorRecorder::getRecordedError()) download->recordedErrors ++ ;
+	else delete *it ;
+      }
+    }
+  }
+  return NULL ;
+}
+
+/** A download with a recorder and a download without recorder on the same ring at the same time
+ */
+static int checkConcurrentDownloads ( FecRingDevice &ring, unsigned int nCcu ) {
+
+  int error = 0 ;
+  downloadThreadType downloads[2] = { { &ring, true, nCcu, 0, 0 }, { &ring, false, nCcu, 0, 0 } } ;
+  pthread_t threads[2] ;
+  for (unsigned int i = 0 ; i < 2 ; i ++) pthread_create (&threads[i], NULL, downloadThread, &downloads[i]) ;
+  for (unsigned int i = 0 ; i < 2 ; i ++) pthread_join (threads[i], NULL) ;
+
+  if (downloads[1].recordedErrors) {
+    std::cerr << "ERROR: " << downloads[1].recordedErrors << " errors of the download without recorder are the marker of the recorder" << std::endl ;
+    error ++ ;
+  }
+  unsigned int frames = 20 * nCcu * 16 * 6 ;
+  if ((downloads[0].errors != frames) || (downloads[1].errors != frames)) {
+    std::cerr << "ERROR: " << downloads[0].errors << " and " << downloads[1].errors << " errors instead of " << frames << std::endl ;
+    error ++ ;
+  }
+
+  return error ;
+}
+
+/**
+ * Check the FecErrorRecorder and compare the time of a download on a ring where all the frames fail
+ * with the exceptions and with the recorder.
+ */
+int main ( int argc, char **argv ) {
+
+  tscType8 fecSlot = 5 ;
+  unsigned int nCcu = 100 ;
+  if ((argc > 1) && atoi(argv[1]) > 0) nCcu = atoi(argv[1]) ;
+
+  int error = 0 ;
+  try {
+    error += checkRecorder() ;
+    error += checkRingError() ;
+
+    FecFailingRingDevice ring (fecSlot, 0) ;
+    error += checkConcurrentDownloads (ring, 5) ;
+
+    // -------------------------------------------------------------------------
+    // Exceptions
+    accessDeviceTypeList vAccessExceptions ;
+    buildDownload (fecSlot, nCcu, vAccessExceptions) ;
+    std::list<FecExceptionHandler *> errorList ;
+
+    unsigned long long start = getNanoSeconds() ;
+    ring.setBlockDevices (vAccessExceptions, false) ;
+    unsigned int errorExceptions = DeviceFrame::decodeErrorFrame (vAccessExceptions, errorList) ;
+    unsigned long long exceptionTime = getNanoSeconds() - start ;
+    FecExceptionHandler *lastException = errorList.back() ;
+
+    // -------------------------------------------------------------------------
+    // Recorder
+    accessDeviceTypeList vAccessRecorder ;
+    buildDownload (fecSlot, nCcu, vAccessRecorder) ;
+    FecErrorRecorder errorRecorder ;
+
+    start = getNanoSeconds() ;
+    ring.setBlockDevices (vAccessRecorder, false, &errorRecorder) ;
+    unsigned int errorRecorded = DeviceFrame::decodeErrorFrame (vAccessRecorder, errorRecorder) ;
+    unsigned long long recorderTime = getNanoSeconds() - start ;
+
+    std::cout << vAccessRecorder.size() << " frames in error: " << exceptionTime / 1000 << " us with the exceptions, "
+	      << recorderTime / 1000 << " us with the recorder" << std::endl ;
+
+    if ((errorExceptions != vAccessExceptions.size()) || (errorRecorded != vAccessRecorder.size()) ||
+	(errorRecorder.getNumberOfErrors() != vAccessRecorder.size()) ||
+	(errorRecorder.getNumberOfLostRecords() != vAccessRecorder.size() - FECERRORRECORDERSIZE)) {
+      std::cerr << "ERROR: " << errorExceptions << " exceptions, " << errorRecorded << " errors recorded for " << vAccessRecorder.size() << " frames" << std::endl ;
+      error ++ ;
+    }
+    for (accessDeviceTypeList::iterator it = vAccessRecorder.begin() ; it != vAccessRecorder.end() ; it ++) {
+      if (it->e != NULL) {
+	std::cerr << "ERROR: error of a frame not collected" << std::endl ;
+	error ++ ;
+	break ;
+      }
+    }
+
+    // The last record gives the same exception as the last exception
+    const fecErrorRecordType &lastRecord = errorRecorder.getRecord (errorRecorder.getNumberOfRecords() - 1) ;
+    FecExceptionHandler *lastConverted = FecErrorRecorder::newException (lastRecord) ;
+    if ((lastConverted->getErrorCode() != lastException->getErrorCode()) || (lastConverted->getHardPosition() != lastException->getHardPosition()) ||
+	(lastConverted->getInformationSup() != lastException->getInformationSup()) || (lastConverted->getErrorMessage() != lastException->getErrorMessage()) ||
+	(lastRecord.registerOffset != vAccessRecorder.back().offset)) {
+      std::cerr << "ERROR: the record is different from the exception" << std::endl ;
+      std::cerr << lastConverted->what() << std::endl << lastException->what() << std::endl ;
+      error ++ ;
+    }
+    delete lastConverted ;
+
+    // One error per device and the records lost
+    std::list<FecExceptionHandler *> errorListDevice ;
+    errorRecorder.getErrorList (errorListDevice, true) ;
+    std::set<keyType> devices ;
+    for (unsigned int i = 0 ; i < errorRecorder.getNumberOfRecords() ; i ++) devices.insert (errorRecorder.getRecord(i).hardPosition) ;
+    if ((errorListDevice.size() != devices.size() + 1) || (errorListDevice.back()->getErrorCode() != TOOMUCHERROR)) {
+      std::cerr << "ERROR: " << errorListDevice.size() << " exceptions for " << devices.size() << " devices" << std::endl ;
+      error ++ ;
+    }
+    for (std::list<FecExceptionHandler *>::iterator it = errorListDevice.begin() ; it != errorListDevice.end() ; it ++) delete *it ;
+
+    for (std::list<FecExceptionHandler *>::iterator it = errorList.begin() ; it != errorList.end() ; it ++) delete *it ;
+
+    // -------------------------------------------------------------------------
+    // Error of each frame only: the download above is dominated by the management of the ring
+    FecErrorRecorder *noRecorder = NULL ;
+    start = getNanoSeconds() ;
+    for (accessDeviceTypeList::iterator it = vAccessExceptions.begin() ; it != vAccessExceptions.end() ; it ++) {
+      FecExceptionHandler *e = NEWFRAMEERROR (noRecorder, DD_DATA_CORRUPT_ON_WRITE, "Bad status in frame", ERRORCODE, it->index, *it, "Status of frame", FAKEBADACKNOWLEDGE) ;
+      delete e ;
+    }
+    exceptionTime = getNanoSeconds() - start ;
+    errorRecorder.clear() ;
+    start = getNanoSeconds() ;
+    for (accessDeviceTypeList::iterator it = vAccessRecorder.begin() ; it != vAccessRecorder.end() ; it ++)
+      NEWFRAMEERROR (&errorRecorder, DD_DATA_CORRUPT_ON_WRITE, "Bad status in frame", ERRORCODE, it->index, *it, "Status of frame", FAKEBADACKNOWLEDGE) ;
+    recorderTime = getNanoSeconds() - start ;
+
+    std::cout << "Errors only: " << exceptionTime / 1000 << " us with the exceptions, " << recorderTime / 1000 << " us with the recorder" << std::endl ;
+    if (recorderTime >= exceptionTime) {
+      std::cerr << "ERROR: the recorder is not faster than the exceptions" << std::endl ;
+      error ++ ;
+    }
+  }
+  catch (FecExceptionHandler &e) {
+    std::cerr << "ERROR: " << e.what() << std::endl ;
+    error ++ ;
+  }
+
+  if (error) std::cerr << error << " error(s)" << std::endl ;
+  else std::cout << "All tests passed" << std::endl ;
+
+  return error ? -1 : 0 ;
+}
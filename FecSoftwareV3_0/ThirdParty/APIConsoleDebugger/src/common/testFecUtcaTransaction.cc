@@ -0,0 +1,275 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <iostream>
+#include <vector>
+
+#include "FecExceptionHandler.h"
+#include "FecUtcaTransaction.h"
+#include "FecUtcaBusModel.h"
+#include "TestTime.h"
+
+/** Check a number of round trips
+ */
+static int checkRoundTrips ( const char *name, FecUtcaBusModel &model, unsigned long expected ) {
+
+  if (model.getRoundTrips() != expected) {
+    std::cerr << "ERROR: " << name << ": " << model.getRoundTrips() << " round trips instead of " << expected << std::endl ;
+    model.resetCounters() ;
+    return 1 ;
+  }
+  model.resetCounters() ;
+  return 0 ;
+}
+
+/** Frames sent by a thread on its ring
+ */
+typedef struct {
+  FecUtcaBusModel *model ;
+  unsigned int ring, frames, words ;
+  int error ;
+} RingThread ;
+
+static void *sendFrames ( void *arg ) {
+
+  RingThread &thread = *(RingThread *)arg ;
+  try {
+    FecUtcaRingTransport transport (*thread.model, thread.ring) ;
+    std::vector<tscType32> frame (thread.words) ;
+    for (unsigned int i = 0 ; i < thread.frames ; i ++) {
+      for (unsigned int w = 0 ; w < thread.words ; w ++) frame[w] = (thread.ring << 24) | (i << 8) | w ;
+      transport.writeTransmitFifo (&frame[0], frame.size()) ;
+      transport.writeRegister (FecUtcaRingTransport::CR0, i) ;
+      if (transport.readRegister (FecUtcaRingTransport::CR0) != i) thread.error ++ ;
+    }
+  }
+  catch (FecExceptionHandler &e) {
+    thread.error ++ ;
+  }
+  return NULL ;
+}
+
+/** Test of the uTCA FEC transactions on the model of the IPbus nodes
+ */
+int main ( int argc, char *argv[] ) {
+
+  unsigned int nFrames = 200, nWords = 32 ;
+  unsigned long roundTripTime = 100 ;
+  for (int i = 1 ; i < argc ; i ++) {
+    if ((strcmp(argv[i], "-frames") == 0) && (i+1 < argc)) nFrames = atoi(argv[++i]) ;
+    else if ((strcmp(argv[i], "-words") == 0) && (i+1 < argc)) nWords = atoi(argv[++i]) ;
+    else if ((strcmp(argv[i], "-roundTripTime") == 0) && (i+1 < argc)) roundTripTime = atoi(argv[++i]) ;
+    else {
+      std::cerr << argv[0] << std::endl ;
+      std::cerr << "  -frames <number of frames for the benchmark>" << std::endl ;
+      std::cerr << "  -words <number of words per frame>" << std::endl ;
+      std::cerr << "  -roundTripTime <duration of an IPbus round trip in us>" << std::endl ;
+      return 0 ;
+    }
+  }
+  if (nWords == 0) nWords = 1 ;
+
+  int error = 0 ;
+
+  try {
+    FecUtcaBusModel model ;
+
+    // Futures: valid only after the dispatch which executes the read and until the next one
+    FecUtcaTransaction transaction (model) ;
+    unsigned int cr0 = model.getNodeId("FEC_Rd_Wr.control.ring1.CR0") ;
+    unsigned int sr0 = model.getNodeId("FEC_Rd.status.ring1.SR0") ;
+    model.setRegister("FEC_Rd.status.ring1.SR0", 0x4c90) ;
+    transaction.write (cr0, 0x1234) ;
+    FecUtcaValue vCr0 = transaction.read (cr0) ;
+    FecUtcaValue vSr0 = transaction.read (sr0) ;
+    if (vCr0.isValid() || (transaction.getNumberOfAccesses() != 3)) {
+      std::cerr << "ERROR: read valid before the dispatch" << std::endl ;
+      error ++ ;
+    }
+    try {
+      vCr0.value() ;
+      std::cerr << "ERROR: no exception for a value read before the dispatch" << std::endl ;
+      error ++ ;
+    }
+    catch (FecExceptionHandler &e) { }
+    transaction.dispatch() ;
+    if (!vCr0.isValid() || (vCr0.value() != 0x1234) || (vSr0.value() != 0x4c90)) {
+      std::cerr << "ERROR: wrong values read: CR0 0x" << std::hex << vCr0.value() << " SR0 0x" << vSr0.value() << std::dec << std::endl ;
+      error ++ ;
+    }
+    transaction.dispatch() ; // empty, nothing sent
+    if (!vCr0.isValid()) {
+      std::cerr << "ERROR: an empty dispatch invalidates the values" << std::endl ;
+      error ++ ;
+    }
+    error += checkRoundTrips("write and two reads", model, 1) ;
+    FecUtcaValue vRead = transaction.read (sr0) ;
+    transaction.dispatch() ;
+    if (vCr0.isValid() || !vRead.isValid()) {
+      std::cerr << "ERROR: the values of a previous dispatch are still valid" << std::endl ;
+      error ++ ;
+    }
+    transaction.write (sr0, 0) ;
+    vRead = transaction.read (cr0) ;
+    try {
+      transaction.dispatch() ;
+      std::cerr << "ERROR: no exception for a write in a status register" << std::endl ;
+      error ++ ;
+    }
+    catch (FecExceptionHandler &e) { }
+    if (vRead.isValid() || transaction.getNumberOfAccesses()) {
+      std::cerr << "ERROR: the failed dispatch left values or accesses" << std::endl ;
+      error ++ ;
+    }
+    model.resetCounters() ;
+
+    // Nodes of a ring which does not exist
+    try {
+      FecUtcaRingTransport transport (model, 5) ;
+      std::cerr << "ERROR: no exception for the ring 5" << std::endl ;
+      error ++ ;
+    }
+    catch (FecExceptionHandler &e) { }
+
+    // Registers and FIFOs of a ring
+    FecUtcaRingTransport transport (model, 2) ;
+    transport.writeRegister (FecUtcaRingTransport::CR1, 0x3) ;
+    if (transport.readRegister (FecUtcaRingTransport::CR1) != 0x3) {
+      std::cerr << "ERROR: CR1 not written" << std::endl ;
+      error ++ ;
+    }
+    error += checkRoundTrips("write and read of CR1", model, 2) ;
+
+    std::vector<tscType32> frame (nWords) ;
+    for (unsigned int w = 0 ; w < nWords ; w ++) frame[w] = 0xA0000000 | w ;
+    transport.writeTransmitFifo (&frame[0], frame.size()) ;
+    if (model.getTransmitFifo(2) != frame) {
+      std::cerr << "ERROR: wrong frame in the FIFO transmit" << std::endl ;
+      error ++ ;
+    }
+    error += checkRoundTrips("frame in the FIFO transmit", model, 1) ;
+
+    for (unsigned int w = 0 ; w < nWords ; w ++) model.pushReceiveFifo (2, w) ;
+    std::vector<tscType32> received = transport.readReceiveFifo() ;
+    if ((received.size() != nWords) || (received[nWords-1] != nWords-1)) {
+      std::cerr << "ERROR: " << received.size() << " words read from the FIFO receive instead of " << nWords << std::endl ;
+      error ++ ;
+    }
+    error += checkRoundTrips("FIFO receive", model, 2) ;
+    if (!transport.readReceiveFifo().empty()) {
+      std::cerr << "ERROR: the FIFO receive is not empty" << std::endl ;
+      error ++ ;
+    }
+    error += checkRoundTrips("empty FIFO receive", model, 1) ;
+
+    // Local bus: the acknowledge is read with the command and with the data
+    tscType32 value = 0 ;
+    if (transport.sendCommand (0x24, 0x5a, NULL) || (model.getLocalRegister(2, 0x24) != 0x5a)) {
+      std::cerr << "ERROR: write on the local bus failed" << std::endl ;
+      error ++ ;
+    }
+    error += checkRoundTrips("write on the local bus", model, 2) ;
+    if (transport.sendCommand (0x24, 0, &value) || (value != 0x5a)) {
+      std::cerr << "ERROR: read on the local bus failed, value 0x" << std::hex << value << std::dec << std::endl ;
+      error ++ ;
+    }
+    error += checkRoundTrips("read on the local bus", model, 2) ;
+    model.setAckDelay (2, 1) ;
+    value = 0 ;
+    if (transport.sendCommand (0x24, 0, &value) || (value != 0x5a)) {
+      std::cerr << "ERROR: read on a slow local bus failed" << std::endl ;
+      error ++ ;
+    }
+    error += checkRoundTrips("read on a slow local bus", model, 3) ;
+    model.setAckDelay (2, 0) ;
+
+    // Reset of all the rings
+    FecUtcaRingTransport::hardReset (model, 0, 3) ;
+    if ((model.getRegister("FEC_Rd_Wr.ring3.aclr_n") != 1) || (model.getRegister("FEC_Rd_Wr.fec_tx_clk_shift") != 1) || (model.getRegister("FEC_Rd_Wr.fec_rx_clk_shift") != 1)) {
+      std::cerr << "ERROR: reset or clock shift not set" << std::endl ;
+      error ++ ;
+    }
+    error += checkRoundTrips("hard reset", model, 2) ;
+
+    // The rings share the bus
+    RingThread threads[4] ;
+    pthread_t ids[4] ;
+    bool running[4] ;
+    for (unsigned int ring = 0 ; ring < 4 ; ring ++) {
+      threads[ring].model = &model ; threads[ring].ring = ring ;
+      threads[ring].frames = 50 ; threads[ring].words = 8 ; threads[ring].error = 0 ;
+      model.getTransmitFifo(ring).clear() ;
+      running[ring] = (pthread_create (&ids[ring], NULL, sendFrames, &threads[ring]) == 0) ;
+      if (!running[ring]) sendFrames (&threads[ring]) ;
+    }
+    for (unsigned int ring = 0 ; ring < 4 ; ring ++) {
+      if (running[ring]) pthread_join (ids[ring], NULL) ;
+      if (threads[ring].error || (model.getTransmitFifo(ring).size() != 50 * 8) || ((model.getTransmitFifo(ring)[8*49] >> 24) != ring)) {
+	std::cerr << "ERROR: frames of the ring " << ring << " lost or mixed with another ring" << std::endl ;
+	error ++ ;
+      }
+    }
+    error += checkRoundTrips("4 rings in parallel", model, 4 * 50 * 3) ;
+
+    // Benchmark: one round trip per word as in FecRingDevice::setFifoTransmit(tscType32 *, int) against one per frame
+    model.setRoundTripTime (roundTripTime) ;
+    unsigned int fifoNode = model.getNodeId("FIFO.ring2.TRA") ;
+    unsigned long start = getMicroSeconds() ;
+    for (unsigned int i = 0 ; i < nFrames ; i ++) {
+      for (unsigned int w = 0 ; w < nWords ; w ++) {
+	transaction.write (fifoNode, frame[w]) ;
+	transaction.dispatch() ;
+      }
+    }
+    unsigned long wordTime = getMicroSeconds() - start ;
+    unsigned long wordTrips = model.getRoundTrips() ;
+    model.resetCounters() ;
+    start = getMicroSeconds() ;
+    for (unsigned int i = 0 ; i < nFrames ; i ++) transport.writeTransmitFifo (&frame[0], frame.size()) ;
+    unsigned long frameTime = getMicroSeconds() - start ;
+    unsigned long frameTrips = model.getRoundTrips() ;
+    model.resetCounters() ;
+    std::cout << nFrames << " frames of " << nWords << " words, " << roundTripTime << " us per round trip:" << std::endl ;
+    std::cout << "  one dispatch per word : " << wordTrips << " round trips in " << wordTime << " us" << std::endl ;
+    std::cout << "  one dispatch per frame: " << frameTrips << " round trips in " << frameTime << " us" << std::endl ;
+    if ((wordTrips != (unsigned long)nFrames * nWords) || (frameTrips != nFrames)) {
+      std::cerr << "ERROR: wrong number of round trips in the benchmark" << std::endl ;
+      error ++ ;
+    }
+
+    // Commands on the local bus: 5 round trips with one dispatch per step, 2 with the transactions
+    start = getMicroSeconds() ;
+    for (unsigned int i = 0 ; i < nFrames ; i ++) transport.sendCommand (0x24, i, NULL) ;
+    std::cout << "  " << nFrames << " commands on the local bus: " << model.getRoundTrips() << " round trips in " << getMicroSeconds() - start
+	      << " us (" << 5 * nFrames << " with one dispatch per step)" << std::endl ;
+    model.resetCounters() ;
+  }
+  catch (FecExceptionHandler &e) {
+    std::cerr << "ERROR: " << e.what() << std::endl ;
+    error ++ ;
+  }
+
+  if (error) std::cerr << error << " error(s)" << std::endl ;
+  else std::cout << "All tests passed" << std::endl ;
+
+  return error ? -1 : 0 ;
+}
@@ -0,0 +1,203 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Copyright 2002 - 2003, Frederic DROUHIN - Universite de Haute-Alsace, Mulhouse-France
+*/
+#include <iostream>
+#include <map>
+#include <vector>
+#include <cstdlib>
+
+
+#include "hashMapDefinition.h"
+#include "tscTypes.h"
+#include "keyType.h"
+#include "KeyTypeTable.h"
+#include "TestTime.h"
+
+/** Devices of a crate: 20 FECs, 8 rings, 10 CCUs, 12 modules per CCU with 6 APVs, MUX, PLL and laserdriver
+ */
+static void buildCrate ( std::vector<keyType> &keys ) {
+
+  tscType8 addresses[] = { 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x43, 0x44, 0x60 } ;
+  for (unsigned int fec = 1 ; fec <= 20 ; fec ++)
+    for (unsigned int ring = 0 ; ring < 8 ; ring ++)
+      for (unsigned int ccu = 1 ; ccu <= 10 ; ccu ++)
+	for (unsigned int channel = 0x10 ; channel < 0x1C ; channel ++)
+	  for (unsigned int i = 0 ; i < sizeof(addresses) ; i ++)
+	    keys.push_back (buildCompleteKey(fec, ring, ccu, channel, addresses[i])) ;
+}
+
+/** Compare the table with a std::map
+ */
+static int compareTable ( KeyTypeTable<unsigned long> &table, std::map<keyType, unsigned long> &reference, std::string step ) {
+
+  if (table.size() != reference.size()) {
+    std::cerr << "ERROR: " << step << ": " << table.size() << " values instead of " << reference.size() << std::endl ;
+    return 1 ;
+  }
+  for (std::map<keyType, unsigned long>::iterator it = reference.begin() ; it != reference.end() ; it ++) {
+    KeyTypeTable<unsigned long>::iterator found = table.find (it->first) ;
+    if ((found == table.end()) || (found->first != it->first) || (found->second != it->second)) {
+      std::cerr << "ERROR: " << step << ": key 0x" << std::hex << it->first << std::dec << " not found" << std::endl ;
+      return 1 ;
+    }
+  }
+  unsigned int n = 0 ;
+  for (KeyTypeTable<unsigned long>::const_iterator it = table.begin() ; it != table.end() ; it ++, n ++) {
+    if (reference.find (it->first) == reference.end()) {
+      std::cerr << "ERROR: " << step << ": key 0x" << std::hex << it->first << std::dec << " should not be present" << std::endl ;
+      return 1 ;
+    }
+  }
+  if (n != reference.size()) {
+    std::cerr << "ERROR: " << step << ": " << n << " values iterated instead of " << reference.size() << std::endl ;
+    return 1 ;
+  }
+  return 0 ;
+}
+
+/**
+ * Check the KeyTypeTable against a std::map and compare the lookup and the iteration with Sgi::hash_map on the devices of a crate.
+ */
+int main ( int argc, char **argv ) {
+
+  int error = 0 ;
+  std::vector<keyType> keys ;
+  buildCrate (keys) ;
+
+  // -------------------------------------------------------------------------
+  // Insertion order and dense rings
+  KeyTypeTable<unsigned long> table ;
+  for (unsigned int i = 0 ; i < keys.size() ; i ++) table[keys[i]] = i ;
+  unsigned int i = 0 ;
+  for (KeyTypeTable<unsigned long>::iterator it = table.begin() ; it != table.end() ; it ++, i ++) {
+    if ((it->first != keys[i]) || (it->second != i)) {
+      std::cerr << "ERROR: iteration is not in the order of insertion" << std::endl ;
+      error ++ ;
+      break ;
+    }
+  }
+  if (table.getNumberOfDenseRings() != 20*8) {
+    std::cerr << "ERROR: " << table.getNumberOfDenseRings() << " dense rings instead of " << 20*8 << std::endl ;
+    error ++ ;
+  }
+
+  // -------------------------------------------------------------------------
+  // Random operations compared to std::map, with keys outside of the dense table
+  std::map<keyType, unsigned long> reference ;
+  KeyTypeTable<unsigned long> randomTable ;
+  srand (1) ;
+  for (unsigned int op = 0 ; op < 200000 ; op ++) {
+    keyType key ;
+    unsigned int fec = 1 + rand() % 20, ring = rand() % 8, ccu = 1 + rand() % 3, channel = 0x70 + rand() % 4, address = 0x80 + rand() % 0x80 ;
+    switch (rand() % 4) {
+    case 0: key = buildFecRingKey(fec, ring) ; break ;                            // sparse rings
+    case 1: key = buildCompleteKey(fec % 4, 0, ccu, channel, 0x20) ; break ;      // channel without slot
+    case 2: key = buildCompleteKey(1, 1, 0x7F, 0x10, address) ; break ;           // address on 8 bits
+    default: key = keys[rand() % 4000] ; break ;                                  // dense rings
+    }
+    if (rand() % 3) {
+      randomTable[key] = op ;
+      reference[key] = op ;
+    }
+    else if (randomTable.erase (key) != reference.erase (key)) {
+      std::cerr << "ERROR: erase of 0x" << std::hex << key << std::dec << " differs" << std::endl ;
+      error ++ ;
+      break ;
+    }
+  }
+  error += compareTable (randomTable, reference, "random operations") ;
+
+  std::pair<KeyTypeTable<unsigned long>::iterator, bool> inserted = randomTable.insert (std::make_pair (keys[0], 2UL)) ;
+  if (inserted.second != (reference.find (keys[0]) == reference.end())) {
+    std::cerr << "ERROR: insert of a key already present" << std::endl ;
+    error ++ ;
+  }
+  if (inserted.second) reference[keys[0]] = 2 ;
+
+  // Erase during the iteration
+  for (KeyTypeTable<unsigned long>::iterator it = randomTable.begin() ; it != randomTable.end() ; it ++)
+    if (it->second % 2) randomTable.erase (it->first) ;
+  for (std::map<keyType, unsigned long>::iterator it = reference.begin() ; it != reference.end() ; )
+    if (it->second % 2) reference.erase (it ++) ; else it ++ ;
+  error += compareTable (randomTable, reference, "erase during iteration") ;
+
+  // Copy and clear
+  KeyTypeTable<unsigned long> copyTable = randomTable ;
+  randomTable.clear() ;
+  error += compareTable (copyTable, reference, "copy") ;
+  if (!randomTable.empty() || (randomTable.begin() != randomTable.end()) || (randomTable.find (keys[0]) != randomTable.end())) {
+    std::cerr << "ERROR: table not empty after clear" << std::endl ;
+    error ++ ;
+  }
+
+  // -------------------------------------------------------------------------
+  // Lookup and iteration compared to Sgi::hash_map
+  Sgi::hash_map<keyType, unsigned long> hashMap ;
+  for (unsigned int i = 0 ; i < keys.size() ; i ++) hashMap[keys[i]] = i ;
+
+  // Lookup in the order of the devices of the rings (download/upload of the FecAccessManager) and in a random order
+  std::vector<keyType> lookups (keys) ;
+  for (unsigned int i = lookups.size() - 1 ; i > 0 ; i --) std::swap (lookups[i], lookups[rand() % (i + 1)]) ;
+
+  unsigned long long hashLookup[2], tableLookup[2] ;
+  unsigned long sumHash = 0, sumTable = 0 ;
+  for (unsigned int order = 0 ; order < 2 ; order ++) {
+    std::vector<keyType> &devices = order ? lookups : keys ;
+    unsigned long long start = getNanoSeconds() ;
+    for (unsigned int pass = 0 ; pass < 10 ; pass ++)
+      for (unsigned int i = 0 ; i < devices.size() ; i ++) sumHash += hashMap.find(devices[i])->second ;
+    hashLookup[order] = getNanoSeconds() - start ;
+    start = getNanoSeconds() ;
+    for (unsigned int pass = 0 ; pass < 10 ; pass ++)
+      for (unsigned int i = 0 ; i < devices.size() ; i ++) sumTable += table.find(devices[i])->second ;
+    tableLookup[order] = getNanoSeconds() - start ;
+  }
+
+  unsigned long long start = getNanoSeconds() ;
+  for (unsigned int pass = 0 ; pass < 10 ; pass ++)
+    for (Sgi::hash_map<keyType, unsigned long>::iterator it = hashMap.begin() ; it != hashMap.end() ; it ++) sumHash += it->second ;
+  unsigned long long hashIteration = getNanoSeconds() - start ;
+  start = getNanoSeconds() ;
+  for (unsigned int pass = 0 ; pass < 10 ; pass ++)
+    for (KeyTypeTable<unsigned long>::iterator it = table.begin() ; it != table.end() ; it ++) sumTable += it->second ;
+  unsigned long long tableIteration = getNanoSeconds() - start ;
+
+  std::cout << keys.size() << " devices, 10 passes" << std::endl ;
+  std::cout << "Lookup in the order of the rings: " << hashLookup[0] / 1000 << " us with Sgi::hash_map, " << tableLookup[0] / 1000 << " us with KeyTypeTable" << std::endl ;
+  std::cout << "Lookup in a random order: " << hashLookup[1] / 1000 << " us with Sgi::hash_map, " << tableLookup[1] / 1000 << " us with KeyTypeTable" << std::endl ;
+  std::cout << "Iteration: " << hashIteration / 1000 << " us with Sgi::hash_map, " << tableIteration / 1000 << " us with KeyTypeTable" << std::endl ;
+  std::cout << "Index of the KeyTypeTable: " << table.getIndexMemorySize() << " bytes" << std::endl ;
+
+  if (sumHash != sumTable) {
+    std::cerr << "ERROR: values found are different" << std::endl ;
+    error ++ ;
+  }
+  // The lookups depend on the cache of the processor, only the iteration is checked (without optimisation the accessors of the containers are not inlined)
+#ifdef __OPTIMIZE__
+  if (tableIteration >= hashIteration) {
+    std::cerr << "ERROR: the iteration of the KeyTypeTable is slower than Sgi::hash_map" << std::endl ;
+    error ++ ;
+  }
+#endif
+
+  if (error) std::cerr << error << " error(s)" << std::endl ;
+  else std::cout << "All tests passed" << std::endl ;
+
+  return error ? -1 : 0 ;
+}
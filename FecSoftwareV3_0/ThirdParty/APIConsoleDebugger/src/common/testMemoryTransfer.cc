@@ -0,0 +1,417 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Copyright 2002 - 2003, Frederic DROUHIN - Universite de Haute-Alsace, Mulhouse-France
+*/
+#include <iostream>
+#include <iomanip>
+#include <deque>
+#include <list>
+#include <map>
+#include <set>
+#include <sstream>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+
+
+#include "TestFecRingDevice.h"
+#include "TestTime.h"
+
+/** Firmware of the fake FEC
+ */
+#define FAKEFIRMWAREVERSION 0x15
+
+/** Time of a register or single FIFO word access on the bus in ns
+ */
+#define FAKEBUSACCESS 1000
+
+/** Time per word of a block FIFO access in ns
+ */
+#define FAKEBUSBLOCKWORD 50
+
+/** Time to transfer one byte on the ring in ns
+ */
+#define FAKERINGBYTE 200
+
+/**
+ * Ring with CCUs with a memory channel. The time of the bus accesses and the transfer
+ * of the frames on the ring (one frame at a time, FAKERINGBYTE per byte plus the latency of the ring) are
+ * emulated so the throughput of the transfers can be compared. The CCUs answer to the CRE read and to
+ * the multiple byte read and write of the memory channel.
+ */
+class FecMemoryRingDevice: public FecFakeRingDevice {
+
+ public:
+
+  FecMemoryRingDevice ( tscType8 fecSlot, tscType8 ringSlot, unsigned long long latency ):
+    FecFakeRingDevice (fecSlot, ringSlot, FAKEFIRMWAREVERSION), latency_(latency), jitter_(0), sendTime_(0), ringFree_(0) {
+  }
+
+  /** Memory of a CCU
+   */
+  tscType8 *getMemory ( tscType8 ccu ) {
+
+    std::vector<tscType8> &memory = memory_[ccu] ;
+    if (memory.empty()) memory.resize (MAXMEMORYBYTESADDRESS, 0) ;
+    return &memory[0] ;
+  }
+
+  /** The answers of the CCUs are delayed by a random time up to jitter ns so they arrive in any order
+   */
+  void setJitter ( unsigned long long jitter ) { jitter_ = jitter ; }
+
+  /** A CCU does not answer anymore
+   */
+  void setDeadCcu ( tscType8 ccu ) { deadCcu_.insert(ccu) ; }
+
+ protected:
+
+  /** Wait for the time of a bus access
+   */
+  void busAccess ( int blockWords ) {
+
+    unsigned long long end = getNanoSeconds() + FAKEBUSACCESS + blockWords * FAKEBUSBLOCKWORD ;
+    while (getNanoSeconds() < end) ;
+  }
+
+  /** Move the frames arrived in the FIFO receive
+   */
+  void update ( ) {
+
+    unsigned long long now = getNanoSeconds() ;
+    while (!ring_.empty() && (ring_.begin()->first <= now)) {
+      pushFrame (ring_.begin()->second) ;
+      ring_.erase (ring_.begin()) ;
+    }
+  }
+
+  /** Direct acknowledge and answer of the CCUs
+   */
+  void answerFrame ( std::vector<tscType8> &frame, bool first ) {
+
+    if (first) sendTime_ = getNanoSeconds() ;
+    unsigned int size = frame.size() ;
+
+    tscType8 ccu = frame[0] ;
+    if (deadCcu_.find(ccu) != deadCcu_.end()) return ;
+
+    // Direct acknowledge
+    frame.push_back (FECACKNOERROR32) ;
+    unsigned long long arrival = transfer (frame, sendTime_) ;
+
+    // Answer
+    unsigned int pos = (frame[2] & FEC_LENGTH_2BYTES) ? 4 : 3 ;
+    tscType8 channel = frame[pos], tnum = frame[pos+1], command = frame[pos+2] ;
+    std::vector<tscType8> answer ;
+    answer.push_back (FRAMEFECNUMBER) ; answer.push_back (ccu) ;
+
+    if ((channel == 0) && (command == CMD_CCUREADCRE)) {
+      tscType8 data[] = { 5, 0, tnum, 0, 0, 0 } ;
+      answer.insert (answer.end(), data, data + sizeof(data)) ;
+    }
+    else if (command == CMD_CHANNELMEMMULTIPLEBYTEWRITE) {
+      unsigned int address = (frame[pos+3] << 8) | frame[pos+4] ;
+      for (unsigned int i = pos+5 ; i < size ; i ++) getMemory(ccu)[(address++) & 0xFFFF] = frame[i] ;
+      return ;
+    }
+    else if (command == CMD_CHANNELMEMMULTIPLEBYTEREAD) {
+      unsigned int address = (frame[pos+3] << 8) | frame[pos+4] ;
+      unsigned int length = frame[pos+5] ;
+      if (length & FEC_LENGTH_2BYTES) length = ((length & 0x7F) << 8) | frame[pos+6] ;
+#ifdef BUGMEMORY2BYTES
+      length -= 2 ; // Memory bus channel error, lenh-lenl has to be increased by 2
+#endif
+      if (length + 2 > FEC_UPPERLIMIT_LENGTH) {
+	answer.push_back (FEC_LENGTH_2BYTES | ((length + 2) >> 8)) ;
+	answer.push_back ((length + 2) & 0xFF) ;
+      }
+      else answer.push_back (length + 2) ;
+      answer.push_back (channel) ; answer.push_back (tnum) ;
+      for (unsigned int i = 0 ; i < length ; i ++) answer.push_back (getMemory(ccu)[(address++) & 0xFFFF]) ;
+    }
+    else return ;
+
+    answer.push_back (FECACKNOERROR32) ;
+    transfer (answer, arrival) ;
+  }
+
+ private:
+
+  /** Frame on the ring: arrival time in the FIFO receive and frame (with the status)
+   */
+  typedef std::multimap<unsigned long long, std::vector<tscType8> > ringFramesType ;
+
+  /** Put a frame on the ring, one frame at a time
+   * \return time when the frame arrives in the FIFO receive
+   */
+  unsigned long long transfer ( std::vector<tscType8> frame, unsigned long long start ) {
+
+    if (ringFree_ < start) ringFree_ = start ;
+    ringFree_ += frame.size() * FAKERINGBYTE ;
+    unsigned long long arrival = ringFree_ + latency_ ;
+    if (jitter_ && (frame[0] == FRAMEFECNUMBER)) arrival += rand() % jitter_ ;
+    ring_.insert (std::make_pair(arrival, frame)) ;
+    return arrival ;
+  }
+
+  unsigned long long latency_, jitter_, sendTime_ ;
+  ringFramesType ring_ ;
+  unsigned long long ringFree_ ;
+  std::map<tscType8, std::vector<tscType8> > memory_ ;
+  std::set<tscType8> deadCcu_ ;
+} ;
+
+/** Build a segment
+ */
+static memoryAccessType buildSegment ( keyType index, enumAccessModeType accessType, unsigned int address, unsigned long size, tscType8 *values ) {
+
+  memoryAccessType segment = { index, accessType, (tscType8)(address >> 8), (tscType8)(address & 0xFF), size, values, NULL } ;
+  return segment ;
+}
+
+/** Count and delete the errors of the segments
+ */
+static unsigned int getErrors ( std::list<memoryAccessType> &segments, bool display ) {
+
+  unsigned int error = 0 ;
+  for (std::list<memoryAccessType>::iterator it = segments.begin() ; it != segments.end() ; it ++) {
+    if (it->e != NULL) {
+      if (display) std::cerr << "ERROR: " << it->e->what() << std::endl ;
+      delete it->e ;
+      it->e = NULL ;
+      error ++ ;
+    }
+  }
+  return error ;
+}
+
+/** Scatter write and gather read of segments of several sizes on two CCUs
+ */
+static int checkScatterGather ( FecMemoryRingDevice &ring, tscType8 fecSlot, unsigned int maximumTransactions, unsigned long long jitter ) {
+
+  int error = 0 ;
+  ring.setJitter (jitter) ;
+
+  keyType index[2] = { buildCompleteKey(fecSlot, 0, 0x10, 0x40, 0), buildCompleteKey(fecSlot, 0, 0x11, 0x40, 0) } ;
+  unsigned long sizes[] = { 1, 100, 122, 123, 188, 189, 775, 776, 5000 } ;
+  unsigned int nSizes = sizeof(sizes) / sizeof(unsigned long) ;
+
+  std::vector< std::vector<tscType8> > written, read ;
+  std::list<memoryAccessType> writes, reads ;
+  unsigned int address = 0x0100 ;
+  for (unsigned int i = 0 ; i < nSizes ; i ++) {
+    written.push_back (std::vector<tscType8>(sizes[i])) ;
+    read.push_back (std::vector<tscType8>(sizes[i], 0)) ;
+    for (unsigned long j = 0 ; j < sizes[i] ; j ++) written[i][j] = rand() & 0xFF ;
+  }
+  for (unsigned int i = 0 ; i < nSizes ; i ++) {
+    writes.push_back (buildSegment(index[i%2], MODE_WRITE, address, sizes[i], &written[i][0])) ;
+    reads.push_front (buildSegment(index[i%2], MODE_READ, address, sizes[i], &read[i][0])) ;
+    address += sizes[i] + 0x10 ;
+  }
+
+  ring.setBlockMemory (writes, maximumTransactions) ;
+  error += getErrors (writes, true) ;
+  ring.setBlockMemory (reads, maximumTransactions) ;
+  error += getErrors (reads, true) ;
+
+  for (unsigned int i = 0 ; i < nSizes ; i ++) {
+    if (written[i] != read[i]) {
+      std::cerr << "ERROR: segment of " << sizes[i] << " bytes read back is different with " << maximumTransactions << " transactions in flight" << std::endl ;
+      error ++ ;
+    }
+  }
+
+  // The old methods see the same memory
+  tscType8 *memory = ring.getMemory(0x11) ;
+  if (memcmp (memory + 0x0100 + sizes[0] + 0x10, &written[1][0], sizes[1])) {
+    std::cerr << "ERROR: segment not written at the right position in the memory" << std::endl ;
+    error ++ ;
+  }
+  std::vector<tscType8> values (sizes[8]) ;
+  address = 0x0100 ;
+  for (unsigned int i = 0 ; i < 8 ; i ++) address += sizes[i] + 0x10 ;
+  ring.readFromMemory (index[0], address >> 8, address & 0xFF, sizes[8], &values[0]) ;
+  if (values != written[8]) {
+    std::cerr << "ERROR: segment read with readFromMemory is different" << std::endl ;
+    error ++ ;
+  }
+
+  ring.setJitter (0) ;
+  return error ;
+}
+
+/** Segments out of the memory and CCU without answer
+ */
+static int checkErrors ( FecMemoryRingDevice &ring, tscType8 fecSlot ) {
+
+  int error = 0 ;
+  keyType index = buildCompleteKey(fecSlot, 0, 0x12, 0x40, 0) ;
+  keyType indexDead = buildCompleteKey(fecSlot, 0, 0x13, 0x40, 0) ;
+  tscType8 values[1000] ;
+  for (unsigned int i = 0 ; i < 1000 ; i ++) values[i] = i & 0xFF ;
+
+  // Connect the CCU before it does not answer anymore
+  std::list<memoryAccessType> segments ;
+  segments.push_back (buildSegment(indexDead, MODE_WRITE, 0, 10, values)) ;
+  ring.setBlockMemory (segments) ;
+  error += getErrors (segments, true) ;
+  ring.setDeadCcu (0x13) ;
+
+  unsigned long loopInTimeReadFrame = ring.getLoopInTimeReadFrame() ;
+  ring.setLoopInTimeReadFrame (2000) ;
+
+  segments.clear() ;
+  segments.push_back (buildSegment(index, MODE_WRITE, 0xFF00, 1000, values)) ;   // out of the memory
+  segments.push_back (buildSegment(indexDead, MODE_WRITE, 0x0000, 1000, values)) ;
+  segments.push_back (buildSegment(index, MODE_WRITE, 0x1000, 1000, values)) ;
+  ring.setBlockMemory (segments) ;
+
+  std::list<memoryAccessType>::iterator it = segments.begin() ;
+  if (it->e == NULL) { std::cerr << "ERROR: no error for a segment out of the memory" << std::endl ; error ++ ; }
+  it ++ ;
+  if (it->e == NULL) { std::cerr << "ERROR: no error for a CCU without answer" << std::endl ; error ++ ; }
+  it ++ ;
+  if (it->e != NULL) { std::cerr << "ERROR: " << it->e->what() << std::endl ; error ++ ; }
+  if (memcmp (ring.getMemory(0x12) + 0x1000, values, 1000)) { std::cerr << "ERROR: segment not written after the errors" << std::endl ; error ++ ; }
+  getErrors (segments, false) ;
+
+  // CCU which cannot be connected: the exception is raised before any error is set in the segments
+  keyType indexLost = buildCompleteKey(fecSlot, 0, 0x14, 0x40, 0) ;
+  ring.setDeadCcu (0x14) ;
+  segments.clear() ;
+  segments.push_back (buildSegment(index, MODE_WRITE, 0xFF00, 1000, values)) ;   // out of the memory
+  segments.push_back (buildSegment(indexLost, MODE_WRITE, 0x0000, 10, values)) ;
+  try {
+    ring.setBlockMemory (segments) ;
+    std::cerr << "ERROR: no exception for a CCU which cannot be connected" << std::endl ;
+    error ++ ;
+  }
+  catch (FecExceptionHandler &e) { }
+  if (segments.begin()->e != NULL) {
+    std::cerr << "ERROR: error set in a segment before the exception" << std::endl ;
+    error ++ ;
+  }
+  getErrors (segments, false) ;
+
+  ring.setLoopInTimeReadFrame (loopInTimeReadFrame) ;
+  return error ;
+}
+
+/** Display the usage
+ */
+static void help ( char *program ) {
+
+  std::cout << program << " [-size <bytes>] [-latency <us>] [-help]" << std::endl ;
+  std::cout << "\t-size <bytes>: size of the transfer for the benchmark (default 16384)" << std::endl ;
+  std::cout << "\t-latency <us>: latency of the ring (default 20 us)" << std::endl ;
+}
+
+/**
+ * Check the block memory transfers (setBlockMemory) on a fake ring and compare the throughput
+ * with the old methods (writeIntoMemory / readFromMemory) that wait for each frame.
+ */
+int main ( int argc, char **argv ) {
+
+  unsigned long size = 16384 ;
+  unsigned long latency = 20 ;
+  for (int i = 1 ; i < argc ; i ++) {
+    if (!strcmp(argv[i], "-size") && (i+1 < argc)) size = atol(argv[++i]) ;
+    else if (!strcmp(argv[i], "-latency") && (i+1 < argc)) latency = atol(argv[++i]) ;
+    else {
+      help (argv[0]) ;
+      return 0 ;
+    }
+  }
+  if (size == 0 || size >= MAXMEMORYBYTESADDRESS) size = 16384 ;
+
+  tscType8 fecSlot = 5 ;
+  FecMemoryRingDevice ring (fecSlot, 0, latency * 1000) ;
+  srand (1) ;
+
+  int error = 0 ;
+  try {
+    error += checkScatterGather (ring, fecSlot, 1, 0) ;
+    error += checkScatterGather (ring, fecSlot, MAXMEMORYTRANSACTIONS, 0) ;
+    error += checkScatterGather (ring, fecSlot, MAXMEMORYTRANSACTIONS, 100000) ;
+    error += checkErrors (ring, fecSlot) ;
+
+    // -------------------------------------------------------------------------
+    // Benchmark
+    keyType index = buildCompleteKey(fecSlot, 0, 0x10, 0x40, 0) ;
+    std::vector<tscType8> values (size), valuesRead (size) ;
+    for (unsigned long i = 0 ; i < size ; i ++) values[i] = rand() & 0xFF ;
+
+    std::cout << "Transfer of " << size << " bytes, ring latency " << latency << " us" << std::endl ;
+    std::cout << std::setw(34) << std::left << "Method" << std::setw(16) << "write (kB/s)" << std::setw(16) << "read (kB/s)" << "frames" << std::endl ;
+
+    double oldRead = 0, newRead = 0 ;
+    for (unsigned int transactions = 0 ; transactions <= MAXMEMORYTRANSACTIONS ; transactions = transactions ? transactions * 2 : 1) {
+
+      unsigned long frames = ring.getNumberOfFrames() ;
+      memset (&valuesRead[0], 0, size) ;
+      unsigned long long start = getNanoSeconds() ;
+      if (transactions == 0) ring.writeIntoMemory (index, 0, 0, &values[0], size) ;
+      else {
+	std::list<memoryAccessType> segments ;
+	segments.push_back (buildSegment(index, MODE_WRITE, 0, size, &values[0])) ;
+	ring.setBlockMemory (segments, transactions) ;
+	error += getErrors (segments, true) ;
+      }
+      unsigned long long middle = getNanoSeconds() ;
+      if (transactions == 0) ring.readFromMemory (index, 0, 0, size, &valuesRead[0]) ;
+      else {
+	std::list<memoryAccessType> segments ;
+	segments.push_back (buildSegment(index, MODE_READ, 0, size, &valuesRead[0])) ;
+	ring.setBlockMemory (segments, transactions) ;
+	error += getErrors (segments, true) ;
+      }
+      unsigned long long end = getNanoSeconds() ;
+
+      if (values != valuesRead) {
+	std::cerr << "ERROR: values read are different with " << transactions << " transactions in flight" << std::endl ;
+	error ++ ;
+      }
+
+      double writeRate = size * 1e6 / (middle - start), readRate = size * 1e6 / (end - middle) ;
+      std::ostringstream method ;
+      if (transactions == 0) method << "writeIntoMemory/readFromMemory" ;
+      else method << "setBlockMemory (" << transactions << ")" ;
+      std::cout << std::setw(34) << method.str() << std::setw(16) << std::fixed << std::setprecision(0) << writeRate
+		<< std::setw(16) << readRate << ring.getNumberOfFrames() - frames << std::endl ;
+
+      if (transactions == 0) oldRead = readRate ;
+      if (transactions == MAXMEMORYTRANSACTIONS) newRead = readRate ;
+    }
+
+    // The reads wait for each answer in the old method so they must be faster with several frames in flight
+    if (newRead <= oldRead) {
+      std::cerr << "ERROR: the block memory read is not faster than the frame by frame read" << std::endl ;
+      error ++ ;
+    }
+  }
+  catch (FecExceptionHandler &e) {
+    std::cerr << "ERROR: " << e.what() << std::endl ;
+    error ++ ;
+  }
+
+  if (error) std::cerr << error << " error(s)" << std::endl ;
+  else std::cout << "All tests passed" << std::endl ;
+
+  return error ? -1 : 0 ;
+}
@@ -0,0 +1,253 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <iostream>
+#include <map>
+#include <vector>
+
+#include "keyType.h"
+#include "vfatDefinition.h"
+#include "VfatScanEngine.h"
+
+/** Number of triggers per step of the simulated threshold scan
+ */
+#define TRIGGERS 100
+
+/**
+ * Fake FEC: the registers of each VFAT are kept, the extended registers through the pointer.
+ * A number of blocks can be refused for a chip to test the retries.
+ */
+class FakeVfatWriter: public VfatScanWriter {
+
+public:
+
+  FakeVfatWriter ( ): calls_(0), rings_(0) { }
+
+  unsigned int setBlockDevices ( accessDeviceTypeListMap &vAccess, std::list<FecExceptionHandler *> &errorList ) {
+
+    unsigned int error = 0 ;
+    calls_ ++ ;
+    rings_ = vAccess.size() ;
+
+    for (accessDeviceTypeListMap::iterator itList = vAccess.begin() ; itList != vAccess.end() ; itList ++) {
+      for (accessDeviceTypeList::iterator it = itList->second.begin() ; it != itList->second.end() ; it ++) {
+
+	if (getFecRingKey(it->index) != itList->first) {
+	  std::cerr << "ERROR: access of the chip 0x" << std::hex << it->index << " in the list of the ring 0x" << itList->first << std::dec << std::endl ;
+	  wrongRing_ ++ ;
+	}
+
+	if (failures_[it->index] > 0) {
+	  failures_[it->index] -- ;
+	  it->e = NEWFECEXCEPTIONHANDLER ( TSCFEC_INVALIDOPERATION, "simulated error on the VFAT", ERRORCODE ) ;
+	  errorList.push_back (it->e) ;
+	  error ++ ;
+	  continue ;
+	}
+
+	std::vector<unsigned int> &regs = registers_[it->index] ;
+	if (regs.empty()) regs.resize (0x10 + 0x100, 0) ;
+	if (it->offset == VFAT_EXTREGDATA) regs[0x10 + regs[VFAT_EXTREGPOINTER]] = it->data ;
+	else regs[it->offset] = it->data ;
+	it->sent = true ;
+      }
+    }
+
+    return error ;
+  }
+
+  /** Principal register or extended register (address + 0x10)
+   */
+  unsigned int getRegister ( keyType key, unsigned int address ) {
+    std::vector<unsigned int> &regs = registers_[key] ;
+    return regs.empty() ? 0 : regs[address] ;
+  }
+  unsigned int getExtended ( keyType key, unsigned int address ) { return getRegister (key, 0x10 + address) ; }
+
+  std::map<keyType, std::vector<unsigned int> > registers_ ;
+  std::map<keyType, unsigned int> failures_ ;
+  unsigned int calls_ ;
+  unsigned int rings_ ;
+  static unsigned int wrongRing_ ;
+} ;
+
+unsigned int FakeVfatWriter::wrongRing_ = 0 ;
+
+/**
+ * Simulated threshold scan: each channel of a chip has an S-curve centred on a threshold
+ * depending on the chip and on the channel, the hits are computed from the VThreshold1 of the chip.
+ */
+class SCurveMeasurement: public VfatScanMeasurement {
+
+public:
+
+  SCurveMeasurement ( FakeVfatWriter &writer, unsigned int stopAfter = 0 ): writer_(writer), stopAfter_(stopAfter), calls_(0) { }
+
+  static double getMean ( unsigned int chip, unsigned int channel ) { return 60.0 + 20.0 * chip + (channel % 16) ; }
+
+  void measure ( const VfatScanDefinition &scan, unsigned int step, VfatScanResult &result ) {
+
+    calls_ ++ ;
+    for (unsigned int chip = 0 ; chip < scan.getChips().size() ; chip ++) {
+      double threshold = writer_.getExtended (scan.getChips()[chip], VFAT_VTHRESHOLD1) ;
+      unsigned int *row = result.getRow (step, chip) ;
+      for (unsigned int channel = 0 ; channel < scan.getChannels() ; channel ++) {
+	double sigma = 3.0 ;
+	row[channel] = (unsigned int)(TRIGGERS * 0.5 * erfc ((threshold - getMean (chip, channel)) / (sqrt(2.0) * sigma)) + 0.5) ;
+      }
+    }
+  }
+
+  bool stepDone ( unsigned int step, unsigned int steps ) {
+    return (stopAfter_ == 0) || (step + 1 < stopAfter_) ;
+  }
+
+private:
+
+  FakeVfatWriter &writer_ ;
+  unsigned int stopAfter_ ;
+
+public:
+
+  unsigned int calls_ ;
+} ;
+
+/** Check a value
+ */
+static int check ( const char *name, double value, double expected, double tolerance = 0 ) {
+
+  if (fabs (value - expected) > tolerance) {
+    std::cerr << "ERROR: " << name << ": " << value << " instead of " << expected << std::endl ;
+    return 1 ;
+  }
+  return 0 ;
+}
+
+/** Test of the VFAT scan engine on simulated chips
+ */
+int main ( int argc, char *argv[] ) {
+
+  int error = 0 ;
+
+  // Four chips on two rings
+  std::vector<keyType> keys ;
+  keys.push_back (buildCompleteKey(1,0,0x10,0x10,0x18)) ;
+  keys.push_back (buildCompleteKey(1,0,0x10,0x10,0x19)) ;
+  keys.push_back (buildCompleteKey(1,0,0x11,0x11,0x18)) ;
+  keys.push_back (buildCompleteKey(1,1,0x10,0x10,0x18)) ;
+
+  try {
+    // Threshold scan from 0 to 255 with the settings
+    VfatScanDefinition scan (VFATSCAN_VTHRESHOLD1, 0, 255, 1, 128) ;
+    for (unsigned int i = 0 ; i < keys.size() ; i ++) scan.addChip (keys[i]) ;
+    scan.addSetting (VFATSCAN_VTHRESHOLD2, 0) ;
+    scan.addSetting (VFATSCAN_IPREAMPIN, 168) ;
+    scan.setRestoreValue (25) ;
+
+    FakeVfatWriter writer ;
+    SCurveMeasurement measurement (writer) ;
+    VfatScanEngine engine (writer) ;
+    VfatScanResult result ;
+
+    unsigned int errors = engine.run (scan, measurement, result) ;
+    error += check ("errors", errors, 0) ;
+    error += check ("steps", result.getSteps(), 256) ;
+    error += check ("steps done", result.getStepsDone(), 256) ;
+    error += check ("measurements", measurement.calls_, 256) ;
+    // 2 settings + 256 steps + the restore, one block each for all the rings
+    error += check ("blocks", writer.calls_, 2 + 256 + 1) ;
+    error += check ("blocks counted", engine.getBlocks(), 2 + 256 + 1) ;
+    error += check ("rings per block", writer.rings_, 2) ;
+    // Extended registers are 2 frames, principal registers 1 frame
+    error += check ("frames", engine.getFrames(), 4 * (2 + 1 + 256 * 2 + 2)) ;
+    error += check ("accesses in the right ring", FakeVfatWriter::wrongRing_, 0) ;
+
+    for (unsigned int chip = 0 ; chip < keys.size() ; chip ++) {
+      error += check ("VThreshold2", writer.getExtended (keys[chip], VFAT_VTHRESHOLD2), 0) ;
+      error += check ("IPreampIn", writer.getRegister (keys[chip], VFAT_IPREAMPIN), 168) ;
+      error += check ("VThreshold1 restored", writer.getExtended (keys[chip], VFAT_VTHRESHOLD1), 25) ;
+      for (unsigned int channel = 0 ; channel < 128 ; channel += 7) {
+	error += check ("threshold", result.getCrossing (chip, channel, TRIGGERS / 2), SCurveMeasurement::getMean (chip, channel), 1.0) ;
+      }
+    }
+    error += check ("first step", result.get (0, 0, 0), TRIGGERS) ;
+    error += check ("last step", result.get (255, 3, 127), 0) ;
+
+    // Inverted scan by 4 with a chip failing 2 times at the first step and a chip never written
+    VfatScanDefinition inverted (VFATSCAN_VTHRESHOLD1, 200, 0, 4, 128) ;
+    for (unsigned int i = 0 ; i < keys.size() ; i ++) inverted.addChip (keys[i]) ;
+    inverted.setRetries (3) ;
+
+    FakeVfatWriter faulty ;
+    faulty.failures_[keys[1]] = 2 ;
+    faulty.failures_[keys[2]] = 1000000 ;
+    SCurveMeasurement faultyMeasurement (faulty) ;
+    VfatScanEngine faultyEngine (faulty) ;
+    VfatScanResult faultyResult ;
+
+    errors = faultyEngine.run (inverted, faultyMeasurement, faultyResult) ;
+    error += check ("inverted steps", faultyResult.getSteps(), 51) ;
+    error += check ("inverted first value", faultyResult.getValue(0), 200) ;
+    error += check ("inverted last value", faultyResult.getValue(50), 0) ;
+    error += check ("errors of the chip never written", errors, 51) ;
+    error += check ("chip written after retries", faultyResult.isError (0, 1), false) ;
+    error += check ("chip never written", faultyResult.isError (10, 2), true) ;
+    error += check ("values of the chip in error", faultyResult.get (10, 2, 5), 0) ;
+    // first step: 1 block, 2 retries for the chip 1 (chip 2 is retried with it), then 3 blocks per step for the chip 2
+    error += check ("blocks with retries", faulty.calls_, 51 * 3) ;
+    error += check ("inverted threshold", faultyResult.getCrossing (0, 3, TRIGGERS / 2), SCurveMeasurement::getMean (0, 3), 2.0) ;
+    error += check ("no threshold for the chip in error", faultyResult.getCrossing (2, 3, TRIGGERS / 2), -1) ;
+
+    // Scan stopped by the measurement
+    FakeVfatWriter stopWriter ;
+    SCurveMeasurement stopMeasurement (stopWriter, 10) ;
+    VfatScanEngine stopEngine (stopWriter) ;
+    VfatScanResult stopResult ;
+    stopEngine.run (scan, stopMeasurement, stopResult) ;
+    error += check ("steps done when stopped", stopResult.getStepsDone(), 10) ;
+    error += check ("blocks when stopped", stopWriter.calls_, 2 + 10 + 1) ;
+
+    // Definitions refused
+    VfatScanDefinition noChip (VFATSCAN_VCAL) ;
+    VfatScanDefinition noStep (VFATSCAN_VCAL, 0, 255, 0) ;
+    noStep.addChip (keys[0]) ;
+    VfatScanDefinition outOfRange (VFATSCAN_LATENCY, 0, 300) ;
+    outOfRange.addChip (keys[0]) ;
+    VfatScanDefinition *refused[] = { &noChip, &noStep, &outOfRange } ;
+    for (unsigned int i = 0 ; i < 3 ; i ++) {
+      try {
+	stopEngine.run (*refused[i], stopMeasurement, stopResult) ;
+	std::cerr << "ERROR: scan definition " << i << " accepted" << std::endl ;
+	error ++ ;
+      }
+      catch (FecExceptionHandler &e) { }
+    }
+  }
+  catch (FecExceptionHandler &e) {
+    std::cerr << "ERROR: " << e.what() << std::endl ;
+    error ++ ;
+  }
+
+  if (error) std::cerr << error << " error(s)" << std::endl ;
+  else std::cout << "All tests passed" << std::endl ;
+
+  return error ? -1 : 0 ;
+}
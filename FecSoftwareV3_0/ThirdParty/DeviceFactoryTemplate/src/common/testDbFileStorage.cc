@@ -0,0 +1,379 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <sstream>
+
+#include "DbFileStorage.h"
+#include "FecFactory.h"
+#include "FecDeviceDiff.h"
+#include "ConnectionFactory.h"
+#include "TkDcuInfoFactory.h"
+#include "TestTime.h"
+
+/** Check a value
+ */
+static int check ( const char *name, unsigned long value, unsigned long expected ) {
+
+  if (value != expected) {
+    std::cerr << "ERROR: " << name << ": " << value << " instead of " << expected << std::endl ;
+    return 1 ;
+  }
+  return 0 ;
+}
+
+/** Check a version
+ */
+static int check ( const char *name, DbStorageVersion version, unsigned int major, unsigned int minor ) {
+
+  if ((version.first != major) || (version.second != minor)) {
+    std::cerr << "ERROR: " << name << ": version " << version.first << "." << version.second << " instead of " << major << "." << minor << std::endl ;
+    return 1 ;
+  }
+  return 0 ;
+}
+
+/** Records of devices: one APV per record, the value is used to check the version
+ */
+static DbStorageRecords getDevices ( unsigned int first, unsigned int number, unsigned int value ) {
+
+  DbStorageRecords records ;
+  for (unsigned int i = first ; i < first + number ; i ++) {
+    std::ostringstream id, xml ;
+    id << "0x" << std::hex << i ;
+    xml << "<APV25 key=\"" << id.str() << "\" ipre=\"" << std::dec << value << "\" />" << std::endl ;
+    records[id.str()] = xml.str() ;
+  }
+  return records ;
+}
+
+/** Devices of a FEC given to the factory: two APVs and a PLL per FEC
+ */
+static void buildDevices ( deviceVector &devices ) {
+
+  for (unsigned int fec = 1 ; fec <= 2 ; fec ++) {
+    std::string fecHardwareId = "FEC" + toString (fec) ;
+    for (unsigned int a = 0x20 ; a <= 0x21 ; a ++) {
+      apvDescription *apv = new apvDescription (buildCompleteKey(fec,0,1,0x10,a), 0x2B, 0x64, 0x4, 0x55, 0x34, 0x22, 0x22, 0x22,
+						0x22, 0x22, 0x1D, 0x0, 0x1E, 0x3C, 0x28, 0xFC, 0x1, 0x0) ;
+      apv->setFecHardwareId (fecHardwareId, 1) ;
+      devices.push_back (apv) ;
+    }
+    pllDescription *pll = new pllDescription (buildCompleteKey(fec,0,1,0x10,0x44), 6, 0, 0) ;
+    pll->setFecHardwareId (fecHardwareId, 1) ;
+    devices.push_back (pll) ;
+  }
+}
+
+/** Reader thread: download the version of the current state and check it is complete
+ */
+struct Reader {
+  DbFileStorage *storage ;
+  unsigned int devices ;
+  unsigned int loops ;
+  int error ;
+} ;
+
+static void *readDevices ( void *arg ) {
+
+  Reader *reader = (Reader *)arg ;
+  try {
+    for (unsigned int i = 0 ; i < reader->loops ; i ++) {
+      DbStorageRecords records = reader->storage->getRecords ("TI", DBSTORAGE_FEC, DbStorageVersion (1, 0), DbStorageVersion (0, 0)) ;
+      if (records.size() != reader->devices) reader->error ++ ;
+      reader->storage->getRecords ("TI", DBSTORAGE_FEC) ;
+    }
+  }
+  catch (FecExceptionHandler &e) {
+    std::cerr << "ERROR: " << e.what() << std::endl ;
+    reader->error ++ ;
+  }
+  return NULL ;
+}
+
+/** Test of the storage of the configuration in files: versions, masks, states and runs
+ */
+int main ( int argc, char *argv[] ) {
+
+  unsigned int nDevices = 20000 ;
+  if (argc > 1) nDevices = atoi(argv[1]) ;
+
+  char directory[] = "/tmp/testDbFileStorageXXXXXX" ;
+  if (mkdtemp (directory) == NULL) {
+    std::cerr << "ERROR: cannot create a temporary directory" << std::endl ;
+    return -1 ;
+  }
+
+  int error = 0 ;
+
+  try {
+    DbFileStorage storage (directory) ;
+
+    // Partitions
+    error += check ("first partition", storage.createPartition ("TI"), 1) ;
+    error += check ("second partition", storage.createPartition ("TEC"), 2) ;
+    error += check ("partition id", storage.getPartitionId ("TEC"), 2) ;
+    error += check ("partition name", storage.getPartitionName (1) == "TI", true) ;
+    error += check ("partitions", storage.getAllPartitionNames().size(), 2) ;
+    error += check ("partition created twice", storage.createPartition ("TI"), 1) ;
+    error += check ("partitions after a second creation", storage.getAllPartitionNames().size(), 2) ;
+    try {
+      storage.setRecords ("TI", DBSTORAGE_FEC, getDevices (0, 1, 0), false) ;
+      std::cerr << "ERROR: minor version without major version" << std::endl ;
+      error ++ ;
+    }
+    catch (FecExceptionHandler &e) { }
+
+    // Major version then a minor version changing two devices and adding one
+    unsigned long start = getMicroSeconds() ;
+    error += check ("major version", storage.setRecords ("TI", DBSTORAGE_FEC, getDevices (0, nDevices, 10), true), 1, 0) ;
+    unsigned long uploadTime = getMicroSeconds() - start ;
+    DbStorageRecords minor = getDevices (0, 2, 20) ;
+    DbStorageRecords added = getDevices (nDevices, 1, 20) ;
+    minor.insert (added.begin(), added.end()) ;
+    error += check ("minor version", storage.setRecords ("TI", DBSTORAGE_FEC, minor, false), 1, 1) ;
+    error += check ("second minor version", storage.setRecords ("TI", DBSTORAGE_FEC, getDevices (5, 1, 30), false), 1, 2) ;
+    error += check ("current version", storage.getVersion ("TI", DBSTORAGE_FEC), 1, 2) ;
+    error += check ("versions", storage.getVersions ("TI", DBSTORAGE_FEC).size(), 3) ;
+    error += check ("no version for the TEC", storage.getVersion ("TEC", DBSTORAGE_FEC), 0, 0) ;
+    error += check ("partitions in the current state", storage.getAllPartitionNamesFromCurrentState().size(), 1) ;
+
+    DbStorageRecords records = storage.getRecords ("TI", DBSTORAGE_FEC, DbStorageVersion (1, 1), DbStorageVersion (0, 0)) ;
+    error += check ("devices of 1.1", records.size(), nDevices + 1) ;
+    error += check ("device changed in 1.1", records["0x1"] == getDevices (1, 1, 20)["0x1"], true) ;
+    error += check ("device not changed in 1.1", records["0x5"] == getDevices (5, 1, 10)["0x5"], true) ;
+    records = storage.getRecords ("TI", DBSTORAGE_FEC) ;
+    error += check ("device changed in 1.2", records["0x5"] == getDevices (5, 1, 30)["0x5"], true) ;
+    records = storage.getRecords ("TI", DBSTORAGE_FEC, DbStorageVersion (1, 0), DbStorageVersion (0, 0)) ;
+    error += check ("devices of 1.0", records.size(), nDevices) ;
+    error += check ("device of 1.0", records["0x1"] == getDevices (1, 1, 10)["0x1"], true) ;
+
+    // Mask of two devices
+    DbStorageRecords mask ;
+    mask["0x3"] = "" ;
+    mask["0x4"] = "" ;
+    error += check ("mask version", storage.setRecords ("TI", DBSTORAGE_MASK, mask, true), 1, 0) ;
+    records = storage.getRecords ("TI", DBSTORAGE_FEC) ;
+    error += check ("devices masked", records.size(), nDevices + 1 - 2) ;
+    error += check ("device masked", records.count("0x3"), 0) ;
+    std::string buffer = DbStorage::getXMLBuffer (getDevices (0, 2, 1), "<ROWSET>", "</ROWSET>") ;
+    error += check ("XML buffer", buffer == "<ROWSET><APV25 key=\"0x0\" ipre=\"1\" />\n<APV25 key=\"0x1\" ipre=\"1\" />\n</ROWSET>", true) ;
+
+    // States
+    unsigned int reference = storage.createStateHistory ("reference") ;
+    error += check ("named state", storage.getStateHistoryId ("reference"), reference) ;
+    error += check ("current state", storage.getCurrentStateHistoryId(), reference) ;
+    storage.setRecords ("TI", DBSTORAGE_FEC, getDevices (0, nDevices, 40), true) ;
+    storage.setRecords ("TEC", DBSTORAGE_CONNECTION, getDevices (0, 10, 1), true) ;
+    unsigned int later = storage.getCurrentStateHistoryId() ;
+    error += check ("version after the reference", storage.getVersion ("TI", DBSTORAGE_FEC), 2, 0) ;
+    error += check ("version in the reference", storage.getVersion (reference, "TI", DBSTORAGE_FEC), 1, 2) ;
+    storage.setCurrentState ("TI", reference) ;
+    error += check ("partition set from the reference", storage.getVersion ("TI", DBSTORAGE_FEC), 1, 2) ;
+    error += check ("other partition not changed", storage.getVersion ("TEC", DBSTORAGE_CONNECTION), 1, 0) ;
+    storage.setCurrentState (reference) ;
+    error += check ("state set back", storage.getVersion ("TEC", DBSTORAGE_CONNECTION), 0, 0) ;
+    error += check ("state names", storage.getAllStateHistoryNames().size(), 1) ;
+
+    // Runs
+    storage.setCurrentState (later) ;
+    storage.setRun ("TI", 100, 1, 0, "physics") ;
+    storage.setCurrentState (reference) ;
+    storage.setRun ("TEC", 101, 2, 1, "") ;
+    error += check ("current run", storage.getCurrentRunNumber(), 101) ;
+    error += check ("state of the run", storage.getRunStateHistoryId (100), later) ;
+    error += check ("partitions of the run", storage.getAllPartitionNames (100).front() == "TI", true) ;
+    storage.stopRun ("TI", "stopped") ;
+    try {
+      storage.stopRun ("TI", "") ;
+      std::cerr << "ERROR: run stopped twice" << std::endl ;
+      error ++ ;
+    }
+    catch (FecExceptionHandler &e) { }
+    storage.copyStateForRunNumber (100, false) ;
+    error += check ("partition of the run", storage.getVersion ("TI", DBSTORAGE_FEC), 2, 0) ;
+    error += check ("other partition with the run", storage.getVersion ("TEC", DBSTORAGE_CONNECTION), 0, 0) ;
+    storage.copyStateForRunNumber (100, true) ;
+    error += check ("all partitions of the run", storage.getVersion ("TEC", DBSTORAGE_CONNECTION), 1, 0) ;
+
+    // Another access (process) sees the changes, the storage is read again after a change
+    DbFileStorage other (directory) ;
+    error += check ("state seen by another access", other.getCurrentStateHistoryId(), storage.getCurrentStateHistoryId()) ;
+    error += check ("run seen by another access", other.getRunStateHistoryId (101), reference) ;
+    other.createPartition ("TOB") ;
+    error += check ("partition created by another access", storage.getPartitionId ("TOB"), 3) ;
+
+    // Processes creating the same partition at the same time get the same identifier
+    const unsigned int nProcesses = 4 ;
+    pid_t pids[nProcesses] ;
+    for (unsigned int i = 0 ; i < nProcesses ; i ++) {
+      pids[i] = fork() ;
+      if (pids[i] == 0) {
+	try {
+	  DbFileStorage child (directory) ;
+	  _exit (child.createPartition ("TIB")) ;
+	}
+	catch (FecExceptionHandler &e) {
+	  _exit (0) ;
+	}
+      }
+    }
+    for (unsigned int i = 0 ; i < nProcesses ; i ++) {
+      int status = 0 ;
+      waitpid (pids[i], &status, 0) ;
+      error += check ("partition created by several processes", WIFEXITED(status) ? WEXITSTATUS(status) : 0, 4) ;
+    }
+    error += check ("partitions created by several processes", storage.getAllPartitionNames().size(), 4) ;
+
+    // Concurrent readers, the version files are read once
+    storage.setCurrentState (reference) ;
+    unsigned long filesRead = storage.getFilesRead() ;
+    const unsigned int nThreads = 4 ;
+    pthread_t threads[nThreads] ;
+    Reader readers[nThreads] ;
+    start = getMicroSeconds() ;
+    for (unsigned int i = 0 ; i < nThreads ; i ++) {
+      readers[i].storage = &storage ;
+      readers[i].devices = nDevices ;
+      readers[i].loops = 5 ;
+      readers[i].error = 0 ;
+      pthread_create (&threads[i], NULL, readDevices, &readers[i]) ;
+    }
+    for (unsigned int i = 0 ; i < nThreads ; i ++) {
+      pthread_join (threads[i], NULL) ;
+      error += check ("concurrent reader", readers[i].error, 0) ;
+    }
+    unsigned long readTime = getMicroSeconds() - start ;
+    error += check ("version files read", storage.getFilesRead(), filesRead) ;
+
+    // Download from the disk of a new access
+    DbFileStorage cold (directory) ;
+    start = getMicroSeconds() ;
+    records = cold.getRecords ("TI", DBSTORAGE_FEC, DbStorageVersion (2, 0), DbStorageVersion (0, 0)) ;
+    unsigned long downloadTime = getMicroSeconds() - start ;
+    error += check ("devices downloaded", records.size(), nDevices) ;
+
+    // Empty versions are kept in memory too
+    cold.setRecords ("TOB", DBSTORAGE_CONNECTION, getDevices (0, 1, 1), true) ;
+    cold.setRecords ("TOB", DBSTORAGE_CONNECTION, DbStorageRecords(), false) ;
+    filesRead = cold.getFilesRead() ;
+    cold.getRecords ("TOB", DBSTORAGE_CONNECTION) ;
+    cold.getRecords ("TOB", DBSTORAGE_CONNECTION) ;
+    error += check ("empty version read once", cold.getFilesRead(), filesRead + 2) ;
+
+    // The cache is limited, a version dropped is read again
+    DbFileStorage small (directory, 1) ;
+    small.getRecords ("TOB", DBSTORAGE_CONNECTION) ;
+    error += check ("versions in a limited cache", small.getCachedVersions(), 1) ;
+    small.getRecords ("TOB", DBSTORAGE_CONNECTION) ;
+    error += check ("versions read again", small.getFilesRead(), 4) ;
+
+    // Devices of a FEC factory through the storage, the partition is created by the first upload
+    FecDeviceFactory fecFactory ;
+    fecFactory.setStorageAccess (&storage) ;
+    deviceVector devices, downloaded ;
+    buildDevices (devices) ;
+    unsigned int versionMajor = 0, versionMinor = 0 ;
+    fecFactory.setFecDeviceDescriptions (devices, "TID", &versionMajor, &versionMinor, true) ;
+    error += check ("factory major version", DbStorageVersion (versionMajor, versionMinor), 1, 0) ;
+    fecFactory.getFecDeviceDescriptions ("TID", downloaded) ;
+    error += check ("devices downloaded by the factory", FecDeviceDiff (devices, downloaded).empty(), true) ;
+    fecFactory.getFecDeviceDescriptions ("TID", "FEC2", downloaded) ;
+    error += check ("devices of a FEC", downloaded.size(), 3) ;
+
+    // No version for the same devices, a minor version for a device changed
+    fecFactory.setSkipUnchangedUpload (true) ;
+    fecFactory.setFecDeviceDescriptions (devices, "TID", &versionMajor, &versionMinor, false) ;
+    error += check ("unchanged devices", DbStorageVersion (versionMajor, versionMinor), 1, 0) ;
+    apvDescription *apv = (apvDescription *)devices[0] ;
+    apv->setIpre (apv->getIpre() + 1) ;
+    fecFactory.setFecDeviceDescriptions (deviceVector (1, apv), "TID", &versionMajor, &versionMinor, false) ;
+    error += check ("factory minor version", DbStorageVersion (versionMajor, versionMinor), 1, 1) ;
+    fecFactory.getFecDeviceDescriptions ("TID", downloaded) ;
+    error += check ("device changed by the factory", FecDeviceDiff (devices, downloaded).empty(), true) ;
+    fecFactory.getFecDeviceDescriptions ("TID", downloaded, 1, 0) ;
+    error += check ("device of the factory in 1.0", FecDeviceDiff (devices, downloaded).getNumberOfModified(), 1) ;
+
+    // Mask of a device of the factory
+    std::ostringstream maskedId ;
+    maskedId << devices[5]->getFecHardwareId() << " 0x" << std::hex << devices[5]->getKey() ;
+    DbStorageRecords deviceMask ;
+    deviceMask[maskedId.str()] = "" ;
+    storage.setRecords ("TID", DBSTORAGE_MASK, deviceMask, true) ;
+    fecFactory.getFecDeviceDescriptions ("TID", downloaded) ;
+    error += check ("device masked for the factory", downloaded.size(), devices.size() - 1) ;
+    FecFactory::deleteVectorI (devices) ;
+
+    // Connections of a partition through the storage, a minor version changes a FED channel
+    ConnectionFactory connectionFactory ;
+    connectionFactory.setStorageAccess (&storage) ;
+    ConnectionVector connections, connectionsDownloaded ;
+    for (unsigned int channel = 0 ; channel < 4 ; channel ++)
+      connections.push_back (new ConnectionDescription (50, channel, "FEC1", 1, 2, 3, 0x10, 0x11, 0x20 + 2 * (channel % 2), 1000 + channel / 2)) ;
+    connectionFactory.setConnectionDescriptions (connections, "TID", &versionMajor, &versionMinor, true) ;
+    error += check ("connection major version", DbStorageVersion (versionMajor, versionMinor), 1, 0) ;
+    connections[3]->setEnabled (false) ;
+    connectionFactory.setConnectionDescriptions (ConnectionVector (1, connections[3]), "TID", &versionMajor, &versionMinor, false) ;
+    error += check ("connection minor version", DbStorageVersion (versionMajor, versionMinor), 1, 1) ;
+    connectionFactory.getConnectionDescriptions ("TID", connectionsDownloaded) ;
+    error += check ("connections enabled", connectionsDownloaded.size(), 3) ;
+    connectionFactory.getConnectionDescriptions ("TID", connectionsDownloaded, 1, 0, 0, 0, true) ;
+    error += check ("connections of 1.0", connectionsDownloaded.size(), 4) ;
+    error += check ("connection of 1.0", connectionsDownloaded[3]->isEnabled(), true) ;
+    ConnectionFactory::deleteVectorI (connections) ;
+
+    // DCU infos of a partition and without partition through the storage
+    TkDcuInfoFactory dcuInfoFactory ;
+    dcuInfoFactory.setStorageAccess (&storage) ;
+    tkDcuInfoVector dcuInfos ;
+    for (unsigned int dcuHardId = 1000 ; dcuHardId < 1002 ; dcuHardId ++)
+      dcuInfos.push_back (new TkDcuInfo (dcuHardId, 369000000 + dcuHardId, 10.5, 4)) ;
+    dcuInfoFactory.setTkDcuInfo (dcuInfos, "TID", &versionMajor, &versionMinor) ;
+    error += check ("DCU info major version", DbStorageVersion (versionMajor, versionMinor), 1, 0) ;
+    dcuInfoFactory.setTkDcuInfo (dcuInfos) ;
+    dcuInfoFactory.setTkDcuInfo (tkDcuInfoVector (1, dcuInfos[0])) ;
+    error += check ("DCU info without partition", storage.getVersion ("ALL", DBSTORAGE_DCUINFO), 1, 1) ;
+    dcuInfoFactory.addDetIdPartition ("TID") ;
+    error += check ("DCU infos downloaded", dcuInfoFactory.getInfos().size(), 2) ;
+    error += check ("DCU info downloaded", dcuInfoFactory.getTkDcuInfo (1001)->getDetId(), 369001001) ;
+    for (tkDcuInfoVector::iterator dcuInfo = dcuInfos.begin() ; dcuInfo != dcuInfos.end() ; dcuInfo ++) delete *dcuInfo ;
+
+    std::cout << nDevices << " devices:" << std::endl ;
+    std::cout << "  upload of a major version: " << uploadTime << " us" << std::endl ;
+    std::cout << "  download from the files  : " << downloadTime << " us" << std::endl ;
+    std::cout << "  " << nThreads << " x 5 x 2 downloads      : " << readTime << " us" << std::endl ;
+  }
+  catch (FecExceptionHandler &e) {
+    std::cerr << "ERROR: " << e.what() << std::endl ;
+    error ++ ;
+  }
+
+  std::string command = std::string("rm -rf ") + directory ;
+  if (system (command.c_str()) != 0) std::cerr << "Cannot remove " << directory << std::endl ;
+
+  if (error) std::cerr << error << " error(s)" << std::endl ;
+  else std::cout << "All tests passed" << std::endl ;
+
+  return error ? -1 : 0 ;
+}
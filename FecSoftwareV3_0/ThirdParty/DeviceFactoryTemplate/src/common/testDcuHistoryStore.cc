@@ -0,0 +1,212 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Copyright 2002 - 2003, Frederic DROUHIN - Universite de Haute-Alsace, Mulhouse-France
+*/
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "dcuDescription.h"
+#include "FecDeviceFactory.h"
+#include "DcuHistoryStore.h"
+#include "TestTime.h"
+
+/** Sort the DCUs by time
+ */
+static bool sortDcuByTime ( deviceDescription *d1, deviceDescription *d2 ) {
+
+  return ((dcuDescription *)d1)->getTimeStamp() < ((dcuDescription *)d2)->getTimeStamp() ;
+}
+
+/** Synthetic readout: slow drift of the temperatures and of the voltages with a noise of one count, a step on
+ * the channel 0 of one DCU out of 100
+ */
+static void buildReadout ( deviceVector &dcus, unsigned int nDcus, unsigned int readout, tscType32 timeStamp ) {
+
+  for (unsigned int d = 0 ; d < nDcus ; d ++) {
+    tscType16 channels[DCUHISTORY_CHANNELS] ;
+    for (unsigned int c = 0 ; c < DCUHISTORY_CHANNELS ; c ++) {
+      int value = 1000 + 100 * c + (d % 50) + (readout * (c + 1)) / 40 + (rand() % 3) - 1 ;
+      if ((c == 0) && (d % 100 == 0) && (readout >= 300)) value += 200 ;
+      channels[c] = value ;
+    }
+    unsigned int fec = 1 + d / 1024, ring = (d / 128) % 8, ccu = 1 + (d / 8) % 16, channel = 0x10 + d % 8 ;
+    dcus.push_back (new dcuDescription (buildCompleteKey(fec,ring,ccu,channel,0x0), timeStamp, 0x100000 + d,
+					channels[0], channels[1], channels[2], channels[3], channels[4], channels[5], channels[6], channels[7])) ;
+  }
+}
+
+/** Largest difference between the values received and the values interpolated from the points stored
+ */
+static double getInterpolationError ( std::vector<DcuHistoryPoint> &points, std::vector< std::pair<tscType32, tscType16> > &values ) {
+
+  double maxError = 0 ;
+  std::vector<DcuHistoryPoint>::iterator point = points.begin() ;
+  for (std::vector< std::pair<tscType32, tscType16> >::iterator it = values.begin() ; it != values.end() ; it ++) {
+    while ((point + 1 != points.end()) && ((point + 1)->timeStamp <= it->first)) point ++ ;
+    double value = point->value ;
+    if ((point + 1 != points.end()) && (point->timeStamp < it->first))
+      value += ((double)(point + 1)->value - point->value) * (it->first - point->timeStamp) / ((point + 1)->timeStamp - point->timeStamp) ;
+    double error = fabs (value - it->second) ;
+    if (error > maxError) maxError = error ;
+  }
+  return maxError ;
+}
+
+int main ( int argc, char **argv ) {
+
+  int error = 0 ;
+  std::string directory = "/tmp/testDcuHistoryStore" ;
+  system (("rm -rf " + directory).c_str()) ;
+
+  // Recorded DCU readouts (files written by the DcuFilter) or synthetic readouts
+  deviceVector dcus ;
+  unsigned int nDcus = 2000, nReadouts = 720 ;
+  if (argc > 1) {
+    FecDeviceFactory fecFactory ;
+    for (int i = 1 ; i < argc ; i ++) fecFactory.addFileName (argv[i]) ;
+    deviceVector devices ;
+    fecFactory.getFecDeviceDescriptions (devices, true) ;
+    for (deviceVector::iterator it = devices.begin() ; it != devices.end() ; it ++) {
+      if ((*it)->getDeviceType() == DCU) dcus.push_back (*it) ;
+      else delete *it ;
+    }
+    std::stable_sort (dcus.begin(), dcus.end(), sortDcuByTime) ;
+    std::cout << dcus.size() << " DCU readouts read from " << argc - 1 << " file(s)" << std::endl ;
+  }
+  else {
+    srand (1) ;
+    for (unsigned int r = 0 ; r < nReadouts ; r ++) buildReadout (dcus, nDcus, r, 1200000000 + r * 60) ;
+  }
+
+  // Values received for a few DCUs
+  std::map<tscType32, std::vector< std::pair<tscType32, tscType16> > > received[DCUHISTORY_CHANNELS] ;
+  for (deviceVector::iterator it = dcus.begin() ; it != dcus.end() ; it ++) {
+    dcuDescription *dcu = (dcuDescription *)*it ;
+    if (dcu->getDcuHardId() % 97 != 0) continue ;
+    for (unsigned int c = 0 ; c < DCUHISTORY_CHANNELS ; c ++)
+      received[c][dcu->getDcuHardId()].push_back (std::make_pair (dcu->getTimeStamp(), dcu->getDcuChannel(c))) ;
+  }
+
+  try {
+    tscType16 deviation = 2, deadband = 4 ;
+    {
+      DcuHistoryStore history (directory, 200000) ;
+      history.setCompressionDeviation (deviation) ;
+      history.setDeadband (deadband) ;
+
+      unsigned long start = getMicroSeconds() ;
+      deviceVector significant ;
+      for (deviceVector::iterator it = dcus.begin() ; it != dcus.end() ; ) {
+	deviceVector readout ;
+	tscType32 timeStamp = ((dcuDescription *)*it)->getTimeStamp() ;
+	for ( ; (it != dcus.end()) && (((dcuDescription *)*it)->getTimeStamp() == timeStamp) ; it ++) readout.push_back (*it) ;
+	history.add (readout, significant) ;
+      }
+      history.flush() ;
+      unsigned long addTime = getMicroSeconds() - start ;
+
+      std::cout << history.getNumberOfValues() << " values received in " << addTime << " us ("
+		<< (addTime ? history.getNumberOfValues() * 1000000.0 / addTime : 0) << " values/s)" << std::endl ;
+      std::cout << history.getNumberOfPoints() << " points stored in " << history.getNumberOfSegments() << " segments: compression ratio "
+		<< (double)history.getNumberOfValues() / history.getNumberOfPoints() << ", "
+		<< history.getNumberOfPoints() * 12 << " bytes" << std::endl ;
+      std::cout << history.getNumberOfSignificant() << " DCUs significant over " << history.getNumberOfDcus()
+		<< " (" << 100.0 * history.getNumberOfSignificant() / history.getNumberOfDcus() << "% to be uploaded)" << std::endl ;
+
+      if (history.getNumberOfSignificant() != significant.size() || history.getNumberOfPoints() >= history.getNumberOfValues()) {
+	std::cerr << "ERROR: bad counters" << std::endl ;
+	error ++ ;
+      }
+      if ((argc == 1) && (history.getNumberOfPoints() * 4 > history.getNumberOfValues() || significant.size() * 2 > dcus.size())) {
+	std::cerr << "ERROR: the synthetic readouts are not compressed" << std::endl ;
+	error ++ ;
+      }
+
+      // Invalid parameters
+      try {
+	history.setDeadband (1, DCUHISTORY_CHANNELS) ;
+	std::cerr << "ERROR: invalid channel accepted" << std::endl ;
+	error ++ ;
+      }
+      catch (FecExceptionHandler &e) { }
+      try {
+	history.getAggregates (0x100000, 0, 0, 100, 0) ;
+	std::cerr << "ERROR: invalid window accepted" << std::endl ;
+	error ++ ;
+      }
+      catch (FecExceptionHandler &e) { }
+    }
+
+    // History read again from the directory: the interpolation follows the values within the deviation
+    DcuHistoryStore history (directory, 200000) ;
+    unsigned long start = getMicroSeconds() ;
+    unsigned int queries = 0 ;
+    for (unsigned int c = 0 ; c < DCUHISTORY_CHANNELS ; c ++) {
+      for (std::map<tscType32, std::vector< std::pair<tscType32, tscType16> > >::iterator it = received[c].begin() ; it != received[c].end() ; it ++) {
+	std::vector<DcuHistoryPoint> points ;
+	history.getPoints (it->first, c, 0, 0xFFFFFFFF, points) ;
+	queries ++ ;
+	double maxError = points.empty() ? 0xFFFF : getInterpolationError (points, it->second) ;
+	if (points.empty() || points.front().timeStamp != it->second.front().first || points.back().timeStamp != it->second.back().first || maxError > deviation + 1e-9) {
+	  std::cerr << "ERROR: DCU " << it->first << " channel " << c << ": " << points.size() << " points, error " << maxError << " counts" << std::endl ;
+	  error ++ ;
+	  break ;
+	}
+      }
+    }
+    unsigned long queryTime = getMicroSeconds() - start ;
+    std::cout << queries << " channel histories read in " << queryTime << " us" << std::endl ;
+
+    // Aggregates
+    if (argc == 1) {
+      std::vector<DcuHistoryAggregate> aggregates = history.getAggregates (0x100000, 0, 1200000000, 1200000000 + nReadouts * 60, 3600) ;
+      if (aggregates.size() != 12 || aggregates[0].points == 0 || aggregates[0].min > aggregates[0].max ||
+	  aggregates[0].mean < aggregates[0].min || aggregates[0].mean > aggregates[0].max ||
+	  aggregates[11].min < 1150 || aggregates[11].last < 1150 || aggregates[2].max > 1100) {
+	std::cerr << "ERROR: bad aggregates of the DCU 0x100000" << std::endl ;
+	error ++ ;
+      }
+      for (std::vector<DcuHistoryAggregate>::iterator it = aggregates.begin() ; it != aggregates.end() ; it ++)
+	std::cout << it->timeStart << ": " << it->points << " points, min " << it->min << ", max " << it->max << ", mean " << it->mean << ", last " << it->last << std::endl ;
+      DcuHistoryAggregate empty = history.getAggregate (0x100000, 0, 0, 1000) ;
+      if (empty.points != 0) {
+	std::cerr << "ERROR: points found out of the time range" << std::endl ;
+	error ++ ;
+      }
+    }
+  }
+  catch (FecExceptionHandler &e) {
+    std::cerr << "ERROR: " << e.what() << std::endl ;
+    error ++ ;
+  }
+
+  for (deviceVector::iterator it = dcus.begin() ; it != dcus.end() ; it ++) delete *it ;
+  system (("rm -rf " + directory).c_str()) ;
+
+  if (error) std::cerr << error << " error(s)" << std::endl ;
+  else std::cout << "All tests passed" << std::endl ;
+
+  return error ? -1 : 0 ;
+}
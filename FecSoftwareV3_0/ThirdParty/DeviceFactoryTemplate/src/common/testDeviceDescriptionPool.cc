@@ -0,0 +1,204 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Copyright 2002 - 2003, Frederic DROUHIN - Universite de Haute-Alsace, Mulhouse-France
+*/
+
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "apvDescription.h"
+#include "pllDescription.h"
+#include "muxDescription.h"
+#include "laserdriverDescription.h"
+#include "dcuDescription.h"
+#include "DeviceDescriptionPool.h"
+#include "TestTime.h"
+
+/** Synthetic partition: for each module 6 APVs, 1 PLL, 1 APV MUX and 1 laserdriver, a few vpsp values
+ */
+static void buildPartition ( deviceVector &devices, unsigned int nModules ) {
+
+  for (unsigned int m = 0 ; m < nModules ; m ++) {
+    unsigned int fec = 1 + m / 2048, ring = (m / 256) % 8, ccu = 1 + (m / 16) % 16, channel = 0x10 + m % 16 ;
+    std::string fecHardwareId = "FEC" + toString (fec) ;
+    for (unsigned int a = 0x20 ; a <= 0x25 ; a ++) {
+      apvDescription *apv = new apvDescription (buildCompleteKey(fec,ring,ccu,channel,a), 0x2B, 0x64, 0x4, 0x55, 0x34, 0x22, 0x22, 0x22,
+						0x22, 0x22, 0x1D, 0x0, 0x1E, 0x3C, 0x28 + (m % 5), 0xFC, 0x1, 0x0) ;
+      apv->setFecHardwareId (fecHardwareId, 1 + fec / 10) ;
+      devices.push_back (apv) ;
+    }
+    pllDescription *pll = new pllDescription (buildCompleteKey(fec,ring,ccu,channel,0x44), m % 24, 0, 0) ;
+    pll->setFecHardwareId (fecHardwareId, 1 + fec / 10) ;
+    devices.push_back (pll) ;
+    muxDescription *mux = new muxDescription (buildCompleteKey(fec,ring,ccu,channel,0x43), 0xFF) ;
+    mux->setFecHardwareId (fecHardwareId, 1 + fec / 10) ;
+    devices.push_back (mux) ;
+    laserdriverDescription *laserdriver = new laserdriverDescription (buildCompleteKey(fec,ring,ccu,channel,0x60), 18, 18, 18, 1, 1, 1) ;
+    laserdriver->setFecHardwareId (fecHardwareId, 1 + fec / 10) ;
+    if (m % 50 == 0) laserdriver->setEnabled (false) ;
+    devices.push_back (laserdriver) ;
+  }
+}
+
+int main ( int argc, char **argv ) {
+
+  int error = 0 ;
+  unsigned int nModules = 12500 ;
+
+  deviceVector devices ;
+  buildPartition (devices, nModules) ;
+  dcuDescription *dcu = new dcuDescription (buildCompleteKey(1,0,1,0x10,0x0)) ;
+  devices.push_back (dcu) ;
+
+  try {
+    DeviceDescriptionPool pool ;
+    internedDeviceVector interned ;
+    deviceVector notInterned ;
+
+    unsigned long start = getMicroSeconds() ;
+    pool.intern (devices, interned, &notInterned) ;
+    unsigned long internTime = getMicroSeconds() - start ;
+
+    if (interned.size() != devices.size() - 1 || notInterned.size() != 1 || notInterned[0] != dcu) {
+      std::cerr << "ERROR: " << interned.size() << " devices interned, " << notInterned.size() << " not interned" << std::endl ;
+      error ++ ;
+    }
+    std::cout << interned.size() << " devices interned in " << internTime << " us: " << pool.getNumberOfStrings() << " strings, "
+	      << pool.getNumberOfRegisters() << " register sets" << std::endl ;
+
+    // Round trip
+    deviceVector built ;
+    pool.build (interned, built) ;
+    for (unsigned int i = 0 ; i < built.size() ; i ++) {
+      deviceDescription *original = devices[i] ;
+      if (built[i]->getDeviceType() != original->getDeviceType() || built[i]->getKey() != original->getKey() ||
+	  built[i]->getFecHardwareId() != original->getFecHardwareId() || built[i]->getCrateId() != original->getCrateId() ||
+	  built[i]->getEnabled() != original->getEnabled()) {
+	std::cerr << "ERROR: device " << i << " not rebuilt with the same identification" << std::endl ;
+	error ++ ;
+	break ;
+      }
+      bool different = false ;
+      switch (original->getDeviceType()) {
+      case APV25: different = *((apvDescription *)built[i]) != *((apvDescription *)original) ; break ;
+      case PLL: different = *((pllDescription *)built[i]) != *((pllDescription *)original) ; break ;
+      case APVMUX: different = *((muxDescription *)built[i]) != *((muxDescription *)original) ; break ;
+      case LASERDRIVER: different = *((laserdriverDescription *)built[i]) != *((laserdriverDescription *)original) ; break ;
+      default: break ;
+      }
+      if (different) {
+	std::cerr << "ERROR: device " << i << " not rebuilt with the same values" << std::endl ;
+	error ++ ;
+	break ;
+      }
+    }
+
+    // Memory
+    unsigned long descriptionMemory = 0 ;
+    for (deviceVector::iterator device = devices.begin() ; device != devices.end() ; device ++) {
+      switch ((*device)->getDeviceType()) {
+      case APV25: descriptionMemory += sizeof(apvDescription) ; break ;
+      case PLL: descriptionMemory += sizeof(pllDescription) ; break ;
+      case APVMUX: descriptionMemory += sizeof(muxDescription) ; break ;
+      case LASERDRIVER: descriptionMemory += sizeof(laserdriverDescription) ; break ;
+      default: descriptionMemory += sizeof(dcuDescription) ; break ;
+      }
+      descriptionMemory += sizeof(deviceDescription *) ;
+    }
+    unsigned long internedMemory = interned.size() * sizeof(internedDeviceType) + pool.getMemorySize() ;
+    std::cout << "Memory: " << descriptionMemory << " bytes for the descriptions, " << internedMemory << " bytes interned" << std::endl ;
+    if (internedMemory * 2 > descriptionMemory) {
+      std::cerr << "ERROR: interned devices take more than half of the descriptions" << std::endl ;
+      error ++ ;
+    }
+
+    // Copy
+    start = getMicroSeconds() ;
+    deviceVector copyDescriptions ;
+    for (unsigned int i = 0 ; i < built.size() ; i ++) copyDescriptions.push_back (built[i]->clone()) ;
+    unsigned long copyDescriptionTime = getMicroSeconds() - start ;
+    start = getMicroSeconds() ;
+    internedDeviceVector copyInterned = interned ;
+    unsigned long copyInternedTime = getMicroSeconds() - start ;
+    std::cout << "Copy: " << copyDescriptionTime << " us for the descriptions, " << copyInternedTime << " us interned" << std::endl ;
+
+    // Comparison: one APV changed, one PLL removed
+    ((apvDescription *)copyDescriptions[6*9+2])->setVpsp (0x10) ;
+    keyType removedKey = copyDescriptions[6]->getKey() ;
+    delete copyDescriptions[6] ;
+    copyDescriptions.erase (copyDescriptions.begin()+6) ;
+
+    internedDeviceVector uploaded ;
+    pool.intern (copyDescriptions, uploaded) ;
+
+    start = getMicroSeconds() ;
+    std::vector<keyType> differences ;
+    unsigned int nDifferences = pool.compare (interned, uploaded, differences) ;
+    unsigned long compareTime = getMicroSeconds() - start ;
+
+    if (nDifferences != 2 || differences.size() != 2 ||
+	differences[0] != built[6*9+2]->getKey() || differences[1] != removedKey) {
+      std::cerr << "ERROR: " << nDifferences << " differences found instead of 2" << std::endl ;
+      error ++ ;
+    }
+
+    start = getMicroSeconds() ;
+    unsigned int nDifferencesApv = 0 ;
+    for (unsigned int i = 0 ; i < built.size() ; i ++)
+      if (built[i]->getDeviceType() == APV25 && *((apvDescription *)built[i]) != *((apvDescription *)devices[i])) nDifferencesApv ++ ;
+    unsigned long compareDescriptionTime = getMicroSeconds() - start ;
+    start = getMicroSeconds() ;
+    unsigned int nDifferencesInterned = 0 ;
+    for (unsigned int i = 0 ; i < interned.size() ; i ++)
+      if (!DeviceDescriptionPool::equalRegisters (interned[i], copyInterned[i])) nDifferencesInterned ++ ;
+    unsigned long compareInternedTime = getMicroSeconds() - start ;
+    if (nDifferencesApv != 0 || nDifferencesInterned != 0) {
+      std::cerr << "ERROR: differences in identical vectors" << std::endl ;
+      error ++ ;
+    }
+    std::cout << "Compare: " << compareDescriptionTime << " us for the APV descriptions, " << compareInternedTime
+	      << " us interned, " << compareTime << " us for the comparison by key" << std::endl ;
+
+    // Invalid handle
+    internedDeviceType invalid = interned[0] ;
+    invalid.registers = pool.getNumberOfRegisters() ;
+    try {
+      deviceDescription *device = pool.build (invalid) ;
+      delete device ;
+      std::cerr << "ERROR: invalid handle accepted" << std::endl ;
+      error ++ ;
+    }
+    catch (FecExceptionHandler &e) { }
+
+    for (deviceVector::iterator device = built.begin() ; device != built.end() ; device ++) delete *device ;
+    for (deviceVector::iterator device = copyDescriptions.begin() ; device != copyDescriptions.end() ; device ++) delete *device ;
+  }
+  catch (FecExceptionHandler &e) {
+    std::cerr << "ERROR: " << e.what() << std::endl ;
+    error ++ ;
+  }
+
+  for (deviceVector::iterator device = devices.begin() ; device != devices.end() ; device ++) delete *device ;
+
+  if (error) std::cerr << error << " error(s)" << std::endl ;
+  else std::cout << "All tests passed" << std::endl ;
+
+  return error ? -1 : 0 ;
+}
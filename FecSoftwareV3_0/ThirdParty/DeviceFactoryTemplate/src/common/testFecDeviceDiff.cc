@@ -0,0 +1,244 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Copyright 2002 - 2003, Frederic DROUHIN - Universite de Haute-Alsace, Mulhouse-France
+*/
+
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "apvDescription.h"
+#include "pllDescription.h"
+#include "muxDescription.h"
+#include "laserdriverDescription.h"
+#include "dcuDescription.h"
+#include "delay25Description.h"
+#include "FecDeviceDiff.h"
+#include "TestTime.h"
+
+/** Synthetic partition: for each module 6 APVs, 1 PLL, 1 APV MUX, 1 laserdriver and 1 DCU
+ */
+static void buildPartition ( deviceVector &devices, unsigned int nModules ) {
+
+  for (unsigned int m = 0 ; m < nModules ; m ++) {
+    unsigned int fec = 1 + m / 2048, ring = (m / 256) % 8, ccu = 1 + (m / 16) % 16, channel = 0x10 + m % 16 ;
+    std::string fecHardwareId = "FEC" + toString (fec) ;
+    for (unsigned int a = 0x20 ; a <= 0x25 ; a ++) {
+      apvDescription *apv = new apvDescription (buildCompleteKey(fec,ring,ccu,channel,a), 0x2B, 0x64, 0x4, 0x55, 0x34, 0x22, 0x22, 0x22,
+						0x22, 0x22, 0x1D, 0x0, 0x1E, 0x3C, 0x28 + (m % 5), 0xFC, 0x1, 0x0) ;
+      apv->setFecHardwareId (fecHardwareId, 1) ;
+      devices.push_back (apv) ;
+    }
+    pllDescription *pll = new pllDescription (buildCompleteKey(fec,ring,ccu,channel,0x44), m % 24, 0, 0) ;
+    pll->setFecHardwareId (fecHardwareId, 1) ;
+    devices.push_back (pll) ;
+    muxDescription *mux = new muxDescription (buildCompleteKey(fec,ring,ccu,channel,0x43), 0xFF) ;
+    mux->setFecHardwareId (fecHardwareId, 1) ;
+    devices.push_back (mux) ;
+    laserdriverDescription *laserdriver = new laserdriverDescription (buildCompleteKey(fec,ring,ccu,channel,0x60), 18, 18, 18, 1, 1, 1) ;
+    laserdriver->setFecHardwareId (fecHardwareId, 1) ;
+    devices.push_back (laserdriver) ;
+    dcuDescription *dcu = new dcuDescription (buildCompleteKey(fec,ring,ccu,channel,0x0), 0, 0x100000 + m, 0, 0, 0, 0, 0, 0, 0, 0) ;
+    dcu->setFecHardwareId (fecHardwareId, 1) ;
+    devices.push_back (dcu) ;
+  }
+}
+
+/** Clone a vector of devices
+ */
+static void cloneDevices ( deviceVector &devices, deviceVector &copy ) {
+
+  for (deviceVector::iterator device = devices.begin() ; device != devices.end() ; device ++) copy.push_back ((*device)->clone()) ;
+}
+
+/** Delete a vector of devices
+ */
+static void deleteDevices ( deviceVector &devices ) {
+
+  for (deviceVector::iterator device = devices.begin() ; device != devices.end() ; device ++) delete *device ;
+  devices.clear() ;
+}
+
+/** Find the difference of a device
+ */
+static const deviceDiffType *findDiff ( FecDeviceDiff &diff, keyType index ) {
+
+  const std::vector<deviceDiffType> &differences = diff.getDifferences() ;
+  for (std::vector<deviceDiffType>::const_iterator it = differences.begin() ; it != differences.end() ; it ++)
+    if (it->index == index) return &(*it) ;
+  return NULL ;
+}
+
+int main ( int argc, char **argv ) {
+
+  int error = 0 ;
+  unsigned int nModules = 12500 ;
+
+  deviceVector reference, values ;
+  buildPartition (reference, nModules) ;
+  cloneDevices (reference, values) ;
+
+  try {
+    // Identical versions
+    unsigned long start = getMicroSeconds() ;
+    FecDeviceDiff diff (reference, values) ;
+    unsigned long compareTime = getMicroSeconds() - start ;
+    if (!diff.empty() || diff.getNumberOfDevices() != reference.size()) {
+      std::cerr << "ERROR: differences found between identical versions" << std::endl << diff.getSummary(10) ;
+      error ++ ;
+    }
+    std::cout << reference.size() << " devices compared in " << compareTime << " us" << std::endl ;
+
+    // One APV, one PLL, one laserdriver, one DCU modified, one PLL removed, one APV added, one MUX moved to another crate
+    apvDescription *apv = (apvDescription *)values[10*3+2] ;
+    tscType8 ipre = apv->getIpre() ;
+    apv->setIpre (ipre + 1) ;
+    apv->setVpsp (0x10) ;
+    pllDescription *pll = (pllDescription *)values[10*4+6] ;
+    pll->setDelayFine (pll->getDelayFine() + 1) ;
+    laserdriverDescription *laserdriver = (laserdriverDescription *)values[10*5+8] ;
+    laserdriver->setEnabled (false) ;
+    laserdriver->setFecHardwareId ("FEC99", 1) ;
+    dcuDescription *dcu = (dcuDescription *)values[10*6+9] ;
+    dcu->setDcuHardId (0x200000) ;
+    keyType removedKey = values[10*7+6]->getKey() ;
+    delete values[10*7+6] ;
+    values.erase (values.begin()+10*7+6) ;
+    keyType addedKey = buildCompleteKey(1,0,1,0x10,0x26) ;
+    apvDescription *added = (apvDescription *)values[0]->clone() ;
+    added->setAccessKey (addedKey) ;
+    values.push_back (added) ;
+    keyType movedKey = values[10*8+7]->getKey() ;
+    values[10*8+7]->setCrateId (2) ;
+
+    start = getMicroSeconds() ;
+    unsigned int nDifferences = diff.compare (reference, values) ;
+    compareTime = getMicroSeconds() - start ;
+    std::cout << diff.getSummary() ;
+    std::cout << "Comparison with " << nDifferences << " differences in " << compareTime << " us" << std::endl ;
+
+    if (nDifferences != 8 || diff.getNumberOfAdded() != 2 || diff.getNumberOfRemoved() != 2 || diff.getNumberOfModified() != 4) {
+      std::cerr << "ERROR: " << diff.getNumberOfAdded() << " added, " << diff.getNumberOfRemoved() << " removed, "
+		<< diff.getNumberOfModified() << " modified instead of 2, 2, 4" << std::endl ;
+      error ++ ;
+    }
+
+    const deviceDiffType *apvDiff = findDiff (diff, apv->getKey()) ;
+    if (apvDiff == NULL || apvDiff->diff != DEVICEMODIFIED || apvDiff->registers.size() != 2 ||
+	apvDiff->registers[0].registerName != apvDescription::APVPARAMETERNAMES[apvDescription::IPRE] ||
+	apvDiff->registers[0].oldValue != ipre || apvDiff->registers[0].newValue != (tscType8)(ipre + 1) ||
+	apvDiff->registers[1].registerName != apvDescription::APVPARAMETERNAMES[apvDescription::VPSP] ||
+	apvDiff->registers[1].newValue != 0x10) {
+      std::cerr << "ERROR: registers of the APV modified not found" << std::endl ;
+      error ++ ;
+    }
+
+    const deviceDiffType *pllDiff = findDiff (diff, pll->getKey()) ;
+    if (pllDiff == NULL || pllDiff->registers.size() != 1 ||
+	pllDiff->registers[0].registerName != pllDescription::PLLPARAMETERNAMES[pllDescription::DELAYFINE]) {
+      std::cerr << "ERROR: register of the PLL modified not found" << std::endl ;
+      error ++ ;
+    }
+
+    const deviceDiffType *laserdriverDiff = findDiff (diff, laserdriver->getKey()) ;
+    if (laserdriverDiff == NULL || laserdriverDiff->registers.size() != 2 ||
+	laserdriverDiff->registers[0].newText != "FEC99" ||
+	laserdriverDiff->registers[1].registerName != deviceDescription::FECPARAMETERNAMES[deviceDescription::ENABLED]) {
+      std::cerr << "ERROR: enable and FEC hardware id of the laserdriver modified not found" << std::endl ;
+      error ++ ;
+    }
+
+    const deviceDiffType *dcuDiff = findDiff (diff, dcu->getKey()) ;
+    if (dcuDiff == NULL || dcuDiff->registers.size() != 1 || dcuDiff->registers[0].newValue != 0x200000) {
+      std::cerr << "ERROR: hardware id of the DCU modified not found" << std::endl ;
+      error ++ ;
+    }
+
+    const deviceDiffType *removedDiff = findDiff (diff, removedKey) ;
+    const deviceDiffType *addedDiff = findDiff (diff, addedKey) ;
+    if (removedDiff == NULL || removedDiff->diff != DEVICEREMOVED || removedDiff->deviceType != PLL ||
+	addedDiff == NULL || addedDiff->diff != DEVICEADDED || addedDiff->deviceType != APV25) {
+      std::cerr << "ERROR: devices added and removed not found" << std::endl ;
+      error ++ ;
+    }
+
+    unsigned int moved = 0 ;
+    const std::vector<deviceDiffType> &differences = diff.getDifferences() ;
+    for (std::vector<deviceDiffType>::const_iterator it = differences.begin() ; it != differences.end() ; it ++) {
+      if (it->index == movedKey) moved ++ ;
+      if (it != differences.begin() && (it-1)->index > it->index) {
+	std::cerr << "ERROR: differences not sorted by key" << std::endl ;
+	error ++ ;
+	break ;
+      }
+    }
+    if (moved != 2) {
+      std::cerr << "ERROR: device moved to another crate not removed and added" << std::endl ;
+      error ++ ;
+    }
+
+    std::string summary = diff.getSummary (3) ;
+    if (summary.find ("2 device(s) added, 2 removed, 4 modified") != 0 || summary.find ("... 5 other device(s)") == std::string::npos) {
+      std::cerr << "ERROR: bad summary" << std::endl << summary ;
+      error ++ ;
+    }
+    if (diff.getSummary().find ("ipre " + toString((int)ipre) + " -> " + toString((int)(tscType8)(ipre + 1))) == std::string::npos) {
+      std::cerr << "ERROR: register of the APV not in the summary" << std::endl ;
+      error ++ ;
+    }
+
+    // A register of a DELAY25 (not interned) changed: the upload of the version must not be skipped
+    delay25Description delay25Reference (buildCompleteKey(1,0,1,0x10,0x60), 10, 20, 30, 40, 50) ;
+    delay25Description delay25Value (buildCompleteKey(1,0,1,0x10,0x60), 10, 20, 31, 40, 50) ;
+    deviceVector delay25References (1, &delay25Reference), delay25Values (1, &delay25Value) ;
+    diff.compare (delay25References, delay25Values) ;
+    if (diff.empty() || (diff.getNumberOfModified() != 1)) {
+      std::cerr << "ERROR: register of the DELAY25 modified not found" << std::endl ;
+      error ++ ;
+    }
+    diff.compare (delay25References, delay25References) ;
+    if (!diff.empty()) {
+      std::cerr << "ERROR: differences found for the same DELAY25" << std::endl ;
+      error ++ ;
+    }
+
+    // Empty versions
+    deviceVector empty ;
+    diff.compare (empty, empty) ;
+    if (!diff.empty()) {
+      std::cerr << "ERROR: differences found between empty versions" << std::endl ;
+      error ++ ;
+    }
+  }
+  catch (FecExceptionHandler &e) {
+    std::cerr << "ERROR: " << e.what() << std::endl ;
+    error ++ ;
+  }
+
+  deleteDevices (reference) ;
+  deleteDevices (values) ;
+
+  if (error) {
+    std::cerr << error << " error(s)" << std::endl ;
+    return -1 ;
+  }
+
+  std::cout << "All tests passed" << std::endl ;
+  return 0 ;
+}
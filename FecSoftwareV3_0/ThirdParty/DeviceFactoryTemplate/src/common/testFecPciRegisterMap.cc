@@ -0,0 +1,180 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <sys/ioctl.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdlib.h>
+
+#include <iostream>
+#include <vector>
+
+#include "cmdDescription.h"
+#include "datatypes.h"
+#include "fec_ioctl.h"
+#include "FecExceptionHandler.h"
+#include "FecPciBar.h"
+#include "FecPciBarModel.h"
+#include "TestTime.h"
+
+/** Check a value
+ */
+static int check ( const char *name, tscType32 value, tscType32 expected ) {
+
+  if (value != expected) {
+    std::cerr << "ERROR: " << name << ": 0x" << std::hex << value << " instead of 0x" << expected << std::dec << std::endl ;
+    return 1 ;
+  }
+  return 0 ;
+}
+
+/** Send a frame as FecRingDevice::sendFifoTransmit and read the frame back as the ring device does
+ */
+static int sendFrame ( FecPciBar &bar, tscType32 *frame, int count, tscType32 *back ) {
+
+  bar.writeFifo (bar.getFifoTransmitOffset(), frame, count) ;
+  bar.write (DD_FEC_CTRL1_OFFSET, DD_FEC_CLEAR_ERRORS) ;
+  tscType32 cr0 = bar.read (DD_FEC_CTRL0_OFFSET) ;
+  bar.write (DD_FEC_CTRL0_OFFSET, cr0 | FEC_CR0_SEND | FEC_CR0_ENABLEFEC) ;
+  bar.write (DD_FEC_CTRL0_OFFSET, cr0 | FEC_CR0_ENABLEFEC) ;
+
+  int loop = 0 ;
+  while ((bar.read (DD_FEC_STAT0_OFFSET) & FEC_SR0_RECEMPTY) && (loop < 100)) loop ++ ;
+  if (loop == 100) return 0 ;
+
+  int words = 0 ;
+  while (!(bar.read (DD_FEC_STAT0_OFFSET) & FEC_SR0_RECEMPTY) && (words < count)) {
+    bar.readFifo (bar.getFifoReceiveOffset(), back + words, 1) ;
+    words ++ ;
+  }
+  return words ;
+}
+
+/** Test of the register accesses of the PCI FEC on a memory image and on the model of the FIFOs
+ */
+int main ( int argc, char *argv[] ) {
+
+  unsigned int nWords = 1000000 ;
+  if (argc > 1) nWords = atoi(argv[1]) ;
+
+  int error = 0 ;
+
+  try {
+    // Mapped registers on memory: each offset is a word of the image
+    std::vector<tscType32> image (0x30 / 4, 0) ;
+    FecPciMappedBar mapped (&image[0], DD_FEC_FIFOTRA_OFFSET_EV1, DD_FEC_FIFOREC_OFFSET_EV1, DD_FEC_FIFORET_OFFSET_EV1) ;
+    mapped.write (DD_FEC_CTRL0_OFFSET, 0x1234) ;
+    mapped.write (DD_FEC_CTRL1_OFFSET, 0x5678) ;
+    image[DD_FEC_STAT0_OFFSET / 4] = 0x0c98 ;
+    image[DD_FEC_FIRMWARE_VERSION_OFFSET / 4] = 0x1e ;
+    error += check ("mapped CR0", image[0], 0x1234) ;
+    error += check ("mapped CR1", image[1], 0x5678) ;
+    error += check ("mapped CR0 read", mapped.read (DD_FEC_CTRL0_OFFSET), 0x1234) ;
+    error += check ("mapped SR0 read", mapped.read (DD_FEC_STAT0_OFFSET), 0x0c98) ;
+    error += check ("mapped firmware version", mapped.read (DD_FEC_FIRMWARE_VERSION_OFFSET), 0x1e) ;
+
+    // Block in the FIFO transmit: all words at the same offset, the last one stays in memory
+    tscType32 frame[8] = { 0x10, 0x20, 0x05, 0x01, 0x30, 0x40, 0x50, 0x60 } ;
+    mapped.writeFifo (mapped.getFifoTransmitOffset(), frame, 8) ;
+    error += check ("mapped FIFO transmit", image[DD_FEC_FIFOTRA_OFFSET_EV1 / 4], 0x60) ;
+    error += check ("mapped FIFO receive untouched", image[DD_FEC_FIFOREC_OFFSET_EV1 / 4], 0) ;
+    image[DD_FEC_FIFOREC_OFFSET_EV1 / 4] = 0xabcd ;
+    tscType32 values[3] = { 0, 0, 0 } ;
+    mapped.readFifo (mapped.getFifoReceiveOffset(), values, 3) ;
+    error += check ("mapped FIFO receive", values[0] + values[1] + values[2], 3 * 0xabcd) ;
+
+    // Model of the FIFOs and of the status register 0
+    FecPciBarModel model ;
+    tscType32 sr0 = model.read (DD_FEC_STAT0_OFFSET) ;
+    error += check ("empty FIFOs", sr0 & (FEC_SR0_TRAEMPTY | FEC_SR0_RECEMPTY | FEC_SR0_RETEMPTY),
+		    FEC_SR0_TRAEMPTY | FEC_SR0_RECEMPTY | FEC_SR0_RETEMPTY) ;
+    model.setRegister (DD_FEC_STAT0_OFFSET, FEC_SR0_LINKINITIALIZED | FEC_SR0_RECEMPTY) ;
+    model.writeFifo (model.getFifoTransmitOffset(), frame, 8) ;
+    model.write (model.getFifoReturnOffset(), 0x5) ;
+    sr0 = model.read (DD_FEC_STAT0_OFFSET) ;
+    error += check ("SR0 with the FIFO transmit filled", sr0, FEC_SR0_LINKINITIALIZED | FEC_SR0_RECEMPTY) ;
+    error += check ("FIFO transmit size", model.getFifoTransmit().size(), 8) ;
+    error += check ("FIFO return", model.read (model.getFifoReturnOffset()), 0x5) ;
+    error += check ("FIFO return empty", model.read (model.getFifoReturnOffset()), 0) ;
+    model.readFifo (model.getFifoTransmitOffset(), values, 3) ;
+    error += check ("FIFO transmit order", values[2], 0x05) ;
+    error += check ("accesses counted", model.getReads() + model.getWrites(), 2 + 9 + 2 + 3) ;
+
+    // A frame sent comes back in the FIFO receive in loopback mode
+    FecPciBarModel ring (0x30, DD_FEC_FIFOTRA_OFFSET_EV1, DD_FEC_FIFOREC_OFFSET_EV1, DD_FEC_FIFORET_OFFSET_EV1, true) ;
+    tscType32 back[8] = { 0 } ;
+    int words = sendFrame (ring, frame, 8, back) ;
+    error += check ("words received", words, 8) ;
+    for (int i = 0 ; i < words ; i ++) error += check ("word received", back[i], frame[i]) ;
+    error += check ("send bit cleared", ring.getRegister (DD_FEC_CTRL0_OFFSET) & FEC_CR0_SEND, 0) ;
+    error += check ("errors cleared", ring.getRegister (DD_FEC_CTRL1_OFFSET), DD_FEC_CLEAR_ERRORS) ;
+
+    // Accesses out of the registers are refused
+    try {
+      model.read (0x30) ;
+      std::cerr << "ERROR: read out of the registers accepted" << std::endl ;
+      error ++ ;
+    }
+    catch (FecExceptionHandler &e) { }
+    try {
+      model.write (0x2, 0) ;
+      std::cerr << "ERROR: write not aligned accepted" << std::endl ;
+      error ++ ;
+    }
+    catch (FecExceptionHandler &e) { }
+
+    // Benchmark: volatile stores in the mapped FIFO against two system calls per word,
+    // as glue_fec_set_native_fifotra_item_32 (the ioctl are done on /dev/null)
+    int fd = open ("/dev/null", O_RDWR) ;
+    if (fd < 0) {
+      std::cerr << "ERROR: cannot open /dev/null for the benchmark" << std::endl ;
+      error ++ ;
+    }
+    else {
+      std::vector<tscType32> block (nWords) ;
+      for (unsigned int i = 0 ; i < nWords ; i ++) block[i] = i ;
+      unsigned long start = getMicroSeconds() ;
+      mapped.writeFifo (mapped.getFifoTransmitOffset(), &block[0], nWords) ;
+      unsigned long mappedTime = getMicroSeconds() - start ;
+      error += check ("last word of the benchmark", image[DD_FEC_FIFOTRA_OFFSET_EV1 / 4], nWords - 1) ;
+
+      int size ;
+      DD_FEC_ARRAY offsetAndValue ;
+      start = getMicroSeconds() ;
+      for (unsigned int i = 0 ; i < nWords ; i ++) {
+	ioctl (fd, DD_IOC_GET_FIFO_ITEM_SIZE, &size) ;
+	ioctl (fd, DD_IOC_WRITE_TO_FEC_FIFO, &offsetAndValue) ;
+      }
+      unsigned long ioctlTime = getMicroSeconds() - start ;
+      close (fd) ;
+
+      std::cout << nWords << " words written in the FIFO transmit:" << std::endl ;
+      std::cout << "  registers mapped: " << mappedTime << " us" << std::endl ;
+      std::cout << "  ioctl per word  : " << ioctlTime << " us" << std::endl ;
+    }
+  }
+  catch (FecExceptionHandler &e) {
+    std::cerr << "ERROR: " << e.what() << std::endl ;
+    error ++ ;
+  }
+
+  if (error) std::cerr << error << " error(s)" << std::endl ;
+  else std::cout << "All tests passed" << std::endl ;
+
+  return error ? -1 : 0 ;
+}
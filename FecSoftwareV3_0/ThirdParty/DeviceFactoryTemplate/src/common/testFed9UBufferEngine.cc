@@ -0,0 +1,262 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Copyright 2002 - 2003, Frederic DROUHIN - Universite de Haute-Alsace, Mulhouse-France
+*/
+
+#include <stdlib.h>
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "Fed9UBufferGenerator.hh"
+#include "Fed9UBufferCreatorRaw.hh"
+#include "Fed9UBufferCreatorProcRaw.hh"
+#include "Fed9UBufferDescription.hh"
+#include "Fed9URawBufferWriter.hh"
+#include "Fed9USignalModel.hh"
+#include "Fed9UBufferEngine.hh"
+#include "Fed9UEventIntegrity.hh"
+#include "Fed9UEventInfo.hh"
+#include "Fed9UCrc.hh"
+#include "TestTime.h"
+
+using namespace Fed9U ;
+
+/** Description of the events made by Fed9UBufferCreatorRaw (virgin raw) or Fed9UBufferCreatorProcRaw
+ */
+static void setRawDescription ( Fed9UBufferDescription &description, bool virginRaw, bool fullDebug ) {
+
+  Fed9UEventInfo info ;
+  if (virginRaw) {
+    description.setPacketCode (0xE0 | info.getVirginRawModeCode() | info.getFrameFindingModeCode()) ;
+    description.setMode (info.getVirginRawModeCode()) ;
+    description.trackerEventType (info.getVirginRawDaqModeCode()) ;
+  }
+  else {
+    description.setPacketCode (0xE0 | info.getProcessedRawModeCode() | info.getFrameFindingModeCode()) ;
+    description.setMode (info.getProcessedRawDaqModeCode()) ;
+    description.trackerEventType (info.getProcessedRawDaqModeCode()) ;
+  }
+  description.setHeaderFormat (fullDebug ? info.getTrackerSpecialHeaderFullDebugMode() : info.getTrackerSpecialHeaderApvErrorMode()) ;
+}
+
+/** Compare the writer with the buffer generator, which leaves the APV address error register and the CRC to 0
+ */
+static int compareWithGenerator ( bool virginRaw, const std::vector<unsigned short> &strips ) {
+
+  Fed9UBufferCreatorRaw rawCreator ;
+  Fed9UBufferCreatorProcRaw procRawCreator ;
+  Fed9UBufferGenerator generator (virginRaw ? static_cast<Fed9UBufferCreator *>(&rawCreator) : &procRawCreator) ;
+  generator.setBunchCrossing (0x123) ;
+  generator.generateFed9UBuffer (strips) ;
+  std::vector<u32> reference (generator.getBufferSize()) ;
+  generator.getBuffer (reinterpret_cast<unsigned int*>(&reference[0])) ;
+  reference[2] |= 0xFF ;
+  reference[reference.size() - 1] = calculateFEDBufferCRC (reinterpret_cast<u8 *>(&reference[0]), reference.size() * 4, true) << 16 ;
+
+  Fed9UBufferDescription description ;
+  setRawDescription (description, virginRaw, true) ;
+  description.setBunchCrossing (0x123) ;
+  Fed9URawBufferWriter writer (description) ;
+  std::vector<u32> buffer (writer.getBufferSize() + 1) ;
+  u32 words = writer.write (&strips[0], 0, &buffer[0]) ;
+
+  if (words != reference.size()) {
+    std::cerr << "ERROR: " << words << " words written instead of " << reference.size() << std::endl ;
+    return 1 ;
+  }
+  for (u32 i = 0 ; i < words ; i ++) {
+    if (buffer[i] != reference[i]) {
+      std::cerr << "ERROR: " << (virginRaw ? "virgin raw" : "processed raw") << " word " << i << " is 0x" << std::hex << buffer[i]
+		<< " instead of 0x" << reference[i] << std::dec << std::endl ;
+      return 1 ;
+    }
+  }
+  return 0 ;
+}
+
+/** Generate the events and return the CRC of each event. If check is set the integrity of all the events is checked, and
+ * the truth of one every truth events if truth is not zero.
+ */
+static int runEngine ( Fed9UBufferEngine &engine, std::vector<u32> &slots, u32 slotWords, u16 threads, u32 events, bool check, u32 truth,
+		       std::vector<u32> &crcs, unsigned long &time ) {
+
+  int error = 0 ;
+  Fed9UEventIntegrityChecker checker ;
+  Fed9UEventIntegrity integrity ;
+  crcs.assign (events + 1, 0) ;
+
+  unsigned long start = getMicroSeconds() ;
+  engine.start (&slots[0], slots.size() / slotWords, slotWords, threads, events) ;
+  u32 eventNumber, received = 0 ;
+  const u32 *event ;
+  while ((event = engine.pop (eventNumber)) != NULL) {
+    received ++ ;
+    if ((eventNumber == 0) || (eventNumber > events) || crcs[eventNumber]) {
+      std::cerr << "ERROR: event " << eventNumber << " unexpected" << std::endl ;
+      error ++ ;
+    }
+    else crcs[eventNumber] = event[engine.getBufferSize() - 1] ;
+    if (check && !checker.check (event, engine.getBufferSize(), integrity)) {
+      std::cerr << "ERROR: event " << eventNumber << " rejected by the integrity checker, errors 0x" << std::hex << integrity._errors << std::dec << std::endl ;
+      error ++ ;
+    }
+    std::ostringstream report ;
+    if (truth && (eventNumber % truth == 0) && !engine.checkEvent (event, eventNumber, report)) {
+      std::cerr << "ERROR: " << report.str() ;
+      error ++ ;
+    }
+    engine.release (event) ;
+    if (error > 10) break ;
+  }
+  time = getMicroSeconds() - start ;
+  engine.stop() ;
+
+  if ((received != events) || (engine.getEventsGenerated() != events)) {
+    std::cerr << "ERROR: " << received << " events received and " << engine.getEventsGenerated() << " generated instead of " << events << std::endl ;
+    error ++ ;
+  }
+  return error ;
+}
+
+/** \param -events <number of events> -threads <number of threads>
+ */
+int main ( int argc, char **argv ) {
+
+  unsigned int events = 2000 ;
+  u16 threads = 4 ;
+  for (int i = 1 ; i < argc ; i ++) {
+    std::string param ( argv[i] ) ;
+    if ((param == "-events") && (i+1 < argc)) {
+      events = atoi(argv[i+1]) ;
+      i ++ ;
+    }
+    else if ((param == "-threads") && (i+1 < argc)) {
+      threads = atoi(argv[i+1]) ;
+      i ++ ;
+    }
+    else if (param == "-help") {
+      std::cerr << argv[0] << " -events <number of events> -threads <number of threads>" << std::endl ;
+      return 0 ;
+    }
+  }
+
+  int error = 0 ;
+
+  try {
+    // -------------------------------------------------------------------------
+    // Same buffers as the buffer generator
+    std::vector<unsigned short> strips (STRIPS_PER_FED) ;
+    srand (4321) ;
+    for (u32 i = 0 ; i < STRIPS_PER_FED ; i ++) strips[i] = rand() % 1024 ;
+    error += compareWithGenerator (true, strips) ;
+    error += compareWithGenerator (false, strips) ;
+
+    // -------------------------------------------------------------------------
+    // Signal model with clusters
+    Fed9UPedestalNoiseModel model (200, 2.0, 20, 150) ;
+    Fed9UBufferDescription description ;
+    setRawDescription (description, true, true) ;
+    Fed9URawBufferWriter writer (description) ;
+    Fed9UBufferEngine engine (writer, model, 99) ;
+
+    std::vector<u16> truth (STRIPS_PER_FED), again (STRIPS_PER_FED) ;
+    engine.getTruth (7, &truth[0]) ;
+    engine.getTruth (7, &again[0]) ;
+    u32 high = 0 ;
+    for (u32 i = 0 ; i < STRIPS_PER_FED ; i ++) {
+      if (truth[i] != again[i]) {
+	std::cerr << "ERROR: the truth of an event is not reproducible" << std::endl ;
+	error ++ ;
+	break ;
+      }
+      if (truth[i] > 200 + 20) high ++ ;
+    }
+    if ((high < 20) || (high > 20 * 3)) {
+      std::cerr << "ERROR: " << high << " strips in clusters for 20 clusters" << std::endl ;
+      error ++ ;
+    }
+
+    // -------------------------------------------------------------------------
+    // Engine: every event generated once, valid and equal to its truth, the same whatever the number of threads
+    const u32 slotWords = (engine.getBufferSize() + 1) & ~1 ;
+    std::vector<u32> slots (slotWords * (2 * threads + 2)) ;
+    std::vector<u32> crcs, crcsOneThread ;
+    unsigned long time, timeOneThread ;
+    error += runEngine (engine, slots, slotWords, threads, events, true, 10, crcs, time) ;
+    error += runEngine (engine, slots, slotWords, 1, events, false, 0, crcsOneThread, timeOneThread) ;
+    if (crcs != crcsOneThread) {
+      std::cerr << "ERROR: the events depend on the number of threads" << std::endl ;
+      error ++ ;
+    }
+    error += runEngine (engine, slots, slotWords, threads, events, false, 0, crcs, time) ;
+
+    // APV ERROR header and processed raw, which Fed9UEvent cannot decode, checked with the integrity checker
+    Fed9UBufferDescription apvErrorDescription ;
+    setRawDescription (apvErrorDescription, false, false) ;
+    Fed9URawBufferWriter apvErrorWriter (apvErrorDescription) ;
+    Fed9UBufferEngine apvErrorEngine (apvErrorWriter, model, 99) ;
+    std::vector<u32> apvErrorCrcs ;
+    unsigned long apvErrorTime ;
+    error += runEngine (apvErrorEngine, slots, slotWords, threads, events / 10, true, 0, apvErrorCrcs, apvErrorTime) ;
+
+    // Stop while generating without limit
+    engine.start (&slots[0], slots.size() / slotWords, slotWords, threads) ;
+    u32 eventNumber ;
+    for (unsigned int i = 0 ; i < 100 ; i ++) engine.release (engine.pop (eventNumber)) ;
+    engine.stop() ;
+    if ((engine.getEventsGenerated() < 100) || engine.pop (eventNumber)) {
+      std::cerr << "ERROR: generation without limit not stopped" << std::endl ;
+      error ++ ;
+    }
+
+    // -------------------------------------------------------------------------
+    // Rate compared to the buffer generator, with the CRC that it leaves to zero
+    Fed9UBufferCreatorRaw creator ;
+    Fed9UBufferGenerator generator (&creator) ;
+    unsigned int generatorEvents = events / 20 + 1 ;
+    std::vector<u32> buffer (engine.getBufferSize()) ;
+    unsigned long start = getMicroSeconds() ;
+    for (unsigned int e = 1 ; e <= generatorEvents ; e ++) {
+      engine.getTruth (e, &strips[0]) ;
+      generator.generateFed9UBuffer (strips) ;
+      generator.getBuffer (reinterpret_cast<unsigned int*>(&buffer[0])) ;
+      buffer[buffer.size() - 1] = calculateFEDBufferCRC (reinterpret_cast<u8 *>(&buffer[0]), buffer.size() * 4, true) << 16 ;
+    }
+    unsigned long generatorTime = getMicroSeconds() - start ;
+
+    double generatorRate = generatorEvents * 1e6 / generatorTime, oneThreadRate = events * 1e6 / timeOneThread, rate = events * 1e6 / time ;
+    std::cout << "Fed9UBufferGenerator: " << generatorRate << " events/s" << std::endl ;
+    std::cout << "Fed9UBufferEngine, 1 thread: " << oneThreadRate << " events/s, " << oneThreadRate * engine.getBufferSize() * 4 / 1e6 << " MB/s" << std::endl ;
+    std::cout << "Fed9UBufferEngine, " << threads << " threads: " << rate << " events/s, " << rate * engine.getBufferSize() * 4 / 1e6 << " MB/s" << std::endl ;
+    if (oneThreadRate < generatorRate) {
+      std::cerr << "ERROR: the engine is slower than the buffer generator" << std::endl ;
+      error ++ ;
+    }
+  }
+  catch (std::exception &e) {
+    std::cerr << "ERROR: " << e.what() << std::endl ;
+    error ++ ;
+  }
+
+  if (error) std::cerr << error << " error(s)" << std::endl ;
+  else std::cout << "All tests passed" << std::endl ;
+
+  return error ? -1 : 0 ;
+}
@@ -0,0 +1,262 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Copyright 2002 - 2003, Frederic DROUHIN - Universite de Haute-Alsace, Mulhouse-France
+*/
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Fed9UCfDeployer.hh"
+#include "Fed9UWait.hh"
+#include "TestTime.h"
+
+using namespace Fed9U ;
+
+/** VME bus of the crate, only one FED transfers data at a time
+ */
+static pthread_mutex_t busMutex = PTHREAD_MUTEX_INITIALIZER ;
+
+/** In memory compact flash card of a FED. Each cluster transfer holds the VME bus for busTime micro seconds, then the card
+ * takes cardTime micro seconds. The firmware loaded by a reload has the versions of the image only if the card holds it.
+ */
+class FakeCf: public Fed9UCfTarget {
+public:
+  FakeCf ( const Fed9UCfImage &image, const Fed9UCfFirmwareVersions &newVersions, u32 busTime, u32 cardTime ):
+    image_(image), newVersions_(newVersions), busTime_(busTime), cardTime_(cardTime), card_(Fed9UCfImage::MAX_CLUSTERS * Fed9UCfImage::CLUSTER_BYTES, 0xff),
+    writes_(Fed9UCfImage::MAX_CLUSTERS, 0), corruptCluster_(-1), failCluster_(-1), stopCluster_(-1), stopDeployer_(NULL), reloads_(0) {
+    versions_._fe = versions_._delay = versions_._be = versions_._vme = 1 ;
+  }
+
+  void writeCluster ( u32 cluster, const u8 *data ) {
+    if (static_cast<int>(cluster) == failCluster_) {
+      failCluster_ = -1 ;
+      throw std::runtime_error ("VME bus error") ;
+    }
+    if (static_cast<int>(cluster) == stopCluster_) {
+      stopCluster_ = -1 ;
+      stopDeployer_->stop() ;
+    }
+    transfer() ;
+    memcpy (&card_[cluster * Fed9UCfImage::CLUSTER_BYTES], data, Fed9UCfImage::CLUSTER_BYTES) ;
+    // A bit flips on the first write of the corrupt cluster
+    if (static_cast<int>(cluster) == corruptCluster_ && writes_[cluster] == 0) card_[cluster * Fed9UCfImage::CLUSTER_BYTES + 1000] ^= 0x10 ;
+    writes_[cluster] ++ ;
+  }
+
+  void readCluster ( u32 cluster, u8 *data ) {
+    transfer() ;
+    memcpy (data, &card_[cluster * Fed9UCfImage::CLUSTER_BYTES], Fed9UCfImage::CLUSTER_BYTES) ;
+  }
+
+  void reloadFirmware ( u32 revision ) {
+    reloads_ ++ ;
+    if (!memcmp (&card_[0], image_.getCluster (0), image_.getClusterCount() * Fed9UCfImage::CLUSTER_BYTES)) versions_ = newVersions_ ;
+  }
+
+  void transfer ( ) {
+    pthread_mutex_lock (&busMutex) ;
+    fed9Uwait (busTime_) ;
+    pthread_mutex_unlock (&busMutex) ;
+    fed9Uwait (cardTime_) ;
+  }
+
+  Fed9UCfFirmwareVersions getFirmwareVersions ( ) { return versions_ ; }
+
+  const Fed9UCfImage &image_ ;
+  Fed9UCfFirmwareVersions newVersions_ ;
+  Fed9UCfFirmwareVersions versions_ ;
+  u32 busTime_ ;
+  u32 cardTime_ ;
+  std::vector<u8> card_ ;
+  std::vector<unsigned int> writes_ ;
+  int corruptCluster_ ;
+  int failCluster_ ;
+  int stopCluster_ ;
+  Fed9UCfDeployer *stopDeployer_ ;
+  unsigned int reloads_ ;
+};
+
+/** Build an .ace file as written by Fed9UVmeDevice::getCfImageFile, the BE and delay labels swapped as it does
+ */
+static std::string makeAceFile ( u32 dataBytes ) {
+  std::ostringstream file ;
+  file << "Revision: 0\n"
+       << "\tFE FPGA    : vers = $ 21000410\n"
+       << "\tDELAY FPGA : vers = $ 23000312\n"
+       << "\tBE FPGA    : vers = $ 22000105\n"
+       << "\tVME FPGA   : vers = $ 24000208\n"
+       << "END OF FILE HEADER\n" ;
+  std::string data (dataBytes, 0) ;
+  for (u32 i = 0 ; i < dataBytes ; i ++) data[i] = static_cast<char>((i * 7 + i / 1000) & 0xff) ;
+  return file.str() + data + "\nEND OF FILE\n" ;
+}
+
+int main ( int argc, char **argv ) {
+
+  unsigned int fedNumber = 16 ;
+  unsigned int clusters = 488 ;
+  unsigned int busTime = 50 ;
+  unsigned int cardTime = 1000 ;
+  for (int i = 1 ; i < argc ; i ++) {
+    std::string param ( argv[i] ) ;
+    if ((param == "-feds") && (i+1 < argc)) {
+      fedNumber = atoi(argv[i+1]) ;
+      i ++ ;
+    }
+    else if ((param == "-clusters") && (i+1 < argc)) {
+      clusters = atoi(argv[i+1]) ;
+      i ++ ;
+    }
+    else if ((param == "-busTime") && (i+1 < argc)) {
+      busTime = atoi(argv[i+1]) ;
+      i ++ ;
+    }
+    else if ((param == "-cardTime") && (i+1 < argc)) {
+      cardTime = atoi(argv[i+1]) ;
+      i ++ ;
+    }
+    else if (param == "-help") {
+      std::cerr << argv[0] << " -feds <number of FEDs> -clusters <image clusters> -busTime <VME micro seconds per cluster> -cardTime <card micro seconds per cluster>" << std::endl ;
+      return 0 ;
+    }
+  }
+  if (fedNumber < 4) fedNumber = 4 ;
+  if (clusters < 30 || clusters > Fed9UCfImage::MAX_CLUSTERS) clusters = 488 ;
+
+  int error = 0 ;
+
+  try {
+    // -------------------------------------------------------------------------
+    // Image parsing: header, versions, partial last cluster padded with zeros
+    const u32 dataBytes = (clusters - 1) * Fed9UCfImage::CLUSTER_BYTES + 1000 ;
+    std::istringstream aceFile (makeAceFile (dataBytes)) ;
+    Fed9UCfImage image (aceFile) ;
+    Fed9UCfFirmwareVersions versions ;
+    if (image.getClusterCount() != clusters || image.getDataSize() != dataBytes || image.getFirmwareInfo().find ("VME FPGA") == std::string::npos
+	|| !image.getFirmwareVersions (0, versions) || versions._fe != 0x21000410 || versions._delay != 0x23000312 || image.getFirmwareVersions (1, versions)
+	|| image.getCluster (clusters - 1)[1000] != 0 || image.getCluster (clusters - 1)[999] != static_cast<u8>((dataBytes - 1) * 7 + (dataBytes - 1) / 1000)) {
+      std::cerr << "ERROR: image parsed wrongly: " << image.getClusterCount() << " clusters, " << image.getDataSize() << " bytes" << std::endl ;
+      error ++ ;
+    }
+
+    std::string truncated (makeAceFile (1000)) ;
+    truncated.resize (truncated.size() - 5) ;
+    std::istringstream truncatedFile (truncated) ;
+    try {
+      Fed9UCfImage bad (truncatedFile) ;
+      std::cerr << "ERROR: incomplete image accepted" << std::endl ;
+      error ++ ;
+    }
+    catch (const std::exception &e) { }
+
+    // -------------------------------------------------------------------------
+    // FED 1 has a bit flip on cluster 5, FED 2 fails at cluster 20, FED 3 loads the wrong firmware
+    image.getFirmwareVersions (0, versions) ;
+    Fed9UCfFirmwareVersions loaded (versions) ;
+    // The FEDs return the versions in the right order
+    loaded._delay = versions._be ;
+    loaded._be = versions._delay ;
+    std::vector<FakeCf*> cards ;
+    Fed9UCfDeployer deployer (image) ;
+    for (unsigned int fed = 0 ; fed < fedNumber ; fed ++) {
+      cards.push_back (new FakeCf (image, loaded, busTime, cardTime)) ;
+      deployer.addFed (*cards[fed]) ;
+    }
+    cards[1]->corruptCluster_ = 5 ;
+    cards[2]->failCluster_ = 20 ;
+
+    std::vector<Fed9UCfDeployStatus> status ;
+    unsigned long start = getMicroSeconds() ;
+    unsigned int failed = deployer.deploy (status) ;
+    double firstPass = (getMicroSeconds() - start) / 1000000.0 ;
+    if (failed != 1 || status[2]._clustersDone != 20 || status[2]._error.find ("VME bus error") == std::string::npos || status[1]._rewrites != 1) {
+      std::cerr << "ERROR: first pass: " << failed << " failed FED(s), FED 2 stopped at " << status[2]._clustersDone << ", FED 1 "
+		<< status[1]._rewrites << " rewrite(s)" << std::endl ;
+      error ++ ;
+    }
+    for (unsigned int fed = 0 ; fed < fedNumber ; fed ++) {
+      if (cards[fed]->reloads_ || status[fed]._reloaded) {
+	std::cerr << "ERROR: FED " << fed << " reloaded while FED 2 does not hold the image" << std::endl ;
+	error ++ ;
+      }
+    }
+
+    // -------------------------------------------------------------------------
+    // Resume: only the clusters FED 2 misses are written, then all the FEDs are reloaded
+    cards[3]->newVersions_._vme = 0x24000207 ;
+    const u32 writtenBefore = deployer.getClustersWritten() ;
+    start = getMicroSeconds() ;
+    failed = deployer.deploy (status) ;
+    double secondPass = (getMicroSeconds() - start) / 1000000.0 ;
+    if (failed != 1 || deployer.getClustersWritten() != clusters - 20 || cards[2]->writes_[0] != 1 || cards[2]->writes_[20] != 1) {
+      std::cerr << "ERROR: resume: " << failed << " failed FED(s), " << deployer.getClustersWritten() << " clusters written" << std::endl ;
+      error ++ ;
+    }
+    for (unsigned int fed = 0 ; fed < fedNumber ; fed ++) {
+      const bool good = fed != 3 ;
+      if (!status[fed]._reloaded || cards[fed]->reloads_ != 1 || status[fed]._versionsMatch != good || status[fed]._error.empty() == !good
+	  || memcmp (&cards[fed]->card_[0], image.getCluster (0), clusters * Fed9UCfImage::CLUSTER_BYTES)) {
+	std::cerr << "ERROR: FED " << fed << ": reloaded " << status[fed]._reloaded << " versions match " << status[fed]._versionsMatch
+		  << " " << status[fed]._error << std::endl ;
+	error ++ ;
+      }
+    }
+    std::cout << "FED 3: " << status[3]._error << std::endl ;
+
+    // -------------------------------------------------------------------------
+    // A new image restarts from the first cluster. A stop requested while cluster 10 is written ends the deployment once
+    // that cluster is verified, the next deployment resumes from cluster 11.
+    std::istringstream otherFile (makeAceFile (12 * Fed9UCfImage::CLUSTER_BYTES)) ;
+    Fed9UCfImage other (otherFile) ;
+    Fed9UCfDeployer otherDeployer (other) ;
+    otherDeployer.addFed (*cards[0]).setReload (false) ;
+    cards[0]->stopDeployer_ = &otherDeployer ;
+    cards[0]->stopCluster_ = 10 ;
+    std::vector<Fed9UCfDeployStatus> otherStatus (1, status[0]) ;
+    if (otherDeployer.deploy (otherStatus) != 1 || otherStatus[0]._clustersDone != 11 || otherStatus[0]._error.find ("stopped") == std::string::npos) {
+      std::cerr << "ERROR: stop: " << otherStatus[0]._clustersDone << " clusters done, " << otherStatus[0]._error << std::endl ;
+      error ++ ;
+    }
+    if (otherDeployer.deploy (otherStatus) != 0 || otherStatus[0]._clustersDone != 12 || otherDeployer.getClustersWritten() != 1) {
+      std::cerr << "ERROR: resume after stop: " << otherStatus[0]._clustersDone << " clusters done" << std::endl ;
+      error ++ ;
+    }
+
+    const unsigned int totalClusters = writtenBefore + clusters - 20 ;
+    std::cout << fedNumber << " FEDs, " << clusters << " clusters, " << totalClusters << " clusters written and read back" << std::endl ;
+    std::cout << "Wall time for the crate " << firstPass + secondPass << " s, one FED at a time "
+	      << 2.0 * totalClusters * (busTime + cardTime) / 1000000.0 << " s" << std::endl ;
+
+    for (unsigned int fed = 0 ; fed < fedNumber ; fed ++) delete cards[fed] ;
+  }
+  catch (const std::exception &e) {
+    std::cerr << "ERROR: " << e.what() << std::endl ;
+    error ++ ;
+  }
+
+  if (error) std::cerr << error << " error(s)" << std::endl ;
+  else std::cout << "All tests passed" << std::endl ;
+
+  return error ? -1 : 0 ;
+}
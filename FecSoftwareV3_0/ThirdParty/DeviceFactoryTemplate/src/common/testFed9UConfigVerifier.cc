@@ -0,0 +1,170 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Copyright 2002 - 2003, Frederic DROUHIN - Universite de Haute-Alsace, Mulhouse-France
+*/
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Fed9UDescription.hh"
+#include "Fed9UConfigVerifier.hh"
+
+using namespace Fed9U ;
+
+/** Check that a list holds one difference on a field, at the given internal number of the FE unit, channel, APV or strip
+ */
+static int checkMismatch ( const std::vector<Fed9UConfigMismatch> &mismatches, Fed9UConfigMismatch::Field field, u32 number, u32 expected, u32 actual ) {
+  for (unsigned int i = 0 ; i < mismatches.size() ; i ++) {
+    const Fed9UConfigMismatch &m = mismatches[i] ;
+    if (m._field != field) continue ;
+    u32 found ;
+    switch (field) {
+    case Fed9UConfigMismatch::FE_UNIT_DISABLE: case Fed9UConfigMismatch::OPTO_RX_CAPACITOR: found = m._address.getFedFeUnit() ; break ;
+    case Fed9UConfigMismatch::CM_MEDIAN_OVERRIDE: found = m._address.getFedFeUnit() * APVS_PER_FEUNIT + m._address.getFeUnitApv() ; break ;
+    case Fed9UConfigMismatch::FRAME_THRESHOLD: case Fed9UConfigMismatch::ADC_S1: found = m._address.getFedChannel() ; break ;
+    case Fed9UConfigMismatch::APV_DISABLE: found = m._address.getFedApv() ; break ;
+    case Fed9UConfigMismatch::PEDESTAL: case Fed9UConfigMismatch::HIGH_THRESHOLD: case Fed9UConfigMismatch::LOW_THRESHOLD: found = m._address.getFedStrip() ; break ;
+    default: found = 0 ;
+    }
+    if (found == number && m._expected == expected && m._actual == actual) return 0 ;
+  }
+  std::cerr << "ERROR: no " << Fed9UConfigVerifier::getFieldName (field) << " difference at " << number << ": " << expected << " / " << actual << std::endl ;
+  return 1 ;
+}
+
+/** Check the number of differences found
+ */
+static int checkCount ( u32 found, u32 expected, const char *name ) {
+  if (found == expected) return 0 ;
+  std::cerr << "ERROR: " << name << ": " << found << " differences instead of " << expected << std::endl ;
+  return 1 ;
+}
+
+int main ( int argc, char **argv ) {
+
+  int error = 0 ;
+
+  try {
+    Fed9UDescription expected ;
+    Fed9UAddress addr ;
+    for (u16 channel = 0 ; channel < CHANNELS_PER_FED ; channel ++) expected.setFrameThreshold (addr.setFedChannel(channel), 100) ;
+    std::vector<Fed9UConfigMismatch> mismatches ;
+
+    // -------------------------------------------------------------------------
+    // The FED stores the frame thresholds in steps of 32: 100 is read back as 96
+    Fed9UDescription actual (expected) ;
+    for (u16 channel = 0 ; channel < CHANNELS_PER_FED ; channel ++) actual.setFrameThreshold (addr.setFedChannel(channel), 96) ;
+    error += checkCount (Fed9UConfigVerifier::compare (expected, actual, Fed9UConfigVerifier::ALL, true, mismatches), 0, "same settings") ;
+
+    // -------------------------------------------------------------------------
+    // One difference in each group of settings
+    Fed9UAddress feUnit3, feUnit7, feUnit2, channel20, channel10, apv50, strip1000, strip2000 ;
+    feUnit3.setFedFeUnit(3) ;
+    feUnit7.setFedFeUnit(7) ;
+    feUnit2.setFedFeUnit(2) ;
+    channel20.setFedChannel(20) ;
+    channel10.setFedChannel(10) ;
+    apv50.setFedApv(50) ;
+    strip1000.setFedStrip(1000) ;
+    strip2000.setFedStrip(2000) ;
+    actual.setFedId (expected.getFedId() + 1) ;
+    actual.setFedFeUnitDisable (feUnit3, !expected.getFedFeUnitDisable (feUnit3)) ;
+    actual.setOptoRxCapacitor (feUnit7, (expected.getOptoRxCapacitor (feUnit7) + 1) & 0x3) ;
+    bool disable ;
+    std::vector<u16> medians (actual.getCmMedianOverride (feUnit2, disable)) ;
+    const u16 median = medians[5] ;
+    medians[5] = 200 ;
+    actual.setCmMedianOverride (feUnit2, disable, medians) ;
+    actual.setFrameThreshold (channel20, 128) ;
+    // The ADC controls are shared by a channel pair, channel 10 is paired with channel 9
+    Fed9UAdcControls adc (expected.getAdcControls (channel10)) ;
+    adc._s1 = !adc._s1 ;
+    actual.setAdcControls (channel10, adc) ;
+    actual.setApvDisable (apv50, !expected.getApvDisable (apv50)) ;
+    Fed9UStripDescription strip (actual.getFedStrips().getStrip (strip1000)) ;
+    const i16 pedestal = strip.getPedestal() ;
+    strip.setPedestal (pedestal + 7) ;
+    actual.getFedStrips().setStrip (strip1000, strip) ;
+    // The cluster thresholds are derived from the noise
+    strip = actual.getFedStrips().getStrip (strip2000) ;
+    const Fed9UStripDescription noisyStrip (strip.getPedestal(), strip.getHighThresholdFactor(), strip.getLowThresholdFactor(), 4.0, strip.getDisable()) ;
+    actual.getFedStrips().setStrip (strip2000, noisyStrip) ;
+
+    u32 found = Fed9UConfigVerifier::compare (expected, actual, Fed9UConfigVerifier::ALL, true, mismatches) ;
+    error += checkCount (found, 11, "one difference per setting") ;
+    error += checkMismatch (mismatches, Fed9UConfigMismatch::FE_UNIT_DISABLE, 3, expected.getFedFeUnitDisable (feUnit3), actual.getFedFeUnitDisable (feUnit3)) ;
+    error += checkMismatch (mismatches, Fed9UConfigMismatch::OPTO_RX_CAPACITOR, 7, expected.getOptoRxCapacitor (feUnit7), actual.getOptoRxCapacitor (feUnit7)) ;
+    error += checkMismatch (mismatches, Fed9UConfigMismatch::CM_MEDIAN_OVERRIDE, 2 * APVS_PER_FEUNIT + 5, median, 200) ;
+    error += checkMismatch (mismatches, Fed9UConfigMismatch::FRAME_THRESHOLD, 20, 96, 128) ;
+    error += checkMismatch (mismatches, Fed9UConfigMismatch::ADC_S1, 9, !adc._s1, adc._s1) ;
+    error += checkMismatch (mismatches, Fed9UConfigMismatch::ADC_S1, 10, !adc._s1, adc._s1) ;
+    error += checkMismatch (mismatches, Fed9UConfigMismatch::APV_DISABLE, 50, expected.getApvDisable (apv50), actual.getApvDisable (apv50)) ;
+    error += checkMismatch (mismatches, Fed9UConfigMismatch::PEDESTAL, 1000, static_cast<u16>(pedestal), static_cast<u16>(pedestal + 7)) ;
+    error += checkMismatch (mismatches, Fed9UConfigMismatch::HIGH_THRESHOLD, 2000, strip.getHighThreshold(), noisyStrip.getHighThreshold()) ;
+    error += checkMismatch (mismatches, Fed9UConfigMismatch::LOW_THRESHOLD, 2000, strip.getLowThreshold(), noisyStrip.getLowThreshold()) ;
+
+    // The text output has one line per difference
+    std::ostringstream text ;
+    Fed9UConfigVerifier::print (text, mismatches) ;
+    std::istringstream lines (text.str()) ;
+    std::string line ;
+    unsigned int lineCount = 0 ;
+    while (std::getline (lines, line)) lineCount ++ ;
+    error += checkCount (lineCount, found, "lines printed") ;
+    std::ostringstream fedIdLine ;
+    fedIdLine << "The FED ID setting on the FED does not match that in the theLocalFedSettings: FED " << actual.getFedId()
+	      << ", description " << expected.getFedId() ;
+    if (text.str().find (fedIdLine.str()) == std::string::npos || text.str().find (" strip ") == std::string::npos) {
+      std::cerr << "ERROR: unexpected text output" << std::endl << text.str() ;
+      error ++ ;
+    }
+    std::cout << text.str() ;
+
+    // -------------------------------------------------------------------------
+    // Sections and ADCs off
+    mismatches.clear() ;
+    error += checkCount (Fed9UConfigVerifier::compare (expected, actual, Fed9UConfigVerifier::BACK_END, true, mismatches), 2, "back end") ;
+    mismatches.clear() ;
+    error += checkCount (Fed9UConfigVerifier::compare (expected, actual, Fed9UConfigVerifier::CM_MEDIAN_OVERRIDE, true, mismatches), 1, "median override") ;
+    mismatches.clear() ;
+    error += checkCount (Fed9UConfigVerifier::compare (expected, actual, Fed9UConfigVerifier::STRIPS, true, mismatches), 3, "strips") ;
+    mismatches.clear() ;
+    error += checkCount (Fed9UConfigVerifier::compare (expected, actual, Fed9UConfigVerifier::ALL, false, mismatches), 8, "ADCs off") ;
+
+    // The ADC of channel 10 is off when its four APVs and those of channel 9 are disabled
+    for (u16 apv = 0 ; apv < 2 ; apv ++) {
+      expected.setApvDisable (Fed9UAddress().setFedChannel(9).setChannelApv(apv), true) ;
+      expected.setApvDisable (Fed9UAddress().setFedChannel(10).setChannelApv(apv), true) ;
+      actual.setApvDisable (Fed9UAddress().setFedChannel(9).setChannelApv(apv), true) ;
+      actual.setApvDisable (Fed9UAddress().setFedChannel(10).setChannelApv(apv), true) ;
+    }
+    mismatches.clear() ;
+    error += checkCount (Fed9UConfigVerifier::compare (expected, actual, Fed9UConfigVerifier::ALL, true, mismatches), 9, "channel pair disabled") ;
+  }
+  catch (const std::exception &e) {
+    std::cerr << "ERROR: " << e.what() << std::endl ;
+    error ++ ;
+  }
+
+  if (error) std::cerr << error << " error(s)" << std::endl ;
+  else std::cout << "All tests passed" << std::endl ;
+
+  return error ? -1 : 0 ;
+}
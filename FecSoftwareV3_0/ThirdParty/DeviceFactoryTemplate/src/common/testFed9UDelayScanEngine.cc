@@ -0,0 +1,201 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Copyright 2002 - 2003, Frederic DROUHIN - Universite de Haute-Alsace, Mulhouse-France
+*/
+
+#include <stdlib.h>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Fed9UDelayScanEngine.hh"
+
+using namespace Fed9U ;
+
+/** Synthetic FED: each channel sees a tick mark of 800 ADC counts starting at its edge and lasting 75 ns. After a delay
+ * is programmed the channel moves to its new value with a time constant of 2 ms. The waits only advance a clock.
+ */
+class FakeFed: public Fed9UDelayScanTarget {
+public:
+  static const float BASELINE ;
+  static const float HEIGHT ;
+  static const float TAU ;
+
+  FakeFed ( ): time_(0), writes_(0) {
+    for (u16 channel = 0 ; channel < CHANNELS_PER_FED ; channel ++) {
+      edge_[channel] = 10 + (channel * 37 + 11) % 370 ;
+      dead_[channel] = false ;
+      start_[channel] = target_[channel] = tick (channel, 0) ;
+      set_[channel] = 0 ;
+    }
+  }
+
+  void setDelays ( const std::vector<u16> &fedChannels, const std::vector<u16> &nanoDelays ) {
+    for (unsigned int i = 0 ; i < fedChannels.size() ; i ++) {
+      const u16 channel = fedChannels[i] ;
+      start_[channel] = value (channel) ;
+      target_[channel] = tick (channel, nanoDelays[i]) ;
+      set_[channel] = time_ ;
+      delay_[channel] = nanoDelays[i] ;
+    }
+    writes_ ++ ;
+  }
+
+  void wait ( u32 microseconds ) { time_ += microseconds ; }
+
+  /** Current value of a channel
+   */
+  float value ( u16 channel ) const {
+    return target_[channel] + (start_[channel] - target_[channel]) * exp (-static_cast<float>(time_ - set_[channel]) / TAU) ;
+  }
+
+  /** Settled value of a channel at a delay, the middle of each ramp is at the edges of the tick mark
+   */
+  float tick ( u16 channel, u16 delay ) const {
+    if (dead_[channel]) return BASELINE ;
+    float rise = (static_cast<float>(delay) - edge_[channel]) / 4.0 + 0.5 ;
+    float fall = (static_cast<float>(edge_[channel] + 75) - delay) / 4.0 + 0.5 ;
+    float level = std::max (0.0f, std::min (1.0f, std::min (rise, fall))) ;
+    return BASELINE + HEIGHT * level ;
+  }
+
+  u16 edge_[CHANNELS_PER_FED] ;
+  bool dead_[CHANNELS_PER_FED] ;
+  u16 delay_[CHANNELS_PER_FED] ;
+  u64 time_ ;
+  unsigned int writes_ ;
+
+private:
+  float start_[CHANNELS_PER_FED] ;
+  float target_[CHANNELS_PER_FED] ;
+  u64 set_[CHANNELS_PER_FED] ;
+};
+
+const float FakeFed::BASELINE = 100.0 ;
+const float FakeFed::HEIGHT = 800.0 ;
+const float FakeFed::TAU = 2000.0 ;
+
+/** Reads the channels of the synthetic FEDs, each FED is only accessed from its own scan thread
+ */
+class FakeProbe: public Fed9UDelayScanProbe {
+public:
+  explicit FakeProbe ( std::vector<FakeFed*> &feds ): feds_(feds) { }
+
+  void measure ( u32 fed, const std::vector<u16> &fedChannels, std::vector<float> &values ) {
+    for (unsigned int i = 0 ; i < fedChannels.size() ; i ++) values[i] = feds_[fed]->value (fedChannels[i]) ;
+  }
+
+private:
+  std::vector<FakeFed*> &feds_ ;
+};
+
+int main ( int argc, char **argv ) {
+
+  unsigned int fedNumber = 4 ;
+  for (int i = 1 ; i < argc ; i ++) {
+    std::string param ( argv[i] ) ;
+    if ((param == "-feds") && (i+1 < argc)) {
+      fedNumber = atoi(argv[i+1]) ;
+      i ++ ;
+    }
+    else if (param == "-help") {
+      std::cerr << argv[0] << " -feds <number of FEDs>" << std::endl ;
+      return 0 ;
+    }
+  }
+  if (fedNumber < 2) fedNumber = 2 ;
+
+  int error = 0 ;
+
+  try {
+    // FED 0: a dead channel and an edge after the last coarse step, FED 1: a subset of the channels
+    std::vector<FakeFed*> feds ;
+    for (unsigned int fed = 0 ; fed < fedNumber ; fed ++) feds.push_back (new FakeFed()) ;
+    feds[0]->dead_[5] = true ;
+    feds[0]->edge_[6] = 390 ;
+    std::vector<u16> subset ;
+    for (u16 channel = 24 ; channel < 36 ; channel ++) subset.push_back (channel) ;
+
+    FakeProbe probe (feds) ;
+    Fed9UDelayScanEngine engine (probe) ;
+    for (unsigned int fed = 0 ; fed < fedNumber ; fed ++) engine.addFed (*feds[fed], fed == 1 ? subset : std::vector<u16>()) ;
+
+    std::vector<std::vector<Fed9UDelayScanResult> > results ;
+    std::vector<std::string> errors ;
+    unsigned int failed = engine.scan (results, errors) ;
+    if (failed != 1) {
+      std::cerr << "ERROR: " << failed << " FED(s) failed instead of 1" << std::endl ;
+      error ++ ;
+    }
+
+    for (unsigned int fed = 0 ; fed < fedNumber ; fed ++) {
+      if (!errors[fed].empty()) {
+	std::cerr << "ERROR: FED " << fed << ": " << errors[fed] << std::endl ;
+	error ++ ;
+      }
+      const unsigned int channels = fed == 1 ? subset.size() : CHANNELS_PER_FED ;
+      if (results[fed].size() != channels) {
+	std::cerr << "ERROR: FED " << fed << ": " << results[fed].size() << " results instead of " << channels << std::endl ;
+	error ++ ;
+	continue ;
+      }
+      for (unsigned int i = 0 ; i < results[fed].size() ; i ++) {
+	const Fed9UDelayScanResult &result = results[fed][i] ;
+	const u16 channel = result._fedChannel ;
+	if (feds[fed]->dead_[channel]) {
+	  if (result._found) {
+	    std::cerr << "ERROR: FED " << fed << " channel " << channel << ": edge found on a dead channel" << std::endl ;
+	    error ++ ;
+	  }
+	  continue ;
+	}
+	u16 optimal = feds[fed]->edge_[channel] + engine.getSamplingPoint() ;
+	while (optimal >= 400) optimal -= 25 ;
+	if (!result._found || abs (result._edge - feds[fed]->edge_[channel]) > 1 || abs (result._optimalDelay - optimal) > 1
+	    || feds[fed]->delay_[channel] != result._optimalDelay) {
+	  std::cerr << "ERROR: FED " << fed << " channel " << channel << ": edge " << result._edge << " optimal " << result._optimalDelay
+		    << " programmed " << feds[fed]->delay_[channel] << ", expected edge " << feds[fed]->edge_[channel] << " optimal " << optimal << std::endl ;
+	  error ++ ;
+	}
+      }
+    }
+
+    u64 slowest = 0 ;
+    unsigned int writes = 0 ;
+    for (unsigned int fed = 0 ; fed < fedNumber ; fed ++) {
+      slowest = std::max (slowest, feds[fed]->time_) ;
+      writes += feds[fed]->writes_ ;
+    }
+    std::cout << fedNumber << " FEDs, " << engine.getSteps() << " steps, " << writes << " delay writes, " << engine.getMeasurements()
+	      << " measurements" << std::endl ;
+    std::cout << "Settle time " << engine.getWaitTime() / 1000 << " ms in total, " << slowest / 1000 << " ms for the slowest FED, "
+	      << "instead of " << fedNumber * 400 * 500 << " ms with 400 steps of 500 ms per FED" << std::endl ;
+
+    for (unsigned int fed = 0 ; fed < fedNumber ; fed ++) delete feds[fed] ;
+  }
+  catch (const std::exception &e) {
+    std::cerr << "ERROR: " << e.what() << std::endl ;
+    error ++ ;
+  }
+
+  if (error) std::cerr << error << " error(s)" << std::endl ;
+  else std::cout << "All tests passed" << std::endl ;
+
+  return error ? -1 : 0 ;
+}
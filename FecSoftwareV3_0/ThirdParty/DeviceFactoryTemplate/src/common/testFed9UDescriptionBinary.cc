@@ -0,0 +1,203 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Copyright 2002 - 2003, Frederic DROUHIN - Universite de Haute-Alsace, Mulhouse-France
+*/
+
+#include <stdlib.h>
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "Fed9UDescription.hh"
+#include "Fed9UDescriptionBinary.hh"
+#include "Fed9UDescriptionDiff.hh"
+#include "Fed9UDescriptionException.hh"
+#include "TestTime.h"
+
+using namespace Fed9U ;
+
+/** Modify a set of settings spread over the description so that the round trip and diff cover each level
+ */
+static void modifyDescription ( Fed9UDescription &description ) {
+
+  Fed9UAddress addr ;
+  description.setFedId (description.getFedId() + 1) ;
+  description.setCrateNumber (description.getCrateNumber() + 1) ;
+  description.setName ("binaryTest") ;
+  description.setFineDelay (addr.setFedFeUnit(2).setFeUnitChannel(5), 17) ;
+  description.setAdcControls (addr.setFedFeUnit(3).setFeUnitChannel(8), Fed9UAdcControls(true,false,true,false)) ;
+  description.setApvDisable (addr.setFedFeUnit(6).setFeUnitApv(11), true) ;
+  description.setOptoRxInputOffset (addr.setFedFeUnit(7), 3) ;
+  for (u16 strip = 0 ; strip < STRIPS_PER_FED ; strip += 97) {
+    Fed9UStripDescription s = description.getFedStrips().getStrip(addr.setFedStrip(strip)) ;
+    s.setPedestal ((strip * 7) % 1000) ;
+    s.setNoise (1.5 + (strip % 10) * 0.25) ;
+    s.setDisable ((strip % 3) == 0) ;
+    description.getFedStrips().setStrip (addr, s) ;
+  }
+}
+
+/** \param -loop <number of iterations used for the timing> -file <binary file to write>
+ */
+int main ( int argc, char **argv ) {
+
+  unsigned int loop = 10 ;
+  std::string fileName = "" ;
+
+  // Find the options
+  for (int i = 1 ; i < argc ; i ++) {
+
+    std::string param ( argv[i] ) ;
+    if (param == "-loop") {
+      if (i+1 < argc) {
+	loop = atoi(argv[i+1]) ;
+	i ++ ;
+      }
+    }
+    else if (param == "-file") {
+      if (i+1 < argc) {
+	fileName = std::string(argv[i+1]) ;
+	i ++ ;
+      }
+    }
+    else if (param == "-help") {
+      std::cerr << argv[0] << std::endl ;
+      std::cerr << "  -loop <number of iterations> -file <binary file to write>" << std::endl ;
+      return 0 ;
+    }
+  }
+  if (loop == 0) loop = 1 ;
+
+  int error = 0 ;
+
+  try {
+    Fed9UDescription reference ;
+    modifyDescription (reference) ;
+
+    // Binary round trip
+    std::vector<u8> binary ;
+    unsigned long start = getMicroSeconds() ;
+    for (unsigned int i = 0 ; i < loop ; i ++) Fed9UDescriptionBinary::encode (reference, binary) ;
+    unsigned long encodeTime = (getMicroSeconds() - start) / loop ;
+
+    Fed9UDescription fromBinary ;
+    start = getMicroSeconds() ;
+    for (unsigned int i = 0 ; i < loop ; i ++) Fed9UDescriptionBinary::decode (&binary[0], binary.size(), fromBinary) ;
+    unsigned long decodeTime = (getMicroSeconds() - start) / loop ;
+
+    if (!(fromBinary == reference)) {
+      std::cerr << "ERROR: binary round trip does not reproduce the description" << std::endl ;
+      error ++ ;
+    }
+
+    // A corrupted buffer must be refused
+    std::vector<u8> corrupted (binary) ;
+    corrupted[corrupted.size()/2] ^= 0x5A ;
+    try {
+      Fed9UDescription d ;
+      Fed9UDescriptionBinary::decode (&corrupted[0], corrupted.size(), d) ;
+      std::cerr << "ERROR: corrupted binary description was accepted" << std::endl ;
+      error ++ ;
+    }
+    catch (Fed9UDescriptionException &e) { }
+
+    // ASCII streamer used by Fed9UDescription, only the writing is timed as it is not read back consistently
+    std::string ascii ;
+    start = getMicroSeconds() ;
+    for (unsigned int i = 0 ; i < loop ; i ++) {
+      std::ostringstream os ;
+      reference.saveDescription (os) ;
+      ascii = os.str() ;
+    }
+    unsigned long asciiSaveTime = (getMicroSeconds() - start) / loop ;
+
+    // The ASCII streamer writes every setting, so the decoded description must give the same text
+    std::ostringstream binaryAscii ;
+    fromBinary.saveDescription (binaryAscii) ;
+    if (binaryAscii.str() != ascii) {
+      std::cerr << "ERROR: ASCII text of the binary round trip differs from the one of the description" << std::endl ;
+      error ++ ;
+    }
+
+    // Same through the stream interface used for the files
+    std::stringstream binaryStream ;
+    Fed9UDescriptionBinary::saveDescription (reference, binaryStream) ;
+    Fed9UDescription fromStream ;
+    Fed9UDescriptionBinary::loadDescription (binaryStream, fromStream) ;
+    std::ostringstream streamAscii ;
+    fromStream.saveDescription (streamAscii) ;
+    if (!(fromStream == reference) || streamAscii.str() != ascii) {
+      std::cerr << "ERROR: binary stream round trip does not reproduce the description" << std::endl ;
+      error ++ ;
+    }
+
+    std::cout << "Binary: " << binary.size() << " bytes, encode " << encodeTime << " us, decode " << decodeTime << " us" << std::endl ;
+    std::cout << "ASCII:  " << ascii.size() << " bytes, save " << asciiSaveTime << " us" << std::endl ;
+
+
+    // Diff and patch
+    Fed9UDescription modified (reference) ;
+    Fed9UAddress addr ;
+    modified.setFineDelay (addr.setFedFeUnit(0).setFeUnitChannel(1), 3) ;
+    modified.setMedianOverride (addr.setFedFeUnit(4).setFeUnitApv(7), 321) ;
+    modified.setFedFeUnitDisable (addr.setFedFeUnit(5), true) ;
+    Fed9UStripDescription s = modified.getFedStrips().getStrip(addr.setFedStrip(1234)) ;
+    s.setPedestal (s.getPedestal() + 1) ;
+    modified.getFedStrips().setStrip (addr, s) ;
+    modified.setTestRegister (modified.getTestRegister() ^ 0x1) ;
+
+    Fed9UDescriptionDiff diff (reference, modified) ;
+    if (diff.getChangedChannels().size() != 1 || diff.getChangedApvs().size() != 1 ||
+	diff.getChangedFeUnits().size() != 1 || diff.getChangedStrips().size() != 1 || !diff.getGlobalChanged()) {
+      std::cerr << "ERROR: diff does not report the expected changes" << std::endl << diff ;
+      error ++ ;
+    }
+
+    std::vector<u8> diffBuffer ;
+    diff.encode (diffBuffer) ;
+    Fed9UDescriptionDiff decodedDiff ;
+    decodedDiff.decode (&diffBuffer[0], diffBuffer.size()) ;
+    Fed9UDescription patched (reference) ;
+    decodedDiff.apply (patched) ;
+    if (!(patched == modified)) {
+      std::cerr << "ERROR: applying the diff does not reproduce the modified description" << std::endl ;
+      error ++ ;
+    }
+    if (!Fed9UDescriptionDiff(modified, patched).empty()) {
+      std::cerr << "ERROR: diff of identical descriptions is not empty" << std::endl ;
+      error ++ ;
+    }
+    std::cout << "Diff:   " << diffBuffer.size() << " bytes" << std::endl << diff ;
+
+    if (fileName.size()) {
+      std::ofstream os (fileName.c_str(), std::ios::binary) ;
+      Fed9UDescriptionBinary::saveDescription (reference, os) ;
+    }
+  }
+  catch (std::exception &e) {
+    std::cerr << "ERROR: " << e.what() << std::endl ;
+    error ++ ;
+  }
+
+  if (error) std::cerr << error << " error(s)" << std::endl ;
+  else std::cout << "All tests passed" << std::endl ;
+
+  return error ? -1 : 0 ;
+}
@@ -0,0 +1,380 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Copyright 2002 - 2003, Frederic DROUHIN - Universite de Haute-Alsace, Mulhouse-France
+*/
+
+#include <stdlib.h>
+#include <pthread.h>
+
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "Fed9UBufferGenerator.hh"
+#include "Fed9UBufferCreatorRaw.hh"
+#include "Fed9UEventStreamLine.hh"
+#include "Fed9UEventIntegrity.hh"
+#include "Fed9UDescription.hh"
+#include "Fed9UAddress.hh"
+#include "Fed9UCrc.hh"
+#include "TestTime.h"
+
+using namespace Fed9U ;
+
+/** Set the APV address error register to "all FE units agree" and write the CRC in the DAQ trailer
+ * (the generator leaves both to 0), the buffers are in the VME order
+ */
+static void finaliseBuffer ( std::vector<u32> &buffer, bool apvAddress = true ) {
+
+  u8 *bytes = reinterpret_cast<u8 *>(&buffer[0]) ;
+  if (apvAddress) bytes[8] = 0xFF ;
+  u8 *trailer = bytes + buffer.size() * 4 - 8 ;
+  u16 crc = calculateFEDBufferCRC (bytes, buffer.size() * 4, true) ;
+  trailer[6] = crc & 0xFF ;
+  trailer[7] = crc >> 8 ;
+}
+
+/** Generate virgin raw FED buffers in FULL DEBUG mode
+ */
+static void generateEvents ( unsigned int events, std::vector<std::vector<u32> > &buffers ) {
+
+  Fed9UBufferCreatorRaw creator ;
+  Fed9UBufferGenerator generator (&creator) ;
+  std::vector<unsigned short> strips (STRIPS_PER_FED) ;
+  buffers.resize (events) ;
+  for (unsigned int e = 0 ; e < events ; e ++) {
+    for (u32 i = 0 ; i < STRIPS_PER_FED ; i ++) strips[i] = rand() % 1024 ;
+    generator.generateFed9UBuffer (strips) ;
+    buffers[e].resize (generator.getBufferSize()) ;
+    generator.getBuffer (reinterpret_cast<unsigned int*>(&buffers[e][0])) ;
+    finaliseBuffer (buffers[e]) ;
+  }
+}
+
+/** Convert a FULL DEBUG buffer into an APV ERROR buffer (3 bytes of status per FE unit, all the flags set)
+ */
+static void toApvErrorMode ( const std::vector<u32> &fullDebug, std::vector<u32> &apvError ) {
+
+  apvError.assign (fullDebug.begin(), fullDebug.begin() + 4) ;
+  reinterpret_cast<u8 *>(&apvError[0])[10] = (FED9U_HEADER_APVERROR << 4) | (reinterpret_cast<u8 *>(&apvError[0])[10] & 0xF) ;
+  apvError.insert (apvError.end(), 6, 0xFFFFFFFF) ;
+  apvError.insert (apvError.end(), fullDebug.begin() + 4 + 32, fullDebug.end()) ;
+  u8 *trailer = reinterpret_cast<u8 *>(&apvError[0]) + apvError.size() * 4 - 8 ;
+  u32 length = apvError.size() / 2 ;
+  trailer[0] = length & 0xFF ; trailer[1] = (length >> 8) & 0xFF ; trailer[2] = (length >> 16) & 0xFF ;
+  finaliseBuffer (apvError, false) ;
+}
+
+/** Clear random status bits in the FE unit header
+ */
+static void corruptStatus ( std::vector<u32> &buffer, bool fullDebug ) {
+
+  for (int n = rand() % 4 ; n >= 0 ; n --) {
+    if (fullDebug) {
+      u32 f = rand() % FEUNITS_PER_FED, bit = rand() % 72 ;
+      if (bit < 32) buffer[4 + 4 * f + 1] &= ~(1U << bit) ;
+      else if (bit < 64) buffer[4 + 4 * f] &= ~(1U << (bit - 32)) ;
+      else buffer[4 + 4 * f + 3] &= ~(1U << (bit - 64)) ;
+    }
+    else buffer[4 + rand() % 6] &= ~(1U << (rand() % 32)) ;
+  }
+  finaliseBuffer (buffer, fullDebug) ;
+}
+
+/** Compare the channel masks with the status decoded by Fed9UEventUnitStreamLine
+ */
+static int compareChannels ( std::vector<u32> &buffer, const Fed9UEventIntegrity &integrity, bool fullDebug ) {
+
+  Fed9UEventStreamLine event (&buffer[0], NULL) ;
+  for (u32 feUnit = 1 ; feUnit <= FEUNITS_PER_FED ; feUnit ++) {
+    for (u32 channel = 1 ; channel <= CHANNELS_PER_FEUNIT ; channel ++) {
+      u8 status = event.getFeUnit(feUnit).getChannelStatus(channel) ;
+      bool expected[Fed9UEventIntegrity::CHANNEL_VIOLATIONS] ;
+      if (fullDebug) {
+	expected[Fed9UEventIntegrity::APV_ERROR] = (status & 0x5) != 0x5 ;
+	expected[Fed9UEventIntegrity::APV_HEADER] = (status & 0xA) != 0xA ;
+	expected[Fed9UEventIntegrity::OUT_OF_SYNC] = (status & 0x10) != 0x10 ;
+	expected[Fed9UEventIntegrity::UNLOCKED] = (status & 0x20) != 0x20 ;
+      }
+      else {
+	expected[Fed9UEventIntegrity::APV_ERROR] = status != 0x3 ;
+	expected[Fed9UEventIntegrity::APV_HEADER] = expected[Fed9UEventIntegrity::OUT_OF_SYNC] = expected[Fed9UEventIntegrity::UNLOCKED] = false ;
+      }
+      for (u32 v = 0 ; v < Fed9UEventIntegrity::CHANNEL_VIOLATIONS ; v ++) {
+	if (integrity.getChannelError (static_cast<Fed9UEventIntegrity::ChannelViolation>(v), feUnit, channel) != expected[v]) {
+	  std::cerr << "ERROR: FE-FPGA " << feUnit << " channel " << channel << " status 0x" << std::hex << (int)status << std::dec
+		    << " violation " << v << " differs from getChannelStatus" << std::endl ;
+	  return 1 ;
+	}
+      }
+    }
+  }
+  return 0 ;
+}
+
+/** Check an event with one error and compare the event errors
+ */
+static int checkError ( const Fed9UEventIntegrityChecker &checker, std::vector<u32> buffer, u32 words, u32 expected, const std::string &name ) {
+
+  Fed9UEventIntegrity integrity ;
+  if (checker.check (&buffer[0], words, integrity) || (integrity._errors != expected)) {
+    std::cerr << "ERROR: " << name << ": errors 0x" << std::hex << integrity._errors << " instead of 0x" << expected << std::dec << std::endl ;
+    return 1 ;
+  }
+  return 0 ;
+}
+
+/** Statistics of a part of the events, filled by a thread
+ */
+struct StatisticsThread {
+  const Fed9UEventIntegrityChecker *checker ;
+  std::vector<std::vector<u32> > *buffers ;
+  unsigned int first, last ;
+  Fed9UEventErrorStatistics statistics ;
+  pthread_t thread ;
+} ;
+
+static void *fillStatistics ( void *arg ) {
+
+  StatisticsThread *context = reinterpret_cast<StatisticsThread *>(arg) ;
+  Fed9UEventIntegrity integrity ;
+  for (unsigned int e = context->first ; e < context->last ; e ++) {
+    context->checker->check (&(*context->buffers)[e][0], (*context->buffers)[e].size(), integrity) ;
+    context->statistics.add (integrity) ;
+  }
+  return NULL ;
+}
+
+/** \param -events <number of events>
+ */
+int main ( int argc, char **argv ) {
+
+  unsigned int events = 400 ;
+  for (int i = 1 ; i < argc ; i ++) {
+    std::string param ( argv[i] ) ;
+    if ((param == "-events") && (i+1 < argc)) {
+      events = atoi(argv[i+1]) ;
+      i ++ ;
+    }
+    else if (param == "-help") {
+      std::cerr << argv[0] << " -events <number of events>" << std::endl ;
+      return 0 ;
+    }
+  }
+
+  int error = 0 ;
+
+  try {
+    srand (1234) ;
+    std::vector<std::vector<u32> > buffers ;
+    generateEvents (events, buffers) ;
+    Fed9UEventIntegrityChecker checker ;
+    Fed9UEventIntegrity integrity ;
+
+    // -------------------------------------------------------------------------
+    // Events without error, accepted by the current checker too
+    Fed9UEventStreamLine clean (&buffers[0][0], NULL) ;
+    std::ofstream null ("/dev/null") ;
+    std::streambuf *coutBuffer = std::cout.rdbuf (null.rdbuf()) ;
+    clean.checkEvent() ;
+    std::cout.rdbuf (coutBuffer) ;
+    if (!clean.checkIntegrity (integrity) || !checker.check (&buffers[0][0], buffers[0].size(), integrity)) {
+      std::cerr << "ERROR: event without error rejected, errors 0x" << std::hex << integrity._errors << std::dec << std::endl ;
+      error ++ ;
+    }
+
+    // -------------------------------------------------------------------------
+    // Each error alone
+    std::vector<u32> buffer = buffers[0] ;
+    u8 *bytes = reinterpret_cast<u8 *>(&buffer[0]) ;
+    u32 words = buffer.size() ;
+
+    buffer[words / 2] ^= 0x1 ;
+    error += checkError (checker, buffer, words, Fed9UEventIntegrity::ERROR_CRC, "payload modified") ;
+    buffer = buffers[0] ;
+    bytes = reinterpret_cast<u8 *>(&buffer[0]) ;
+
+    bytes[words * 4 - 8] ++ ; finaliseBuffer (buffer) ;
+    error += checkError (checker, buffer, words, Fed9UEventIntegrity::ERROR_LENGTH, "DAQ length") ;
+    buffer = buffers[0] ;
+    bytes = reinterpret_cast<u8 *>(&buffer[0]) ;
+
+    bytes[10] = (bytes[10] & 0xF0) | 0x5 ; finaliseBuffer (buffer) ;
+    error += checkError (checker, buffer, words, Fed9UEventIntegrity::ERROR_EVENT_TYPE, "event type") ;
+    buffer = buffers[0] ;
+    bytes = reinterpret_cast<u8 *>(&buffer[0]) ;
+
+    error += checkError (checker, buffer, words - 2, Fed9UEventIntegrity::ERROR_TRUNCATED, "truncated buffer") ;
+    error += checkError (checker, buffer, 3, Fed9UEventIntegrity::ERROR_TRUNCATED, "header only") ;
+
+    bytes[words * 4 - 5] = 0x50 ; finaliseBuffer (buffer) ;
+    error += checkError (checker, buffer, words, Fed9UEventIntegrity::ERROR_TRAILER, "trailer marker") ;
+    buffer = buffers[0] ;
+    bytes = reinterpret_cast<u8 *>(&buffer[0]) ;
+
+    // FE-FPGA 3 is at position 5: overflow, APV address error on FE-FPGA 8, length of FE-FPGA 3 in the header
+    bytes[14] = 0x20 ; bytes[8] = 0xFE ; buffer[4 + 4 * 5 + 2] += 0x10000 ; finaliseBuffer (buffer, false) ;
+    if (checker.check (&buffer[0], words, integrity) || (integrity._errors != Fed9UEventIntegrity::ERROR_FE_UNIT) ||
+	!integrity.getFeUnitError (Fed9UEventIntegrity::FE_OVERFLOW, 3) || !integrity.getFeUnitError (Fed9UEventIntegrity::APV_ADDRESS, 8) ||
+	!integrity.getFeUnitError (Fed9UEventIntegrity::FE_LENGTH, 3) || integrity.getFeUnitError (Fed9UEventIntegrity::FE_LENGTH, 4)) {
+      std::cerr << "ERROR: FE unit errors not found" << std::endl ;
+      error ++ ;
+    }
+    buffer = buffers[0] ;
+    bytes = reinterpret_cast<u8 *>(&buffer[0]) ;
+
+    // Unlocked channel 5 of FE-FPGA 3 (status bit 6 * 4 + 5) and a CRC error: both reported, the current checker stops at the CRC
+    buffer[4 + 4 * 5 + 1] &= ~(1U << 29) ;
+    error += checkError (checker, buffer, words, Fed9UEventIntegrity::ERROR_CRC | Fed9UEventIntegrity::ERROR_CHANNEL, "unlocked channel and CRC") ;
+    checker.check (&buffer[0], words, integrity) ;
+    if (!integrity.getChannelError (Fed9UEventIntegrity::UNLOCKED, 3, 5) || integrity.getChannelError (Fed9UEventIntegrity::OUT_OF_SYNC, 3, 5)) {
+      std::cerr << "ERROR: unlocked channel 5 of FE-FPGA 3 not found" << std::endl ;
+      error ++ ;
+    }
+
+    // Channels disabled in the description are not checked
+    Fed9UDescription description ;
+    description.setDaqMode (FED9U_MODE_VIRGIN_RAW) ;
+    finaliseBuffer (buffer) ;
+    error += checkError (Fed9UEventIntegrityChecker (&description), buffer, words, Fed9UEventIntegrity::ERROR_CHANNEL, "unlocked channel enabled in the description") ;
+    Fed9UAddress addr ;
+    description.setApvDisable (addr.setFedFeUnit(5).setFeUnitChannel(4).setChannelApv(0), true) ;
+    Fed9UEventIntegrityChecker descriptionChecker (&description) ;
+    if (!descriptionChecker.check (&buffer[0], words, integrity)) {
+      std::cerr << "ERROR: error on a channel disabled in the description, errors 0x" << std::hex << integrity._errors << std::dec << std::endl ;
+      error ++ ;
+    }
+
+    // -------------------------------------------------------------------------
+    // Random status errors compared with Fed9UEventUnitStreamLine in both header formats
+    for (unsigned int e = 0 ; (e < events) && !error ; e ++) {
+      std::vector<u32> apvError ;
+      toApvErrorMode (buffers[e], apvError) ;
+      if (!checker.check (&apvError[0], apvError.size(), integrity)) {
+	std::cerr << "ERROR: APV ERROR event without error rejected, errors 0x" << std::hex << integrity._errors << std::dec << std::endl ;
+	error ++ ;
+      }
+      buffer = buffers[e] ;
+      corruptStatus (buffer, true) ;
+      corruptStatus (apvError, false) ;
+      checker.check (&buffer[0], buffer.size(), integrity) ;
+      error += compareChannels (buffer, integrity, true) ;
+      checker.check (&apvError[0], apvError.size(), integrity) ;
+      error += compareChannels (apvError, integrity, false) ;
+    }
+
+    // -------------------------------------------------------------------------
+    // Statistics filled by threads and merged are the same as in one thread
+    std::vector<std::vector<u32> > mixed (buffers) ;
+    for (unsigned int e = 0 ; e < events ; e += 3) corruptStatus (mixed[e], true) ;
+    for (unsigned int e = 1 ; e < events ; e += 7) mixed[e][mixed[e].size() / 2] ^= 0x100 ;
+
+    Fed9UEventErrorStatistics reference ;
+    for (unsigned int e = 0 ; e < events ; e ++) {
+      checker.check (&mixed[e][0], mixed[e].size(), integrity) ;
+      reference.add (integrity) ;
+    }
+    const unsigned int threads = 4 ;
+    StatisticsThread contexts[threads] ;
+    for (unsigned int t = 0 ; t < threads ; t ++) {
+      contexts[t].checker = &checker ;
+      contexts[t].buffers = &mixed ;
+      contexts[t].first = events * t / threads ;
+      contexts[t].last = events * (t + 1) / threads ;
+      pthread_create (&contexts[t].thread, NULL, fillStatistics, &contexts[t]) ;
+    }
+    Fed9UEventErrorStatistics merged ;
+    for (unsigned int t = 0 ; t < threads ; t ++) {
+      pthread_join (contexts[t].thread, NULL) ;
+      merged.merge (contexts[t].statistics) ;
+    }
+    bool same = (merged.getEvents() == events) && (merged.getEventErrors() == reference.getEventErrors()) &&
+      (merged.getEventErrors (Fed9UEventIntegrity::ERROR_CRC) == reference.getEventErrors (Fed9UEventIntegrity::ERROR_CRC)) ;
+    for (u32 v = 0 ; v < Fed9UEventIntegrity::CHANNEL_VIOLATIONS ; v ++) {
+      Fed9UEventIntegrity::ChannelViolation violation = static_cast<Fed9UEventIntegrity::ChannelViolation>(v) ;
+      for (u32 feUnit = 1 ; feUnit <= FEUNITS_PER_FED ; feUnit ++) {
+	same = same && (merged.getFeUnitChannelErrors (violation, feUnit) == reference.getFeUnitChannelErrors (violation, feUnit)) ;
+	for (u32 channel = 1 ; channel <= CHANNELS_PER_FEUNIT ; channel ++)
+	  same = same && (merged.getChannelErrors (violation, feUnit, channel) == reference.getChannelErrors (violation, feUnit, channel)) ;
+      }
+    }
+    if (!same || (reference.getEventErrors (Fed9UEventIntegrity::ERROR_CRC) != (events + 5) / 7)) {
+      std::cerr << "ERROR: statistics of the threads differ from the statistics of one thread" << std::endl ;
+      error ++ ;
+    }
+    std::cout << reference.getEventErrors() << " events with errors out of " << reference.getEvents()
+	      << ", events with unlocked channels on FE-FPGA 3: " << reference.getFeUnitChannelErrors (Fed9UEventIntegrity::UNLOCKED, 3) << std::endl ;
+
+    // -------------------------------------------------------------------------
+    // Benchmark against checkEvent and checkChannelStatuses
+    std::vector<Fed9UEventStreamLine *> streamLines ;
+    for (unsigned int e = 0 ; e < events ; e ++) streamLines.push_back (new Fed9UEventStreamLine (&mixed[e][0], &description)) ;
+    Fed9UEventIntegrityChecker benchmarkChecker (&description) ;
+    Fed9UEventErrorStatistics statistics ;
+
+    coutBuffer = std::cout.rdbuf (null.rdbuf()) ;
+    unsigned int exceptions = 0 ;
+    unsigned long start = getMicroSeconds() ;
+    for (unsigned int e = 0 ; e < events ; e ++) {
+      try { streamLines[e]->checkEvent() ; streamLines[e]->checkChannelStatuses() ; }
+      catch (std::exception &) { exceptions ++ ; }
+    }
+    unsigned long currentTime = getMicroSeconds() - start ;
+    start = getMicroSeconds() ;
+    for (unsigned int e = 0 ; e < events ; e ++) {
+      try { streamLines[e]->checkChannelStatuses() ; }
+      catch (std::exception &) { }
+    }
+    unsigned long currentStatusTime = getMicroSeconds() - start ;
+    std::cout.rdbuf (coutBuffer) ;
+
+    start = getMicroSeconds() ;
+    for (unsigned int e = 0 ; e < events ; e ++) {
+      benchmarkChecker.check (&mixed[e][0], mixed[e].size(), integrity) ;
+      statistics.add (integrity) ;
+    }
+    unsigned long checkerTime = getMicroSeconds() - start ;
+    unsigned int rejected = statistics.getEventErrors() ;
+    Fed9UEventIntegrityChecker statusChecker (&description, false) ;
+    start = getMicroSeconds() ;
+    for (unsigned int e = 0 ; e < events ; e ++) {
+      statusChecker.check (&mixed[e][0], mixed[e].size(), integrity) ;
+      statistics.add (integrity) ;
+    }
+    unsigned long checkerStatusTime = getMicroSeconds() - start ;
+    for (unsigned int e = 0 ; e < events ; e ++) delete streamLines[e] ;
+
+    std::cout << events << " events of " << buffers[0].size() * 4 << " bytes, " << exceptions << " rejected by checkEvent + checkChannelStatuses, "
+	      << rejected << " by Fed9UEventIntegrityChecker" << std::endl ;
+    std::cout << "checkEvent + checkChannelStatuses: " << currentTime << " us, Fed9UEventIntegrityChecker: " << checkerTime << " us" << std::endl ;
+    std::cout << "checkChannelStatuses: " << currentStatusTime << " us, Fed9UEventIntegrityChecker without CRC: " << checkerStatusTime << " us" << std::endl ;
+    if ((checkerTime >= currentTime) || (checkerStatusTime >= currentStatusTime)) {
+      std::cerr << "ERROR: Fed9UEventIntegrityChecker is not faster than the current checks" << std::endl ;
+      error ++ ;
+    }
+  }
+  catch (std::exception &e) {
+    std::cerr << "ERROR: " << e.what() << std::endl ;
+    error ++ ;
+  }
+
+  if (error) std::cerr << error << " error(s)" << std::endl ;
+  else std::cout << "All tests passed" << std::endl ;
+
+  return error ? -1 : 0 ;
+}
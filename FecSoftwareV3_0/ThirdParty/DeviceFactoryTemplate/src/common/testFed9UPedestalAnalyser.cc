@@ -0,0 +1,223 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Copyright 2002 - 2003, Frederic DROUHIN - Universite de Haute-Alsace, Mulhouse-France
+*/
+
+#include <stdlib.h>
+#include <math.h>
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "Fed9UBufferGenerator.hh"
+#include "Fed9UBufferCreatorRaw.hh"
+#include "Fed9UPedestalAnalyser.hh"
+#include "Fed9UStrips.hh"
+#include "TestTime.h"
+
+using namespace Fed9U ;
+
+/** Gaussian random number using the Box-Muller method
+ */
+static double gauss ( double sigma ) {
+  double u1 = (rand() + 1.0) / (RAND_MAX + 2.0) ;
+  double u2 = (rand() + 1.0) / (RAND_MAX + 2.0) ;
+  return sigma * sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2) ;
+}
+
+static const float NOISE = 4.0 ;
+static const u32 DEAD_STRIP = 1000 ;
+static const u32 NOISY_STRIP = 5000 ;
+
+/** Generate a set of virgin raw FED buffers with known pedestals, noise and a common mode per APV
+ */
+static void generateEvents ( unsigned int events, std::vector<i16> &pedestals, std::vector<std::vector<u32> > &buffers ) {
+
+  srand (4321) ;
+  pedestals.resize (STRIPS_PER_FED) ;
+  for (u32 i = 0 ; i < STRIPS_PER_FED ; i ++) pedestals[i] = 200 + rand() % 300 ;
+
+  Fed9UBufferCreatorRaw creator ;
+  Fed9UBufferGenerator generator (&creator) ;
+  std::vector<unsigned short> strips (STRIPS_PER_FED) ;
+  buffers.resize (events) ;
+  for (unsigned int e = 0 ; e < events ; e ++) {
+    for (u32 apv = 0 ; apv < APVS_PER_FED ; apv ++) {
+      double commonMode = gauss (20.0) ;
+      for (u32 i = apv * STRIPS_PER_APV ; i < (apv + 1) * STRIPS_PER_APV ; i ++) {
+	double noise = (i == DEAD_STRIP) ? 0.0 : (i == NOISY_STRIP) ? 10.0 * NOISE : NOISE ;
+	double value = pedestals[i] + commonMode + gauss (noise) ;
+	strips[i] = value < 0.0 ? 0 : value > 1023.0 ? 1023 : static_cast<unsigned short>(value + 0.5) ;
+      }
+    }
+    generator.generateFed9UBuffer (strips) ;
+    buffers[e].resize (generator.getBufferSize()) ;
+    generator.getBuffer (reinterpret_cast<unsigned int*>(&buffers[e][0])) ;
+  }
+}
+
+/** \param -events <number of events> -threads <number of threads> -file <binary event file to read instead of generating events>
+ */
+int main ( int argc, char **argv ) {
+
+  unsigned int events = 500 ;
+  unsigned int threads = 0 ;
+  std::string fileName = "" ;
+
+  // Find the options
+  for (int i = 1 ; i < argc ; i ++) {
+    std::string param ( argv[i] ) ;
+    if (param == "-events") {
+      if (i+1 < argc) {
+	events = atoi(argv[i+1]) ;
+	i ++ ;
+      }
+    }
+    else if (param == "-threads") {
+      if (i+1 < argc) {
+	threads = atoi(argv[i+1]) ;
+	i ++ ;
+      }
+    }
+    else if (param == "-file") {
+      if (i+1 < argc) {
+	fileName = std::string(argv[i+1]) ;
+	i ++ ;
+      }
+    }
+    else if (param == "-help") {
+      std::cerr << argv[0] << std::endl ;
+      std::cerr << "  -events <number of events> -threads <number of threads> -file <binary event file>" << std::endl ;
+      return 0 ;
+    }
+  }
+
+  int error = 0 ;
+
+  try {
+    // Analyse a file of recorded events
+    if (fileName.size()) {
+      std::ifstream is (fileName.c_str(), std::ios::binary) ;
+      Fed9UPedestalAnalyser analyser (threads) ;
+      unsigned long start = getMicroSeconds() ;
+      u32 read = analyser.addEvents (is) ;
+      Fed9UStrips strips ;
+      u32 disabled = analyser.writeStrips (strips) ;
+      unsigned long time = getMicroSeconds() - start ;
+      std::cout << read << " events analysed with " << analyser.getThreads() << " threads in " << time << " us, "
+		<< disabled << " strips disabled" << std::endl ;
+      return 0 ;
+    }
+
+    std::vector<i16> pedestals ;
+    std::vector<std::vector<u32> > buffers ;
+    generateEvents (events, pedestals, buffers) ;
+
+    // Reference with a single thread
+    Fed9UPedestalAnalyser reference (1) ;
+    unsigned long start = getMicroSeconds() ;
+    for (unsigned int e = 0 ; e < events ; e ++) reference.addEvent (&buffers[e][0], buffers[e].size()) ;
+    reference.flush() ;
+    unsigned long singleTime = getMicroSeconds() - start ;
+
+    Fed9UPedestalAnalyser analyser (threads) ;
+    start = getMicroSeconds() ;
+    for (unsigned int e = 0 ; e < events ; e ++) analyser.addEvent (&buffers[e][0], buffers[e].size()) ;
+    Fed9UStrips strips ;
+    u32 disabled = analyser.writeStrips (strips) ;
+    unsigned long threadTime = getMicroSeconds() - start ;
+
+    if (analyser.getEvents() != events) {
+      std::cerr << "ERROR: " << analyser.getEvents() << " events analysed instead of " << events << std::endl ;
+      error ++ ;
+    }
+
+    // Threads must give exactly the same result as the single thread
+    Fed9UAddress addr ;
+    double noiseSum = 0.0 ;
+    for (u32 i = 0 ; i < STRIPS_PER_FED ; i ++) {
+      if (analyser.getPedestal(i) != reference.getPedestal(i) || analyser.getNoise(i) != reference.getNoise(i)) {
+	std::cerr << "ERROR: strip " << i << " differs between the threaded and single thread analysis" << std::endl ;
+	error ++ ;
+	break ;
+      }
+      const Fed9UStripDescription &strip = strips.getStrip(addr.setFedStrip(i)) ;
+      // The pedestal includes the mean common mode, which is small over many events
+      if (fabs(strip.getPedestal() - pedestals[i]) > 5) {
+	std::cerr << "ERROR: strip " << i << " pedestal " << strip.getPedestal() << " expected " << pedestals[i] << std::endl ;
+	error ++ ;
+	break ;
+      }
+      if (i != DEAD_STRIP && i != NOISY_STRIP) {
+	noiseSum += analyser.getNoise(i) ;
+	if (strip.getDisable()) {
+	  std::cerr << "ERROR: strip " << i << " disabled with noise " << analyser.getNoise(i) << std::endl ;
+	  error ++ ;
+	}
+      }
+    }
+    double meanNoise = noiseSum / (STRIPS_PER_FED - 2) ;
+    if (fabs(meanNoise - NOISE) > 0.2 * NOISE) {
+      std::cerr << "ERROR: mean common mode subtracted noise " << meanNoise << " expected " << NOISE << std::endl ;
+      error ++ ;
+    }
+    if (!strips.getStrip(addr.setFedStrip(DEAD_STRIP)).getDisable() || !strips.getStrip(addr.setFedStrip(NOISY_STRIP)).getDisable()) {
+      std::cerr << "ERROR: dead or noisy strip not disabled" << std::endl ;
+      error ++ ;
+    }
+
+    // Same events read from a stream of binary records, with batches that do not divide the number of events
+    std::stringstream stream ;
+    for (unsigned int e = 0 ; e < events ; e ++) {
+      u8 fileType = 0 ;
+      u32 size = buffers[e].size() * 4 ;
+      stream.write (reinterpret_cast<char*>(&fileType), 1) ;
+      stream.write (reinterpret_cast<char*>(&size), 4) ;
+      stream.write (reinterpret_cast<char*>(&buffers[e][0]), size) ;
+    }
+    Fed9UPedestalAnalyser streamAnalyser (threads, 7) ;
+    u32 read = streamAnalyser.addEvents (stream) ;
+    streamAnalyser.flush() ;
+    if (read != events || streamAnalyser.getEvents() != events) {
+      std::cerr << "ERROR: " << read << " events read and " << streamAnalyser.getEvents() << " analysed from the stream instead of " << events << std::endl ;
+      error ++ ;
+    }
+    for (u32 i = 0 ; i < STRIPS_PER_FED ; i ++) {
+      if (streamAnalyser.getPedestal(i) != reference.getPedestal(i) || streamAnalyser.getNoise(i) != reference.getNoise(i)) {
+	std::cerr << "ERROR: strip " << i << " differs between the stream and the buffer analysis" << std::endl ;
+	error ++ ;
+	break ;
+      }
+    }
+
+    std::cout << "Mean noise " << meanNoise << ", raw noise of strip 0 " << analyser.getRawNoise(0) << ", " << disabled << " strips disabled" << std::endl ;
+    std::cout << "1 thread:  " << events * 1000000.0 / singleTime << " events/s" << std::endl ;
+    std::cout << analyser.getThreads() << " threads: " << events * 1000000.0 / threadTime << " events/s" << std::endl ;
+  }
+  catch (std::exception &e) {
+    std::cerr << "ERROR: " << e.what() << std::endl ;
+    error ++ ;
+  }
+
+  if (error) std::cerr << error << " error(s)" << std::endl ;
+  else std::cout << "All tests passed" << std::endl ;
+
+  return error ? -1 : 0 ;
+}
@@ -0,0 +1,200 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Copyright 2002 - 2003, Frederic DROUHIN - Universite de Haute-Alsace, Mulhouse-France
+*/
+
+#include <stdlib.h>
+
+#include <iostream>
+#include <vector>
+
+#include "Fed9UDescription.hh"
+#include "Fed9UEvent.hh"
+#include "Fed9UBufferGenerator.hh"
+#include "Fed9UBufferCreatorRaw.hh"
+#include "Fed9USiStripReordering.hh"
+#include "TestTime.h"
+
+using namespace Fed9U ;
+
+/** Check the permutation tables against the original algorithms for every index
+ */
+static int checkTables ( ) {
+
+  int error = 0 ;
+  Fed9USiStripReordering reordering ;
+
+  std::vector<unsigned short> identity ;
+  for (unsigned short i = 0 ; i < Fed9USiStripReordering::NUMBER_OF_APV_STRIPS ; i ++) identity.push_back(i) ;
+
+  std::vector<unsigned short> reordered, disordered ;
+  reordering.reOrderingAlgorithm (identity, reordered) ;
+  reordering.disOrderingAlgorithm (identity, disordered) ;
+  for (unsigned short i = 0 ; i < Fed9USiStripReordering::NUMBER_OF_APV_STRIPS ; i ++) {
+    if (Fed9USiStripReordering::APV_REORDER_TABLE[i] != reordered[i]) {
+      std::cerr << "ERROR: APV re-ordering table differs at index " << i << std::endl ;
+      error ++ ;
+    }
+    if (Fed9USiStripReordering::APV_DISORDER_TABLE[i] != disordered[i]) {
+      std::cerr << "ERROR: APV dis-ordering table differs at index " << i << std::endl ;
+      error ++ ;
+    }
+  }
+
+  // Channel level, the original algorithm applied to each APV with the interleaving done by hand
+  u16 physical[Fed9USiStripReordering::NUMBER_OF_CHANNEL_SAMPLES], raw[Fed9USiStripReordering::NUMBER_OF_CHANNEL_SAMPLES] ;
+  std::vector<unsigned short> apv[2], apvRaw[2] ;
+  for (unsigned short i = 0 ; i < Fed9USiStripReordering::NUMBER_OF_CHANNEL_SAMPLES ; i ++) {
+    physical[i] = 1000 + i ;
+    apv[i / Fed9USiStripReordering::NUMBER_OF_APV_STRIPS].push_back(physical[i]) ;
+  }
+  reordering.disOrderingAlgorithm (apv[0], apvRaw[0]) ;
+  reordering.disOrderingAlgorithm (apv[1], apvRaw[1]) ;
+
+  Fed9USiStripReordering::disOrderChannel (physical, raw) ;
+  for (unsigned short i = 0 ; i < Fed9USiStripReordering::NUMBER_OF_CHANNEL_SAMPLES ; i ++) {
+    if (raw[i] != apvRaw[i % 2][i / 2]) {
+      std::cerr << "ERROR: channel dis-ordering differs at sample " << i << std::endl ;
+      error ++ ;
+    }
+  }
+
+  u16 back[Fed9USiStripReordering::NUMBER_OF_CHANNEL_SAMPLES] ;
+  Fed9USiStripReordering::reOrderChannel (raw, back) ;
+  std::vector<unsigned short> apvBack[2] ;
+  reordering.reOrderingAlgorithm (apvRaw[0], apvBack[0]) ;
+  reordering.reOrderingAlgorithm (apvRaw[1], apvBack[1]) ;
+  for (unsigned short i = 0 ; i < Fed9USiStripReordering::NUMBER_OF_CHANNEL_SAMPLES ; i ++) {
+    if (back[i] != physical[i] || back[i] != apvBack[i / Fed9USiStripReordering::NUMBER_OF_APV_STRIPS][i % Fed9USiStripReordering::NUMBER_OF_APV_STRIPS]) {
+      std::cerr << "ERROR: channel re-ordering differs at strip " << i << std::endl ;
+      error ++ ;
+    }
+  }
+
+  // In place variants
+  Fed9USiStripReordering::disOrderChannel (back) ;
+  Fed9USiStripReordering::reOrderChannel (back) ;
+  for (unsigned short i = 0 ; i < Fed9USiStripReordering::NUMBER_OF_CHANNEL_SAMPLES ; i ++) {
+    if (back[i] != physical[i]) {
+      std::cerr << "ERROR: in place re-ordering differs at strip " << i << std::endl ;
+      error ++ ;
+    }
+  }
+
+  return error ;
+}
+
+/** \param -loop <number of events to time>
+ */
+int main ( int argc, char **argv ) {
+
+  unsigned int loop = 100 ;
+
+  // Find the options
+  for (int i = 1 ; i < argc ; i ++) {
+    std::string param ( argv[i] ) ;
+    if (param == "-loop") {
+      if (i+1 < argc) {
+	loop = atoi(argv[i+1]) ;
+	i ++ ;
+      }
+    }
+    else if (param == "-help") {
+      std::cerr << argv[0] << std::endl ;
+      std::cerr << "  -loop <number of events to time>" << std::endl ;
+      return 0 ;
+    }
+  }
+  if (loop == 0) loop = 1 ;
+
+  int error = 0 ;
+
+  try {
+    error += checkTables() ;
+
+    // Virgin raw event built from known strip data
+    std::vector<unsigned short> strips (STRIPS_PER_FED) ;
+    std::vector<i16> pedestals (STRIPS_PER_FED) ;
+    srand (12345) ;
+    for (u32 i = 0 ; i < STRIPS_PER_FED ; i ++) {
+      pedestals[i] = 100 + rand() % 400 ;
+      strips[i] = pedestals[i] + rand() % 200 ;
+    }
+
+    Fed9UBufferCreatorRaw creator ;
+    Fed9UBufferGenerator generator (&creator) ;
+    generator.generateFed9UBuffer (strips) ;
+    std::vector<u32> buffer (generator.getBufferSize()) ;
+    generator.getBuffer (reinterpret_cast<unsigned int*>(&buffer[0])) ;
+
+    Fed9UDescription description ;
+    Fed9UEvent event (&buffer[0], &description, buffer.size()) ;
+
+    std::vector<i16> result (STRIPS_PER_FED) ;
+    u16 channels = Fed9USiStripReordering::reOrderEvent (event, &pedestals[0], &result[0]) ;
+    if (channels != CHANNELS_PER_FED) {
+      std::cerr << "ERROR: " << channels << " channels unpacked instead of " << CHANNELS_PER_FED << std::endl ;
+      error ++ ;
+    }
+    for (u32 i = 0 ; i < STRIPS_PER_FED ; i ++) {
+      if (result[i] != static_cast<i16>(strips[i] - pedestals[i])) {
+	std::cerr << "ERROR: strip " << i << " is " << result[i] << " expected " << strips[i] - pedestals[i] << std::endl ;
+	error ++ ;
+	break ;
+      }
+    }
+
+    // Timing against the per channel sample access and vector based re-ordering
+    Fed9USiStripReordering reordering ;
+    unsigned long start = getMicroSeconds() ;
+    for (unsigned int l = 0 ; l < loop ; l ++) {
+      for (u16 fe = 0 ; fe < FEUNITS_PER_FED ; fe ++) {
+	for (u16 ch = 0 ; ch < CHANNELS_PER_FEUNIT ; ch ++) {
+	  std::vector<u16> samples = event.channel(fe, ch).getSamples() ;
+	  std::vector<unsigned short> apv[2], fedOrder[2] ;
+	  for (u16 i = 0 ; i < samples.size() ; i ++) apv[i % 2].push_back(samples[i]) ;
+	  reordering.reOrderingAlgorithm (apv[0], fedOrder[0]) ;
+	  reordering.reOrderingAlgorithm (apv[1], fedOrder[1]) ;
+	  u32 first = (fe * CHANNELS_PER_FEUNIT + ch) * Fed9USiStripReordering::NUMBER_OF_CHANNEL_SAMPLES ;
+	  for (u16 i = 0 ; i < Fed9USiStripReordering::NUMBER_OF_CHANNEL_SAMPLES ; i ++) {
+	    result[first + i] = fedOrder[i / Fed9USiStripReordering::NUMBER_OF_APV_STRIPS][i % Fed9USiStripReordering::NUMBER_OF_APV_STRIPS] - pedestals[first + i] ;
+	  }
+	}
+      }
+    }
+    unsigned long vectorTime = (getMicroSeconds() - start) / loop ;
+
+    start = getMicroSeconds() ;
+    for (unsigned int l = 0 ; l < loop ; l ++) {
+      Fed9USiStripReordering::reOrderEvent (event, &pedestals[0], &result[0]) ;
+    }
+    unsigned long tableTime = (getMicroSeconds() - start) / loop ;
+
+    std::cout << "Per channel vectors: " << vectorTime << " us/event" << std::endl ;
+    std::cout << "Fused table pass:    " << tableTime << " us/event" << std::endl ;
+  }
+  catch (std::exception &e) {
+    std::cerr << "ERROR: " << e.what() << std::endl ;
+    error ++ ;
+  }
+
+  if (error) std::cerr << error << " error(s)" << std::endl ;
+  else std::cout << "All tests passed" << std::endl ;
+
+  return error ? -1 : 0 ;
+}
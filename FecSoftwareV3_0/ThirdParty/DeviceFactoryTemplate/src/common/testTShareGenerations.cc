@@ -0,0 +1,328 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Copyright 2002 - 2003, Frederic DROUHIN - Universite de Haute-Alsace, Mulhouse-France
+*/
+
+#include <sys/wait.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "TShare.h"
+#include "TestTime.h"
+
+/** Size of one generation in words
+ */
+#define GENERATIONWORDS 16384
+
+/** Processes reading during the test
+ */
+#define NREADERS 4
+
+/** Value of a word of a generation
+ */
+static inline unsigned int patternWord ( unsigned int version, unsigned int i ) {
+  return (version * 2654435761U) ^ (i * 40503U) ;
+}
+
+/** Fill a generation: version, number of words, words
+ */
+static unsigned int fillGeneration ( unsigned int *buffer, unsigned int version ) {
+  unsigned int nWords = 1024 + (version * 7919) % (GENERATIONWORDS - 1024 - 2) ;
+  buffer[0] = version ;
+  buffer[1] = nWords ;
+  for (unsigned int i = 0 ; i < nWords ; i ++) buffer[2+i] = patternWord (version, i) ;
+  return (nWords + 2) * sizeof(unsigned int) ;
+}
+
+/** Check a copy of a generation
+ * \return false if the generation is not consistent
+ */
+static bool checkGeneration ( unsigned int *buffer, unsigned int length ) {
+  if (length == 0) return true ; // nothing published
+  if (length < 2*sizeof(unsigned int)) return false ;
+  unsigned int version = buffer[0] ;
+  unsigned int nWords = buffer[1] ;
+  if (length != (nWords + 2) * sizeof(unsigned int)) return false ;
+  for (unsigned int i = 0 ; i < nWords ; i ++)
+    if (buffer[2+i] != patternWord (version, i)) return false ;
+  return true ;
+}
+
+/** Reader process: copy the generations until the version stop is published
+ * \return exit status, 0 if all the copies were consistent and the versions never went back
+ */
+static int reader ( char *name, unsigned int stop ) {
+
+  int error = 0 ;
+  try {
+    TShare ms (name, TShare_OPEN, 0) ;
+    std::vector<unsigned int> buffer (GENERATIONWORDS) ;
+    unsigned int lastVersion = 0, reads = 0 ;
+    while (lastVersion < stop) {
+      unsigned int length = ms.ReadGeneration (&buffer[0], GENERATIONWORDS*sizeof(unsigned int)) ;
+      reads ++ ;
+      if (!checkGeneration (&buffer[0], length)) {
+	std::cerr << "ERROR: reader " << getpid() << " got an inconsistent generation" << std::endl ;
+	error ++ ;
+	break ;
+      }
+      if (length != 0) {
+	if (buffer[0] < lastVersion) {
+	  std::cerr << "ERROR: reader " << getpid() << " version " << buffer[0] << " after " << lastVersion << std::endl ;
+	  error ++ ;
+	}
+	lastVersion = buffer[0] ;
+      }
+    }
+    std::cout << "Reader " << getpid() << ": " << reads << " consistent copies" << std::endl ;
+  }
+  catch (std::string &e) {
+    std::cerr << "ERROR: reader " << getpid() << ": " << e << std::endl ;
+    error ++ ;
+  }
+  return error ? 1 : 0 ;
+}
+
+/** Fill two memories as DBCacheHandler::FillShareMemory, the download of the second one fails
+ */
+static void failedDownload ( TShare &first, TShare &second, unsigned int version ) {
+
+  TShareUpdate firstUpdate, secondUpdate ;
+  unsigned int *buffer = (unsigned int *)firstUpdate.Begin (&first) ;
+  fillGeneration (buffer, version) ;
+  buffer = (unsigned int *)secondUpdate.Begin (&second) ;
+  buffer[0] = version ;
+  throw std::string ("download failed") ;
+}
+
+/** Try to begin an update from another process: true if it is accepted, the update is aborted
+ */
+static bool otherProcessWriter ( char *name ) {
+
+  pid_t pid = fork() ;
+  if (pid == 0) {
+    try {
+      TShare other (name, TShare_OPEN, 0) ;
+      other.BeginUpdate() ;
+      other.AbortUpdate() ;
+    }
+    catch (std::string &e) { _exit (1) ; }
+    _exit (0) ;
+  }
+  int status ;
+  waitpid (pid, &status, 0) ;
+  return WIFEXITED(status) && (WEXITSTATUS(status) == 0) ;
+}
+
+/** Try to begin an update from another thread: 0 if it is refused
+ */
+static void *otherThreadWriter ( void *arg ) {
+  TShare *ms = (TShare *)arg ;
+  try { ms->BeginUpdate() ; }
+  catch (std::string &e) { return (void *)0 ; }
+  return (void *)1 ;
+}
+
+static void alarmHandler ( int ) {
+  fprintf (stderr, "ERROR: blocked on the semaphore\n") ;
+  _exit (2) ;
+}
+
+int main ( int argc, char **argv ) {
+
+  int error = 0 ;
+  char name[256], fileName[300] ;
+  snprintf (name, 256, "TShareGenerationsTest%d", getpid()) ;
+
+  try {
+    TShare ms (name, TShare_CREATE, GENERATIONWORDS*sizeof(unsigned int), 3) ;
+    if (!ms.HasGenerations() || ms.GetGenerationSize() != GENERATIONWORDS*sizeof(unsigned int)) {
+      std::cerr << "ERROR: generations not created" << std::endl ;
+      error ++ ;
+    }
+
+    // Concurrent readers while the writer publishes
+    unsigned int nVersions = 2000 ;
+    std::vector<pid_t> readers ;
+    for (int i = 0 ; i < NREADERS ; i ++) {
+      pid_t pid = fork() ;
+      if (pid == 0) _exit (reader (name, nVersions)) ;
+      readers.push_back (pid) ;
+    }
+
+    unsigned long start = getMicroSeconds() ;
+    for (unsigned int version = 1 ; version <= nVersions ; version ++) {
+      unsigned int *buffer = (unsigned int *)ms.BeginUpdate() ;
+      ms.Publish (fillGeneration (buffer, version)) ;
+    }
+    unsigned long writeTime = getMicroSeconds() - start ;
+
+    for (unsigned int i = 0 ; i < readers.size() ; i ++) {
+      int status ;
+      waitpid (readers[i], &status, 0) ;
+      if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+	std::cerr << "ERROR: reader " << readers[i] << " failed" << std::endl ;
+	error ++ ;
+      }
+    }
+    std::cout << nVersions << " generations published in " << writeTime << " us with " << NREADERS << " readers" << std::endl ;
+    if (ms.GetVersion() != nVersions) {
+      std::cerr << "ERROR: version " << ms.GetVersion() << " instead of " << nVersions << std::endl ;
+      error ++ ;
+    }
+
+    // A second writer is refused while an update is in progress
+    ms.BeginUpdate() ;
+    pid_t pid = fork() ;
+    if (pid == 0) {
+      TShare other (name, TShare_OPEN, 0) ;
+      try { other.BeginUpdate() ; }
+      catch (std::string &e) { _exit (0) ; }
+      _exit (1) ;
+    }
+    int status ;
+    waitpid (pid, &status, 0) ;
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      std::cerr << "ERROR: second writer accepted" << std::endl ;
+      error ++ ;
+    }
+
+    // Nor a second thread of the same process
+    pthread_t thread ;
+    void *accepted = NULL ;
+    pthread_create (&thread, NULL, otherThreadWriter, &ms) ;
+    pthread_join (thread, &accepted) ;
+    if (accepted != NULL) {
+      std::cerr << "ERROR: second writer thread accepted" << std::endl ;
+      error ++ ;
+    }
+    ms.AbortUpdate() ;
+
+    // Writer killed in the middle of an update: the generation published is not changed
+    // and the next writer takes the update back
+    int pipeFd[2] ;
+    if (pipe (pipeFd) != 0) throw std::string ("pipe") ;
+    pid = fork() ;
+    if (pid == 0) {
+      TShare other (name, TShare_OPEN, 0) ;
+      unsigned int *buffer = (unsigned int *)other.BeginUpdate() ;
+      for (unsigned int i = 0 ; i < GENERATIONWORDS/2 ; i ++) buffer[i] = 0xDEADBEEF ;
+      char c = 1 ;
+      if (write (pipeFd[1], &c, 1) != 1) _exit (1) ;
+      pause() ;
+      _exit (0) ;
+    }
+    char c ;
+    if (read (pipeFd[0], &c, 1) != 1) throw std::string ("pipe read") ;
+    kill (pid, SIGKILL) ;
+    waitpid (pid, &status, 0) ;
+    close (pipeFd[0]) ; close (pipeFd[1]) ;
+
+    std::vector<unsigned int> copy (GENERATIONWORDS) ;
+    unsigned int length = ms.ReadGeneration (&copy[0], GENERATIONWORDS*sizeof(unsigned int)) ;
+    if (!checkGeneration (&copy[0], length) || copy[0] != nVersions) {
+      std::cerr << "ERROR: generation published modified by the writer killed" << std::endl ;
+      error ++ ;
+    }
+    unsigned int *buffer = (unsigned int *)ms.BeginUpdate() ;
+    ms.Publish (fillGeneration (buffer, nVersions+1)) ;
+    length = ms.ReadGeneration (&copy[0], GENERATIONWORDS*sizeof(unsigned int)) ;
+    if (!checkGeneration (&copy[0], length) || copy[0] != nVersions+1) {
+      std::cerr << "ERROR: no publication after the recovery" << std::endl ;
+      error ++ ;
+    }
+
+    // In place read
+    unsigned int sequence ;
+    const void *generation = ms.GetGeneration (sequence, length) ;
+    if (!checkGeneration ((unsigned int *)generation, length) || !ms.ValidateGeneration (generation, sequence)) {
+      std::cerr << "ERROR: in place read" << std::endl ;
+      error ++ ;
+    }
+    buffer = (unsigned int *)ms.BeginUpdate() ;
+    ms.Publish (fillGeneration (buffer, nVersions+2)) ;
+    buffer = (unsigned int *)ms.BeginUpdate() ;
+    ms.Publish (fillGeneration (buffer, nVersions+3)) ;
+    buffer = (unsigned int *)ms.BeginUpdate() ;
+    if (ms.ValidateGeneration (generation, sequence)) {
+      std::cerr << "ERROR: generation rewritten but still valid" << std::endl ;
+      error ++ ;
+    }
+    ms.AbortUpdate() ;
+
+    // Download error in the middle of the update of two memories: both updates are aborted,
+    // the generations published are not changed and the other writers are accepted
+    char secondName[256] ;
+    snprintf (secondName, 256, "TShareGenerationsTestSecond%d", getpid()) ;
+    {
+      TShare second (secondName, TShare_CREATE, GENERATIONWORDS*sizeof(unsigned int), 3) ;
+      buffer = (unsigned int *)second.BeginUpdate() ;
+      second.Publish (fillGeneration (buffer, 1)) ;
+      try {
+	failedDownload (ms, second, nVersions+4) ;
+	std::cerr << "ERROR: download error not raised" << std::endl ;
+	error ++ ;
+      }
+      catch (std::string &e) { }
+      length = ms.ReadGeneration (&copy[0], GENERATIONWORDS*sizeof(unsigned int)) ;
+      if (!checkGeneration (&copy[0], length) || copy[0] != nVersions+3 || second.GetVersion() != 1) {
+	std::cerr << "ERROR: generation published after a download error" << std::endl ;
+	error ++ ;
+      }
+      if (!otherProcessWriter (name) || !otherProcessWriter (secondName)) {
+	std::cerr << "ERROR: memory left in update after a download error" << std::endl ;
+	error ++ ;
+      }
+    }
+    snprintf (fileName, 300, "/tmp/%s.shm", secondName) ; unlink (fileName) ;
+    snprintf (fileName, 300, "/tmp/%s.sem", secondName) ; unlink (fileName) ;
+
+    // A process which dies with the semaphore does not block the others
+    pid = fork() ;
+    if (pid == 0) {
+      TShare other (name, TShare_OPEN, 0) ;
+      other.Lock() ;
+      _exit (0) ;
+    }
+    waitpid (pid, &status, 0) ;
+    signal (SIGALRM, alarmHandler) ;
+    alarm (5) ;
+    ms.Lock() ;
+    ms.Unlock() ;
+    alarm (0) ;
+  }
+  catch (std::string &e) {
+    std::cerr << "ERROR: " << e << std::endl ;
+    error ++ ;
+  }
+
+  snprintf (fileName, 300, "/tmp/%s.shm", name) ; unlink (fileName) ;
+  snprintf (fileName, 300, "/tmp/%s.sem", name) ; unlink (fileName) ;
+
+  if (error) std::cerr << error << " error(s)" << std::endl ;
+  else std::cout << "All tests passed" << std::endl ;
+
+  return error ? -1 : 0 ;
+}
@@ -0,0 +1,319 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Copyright 2002 - 2003, Frederic DROUHIN - Universite de Haute-Alsace, Mulhouse-France
+*/
+
+#include <stdlib.h>
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "stringConv.h"
+#include "keyType.h"
+#include "deviceType.h"
+#include "ccuDefinition.h"
+#include "cmdDescription.h"
+#include "FecExceptionHandler.h"
+#include "TkRingDescription.h"
+#include "TkRingRedundancyPlanner.h"
+#include "TkRingModel.h"
+#include "TestTime.h"
+
+#define FECSLOT  11
+#define RINGSLOT 3
+
+/** Build a ring of CCUs with the addresses 1 to nCcus and a dummy CCU 0x7F
+ */
+static TkRingDescription *buildRing ( unsigned int nCcus, bool dummy, bool inverted ) {
+
+  TkRingDescription *tkRing = new TkRingDescription ( 0, buildCompleteKey(FECSLOT,RINGSLOT,0,0,0), true, true, true ) ;
+  ccuVector vCcu ;
+  for (unsigned int i = 1 ; i <= nCcus ; i ++)
+    vCcu.push_back(new CCUDescription(0, buildCompleteKey(FECSLOT,RINGSLOT,i,0,0), i, true, true)) ;
+  if (dummy)
+    vCcu.push_back(new CCUDescription(0, buildCompleteKey(FECSLOT,RINGSLOT,0x7F,0,0), DUMMYCCUARRANGEMENT | (inverted ? TIBINVERTEDDUMMY : 0), true, false)) ;
+  tkRing->setCcuVector(vCcu) ;
+
+  return tkRing ;
+}
+
+/** Return the key of the CCU in position i in the ring
+ */
+static keyType ccuAt ( TkRingDescription &tkRing, unsigned int i ) {
+  return (*tkRing.getCcuVector())[i]->getKey() ;
+}
+
+/** Access to the model ring whose first scans fail
+ */
+class TkRingScanFailure: public TkRingAccess {
+
+ public:
+
+  TkRingScanFailure ( TkRingModel &model, unsigned int failures ): model_(model), failures_(failures) { }
+
+  tscType16 fecRingReconfigure ( TkRingDescription &tkRing ) throw (FecExceptionHandler) {
+    return model_.fecRingReconfigure(tkRing) ;
+  }
+
+  std::list<keyType> *getCcuList ( ) throw (FecExceptionHandler) {
+    if (failures_) {
+      failures_ -- ;
+      RAISEFECEXCEPTIONHANDLER ( TSCFEC_INVALIDOPERATION, "scan of the ring failed", ERRORCODE ) ;
+    }
+    return model_.getCcuList() ;
+  }
+
+  unsigned int getFailuresLeft ( ) { return failures_ ; }
+
+ private:
+
+  TkRingModel &model_ ;
+  unsigned int failures_ ;
+} ;
+
+/** Check the enumeration against a brute force validation of all the patterns
+ */
+static int checkEnumeration ( unsigned int nCcus, bool inverted ) {
+
+  int error = 0 ;
+  TkRingDescription *tkRing = buildRing(nCcus, true, inverted) ;
+  TkRingRedundancyPlanner planner ;
+  const std::vector<TkRingRedundancyPlanner::Configuration> &plan = planner.plan(*tkRing) ;
+
+  unsigned int valid = 0 ;
+  for (unsigned int pattern = 0 ; pattern < (1U << nCcus) ; pattern ++) {
+    for (int ports = 0 ; ports < 4 ; ports ++) {
+      TkRingRedundancyPlanner::Configuration c ;
+      for (unsigned int i = 0 ; i < nCcus ; i ++) c.bypassed_.push_back((pattern >> i) & 0x1) ;
+      c.inputAUsed_ = !(ports & 0x1) ;
+      c.outputAUsed_ = !(ports & 0x2) ;
+      TkRingRedundancyPlanner::setConfiguration(*tkRing, c) ;
+      if (tkRing->isReconfigurable() && (pattern || ports)) valid ++ ;
+    }
+  }
+  if (valid != plan.size()) {
+    std::cerr << "ERROR: " << plan.size() << " configurations planned for " << valid << " valid" << std::endl ;
+    error ++ ;
+  }
+  for (unsigned int i = 1 ; i < plan.size() ; i ++) {
+    if (plan[i].ccusKept_ > plan[i-1].ccusKept_) {
+      std::cerr << "ERROR: configuration " << i << " keeps more CCUs than the previous one" << std::endl ;
+      error ++ ;
+      break ;
+    }
+  }
+
+  delete tkRing ;
+  return error ;
+}
+
+/** Check that the planner recovers the ring broken in the model keeping the expected number of CCUs
+ * and with at most the number of attempts given (0 for no check)
+ */
+static int checkRecovery ( const std::string &name, TkRingDescription &tkRing, TkRingModel &model, TkRingRedundancyPlanner &planner,
+			   unsigned int ccusKept, bool recoverable = true, unsigned int maximumAttempts = 0 ) {
+
+  int error = 0 ;
+
+  // Symptoms: the ring does not close
+  TkRingRedundancyPlanner::Configuration nominal = TkRingRedundancyPlanner::getConfiguration(tkRing) ;
+  unsigned int reconfigurations = model.getNumberOfReconfigurations() ;
+  planner.setFecSR0(model.fecRingReconfigure(tkRing)) ;
+
+  bool recovered = planner.apply(model, tkRing) ;
+  TkRingRedundancyPlanner::Configuration result = TkRingRedundancyPlanner::getConfiguration(tkRing) ;
+
+  if (recovered != recoverable) {
+    std::cerr << "ERROR: " << name << ": ring " << (recovered ? "recovered" : "not recovered") << std::endl ;
+    error ++ ;
+  }
+  else if (recovered) {
+    if (!isFecSR0Correct(model.getFecRingSR0())) {
+      std::cerr << "ERROR: " << name << ": the model ring is not closed" << std::endl ;
+      error ++ ;
+    }
+    if (result.ccusKept_ != ccusKept) {
+      std::cerr << "ERROR: " << name << ": " << result.ccusKept_ << " CCUs kept instead of " << ccusKept << std::endl ;
+      error ++ ;
+    }
+  }
+  else if ((result.bypassed_ != nominal.bypassed_) || (result.inputAUsed_ != nominal.inputAUsed_) || (result.outputAUsed_ != nominal.outputAUsed_)) {
+    std::cerr << "ERROR: " << name << ": the ring description was not restored" << std::endl ;
+    error ++ ;
+  }
+
+  unsigned int attempts = planner.getAttempts().size() ;
+  if (maximumAttempts && (attempts > maximumAttempts)) {
+    std::cerr << "ERROR: " << name << ": " << attempts << " attempts instead of " << maximumAttempts << std::endl ;
+    error ++ ;
+  }
+  if (attempts != model.getNumberOfReconfigurations() - reconfigurations - 1) {
+    std::cerr << "ERROR: " << name << ": " << attempts << " attempts for " << model.getNumberOfReconfigurations() - reconfigurations - 1 << " reconfigurations" << std::endl ;
+    error ++ ;
+  }
+
+  std::cout << name << ": " ;
+  if (recovered) TkRingRedundancyPlanner::display(std::cout, tkRing, planner.getConfigurations()[planner.getAttempts().back().configuration_]) ;
+  else std::cout << "not recoverable" ;
+  std::cout << " after " << attempts << " attempts" << std::endl ;
+
+  // Back to the nominal ring for the next test
+  model.clearFaults() ;
+  TkRingRedundancyPlanner::setConfiguration(tkRing, nominal) ;
+  planner.reset() ;
+
+  return error ;
+}
+
+/** \param -ccus <number of CCUs in the ring>
+ */
+int main ( int argc, char **argv ) {
+
+  unsigned int nCcus = 8 ;
+
+  // Find the options
+  for (int i = 1 ; i < argc ; i ++) {
+    std::string param ( argv[i] ) ;
+    if (param == "-ccus") {
+      if (i+1 < argc) {
+	nCcus = atoi(argv[i+1]) ;
+	i ++ ;
+      }
+    }
+    else if (param == "-help") {
+      std::cerr << argv[0] << std::endl ;
+      std::cerr << "  -ccus <number of CCUs in the ring>" << std::endl ;
+      return 0 ;
+    }
+  }
+  if (nCcus < 4) nCcus = 4 ;
+
+  int error = 0 ;
+
+  try {
+    error += checkEnumeration(6, false) ;
+    error += checkEnumeration(6, true) ;
+
+    for (int inverted = 0 ; inverted < 2 ; inverted ++) {
+
+      TkRingDescription *tkRing = buildRing(nCcus, true, inverted) ;
+      TkRingModel model (*tkRing) ;
+      TkRingRedundancyPlanner planner ;
+      std::cout << "---------------- Ring with " << nCcus << " CCUs, dummy CCU " << (inverted ? "TIB inverted" : "standard") << std::endl ;
+
+      // Nominal ring, nothing to do
+      planner.setFecSR0(model.fecRingReconfigure(*tkRing)) ;
+      std::list<keyType> *ccuList = model.getCcuList() ;
+      planner.setCcuList(*ccuList) ;
+      delete ccuList ;
+      unsigned int reconfigurations = model.getNumberOfReconfigurations() ;
+      if (planner.isRecoveryNeeded(*tkRing) || !planner.apply(model, *tkRing) || (model.getNumberOfReconfigurations() != reconfigurations)) {
+	std::cerr << "ERROR: the nominal ring is reconfigured" << std::endl ;
+	error ++ ;
+      }
+      planner.reset() ;
+
+      // One dead CCU at each position
+      for (unsigned int i = 0 ; i < nCcus ; i ++) {
+	model.setCcuDead(ccuAt(*tkRing, i)) ;
+	std::stringstream name ; name << "CCU " << i+1 << " dead" ;
+	error += checkRecovery(name.str(), *tkRing, model, planner, nCcus - 1) ;
+      }
+
+      // Same with the CCUs which answered before the break: after the configurations keeping
+      // all the CCUs (FEC ports and dummy CCU), the suspect CCU is bypassed first
+      unsigned int broken = nCcus / 2 ;
+      model.setCcuDead(ccuAt(*tkRing, broken)) ;
+      std::list<keyType> found ;
+      for (unsigned int i = 0 ; i < broken ; i ++) found.push_back(ccuAt(*tkRing, i)) ;
+      planner.setCcuList(found) ;
+      planner.setCcuStatus(ccuAt(*tkRing, broken-1), CCU_SRA_CRC_ERROR, 0) ;
+      error += checkRecovery("CCU in the middle dead with a partial scan", *tkRing, model, planner, nCcus - 1, true, 4) ;
+
+      // Broken cables: no CCU lost
+      model.setInputLinkBroken(ccuAt(*tkRing, 0), true) ;
+      error += checkRecovery("FEC output A cable broken", *tkRing, model, planner, nCcus) ;
+      model.setFecInputLinkBroken(true) ;
+      error += checkRecovery("FEC input A cable broken", *tkRing, model, planner, nCcus) ;
+      model.setInputLinkBroken(ccuAt(*tkRing, 2), true) ;
+      error += checkRecovery("Cable into CCU 3 input A broken", *tkRing, model, planner, nCcus - 1) ;
+
+      // Two faults
+      model.setCcuDead(ccuAt(*tkRing, 1)) ;
+      model.setCcuDead(ccuAt(*tkRing, nCcus - 2)) ;
+      error += checkRecovery("CCU 2 and CCU " + toString(nCcus - 1) + " dead", *tkRing, model, planner, nCcus - 2) ;
+      model.setCcuDead(ccuAt(*tkRing, 1)) ;
+      model.setCcuDead(ccuAt(*tkRing, 2)) ;
+      error += checkRecovery("CCU 2 and CCU 3 dead", *tkRing, model, planner, 0, false) ;
+
+      // Unstable ring, the first try of each configuration fails
+      model.setCcuDead(ccuAt(*tkRing, 0)) ;
+      model.setTransientFailures(2) ;
+      planner.setTries(3) ;
+      error += checkRecovery("CCU 1 dead on an unstable ring", *tkRing, model, planner, nCcus - 1) ;
+      planner.setTries(1) ;
+
+      // A scan which fails is the error of its attempt, not a ring without CCU, the next attempt is done
+      TkRingRedundancyPlanner::Configuration nominal = TkRingRedundancyPlanner::getConfiguration(*tkRing) ;
+      TkRingScanFailure failing (model, 1) ;
+      model.setCcuDead(ccuAt(*tkRing, 0)) ;
+      planner.setFecSR0(model.fecRingReconfigure(*tkRing)) ;
+      bool recovered = planner.apply(failing, *tkRing) ;
+      bool scanErrorRecorded = false ;
+      for (unsigned int i = 0 ; i < planner.getAttempts().size() ; i ++)
+	if (planner.getAttempts()[i].error_.find("scan of the ring failed") != std::string::npos) scanErrorRecorded = true ;
+      if (!recovered || failing.getFailuresLeft() || !scanErrorRecorded) {
+	std::cerr << "ERROR: scan failure " << (scanErrorRecorded ? "recorded" : "not recorded") << ", ring " << (recovered ? "recovered" : "not recovered") << std::endl ;
+	error ++ ;
+      }
+      model.clearFaults() ;
+      TkRingRedundancyPlanner::setConfiguration(*tkRing, nominal) ;
+      planner.reset() ;
+
+      delete tkRing ;
+    }
+
+    // Not enough CCUs
+    TkRingDescription *tkRing = buildRing(2, true, false) ;
+    TkRingRedundancyPlanner planner ;
+    try {
+      planner.plan(*tkRing) ;
+      std::cerr << "ERROR: no exception for a ring with 2 CCUs" << std::endl ;
+      error ++ ;
+    }
+    catch (FecExceptionHandler &e) { }
+    delete tkRing ;
+
+    // Time to plan a large ring
+    tkRing = buildRing(16, true, false) ;
+    unsigned long start = getMicroSeconds() ;
+    unsigned int nConfigurations = planner.plan(*tkRing).size() ;
+    std::cout << nConfigurations << " configurations planned for 16 CCUs in " << getMicroSeconds() - start << " us" << std::endl ;
+    delete tkRing ;
+  }
+  catch (FecExceptionHandler &e) {
+    std::cerr << "ERROR: " << e.what() << std::endl ;
+    error ++ ;
+  }
+
+  if (error) std::cerr << error << " error(s)" << std::endl ;
+  else std::cout << "All tests passed" << std::endl ;
+
+  return error ? -1 : 0 ;
+}
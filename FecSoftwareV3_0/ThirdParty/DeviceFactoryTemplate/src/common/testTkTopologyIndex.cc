@@ -0,0 +1,189 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Copyright 2002 - 2003, Frederic DROUHIN - Universite de Haute-Alsace, Mulhouse-France
+*/
+
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "dcuDescription.h"
+#include "TkTopologyIndex.h"
+#include "TestTime.h"
+
+/** Synthetic tracker: 4 crates of 16 FECs with 7 rings of 8 CCUs, 4 modules of 4 or 6 APVs per CCU,
+ * 96 channels per FED, 8 modules per power group and 10 CCUs per control group
+ */
+static void buildTracker ( ConnectionVector &connections, tkDcuInfoVector &dcuInfos, tkDcuPsuMapVector &dcuPsuMaps, deviceVector &dcuDevices ) {
+
+  unsigned int module = 0, ccuNumber = 0, fedId = 50, fedChannel = 0 ;
+  for (unsigned int crate = 1 ; crate <= 4 ; crate ++) {
+    for (unsigned int fec = 1 ; fec <= 16 ; fec ++) {
+      std::string fecHardwareId = "FEC" + toString (crate * 100 + fec) ;
+      for (unsigned int ring = 0 ; ring < 7 ; ring ++) {
+	for (unsigned int ccu = 1 ; ccu <= 8 ; ccu ++, ccuNumber ++) {
+
+	  // CCU DCU on a control group
+	  tscType32 ccuDcuHardId = 0x800000 + ccuNumber ;
+	  dcuDescription *dcu = new dcuDescription (buildCompleteKey(fec,ring,ccu,0x10,0x0), 0, ccuDcuHardId, 0, 0, 0, 0, 0, 0, 0, 0, DCUCCU) ;
+	  dcu->setCrateId (crate) ;
+	  dcuDevices.push_back (dcu) ;
+	  dcuInfos.push_back (new TkDcuInfo (ccuDcuHardId, 0, 0, 0)) ;
+	  dcuPsuMaps.push_back (new TkDcuPsuMap (ccuDcuHardId, "cms_trk_dcs:CAEN/CG" + toString (ccuNumber / 10) + ",TK_CG" + toString (ccuNumber / 10),
+						 PSUDCUTYPE_CG, buildCompleteKey(fec,ring,ccu,0x10,0x0))) ;
+
+	  for (unsigned int channel = 0x11 ; channel <= 0x14 ; channel ++, module ++) {
+	    tscType32 dcuHardId = 0x100000 + module ;
+	    unsigned int apvNumber = (module % 2) ? 4 : 6 ;
+	    dcu = new dcuDescription (buildCompleteKey(fec,ring,ccu,channel,0x0), 0, dcuHardId, 0, 0, 0, 0, 0, 0, 0, 0) ;
+	    dcu->setCrateId (crate) ;
+	    dcuDevices.push_back (dcu) ;
+	    dcuInfos.push_back (new TkDcuInfo (dcuHardId, 369000000 + module * 4, 50 + module % 40, apvNumber)) ;
+	    dcuPsuMaps.push_back (new TkDcuPsuMap (dcuHardId, "cms_trk_dcs:CAEN/PG" + toString (module / 8) + ",TK_PG" + toString (module / 8), PSUDCUTYPE_PG)) ;
+	    for (unsigned int apv = 0x20 ; apv < 0x20 + apvNumber ; apv += 2) {
+	      if (apvNumber == 4 && apv == 0x22) apv = 0x24 ;
+	      connections.push_back (new ConnectionDescription (fedId, fedChannel, fecHardwareId, crate, fec, ring, ccu, channel, apv, dcuHardId)) ;
+	      if (++ fedChannel == 96) { fedId ++ ; fedChannel = 0 ; }
+	    }
+	  }
+	}
+      }
+    }
+  }
+}
+
+int main ( int argc, char **argv ) {
+
+  int error = 0 ;
+
+  ConnectionVector connections ;
+  tkDcuInfoVector dcuInfos ;
+  tkDcuPsuMapVector dcuPsuMaps ;
+  deviceVector dcuDevices ;
+
+  try {
+    buildTracker (connections, dcuInfos, dcuPsuMaps, dcuDevices) ;
+
+    TkTopologyVersion version ;
+    version.partitionName = "TRACKER" ;
+    version.connectionMajor = 12 ; version.connectionMinor = 1 ;
+    version.dcuInfoMajor = version.dcuInfoMinor = version.dcuPsuMapMajor = version.dcuPsuMapMinor = version.fecMajor = version.fecMinor = 0 ;
+
+    unsigned long start = getMicroSeconds() ;
+    TkTopologyIndex topology (connections, dcuInfos, dcuPsuMaps, dcuDevices, version) ;
+    unsigned long buildTime = getMicroSeconds() - start ;
+    std::cout << "Index of " << topology.getNumberOfModules() << " DCUs, " << topology.getNumberOfFedChannels() << " FED channels, "
+	      << topology.getNumberOfPsus() << " PSUs built in " << buildTime << " us" << std::endl ;
+
+    if (topology.getNumberOfModules() != dcuInfos.size() || topology.getNumberOfFedChannels() != connections.size() ||
+	topology.getVersion().connectionMajor != 12 || topology.getVersion().partitionName != "TRACKER") {
+      std::cerr << "ERROR: bad index size or version" << std::endl ;
+      error ++ ;
+    }
+    if (!topology.getViolations().empty()) {
+      std::cerr << "ERROR: " << topology.getViolations().size() << " violations in a consistent tracker: " << topology.getViolations()[0] << std::endl ;
+      error ++ ;
+    }
+
+    // Every connection is found through all the identifiers
+    start = getMicroSeconds() ;
+    unsigned int lookups = 0 ;
+    for (ConnectionVector::iterator it = connections.begin() ; it != connections.end() ; it ++) {
+      ConnectionDescription *connection = *it ;
+      unsigned int moduleId = topology.findModuleByFedChannel (connection->getFedId(), connection->getFedChannel()) ;
+      if (moduleId == TKTOPOLOGY_INVALID ||
+	  topology.findModuleByDcuHardId (connection->getDcuHardId()) != moduleId ||
+	  topology.findModuleByFecKey (connection->getFecCrateId(), connection->getKey()) != moduleId ||
+	  topology.findModuleByDetId (topology.getModule(moduleId).detId) != moduleId) {
+	std::cerr << "ERROR: FED " << connection->getFedId() << " channel " << connection->getFedChannel() << " not found" << std::endl ;
+	error ++ ;
+	break ;
+      }
+      lookups += 4 ;
+    }
+    unsigned long lookupTime = getMicroSeconds() - start ;
+    std::cout << lookups << " lookups in " << lookupTime << " us" << std::endl ;
+
+    // Module to FED channels and PSU
+    unsigned int moduleId = topology.findModuleByDcuHardId (0x100000 + 1001) ;
+    const TkTopologyModule &module = topology.getModule (moduleId) ;
+    if (module.detId != 369000000 + 1001 * 4 || module.apvNumber != 4 || module.fedChannelNumber != 2 ||
+	topology.getFedChannel(moduleId, 0).apvAddress != 0x20 || topology.getFedChannel(moduleId, 1).apvAddress != 0x24 ||
+	module.psuId != topology.findPsu ("cms_trk_dcs:CAEN/PG125,TK_PG125")) {
+      std::cerr << "ERROR: bad module " << module.dcuHardId << std::endl ;
+      error ++ ;
+    }
+    const TkTopologyPsu &psu = topology.getPsu (module.psuId) ;
+    if (psu.psuType != PSUDCUTYPE_PG || psu.moduleNumber != 8 || topology.getPsuModule(module.psuId, 1001 % 8) != moduleId) {
+      std::cerr << "ERROR: bad modules for the PSU " << psu.psuName << std::endl ;
+      error ++ ;
+    }
+
+    // CCU DCU through the DCU descriptions
+    unsigned int ccuId = topology.findModuleByFecKey (2, buildCompleteKey(3,4,5,0x10,0x0)) ;
+    if (ccuId == TKTOPOLOGY_INVALID || topology.getModule(ccuId).fedChannelNumber != 0 ||
+	topology.getPsu(topology.getModule(ccuId).psuId).psuType != PSUDCUTYPE_CG) {
+      std::cerr << "ERROR: CCU DCU not found" << std::endl ;
+      error ++ ;
+    }
+
+    if (topology.findModuleByDetId (1) != TKTOPOLOGY_INVALID || topology.findFedChannel (1000, 0) != TKTOPOLOGY_INVALID || topology.findPsu ("none") != TKTOPOLOGY_INVALID) {
+      std::cerr << "ERROR: unknown identifiers found" << std::endl ;
+      error ++ ;
+    }
+
+    // Inconsistent sources: FED channel connected twice, DCU without DCU info, DCU on two PSUs, two DCUs on the same key
+    ConnectionVector badConnections = connections ;
+    badConnections.push_back (new ConnectionDescription (50, 0, "FEC101", 1, 1, 0, 1, 0x15, 0x20, 0x100000 + 5)) ;
+    badConnections.push_back (new ConnectionDescription (490, 0, "FEC101", 1, 1, 0, 1, 0x16, 0x20, 0x7FFFFF)) ;
+    tkDcuPsuMapVector badDcuPsuMaps = dcuPsuMaps ;
+    badDcuPsuMaps.push_back (new TkDcuPsuMap (0x100000 + 7, "cms_trk_dcs:CAEN/PG9,TK_PG9", PSUDCUTYPE_PG)) ;
+    deviceVector badDcuDevices = dcuDevices ;
+    dcuDescription *dcu = new dcuDescription (buildCompleteKey(1,0,1,0x11,0x0), 0, 0x7FFFFE, 0, 0, 0, 0, 0, 0, 0, 0) ;
+    dcu->setCrateId (1) ;
+    badDcuDevices.push_back (dcu) ;
+
+    TkTopologyIndex badTopology (badConnections, dcuInfos, badDcuPsuMaps, badDcuDevices, version) ;
+    const std::vector<std::string> &violations = badTopology.getViolations() ;
+    for (std::vector<std::string>::const_iterator it = violations.begin() ; it != violations.end() ; it ++) std::cout << *it << std::endl ;
+    if (violations.size() != 4) {
+      std::cerr << "ERROR: " << violations.size() << " violations found instead of 4" << std::endl ;
+      error ++ ;
+    }
+
+    delete badConnections[badConnections.size()-1] ;
+    delete badConnections[badConnections.size()-2] ;
+    delete badDcuPsuMaps[badDcuPsuMaps.size()-1] ;
+    delete dcu ;
+  }
+  catch (FecExceptionHandler &e) {
+    std::cerr << "ERROR: " << e.what() << std::endl ;
+    error ++ ;
+  }
+
+  for (ConnectionVector::iterator it = connections.begin() ; it != connections.end() ; it ++) delete *it ;
+  for (tkDcuInfoVector::iterator it = dcuInfos.begin() ; it != dcuInfos.end() ; it ++) delete *it ;
+  for (tkDcuPsuMapVector::iterator it = dcuPsuMaps.begin() ; it != dcuPsuMaps.end() ; it ++) delete *it ;
+  for (deviceVector::iterator it = dcuDevices.begin() ; it != dcuDevices.end() ; it ++) delete *it ;
+
+  if (error) std::cerr << error << " error(s)" << std::endl ;
+  else std::cout << "All tests passed" << std::endl ;
+
+  return error ? -1 : 0 ;
+}
@@ -5,6 +5,7 @@
 #include <vector>
 
 #include "hashMapDefinition.h"
+#include "KeyTypeTable.h"
 
 #include "tscTypes.h"
 #include "keyType.h"
@@ -17,12 +18,12 @@
 // Create new type in order to store the access of each device type
 
 // Hash table for Vfat
-typedef Sgi::hash_map<keyType, vfatAccess *> vfatAccessedType ;
+typedef KeyTypeTable<vfatAccess *> vfatAccessedType ;
 
 // Hash table for CChip
-typedef Sgi::hash_map<keyType, totemCChipAccess *> cchipAccessedType ;
+typedef KeyTypeTable<totemCChipAccess *> cchipAccessedType ;
 
 // Hash table for TBB
-typedef Sgi::hash_map<keyType, totemBBAccess *> tbbAccessedType ;
+typedef KeyTypeTable<totemBBAccess *> tbbAccessedType ;
 
 #endif
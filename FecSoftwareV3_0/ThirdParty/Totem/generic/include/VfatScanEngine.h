@@ -0,0 +1,281 @@
+/*
+This file is part of Fec Software project.
+
+Fec Software is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Fec Software is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Fec Software; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+#ifndef VFATSCANENGINE_H
+#define VFATSCANENGINE_H
+
+#include <list>
+#include <utility>
+#include <vector>
+
+#include "keyType.h"
+#include "deviceFrame.h"
+#include "FecExceptionHandler.h"
+#include "FecAccess.h"
+
+#include "vfatDefinition.h"
+
+/** Registers of the VFAT that can be scanned
+ */
+enum VfatScanRegister { VFATSCAN_IPREAMPIN, VFATSCAN_IPREAMPFEED, VFATSCAN_IPREAMPOUT,
+			VFATSCAN_ISHAPER, VFATSCAN_ISHAPERFEED, VFATSCAN_ICOMP,
+			VFATSCAN_LATENCY, VFATSCAN_VCAL, VFATSCAN_VTHRESHOLD1, VFATSCAN_VTHRESHOLD2, VFATSCAN_CALPHASE } ;
+
+/**
+ * \class VfatScanDefinition
+ * Declaration of a scan: a register of the VFAT goes from a first to a last value by step on all the chips,
+ * with fixed settings written once before the first step. The last value can be lower than the first one
+ * (inverted threshold scan). Each step gives a number of values per chip, one per channel for the hit counts.
+ * \brief Definition of a scan of the VFATs
+ */
+class VfatScanDefinition {
+
+ public:
+
+  /** \brief Scan of a register
+   * \param reg - register scanned
+   * \param first - first value
+   * \param last - last value (included if reached by the step)
+   * \param step - step, always positive
+   * \param channels - number of values measured per chip and step
+   */
+  VfatScanDefinition ( VfatScanRegister reg, unsigned int first = 0, unsigned int last = 255, unsigned int step = 1, unsigned int channels = 128 ):
+    register_(reg), first_(first), last_(last), step_(step), channels_(channels), retries_(5), restore_(false), restoreValue_(0) { }
+
+  /** \brief Add a chip to the scan
+   */
+  void addChip ( keyType key ) { chips_.push_back(key) ; }
+
+  /** \brief Add a setting written on all the chips before the first step
+   */
+  void addSetting ( VfatScanRegister reg, tscType8 value ) { settings_.push_back(std::make_pair(reg, value)) ; }
+
+  /** \brief Number of times a chip is written before the step is marked in error for this chip
+   */
+  void setRetries ( unsigned int retries ) { retries_ = retries ; }
+
+  /** \brief Value written in the register scanned at the end of the scan
+   */
+  void setRestoreValue ( tscType8 value ) { restore_ = true ; restoreValue_ = value ; }
+
+  VfatScanRegister getRegister ( ) const { return register_ ; }
+  unsigned int getFirst ( ) const { return first_ ; }
+  unsigned int getLast ( ) const { return last_ ; }
+  unsigned int getStep ( ) const { return step_ ; }
+  unsigned int getChannels ( ) const { return channels_ ; }
+  unsigned int getRetries ( ) const { return retries_ ; }
+  bool getRestore ( ) const { return restore_ ; }
+  tscType8 getRestoreValue ( ) const { return restoreValue_ ; }
+  const std::vector<keyType> &getChips ( ) const { return chips_ ; }
+  const std::vector< std::pair<VfatScanRegister, tscType8> > &getSettings ( ) const { return settings_ ; }
+
+  /** \brief Values of the register, in the order of the scan
+   */
+  std::vector<unsigned int> getValues ( ) const ;
+
+  /** \brief Check the definition
+   * \exception FecExceptionHandler if the range, the step or the chips are not valid
+   */
+  void check ( ) const throw (FecExceptionHandler) ;
+
+  /** \brief Add the accesses writing a register of a chip
+   */
+  static void addWrite ( keyType key, VfatScanRegister reg, tscType8 value, accessDeviceTypeList &vAccess ) ;
+
+ private:
+
+  VfatScanRegister register_ ;
+  unsigned int first_, last_, step_ ;
+  unsigned int channels_ ;
+  unsigned int retries_ ;
+  bool restore_ ;
+  tscType8 restoreValue_ ;
+  std::vector<keyType> chips_ ;
+  std::vector< std::pair<VfatScanRegister, tscType8> > settings_ ;
+} ;
+
+/**
+ * \class VfatScanResult
+ * Values measured by a scan, stored in one array: step x chip x channel.
+ * A step of a chip is marked in error when the chip cannot be written, its values are then 0.
+ * \brief Result matrix of a scan of the VFATs
+ */
+class VfatScanResult {
+
+ public:
+
+  /** \brief Empty result
+   */
+  VfatScanResult ( ): chips_(0), channels_(0), stepsDone_(0) { }
+
+  /** \brief Allocate the matrix, all the values set to 0
+   */
+  void resize ( const std::vector<unsigned int> &values, unsigned int chips, unsigned int channels ) ;
+
+  unsigned int getSteps ( ) const { return values_.size() ; }
+  unsigned int getChips ( ) const { return chips_ ; }
+  unsigned int getChannels ( ) const { return channels_ ; }
+
+  /** \brief Value of the register at a step
+   */
+  unsigned int getValue ( unsigned int step ) const { return values_[step] ; }
+
+  /** \brief Value measured
+   */
+  unsigned int get ( unsigned int step, unsigned int chip, unsigned int channel ) const {
+    return data_[(step * chips_ + chip) * channels_ + channel] ;
+  }
+
+  /** \brief Set a value measured
+   */
+  void set ( unsigned int step, unsigned int chip, unsigned int channel, unsigned int value ) {
+    data_[(step * chips_ + chip) * channels_ + channel] = value ;
+  }
+
+  /** \brief Values of a chip at a step, getChannels() values
+   */
+  unsigned int *getRow ( unsigned int step, unsigned int chip ) {
+    return &data_[(step * chips_ + chip) * channels_] ;
+  }
+
+  /** \brief The chip was not written at this step
+   */
+  bool isError ( unsigned int step, unsigned int chip ) const { return errors_[step * chips_ + chip] ; }
+  void setError ( unsigned int step, unsigned int chip ) { errors_[step * chips_ + chip] = true ; }
+
+  /** \brief Number of steps done, the scan can be stopped before the end
+   */
+  unsigned int getStepsDone ( ) const { return stepsDone_ ; }
+  void setStepsDone ( unsigned int stepsDone ) { stepsDone_ = stepsDone ; }
+
+  /** \brief Register value where the values of a channel cross a level (S-curve), interpolated between the steps
+   * \return -1 if the level is not crossed
+   */
+  double getCrossing ( unsigned int chip, unsigned int channel, unsigned int level ) const ;
+
+ private:
+
+  unsigned int chips_ ;
+  unsigned int channels_ ;
+  unsigned int stepsDone_ ;
+  std::vector<unsigned int> values_ ;
+  std::vector<unsigned int> data_ ;
+  std::vector<bool> errors_ ;
+} ;
+
+/**
+ * \class VfatScanMeasurement
+ * Called by the scan engine when all the chips are set for a step: the measurement (trigger and readout
+ * of the hits for example) fills the row of each chip in the result.
+ * \brief Measurement done at each step of a scan
+ */
+class VfatScanMeasurement {
+
+ public:
+
+  virtual ~VfatScanMeasurement ( ) { }
+
+  /** \brief Measure the step
+   * \param scan - scan done
+   * \param step - index of the step in the result
+   * \param result - result to be filled for this step
+   */
+  virtual void measure ( const VfatScanDefinition &scan, unsigned int step, VfatScanResult &result ) = 0 ;
+
+  /** \brief Called after each step, for a progress display for example
+   * \return false to stop the scan
+   */
+  virtual bool stepDone ( unsigned int step, unsigned int steps ) { return true ; }
+} ;
+
+/**
+ * \class VfatScanWriter
+ * Send blocks of frames to the VFATs, one list of accesses per ring. VfatScanFecWriter uses the FecAccess,
+ * another implementation can simulate the chips.
+ * \brief Block writes of the VFAT registers
+ */
+class VfatScanWriter {
+
+ public:
+
+  virtual ~VfatScanWriter ( ) { }
+
+  /** \brief Send the accesses, see FecAccess::setBlockDevices
+   * \return number of errors, the access in error has its exception set
+   */
+  virtual unsigned int setBlockDevices ( accessDeviceTypeListMap &vAccess, std::list<FecExceptionHandler *> &errorList ) = 0 ;
+} ;
+
+/**
+ * \class VfatScanFecWriter
+ * \brief Block writes of the VFAT registers through the FecAccess
+ */
+class VfatScanFecWriter: public VfatScanWriter {
+
+ public:
+
+  VfatScanFecWriter ( FecAccess &fecAccess ): fecAccess_(fecAccess) { }
+
+  unsigned int setBlockDevices ( accessDeviceTypeListMap &vAccess, std::list<FecExceptionHandler *> &errorList ) {
+    return fecAccess_.setBlockDevices (vAccess, errorList) ;
+  }
+
+ private:
+
+  FecAccess &fecAccess_ ;
+} ;
+
+/**
+ * \class VfatScanEngine
+ * Run a scan on several VFATs: at each step the register of all the chips is written in one block of frames
+ * per ring (multiple frames), the chips in error are written again up to the number of retries, then the
+ * measurement is called. This class has no dependency on the GUI.
+ * \brief Scan of the VFAT registers with block writes
+ */
+class VfatScanEngine {
+
+ public:
+
+  /** \brief Engine using the writer given
+   */
+  VfatScanEngine ( VfatScanWriter &writer ): writer_(writer), blocks_(0), frames_(0) { }
+
+  /** \brief Run the scan
+   * \return number of steps of a chip in error
+   * \exception FecExceptionHandler if the definition is not valid
+   */
+  unsigned int run ( const VfatScanDefinition &scan, VfatScanMeasurement &measurement, VfatScanResult &result ) throw (FecExceptionHandler) ;
+
+  /** \brief Number of blocks and accesses sent since the creation
+   */
+  unsigned long getBlocks ( ) { return blocks_ ; }
+  unsigned long getFrames ( ) { return frames_ ; }
+
+ private:
+
+  /** \brief Write a register on a set of chips, with the retries
+   * \return the chips (index in the scan) not written
+   */
+  std::vector<unsigned int> writeChips ( const VfatScanDefinition &scan, const std::vector<unsigned int> &chips,
+					 VfatScanRegister reg, tscType8 value ) ;
+
+  VfatScanWriter &writer_ ;
+  unsigned long blocks_ ;
+  unsigned long frames_ ;
+} ;
+
+#endif
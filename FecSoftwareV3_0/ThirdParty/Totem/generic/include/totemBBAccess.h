@@ -21,6 +21,7 @@ Copyright 2006 Juha Petajajarvi -  Rovaniemi University of Applied Sciences, Rov
 #define TOTEMBBACCESS_H
 
 #include "deviceType.h"
+#include "KeyTypeTable.h"
 #include "deviceFrame.h"
 
 #include "FecAccess.h"
@@ -137,7 +138,7 @@ class totemBBAccess: public deviceAccess {
    * \warning if a problem occurs in one channel then 0 is set in the corresponding registers
    */
   static unsigned int getValuesMultipleFrames ( FecAccess &fecAccess, 
-						Sgi::hash_map<keyType, totemBBAccess *> &tbbSet,
+						KeyTypeTable<totemBBAccess *> &tbbSet,
 						deviceVector &tbbVector,
 						std::list<FecExceptionHandler *> &errorList ) throw (FecExceptionHandler) ;
 };
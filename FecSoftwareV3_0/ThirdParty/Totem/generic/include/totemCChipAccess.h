@@ -21,6 +21,7 @@ Copyright 2006 Juha Petajajarvi -  Rovaniemi University of Applied Sciences, Rov
 #define TOTEMCCHIPACCESS_H
 
 #include "deviceType.h"
+#include "KeyTypeTable.h"
 #include "deviceFrame.h"
 
 #include "FecAccess.h"
@@ -265,7 +266,7 @@ class totemCChipAccess: public deviceAccess {
    * \warning if a problem occurs in one channel then 0 is set in the corresponding registers
    */
   static unsigned int getValuesMultipleFrames ( FecAccess &fecAccess,
-						Sgi::hash_map<keyType, totemCChipAccess *> &ccSet,
+						KeyTypeTable<totemCChipAccess *> &ccSet,
 						deviceVector &ccVector,
 						std::list<FecExceptionHandler *> &errorList ) throw (FecExceptionHandler) ;
 
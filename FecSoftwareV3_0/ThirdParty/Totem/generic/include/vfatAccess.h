@@ -22,6 +22,7 @@ based on philipsAccess made by Frederic DROUHIN - Universite de Haute-Alsace, Mu
 #define VFATACCESS_H
 
 #include "deviceType.h"
+#include "KeyTypeTable.h"
 #include "deviceFrame.h"
 
 #include "FecAccess.h"
@@ -281,7 +282,7 @@ class vfatAccess: public deviceAccess {
 
   /** \brief static method to upload from the hardware the devices
    */
-  static unsigned int getVfatValuesMultipleFrames ( FecAccess &fecAccess, Sgi::hash_map<keyType, vfatAccess *> &vfatSet, deviceVector &vfatVector, std::list<FecExceptionHandler *> &errorList ) 
+  static unsigned int getVfatValuesMultipleFrames ( FecAccess &fecAccess, KeyTypeTable<vfatAccess *> &vfatSet, deviceVector &vfatVector, std::list<FecExceptionHandler *> &errorList ) 
    throw (FecExceptionHandler) ;
 };
 
@@ -0,0 +1,237 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <set>
+#include <sstream>
+
+#include "tscTypes.h"
+#include "vfatDefinition.h"
+#include "VfatScanEngine.h"
+
+/** Address of the registers: principal registers, then extended registers written through the pointer
+ */
+static const tscType8 vfatScanAddress[] = { VFAT_IPREAMPIN, VFAT_IPREAMPFEED, VFAT_IPREAMPOUT,
+					     VFAT_ISHAPER, VFAT_ISHAPERFEED, VFAT_ICOMP,
+					     VFAT_LATENCY, VFAT_VCAL, VFAT_VTHRESHOLD1, VFAT_VTHRESHOLD2, VFAT_CALPHASE } ;
+
+/** \return the values from the first to the last one, decreasing if the last value is lower than the first one
+ */
+std::vector<unsigned int> VfatScanDefinition::getValues ( ) const {
+
+  std::vector<unsigned int> values ;
+  if (step_ == 0) return values ;
+
+  if (first_ <= last_) {
+    for (unsigned int value = first_ ; value <= last_ ; value += step_) values.push_back(value) ;
+  }
+  else {
+    for (unsigned int value = first_ ; (value >= last_) && (value <= first_) ; value -= step_) {
+      values.push_back(value) ;
+      if (value < step_) break ;
+    }
+  }
+
+  return values ;
+}
+
+/** \exception FecExceptionHandler if the step is 0, a value is not a 8 bits value, no chip or no channel is given
+ */
+void VfatScanDefinition::check ( ) const throw (FecExceptionHandler) {
+
+  std::ostringstream msg ;
+  if (step_ == 0) msg << "the step of the VFAT scan is 0" ;
+  else if ((first_ > 0xFF) || (last_ > 0xFF)) msg << "the range of the VFAT scan (" << first_ << ", " << last_ << ") is not a 8 bits range" ;
+  else if (chips_.empty()) msg << "no VFAT given for the scan" ;
+  else if (channels_ == 0) msg << "no channel measured in the VFAT scan" ;
+  else return ;
+
+  RAISEFECEXCEPTIONHANDLER ( TSCFEC_INVALIDOPERATION,
+			     msg.str(),
+			     ERRORCODE ) ;
+}
+
+/** A principal register is one access, an extended register is the pointer then the data.
+ * The accesses are the one of the single writes (vfatAccess), in normal mode.
+ * \param key - key of the chip
+ * \param reg - register
+ * \param value - value to be written
+ * \param vAccess - list of the ring where the accesses are added
+ */
+void VfatScanDefinition::addWrite ( keyType key, VfatScanRegister reg, tscType8 value, accessDeviceTypeList &vAccess ) {
+
+  if (reg >= VFATSCAN_LATENCY) {
+    accessDeviceType pointer = { key, NORMALMODE, MODE_WRITE, VFAT_EXTREGPOINTER, vfatScanAddress[reg], false, 0, 0, 0, NULL } ;
+    vAccess.push_back(pointer) ;
+    accessDeviceType data = { key, NORMALMODE, MODE_WRITE, VFAT_EXTREGDATA, value, false, 0, 0, 0, NULL } ;
+    vAccess.push_back(data) ;
+  }
+  else {
+    accessDeviceType data = { key, NORMALMODE, MODE_WRITE, vfatScanAddress[reg], value, false, 0, 0, 0, NULL } ;
+    vAccess.push_back(data) ;
+  }
+}
+
+/** \param values - values of the register, one per step
+ * \param chips - number of chips
+ * \param channels - number of values per chip and step
+ */
+void VfatScanResult::resize ( const std::vector<unsigned int> &values, unsigned int chips, unsigned int channels ) {
+
+  values_ = values ;
+  chips_ = chips ;
+  channels_ = channels ;
+  stepsDone_ = 0 ;
+  data_.assign (values.size() * chips * channels, 0) ;
+  errors_.assign (values.size() * chips, false) ;
+}
+
+/** The steps in error are skipped. The values of the channel are expected to go through the level
+ * (increasing or decreasing), the first crossing is interpolated between the two steps around it.
+ * \param chip - index of the chip in the scan
+ * \param channel - channel
+ * \param level - level (half of the number of triggers for a threshold)
+ */
+double VfatScanResult::getCrossing ( unsigned int chip, unsigned int channel, unsigned int level ) const {
+
+  bool previous = false ;
+  unsigned int previousStep = 0 ;
+
+  for (unsigned int step = 0 ; step < stepsDone_ ; step ++) {
+
+    if (isError (step, chip)) continue ;
+
+    if (previous) {
+      double v0 = get (previousStep, chip, channel), v1 = get (step, chip, channel) ;
+      if (((v0 < level) && (v1 >= level)) || ((v0 >= level) && (v1 < level))) {
+	double x0 = values_[previousStep], x1 = values_[step] ;
+	return x0 + (x1 - x0) * (level - v0) / (v1 - v0) ;
+      }
+    }
+    previous = true ;
+    previousStep = step ;
+  }
+
+  return -1 ;
+}
+
+/** All the chips are written in one call of the writer: one list of accesses per ring.
+ * A chip with an access in error is written again in the next block.
+ * \param scan - scan
+ * \param chips - index of the chips to be written
+ * \param reg - register
+ * \param value - value
+ */
+std::vector<unsigned int> VfatScanEngine::writeChips ( const VfatScanDefinition &scan, const std::vector<unsigned int> &chips,
+						       VfatScanRegister reg, tscType8 value ) {
+
+  std::vector<unsigned int> pending = chips ;
+  unsigned int attempts = scan.getRetries() ? scan.getRetries() : 1 ;
+
+  for (unsigned int attempt = 0 ; (attempt < attempts) && !pending.empty() ; attempt ++) {
+
+    // One list per ring, the position of the chip is kept to find it back
+    accessDeviceTypeListMap vAccess ;
+    Sgi::hash_map<keyType, unsigned int> chipIndex ;
+    for (std::vector<unsigned int>::iterator it = pending.begin() ; it != pending.end() ; it ++) {
+      keyType key = scan.getChips()[*it] ;
+      VfatScanDefinition::addWrite (key, reg, value, vAccess[getFecRingKey(key)]) ;
+      chipIndex[key] = *it ;
+    }
+
+    // Send the block
+    std::list<FecExceptionHandler *> errorList ;
+    unsigned int error = writer_.setBlockDevices (vAccess, errorList) ;
+    blocks_ ++ ;
+
+    // Chips in error, the exceptions of the accesses are in the list
+    std::set<unsigned int> failed ;
+    unsigned int accessErrors = 0 ;
+    for (accessDeviceTypeListMap::iterator itList = vAccess.begin() ; itList != vAccess.end() ; itList ++) {
+      frames_ += itList->second.size() ;
+      for (accessDeviceTypeList::iterator itDevice = itList->second.begin() ; itDevice != itList->second.end() ; itDevice ++) {
+	if (itDevice->e != NULL) {
+	  failed.insert(chipIndex[itDevice->index]) ;
+	  accessErrors ++ ;
+	}
+      }
+    }
+    // Error on a ring without exception on the accesses: nothing is known on the chips
+    if (error > accessErrors) failed.insert (pending.begin(), pending.end()) ;
+
+    for (std::list<FecExceptionHandler *>::iterator it = errorList.begin() ; it != errorList.end() ; it ++) delete *it ;
+
+    pending.assign (failed.begin(), failed.end()) ;
+  }
+
+  return pending ;
+}
+
+/** The settings are written once on all the chips, then for each step the register is written and the measurement
+ * is called. The chips not written at a step are marked in error in the result and are still written at the next step.
+ * If a restore value is given, it is written at the end of the scan.
+ * \param scan - definition of the scan
+ * \param measurement - measurement done at each step
+ * \param result - result, resized for the scan
+ * \return number of steps of a chip in error
+ * \exception FecExceptionHandler if the definition is not valid
+ */
+unsigned int VfatScanEngine::run ( const VfatScanDefinition &scan, VfatScanMeasurement &measurement, VfatScanResult &result ) throw (FecExceptionHandler) {
+
+  scan.check() ;
+
+  std::vector<unsigned int> values = scan.getValues() ;
+  result.resize (values, scan.getChips().size(), scan.getChannels()) ;
+
+  std::vector<unsigned int> chips ;
+  for (unsigned int i = 0 ; i < scan.getChips().size() ; i ++) chips.push_back(i) ;
+
+  // Settings
+  std::set<unsigned int> notSet ;
+  for (std::vector< std::pair<VfatScanRegister, tscType8> >::const_iterator it = scan.getSettings().begin() ; it != scan.getSettings().end() ; it ++) {
+    std::vector<unsigned int> failed = writeChips (scan, chips, it->first, it->second) ;
+    notSet.insert (failed.begin(), failed.end()) ;
+  }
+
+  // Steps
+  unsigned int error = 0 ;
+  for (unsigned int step = 0 ; step < values.size() ; step ++) {
+
+    std::vector<unsigned int> failed = writeChips (scan, chips, scan.getRegister(), values[step]) ;
+    failed.insert (failed.end(), notSet.begin(), notSet.end()) ;
+    for (std::vector<unsigned int>::iterator it = failed.begin() ; it != failed.end() ; it ++) {
+      if (!result.isError (step, *it)) {
+	result.setError (step, *it) ;
+	error ++ ;
+      }
+    }
+
+    measurement.measure (scan, step, result) ;
+    for (std::vector<unsigned int>::iterator it = failed.begin() ; it != failed.end() ; it ++) {
+      unsigned int *row = result.getRow (step, *it) ;
+      for (unsigned int channel = 0 ; channel < result.getChannels() ; channel ++) row[channel] = 0 ;
+    }
+    result.setStepsDone (step + 1) ;
+
+    if (!measurement.stepDone (step, values.size())) break ;
+  }
+
+  // Restore the register
+  if (scan.getRestore()) writeChips (scan, chips, scan.getRegister(), scan.getRestoreValue()) ;
+
+  return error ;
+}
@@ -216,7 +216,7 @@ void totemBBAccess::getBlockWriteValues ( totemBBDescription tbbValues, std::lis
  * \warning if a problem occurs in one channel then 0 is set in the corresponding registers
  */
 unsigned int totemBBAccess::getValuesMultipleFrames ( FecAccess &fecAccess, 
-						      Sgi::hash_map<keyType, totemBBAccess *> &tbbSet,
+						      KeyTypeTable<totemBBAccess *> &tbbSet,
 						      deviceVector &tbbVector,
 						      std::list<FecExceptionHandler *> &errorList ) throw (FecExceptionHandler) {
 
@@ -229,7 +229,7 @@ unsigned int totemBBAccess::getValuesMultipleFrames ( FecAccess &fecAccess,
   // -------------------------------------------------------------------
   // read all the registers
   accessDeviceTypeListMap vAccessesTbb ;
-  for ( Sgi::hash_map<keyType, totemBBAccess *>::iterator itTbb = tbbSet.begin() ; itTbb != tbbSet.end() ; itTbb ++ ) {
+  for ( KeyTypeTable<totemBBAccess *>::iterator itTbb = tbbSet.begin() ; itTbb != tbbSet.end() ; itTbb ++ ) {
 
     accessDeviceType control = { itTbb->second->getKey(), NORMALMODE, MODE_READ, TBB_CONTROL, 0, false, 0, 0, 0, NULL} ;
     vAccessesTbb[getFecRingKey(itTbb->second->getKey())].push_back(control) ;
@@ -537,7 +537,7 @@ void totemCChipAccess::getBlockWriteValues ( totemCChipDescription ccValues, std
  * \warning if a problem occurs in one channel then 0 is set in the corresponding registers
  */
 unsigned int totemCChipAccess::getValuesMultipleFrames ( FecAccess &fecAccess,
-							 Sgi::hash_map<keyType, totemCChipAccess *> &ccSet,
+							 KeyTypeTable<totemCChipAccess *> &ccSet,
 							 deviceVector &ccVector,
 							 std::list<FecExceptionHandler *> &errorList ) throw (FecExceptionHandler) {
 
@@ -554,7 +554,7 @@ unsigned int totemCChipAccess::getValuesMultipleFrames ( FecAccess &fecAccess,
   // -------------------------------------------------------------------
   // read all the registers
   accessDeviceTypeListMap vAccessesCc ;
-  for ( Sgi::hash_map<keyType, totemCChipAccess *>::iterator itCc = ccSet.begin() ; itCc != ccSet.end() ; itCc ++ ) {
+  for ( KeyTypeTable<totemCChipAccess *>::iterator itCc = ccSet.begin() ; itCc != ccSet.end() ; itCc ++ ) {
 
     accessDeviceType control0 = { itCc->second->getKey(), NORMALMODE, MODE_READ, CCHIP_CONTROL0, 0, false, 0, 0, 0, NULL} ;
     vAccessesCc[getFecRingKey(itCc->second->getKey())].push_back(control0) ;
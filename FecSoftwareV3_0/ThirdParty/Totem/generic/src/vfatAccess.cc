@@ -603,7 +603,7 @@ void vfatAccess::getVfatBlockWriteValues ( vfatDescription vfatValues, std::list
  * \warning if a problem occurs in one channel then 0 is set in the corresponding registers
  */
 unsigned int vfatAccess::getVfatValuesMultipleFrames ( FecAccess &fecAccess, 
-                                                       Sgi::hash_map<keyType, vfatAccess *> &vfatSet,
+                                                       KeyTypeTable<vfatAccess *> &vfatSet,
                                                        deviceVector &vfatVector,
 						       std::list<FecExceptionHandler *> &errorList ) throw (FecExceptionHandler) {
 
@@ -620,7 +620,7 @@ unsigned int vfatAccess::getVfatValuesMultipleFrames ( FecAccess &fecAccess,
   // -------------------------------------------------------------------
   // read all the registers
   accessDeviceTypeListMap vAccessesVfat ;
-  for ( Sgi::hash_map<keyType, vfatAccess *>::iterator itVfat = vfatSet.begin() ; itVfat != vfatSet.end() ; itVfat ++ ) {
+  for ( KeyTypeTable<vfatAccess *>::iterator itVfat = vfatSet.begin() ; itVfat != vfatSet.end() ; itVfat ++ ) {
 
     accessDeviceType control0 = { itVfat->second->getKey(), NORMALMODE, MODE_READ, VFAT_CONTROL0, 0, false, 0, 0, 0, NULL} ;
     vAccessesVfat[getFecRingKey(itVfat->second->getKey())].push_back(control0) ;
@@ -0,0 +1,280 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Copyright 2002 - 2003, Frederic DROUHIN - Universite de Haute-Alsace, Mulhouse-France
+*/
+#ifndef CCUALARMDISPATCHER_H
+#define CCUALARMDISPATCHER_H
+
+#include <pthread.h>
+#include <vector>
+
+#include "tscTypes.h"
+#include "keyType.h"
+#include "FecExceptionHandler.h"
+#include "FecRingDevice.h"
+
+/** Maximum number of subscribers for one dispatcher
+ */
+#define MAXCCUALARMSUBSCRIBERS 32
+
+/** Filters for the subscription: the event is delivered if (event index & mask) == (subscription index & mask)
+ */
+#define CCUALARMFILTERALL     ((keyType)0)
+#define CCUALARMFILTERFEC     (setFecSlotKey(MASKFECKEY))
+#define CCUALARMFILTERRING    (CCUALARMFILTERFEC | setRingKey(MASKRINGKEY))
+#define CCUALARMFILTERCCU     (CCUALARMFILTERRING | setCcuKey(MASKCCUKEY))
+#define CCUALARMFILTERCHANNEL (CCUALARMFILTERCCU | setChannelKey(MASKCHANNELKEY))
+
+/** Type of the events, can be combined in the subscription
+ */
+enum enumCcuAlarmType { CCUALARMINPUT = 0x1, PIAINTERRUPT = 0x2 } ;
+
+/** Event decoded from a CCU alarm frame
+ */
+typedef struct {
+
+  /** FEC/ring/CCU/channel of the source, channel 0 for the CCU alarm inputs
+   */
+  keyType index ;
+
+  /** CCU alarm inputs or PIA interrupt
+   */
+  enumCcuAlarmType type ;
+
+  /** PIA data register bits or CCU alarm inputs
+   */
+  tscType8 status ;
+
+  /** Time of the reception of the frame in microseconds
+   */
+  unsigned long long timestamp ;
+
+} CcuAlarmEvent ;
+
+/**
+ * \class CcuAlarmQueue
+ * Bounded queue of events between the dispatcher thread (single producer) and one subscriber (single consumer).
+ * No lock is used: each side only writes its own position.
+ * \warning only one thread may call pop
+ */
+class CcuAlarmQueue {
+
+ public:
+
+  /** \brief Create a queue, the size is rounded up to a power of 2
+   */
+  CcuAlarmQueue ( unsigned int size ) ;
+
+  /** \brief Delete the events
+   */
+  ~CcuAlarmQueue ( ) ;
+
+  /** \brief Add an event, false if the queue is full (the event is lost)
+   */
+  bool push ( const CcuAlarmEvent &event ) ;
+
+  /** \brief Remove the oldest event, false if the queue is empty
+   */
+  bool pop ( CcuAlarmEvent &event ) ;
+
+  /** \brief Number of events lost because the queue was full
+   */
+  unsigned long getLost ( ) { return lost_ ; }
+
+ private:
+
+  /** Events
+   */
+  CcuAlarmEvent *events_ ;
+
+  /** Size - 1
+   */
+  unsigned int mask_ ;
+
+  /** Next position written by the producer
+   */
+  volatile unsigned int head_ ;
+
+  /** Next position read by the consumer
+   */
+  volatile unsigned int tail_ ;
+
+  /** Events lost
+   */
+  volatile unsigned long lost_ ;
+} ;
+
+/**
+ * \class CcuAlarmDispatcher
+ * Receive the CCU alarms and PIA interrupts of all the rings of a FEC with one thread and deliver them
+ * to the subscribers. The thread polls the rings with FecRingDevice::getCcuAlarmFrame, the polling period
+ * is doubled each time no frame is found (until the maximum) and set back to the minimum when a frame arrives.
+ * The frames received during a transaction (setBlockDevices) are kept by the FecRingDevice and are delivered after it.
+ * <p>Example:
+ * <pre>
+ * CcuAlarmDispatcher dispatcher ;
+ * dispatcher.addRing (fecAccess->getFecRingDevice(ringIndex)) ;
+ * unsigned int id = dispatcher.subscribe (ccuIndex, CCUALARMFILTERCCU, PIAINTERRUPT) ;
+ * dispatcher.enableSource (ccuIndex | setChannelKey(0x30)) ;
+ * dispatcher.start() ;
+ * CcuAlarmEvent event ;
+ * while (dispatcher.getEvent(id, event)) ...
+ * </pre>
+ * \brief Event driven CCU alarm and PIA interrupt dispatcher
+ * \warning the hardware interrupts are not available in user space for the bus adapters used, so the rings are polled
+ */
+class CcuAlarmDispatcher {
+
+ public:
+
+  /** \brief Create a dispatcher without ring, polling between 100 us and 10 ms
+   */
+  CcuAlarmDispatcher ( ) ;
+
+  /** \brief Stop the thread and delete the queues
+   */
+  ~CcuAlarmDispatcher ( ) ;
+
+  /** \brief Add a ring to be polled
+   * \exception FecExceptionHandler if the dispatcher is running or if the ring is on another FEC
+   */
+  void addRing ( FecRingDevice *fecRingDevice ) throw (FecExceptionHandler) ;
+
+  /** \brief Set the minimum and maximum polling periods in microseconds
+   */
+  void setPollingPeriod ( unsigned long minimum, unsigned long maximum ) ;
+
+  /** \brief Enable the CCU alarm inputs (channel 0) or the PIA interrupts (PIA channel) of a source
+   * \exception FecExceptionHandler
+   */
+  void enableSource ( keyType index ) throw (FecExceptionHandler) ;
+
+  /** \brief Register a subscriber
+   * \param index - source index
+   * \param mask - part of the index used for the filtering (CCUALARMFILTER...)
+   * \param types - types of the events delivered (enumCcuAlarmType combined)
+   * \param queueSize - maximum number of events waiting in the queue
+   * \return subscriber identifier
+   * \exception FecExceptionHandler if too many subscribers
+   */
+  unsigned int subscribe ( keyType index, keyType mask, unsigned int types = CCUALARMINPUT | PIAINTERRUPT, unsigned int queueSize = 256 ) throw (FecExceptionHandler) ;
+
+  /** \brief No more events are delivered to the subscriber
+   */
+  void unsubscribe ( unsigned int subscriber ) ;
+
+  /** \brief Retreive the next event of a subscriber without waiting
+   * \return false if no event is available
+   */
+  bool getEvent ( unsigned int subscriber, CcuAlarmEvent &event ) ;
+
+  /** \brief Number of events lost by a subscriber (queue full)
+   */
+  unsigned long getEventsLost ( unsigned int subscriber ) ;
+
+  /** \brief Start the thread
+   * \exception FecExceptionHandler if the thread cannot be created
+   */
+  void start ( ) throw (FecExceptionHandler) ;
+
+  /** \brief Stop the thread and wait for it
+   */
+  void stop ( ) ;
+
+  /** \brief Is the thread running
+   */
+  bool isRunning ( ) { return running_ ; }
+
+  /** \brief Number of events dispatched
+   */
+  unsigned long getNumberOfEvents ( ) { return events_ ; }
+
+  /** \brief Number of alarm frames which cannot be decoded and errors during the polling
+   */
+  unsigned long getNumberOfErrors ( ) { return errors_ ; }
+
+  /** \brief Number of frames read by the dispatcher which were not alarms, they are not related to any transaction
+   */
+  unsigned long getNumberOfUnexpectedFrames ( ) { return unexpectedFrames_ ; }
+
+  /** \brief Decode a CCU alarm frame
+   * \param ringIndex - FEC and ring of the frame
+   * \param frame - frame DST SRC LEN CHANNEL TRANSACTION DATA
+   * \param event - event decoded
+   * \return false if the channel is not the CCU node controller (0) or a PIA channel
+   */
+  static bool decodeFrame ( keyType ringIndex, tscType8 *frame, CcuAlarmEvent &event ) ;
+
+ private:
+
+  /** Subscription
+   */
+  typedef struct {
+    keyType index ;
+    keyType mask ;
+    unsigned int types ;
+    CcuAlarmQueue *queue ;
+    volatile bool active ;
+  } CcuAlarmSubscriber ;
+
+  /** Thread entry
+   */
+  static void *dispatcherThread ( void *arg ) ;
+
+  /** Poll the rings until stop
+   */
+  void run ( ) ;
+
+  /** Deliver an event to the subscribers
+   */
+  void dispatch ( const CcuAlarmEvent &event ) ;
+
+  /** Rings of the FEC
+   */
+  std::vector<FecRingDevice *> rings_ ;
+
+  /** Subscribers, only the first nSubscribers_ are valid
+   */
+  CcuAlarmSubscriber subscribers_[MAXCCUALARMSUBSCRIBERS] ;
+
+  /** Number of subscribers
+   */
+  volatile unsigned int nSubscribers_ ;
+
+  /** Lock between the calls to subscribe
+   */
+  pthread_mutex_t subscribeMutex_ ;
+
+  /** Thread
+   */
+  pthread_t thread_ ;
+
+  /** Thread running and stop requested
+   */
+  volatile bool running_, stopRequested_ ;
+
+  /** Polling periods in microseconds
+   */
+  unsigned long minimumPeriod_, maximumPeriod_ ;
+
+  /** Counters
+   */
+  volatile unsigned long events_, errors_, unexpectedFrames_ ;
+} ;
+
+#endif
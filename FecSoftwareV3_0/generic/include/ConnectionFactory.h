@@ -38,6 +38,7 @@
 
 #include "XMLConnection.h"
 #include "DeviceFactoryInterface.h"
+#include "DbStorage.h"
 
 typedef struct {
 
@@ -86,6 +87,10 @@ class ConnectionFactory: public DeviceFactoryInterface {
    */
   std::vector<DetGeo *> detGeoMap_ ;
 
+  /** Storage of the configuration without Oracle, not deleted by the factory
+   */
+  DbStorage *dbStorage_ ;
+
 #ifdef DATABASE
   /** \brief retreive information concerning the partition versus the version depending of the parameters passed 
    */
@@ -97,6 +102,16 @@ class ConnectionFactory: public DeviceFactoryInterface {
    */
   void getConnectionDescriptions ( bool fileUsed, unsigned int versionMajor, unsigned int versionMinor, unsigned int maskVersionMajor, unsigned int maskVersionMinor, std::string partitionName, ConnectionVector &outVector, bool allConnections = false, bool forceDbReload = false ) throw (FecExceptionHandler ) ;
 
+  /** \brief retreive the connections of a version of a partition from the storage
+   */
+  void getStorageConnections ( unsigned int versionMajor, unsigned int versionMinor, unsigned int maskVersionMajor, unsigned int maskVersionMinor, std::string partitionName, bool forceDbReload )
+    throw (FecExceptionHandler ) ;
+
+  /** \brief upload the connections in a new version of a partition in the storage
+   */
+  void setStorageConnections ( ConnectionVector connectionVector, std::string partitionName, unsigned int *versionMajor, unsigned int *versionMinor, bool majorVersion )
+    throw (FecExceptionHandler ) ;
+
  public:
 
   /** \brief Build a factory and a database access
@@ -128,6 +143,24 @@ class ConnectionFactory: public DeviceFactoryInterface {
    */
   inline ConnectionVector getConnectionVector ( ) { return connectionVector_ ; } 
 
+  // ------------------------------------------------------------------------------------------------------
+  // 
+  // Storage methods
+  //
+  // ------------------------------------------------------------------------------------------------------
+
+  /** \brief Download and upload the connections of the partitions through a storage of the configuration (NULL to stop)
+   */
+  void setStorageAccess ( DbStorage *dbStorage ) ;
+
+  /** \brief return the storage of the configuration
+   */
+  inline DbStorage *getStorageAccess ( ) { return dbStorage_ ; }
+
+  /** \brief return true if the connections of the partitions are downloaded and uploaded through the storage
+   */
+  inline bool getStorageUsed ( ) { return (dbStorage_ != NULL) ; }
+
   // ------------------------------------------------------------------------------------------------------
   // 
   // XML file methods
@@ -78,7 +78,8 @@ class DBCacheHandler
 		 unsigned int fedsize=0xea00000,
 		 unsigned int fecsize=0x800000,
 		 unsigned int consize=0x200000,
-		 bool commonmem=true
+		 bool commonmem=true,
+		 unsigned int generations=0
 		 ) ;
 
   /** Destructor */
@@ -91,7 +92,9 @@ class DBCacheHandler
   void InitialiseShareMemory(); 
 
   /**
-     Configure state method
+     Configure state method. With generations, each memory is filled in its
+     next generation and published at the end, the readers (DbClient) are
+     never blocked and always see a complete cache.
    */
 
   void FillShareMemory(bool disableApvError=false);
@@ -135,6 +138,7 @@ class DBCacheHandler
   unsigned int FEDShareMemorySize_,FECShareMemorySize_,CONShareMemorySize_;
   bool downloadFED_,downloadFEC_,downloadCON_,commonMemory_;
   bool fecChanged_,fedChanged_;
+  unsigned int generations_;
  bool o2oStatus_;
 
 };
@@ -0,0 +1,211 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+#ifndef DBFILESTORAGE_H
+#define DBFILESTORAGE_H
+
+#include <pthread.h>
+#include <sys/types.h>
+
+#include <set>
+#include <vector>
+
+#include "DbStorage.h"
+
+/** Default number of version files kept in memory
+ */
+#define DBFILESTORAGE_CACHESIZE 64
+
+/**
+ * \class DbFileStorage
+ * Storage of the configuration in a directory, used without Oracle (tests, offline operation):
+ * <ul>
+ * <li> the file index contains the partitions, the versions, the states and the runs
+ * <li> each version is a file partitionId/data_major_minor with its records, never changed once written
+ * <li> the files are written in a temporary file flushed on the disk and renamed, a reader never sees a partial
+ * file, even after a crash
+ * </ul>
+ * Several readers access the storage in parallel: the threads through a read / write lock, the processes
+ * through a shared / exclusive lock on the file lock. The index is read again when another process changed it.
+ * The last version files read are kept in memory, empty versions included.
+ * \brief File-backed storage of the configuration
+ */
+class DbFileStorage: public DbStorage {
+
+ public:
+
+  /** \brief Open or create the storage in a directory
+   */
+  DbFileStorage ( std::string directory, unsigned int cacheSize = DBFILESTORAGE_CACHESIZE ) throw (FecExceptionHandler) ;
+
+  /** \brief Release the locks
+   */
+  virtual ~DbFileStorage ( ) ;
+
+  /** \brief Directory of the storage
+   */
+  std::string getDirectory ( ) { return directory_ ; }
+
+  unsigned int createPartition ( std::string partitionName ) throw (FecExceptionHandler) ;
+  unsigned int getPartitionId ( std::string partitionName ) throw (FecExceptionHandler) ;
+  std::string getPartitionName ( unsigned int partitionId ) throw (FecExceptionHandler) ;
+  std::list<std::string> getAllPartitionNames ( ) throw (FecExceptionHandler) ;
+  std::list<std::string> getAllPartitionNamesFromCurrentState ( ) throw (FecExceptionHandler) ;
+  std::list<std::string> getAllPartitionNames ( unsigned int runNumber ) throw (FecExceptionHandler) ;
+
+  DbStorageVersion setRecords ( std::string partitionName, DbStorageData data, const DbStorageRecords &records, bool major ) throw (FecExceptionHandler) ;
+  DbStorageVersion getVersion ( std::string partitionName, DbStorageData data ) throw (FecExceptionHandler) ;
+  std::list<DbStorageVersion> getVersions ( std::string partitionName, DbStorageData data ) throw (FecExceptionHandler) ;
+  DbStorageRecords getRecords ( std::string partitionName, DbStorageData data, DbStorageVersion version, DbStorageVersion mask ) throw (FecExceptionHandler) ;
+  using DbStorage::getRecords ;
+
+  unsigned int getCurrentStateHistoryId ( ) throw (FecExceptionHandler) ;
+  unsigned int createStateHistory ( std::string stateHistoryName ) throw (FecExceptionHandler) ;
+  unsigned int getStateHistoryId ( std::string stateHistoryName ) throw (FecExceptionHandler) ;
+  std::list<std::string> getAllStateHistoryNames ( ) throw (FecExceptionHandler) ;
+  DbStorageVersion getVersion ( unsigned int stateHistoryId, std::string partitionName, DbStorageData data ) throw (FecExceptionHandler) ;
+  unsigned int setCurrentState ( unsigned int stateHistoryId ) throw (FecExceptionHandler) ;
+  unsigned int setCurrentState ( std::string partitionName, unsigned int stateHistoryId ) throw (FecExceptionHandler) ;
+
+  void setRun ( std::string partitionName, unsigned int runNumber, int runMode, int local, std::string comment ) throw (FecExceptionHandler) ;
+  void stopRun ( std::string partitionName, std::string comment ) throw (FecExceptionHandler) ;
+  unsigned int getCurrentRunNumber ( ) throw (FecExceptionHandler) ;
+  unsigned int getRunStateHistoryId ( unsigned int runNumber ) throw (FecExceptionHandler) ;
+  unsigned int copyStateForRunNumber ( unsigned int runNumber, bool allPartition ) throw (FecExceptionHandler) ;
+
+  /** \brief Number of version files read from the disk since the creation
+   */
+  unsigned long getFilesRead ( ) { return filesRead_ ; }
+
+  /** \brief Number of version files kept in memory
+   */
+  unsigned int getCachedVersions ( ) ;
+
+ private:
+
+  /** Versions of each data for each partition (partition identifier), the state 0 is the empty state
+   */
+  typedef std::map<unsigned int, std::vector<DbStorageVersion> > StateVersions ;
+
+  /** State history
+   */
+  struct State {
+    std::string name ;
+    StateVersions versions ;
+  } ;
+
+  /** Run
+   */
+  struct Run {
+    unsigned int partitionId ;
+    unsigned int stateHistoryId ;
+    int runMode ;
+    int local ;
+    bool stopped ;
+    std::string comment ;
+  } ;
+
+  /**
+   * Lock of the storage for one operation: file lock then read / write lock, the index is read again if needed
+   */
+  class Lock {
+  public:
+    Lock ( DbFileStorage &storage, bool write ) throw (FecExceptionHandler) ;
+    ~Lock ( ) ;
+  private:
+    DbFileStorage &storage_ ;
+    int fd_ ;
+  } ;
+  friend class Lock ;
+
+  /** \brief Read the index if it was changed by another process, must be called with the write lock
+   */
+  void refreshIndex ( ) throw (FecExceptionHandler) ;
+
+  /** \brief Write the index, must be called with the write lock
+   */
+  void writeIndex ( ) throw (FecExceptionHandler) ;
+
+  /** \brief Write a file through a temporary file
+   */
+  void writeFile ( std::string fileName, const std::string &content ) throw (FecExceptionHandler) ;
+
+  /** \brief Add the records of a version to records, or remove their identifiers (mask)
+   */
+  void mergeVersion ( unsigned int partitionId, DbStorageData data, DbStorageVersion version, DbStorageRecords &records, bool remove ) throw (FecExceptionHandler) ;
+
+  /** \brief Read the records of a version file
+   */
+  void readVersion ( std::string fileName, DbStorageRecords &records ) throw (FecExceptionHandler) ;
+
+  /** \brief Name of the file of a version
+   */
+  std::string getVersionFileName ( unsigned int partitionId, DbStorageData data, DbStorageVersion version ) ;
+
+  /** \brief Methods without lock
+   */
+  unsigned int findPartitionId ( std::string partitionName ) throw (FecExceptionHandler) ;
+  const State &findState ( unsigned int stateHistoryId ) throw (FecExceptionHandler) ;
+  unsigned int addState ( const State &state ) ;
+  DbStorageVersion findVersion ( unsigned int stateHistoryId, unsigned int partitionId, DbStorageData data ) throw (FecExceptionHandler) ;
+
+  /** \brief Check the data given
+   */
+  static void checkData ( DbStorageData data ) throw (FecExceptionHandler) ;
+
+  /** Directory
+   */
+  std::string directory_ ;
+
+  /** Content of the index
+   */
+  std::map<unsigned int, std::string> partitions_ ;
+  std::map<unsigned int, std::set<DbStorageVersion> > versions_ ; // key partitionId * DBSTORAGE_DATANUMBER + data
+  std::map<unsigned int, State> states_ ;
+  unsigned int currentState_ ;
+  std::map<unsigned int, Run> runs_ ;
+
+  /** Identification of the index read
+   */
+  ino_t indexInode_ ;
+  time_t indexTime_ ;
+  long indexTimeNs_ ;
+  off_t indexSize_ ;
+
+  /** Threads accessing the storage
+   */
+  pthread_rwlock_t rwlock_ ;
+
+  /** Version file kept in memory, the key is the key of versions_ and the version
+   */
+  typedef std::pair<unsigned int, DbStorageVersion> CacheKey ;
+  struct CachedVersion {
+    DbStorageRecords records ;
+    unsigned long lastUse ;
+  } ;
+
+  /** Last version files read, the readers share the cache. The least recently used version is dropped
+   * when the cache is full.
+   */
+  std::map<CacheKey, CachedVersion> cache_ ;
+  unsigned int cacheSize_ ;
+  unsigned long cacheUse_ ;
+  pthread_mutex_t cacheMutex_ ;
+  unsigned long filesRead_ ;
+} ;
+
+#endif
@@ -0,0 +1,172 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+#ifndef DBSTORAGE_H
+#define DBSTORAGE_H
+
+#include <list>
+#include <map>
+#include <string>
+#include <utility>
+
+#include "FecExceptionHandler.h"
+
+/** Data versioned per partition, as the versions of the state history (STATEHISTORY table).
+ * Only the factories with a storage access are there: FecDeviceFactory, ConnectionFactory and TkDcuInfoFactory.
+ */
+enum DbStorageData { DBSTORAGE_FEC, DBSTORAGE_CONNECTION, DBSTORAGE_DCUINFO, DBSTORAGE_MASK, DBSTORAGE_DATANUMBER } ;
+
+/** Major and minor version, 0.0 when no version exists
+ */
+typedef std::pair<unsigned int, unsigned int> DbStorageVersion ;
+
+/** XML of the records of a version (one device, one connection, ...) by identifier of the record
+ */
+typedef std::map<std::string, std::string> DbStorageRecords ;
+
+/**
+ * \class DbStorage
+ * Storage of the configuration with the semantic of the database used by the DbCommonAccess / DbAccess classes,
+ * without any dependency on Oracle:
+ * <ul>
+ * <li> partitions identified by a name and an identifier
+ * <li> for each partition, versions of each type of data (FEC devices, connections, DCU infos, mask):
+ * a major version contains all the records, a minor version only the records changed over its major version
+ * <li> a mask version contains the identifiers of the records removed at the download
+ * <li> state histories: the versions of each partition, the current state is the one used by the download,
+ * a state is never changed once created, a change of the current state creates a new state
+ * <li> runs registered with the current state
+ * </ul>
+ * \brief Versioned storage of the configuration
+ */
+class DbStorage {
+
+ public:
+
+  /** Nothing
+   */
+  virtual ~DbStorage ( ) { }
+
+  /** \brief Create a partition if it does not exist
+   * \return the partition identifier, the one of the existing partition if it already exists
+   */
+  virtual unsigned int createPartition ( std::string partitionName ) throw (FecExceptionHandler) = 0 ;
+
+  /** \brief Identifier of a partition
+   */
+  virtual unsigned int getPartitionId ( std::string partitionName ) throw (FecExceptionHandler) = 0 ;
+
+  /** \brief Name of a partition
+   */
+  virtual std::string getPartitionName ( unsigned int partitionId ) throw (FecExceptionHandler) = 0 ;
+
+  /** \brief All the partitions
+   */
+  virtual std::list<std::string> getAllPartitionNames ( ) throw (FecExceptionHandler) = 0 ;
+
+  /** \brief Partitions with a version in the current state
+   */
+  virtual std::list<std::string> getAllPartitionNamesFromCurrentState ( ) throw (FecExceptionHandler) = 0 ;
+
+  /** \brief Partitions registered for a run
+   */
+  virtual std::list<std::string> getAllPartitionNames ( unsigned int runNumber ) throw (FecExceptionHandler) = 0 ;
+
+  /** \brief Upload a new version, the version becomes the one of the current state
+   * \return the version created
+   */
+  virtual DbStorageVersion setRecords ( std::string partitionName, DbStorageData data, const DbStorageRecords &records, bool major ) throw (FecExceptionHandler) = 0 ;
+
+  /** \brief Version of a data in the current state
+   */
+  virtual DbStorageVersion getVersion ( std::string partitionName, DbStorageData data ) throw (FecExceptionHandler) = 0 ;
+
+  /** \brief Versions of a data for a partition
+   */
+  virtual std::list<DbStorageVersion> getVersions ( std::string partitionName, DbStorageData data ) throw (FecExceptionHandler) = 0 ;
+
+  /** \brief Records of a version without the records of a mask version (0.0 for no mask)
+   */
+  virtual DbStorageRecords getRecords ( std::string partitionName, DbStorageData data, DbStorageVersion version, DbStorageVersion mask ) throw (FecExceptionHandler) = 0 ;
+
+  /** \brief Records of the version of the current state with the mask of the current state
+   */
+  DbStorageRecords getRecords ( std::string partitionName, DbStorageData data ) throw (FecExceptionHandler) {
+    return getRecords (partitionName, data, getVersion (partitionName, data), getVersion (partitionName, DBSTORAGE_MASK)) ;
+  }
+
+  /** \brief Current state
+   */
+  virtual unsigned int getCurrentStateHistoryId ( ) throw (FecExceptionHandler) = 0 ;
+
+  /** \brief Copy the current state with a name, the copy becomes the current state
+   * \return the identifier of the new state
+   */
+  virtual unsigned int createStateHistory ( std::string stateHistoryName ) throw (FecExceptionHandler) = 0 ;
+
+  /** \brief Identifier of a named state
+   */
+  virtual unsigned int getStateHistoryId ( std::string stateHistoryName ) throw (FecExceptionHandler) = 0 ;
+
+  /** \brief Names of the states
+   */
+  virtual std::list<std::string> getAllStateHistoryNames ( ) throw (FecExceptionHandler) = 0 ;
+
+  /** \brief Version of a data for a partition in a state
+   */
+  virtual DbStorageVersion getVersion ( unsigned int stateHistoryId, std::string partitionName, DbStorageData data ) throw (FecExceptionHandler) = 0 ;
+
+  /** \brief Go back to a state
+   */
+  virtual unsigned int setCurrentState ( unsigned int stateHistoryId ) throw (FecExceptionHandler) = 0 ;
+
+  /** \brief Copy the current state with the versions of a partition taken in another state
+   * \return the identifier of the new current state
+   */
+  virtual unsigned int setCurrentState ( std::string partitionName, unsigned int stateHistoryId ) throw (FecExceptionHandler) = 0 ;
+
+  /** \brief Register a run with the current state
+   */
+  virtual void setRun ( std::string partitionName, unsigned int runNumber, int runMode, int local, std::string comment ) throw (FecExceptionHandler) = 0 ;
+
+  /** \brief Stop the last run of a partition
+   */
+  virtual void stopRun ( std::string partitionName, std::string comment ) throw (FecExceptionHandler) = 0 ;
+
+  /** \brief Last run number, 0 if no run was registered
+   */
+  virtual unsigned int getCurrentRunNumber ( ) throw (FecExceptionHandler) = 0 ;
+
+  /** \brief State of a run
+   */
+  virtual unsigned int getRunStateHistoryId ( unsigned int runNumber ) throw (FecExceptionHandler) = 0 ;
+
+  /** \brief Current state set from the state of a run, for all the partitions or only for the partition of the run
+   * \return the identifier of the new current state
+   */
+  virtual unsigned int copyStateForRunNumber ( unsigned int runNumber, bool allPartition ) throw (FecExceptionHandler) = 0 ;
+
+  /** \brief Buffer for the XML parsers (XMLFecDevice, XMLConnection, ...): the records between a header and a footer
+   */
+  static std::string getXMLBuffer ( const DbStorageRecords &records, std::string header, std::string footer ) {
+    std::string buffer = header ;
+    for (DbStorageRecords::const_iterator it = records.begin() ; it != records.end() ; it ++) buffer += it->second ;
+    return buffer + footer ;
+  }
+} ;
+
+#endif
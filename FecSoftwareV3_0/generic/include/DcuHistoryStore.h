@@ -0,0 +1,234 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+#ifndef DCUHISTORYSTORE_H
+#define DCUHISTORYSTORE_H
+
+#include <pthread.h>
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include "hashMapDefinition.h"
+#include "FecExceptionHandler.h"
+#include "deviceType.h"
+
+/** Number of channels of a DCU
+ */
+#define DCUHISTORY_CHANNELS 8
+
+/** Point stored for one channel of one DCU
+ */
+typedef struct {
+
+  tscType32 dcuHardId ;
+  tscType32 timeStamp ;
+  tscType16 value ;
+  tscType8 channel ;
+
+} DcuHistoryPoint ;
+
+/** Aggregate of one channel over a time window
+ */
+typedef struct {
+
+  /** Window [timeStart, timeStop[
+   */
+  tscType32 timeStart, timeStop ;
+
+  /** Number of points stored in the window, the other values are 0 if there is no point
+   */
+  unsigned int points ;
+
+  /** Minimum, maximum and last value stored
+   */
+  tscType16 min, max, last ;
+
+  /** Mean of the values interpolated between the points stored (mean of the points if they have the same time)
+   */
+  double mean ;
+
+} DcuHistoryAggregate ;
+
+/**
+ * \class DcuHistoryStore
+ * Local history of the DCU raw values, used by the DcuFilter before the upload:
+ * <ul>
+ * <li> deadband: a DCU is significant when one channel moved by more than its deadband since the last DCU
+ *      significant or when it was not significant since the maximum silence. Only the significant DCUs need
+ *      to be uploaded.
+ * <li> swinging door compression: a value is stored only when the line from the last point stored cannot
+ *      follow the values received within the compression deviation of the channel.
+ * <li> the points are appended to segment files of the directory, a segment is closed when it is full and
+ *      its time range is then appended to the index file, the segments are never changed once closed.
+ * <li> the queries read only the segments in the time range and the values not yet stored.
+ * </ul>
+ * <pre>
+ * DcuHistoryStore history ("/tmp/DcuHistory") ;
+ * history.setDeadband (3) ; history.setCompressionDeviation (2) ;
+ * deviceVector significant ;
+ * history.add (vDevice, significant) ;
+ * uploadDcuToDatabase (significant) ;
+ * </pre>
+ * \brief Compressed history of the DCU values with deadband filtering
+ * \warning the values of a DCU which are not more recent than the last values received for this DCU are ignored
+ */
+class DcuHistoryStore {
+
+ public:
+
+  /** \brief Open or create the history in a directory
+   */
+  DcuHistoryStore ( std::string directory, unsigned int segmentPoints = 1000000 ) throw (FecExceptionHandler) ;
+
+  /** \brief Store the values held and close the segment
+   */
+  ~DcuHistoryStore ( ) ;
+
+  /** \brief Deadband of one channel or of all channels (ADC counts, 0 by default: every change is significant)
+   */
+  void setDeadband ( tscType16 deadband, int channel = -1 ) throw (FecExceptionHandler) ;
+
+  /** \brief Compression deviation of one channel or of all channels (ADC counts, 0 by default: every change is stored)
+   */
+  void setCompressionDeviation ( tscType16 deviation, int channel = -1 ) throw (FecExceptionHandler) ;
+
+  /** \brief Maximum time in seconds without a DCU significant or a point stored for a channel (1 hour by default)
+   */
+  void setMaximumSilence ( tscType32 maximumSilence ) { maximumSilence_ = maximumSilence ; }
+
+  /** \brief Add the values of a DCU
+   */
+  bool add ( dcuDescription &dcu ) throw (FecExceptionHandler) ;
+
+  /** \brief Add the values of the DCUs of a vector
+   */
+  unsigned int add ( deviceVector &dcus, deviceVector &significant ) throw (FecExceptionHandler) ;
+
+  /** \brief Store the values held and write the points
+   */
+  void flush ( ) throw (FecExceptionHandler) ;
+
+  /** \brief Points of a channel in a time range
+   */
+  void getPoints ( tscType32 dcuHardId, unsigned int channel, tscType32 timeStart, tscType32 timeStop, std::vector<DcuHistoryPoint> &points ) throw (FecExceptionHandler) ;
+
+  /** \brief Aggregate of a channel in a time range
+   */
+  DcuHistoryAggregate getAggregate ( tscType32 dcuHardId, unsigned int channel, tscType32 timeStart, tscType32 timeStop ) throw (FecExceptionHandler) ;
+
+  /** \brief Aggregates of a channel in consecutive windows of a time range
+   */
+  std::vector<DcuHistoryAggregate> getAggregates ( tscType32 dcuHardId, unsigned int channel, tscType32 timeStart, tscType32 timeStop, tscType32 window ) throw (FecExceptionHandler) ;
+
+  /** \brief Number of values received, of points stored, of DCUs received and significant, of segments
+   */
+  unsigned long getNumberOfValues ( ) { return values_ ; }
+  unsigned long getNumberOfPoints ( ) { return points_ ; }
+  unsigned long getNumberOfDcus ( ) { return dcus_ ; }
+  unsigned long getNumberOfSignificant ( ) { return significant_ ; }
+  unsigned int getNumberOfSegments ( ) { return segments_.size() ; }
+
+  /** \brief Directory of the history
+   */
+  std::string getDirectory ( ) { return directory_ ; }
+
+ private:
+
+  /** Compression state of one channel
+   */
+  typedef struct {
+    tscType32 storedTime, heldTime ;
+    tscType16 storedValue, heldValue, significantValue ;
+    double slopeMin, slopeMax ;
+  } ChannelState ;
+
+  /** State of one DCU
+   */
+  typedef struct {
+    ChannelState channels[DCUHISTORY_CHANNELS] ;
+    tscType32 lastTime, significantTime ;
+  } DcuState ;
+
+  /** Segment of the directory
+   */
+  typedef struct {
+    std::string fileName ;
+    tscType32 timeStart, timeStop ;
+    unsigned int points ;
+  } Segment ;
+
+  /** \brief Add the values of a DCU, must be called with the mutex
+   */
+  bool addValues ( dcuDescription &dcu ) throw (FecExceptionHandler) ;
+
+  /** \brief Store a point in the current segment
+   */
+  void storePoint ( tscType32 dcuHardId, unsigned int channel, tscType32 timeStamp, tscType16 value ) throw (FecExceptionHandler) ;
+
+  /** \brief Write the points of the buffer in the current segment
+   */
+  void writeBuffer ( ) throw (FecExceptionHandler) ;
+
+  /** \brief Close the current segment and append it to the index
+   */
+  void closeSegment ( ) throw (FecExceptionHandler) ;
+
+  /** \brief Read the points of a channel from a segment file
+   */
+  void readSegment ( const Segment &segment, tscType32 dcuHardId, unsigned int channel, tscType32 timeStart, tscType32 timeStop, std::vector<DcuHistoryPoint> &points ) throw (FecExceptionHandler) ;
+
+  /** \brief Check the channel given
+   */
+  static void checkChannel ( int channel ) throw (FecExceptionHandler) ;
+
+  /** Directory and number of points of a segment
+   */
+  std::string directory_ ;
+  unsigned int segmentPoints_ ;
+
+  /** Deadband and compression deviation of each channel, maximum silence
+   */
+  tscType16 deadband_[DCUHISTORY_CHANNELS] ;
+  tscType16 deviation_[DCUHISTORY_CHANNELS] ;
+  tscType32 maximumSilence_ ;
+
+  /** State of the DCUs
+   */
+  Sgi::hash_map<unsigned long, DcuState> dcuStates_ ;
+
+  /** Segments closed and current segment (last one of segments_ when segmentFile_ is open)
+   */
+  std::vector<Segment> segments_ ;
+  FILE *segmentFile_ ;
+  unsigned int segmentNumber_ ;
+
+  /** Points not yet written
+   */
+  std::vector<unsigned char> buffer_ ;
+
+  /** Counters
+   */
+  unsigned long values_, points_, dcus_, significant_ ;
+
+  /** Access from several threads
+   */
+  pthread_mutex_t mutex_ ;
+} ;
+
+#endif
@@ -0,0 +1,191 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Copyright 2002 - 2003, Frederic DROUHIN - Universite de Haute-Alsace, Mulhouse-France
+*/
+#ifndef DEVICEDESCRIPTIONPOOL_H
+#define DEVICEDESCRIPTIONPOOL_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "tscTypes.h"
+#include "keyType.h"
+#include "deviceType.h"
+#include "FecExceptionHandler.h"
+
+/** Handle on a value stored in a DeviceDescriptionPool
+ */
+typedef unsigned int internHandleType ;
+
+/** Device description stored in a DeviceDescriptionPool: the FEC hardware id and the registers
+ * are handles on the values of the pool
+ */
+typedef struct {
+
+  /** FEC, ring, CCU, channel, address
+   */
+  keyType accessKey ;
+
+  /** FEC hardware id
+   */
+  internHandleType fecHardwareId ;
+
+  /** Register values, two devices with the same values have the same handle
+   */
+  internHandleType registers ;
+
+  /** Crate and VME controller daisy chain
+   */
+  tscType16 crateId, vmeControllerDaisyChainId ;
+
+  /** Device type (enumDeviceType)
+   */
+  tscType8 deviceType ;
+
+  /** Device enabled
+   */
+  bool enabled ;
+
+} internedDeviceType ;
+
+/** Vector of devices stored in a DeviceDescriptionPool
+ */
+typedef std::vector<internedDeviceType> internedDeviceVector ;
+
+/**
+ * \class DeviceDescriptionPool
+ * Store each FEC hardware id and each set of register values only once and describe the devices
+ * with handles on them. A full tracker partition has about 100000 devices but only a few FEC hardware
+ * ids and a few thousands of different register sets, an interned device takes 20 bytes instead of
+ * a description of about 150 bytes allocated on the heap. The copy of an interned vector is a copy of memory
+ * and the comparison of the registers of two devices is a comparison of handles.
+ * <p>Example:
+ * <pre>
+ * DeviceDescriptionPool pool ;
+ * internedDeviceVector reference, uploaded ;
+ * pool.intern (vDevicesDownloaded, reference) ;
+ * pool.intern (vDevicesUploaded, uploaded) ;
+ * std::vector<keyType> differences ;
+ * pool.compare (reference, uploaded, differences) ;
+ * </pre>
+ * \brief Interning of the device descriptions
+ * \warning the APV, PLL, APV MUX, laserdriver, DOH and Philips are interned. The other devices (DCU) are measurements
+ * and are not interned, they are returned in a separate vector.
+ * \warning the handles are valid only with the pool which created them, the pool only grows until clear.
+ */
+class DeviceDescriptionPool {
+
+ public:
+
+  /** \brief Empty pool
+   */
+  DeviceDescriptionPool ( ) ;
+
+  /** \brief Remove all the values, the handles are not valid anymore
+   */
+  void clear ( ) ;
+
+  /** \brief Store a string
+   */
+  internHandleType internString ( const std::string &value ) ;
+
+  /** \brief String of a handle
+   * \exception FecExceptionHandler if the handle is not valid
+   */
+  const std::string &getString ( internHandleType handle ) throw (FecExceptionHandler) ;
+
+  /** \brief Store register values
+   */
+  internHandleType internRegisters ( const std::string &values ) ;
+
+  /** \brief Register values of a handle
+   * \exception FecExceptionHandler if the handle is not valid
+   */
+  const std::string &getRegisters ( internHandleType handle ) throw (FecExceptionHandler) ;
+
+  /** \brief Store a device description
+   * \return false if the device type is not interned
+   */
+  bool intern ( deviceDescription *device, internedDeviceType &interned ) ;
+
+  /** \brief Store a vector of devices
+   * \param src - devices to be stored
+   * \param dst - devices interned
+   * \param notInterned - if not NULL, the devices which are not interned are added (not copied)
+   * \param allDevices - also the devices disabled
+   */
+  void intern ( deviceVector &src, internedDeviceVector &dst, deviceVector *notInterned = NULL, bool allDevices = true ) ;
+
+  /** \brief Build a device description
+   * \warning the description must be deleted by the caller
+   * \exception FecExceptionHandler if the handles are not valid
+   */
+  deviceDescription *build ( const internedDeviceType &interned ) throw (FecExceptionHandler) ;
+
+  /** \brief Build a vector of device descriptions
+   * \warning the descriptions must be deleted by the caller
+   * \exception FecExceptionHandler if the handles are not valid
+   */
+  void build ( internedDeviceVector &src, deviceVector &dst ) throw (FecExceptionHandler) ;
+
+  /** \brief Same device type and same register values
+   * \warning all the registers are compared, also the APV error register which is not compared by apvDescription::operator==
+   */
+  static inline bool equalRegisters ( const internedDeviceType &d1, const internedDeviceType &d2 ) {
+    return (d1.registers == d2.registers) && (d1.deviceType == d2.deviceType) ;
+  }
+
+  /** \brief Compare the devices with the same key
+   * \param reference - reference values
+   * \param values - values to be compared
+   * \param differences - keys of the devices which are different or which are only in one of the vectors
+   * \return number of differences
+   */
+  unsigned int compare ( internedDeviceVector &reference, internedDeviceVector &values, std::vector<keyType> &differences ) ;
+
+  /** \brief Number of strings stored
+   */
+  unsigned int getNumberOfStrings ( ) { return strings_.size() ; }
+
+  /** \brief Number of register sets stored
+   */
+  unsigned int getNumberOfRegisters ( ) { return registers_.size() ; }
+
+  /** \brief Approximate memory used by the pool in bytes
+   */
+  unsigned long getMemorySize ( ) ;
+
+ private:
+
+  /** \brief Store a value in a table
+   */
+  static internHandleType internValue ( const std::string &value, std::vector<std::string> &values, std::map<std::string, internHandleType> &index ) ;
+
+  /** Strings and their index
+   */
+  std::vector<std::string> strings_ ;
+  std::map<std::string, internHandleType> stringIndex_ ;
+
+  /** Register values, the first byte is the device type
+   */
+  std::vector<std::string> registers_ ;
+  std::map<std::string, internHandleType> registerIndex_ ;
+} ;
+
+#endif
@@ -23,6 +23,7 @@
 #include <fstream>
 
 #include "hashMapDefinition.h" // For hash_map
+#include "KeyTypeTable.h"
 
 // All types
 #include "tscTypes.h"
@@ -57,21 +58,21 @@
 // FecAccess class
 
 // Manage all the FecRingDevice class needed (one per FEC)
-typedef Sgi::hash_map<keyType, FecRingDevice *> fecMapAccessedType ;
+typedef KeyTypeTable<FecRingDevice *> fecMapAccessedType ;
 
 #if defined(BUSVMECAENPCI) || defined(BUSVMECAENUSB) || defined (BUSVMESBS)
 // Manage all the CCSTrigger object (one per FEC)
-typedef Sgi::hash_map<keyType, CCSTrigger *> ccsTriggerMapAccessedType ;
+typedef KeyTypeTable<CCSTrigger *> ccsTriggerMapAccessedType ;
 
 // FEC VME Temperature register by FEC slot
-typedef Sgi::hash_map<keyType, FecVmeTemperature *> fecTemperatureMapAccessedType ;
+typedef KeyTypeTable<FecVmeTemperature *> fecTemperatureMapAccessedType ;
 #endif
 
 // Manage all the conccurent access to the channels
-typedef Sgi::hash_map<keyType, unsigned int> channelMapAccessedType ;
+typedef KeyTypeTable<unsigned int> channelMapAccessedType ;
 
 // Manage all the real hardware acesses
-typedef Sgi::hash_map<keyType, ccuChannelAccess *> deviceMapAccessedType  ;
+typedef KeyTypeTable<ccuChannelAccess *> deviceMapAccessedType  ;
 
 // Table with the FEC hardware id to find the index
 typedef Sgi::hash_map<const char *, keyType, eqstr, eqstr> fecHardwareIdMapIndexType ;
@@ -232,6 +233,10 @@ class FecAccess {
 			  bool invertClockPolarity ) 
     throw (FecExceptionHandler) ;
 
+  /** \brief Download a block of frames in parallel on all rings, the errors are given to the list or to the recorder
+   */
+  unsigned int setBlockDevicesParallel ( accessDeviceTypeListMap &hAccesses, std::list<FecExceptionHandler *> &errorList, FecErrorRecorder *errorRecorder, bool piaChannel, bool debugMessageDisplay ) ;
+
  public:
 
   // ---------------------------- Constructors and destructor
@@ -1032,6 +1037,14 @@ class FecAccess {
    */
   unsigned int setBlockDevicesParallel ( accessDeviceTypeListMap &hAccesses, std::list<FecExceptionHandler *> &errorList, bool piaChannel = false, bool debugMessageDisplay = false ) ;
 
+  /** \brief Download a block of frames, the errors are recorded
+   */
+  unsigned int setBlockDevices ( keyType index, accessDeviceTypeList &vAccesses, FecErrorRecorder &errorRecorder, bool piaChannel = false ) ;
+
+  /** \brief Download a block of frames to all rings, the errors are recorded
+   */
+  unsigned int setBlockDevices ( accessDeviceTypeListMap &hAccesses, FecErrorRecorder &errorRecorder, bool piaChannel = false ) ;
+
   /** \brief Read a value from the device specified in the key
    */
   tscType8 read (keyType index)  
@@ -236,6 +236,10 @@ class FecAccessManager {
   unsigned int parseTbb ( totemBBDescription tbbDevice, std::list<FecExceptionHandler *> &errorList, bool setIt = true ) ;
 #endif // TOTEM
 
+  /** \brief Download a block of frames, the errors of the frames are recorded and one exception per device is given to the list
+   */
+  unsigned int setBlockDevices ( accessDeviceTypeListMap &vAccessDevices, std::list<FecExceptionHandler *> &errorList ) ;
+
  public:
 
   /** \brief Initialisation
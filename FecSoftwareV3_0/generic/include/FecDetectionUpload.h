@@ -34,6 +34,7 @@
 
 #include "deviceType.h"
 #include "TkRingDescription.h"
+#include "TkRingRedundancyPlanner.h"
 
 #if defined(BUSVMECAENPCI) || defined(BUSVMECAENUSB) || defined (BUSVMESBS)
 #include "FecVmeRingDevice.h"
@@ -43,6 +44,44 @@
 
 #define NOFECRING 0xFFFFFFFF
 
+/** Class TkRingFecAccess
+ * Access to one ring through FecAccess for the redundancy planner
+ */
+class TkRingFecAccess: public TkRingAccess {
+
+ public:
+
+  /** \param fecAccess - access to the FEC
+   * \param index - index of the ring
+   */
+  TkRingFecAccess ( FecAccess &fecAccess, keyType index ): fecAccess_(fecAccess), index_(index) { }
+
+  /** Apply the redundancy on the ring
+   */
+  tscType16 fecRingReconfigure ( TkRingDescription &tkRing ) throw (FecExceptionHandler) {
+    return fecAccess_.fecRingReconfigure (index_, tkRing) ;
+  }
+
+  /** Scan the ring for the CCUs, an empty list is returned if no CCU answers
+   * \exception FecExceptionHandler if the ring cannot be scanned
+   */
+  std::list<keyType> *getCcuList ( ) throw (FecExceptionHandler) {
+    std::list<keyType> *ccuList = fecAccess_.getCcuList (index_) ;
+    if (ccuList == NULL) ccuList = new std::list<keyType> ;
+    return ccuList ;
+  }
+
+ private:
+
+  /** Access to the FEC
+   */
+  FecAccess &fecAccess_ ;
+
+  /** Index of the ring
+   */
+  keyType index_ ;
+} ;
+
 /** Class FecDetectionUpload
  * This class detects the FEC into a crate and upload the definition in a file or in the TK configuration database.
  * The creation of the hardware access (FecAccess object) has been done before and the system will "just" detect the devices
@@ -2556,6 +2595,92 @@ class FecDetectionUpload {
 
     return error ;
   }
+
+  /** This method looks for a redundancy configuration which recovers a broken ring.
+   * The symptoms (FEC SR0, CCUs answering, CCU status registers) are read on the ring and the configurations
+   * are applied in the order given by the TkRingRedundancyPlanner until the ring is closed and all the CCUs kept are found.
+   * \param fecAccess - access to the FEC
+   * \param index - index of the ring
+   * \param tkRing - ring description, set to the configuration applied if the ring is recovered
+   * \param errorReportLogger - to report the error
+   * \param maximumConfigurations - maximum number of configurations tried (0 for all)
+   * \return true if an error occurs (same as setRedundancy)
+   */
+  static bool planRedundancy ( FecAccess &fecAccess, keyType index, TkRingDescription &tkRing, ErrorReportLogger &errorReportLogger, unsigned int maximumConfigurations = 0 ) {
+
+    TkRingRedundancyPlanner planner ;
+    planner.setMaximumConfigurations (maximumConfigurations) ;
+
+    // -------------------------------------------------------------------------
+    // Symptoms
+    try {
+      planner.setFecSR0 (fecAccess.getFecRingSR0(index)) ;
+    }
+    catch (FecExceptionHandler &e) {
+      std::stringstream msgError ; msgError << "Unable to retreive FEC status on FEC " << (int) getFecKey(index) << " ring " << (int) getRingKey(index) << ": " << e.what() ;
+      errorReportLogger.errorReport (msgError.str(), LOGERROR) ;
+      return true ;
+    }
+
+    // A ring which cannot be scanned gives no CCU list to the planner, which is not the same as no CCU found
+    TkRingFecAccess ringAccess (fecAccess, index) ;
+    std::list<keyType> *ccuList = NULL ;
+    try {
+      ccuList = ringAccess.getCcuList() ;
+    }
+    catch (FecExceptionHandler &e) {
+      std::stringstream msgError ; msgError << "Unable to scan the CCUs on FEC " << (int) getFecKey(index) << " ring " << (int) getRingKey(index) << ", the plan is made without the scan: " << e.what() ;
+      errorReportLogger.errorReport (msgError.str(), LOGWARNING) ;
+    }
+    if (ccuList != NULL) {
+      planner.setCcuList (*ccuList) ;
+      for (std::list<keyType>::iterator it = ccuList->begin() ; it != ccuList->end() ; it ++) {
+	try {
+	  planner.setCcuStatus (*it, fecAccess.getCcuSRA(*it), fecAccess.getCcuSRC(*it)) ;
+	}
+	catch (FecExceptionHandler &e) { }
+      }
+      delete ccuList ;
+    }
+
+    if (!planner.isRecoveryNeeded(tkRing)) return false ;
+
+    // -------------------------------------------------------------------------
+    // Apply the plan
+    bool recovered = false ;
+    try {
+      recovered = planner.apply (ringAccess, tkRing) ;
+    }
+    catch (FecExceptionHandler &e) {
+      std::stringstream msgError ; msgError << "Unable to plan the redundancy on FEC " << (int) getFecKey(index) << " ring " << (int) getRingKey(index) << ": " << e.what() ;
+      errorReportLogger.errorReport (msgError.str(), LOGERROR) ;
+      return true ;
+    }
+
+    const std::vector<TkRingRedundancyPlanner::Attempt> &attempts = planner.getAttempts() ;
+    for (std::vector<TkRingRedundancyPlanner::Attempt>::const_iterator it = attempts.begin() ; it != attempts.end() ; it ++) {
+      std::stringstream msgInfo ; 
+      msgInfo << "Redundancy on FEC " << (int) getFecKey(index) << "." << (int) getRingKey(index) << ": " ;
+      TkRingRedundancyPlanner::display (msgInfo, tkRing, planner.getConfigurations()[it->configuration_]) ;
+      msgInfo << " returns the status 0x" << std::hex << it->fecSR0_ << std::dec << " with " << it->ccusFound_ << " CCUs" ;
+      if (it->error_.size()) msgInfo << ": " << it->error_ ;
+      errorReportLogger.errorReport (msgInfo.str(), LOGDEBUG) ;
+    }
+
+    if (recovered) {
+      std::stringstream msgInfo ; 
+      msgInfo << "The ring on FEC " << (int) getFecKey(index) << "." << (int) getRingKey(index) << " was recovered after " << attempts.size() << " attempts: " ;
+      tkRing.display(msgInfo) ;
+      errorReportLogger.errorReport (msgInfo.str(), LOGUSERINFO) ;
+    }
+    else {
+      std::stringstream msgError ; 
+      msgError << "No redundancy configuration recovers the ring on FEC " << (int) getFecKey(index) << "." << (int) getRingKey(index) << " after " << attempts.size() << " attempts" ;
+      errorReportLogger.errorReport (msgError.str(), LOGERROR) ;
+    }
+
+    return !recovered ;
+  }
 } ;
 
 #endif
@@ -0,0 +1,156 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+#ifndef FECDEVICEDIFF_H
+#define FECDEVICEDIFF_H
+
+#include <string>
+#include <vector>
+
+#include "tscTypes.h"
+#include "keyType.h"
+#include "deviceType.h"
+#include "DeviceDescriptionPool.h"
+
+/** Difference found for a device
+ */
+enum enumDeviceDiff { DEVICEADDED, DEVICEREMOVED, DEVICEMODIFIED } ;
+
+/** Difference of one register or one parameter of a device
+ */
+typedef struct {
+
+  /** Parameter name of the description (apvDescription::APVPARAMETERNAMES, ...)
+   */
+  std::string registerName ;
+
+  /** Old and new values
+   */
+  unsigned int oldValue, newValue ;
+
+  /** Old and new values of the parameters which are not numbers (FEC hardware id)
+   */
+  std::string oldText, newText ;
+
+} registerDiffType ;
+
+/** Difference of one device between two versions
+ */
+typedef struct {
+
+  /** Device index
+   */
+  keyType index ;
+
+  /** Device type
+   */
+  enumDeviceType deviceType ;
+
+  /** Device added, removed or modified
+   */
+  enumDeviceDiff diff ;
+
+  /** Registers changed for a device modified
+   */
+  std::vector<registerDiffType> registers ;
+
+} deviceDiffType ;
+
+/**
+ * \class FecDeviceDiff
+ * Difference between two versions of the FEC devices (for example two versions of a partition downloaded
+ * by FecDeviceFactory::getFecDeviceDescriptions or a version and the devices to be uploaded).
+ * The devices are matched by crate and key through a hash table and compared through a DeviceDescriptionPool:
+ * two devices with the same registers have the same handle, the registers are only decoded for the
+ * devices modified.
+ * <p>Example:
+ * <pre>
+ * FecDeviceDiff diff (vDevicesVersion12_3, vDevicesVersion12_7) ;
+ * if (!diff.empty()) std::cout << diff.getSummary() ;
+ * </pre>
+ * \brief Device level difference between two configuration versions
+ * \warning the APV, PLL, APV MUX, laserdriver, DOH and Philips are compared register by register. The other
+ * devices are compared with the operator of their description (DCU, DELAY25, GOH, ...) and are always modified
+ * when their type has no comparison (VFAT, CChip, TBB), so that an upload is never skipped for them.
+ */
+class FecDeviceDiff {
+
+ public:
+
+  /** \brief Empty difference
+   */
+  FecDeviceDiff ( ) ;
+
+  /** \brief Difference from the reference to the values
+   */
+  FecDeviceDiff ( deviceVector &reference, deviceVector &values ) ;
+
+  /** \brief Compare two vectors of devices, the previous difference is cleared
+   * \param reference - old version
+   * \param values - new version
+   * \return number of devices added, removed or modified
+   */
+  unsigned int compare ( deviceVector &reference, deviceVector &values ) ;
+
+  /** \brief No difference
+   */
+  bool empty ( ) { return differences_.empty() ; }
+
+  /** \brief Differences sorted by key
+   */
+  const std::vector<deviceDiffType> &getDifferences ( ) { return differences_ ; }
+
+  /** \brief Number of devices added, removed, modified
+   */
+  unsigned int getNumberOfAdded ( ) { return added_ ; }
+  unsigned int getNumberOfRemoved ( ) { return removed_ ; }
+  unsigned int getNumberOfModified ( ) { return modified_ ; }
+
+  /** \brief Number of devices compared (new version)
+   */
+  unsigned int getNumberOfDevices ( ) { return devices_ ; }
+
+  /** \brief Human readable summary
+   * \param maximum - maximum number of devices displayed, 0 for all
+   */
+  std::string getSummary ( unsigned int maximum = 0 ) ;
+
+  /** \brief Name of a device type
+   */
+  static std::string getDeviceTypeName ( enumDeviceType deviceType ) ;
+
+ private:
+
+  /** \brief Registers of two interned devices with the same key and type
+   */
+  void compareRegisters ( const internedDeviceType &oldDevice, const internedDeviceType &newDevice, deviceDiffType &diff ) ;
+
+  /** \brief Add a register changed
+   */
+  static void addRegister ( deviceDiffType &diff, const char *registerName, unsigned int oldValue, unsigned int newValue ) ;
+
+  /** Pool used for the comparison
+   */
+  DeviceDescriptionPool pool_ ;
+
+  /** Differences
+   */
+  std::vector<deviceDiffType> differences_ ;
+  unsigned int added_, removed_, modified_, devices_ ;
+} ;
+
+#endif
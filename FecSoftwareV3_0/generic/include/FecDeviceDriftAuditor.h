@@ -0,0 +1,326 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Copyright 2002 - 2003, Frederic DROUHIN - Universite de Haute-Alsace, Mulhouse-France
+*/
+#ifndef FECDEVICEDRIFTAUDITOR_H
+#define FECDEVICEDRIFTAUDITOR_H
+
+#include <pthread.h>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "tscTypes.h"
+#include "keyType.h"
+#include "deviceType.h"
+#include "FecExceptionHandler.h"
+#include "FecAccessManager.h"
+
+/** Default budget for one ring and one step: 2 ms and 64 register reads
+ */
+#define DRIFTAUDITTIMEBUDGET  2000
+#define DRIFTAUDITFRAMEBUDGET 64
+
+/** Default number of rewrites of a register before the auditor only reports it
+ */
+#define DRIFTAUDITMAXREWRITES 3
+
+/** Action done when a register is different from the reference:
+ * <ul>
+ * <li>DRIFTREPORT: the drift is only recorded
+ * <li>DRIFTREWRITEREGISTER: the registers different are written again with the reference value (APV) or the device is downloaded (other devices)
+ * <li>DRIFTREWRITEDEVICE: the complete reference of the device is downloaded again
+ * </ul>
+ */
+enum enumDriftPolicy { DRIFTREPORT, DRIFTREWRITEREGISTER, DRIFTREWRITEDEVICE } ;
+
+/** Drift of one register of a device
+ */
+typedef struct {
+
+  /** Device index
+   */
+  keyType index ;
+
+  /** Device type
+   */
+  enumDeviceType deviceType ;
+
+  /** Register name (parameter name of the description)
+   */
+  std::string registerName ;
+
+  /** Reference value and last value read
+   */
+  unsigned int expected, read ;
+
+  /** First and last time the drift was found in microseconds
+   */
+  unsigned long long firstSeen, lastSeen ;
+
+  /** Number of audits which found the drift
+   */
+  unsigned long count ;
+
+  /** Number of rewrites done for this register
+   */
+  unsigned long rewrites ;
+
+  /** False when the last audit found the register equal to the reference
+   */
+  bool active ;
+
+} deviceDriftType ;
+
+/** Register of a device read for the audit
+ */
+typedef struct {
+
+  /** Register name (parameter name of the description)
+   */
+  const char *name ;
+
+  /** Value in the reference and value read on the hardware
+   */
+  unsigned int expected, read ;
+
+} driftRegisterType ;
+
+/**
+ * \class FecDeviceDriftAccess
+ * Read and write of the devices audited. FecDeviceDriftFecAccess uses the devices of a FecAccessManager,
+ * another implementation can simulate the devices.
+ * \brief Access to the devices for the drift auditor
+ */
+class FecDeviceDriftAccess {
+
+ public:
+
+  virtual ~FecDeviceDriftAccess ( ) { }
+
+  /** \brief Type and index of the devices to be audited
+   */
+  virtual void getDevices ( std::vector< std::pair<enumDeviceType, keyType> > &devices ) = 0 ;
+
+  /** \brief Take the lock of a ring if it is not used by another thread
+   * \param ringIndex - FEC and ring
+   * \return false if the ring is used
+   */
+  virtual bool tryLockRing ( keyType ringIndex ) = 0 ;
+
+  /** \brief Release the lock taken by tryLockRing
+   */
+  virtual void unlockRing ( keyType ringIndex ) = 0 ;
+
+  /** \brief Read the registers of a device, one frame per register
+   * \param registers - registers with the value in the reference and the value read
+   * \return false if the device has no reference
+   */
+  virtual bool readRegisters ( enumDeviceType deviceType, keyType index, std::vector<driftRegisterType> &registers ) throw (FecExceptionHandler) = 0 ;
+
+  /** \brief Write one register of an APV
+   */
+  virtual void writeRegister ( enumDeviceType deviceType, keyType index, const char *registerName, unsigned int value ) throw (FecExceptionHandler) = 0 ;
+
+  /** \brief Download again the reference of a device
+   */
+  virtual void writeDevice ( enumDeviceType deviceType, keyType index ) throw (FecExceptionHandler) = 0 ;
+} ;
+
+/**
+ * \class FecDeviceDriftFecAccess
+ * The reference of a device is the description given for the last download (deviceAccess::getDownloadedValues).
+ * \brief Access to the devices downloaded by a FecAccessManager
+ */
+class FecDeviceDriftFecAccess: public FecDeviceDriftAccess {
+
+ public:
+
+  FecDeviceDriftFecAccess ( FecAccessManager *fecAccessManager ): fecAccessManager_(fecAccessManager) { }
+
+  void getDevices ( std::vector< std::pair<enumDeviceType, keyType> > &devices ) ;
+  bool tryLockRing ( keyType ringIndex ) ;
+  void unlockRing ( keyType ringIndex ) ;
+  bool readRegisters ( enumDeviceType deviceType, keyType index, std::vector<driftRegisterType> &registers ) throw (FecExceptionHandler) ;
+  void writeRegister ( enumDeviceType deviceType, keyType index, const char *registerName, unsigned int value ) throw (FecExceptionHandler) ;
+  void writeDevice ( enumDeviceType deviceType, keyType index ) throw (FecExceptionHandler) ;
+
+ private:
+
+  /** \brief Ring of a device, NULL if the ring does not exist
+   */
+  FecRingDevice *getFecRingDevice ( keyType ringIndex ) ;
+
+  FecAccessManager *fecAccessManager_ ;
+} ;
+
+/**
+ * \class FecDeviceDriftAuditor
+ * Compare continuously the registers of the devices downloaded by a FecAccessManager with their reference
+ * (FecAccessManager::downloadValues). The devices are audited ring by ring and each call to auditStep audits,
+ * for each ring, the next devices until the time budget or the frame budget of the ring is reached.
+ * A ring used by another thread (download, upload, scan) is skipped for the step so the configuration
+ * traffic is never delayed by more than the audit of one device.
+ * The drifts are kept in a database by device and register with the first/last time seen and the
+ * number of occurrences, the registers can be written again depending of the policy.
+ * <p>Example:
+ * <pre>
+ * FecDeviceDriftFecAccess access (fecAccessManager) ;
+ * FecDeviceDriftAuditor auditor (access, DRIFTREWRITEREGISTER) ;
+ * auditor.setBudget (1000, 32) ;
+ * while (running) {
+ *   auditor.auditStep (errorList) ;
+ *   ...
+ * }
+ * std::list<deviceDriftType> drifts = auditor.getDrifts() ;
+ * </pre>
+ * \brief Budgeted audit of the registers of the front-end devices against their reference
+ * \warning the APVs are audited register by register (one frame per register). The PLL, laserdriver, DOH, APV MUX and Philips
+ * are read with getValues and downloaded completly when a rewrite is needed. The DCUs and PIA resets have no reference and are not audited.
+ * \warning call rebuild after each download or removeDevices of the FecAccessManager
+ */
+class FecDeviceDriftAuditor {
+
+ public:
+
+  /** \brief Create an auditor on the devices given by the access
+   */
+  FecDeviceDriftAuditor ( FecDeviceDriftAccess &access, enumDriftPolicy policy = DRIFTREPORT ) ;
+
+  /** \brief Delete the drift database
+   */
+  ~FecDeviceDriftAuditor ( ) ;
+
+  /** \brief Set the policy and the maximum number of rewrites for a register
+   */
+  void setPolicy ( enumDriftPolicy policy, unsigned int maximumRewrites = DRIFTAUDITMAXREWRITES ) ;
+
+  /** \brief Set the budget of one ring for one step
+   * \param timeBudget - time in microseconds
+   * \param frameBudget - number of register reads
+   */
+  void setBudget ( unsigned long timeBudget, unsigned int frameBudget ) ;
+
+  /** \brief Build the list of devices to be audited from the access
+   */
+  void rebuild ( ) ;
+
+  /** \brief Audit the next devices of each ring in the budget
+   * \param errorList - errors during the reads and drifts found for the first time
+   * \return number of devices audited
+   */
+  unsigned int auditStep ( std::list<FecExceptionHandler *> &errorList ) ;
+
+  /** \brief Number of devices to be audited
+   */
+  unsigned int getNumberOfDevices ( ) ;
+
+  /** \brief Number of complete passes over all the devices (slowest ring)
+   */
+  unsigned long getNumberOfPasses ( ) { return passes_ ; }
+
+  /** \brief Number of registers read
+   */
+  unsigned long getNumberOfReads ( ) { return reads_ ; }
+
+  /** \brief Number of rewrites done (register or device)
+   */
+  unsigned long getNumberOfRewrites ( ) { return rewrites_ ; }
+
+  /** \brief Number of rings skipped because they were used by another thread
+   */
+  unsigned long getNumberOfYields ( ) { return yields_ ; }
+
+  /** \brief Return a copy of the drift database
+   * \param activeOnly - only the drifts found in the last audit of the device
+   */
+  std::list<deviceDriftType> getDrifts ( bool activeOnly = false ) ;
+
+  /** \brief Return the drift of one register
+   * \return false if no drift was found for this register
+   */
+  bool getDrift ( keyType index, std::string registerName, deviceDriftType &drift ) ;
+
+  /** \brief Clear the drift database
+   */
+  void clearDrifts ( ) ;
+
+  /** \brief Current time in microseconds
+   */
+  static unsigned long long getTime ( ) ;
+
+ private:
+
+  /** Devices of one ring and position of the next audit
+   */
+  typedef struct {
+    std::vector< std::pair<enumDeviceType, keyType> > devices ;
+    unsigned int cursor ;
+    unsigned long passes ;
+  } ringAuditType ;
+
+  /** \brief Audit one device
+   * \return number of registers read
+   */
+  unsigned int auditDevice ( enumDeviceType deviceType, keyType index, std::list<FecExceptionHandler *> &errorList ) throw (FecExceptionHandler) ;
+
+  /** \brief Record the result of a register comparison
+   * \return true if the register is different from the reference
+   */
+  bool checkRegister ( keyType index, enumDeviceType deviceType, const char *registerName,
+		       unsigned int expected, unsigned int read, unsigned long long now,
+		       std::list<FecExceptionHandler *> &errorList ) ;
+
+  /** \brief Check that the registers have not been rewritten too often and count the rewrite
+   * \return true if the rewrite can be done
+   */
+  bool acceptRewrite ( keyType index, std::vector<const char *> &registerNames ) ;
+
+  /** Access to the devices and the references
+   */
+  FecDeviceDriftAccess &access_ ;
+
+  /** Rings, key is FEC and ring
+   */
+  std::map<keyType, ringAuditType> rings_ ;
+
+  /** Drift database, key is device index and register name
+   */
+  std::map< std::pair<keyType, std::string>, deviceDriftType > drifts_ ;
+
+  /** Lock on the drift database for the readers on other threads
+   */
+  pthread_mutex_t driftMutex_ ;
+
+  /** Policy and maximum rewrites of a register
+   */
+  enumDriftPolicy policy_ ;
+  unsigned int maximumRewrites_ ;
+
+  /** Budget per ring per step
+   */
+  unsigned long timeBudget_ ;
+  unsigned int frameBudget_ ;
+
+  /** Counters
+   */
+  unsigned long passes_, reads_, rewrites_, yields_ ;
+} ;
+
+#endif
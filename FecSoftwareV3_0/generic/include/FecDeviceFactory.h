@@ -57,6 +57,7 @@
 
 #include "DeviceFactoryInterface.h"
 #include "TkRingDescription.h"
+#include "DbStorage.h"
 
 typedef struct {
 
@@ -118,10 +119,18 @@ class FecDeviceFactory: public DeviceFactoryInterface {
    */
   deviceVector vFecDevices_ ;
 
+  /** Do not create a new version when the devices uploaded are identical to the version downloaded
+   */
+  bool skipUnchangedUpload_ ;
+
   /** Ring description
    */
   tkringVector tkRingDescription_ ;
 
+  /** Storage of the configuration without Oracle, not deleted by the factory
+   */
+  DbStorage *dbStorage_ ;
+
   /** \brief retreive the information from the input for one of the following parameters
    */
   void getFecDeviceDescriptions ( bool fileUsed, unsigned int versionMajor, unsigned int versionMinor, unsigned int pMaskVersionMajorId, unsigned int pMaskVersionMinorId, std::string partitionName, std::string fecHardwareId, deviceVector &outVector, bool allDevices = false, bool forceDbReload = false ) 
@@ -143,6 +152,20 @@ class FecDeviceFactory: public DeviceFactoryInterface {
     throw (oracle::occi::SQLException, FecExceptionHandler ) ;
 #endif
 
+  /** \brief retreive the devices of a version of a partition from the storage
+   */
+  void getStorageDevices ( unsigned int versionMajor, unsigned int versionMinor, unsigned int pMaskVersionMajor, unsigned int pMaskVersionMinor, std::string partitionName, bool forceDbReload )
+    throw (FecExceptionHandler ) ;
+
+  /** \brief complete the devices with the devices downloaded which are not part of them
+   */
+  deviceVector completeWithDownloadedDevices ( deviceVector &devices ) ;
+
+  /** \brief upload the devices in a new version of a partition in the storage
+   */
+  void setStorageDevices ( deviceVector devices, std::string partitionName, unsigned int *versionMajor, unsigned int *versionMinor, bool majorVersion )
+    throw (FecExceptionHandler ) ;
+
  public:
 
   /** \brief Build a FEC factory and a database access
@@ -174,10 +197,36 @@ class FecDeviceFactory: public DeviceFactoryInterface {
    */
   inline deviceVector getFecDevices ( ) { return vFecDevices_ ; } 
 
+  /** \brief Do not create a new version in the database when the devices uploaded are identical to the version downloaded
+   */
+  inline void setSkipUnchangedUpload ( bool skipUnchangedUpload ) { skipUnchangedUpload_ = skipUnchangedUpload ; }
+
+  /** \brief return true if an upload identical to the version downloaded does not create a new version
+   */
+  inline bool getSkipUnchangedUpload ( ) { return skipUnchangedUpload_ ; }
+
   /** \brief return the ring descriptions in the memory
    */
   inline tkringVector getTkRingDescriptions ( ) { return tkRingDescription_ ; } 
 
+  // ------------------------------------------------------------------------------------------------------
+  // 
+  // Storage methods
+  //
+  // ------------------------------------------------------------------------------------------------------
+
+  /** \brief Download and upload the devices of the partitions through a storage of the configuration (NULL to stop)
+   */
+  void setStorageAccess ( DbStorage *dbStorage ) ;
+
+  /** \brief return the storage of the configuration
+   */
+  inline DbStorage *getStorageAccess ( ) { return dbStorage_ ; }
+
+  /** \brief return true if the devices of the partitions are downloaded and uploaded through the storage
+   */
+  inline bool getStorageUsed ( ) { return (dbStorage_ != NULL) ; }
+
 
   // ------------------------------------------------------------------------------------------------------
   // 
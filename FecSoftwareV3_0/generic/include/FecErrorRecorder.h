@@ -0,0 +1,205 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Copyright 2002 - 2003, Frederic DROUHIN - Universite de Haute-Alsace, Mulhouse-France
+*/
+#ifndef FECERRORRECORDER_H
+#define FECERRORRECORDER_H
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include "tscTypes.h"
+#include "keyType.h"
+#include "errorCodeDefinition.h"
+#include "FecExceptionHandler.h"
+
+/** Default number of errors kept by a FecErrorRecorder
+ */
+#define FECERRORRECORDERSIZE 4096
+
+/** Error of one frame in the multiple frames methods. The messages are not copied, they must be static strings.
+ */
+typedef struct {
+
+  /** Time of the error in microseconds
+   */
+  unsigned long long timestamp ;
+
+  /** Position of the error (device or ring)
+   */
+  keyType hardPosition ;
+
+  /** Error code and severity (cf. errorCodeDefinition.h)
+   */
+  errorType errorCode, faultSeverity ;
+
+  /** Additional information: FEC SR0, status of the frame, size of the frame
+   */
+  unsigned int informationSup ;
+
+  /** Static strings: message, name of the information, method and source file
+   */
+  const char *errorMessage, *informationName, *method, *sourceFileName ;
+
+  /** Offset (register) of the access, transaction number and line
+   */
+  unsigned short registerOffset, transaction, line ;
+
+} fecErrorRecordType ;
+
+/**
+ * \class FecErrorRecorder
+ * Keep the errors of the multiple frames methods as compact records in a ring buffer
+ * allocated once. When a ring fails, each frame gives an error: recording it costs a copy
+ * of a few words instead of a FecExceptionHandler on the heap. The messages are built only
+ * when they are read (getMessage, getErrorList).
+ * <p>The frames in error are marked with a shared pointer (accessDeviceType::e == getRecordedError()) which must not be deleted,
+ * DeviceFrame::decodeErrorFrame with a recorder set them back to NULL.
+ * <p>Example:
+ * <pre>
+ * FecErrorRecorder errorRecorder ;
+ * unsigned int error = fecAccess->setBlockDevices (vAccessDevices, errorRecorder) ;
+ * if (error) errorRecorder.getErrorList (errorList) ; // or errorRecorder.raise() ;
+ * </pre>
+ * \brief Compact error records for the multiple frames methods
+ * \warning when more errors than the size are recorded, the oldest are lost, they are still counted
+ * \warning the errors of a ring (ring lost, FIFO problem) are kept as exceptions, one per ring (NEWRINGERROR)
+ * \warning the recorder is given to each call of the multiple frames methods, it is never attached to a ring
+ * \warning not thread safe, one recorder per operation
+ */
+class FecErrorRecorder {
+
+ public:
+
+  /** \brief Allocate the buffer
+   */
+  FecErrorRecorder ( unsigned int size = FECERRORRECORDERSIZE ) ;
+
+  /** \brief Delete the exceptions kept
+   */
+  ~FecErrorRecorder ( ) ;
+
+  /** \brief Remove all the errors
+   */
+  void clear ( ) ;
+
+  /** \brief Record the error of a frame
+   * \return the pointer to be set in the access (getRecordedError)
+   */
+  FecExceptionHandler *record ( errorType errorCode, const char *errorMessage, errorType faultSeverity,
+				keyType hardPosition, unsigned short registerOffset, unsigned short transaction,
+				const char *informationName, unsigned int informationSup,
+				const char *method, const char *sourceFileName, unsigned int line ) ;
+
+  /** \brief Keep an exception, the recorder becomes the owner
+   * \return the exception given
+   */
+  FecExceptionHandler *addException ( FecExceptionHandler *e ) ;
+
+  /** \brief Exception kept for an error code and a position
+   * \return NULL if no exception is kept for them
+   */
+  FecExceptionHandler *getException ( errorType errorCode, keyType hardPosition ) ;
+
+  /** \brief Number of errors: records including the ones lost and exceptions
+   */
+  unsigned long getNumberOfErrors ( ) { return recorded_ + exceptions_.size() ; }
+
+  /** \brief Number of records in the buffer
+   */
+  unsigned int getNumberOfRecords ( ) { return (recorded_ < records_.size()) ? recorded_ : records_.size() ; }
+
+  /** \brief Number of records overwritten
+   */
+  unsigned long getNumberOfLostRecords ( ) { return recorded_ - getNumberOfRecords() ; }
+
+  /** \brief Record from the oldest (0) to the newest
+   * \exception FecExceptionHandler if the record does not exist
+   */
+  const fecErrorRecordType &getRecord ( unsigned int i ) throw (FecExceptionHandler) ;
+
+  /** \brief Formatted message of a record
+   */
+  std::string getMessage ( unsigned int i ) throw (FecExceptionHandler) ;
+
+  /** \brief Exceptions kept
+   */
+  std::list<FecExceptionHandler *> &getExceptions ( ) { return exceptions_ ; }
+
+  /** \brief Add the errors to a list of exceptions as the multiple frames methods did
+   * \param errorList - list of exceptions, the exceptions must be deleted by the caller
+   * \param oneErrorPerDevice - only the first record of each position
+   * \return number of exceptions added
+   */
+  unsigned int getErrorList ( std::list<FecExceptionHandler *> &errorList, bool oneErrorPerDevice = false ) ;
+
+  /** \brief Raise the most severe error
+   * \exception FecExceptionHandler if an error is present
+   */
+  void raise ( ) throw (FecExceptionHandler) ;
+
+  /** \brief Pointer set in the accesses with an error recorded
+   */
+  static FecExceptionHandler *getRecordedError ( ) { return &recordedError_ ; }
+
+  /** \brief Build the exception of a record
+   */
+  static FecExceptionHandler *newException ( const fecErrorRecordType &record ) ;
+
+ private:
+
+  /** Ring buffer
+   */
+  std::vector<fecErrorRecordType> records_ ;
+
+  /** Number of records since the clear
+   */
+  unsigned long recorded_ ;
+
+  /** Errors of the rings
+   */
+  std::list<FecExceptionHandler *> exceptions_ ;
+
+  /** Marker of the accesses in error
+   */
+  static FecExceptionHandler recordedError_ ;
+} ;
+
+/** Error of a frame: recorded if a recorder is given, else a new exception as NEWFECEXCEPTIONHANDLER_INFOSUP
+ * \param errorRecorder - FecErrorRecorder * or NULL
+ * \param access - accessDeviceType of the frame
+ * \warning errorMessage and informationName must be static strings
+ */
+#define NEWFRAMEERROR(errorRecorder,errorCode,errorMessage,faultSeverity,hardPosition,access,informationName,informationSup) \
+(((errorRecorder) != NULL) ? \
+ (errorRecorder)->record(errorCode,errorMessage,faultSeverity,hardPosition,(access).offset,(access).tnum,informationName,informationSup,__PRETTY_FUNCTION__,__FILE__,__LINE__) : \
+ NEWFECEXCEPTIONHANDLER_INFOSUP(errorCode,errorMessage,faultSeverity,hardPosition,informationName,informationSup))
+
+/** Error of a ring (ring lost, FIFO problem) for a frame: with a recorder, one exception per error code and ring
+ * is kept by the recorder and shared by all the frames, else a new exception as NEWFECEXCEPTIONHANDLER_INFOSUP
+ * \param errorRecorder - FecErrorRecorder * or NULL
+ */
+#define NEWRINGERROR(errorRecorder,errorCode,errorMessage,faultSeverity,hardPosition,informationName,informationSup) \
+(((errorRecorder) == NULL) ? \
+ NEWFECEXCEPTIONHANDLER_INFOSUP(errorCode,errorMessage,faultSeverity,hardPosition,informationName,informationSup) : \
+ ((errorRecorder)->getException(errorCode,hardPosition) != NULL) ? \
+ (errorRecorder)->getException(errorCode,hardPosition) : \
+ (errorRecorder)->addException(NEWFECEXCEPTIONHANDLER_INFOSUP(errorCode,errorMessage,faultSeverity,hardPosition,informationName,informationSup)))
+
+#endif
@@ -0,0 +1,132 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+#ifndef FECPCIBAR_H
+#define FECPCIBAR_H
+
+#include "tscTypes.h"
+
+/**
+ * \class FecPciBar
+ * Registers of a PCI FEC (PLX BAR2): control and status registers and FIFOs.
+ * The offsets are given in bytes from the FEC register at offset 0 (DD_FEC_CTRL0_OFFSET),
+ * each access is a 32 bits access. The FIFOs are read or written word by word at the same offset.
+ * \brief Access to the registers of a PCI FEC
+ */
+class FecPciBar {
+
+ public:
+
+  /** \param fifoTransmitOffset - offset of the FIFO transmit
+   * \param fifoReceiveOffset - offset of the FIFO receive
+   * \param fifoReturnOffset - offset of the FIFO return
+   */
+  FecPciBar ( unsigned int fifoTransmitOffset, unsigned int fifoReceiveOffset, unsigned int fifoReturnOffset ):
+    fifoTransmitOffset_(fifoTransmitOffset), fifoReceiveOffset_(fifoReceiveOffset), fifoReturnOffset_(fifoReturnOffset) { }
+
+  /** Nothing
+   */
+  virtual ~FecPciBar ( ) { }
+
+  /** \brief Read the register at the offset given
+   */
+  virtual tscType32 read ( unsigned int offset ) = 0 ;
+
+  /** \brief Write the register at the offset given
+   */
+  virtual void write ( unsigned int offset, tscType32 value ) = 0 ;
+
+  /** \brief Read count words at the same offset (FIFO)
+   */
+  virtual void readFifo ( unsigned int offset, tscType32 *values, int count ) {
+    for (int i = 0 ; i < count ; i ++) values[i] = read (offset) ;
+  }
+
+  /** \brief Write count words at the same offset (FIFO)
+   */
+  virtual void writeFifo ( unsigned int offset, const tscType32 *values, int count ) {
+    for (int i = 0 ; i < count ; i ++) write (offset, values[i]) ;
+  }
+
+  /** \brief Offsets of the FIFOs
+   */
+  unsigned int getFifoTransmitOffset ( ) { return fifoTransmitOffset_ ; }
+  unsigned int getFifoReceiveOffset ( ) { return fifoReceiveOffset_ ; }
+  unsigned int getFifoReturnOffset ( ) { return fifoReturnOffset_ ; }
+
+ protected:
+
+  unsigned int fifoTransmitOffset_ ;
+  unsigned int fifoReceiveOffset_ ;
+  unsigned int fifoReturnOffset_ ;
+} ;
+
+/**
+ * \class FecPciMappedBar
+ * Registers of a PCI FEC mapped in the process by the driver (see glue_fec_map_registers):
+ * each access is a volatile load or store, ie. one PCI access without system call.
+ * The memory is not owned by this class, the mapping is released by the caller.
+ * \brief Registers of a PCI FEC mapped in memory
+ */
+class FecPciMappedBar: public FecPciBar {
+
+ public:
+
+  /** \param registers - address of the FEC register at offset 0
+   * \param fifoTransmitOffset - offset of the FIFO transmit
+   * \param fifoReceiveOffset - offset of the FIFO receive
+   * \param fifoReturnOffset - offset of the FIFO return
+   */
+  FecPciMappedBar ( volatile void *registers,
+		    unsigned int fifoTransmitOffset, unsigned int fifoReceiveOffset, unsigned int fifoReturnOffset ):
+    FecPciBar (fifoTransmitOffset, fifoReceiveOffset, fifoReturnOffset),
+    registers_((volatile tscType32 *)registers) { }
+
+  /** \brief Volatile load of the register
+   */
+  tscType32 read ( unsigned int offset ) {
+    return registers_[offset >> 2] ;
+  }
+
+  /** \brief Volatile store in the register
+   */
+  void write ( unsigned int offset, tscType32 value ) {
+    registers_[offset >> 2] = value ;
+  }
+
+  /** \brief Volatile loads of the FIFO, without any call per word
+   */
+  void readFifo ( unsigned int offset, tscType32 *values, int count ) {
+    volatile tscType32 *fifo = registers_ + (offset >> 2) ;
+    for (int i = 0 ; i < count ; i ++) values[i] = *fifo ;
+  }
+
+  /** \brief Volatile stores in the FIFO, without any call per word
+   */
+  void writeFifo ( unsigned int offset, const tscType32 *values, int count ) {
+    volatile tscType32 *fifo = registers_ + (offset >> 2) ;
+    for (int i = 0 ; i < count ; i ++) *fifo = values[i] ;
+  }
+
+ private:
+
+  /** FEC register at offset 0
+   */
+  volatile tscType32 *registers_ ;
+} ;
+
+#endif
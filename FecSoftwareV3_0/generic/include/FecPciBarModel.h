@@ -0,0 +1,105 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+#ifndef FECPCIBARMODEL_H
+#define FECPCIBARMODEL_H
+
+#include <deque>
+#include <vector>
+
+#include "FecPciBar.h"
+
+/**
+ * \class FecPciBarModel
+ * In-memory model of the registers of a PCI FEC, used to test the register accesses without FEC.
+ * <ul>
+ * <li> the control and status registers are words of a memory image, the status registers are set by the test
+ * <li> the three FIFOs are queues: a write pushes a word, a read pops a word (0 when the FIFO is empty)
+ * <li> the empty bits of the status register 0 follow the FIFOs
+ * <li> in loopback mode, setting the send bit of the control register 0 moves the FIFO transmit
+ * to the FIFO receive, as the frame coming back from the ring
+ * </ul>
+ * \brief Model of the PCI FEC registers counting the accesses
+ */
+class FecPciBarModel: public FecPciBar {
+
+ public:
+
+  /** \brief Create the memory image, with the FIFO offsets of the 32 bits FECs
+   */
+  FecPciBarModel ( unsigned int size = 0x30,
+		   unsigned int fifoTransmitOffset = 0x20, unsigned int fifoReceiveOffset = 0x28, unsigned int fifoReturnOffset = 0x24,
+		   bool loopback = false ) ;
+
+  /** \brief Read a register or a FIFO
+   */
+  tscType32 read ( unsigned int offset ) ;
+
+  /** \brief Write a register or a FIFO
+   */
+  void write ( unsigned int offset, tscType32 value ) ;
+
+  /** \brief Value stored in a register, without any access counted
+   */
+  tscType32 getRegister ( unsigned int offset ) ;
+
+  /** \brief Set a register, without any access counted
+   */
+  void setRegister ( unsigned int offset, tscType32 value ) ;
+
+  /** \brief Content of the FIFOs
+   */
+  std::deque<tscType32> &getFifoTransmit ( ) { return fifoTransmit_ ; }
+  std::deque<tscType32> &getFifoReceive ( ) { return fifoReceive_ ; }
+  std::deque<tscType32> &getFifoReturn ( ) { return fifoReturn_ ; }
+
+  /** \brief Number of reads and writes since the creation or the last resetCounters
+   */
+  unsigned long getReads ( ) { return reads_ ; }
+  unsigned long getWrites ( ) { return writes_ ; }
+
+  /** \brief Reset the counters
+   */
+  void resetCounters ( ) { reads_ = writes_ = 0 ; }
+
+ private:
+
+  /** \brief Word of the image for an offset, the offset is checked
+   */
+  tscType32 &word ( unsigned int offset ) ;
+
+  /** Registers
+   */
+  std::vector<tscType32> image_ ;
+
+  /** FIFOs
+   */
+  std::deque<tscType32> fifoTransmit_ ;
+  std::deque<tscType32> fifoReceive_ ;
+  std::deque<tscType32> fifoReturn_ ;
+
+  /** Frames sent come back in the FIFO receive
+   */
+  bool loopback_ ;
+
+  /** Counters
+   */
+  unsigned long reads_ ;
+  unsigned long writes_ ;
+} ;
+
+#endif
@@ -26,6 +26,7 @@
 #include "FecRingDevice.h"
 #include "datatypes.h"
 #include "glue.h"
+#include "FecPciBar.h"
 
 #define PCIDRIVERMODE (O_RDWR | O_NONBLOCK)
 #define DEVICEDRIVERNAME "/dev/fecpmc%02d"
@@ -35,6 +36,8 @@
  * This class works for any kind of PCI FEC, eletrical (latice and PLX one) and optical
  * This class inherits from FecRingDevice in order to have the same methods for the type of FECs: VME, PCI, USB
  * This class inherits from FecRingDevice which contains all the high level methods for CCU, channels (i2c, pia, memory) 
+ * When the driver allows it, the registers are mapped in the process (glue_fec_map_registers) and accessed
+ * without ioctl: the mapping is only done while the PLX IRQs are disabled, the ioctl are used otherwise.
  */
 class FecPciRingDevice: public FecRingDevice {
 
@@ -43,6 +46,23 @@ class FecPciRingDevice: public FecRingDevice {
    */
   int deviceDescriptor_ ;
 
+  /** Registers mapped in the process, NULL if the ioctl are used
+   */
+  FecPciBar *bar_ ;
+
+  /** Geometry and address of the mapping
+   */
+  DD_FEC_MAP_INFO mapInfo_ ;
+  volatile void *mappedRegisters_ ;
+
+  /** \brief Map the registers if the driver allows it
+   */
+  void mapRegisters ( ) ;
+
+  /** \brief Release the mapping, the ioctl are used after
+   */
+  void unmapRegisters ( ) ;
+
  public:
 
   /** Number of slot in the PCI bus
@@ -104,6 +124,15 @@ class FecPciRingDevice: public FecRingDevice {
    */
   tscType16 getFecFirmwareVersion( ) throw ( FecExceptionHandler ) ;
 
+  /** \brief Use or not the registers mapped in the process
+   * \exception FecExceptionHandler if the mapping is asked and refused by the driver
+   */
+  void setRegisterMapping ( bool mapped ) throw ( FecExceptionHandler ) ;
+
+  /** \brief Are the registers accessed through a mapping
+   */
+  bool isRegisterMapped ( ) { return (bar_ != NULL) ; }
+
   /******************************************************
 	FIFO ACCESS - NATIVE 32 BITS FORMAT
 	NATIVE FORMAT ACCESS ALLOWS R/W OPERATIONS
@@ -136,6 +165,14 @@ class FecPciRingDevice: public FecRingDevice {
    */
   void setFifoTransmit( tscType32 value )  throw ( FecExceptionHandler ) ;
 
+  /** \brief write a set of words in the FIFO transmit
+   */
+  void setFifoTransmit ( tscType32 *value, int count ) throw ( FecExceptionHandler ) ;
+
+  /** \brief read a set of words from the FIFO receive
+   */
+  tscType32* getFifoReceive ( tscType32 *value, int count ) throw ( FecExceptionHandler ) ;
+
 
    /******************************************************
 	HARD RESET
@@ -27,6 +27,11 @@
 /** C++ STL
  */
 #include <list>
+#include <vector>
+
+/** Threads
+ */
+#include <pthread.h>
 
 /** Type definition
  */
@@ -52,6 +57,12 @@ typedef Sgi::hash_map<keyType, CCUDescription *> ccuMapAccessedType ;
 // firmware version needed to use the method in order to parallelize on the rings
 #define MINFIRMWAREVERSION 0x16
 
+// number of CCU alarm frames kept when they arrive during a transaction (the oldest are lost)
+#define MAXCCUALARMFRAMES 64
+
+// number of memory channel transactions in flight for the block memory transfers
+#define MAXMEMORYTRANSACTIONS 8
+
 /**
  * \class FecRingDevice
  * This class gives all the FEC, ring hardware access needed. 
@@ -182,6 +193,34 @@ class FecRingDevice {
    */
   time_t timeTransactionNumber[MAXTRANSACTIONNUMBER+1] ;
 
+  /** Lock taken during the frame transactions on the ring (recursive)
+   */
+  pthread_mutex_t ringMutex_ ;
+
+  /** Lock on the CCU alarm frames kept
+   */
+  pthread_mutex_t alarmFramesMutex_ ;
+
+  /** CCU alarm frames received during a transaction
+   */
+  std::list< std::vector<tscType8> > alarmFrames_ ;
+
+  /** Number of CCU alarm frames lost
+   */
+  unsigned long alarmFramesLost_ ;
+
+  /** To access to the ring lock
+   */
+  friend class FecRingTransactionLock ;
+
+  /** \brief Keep a CCU alarm frame received during a transaction
+   */
+  void pushCcuAlarmFrame ( tscType8 *frame ) ;
+
+  /** \brief Check if a transaction number is in use
+   */
+  bool isTransactionPending ( ) ;
+
  protected:
 
   /** Clock return polarity
@@ -597,6 +636,28 @@ class FecRingDevice {
    */
   void setPiaClearInterrupts ( keyType index ) throw (FecExceptionHandler) ;
 
+  /** \brief Return a CCU alarm frame without blocking
+   */
+  bool getCcuAlarmFrame ( tscType8 frame[DD_USER_MAX_MSG_LENGTH*4] ) throw (FecExceptionHandler) ;
+
+  /** \brief Return the number of CCU alarm frames lost
+   */
+  inline unsigned long getCcuAlarmFramesLost ( ) { return alarmFramesLost_ ; }
+
+  /** \brief Check if a frame is a CCU alarm or a PIA interrupt
+   */
+  static bool isCcuAlarmFrame ( tscType8 *frame ) ;
+
+  /** \brief Take the ring lock if no other thread is using the ring
+   * \return false if the ring is used by another thread
+   * \warning unlockRing must be called when the return is true
+   */
+  bool tryLockRing ( ) ;
+
+  /** \brief Release the ring lock taken by tryLockRing
+   */
+  void unlockRing ( ) ;
+
   // -------------------------------- Channel methods
 
   /** \brief Enable the channel corresponding to the key
@@ -904,6 +965,11 @@ class FecRingDevice {
                         unsigned long size,
                         tscType8 *values ) throw (FecExceptionHandler) ;
 
+  /** \brief read and write segments of memory with several transactions in flight
+   */
+  void setBlockMemory ( std::list<memoryAccessType> &vAccesses, 
+                        unsigned int maximumTransactions = MAXMEMORYTRANSACTIONS ) throw (FecExceptionHandler) ;
+
   // -------------------------- For the trigger channel registers
   
   /** \brief Set the trigger channel CRA
@@ -1052,6 +1118,10 @@ class FecRingDevice {
    */
   virtual tscType32* getFifoTransmit (  tscType32 *value,int count ) throw (FecExceptionHandler) ;
 
+  /** \brief Fill the FIFO transmit, clear the errors and toggle the send bit of the control register 0
+   */
+  virtual void sendFifoTransmit ( tscType32 *value, int count ) throw (FecExceptionHandler) ;
+
   /*****************************************
   Methods for block of frames
   *****************************************/
@@ -1065,18 +1135,19 @@ class FecRingDevice {
   unsigned int buildPIAFrame ( accessDeviceType b, tscType32 *toBeTransmited, unsigned int *fifoRecWord ) ;
 
   /** This methods takes an array of values to be set and send it over the ring.
+   * The errors of the frames are recorded if a recorder is given, else an exception is created for each frame.
    */
-  void setBlockDevices ( std::list<accessDeviceType> &vAccessDevices, bool forceAcknowledge ) throw (FecExceptionHandler) ;
+  void setBlockDevices ( std::list<accessDeviceType> &vAccessDevices, bool forceAcknowledge, FecErrorRecorder *errorRecorder = NULL ) throw (FecExceptionHandler) ;
 
   /** This methods retreive the frames sent by another methods and manage it with errors
    */
   void getBlockFrames ( bool forceChannelAck, accessTransactionFrameMap &tnumSent,
-			Sgi::hash_map<keyType, int> &busy, unsigned int &cptRead )
+			Sgi::hash_map<keyType, int> &busy, unsigned int &cptRead, FecErrorRecorder *errorRecorder = NULL )
     throw (FecExceptionHandler) ;
 
   /** This methods takes an array of values to be set and send it over the ring.
    */
-  void setBlockDevicesBltMode ( std::list<accessDeviceType> &vAccessDevices, bool forceAcknowledge ) throw (FecExceptionHandler) ;
+  void setBlockDevicesBltMode ( std::list<accessDeviceType> &vAccessDevices, bool forceAcknowledge, FecErrorRecorder *errorRecorder = NULL ) throw (FecExceptionHandler) ;
 
   /** This methods takes an array of values to be set and send it over the ring.
    */
@@ -29,6 +29,7 @@
 // FecSoftware includes
 #include "tscTypes.h"
 #include "fec_usb.h"
+#include "fec_usb_pipe.h"
 #include "FecExceptionHandler.h"
 #include "FecRingDevice.h"
 
@@ -57,6 +58,9 @@ class FecUsbRingDevice: public FecRingDevice {
   /* file descriptor form pseudo serial port initialized in/by constructor  */
   int currentPortFD_;
   int device_ ; 
+
+  /* commands sent in one USB transfer */
+  struct fec_usb_pipe *pipe_ ;
   char devName_[256] ;   
 
  public:
@@ -222,6 +226,13 @@ class FecUsbRingDevice: public FecRingDevice {
    */
   tscType32* getFifoTransmit (  tscType32 *value,int count ) 
     throw (FecExceptionHandler);
+
+  /** \brief Fill the FIFO transmit, clear the errors and toggle the send bit in two USB transfers
+   * \param value - words of the frames (array)
+   * \param count - number of words
+   */
+  void sendFifoTransmit ( tscType32 *value, int count ) 
+    throw (FecExceptionHandler);
       
       
       
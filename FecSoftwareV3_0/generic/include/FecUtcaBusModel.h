@@ -0,0 +1,160 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+#ifndef FECUTCABUSMODEL_H
+#define FECUTCABUSMODEL_H
+
+#include <pthread.h>
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "FecUtcaTransaction.h"
+
+/**
+ * \class FecUtcaBusModel
+ * In-memory model of the IPbus nodes of a uTCA FEC, used to test and benchmark the uTCA transport without board.
+ * Each dispatch counts as one round trip and can be given a duration. The nodes modelled are:
+ * <ul>
+ * <li> the control and status registers of each ring, the status registers are set by the test
+ * <li> the FIFO transmit (words kept for the test) and the FIFO receive (words given by the test) with its number of words
+ * <li> the local bus of each ring: writing access_mode does the access on a register map and raises
+ * access_ack after a given number of reads, writing 0 in access_request clears it
+ * <li> the reset and clock shift nodes of the FEC, stored as plain registers
+ * </ul>
+ * \brief Model of the uTCA FEC nodes counting the round trips
+ */
+class FecUtcaBusModel: public FecUtcaBus {
+
+ public:
+
+  /** \brief Create the nodes of the rings
+   * \param minRing - first ring
+   * \param maxRing - last ring
+   * \param roundTripTime - duration of a dispatch in microseconds
+   */
+  FecUtcaBusModel ( unsigned int minRing = 0, unsigned int maxRing = 3, unsigned long roundTripTime = 0 ) ;
+
+  /** \brief Destroy the mutex
+   */
+  ~FecUtcaBusModel ( ) ;
+
+  /** \brief Return the id of a node
+   * \exception FecExceptionHandler if the node does not exist
+   */
+  unsigned int getNodeId ( const std::string &path ) throw (FecExceptionHandler) ;
+
+  /** \brief Execute the accesses, one round trip
+   * \exception FecExceptionHandler if an access is not allowed on a node (write of a status register for example)
+   */
+  void dispatch ( const std::vector<FecUtcaAccess> &accesses, const std::vector<tscType32> &writeValues,
+		  std::vector<tscType32> &readValues ) throw (FecExceptionHandler) ;
+
+  /** \brief Duration of a round trip in microseconds
+   */
+  void setRoundTripTime ( unsigned long roundTripTime ) { roundTripTime_ = roundTripTime ; }
+
+  /** \brief Number of round trips, accesses and words since the creation or the last resetCounters
+   */
+  unsigned long getRoundTrips ( ) { return roundTrips_ ; }
+  unsigned long getAccesses ( ) { return accesses_ ; }
+  unsigned long getWords ( ) { return words_ ; }
+
+  /** \brief Reset the counters
+   */
+  void resetCounters ( ) { roundTrips_ = accesses_ = words_ = 0 ; }
+
+  /** \brief Value of a register node
+   * \exception FecExceptionHandler if the node does not exist
+   */
+  tscType32 getRegister ( const std::string &path ) throw (FecExceptionHandler) ;
+
+  /** \brief Set a register node, for example a status register
+   * \exception FecExceptionHandler if the node does not exist
+   */
+  void setRegister ( const std::string &path, tscType32 value ) throw (FecExceptionHandler) ;
+
+  /** \brief Words written in the FIFO transmit of a ring
+   */
+  std::vector<tscType32> &getTransmitFifo ( unsigned int ring ) { return rings_[ring - minRing_].transmitFifo ; }
+
+  /** \brief Add a word in the FIFO receive of a ring
+   */
+  void pushReceiveFifo ( unsigned int ring, tscType32 value ) { rings_[ring - minRing_].receiveFifo.push_back(value) ; }
+
+  /** \brief Register of the local bus of a ring
+   */
+  tscType32 getLocalRegister ( unsigned int ring, tscType32 address ) { return rings_[ring - minRing_].localRegisters[address] ; }
+  void setLocalRegister ( unsigned int ring, tscType32 address, tscType32 value ) { rings_[ring - minRing_].localRegisters[address] = value ; }
+
+  /** \brief Number of reads of access_ack giving 0 after an access on the local bus of a ring (slow FEC)
+   */
+  void setAckDelay ( unsigned int ring, unsigned int reads ) { rings_[ring - minRing_].ackDelay = reads ; }
+
+ private:
+
+  /** Behaviour of a node
+   */
+  enum NodeType { REGISTER, STATUS, TRANSMITFIFO, RECEIVEFIFO, RECEIVEWORDS, ACCESSMODE, ACCESSREQUEST, ACCESSACK, READDATA } ;
+
+  /** Add a node
+   */
+  unsigned int addNode ( const std::string &path, NodeType type, unsigned int ring ) ;
+
+  /** Write and read a word of a node
+   */
+  void writeNode ( unsigned int node, tscType32 value ) throw (FecExceptionHandler) ;
+  tscType32 readNode ( unsigned int node ) throw (FecExceptionHandler) ;
+
+  /** Nodes: type, ring, value and path
+   */
+  std::vector<NodeType> types_ ;
+  std::vector<unsigned int> nodeRings_ ;
+  std::vector<tscType32> values_ ;
+  std::map<std::string, unsigned int> nodeIds_ ;
+
+  /** State of a ring
+   */
+  typedef struct {
+    unsigned int addressNode, writeDataNode ;
+    std::vector<tscType32> transmitFifo ;
+    std::deque<tscType32> receiveFifo ;
+    std::map<tscType32, tscType32> localRegisters ;
+    tscType32 readData ;
+    bool accessPending ;
+    unsigned int ackDelay, ackDelayLeft ;
+  } RingState ;
+
+  std::vector<RingState> rings_ ;
+  unsigned int minRing_ ;
+
+  /** Duration of a round trip in microseconds
+   */
+  unsigned long roundTripTime_ ;
+
+  /** Counters
+   */
+  unsigned long roundTrips_, accesses_, words_ ;
+
+  /** One dispatch at a time, the rings can be used by several threads
+   */
+  pthread_mutex_t mutex_ ;
+} ;
+
+#endif
@@ -24,8 +24,34 @@
 #include "tscTypes.h"
 #include "FecExceptionHandler.h"
 #include "FecRingDevice.h"
+#include "FecUtcaTransaction.h"
 #include "uhal/uhal.hpp"
 
+#include <pthread.h>
+
+#include <map>
+
+/** FecUtcaBus on top of the uHAL connection. The nodes are resolved once and kept as uhal::Node,
+ * a dispatch queues all the accesses in uHAL and calls uhal::HwInterface::dispatch once.
+ * A block access is a writeBlock / readBlock on a non incremental node, a sequence of single accesses otherwise.
+ * The dispatches of the rings are serialised since they share the connection.
+ */
+class FecUtcaUhalBus: public FecUtcaBus {
+
+ public:
+  FecUtcaUhalBus ( uhal::HwInterface &hwBoard ) ;
+  ~FecUtcaUhalBus ( ) ;
+  unsigned int getNodeId ( const std::string &path ) throw (FecExceptionHandler) ;
+  void dispatch ( const std::vector<FecUtcaAccess> &accesses, const std::vector<tscType32> &writeValues,
+		  std::vector<tscType32> &readValues ) throw (FecExceptionHandler) ;
+
+ private:
+  uhal::HwInterface &hwBoard_ ;
+  std::vector<const uhal::Node *> nodes_ ;
+  std::map<std::string, unsigned int> nodeIds_ ;
+  pthread_mutex_t mutex_ ;
+} ;
+
 
 /** This class gives all the methods to read / write a word in the different registers of the uTCA FEC ie.:
  * FIFO receive, FIFO transmit, FIFO return, control register 0 and 1, status register 0 and 1
@@ -40,6 +66,10 @@ class FecUtcaRingDevice: public FecRingDevice {
         std::string strError;
 ///uHal board object
 	static uhal::HwInterface *hwBoard;
+///Transactions on hwBoard shared by the rings
+	static FecUtcaUhalBus *uhalBus;
+///Registers and FIFOs of this ring, the nodes are resolved once
+        FecUtcaRingTransport *transport;
         /** Send one command to the FEC local bus 
         * @param uCmd Command
         * @param uSetValue Write value
@@ -156,6 +186,19 @@ class FecUtcaRingDevice: public FecRingDevice {
    */
   void setFifoTransmit( tscType32 value )  throw ( FecExceptionHandler ) ;
 
+  /** \brief write a set of words in the FIFO transmit in one IPbus round trip
+   * \param value - values to be written (array)
+   * \param count - number of values
+   */
+  void setFifoTransmit ( tscType32 *value, int count ) throw (FecExceptionHandler) ;
+
+  /** \brief read a set of words from the FIFO receive in one IPbus round trip
+   * \param value - values read (array)
+   * \param count - number of values
+   * \return pointer to the array of value ( = value )
+   */
+  tscType32* getFifoReceive ( tscType32 *value, int count ) throw (FecExceptionHandler) ;
+
 
    /******************************************************
 	HARD RESET
@@ -0,0 +1,310 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+#ifndef FECUTCATRANSACTION_H
+#define FECUTCATRANSACTION_H
+
+#include <string>
+#include <vector>
+
+#include "tscTypes.h"
+#include "FecExceptionHandler.h"
+
+/** Type of the accesses queued in a FecUtcaTransaction
+ */
+enum FecUtcaAccessType { FECUTCAWRITE, FECUTCAREAD } ;
+
+/** One access queued in a FecUtcaTransaction. An access of more than one word is a block access:
+ * on a FIFO node (non incremental) the words are all written to / read from the same address.
+ */
+typedef struct {
+
+  /** Write or read
+   */
+  FecUtcaAccessType type ;
+
+  /** Node given by FecUtcaBus::getNodeId
+   */
+  unsigned int node ;
+
+  /** Position of the first word in the values written or read by the dispatch
+   */
+  unsigned int offset ;
+
+  /** Number of words
+   */
+  unsigned int count ;
+
+} FecUtcaAccess ;
+
+/**
+ * \class FecUtcaBus
+ * IPbus connection to the uTCA FEC as seen by FecUtcaTransaction. The nodes of the address table are
+ * resolved once into ids and a dispatch sends all the accesses given in one round trip.
+ * It is implemented on top of uhal::HwInterface by FecUtcaRingDevice and by FecUtcaBusModel for the tests without board.
+ */
+class FecUtcaBus {
+
+ public:
+
+  /** Nothing to do
+   */
+  virtual ~FecUtcaBus ( ) { }
+
+  /** \brief Resolve a node of the address table
+   * \param path - path of the node, for example FIFO.ring0.TRA
+   * \return the id of the node used in the accesses
+   * \exception FecExceptionHandler if the node does not exist
+   */
+  virtual unsigned int getNodeId ( const std::string &path ) throw (FecExceptionHandler) = 0 ;
+
+  /** \brief Execute the accesses in one round trip, in the order given
+   * \param accesses - accesses to be done
+   * \param writeValues - words written, each write access gives its position in this vector
+   * \param readValues - words read, already sized, each read access gives its position in this vector
+   * \exception FecExceptionHandler if the transaction failed
+   */
+  virtual void dispatch ( const std::vector<FecUtcaAccess> &accesses, const std::vector<tscType32> &writeValues,
+			  std::vector<tscType32> &readValues ) throw (FecExceptionHandler) = 0 ;
+} ;
+
+class FecUtcaTransaction ;
+
+/**
+ * \class FecUtcaValue
+ * Value of a read queued in a FecUtcaTransaction. It is valid after the dispatch that executes the read
+ * and until the next dispatch of the transaction.
+ * \brief Future of a read of a FecUtcaTransaction
+ */
+class FecUtcaValue {
+
+ public:
+
+  /** \brief Empty value, never valid
+   */
+  FecUtcaValue ( ): transaction_(NULL), offset_(0), count_(0), dispatch_(0) { }
+
+  /** \brief Value of a read
+   */
+  FecUtcaValue ( const FecUtcaTransaction *transaction, unsigned int offset, unsigned int count, unsigned long dispatch ):
+    transaction_(transaction), offset_(offset), count_(count), dispatch_(dispatch) { }
+
+  /** \brief Is the read done and its value still available
+   */
+  bool isValid ( ) const ;
+
+  /** \brief Number of words read
+   */
+  unsigned int size ( ) const { return count_ ; }
+
+  /** \brief Return a word read
+   * \param i - position of the word in a block read
+   * \exception FecExceptionHandler if the value is not valid or i is out of the block
+   */
+  tscType32 value ( unsigned int i = 0 ) const throw (FecExceptionHandler) ;
+
+  /** \brief Copy the words read
+   * \param values - array of size() words
+   * \exception FecExceptionHandler if the value is not valid
+   */
+  void copy ( tscType32 *values ) const throw (FecExceptionHandler) ;
+
+ private:
+
+  /** Transaction and position of the words in its values
+   */
+  const FecUtcaTransaction *transaction_ ;
+  unsigned int offset_, count_ ;
+
+  /** Dispatch of the transaction which executes the read (FecUtcaTransaction generation)
+   */
+  unsigned long dispatch_ ;
+} ;
+
+/**
+ * \class FecUtcaTransaction
+ * Queue of reads and writes sent to the uTCA FEC in one IPbus round trip. Each access costs a round trip
+ * when it is dispatched alone, the queue allows to send a frame to the FIFO transmit or a command to the
+ * local bus of the FEC with the reads of the answer in one packet.
+ * <p>Example:
+ * <pre>
+ * FecUtcaTransaction transaction (bus) ;
+ * transaction.writeBlock (fifoNode, frame, size) ;
+ * transaction.write (cr0Node, FEC_CR0_SEND | FEC_CR0_ENABLEFEC) ;
+ * FecUtcaValue sr0 = transaction.read (sr0Node) ;
+ * transaction.dispatch ( ) ;
+ * std::cout << sr0.value() << std::endl ;
+ * </pre>
+ * \brief Queue of accesses dispatched in one IPbus round trip
+ * \warning not thread safe, one transaction per ring
+ */
+class FecUtcaTransaction {
+
+ public:
+
+  /** \brief Transaction on a bus
+   */
+  FecUtcaTransaction ( FecUtcaBus &bus ) ;
+
+  /** \brief Return the bus
+   */
+  FecUtcaBus &getBus ( ) { return bus_ ; }
+
+  /** \brief Queue the write of a word
+   */
+  void write ( unsigned int node, tscType32 value ) ;
+
+  /** \brief Queue the write of several words on the same node (FIFO)
+   */
+  void writeBlock ( unsigned int node, const tscType32 *values, unsigned int count ) ;
+
+  /** \brief Queue the read of a word
+   * \return the value available after the dispatch
+   */
+  FecUtcaValue read ( unsigned int node ) { return readBlock (node, 1) ; }
+
+  /** \brief Queue the read of several words on the same node (FIFO)
+   * \return the values available after the dispatch
+   */
+  FecUtcaValue readBlock ( unsigned int node, unsigned int count ) ;
+
+  /** \brief Send the accesses queued in one round trip. Nothing is sent if the queue is empty.
+   * \exception FecExceptionHandler from the bus, the accesses are removed and the reads are not valid
+   */
+  void dispatch ( ) throw (FecExceptionHandler) ;
+
+  /** \brief Number of accesses waiting for the dispatch
+   */
+  unsigned int getNumberOfAccesses ( ) const { return accesses_.size() ; }
+
+  /** \brief Number of round trips done
+   */
+  unsigned long getNumberOfDispatches ( ) const { return dispatches_ ; }
+
+ private:
+
+  friend class FecUtcaValue ;
+
+  /** Bus used
+   */
+  FecUtcaBus &bus_ ;
+
+  /** Accesses and words to be written of the next dispatch
+   */
+  std::vector<FecUtcaAccess> accesses_ ;
+  std::vector<tscType32> writeValues_ ;
+
+  /** Number of words read by the next dispatch
+   */
+  unsigned int readCount_ ;
+
+  /** Words read by the last dispatch
+   */
+  std::vector<tscType32> readValues_ ;
+
+  /** Number of dispatches tried, a FecUtcaValue keeps the one which executes its read
+   */
+  unsigned long generation_ ;
+
+  /** Has the last dispatch succeeded
+   */
+  bool valid_ ;
+
+  /** Number of successful dispatches (round trips)
+   */
+  unsigned long dispatches_ ;
+} ;
+
+/**
+ * \class FecUtcaRingTransport
+ * Accesses to the registers and the FIFOs of one ring of the uTCA FEC. The nodes of the ring are resolved
+ * once and each method sends its accesses in as few round trips as the protocol allows:
+ * <ul>
+ * <li> a register read or write or a block of words in a FIFO: one round trip
+ * <li> a command on the local bus: the command and the first read of the acknowledge, then the read of the
+ * data with the end of the request and the read of the acknowledge. The acknowledge is polled again once
+ * without waiting before the waits and retries of the request.
+ * </ul>
+ * \brief Registers and FIFOs of a ring of the uTCA FEC
+ */
+class FecUtcaRingTransport {
+
+ public:
+
+  /** Registers of the ring
+   */
+  enum Register { CR0, CR1, SR0, SR1 } ;
+
+  /** \brief Resolve the nodes of a ring
+   * \exception FecExceptionHandler if a node does not exist
+   */
+  FecUtcaRingTransport ( FecUtcaBus &bus, unsigned int ring ) throw (FecExceptionHandler) ;
+
+  /** \brief Return the transaction used, to queue other accesses
+   */
+  FecUtcaTransaction &getTransaction ( ) { return transaction_ ; }
+
+  /** \brief Read a control or a status register
+   */
+  tscType32 readRegister ( Register reg ) throw (FecExceptionHandler) ;
+
+  /** \brief Write a control register
+   */
+  void writeRegister ( Register reg, tscType32 value ) throw (FecExceptionHandler) ;
+
+  /** \brief Write words in the FIFO transmit in one round trip
+   */
+  void writeTransmitFifo ( const tscType32 *values, unsigned int count ) throw (FecExceptionHandler) ;
+
+  /** \brief Read words from the FIFO receive in one round trip
+   */
+  void readReceiveFifo ( tscType32 *values, unsigned int count ) throw (FecExceptionHandler) ;
+
+  /** \brief Read the number of words in the FIFO receive then all the words
+   */
+  std::vector<tscType32> readReceiveFifo ( ) throw (FecExceptionHandler) ;
+
+  /** \brief Send a command to the local bus of the FEC
+   * \param command - address of the register
+   * \param setValue - value written
+   * \param getValue - value read, NULL for a write
+   * \return true if the FEC did not acknowledge the access
+   */
+  bool sendCommand ( tscType32 command, tscType32 setValue, tscType32 *getValue ) throw (FecExceptionHandler) ;
+
+  /** \brief Reset the state machines of the rings and set the clock shifts, two round trips
+   */
+  static void hardReset ( FecUtcaBus &bus, unsigned int minRing, unsigned int maxRing ) throw (FecExceptionHandler) ;
+
+ private:
+
+  /** Node of a ring
+   */
+  static std::string getNodePath ( const char *prefix, unsigned int ring, const char *suffix ) ;
+
+  /** Transaction of the ring
+   */
+  FecUtcaTransaction transaction_ ;
+
+  /** Nodes of the ring
+   */
+  unsigned int registerNodes_[4] ;
+  unsigned int transmitFifoNode_, receiveFifoNode_, receiveFifoWordsNode_ ;
+  unsigned int addressNode_, writeDataNode_, accessModeNode_, accessRequestNode_, accessAckNode_, readDataNode_ ;
+} ;
+
+#endif
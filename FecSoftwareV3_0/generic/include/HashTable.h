@@ -23,6 +23,7 @@
 #include <vector>
 
 #include "hashMapDefinition.h"
+#include "KeyTypeTable.h"
 
 #include "tscTypes.h"
 #include "keyType.h"
@@ -57,52 +58,52 @@
 // Create new type in order to store the access of each device type
 
 // Hash table for the APV
-typedef Sgi::hash_map<keyType, apvAccess *> apvAccessedType ;
+typedef KeyTypeTable<apvAccess *> apvAccessedType ;
 
 // Hash table for the PLL
-typedef Sgi::hash_map<keyType, pllAccess *> pllAccessedType ;
+typedef KeyTypeTable<pllAccess *> pllAccessedType ;
 
 // Hash table for the Laserdriver
-typedef Sgi::hash_map<keyType, laserdriverAccess *> laserdriverAccessedType ;
+typedef KeyTypeTable<laserdriverAccess *> laserdriverAccessedType ;
 
 // Hash table for the Doh
-typedef Sgi::hash_map<keyType, DohAccess *> dohAccessedType ;
+typedef KeyTypeTable<DohAccess *> dohAccessedType ;
 
 // Hash table for the MUX
-typedef Sgi::hash_map<keyType, muxAccess *> muxAccessedType ;
+typedef KeyTypeTable<muxAccess *> muxAccessedType ;
 
 // Hash table for the Philips (not used in normal case)
-typedef Sgi::hash_map<keyType, philipsAccess *> philipsAccessedType ;
+typedef KeyTypeTable<philipsAccess *> philipsAccessedType ;
 
 // Hash table for the DCU
-typedef Sgi::hash_map<keyType, dcuAccess *> dcuAccessedType ;
+typedef KeyTypeTable<dcuAccess *> dcuAccessedType ;
 
 // Hash table for PIA reset - 8 bits for one channel
-typedef Sgi::hash_map<keyType, PiaResetAccess *> piaAccessedType ;
+typedef KeyTypeTable<PiaResetAccess *> piaAccessedType ;
 
 #ifdef PRESHOWER
 // Hash table for Delta
-typedef Sgi::hash_map<keyType, deltaAccess *> deltaAccessedType ;
+typedef KeyTypeTable<deltaAccess *> deltaAccessedType ;
 
 // Hash table for PaceAM
-typedef Sgi::hash_map<keyType, paceAccess *> paceAccessedType ;
+typedef KeyTypeTable<paceAccess *> paceAccessedType ;
 
 // Hash table for Kchip
-typedef Sgi::hash_map<keyType, kchipAccess *> kchipAccessedType ;
+typedef KeyTypeTable<kchipAccess *> kchipAccessedType ;
 
 // Hash table for Kchip
-typedef Sgi::hash_map<keyType, gohAccess *> gohAccessedType ;
+typedef KeyTypeTable<gohAccess *> gohAccessedType ;
 #endif // PRESHOWER
 
 #ifdef TOTEM
 // Hash table for Vfat
-typedef Sgi::hash_map<keyType, vfatAccess *> vfatAccessedType ;
+typedef KeyTypeTable<vfatAccess *> vfatAccessedType ;
 
 // Hash table for CChip
-typedef Sgi::hash_map<keyType, totemCChipAccess *> cchipAccessedType ;
+typedef KeyTypeTable<totemCChipAccess *> cchipAccessedType ;
 
 // Hash table for TTB
-typedef Sgi::hash_map<keyType, totemBBAccess *> tbbAccessedType ;
+typedef KeyTypeTable<totemBBAccess *> tbbAccessedType ;
 #endif // TOTEM
 
 // Hash table for the DCU values
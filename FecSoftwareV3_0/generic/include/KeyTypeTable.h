@@ -0,0 +1,610 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Copyright 2002 - 2003, Frederic DROUHIN - Universite de Haute-Alsace, Mulhouse-France
+*/
+#ifndef KEYTYPETABLE_H
+#define KEYTYPETABLE_H
+
+#include <algorithm>
+#include <deque>
+#include <vector>
+#include <utility>
+
+#include "keyType.h"
+
+/** Number of FEC/ring of the first level (FEC and ring bits of the key)
+ */
+#define KEYTABLERINGS ((MASKFECKEY+1)*(MASKRINGKEY+1))
+
+/** Number of CCU addresses in a ring
+ */
+#define KEYTABLECCUS (MASKCCUKEY+1)
+
+/** Number of channels with a slot in a ring: node controller, i2c channels and broadcast (0x0 to 0x20), PIA (0x30 to 0x33), memory, trigger and JTAG
+ */
+#define KEYTABLECHANNELS 40
+
+/** Number of addresses in the dense table: i2c addresses are on 7 bits
+ */
+#define KEYTABLEADDRESSES 0x80
+
+/** Number of keys in a ring before the ring gets a dense table
+ */
+#define KEYTABLEDENSERING 16
+
+/** Slot not used
+ */
+#define KEYTABLEEMPTY 0
+
+/** Slot of the open addressing table released
+ */
+#define KEYTABLEDELETED 0xFFFFFFFF
+
+/**
+ * \class KeyTypeTable
+ * Map indexed by a keyType (cf. keyType.h) with the interface of Sgi::hash_map used for the accesses.
+ * <p>The values are stored in a deque in the order of insertion, a slot released by erase is reused by the next insertion.
+ * The iteration follows this order and does not depend on a hash function.
+ * <p>A key is found by:
+ * <ul>
+ * <li>the FEC and the ring (first level, KEYTABLERINGS entries)
+ * <li>for a ring with at least KEYTABLEDENSERING keys: the CCU and the channel in arrays allocated for the CCUs used, then the
+ * address in a compact array of slots (one bit per address and the number of addresses before each word of bits give the
+ * rank of the slot). A slot points directly to the value, as the node of a hash_map.
+ * <li>otherwise, or for a channel/address outside of the dense table, an open addressing table
+ * </ul>
+ * \brief Map indexed by FEC/ring/CCU/channel/address
+ * \warning the iterators stay valid after an insertion or the erase of another key. The references to the values are valid until the key is erased.
+ */
+template <class T> class KeyTypeTable {
+
+ public:
+
+  typedef keyType key_type ;
+  typedef T mapped_type ;
+  typedef std::pair<keyType, T> value_type ;
+  typedef unsigned int size_type ;
+
+ private:
+
+  /** Value and its index in the order of the slots
+   */
+  struct Entry {
+    value_type value_ ;
+    unsigned int index_ ;
+  } ;
+
+ public:
+
+  class const_iterator ;
+
+  /** Iterator on the values in the order of the slots, NULL value after the last one
+   */
+  class iterator {
+
+    friend class KeyTypeTable ;
+    friend class const_iterator ;
+
+  public:
+
+    iterator ( ): table_(NULL), entry_(NULL) { }
+
+    value_type &operator* ( ) const { return entry_->value_ ; }
+    value_type *operator-> ( ) const { return &entry_->value_ ; }
+    iterator &operator++ ( ) { entry_ = table_->nextEntry (entry_->index_ + 1) ; return *this ; }
+    iterator operator++ ( int ) { iterator it = *this ; entry_ = table_->nextEntry (entry_->index_ + 1) ; return it ; }
+    bool operator== ( const iterator &it ) const { return entry_ == it.entry_ ; }
+    bool operator!= ( const iterator &it ) const { return entry_ != it.entry_ ; }
+
+  private:
+
+    iterator ( KeyTypeTable *table, Entry *entry ): table_(table), entry_(entry) { }
+
+    KeyTypeTable *table_ ;
+    Entry *entry_ ;
+  } ;
+
+  /** Constant iterator on the values in the order of the slots
+   */
+  class const_iterator {
+
+    friend class KeyTypeTable ;
+
+  public:
+
+    const_iterator ( ): table_(NULL), entry_(NULL) { }
+    const_iterator ( const iterator &it ): table_(it.table_), entry_(it.entry_) { }
+
+    const value_type &operator* ( ) const { return entry_->value_ ; }
+    const value_type *operator-> ( ) const { return &entry_->value_ ; }
+    const_iterator &operator++ ( ) { entry_ = table_->nextEntry (entry_->index_ + 1) ; return *this ; }
+    const_iterator operator++ ( int ) { const_iterator it = *this ; entry_ = table_->nextEntry (entry_->index_ + 1) ; return it ; }
+    bool operator== ( const const_iterator &it ) const { return entry_ == it.entry_ ; }
+    bool operator!= ( const const_iterator &it ) const { return entry_ != it.entry_ ; }
+
+  private:
+
+    const_iterator ( const KeyTypeTable *table, const Entry *entry ): table_(table), entry_(entry) { }
+
+    const KeyTypeTable *table_ ;
+    const Entry *entry_ ;
+  } ;
+
+  /** \brief Empty table, nothing is allocated
+   */
+  KeyTypeTable ( ): size_(0), wastedSlots_(0), sparseUsed_(0), sparseLive_(0) { }
+
+  /** \brief Copy of a table, the slots point to the values of the copy
+   */
+  KeyTypeTable ( const KeyTypeTable &table ) { copy (table) ; }
+
+  KeyTypeTable &operator= ( const KeyTypeTable &table ) {
+    if (this != &table) copy (table) ;
+    return *this ;
+  }
+
+  /** \brief Number of values
+   */
+  size_type size ( ) const { return size_ ; }
+
+  /** \brief No value
+   */
+  bool empty ( ) const { return size_ == 0 ; }
+
+  /** \brief First value
+   */
+  iterator begin ( ) { return iterator (this, nextEntry (0)) ; }
+  const_iterator begin ( ) const { return const_iterator (this, nextEntry (0)) ; }
+
+  /** \brief After the last value
+   */
+  iterator end ( ) { return iterator (this, NULL) ; }
+  const_iterator end ( ) const { return const_iterator (this, NULL) ; }
+
+  /** \brief Find a key
+   * \return end() if the key is not present
+   */
+  iterator find ( keyType key ) { return iterator (this, lookup (key)) ; }
+  const_iterator find ( keyType key ) const { return const_iterator (this, lookup (key)) ; }
+
+  /** \brief 1 if the key is present, 0 otherwise
+   */
+  size_type count ( keyType key ) const { return (lookup (key) != NULL) ? 1 : 0 ; }
+
+  /** \brief Value of a key, inserted with T() if the key is not present
+   */
+  T &operator[] ( keyType key ) {
+    Entry *entry = lookup (key) ;
+    if (entry == NULL) entry = insertEntry (key, T()) ;
+    return entry->value_.second ;
+  }
+
+  /** \brief Insert a value if the key is not present
+   * \return iterator on the value of the key and true if the value was inserted
+   */
+  std::pair<iterator, bool> insert ( const value_type &value ) {
+    Entry *entry = lookup (value.first) ;
+    if (entry != NULL) return std::make_pair (iterator (this, entry), false) ;
+    return std::make_pair (iterator (this, insertEntry (value.first, value.second)), true) ;
+  }
+
+  /** \brief Remove a key
+   * \return number of values removed
+   */
+  size_type erase ( keyType key ) {
+
+    unsigned int ring = getRingIndex (key), channelSlot = 0, entry = KEYTABLEEMPTY ;
+    bool dense = getChannelSlot (key, channelSlot) ;
+
+    if (dense && isDenseRing (ring)) {
+      Entry *denseEntry = eraseDense (ring, channelSlot, key) ;
+      if (denseEntry != NULL) entry = denseEntry->index_ + 1 ;
+    }
+    else {
+      int sparseSlot = findSparse (key) ;
+      if (sparseSlot < 0) return 0 ;
+      entry = sparseSlots_[sparseSlot] ;
+      sparseSlots_[sparseSlot] = KEYTABLEDELETED ;
+      sparseLive_ -- ;
+      if (dense) ringKeys_[ring] -- ;
+    }
+
+    if (entry == KEYTABLEEMPTY) return 0 ;
+    entry -- ;
+    used_[entry] = false ;
+    entries_[entry].value_.second = T() ;
+    freeEntries_.push_back (entry) ;
+    size_ -- ;
+
+    return 1 ;
+  }
+
+  /** \brief Remove the value of an iterator
+   * \return iterator on the next value
+   */
+  iterator erase ( iterator it ) {
+    iterator next = it ;
+    ++ next ;
+    erase (it->first) ;
+    return next ;
+  }
+
+  /** \brief Remove all the values and release the tables
+   */
+  void clear ( ) {
+    entries_.clear() ; used_.clear() ; freeEntries_.clear() ; size_ = 0 ;
+    rings_.clear() ; ccus_.clear() ; channels_.clear() ; addresses_.clear() ; slots_.clear() ; wastedSlots_ = 0 ; ringKeys_.clear() ;
+    sparseKeys_.clear() ; sparseSlots_.clear() ; sparseUsed_ = sparseLive_ = 0 ;
+  }
+
+  /** \brief Number of rings with a dense table
+   */
+  unsigned int getNumberOfDenseRings ( ) const {
+    unsigned int dense = 0 ;
+    for (unsigned int ring = 0 ; ring < rings_.size() ; ring ++) if (rings_[ring] != KEYTABLEEMPTY) dense ++ ;
+    return dense ;
+  }
+
+  /** \brief Memory used by the indexes in bytes (values not included)
+   */
+  unsigned long getIndexMemorySize ( ) const {
+    return (rings_.capacity() + ccus_.capacity() + channels_.capacity() + ringKeys_.capacity() +
+	    sparseSlots_.capacity() + freeEntries_.capacity()) * sizeof(unsigned int) + slots_.capacity() * sizeof(Entry *) +
+      addresses_.capacity() * sizeof(AddressSet) + sparseKeys_.capacity() * sizeof(keyType) + used_.capacity() / 8 ;
+  }
+
+ private:
+
+  /** Addresses of a CCU/channel in a dense ring: one bit per address and number of addresses before each word of bits,
+   * the entries of the addresses are stored in this order from the first slot
+   */
+  struct AddressSet {
+    unsigned int mask_[KEYTABLEADDRESSES / 32] ;
+    unsigned char rank_[KEYTABLEADDRESSES / 32] ;
+    unsigned int first_ ;
+    unsigned int capacity_ ;
+  } ;
+
+  /** FEC and ring of a key
+   */
+  static unsigned int getRingIndex ( keyType key ) { return (key >> OFFRINGKEY) & ((MASKFECKEY << (OFFFECKEY-OFFRINGKEY)) | MASKRINGKEY) ; }
+
+  /** Slot of the channel of a key in the array of its CCU
+   * \return false if the channel or the address have no slot
+   */
+  static bool getChannelSlot ( keyType key, unsigned int &channelSlot ) {
+    unsigned int channel = getChannelKey(key) ;
+    if (channel <= 0x20) channelSlot = channel ;
+    else if ((channel >= 0x30) && (channel <= 0x33)) channelSlot = 0x21 + channel - 0x30 ;
+    else if (channel == 0x40) channelSlot = 37 ;
+    else if (channel == 0x50) channelSlot = 38 ;
+    else if (channel == 0x60) channelSlot = 39 ;
+    else return false ;
+    return getAddressKey(key) < KEYTABLEADDRESSES ;
+  }
+
+  /** Number of bits set in a word. __builtin_popcount is a call to the gcc library when the processor instruction is
+   * not enabled by the compilation flags.
+   */
+  static unsigned int countBits ( unsigned int bits ) {
+    bits = bits - ((bits >> 1) & 0x55555555) ;
+    bits = (bits & 0x33333333) + ((bits >> 2) & 0x33333333) ;
+    return (((bits + (bits >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24 ;
+  }
+
+  /** Number of addresses of a set
+   */
+  static unsigned int getNumberOfAddresses ( const AddressSet &set ) {
+    return set.rank_[KEYTABLEADDRESSES / 32 - 1] + countBits (set.mask_[KEYTABLEADDRESSES / 32 - 1]) ;
+  }
+
+  /** Rank of an address in a set (number of addresses below)
+   */
+  static unsigned int getRank ( const AddressSet &set, unsigned int address ) {
+    return set.rank_[address / 32] + countBits (set.mask_[address / 32] & ((1U << (address % 32)) - 1)) ;
+  }
+
+  /** Set or clear an address in a set and update the ranks of the next words
+   */
+  static void setAddress ( AddressSet &set, unsigned int address, bool present ) {
+    if (present) set.mask_[address / 32] |= 1U << (address % 32) ;
+    else set.mask_[address / 32] &= ~(1U << (address % 32)) ;
+    for (unsigned int i = address / 32 + 1 ; i < KEYTABLEADDRESSES / 32 ; i ++) set.rank_[i] += present ? 1 : -1 ;
+  }
+
+  static bool isAddressSet ( const AddressSet &set, unsigned int address ) { return (set.mask_[address / 32] >> (address % 32)) & 0x1 ; }
+
+  /** Hash of the open addressing table
+   */
+  static unsigned int hashKey ( keyType key ) {
+    key ^= key >> 16 ; key *= 0x45d9f3b ; key ^= key >> 16 ;
+    return key ;
+  }
+
+  bool isDenseRing ( unsigned int ring ) const { return !rings_.empty() && (rings_[ring] != KEYTABLEEMPTY) ; }
+
+  /** \return address set + 1 of the CCU/channel of the key in a dense ring or KEYTABLEEMPTY
+   */
+  unsigned int findAddressSet ( unsigned int ring, keyType key, unsigned int channelSlot ) const {
+    unsigned int ccu = ccus_[(rings_[ring] - 1) * KEYTABLECCUS + getCcuKey(key)] ;
+    return (ccu == KEYTABLEEMPTY) ? KEYTABLEEMPTY : channels_[(ccu - 1) * KEYTABLECHANNELS + channelSlot] ;
+  }
+
+  /** First entry used from index
+   * \return NULL after the last entry
+   */
+  Entry *nextEntry ( unsigned int index ) {
+    while ((index < used_.size()) && !used_[index]) index ++ ;
+    return (index < used_.size()) ? &entries_[index] : NULL ;
+  }
+  const Entry *nextEntry ( unsigned int index ) const { return const_cast<KeyTypeTable *>(this)->nextEntry (index) ; }
+
+  /** \return entry of the key or NULL
+   */
+  Entry *lookup ( keyType key ) {
+    unsigned int ring = getRingIndex (key), channelSlot = 0 ;
+    if (isDenseRing (ring) && getChannelSlot (key, channelSlot)) {
+      unsigned int setIndex = findAddressSet (ring, key, channelSlot) ;
+      if (setIndex == KEYTABLEEMPTY) return NULL ;
+      const AddressSet &set = addresses_[setIndex - 1] ;
+      unsigned int address = getAddressKey(key) ;
+      return isAddressSet (set, address) ? slots_[set.first_ + getRank (set, address)] : NULL ;
+    }
+    int sparseSlot = findSparse (key) ;
+    return (sparseSlot < 0) ? NULL : &entries_[sparseSlots_[sparseSlot] - 1] ;
+  }
+  const Entry *lookup ( keyType key ) const { return const_cast<KeyTypeTable *>(this)->lookup (key) ; }
+
+  /** \return slot in the open addressing table or -1
+   */
+  int findSparse ( keyType key ) const {
+    if (sparseKeys_.empty()) return -1 ;
+    unsigned int mask = sparseKeys_.size() - 1 ;
+    for (unsigned int i = hashKey (key) & mask ; sparseSlots_[i] != KEYTABLEEMPTY ; i = (i + 1) & mask)
+      if ((sparseSlots_[i] != KEYTABLEDELETED) && (sparseKeys_[i] == key)) return i ;
+    return -1 ;
+  }
+
+  /** Store a new value
+   * \return entry of the value
+   */
+  Entry *insertEntry ( keyType key, const T &value ) {
+
+    unsigned int index ;
+    if (freeEntries_.empty()) {
+      index = entries_.size() ;
+      Entry entry = { value_type (key, value), index } ;
+      entries_.push_back (entry) ;
+      used_.push_back (true) ;
+    }
+    else {
+      index = freeEntries_.back() ;
+      freeEntries_.pop_back() ;
+      entries_[index].value_.first = key ;
+      entries_[index].value_.second = value ;
+      used_[index] = true ;
+    }
+    size_ ++ ;
+
+    Entry *entry = &entries_[index] ;
+    unsigned int ring = getRingIndex (key), channelSlot = 0 ;
+    bool dense = getChannelSlot (key, channelSlot) ;
+    if (dense && isDenseRing (ring)) insertDense (ring, channelSlot, key, entry) ;
+    else {
+      insertSparse (key, index) ;
+      if (dense) {
+	if (ringKeys_.empty()) ringKeys_.resize (KEYTABLERINGS, 0) ;
+	if (++ ringKeys_[ring] >= KEYTABLEDENSERING) buildDenseRing (ring) ;
+      }
+    }
+
+    return entry ;
+  }
+
+  /** Set the key in the address set of its CCU/channel, the arrays of the CCU and of the channel are allocated if needed.
+   * The slots of the set are moved at the end of the slots when the set is full.
+   */
+  void insertDense ( unsigned int ring, unsigned int channelSlot, keyType key, Entry *entry ) {
+
+    unsigned int ccuIndex = (rings_[ring] - 1) * KEYTABLECCUS + getCcuKey(key) ;
+    if (ccus_[ccuIndex] == KEYTABLEEMPTY) {
+      channels_.resize (channels_.size() + KEYTABLECHANNELS, KEYTABLEEMPTY) ;
+      ccus_[ccuIndex] = channels_.size() / KEYTABLECHANNELS ;
+    }
+    unsigned int &setIndex = channels_[(ccus_[ccuIndex] - 1) * KEYTABLECHANNELS + channelSlot] ;
+    if (setIndex == KEYTABLEEMPTY) {
+      AddressSet set = { { 0 }, { 0 }, 0, 0 } ;
+      addresses_.push_back (set) ;
+      setIndex = addresses_.size() ;
+    }
+
+    AddressSet &set = addresses_[setIndex - 1] ;
+    unsigned int n = getNumberOfAddresses (set) ;
+    if (n == set.capacity_) {
+      unsigned int capacity = set.capacity_ ? set.capacity_ * 2 : 2 ;
+      slots_.resize (slots_.size() + capacity, NULL) ;
+      std::copy (slots_.begin() + set.first_, slots_.begin() + set.first_ + n, slots_.end() - capacity) ;
+      wastedSlots_ += set.capacity_ ;
+      set.first_ = slots_.size() - capacity ;
+      set.capacity_ = capacity ;
+    }
+
+    unsigned int address = getAddressKey(key), first = set.first_ + getRank (set, address) ;
+    std::copy_backward (slots_.begin() + first, slots_.begin() + set.first_ + n, slots_.begin() + set.first_ + n + 1) ;
+    slots_[first] = entry ;
+    setAddress (set, address, true) ;
+
+    if (wastedSlots_ > slots_.size() / 4) compactSlots() ;
+  }
+
+  /** Remove the key from the address set of its CCU/channel
+   * \return entry of the key or NULL
+   */
+  Entry *eraseDense ( unsigned int ring, unsigned int channelSlot, keyType key ) {
+
+    unsigned int setIndex = findAddressSet (ring, key, channelSlot), address = getAddressKey(key) ;
+    if ((setIndex == KEYTABLEEMPTY) || !isAddressSet (addresses_[setIndex - 1], address)) return NULL ;
+
+    AddressSet &set = addresses_[setIndex - 1] ;
+    unsigned int n = getNumberOfAddresses (set), first = set.first_ + getRank (set, address) ;
+    Entry *entry = slots_[first] ;
+    std::copy (slots_.begin() + first + 1, slots_.begin() + set.first_ + n, slots_.begin() + first) ;
+    slots_[set.first_ + n - 1] = NULL ;
+    setAddress (set, address, false) ;
+
+    return entry ;
+  }
+
+  /** Remove the slots released by the address sets moved
+   */
+  void compactSlots ( ) {
+
+    std::vector<Entry *> slots ;
+    slots.reserve (slots_.size() - wastedSlots_) ;
+    for (unsigned int i = 0 ; i < addresses_.size() ; i ++) {
+      AddressSet &set = addresses_[i] ;
+      unsigned int first = slots.size() ;
+      slots.insert (slots.end(), slots_.begin() + set.first_, slots_.begin() + set.first_ + set.capacity_) ;
+      set.first_ = first ;
+    }
+    slots_.swap (slots) ;
+    wastedSlots_ = 0 ;
+  }
+
+  /** Set the key in the open addressing table, the key must not be present
+   */
+  void insertSparse ( keyType key, unsigned int entry ) {
+
+    if ((sparseUsed_ + 1) * 2 > sparseKeys_.size()) rehashSparse() ;
+
+    unsigned int mask = sparseKeys_.size() - 1, i = hashKey (key) & mask ;
+    while ((sparseSlots_[i] != KEYTABLEEMPTY) && (sparseSlots_[i] != KEYTABLEDELETED)) i = (i + 1) & mask ;
+    if (sparseSlots_[i] == KEYTABLEEMPTY) sparseUsed_ ++ ;
+    sparseKeys_[i] = key ;
+    sparseSlots_[i] = entry + 1 ;
+    sparseLive_ ++ ;
+  }
+
+  /** Resize the open addressing table to have at most one quarter of the slots used, the slots released are removed
+   */
+  void rehashSparse ( ) {
+
+    unsigned int size = 16 ;
+    while (size < (sparseLive_ + 1) * 4) size <<= 1 ;
+
+    std::vector<keyType> keys (size, 0) ;
+    std::vector<unsigned int> slots (size, KEYTABLEEMPTY) ;
+    for (unsigned int j = 0 ; j < sparseKeys_.size() ; j ++) {
+      if ((sparseSlots_[j] == KEYTABLEEMPTY) || (sparseSlots_[j] == KEYTABLEDELETED)) continue ;
+      unsigned int i = hashKey (sparseKeys_[j]) & (size - 1) ;
+      while (slots[i] != KEYTABLEEMPTY) i = (i + 1) & (size - 1) ;
+      keys[i] = sparseKeys_[j] ;
+      slots[i] = sparseSlots_[j] ;
+    }
+    sparseKeys_.swap (keys) ;
+    sparseSlots_.swap (slots) ;
+    sparseUsed_ = sparseLive_ ;
+  }
+
+  /** Move the keys of a ring from the open addressing table to the dense table
+   */
+  void buildDenseRing ( unsigned int ring ) {
+
+    if (rings_.empty()) rings_.resize (KEYTABLERINGS, KEYTABLEEMPTY) ;
+    ccus_.resize (ccus_.size() + KEYTABLECCUS, KEYTABLEEMPTY) ;
+    rings_[ring] = ccus_.size() / KEYTABLECCUS ;
+
+    unsigned int channelSlot = 0 ;
+    for (unsigned int i = 0 ; i < sparseKeys_.size() ; i ++) {
+      if ((sparseSlots_[i] == KEYTABLEEMPTY) || (sparseSlots_[i] == KEYTABLEDELETED)) continue ;
+      if ((getRingIndex (sparseKeys_[i]) == ring) && getChannelSlot (sparseKeys_[i], channelSlot)) {
+	insertDense (ring, channelSlot, sparseKeys_[i], &entries_[sparseSlots_[i] - 1]) ;
+	sparseSlots_[i] = KEYTABLEDELETED ;
+	sparseLive_ -- ;
+      }
+    }
+    ringKeys_[ring] = 0 ;
+  }
+
+  /** Copy the values and the indexes of a table, the slots are set to the entries of this table
+   */
+  void copy ( const KeyTypeTable &table ) {
+
+    entries_ = table.entries_ ; used_ = table.used_ ; freeEntries_ = table.freeEntries_ ; size_ = table.size_ ;
+    rings_ = table.rings_ ; ccus_ = table.ccus_ ; channels_ = table.channels_ ; addresses_ = table.addresses_ ;
+    slots_ = table.slots_ ; wastedSlots_ = table.wastedSlots_ ; ringKeys_ = table.ringKeys_ ;
+    sparseKeys_ = table.sparseKeys_ ; sparseSlots_ = table.sparseSlots_ ; sparseUsed_ = table.sparseUsed_ ; sparseLive_ = table.sparseLive_ ;
+    for (unsigned int i = 0 ; i < slots_.size() ; i ++)
+      if (slots_[i] != NULL) slots_[i] = &entries_[slots_[i]->index_] ;
+  }
+
+  /** Values in the order of the slots, the deque keeps the address of an entry when another one is added
+   */
+  std::deque<Entry> entries_ ;
+
+  /** Slots used
+   */
+  std::vector<bool> used_ ;
+
+  /** Slots released
+   */
+  std::vector<unsigned int> freeEntries_ ;
+
+  /** Number of values
+   */
+  size_type size_ ;
+
+  /** For each FEC/ring: array of CCUs + 1, KEYTABLEEMPTY for a ring without dense table
+   */
+  std::vector<unsigned int> rings_ ;
+
+  /** Arrays of KEYTABLECCUS CCUs of the dense rings: array of channels + 1
+   */
+  std::vector<unsigned int> ccus_ ;
+
+  /** Arrays of KEYTABLECHANNELS channels of the CCUs used: address set + 1
+   */
+  std::vector<unsigned int> channels_ ;
+
+  /** Address sets of the channels used
+   */
+  std::vector<AddressSet> addresses_ ;
+
+  /** Slots of the address sets: entry of the value or NULL
+   */
+  std::vector<Entry *> slots_ ;
+
+  /** Slots no more used after the move of an address set
+   */
+  unsigned int wastedSlots_ ;
+
+  /** Keys of a ring without dense table which can be moved to the dense table
+   */
+  std::vector<unsigned int> ringKeys_ ;
+
+  /** Open addressing table: keys and entry + 1 (KEYTABLEEMPTY or KEYTABLEDELETED)
+   */
+  std::vector<keyType> sparseKeys_ ;
+  std::vector<unsigned int> sparseSlots_ ;
+
+  /** Number of slots of the open addressing table used (including the slots released) and with a key
+   */
+  unsigned int sparseUsed_, sparseLive_ ;
+} ;
+
+#endif
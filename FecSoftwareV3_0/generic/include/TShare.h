@@ -7,6 +7,35 @@
 #include <sys/sem.h>
 #include <unistd.h>
 #include <string>
+/** Maximum number of generations in a share memory
+ */
+#define TSHAREMAXGENERATIONS 8
+
+/** Size reserved at the beginning of the share memory for the generation header
+ */
+#define TSHAREHEADERSIZE 4096
+
+/** Identification of a share memory with generations
+ */
+#define TSHAREMAGIC 0x54534847
+
+/**
+   \struct TShareHeader
+   \brief Header at the beginning of a share memory with generations.
+   sequence is odd while the generation is written, current is the last generation published.
+ */
+typedef struct {
+  volatile unsigned int magic;  ///< TSHAREMAGIC once initialised
+  unsigned int generations;     ///< Number of generations
+  unsigned int size;            ///< Size of one generation
+  volatile unsigned int current; ///< Generation published
+  volatile unsigned int version; ///< Number of generations published
+  volatile pid_t writer;        ///< Thread id of the writer of a generation, 0 if none
+  volatile unsigned int recoveries; ///< Number of updates recovered after the death of the writer
+  volatile unsigned int sequence[TSHAREMAXGENERATIONS]; ///< Seqlock of each generation
+  volatile unsigned int length[TSHAREMAXGENERATIONS]; ///< Bytes used in each generation
+} TShareHeader;
+
 /**
  \enum TShareType
  */
@@ -45,6 +74,27 @@ enum TShareType {
    <pre>
    ms->Detach(mc);
    </pre>
+   <h2> Generations </h2>
+   A share memory created with 2 generations or more is published without
+   semaphore: the writer fills the next generation and then changes the
+   generation published, the readers copy the generation published and
+   check with its sequence number that it was not modified during the copy.
+   The writer never waits for the readers and a reader which dies has no
+   effect on the others.
+   <pre>
+   // Writer
+   TShare *ms = new TShare("MyShare",TShare_CREATE,1000,3);
+   char *buffer = (char *) ms->BeginUpdate();
+   int length = fillTheBuffer(buffer);
+   ms->Publish(length);
+   // Reader
+   TShare *ms = new TShare("MyShare",TShare_OPEN,0);
+   char buffer[1000];
+   unsigned int length = ms->ReadGeneration(buffer,1000);
+   </pre>
+   Only one thread, of this process or another one, can update the memory at
+   a time. If the writer dies during an update, the next BeginUpdate detects
+   it and takes the update back, the generation published is not modified.
    <h5>note</h5> 
    Two empty files are created in /tmp by TShare: \\
     name.sem and name.shm 
@@ -79,6 +129,10 @@ private:
   int fSize; ///< Sahre memory size
 
   struct sembuf fSembuf[1]; 
+  TShareHeader *fHeader; ///< Generation header, NULL if the memory has no generation
+  unsigned int fWriting; ///< Generation written by BeginUpdate
+  /** Attach the memory for the generation methods and check the header */
+  TShareHeader* GetHeader() throw (std::string);
  protected:
   bool isServer; ///< True if open in create mode
 public:
@@ -86,9 +140,10 @@ public:
      Create a TShare object:
      @param name Share memory name
      @param mode TShare_CREATE or TShare_OPEN (see TShare.h)
-     @param size Share memory size
+     @param size Share memory size (size of one generation if generations > 1)
+     @param generations Number of generations (TShare_CREATE only), 0 for a memory without generation
    */
-  TShare(char* name,int mode,int size) throw (std::string);
+  TShare(char* name,int mode,int size,unsigned int generations=0) throw (std::string);
   ~TShare() throw (std::string);
   /** Lock the Semaphore to access safely the Share memory */
   void Lock() throw (std::string);
@@ -102,9 +157,83 @@ public:
       @param ad  pointer to the Share memory
    */
   void Detach(const void* ad) throw (std::string);
+  /** Start the update of the next generation, only one thread of one process can update the memory at a time.
+      Publish and AbortUpdate must be called by the thread which began the update
+      @return pointer to the generation to be filled
+   */
+  void* BeginUpdate() throw (std::string);
+  /** Publish the generation filled after BeginUpdate
+      @param length Number of bytes used
+   */
+  void Publish(unsigned int length) throw (std::string);
+  /** Abort an update, the generation published is not changed */
+  void AbortUpdate() throw (std::string);
+  /** Copy the generation published
+      @param buffer Destination
+      @param size Size of the destination
+      @param maxRetry Number of copies done before giving up if the writer modifies the generation
+      @return number of bytes copied
+   */
+  unsigned int ReadGeneration(void* buffer,unsigned int size,unsigned int maxRetry=1000) throw (std::string);
+  /** Pointer to the generation published, for reading in place
+      @param sequence Sequence to be given to ValidateGeneration
+      @param length Number of bytes used
+   */
+  const void* GetGeneration(unsigned int &sequence,unsigned int &length) throw (std::string);
+  /** Check that a generation read in place was not modified since GetGeneration */
+  bool ValidateGeneration(const void* generation,unsigned int sequence) throw (std::string);
+  /** Size of one generation, 0 if the memory has no generation */
+  unsigned int GetGenerationSize() throw (std::string);
+  /** Number of generations published, 0 if the memory has no generation */
+  unsigned int GetVersion() throw (std::string);
+  /** True if the memory was created with generations */
+  bool HasGenerations() throw (std::string);
   /** Return Share memory name */
   inline const char* GetName() { return fName;}
 };
+
+/**
+   Update of the next generation of a TShare, aborted when the object is destroyed
+   without Publish (for example when an exception is raised while the generation
+   is filled), so that the memory is never left in update.
+   <pre>
+   TShareUpdate update;
+   char *buffer = (char *) update.Begin(ms);
+   int length = fillTheBuffer(buffer); // can throw
+   update.Publish(length);
+   </pre>
+ */
+class TShareUpdate {
+private:
+  TShare* fShare; ///< Memory in update, NULL if no update
+public:
+  TShareUpdate() : fShare(NULL) {}
+  ~TShareUpdate() { Abort(); }
+  /** Start the update of the next generation of a memory (TShare::BeginUpdate) */
+  void* Begin(TShare* share) throw (std::string)
+    {
+      void* buffer = share->BeginUpdate();
+      fShare = share;
+      return buffer;
+    }
+  /** True between Begin and Publish or Abort */
+  bool Started() const { return fShare != NULL; }
+  /** Publish the generation filled (TShare::Publish) */
+  void Publish(unsigned int length) throw (std::string)
+    {
+      TShare* share = fShare;
+      fShare = NULL;
+      share->Publish(length);
+    }
+  /** Abort the update if it is not published (TShare::AbortUpdate), the errors are ignored */
+  void Abort() throw ()
+    {
+      if (fShare == NULL) return;
+      try { fShare->AbortUpdate(); }
+      catch (std::string &e) { }
+      fShare = NULL;
+    }
+};
 #endif
 
 
@@ -0,0 +1,224 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Copyright 2002 - 2003, Frederic DROUHIN - Universite de Haute-Alsace, Mulhouse-France
+*/
+#ifndef TESTFECRINGDEVICE_H
+#define TESTFECRINGDEVICE_H
+
+#include <deque>
+#include <vector>
+
+#include <pthread.h>
+
+#include "cmdDescription.h"
+#include "FecRingDevice.h"
+
+/**
+ * Ring without hardware used by the test executables of ThirdParty/APIConsoleDebugger.
+ * The registers and the FIFOs of the FEC are emulated: the frames written in the FIFO transmit
+ * are given to answerFrame when the send bit of the CR0 is toggled, and the derived class puts
+ * the direct acknowledge and the answers of the CCUs in the FIFO receive with pushFrame.
+ * The derived class can also emulate the time of the bus accesses (busAccess) and frames which
+ * arrive later in the FIFO receive (update).
+ * The SR0 gives the number of words of the FIFO receive only when the firmware version allows the
+ * block transfers (MINFIRMWAREVERSION). All the accesses are protected by a mutex so a thread can
+ * read the ring while another one downloads frames.
+ */
+class FecFakeRingDevice: public FecRingDevice {
+
+ public:
+
+  FecFakeRingDevice ( tscType8 fecSlot, tscType8 ringSlot, tscType16 firmwareVersion ):
+    FecRingDevice (fecSlot, ringSlot, FECVME), firmwareVersion_(firmwareVersion), cr0_(FEC_CR0_ENABLEFEC), pendingIrq_(false),
+    frames_(0), sends_(0) {
+
+    pthread_mutex_init (&mutex_, NULL) ;
+    setInitFecRingDevice (false) ;
+  }
+
+  virtual ~FecFakeRingDevice ( ) {
+    pthread_mutex_destroy (&mutex_) ;
+  }
+
+  /** Number of frames sent on the ring
+   */
+  unsigned long getNumberOfFrames ( ) { return frames_ ; }
+
+  /** Number of times the FIFO transmit was sent
+   */
+  unsigned long getNumberOfSends ( ) { return sends_ ; }
+
+  /** Frame arriving in the FIFO receive when no transaction is running, a CCU alarm for example
+   */
+  void injectFrame ( const std::vector<tscType8> &frame ) {
+    pthread_mutex_lock (&mutex_) ;
+    pushFrame (frame) ;
+    pthread_mutex_unlock (&mutex_) ;
+  }
+
+  // ---------------------------------------------- registers
+
+  void setFecRingCR0 ( tscType16 ctrl0Value, bool force = false ) {
+    pthread_mutex_lock (&mutex_) ;
+    busAccess (0) ;
+    if ((ctrl0Value & FEC_CR0_SEND) && !(cr0_ & FEC_CR0_SEND)) send() ;
+    cr0_ = ctrl0Value ;
+    pthread_mutex_unlock (&mutex_) ;
+  }
+  tscType16 getFecRingCR0 ( ) { busAccess (0) ; return cr0_ ; }
+  void setFecRingCR1 ( tscType16 ctrl1Value ) {
+    pthread_mutex_lock (&mutex_) ;
+    busAccess (0) ;
+    if (ctrl1Value & FEC_CR1_CLEARIRQ) pendingIrq_ = false ;
+    pthread_mutex_unlock (&mutex_) ;
+  }
+  tscType16 getFecRingCR1 ( ) { busAccess (0) ; return 0 ; }
+  tscType32 getFecRingSR0 ( unsigned long sleeptime = 0 ) {
+    pthread_mutex_lock (&mutex_) ;
+    busAccess (0) ;
+    update() ;
+    tscType32 sr0 = FEC_SR0_LINKINITIALIZED | FEC_SR0_TRAEMPTY | FEC_SR0_RETEMPTY ;
+    if (receive_.empty()) sr0 |= FEC_SR0_RECEMPTY ;
+    if (pendingIrq_) sr0 |= FEC_SR0_PENDINGIRQ ;
+    for (std::deque<tscType8>::iterator it = receiveDst_.begin() ; it != receiveDst_.end() ; it ++)
+      if (*it == FRAMEFECNUMBER) { sr0 |= FEC_SR0_DATATOFEC ; break ; }
+    if (firmwareVersion_ >= MINFIRMWAREVERSION)
+      sr0 |= (receive_.size() < MAXFECFIFOWORD ? receive_.size() : MAXFECFIFOWORD) << 16 ;
+    pthread_mutex_unlock (&mutex_) ;
+    return sr0 ;
+  }
+  tscType16 getFecRingSR1 ( ) { busAccess (0) ; return 0 ; }
+  tscType16 getFecFirmwareVersion ( ) throw (FecExceptionHandler) { return firmwareVersion_ ; }
+
+  // ---------------------------------------------- FIFOs
+
+  tscType32 getFifoReceive ( ) {
+    pthread_mutex_lock (&mutex_) ;
+    busAccess (0) ;
+    tscType32 value = popReceive() ;
+    pthread_mutex_unlock (&mutex_) ;
+    return value ;
+  }
+  tscType32* getFifoReceive ( tscType32 *value, int count ) throw (FecExceptionHandler) {
+    pthread_mutex_lock (&mutex_) ;
+    busAccess (count) ;
+    for (int i = 0 ; i < count ; i ++) value[i] = popReceive() ;
+    pthread_mutex_unlock (&mutex_) ;
+    return value ;
+  }
+  void setFifoReceive ( tscType32 value ) { }
+  tscType8 getFifoReturn ( ) { return 0 ; }
+  void setFifoReturn ( tscType8 value ) { }
+  tscType32 getFifoTransmit ( ) {
+    pthread_mutex_lock (&mutex_) ;
+    tscType32 value = 0 ;
+    if (!transmit_.empty()) { value = transmit_.front() ; transmit_.pop_front() ; }
+    pthread_mutex_unlock (&mutex_) ;
+    return value ;
+  }
+  void setFifoTransmit ( tscType32 value ) {
+    pthread_mutex_lock (&mutex_) ;
+    busAccess (0) ;
+    transmit_.push_back(value) ;
+    pthread_mutex_unlock (&mutex_) ;
+  }
+  void setFifoTransmit ( tscType32 *value, int count ) throw (FecExceptionHandler) {
+    pthread_mutex_lock (&mutex_) ;
+    busAccess (count) ;
+    for (int i = 0 ; i < count ; i ++) transmit_.push_back(value[i]) ;
+    pthread_mutex_unlock (&mutex_) ;
+  }
+
+  void fecHardReset ( ) { }
+  void setIRQ ( bool enable, tscType8 level = 1 ) { }
+
+ protected:
+
+  /** Answer to a frame sent on the ring (without its status)
+   * \param frame - frame read from the FIFO transmit
+   * \param first - first frame of the FIFO transmit for this send
+   */
+  virtual void answerFrame ( std::vector<tscType8> &frame, bool first ) = 0 ;
+
+  /** Time of an access to the FEC
+   * \param blockWords - number of words of a block transfer, 0 for a single access
+   */
+  virtual void busAccess ( int blockWords ) { }
+
+  /** Put in the FIFO receive the frames arrived since the last access
+   */
+  virtual void update ( ) { }
+
+  /** Put a frame (8 bits words, with its status) in the FIFO receive (32 bits words)
+   */
+  void pushFrame ( const std::vector<tscType8> &frame ) {
+    for (unsigned int i = 0 ; i < frame.size() ; i += 4) {
+      tscType32 word = 0 ;
+      for (unsigned int j = 0 ; j < 4 ; j ++) word = (word << 8) | (i+j < frame.size() ? frame[i+j] : 0) ;
+      receive_.push_back (word) ;
+      receiveDst_.push_back (frame[0]) ;
+    }
+    pendingIrq_ = true ;
+  }
+
+  /** Mutex of the accesses, for the settings of the derived classes
+   */
+  pthread_mutex_t mutex_ ;
+
+ private:
+
+  tscType32 popReceive ( ) {
+    update() ;
+    tscType32 value = 0 ;
+    if (!receive_.empty()) {
+      value = receive_.front() ; receive_.pop_front() ; receiveDst_.pop_front() ;
+    }
+    return value ;
+  }
+
+  /** Give each frame of the FIFO transmit to answerFrame
+   */
+  void send ( ) {
+    sends_ ++ ;
+    bool first = true ;
+    while (!transmit_.empty()) {
+      std::vector<tscType8> frame ;
+      tscType32 word = transmit_.front() ;
+      unsigned int size = (word >> 8) & 0xFF ;
+      if (size & FEC_LENGTH_2BYTES) size = ((size & 0x7F) << 8) + (word & 0xFF) + 1 ;
+      size += 3 ;
+      while ((frame.size() < size) && !transmit_.empty()) {
+	word = transmit_.front() ; transmit_.pop_front() ;
+	for (int shift = 24 ; shift >= 0 ; shift -= 8) if (frame.size() < size) frame.push_back ((word >> shift) & 0xFF) ;
+      }
+      frames_ ++ ;
+      answerFrame (frame, first) ;
+      first = false ;
+    }
+  }
+
+  tscType16 firmwareVersion_ ;
+  tscType16 cr0_ ;
+  bool pendingIrq_ ;
+  std::deque<tscType32> transmit_, receive_ ;
+  std::deque<tscType8> receiveDst_ ;
+  unsigned long frames_ ;
+  unsigned long sends_ ;
+} ;
+
+#endif
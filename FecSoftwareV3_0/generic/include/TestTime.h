@@ -0,0 +1,46 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Copyright 2002 - 2003, Frederic DROUHIN - Universite de Haute-Alsace, Mulhouse-France
+*/
+#ifndef TESTTIME_H
+#define TESTTIME_H
+
+#include <sys/time.h>
+#include <time.h>
+
+/** Clocks used by the test executables (ThirdParty/DeviceFactoryTemplate and
+ * ThirdParty/APIConsoleDebugger) to measure the time spent in the code tested
+ */
+
+/** Time of the day in microseconds
+ */
+inline unsigned long getMicroSeconds ( ) {
+  struct timeval tv ;
+  gettimeofday (&tv, NULL) ;
+  return tv.tv_sec * 1000000UL + tv.tv_usec ;
+}
+
+/** Monotonic time in ns, for the short measurements
+ */
+inline unsigned long long getNanoSeconds ( ) {
+  struct timespec t ;
+  clock_gettime (CLOCK_MONOTONIC, &t) ;
+  return (unsigned long long)t.tv_sec * 1000000000ULL + t.tv_nsec ;
+}
+
+#endif
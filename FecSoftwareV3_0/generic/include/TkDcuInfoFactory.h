@@ -38,6 +38,7 @@
 #endif
 
 #include "DeviceFactoryInterface.h"
+#include "DbStorage.h"
 
 /** This class manage all the DCU conversion factors
  * This class provide a support for database (must be compiled with DATABASE flag) or files
@@ -102,6 +103,20 @@ class TkDcuInfoFactory: public DeviceFactoryInterface {
    */
   tkVersionVector maskVersions_ ;
 
+  /** Storage of the configuration without Oracle, not deleted by the factory
+   */
+  DbStorage *dbStorage_ ;
+
+  /** \brief retreive the DCU infos of a version of a partition from the storage
+   */
+  void getStorageDcuInfos ( std::string partitionName, unsigned int majorVersionId, unsigned int minorVersionId, bool cleanCache, bool forceDbReload )
+    throw (FecExceptionHandler ) ;
+
+  /** \brief upload the DCU infos in a new version of a partition in the storage
+   */
+  void setStorageDcuInfos ( tkDcuInfoVector vInfo, std::string partitionName, unsigned int *versionMajor, unsigned int *versionMinor, bool majorVersion )
+    throw (FecExceptionHandler ) ;
+
  public:
 
   /** \brief Build a FEC factory and if database is set create a database access
@@ -136,6 +151,24 @@ class TkDcuInfoFactory: public DeviceFactoryInterface {
     return vDcuInfo_ ;
   }
 
+  // ------------------------------------------------------------------------------------------------------
+  // 
+  // Storage methods
+  //
+  // ------------------------------------------------------------------------------------------------------
+
+  /** \brief Download and upload the DCU infos of the partitions through a storage of the configuration (NULL to stop)
+   */
+  void setStorageAccess ( DbStorage *dbStorage ) ;
+
+  /** \brief return the storage of the configuration
+   */
+  inline DbStorage *getStorageAccess ( ) { return dbStorage_ ; }
+
+  /** \brief return true if the DCU infos of the partitions are downloaded and uploaded through the storage
+   */
+  inline bool getStorageUsed ( ) { return (dbStorage_ != NULL) ; }
+
   // ------------------------------------------------------------------------------------------------------
   // 
   // XML file methods
@@ -177,14 +210,6 @@ class TkDcuInfoFactory: public DeviceFactoryInterface {
   void getPartitionVersion ( std::string partitionName, unsigned int *major, unsigned int *minor, unsigned int *partitionNumber ) 
     throw (oracle::occi::SQLException, FecExceptionHandler ) ;
 
-  /** \brief Add the DCU infos for the given partition (the data are extracted from the database)
-   */
-  void addDetIdPartition ( std::string partitionName, unsigned int majorVersionId = 0, unsigned int minorVersionId = 0, bool cleanCache = true, bool forceDbReload = false ) throw (FecExceptionHandler);
-
-  /** \brief Add all the DCU infos that are in the database for the given version
-   */
-  void addAllDetId (unsigned int majorVersionId = 0, unsigned int minorVersionId = 0, bool cleanCache = true, bool forceDbReload = false) throw (FecExceptionHandler);
-
   /** \brief Update the channel delays (coarse and fine) according to the fibre length between detector and FED
    */
   void updateChannelDelays ( std::string partitionName ) throw (oracle::occi::SQLException, FecExceptionHandler);
@@ -356,6 +381,14 @@ class TkDcuInfoFactory: public DeviceFactoryInterface {
   //
   // ------------------------------------------------------------------------------------------------------
 
+  /** \brief Add the DCU infos for the given partition (the data are extracted from the database or the storage)
+   */
+  void addDetIdPartition ( std::string partitionName, unsigned int majorVersionId = 0, unsigned int minorVersionId = 0, bool cleanCache = true, bool forceDbReload = false ) throw (FecExceptionHandler);
+
+  /** \brief Add all the DCU infos that are in the database or the storage for the given version
+   */
+  void addAllDetId (unsigned int majorVersionId = 0, unsigned int minorVersionId = 0, bool cleanCache = true, bool forceDbReload = false) throw (FecExceptionHandler);
+
   /** \brief Retreive the descriptions for the given devices from the input
    */
   TkDcuInfo *getTkDcuInfo ( unsigned long dcuHardId ) throw ( FecExceptionHandler ) ;
@@ -365,6 +398,11 @@ class TkDcuInfoFactory: public DeviceFactoryInterface {
   void setTkDcuInfo ( tkDcuInfoVector vInfo ) 
     throw ( FecExceptionHandler ) ;
 
+  /** \brief Upload the description in a new version of a partition in the storage
+   */
+  void setTkDcuInfo ( tkDcuInfoVector vInfo, std::string partitionName, unsigned int *versionMajor, unsigned int *versionMinor, bool majorVersion = true ) 
+    throw ( FecExceptionHandler ) ;
+
   /** \brief upload an hash_map in the output
    */
   void setTkDcuInfo ( Sgi::hash_map<unsigned long, TkDcuInfo *> vInfo ) 
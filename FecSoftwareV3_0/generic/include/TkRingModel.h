@@ -0,0 +1,174 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Copyright 2002 - 2003, Frederic DROUHIN - Universite de Haute-Alsace, Mulhouse-France
+*/
+#ifndef TKRINGMODEL_H
+#define TKRINGMODEL_H
+
+#include <list>
+#include <vector>
+
+#include "keyType.h"
+#include "FecExceptionHandler.h"
+#include "TkRingDescription.h"
+#include "TkRingRedundancyPlanner.h"
+
+/**
+ * \class TkRingModel
+ * In-memory model of a ring of CCUs with its A and B links, used to test the redundancy without hardware.
+ * The wiring is the one used by TkRingDescription::computeRedundancy:
+ * <ul>
+ * <li> FEC output A -> first CCU input A, FEC output B -> input B of the first and second CCUs
+ * <li> CCU output A -> next CCU input A, last CCU output A -> FEC input A
+ * <li> CCU output B -> input B of the CCU after the next one
+ * <li> before last CCU output B -> dummy CCU input B, last CCU output B -> dummy CCU input A (swapped for the TIB inverted dummy)
+ * <li> dummy CCU output -> FEC input B
+ * </ul>
+ * CCUs can be declared dead and links can be broken. The token follows the ports set by the last reconfiguration:
+ * the ring is closed when it comes back to the FEC on the input selected.
+ * \brief Scripted model of a ring for the redundancy tests
+ * \warning the CCUs are all reprogrammed at each reconfiguration, even if the ring is open in front of them
+ */
+class TkRingModel: public TkRingAccess {
+
+ public:
+
+  /** \brief Create the model from the CCUs of a ring, all CCUs alive and all links correct
+   * \param tkRing - ring description with the CCUs in the ring order
+   */
+  TkRingModel ( TkRingDescription &tkRing ) ;
+
+  /** \brief Declare a CCU dead: it does not receive nor forward the token
+   * \exception FecExceptionHandler if the CCU is not in the ring
+   */
+  void setCcuDead ( keyType ccuKey, bool dead = true ) throw (FecExceptionHandler) ;
+
+  /** \brief Break the link going into one input of a CCU
+   * \param ccuKey - CCU
+   * \param inputA - input A or B of the CCU
+   * \param broken - broken or repaired
+   * \exception FecExceptionHandler if the CCU is not in the ring
+   */
+  void setInputLinkBroken ( keyType ccuKey, bool inputA, bool broken = true ) throw (FecExceptionHandler) ;
+
+  /** \brief Break the link going into one input of the FEC
+   */
+  void setFecInputLinkBroken ( bool inputA, bool broken = true ) ;
+
+  /** \brief The next reconfigurations fail whatever the configuration (unstable ring)
+   */
+  void setTransientFailures ( unsigned int number ) ;
+
+  /** \brief All the CCUs alive and all the links correct
+   */
+  void clearFaults ( ) ;
+
+  /** \brief Return the number of reconfigurations done
+   */
+  unsigned int getNumberOfReconfigurations ( ) { return reconfigurations_ ; }
+
+  /** \brief Return the FEC status register 0 of the last reconfiguration
+   */
+  tscType16 getFecRingSR0 ( ) { return fecSR0_ ; }
+
+  /** \brief Apply the ports computed by TkRingDescription::computeRedundancy and follow the token
+   * \return the FEC status register 0
+   * \exception FecExceptionHandler if the ring given is not reconfigurable
+   */
+  tscType16 fecRingReconfigure ( TkRingDescription &tkRing ) throw (FecExceptionHandler) ;
+
+  /** \brief Return the CCUs on the path of the token if the ring is closed
+   */
+  std::list<keyType> *getCcuList ( ) throw (FecExceptionHandler) ;
+
+ private:
+
+  /** Find the index of a CCU (the dummy is the last one)
+   */
+  unsigned int findCcu ( keyType ccuKey ) throw (FecExceptionHandler) ;
+
+  /** Follow the token from the FEC, return true if it comes back
+   */
+  bool followToken ( ) ;
+
+  /** Node index of the FEC in the path
+   */
+  static const int FECNODE = -1 ;
+
+  /** Node index when the token is not received
+   */
+  static const int NONODE = -2 ;
+
+  /** Key of the ring
+   */
+  keyType ringKey_ ;
+
+  /** Keys of the CCUs in the ring order, the dummy is the last one
+   */
+  std::vector<keyType> ccuKeys_ ;
+
+  /** Number of CCUs without the dummy
+   */
+  unsigned int nNormalCcus_ ;
+
+  /** The ring has a dummy CCU
+   */
+  bool dummy_ ;
+
+  /** The dummy CCU inputs are swapped
+   */
+  bool dummyInverted_ ;
+
+  /** For each CCU, alive or not
+   */
+  std::vector<bool> alive_ ;
+
+  /** For each CCU, input B and output B selected
+   */
+  std::vector<bool> inputB_, outputB_ ;
+
+  /** For each CCU, link into the input A and B broken
+   */
+  std::vector<bool> inputABroken_, inputBBroken_ ;
+
+  /** FEC ports selected
+   */
+  bool fecOutputA_, fecInputA_ ;
+
+  /** FEC input links broken
+   */
+  bool fecInputABroken_, fecInputBBroken_ ;
+
+  /** Number of failures to be simulated
+   */
+  unsigned int transientFailures_ ;
+
+  /** Number of reconfigurations
+   */
+  unsigned int reconfigurations_ ;
+
+  /** FEC SR0 after the last reconfiguration
+   */
+  tscType16 fecSR0_ ;
+
+  /** CCUs on the path of the token
+   */
+  std::list<keyType> path_ ;
+} ;
+
+#endif
@@ -0,0 +1,288 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Copyright 2002 - 2003, Frederic DROUHIN - Universite de Haute-Alsace, Mulhouse-France
+*/
+#ifndef TKRINGREDUNDANCYPLANNER_H
+#define TKRINGREDUNDANCYPLANNER_H
+
+#include <iostream>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "keyType.h"
+#include "FecExceptionHandler.h"
+#include "TkRingDescription.h"
+
+/**
+ * \class TkRingAccess
+ * Minimal access to a ring needed to apply and verify a redundancy configuration.
+ * It is implemented on top of FecAccess for the hardware (see FecDetectionUpload)
+ * and by TkRingModel for the tests without hardware.
+ */
+class TkRingAccess {
+
+ public:
+
+  /** Nothing to do
+   */
+  virtual ~TkRingAccess ( ) { }
+
+  /** \brief Apply the redundancy configuration given by the ring description
+   * \param tkRing - ring with the CCUs enabled/disabled and the input/output of the FEC
+   * \return the FEC status register 0 after the reconfiguration
+   * \exception FecExceptionHandler
+   */
+  virtual tscType16 fecRingReconfigure ( TkRingDescription &tkRing ) throw (FecExceptionHandler) = 0 ;
+
+  /** \brief Scan the ring for the CCUs
+   * \return list of CCU keys found, an empty list if no CCU answers. The list must be deleted by the caller.
+   * \exception FecExceptionHandler
+   */
+  virtual std::list<keyType> *getCcuList ( ) throw (FecExceptionHandler) = 0 ;
+} ;
+
+/**
+ * \class TkRingRedundancyPlanner
+ * Find the redundancy configurations that can recover a broken ring.
+ * The planner takes the CCU order from a TkRingDescription and the symptoms observed on the ring
+ * (FEC SR0, list of CCUs answering a scan, CCU status registers A and C). It enumerates all the
+ * CCU bypass patterns and FEC input/output combinations accepted by TkRingDescription::isReconfigurable,
+ * ranks them by the number of CCUs kept in the ring then by the suspicion on the CCUs bypassed,
+ * and applies them in turn until one of them closes the ring and all the CCUs kept answer a scan.
+ * \brief Automatic ring fault isolation and redundancy
+ * \warning the dummy CCU is not counted in the number of CCUs kept, it is only used on the ring B
+ */
+class TkRingRedundancyPlanner {
+
+ public:
+
+  /** One redundancy configuration of the ring
+   */
+  struct Configuration {
+
+    /** One flag per CCU (dummy CCU excluded) in the ring order, true if the CCU is bypassed
+     */
+    std::vector<bool> bypassed_ ;
+
+    /** FEC output A connected to the first CCU (or output B)
+     */
+    bool inputAUsed_ ;
+
+    /** Last CCU connected to FEC input A (or dummy CCU to input B)
+     */
+    bool outputAUsed_ ;
+
+    /** Number of CCUs kept in the ring
+     */
+    unsigned int ccusKept_ ;
+
+    /** Sum of the suspicion on the CCUs bypassed
+     */
+    unsigned int suspicion_ ;
+
+    /** Number of B ports used by the FEC
+     */
+    unsigned int portsB_ ;
+  } ;
+
+  /** Result of one application of a configuration on the ring
+   */
+  struct Attempt {
+
+    /** Index of the configuration in the plan
+     */
+    unsigned int configuration_ ;
+
+    /** FEC status register 0 after the reconfiguration
+     */
+    tscType16 fecSR0_ ;
+
+    /** Number of CCUs answering the scan after the reconfiguration
+     */
+    unsigned int ccusFound_ ;
+
+    /** True if the ring is closed and all the CCUs kept are found
+     */
+    bool verified_ ;
+
+    /** Error during the reconfiguration or the scan if any
+     */
+    std::string error_ ;
+  } ;
+
+  /** \brief Create a planner without symptoms, 1 try for each configuration
+   */
+  TkRingRedundancyPlanner ( ) ;
+
+  /** \brief Clear the symptoms, the plan and the attempts
+   */
+  void reset ( ) ;
+
+  // ***********************************************************************************************
+  // Symptoms
+  // ***********************************************************************************************
+
+  /** \brief Set the FEC status register 0 read on the broken ring
+   */
+  void setFecSR0 ( tscType16 fecSR0 ) ;
+
+  /** \brief Set the CCUs found by a scan of the ring (FecAccess::getCcuList)
+   */
+  void setCcuList ( const std::list<keyType> &ccuList ) ;
+
+  /** \brief Set the status registers of a CCU that answered
+   * \param ccuKey - CCU key
+   * \param sra - CCU status register A, the error bits make the CCU suspect
+   * \param src - CCU status register C, a CCU not using the ports of the current configuration is suspect
+   */
+  void setCcuStatus ( keyType ccuKey, tscType8 sra, tscType8 src ) ;
+
+  // ***********************************************************************************************
+  // Plan
+  // ***********************************************************************************************
+
+  /** \brief Number of times each configuration is applied before trying the next one (at least 1)
+   */
+  void setTries ( unsigned int tries ) ;
+
+  /** \brief Maximum number of configurations tried by apply, 0 for all of them
+   */
+  void setMaximumConfigurations ( unsigned int maximum ) ;
+
+  /** \brief Check the symptoms against the ring
+   * \return true if the SR0 is not correct or if one of the enabled CCUs is missing in the scan
+   */
+  bool isRecoveryNeeded ( TkRingDescription &tkRing ) ;
+
+  /** \brief Enumerate and rank the configurations of the ring
+   * \param tkRing - ring with the CCUs in the ring order, its current configuration is not part of the plan
+   * \return the configurations, best first
+   * \exception FecExceptionHandler if the ring has not enough CCUs to be reconfigured
+   */
+  const std::vector<Configuration> &plan ( TkRingDescription &tkRing ) throw (FecExceptionHandler) ;
+
+  /** \brief Apply the configurations of the plan until the ring is recovered
+   * \param access - access to the ring
+   * \param tkRing - ring description, set to the configuration that worked or left unchanged if none worked
+   * \return true if the ring is recovered (or if it did not need a recovery)
+   * \exception FecExceptionHandler if the ring has not enough CCUs to be reconfigured
+   */
+  bool apply ( TkRingAccess &access, TkRingDescription &tkRing ) throw (FecExceptionHandler) ;
+
+  /** \brief Return the configurations of the last plan
+   */
+  const std::vector<Configuration> &getConfigurations ( ) { return configurations_ ; }
+
+  /** \brief Return the attempts done by the last apply
+   */
+  const std::vector<Attempt> &getAttempts ( ) { return attempts_ ; }
+
+  /** \brief Return the suspicion on a CCU computed from the symptoms by the last plan
+   */
+  unsigned int getSuspicion ( keyType ccuKey ) ;
+
+  /** \brief Display the plan and the attempts into a stream
+   */
+  void display ( std::ostream &flux, TkRingDescription &tkRing ) ;
+
+  // ***********************************************************************************************
+  // Static method
+  // ***********************************************************************************************
+
+  /** \brief Set the ring description to a configuration (enabled CCUs and FEC input/output)
+   */
+  static void setConfiguration ( TkRingDescription &tkRing, const Configuration &configuration ) ;
+
+  /** \brief Get the configuration currently set in a ring description
+   */
+  static Configuration getConfiguration ( TkRingDescription &tkRing ) ;
+
+  /** \brief Check that the CCUs kept by the ring, and only them, are in the list
+   */
+  static bool isCcuListCorrect ( TkRingDescription &tkRing, const std::list<keyType> &ccuList ) ;
+
+  /** \brief Display a configuration in the same format as TkRingDescription::display
+   */
+  static void display ( std::ostream &flux, TkRingDescription &tkRing, const Configuration &configuration ) ;
+
+ private:
+
+  /** Enumerate recursively the bypass patterns with no two consecutive CCUs bypassed
+   */
+  void enumerate ( TkRingDescription &tkRing, Configuration &configuration, unsigned int position, const Configuration &current ) ;
+
+  /** Compute the suspicion for each CCU of the ring from the symptoms
+   */
+  void computeSuspicion ( TkRingDescription &tkRing ) ;
+
+  /** Sort the configuration, best first
+   */
+  static bool isBetter ( const Configuration &c1, const Configuration &c2 ) ;
+
+  /** Return the number of CCUs of the ring without the dummy CCU
+   */
+  static unsigned int getNumberOfNormalCcus ( TkRingDescription &tkRing ) ;
+
+  /** FEC SR0 observed
+   */
+  tscType16 fecSR0_ ;
+
+  /** True if the FEC SR0 was given
+   */
+  bool fecSR0Set_ ;
+
+  /** CCUs found by the scan
+   */
+  std::list<keyType> ccuList_ ;
+
+  /** True if the list of CCUs was given
+   */
+  bool ccuListSet_ ;
+
+  /** CCU status register A and C for each CCU key (SRA in the low byte, SRC in the high byte)
+   */
+  std::map<keyType, tscType16> ccuStatus_ ;
+
+  /** CCU addresses in the ring order (dummy CCU excluded)
+   */
+  std::vector<keyType> ccuOrder_ ;
+
+  /** Suspicion for each CCU in the ring order
+   */
+  std::vector<unsigned int> suspicion_ ;
+
+  /** Number of tries for each configuration
+   */
+  unsigned int tries_ ;
+
+  /** Maximum number of configurations applied
+   */
+  unsigned int maximumConfigurations_ ;
+
+  /** Configurations ranked
+   */
+  std::vector<Configuration> configurations_ ;
+
+  /** Attempts of the last apply
+   */
+  std::vector<Attempt> attempts_ ;
+} ;
+
+#endif
@@ -0,0 +1,241 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+#ifndef TKTOPOLOGYINDEX_H
+#define TKTOPOLOGYINDEX_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "hashMapDefinition.h"
+#include "keyType.h"
+#include "deviceType.h"
+
+/** Identifier not found or not set
+ */
+#define TKTOPOLOGY_INVALID 0xFFFFFFFF
+
+/** Versions of the sources used to build the index
+ */
+typedef struct {
+
+  /** Partition name
+   */
+  std::string partitionName ;
+
+  /** Versions of the connections, of the DCU infos, of the DCU-PSU map and of the FEC devices
+   */
+  unsigned int connectionMajor, connectionMinor ;
+  unsigned int dcuInfoMajor, dcuInfoMinor ;
+  unsigned int dcuPsuMapMajor, dcuPsuMapMinor ;
+  unsigned int fecMajor, fecMinor ;
+
+} TkTopologyVersion ;
+
+/** Module (or CCU) identified by its DCU
+ */
+typedef struct {
+
+  /** DCU hardware id and det id (0 if no DCU info)
+   */
+  tscType32 dcuHardId, detId ;
+
+  /** FEC crate and FEC, ring, CCU, channel (TKTOPOLOGY_INVALID if not known)
+   */
+  unsigned int fecCrateId ;
+  keyType fecKey ;
+
+  /** PSU identifier in the index (TKTOPOLOGY_INVALID if not known)
+   */
+  unsigned int psuId ;
+
+  /** Number of APVs and fibre length from the DCU info
+   */
+  unsigned int apvNumber ;
+  double fibreLength ;
+
+  /** FED channels of the module: position in the FED channels of the index and number
+   */
+  unsigned int firstFedChannel, fedChannelNumber ;
+
+} TkTopologyModule ;
+
+/** FED channel connected to a module
+ */
+typedef struct {
+
+  /** FED id and channel
+   */
+  unsigned int fedId, fedChannel ;
+
+  /** APV address of the first APV of the pair
+   */
+  unsigned int apvAddress ;
+
+  /** Module identifier in the index
+   */
+  unsigned int moduleId ;
+
+} TkTopologyFedChannel ;
+
+/** Power supply channel (PSUDCUTYPE_PG) or group (PSUDCUTYPE_CG)
+ */
+typedef struct {
+
+  /** Complete PSU name and type
+   */
+  std::string psuName, psuType ;
+
+  /** Modules of the PSU: position in the PSU modules of the index and number
+   */
+  unsigned int firstModule, moduleNumber ;
+
+} TkTopologyPsu ;
+
+/**
+ * \class TkTopologyIndex
+ * Index of the tracker topology built once from the connections (ConnectionFactory), the DCU infos
+ * (TkDcuInfoFactory), the DCU-PSU map (TkDcuPsuMapFactory) and the DCU descriptions (FecDeviceFactory).
+ * The modules, FED channels and PSUs get dense identifiers valid for this index only and each
+ * identifier (DCU hardware id, det id, FEC crate and key, FED id and channel) is found in a hash table:
+ * <pre>
+ * TkTopologyIndex topology (connections, dcuInfos, dcuPsuMaps, dcuDevices, version) ;
+ * unsigned int moduleId = topology.findModuleByDetId (detId) ;
+ * if (moduleId != TKTOPOLOGY_INVALID) std::cout << topology.getModule(moduleId).dcuHardId << std::endl ;
+ * </pre>
+ * The index is never changed once built: a new version of the sources gives a new index.
+ * The inconsistencies between the sources are reported by getViolations, the first source wins.
+ * \brief Cross-factory index DCU / PSU / FEC key / FED channel / det id
+ * \warning the PSU names are found through a std::map, the other lookups are hash tables
+ */
+class TkTopologyIndex {
+
+ public:
+
+  /** \brief Build the index
+   */
+  TkTopologyIndex ( ConnectionVector &connections, tkDcuInfoVector &dcuInfos, tkDcuPsuMapVector &dcuPsuMaps,
+		    deviceVector &dcuDevices, const TkTopologyVersion &version ) ;
+
+  /** \brief Build the index with the DCU infos of TkDcuInfoFactory::getInfos
+   */
+  TkTopologyIndex ( ConnectionVector &connections, Sgi::hash_map<unsigned long, TkDcuInfo *> &dcuInfos, tkDcuPsuMapVector &dcuPsuMaps,
+		    deviceVector &dcuDevices, const TkTopologyVersion &version ) ;
+
+  /** \brief Versions of the sources
+   */
+  const TkTopologyVersion &getVersion ( ) const { return version_ ; }
+
+  /** \brief Inconsistencies found during the build
+   */
+  const std::vector<std::string> &getViolations ( ) const { return violations_ ; }
+
+  /** \brief Number of modules, FED channels, PSUs
+   */
+  unsigned int getNumberOfModules ( ) const { return modules_.size() ; }
+  unsigned int getNumberOfFedChannels ( ) const { return fedChannels_.size() ; }
+  unsigned int getNumberOfPsus ( ) const { return psus_.size() ; }
+
+  /** \brief Module, FED channel, PSU from its identifier
+   */
+  const TkTopologyModule &getModule ( unsigned int moduleId ) const { return modules_[moduleId] ; }
+  const TkTopologyFedChannel &getFedChannel ( unsigned int fedChannelId ) const { return fedChannels_[fedChannelId] ; }
+  const TkTopologyPsu &getPsu ( unsigned int psuId ) const { return psus_[psuId] ; }
+
+  /** \brief FED channel of a module
+   * \param moduleId - module
+   * \param number - from 0 to TkTopologyModule::fedChannelNumber - 1
+   */
+  const TkTopologyFedChannel &getFedChannel ( unsigned int moduleId, unsigned int number ) const {
+    return fedChannels_[modules_[moduleId].firstFedChannel + number] ;
+  }
+
+  /** \brief Module of a PSU
+   * \param psuId - PSU
+   * \param number - from 0 to TkTopologyPsu::moduleNumber - 1
+   */
+  unsigned int getPsuModule ( unsigned int psuId, unsigned int number ) const {
+    return psuModules_[psus_[psuId].firstModule + number] ;
+  }
+
+  /** \brief Module from one of its identifiers, TKTOPOLOGY_INVALID if not found
+   */
+  unsigned int findModuleByDcuHardId ( tscType32 dcuHardId ) const ;
+  unsigned int findModuleByDetId ( tscType32 detId ) const ;
+  unsigned int findModuleByFecKey ( unsigned int fecCrateId, keyType fecKey ) const ;
+  unsigned int findModuleByFedChannel ( unsigned int fedId, unsigned int fedChannel ) const ;
+
+  /** \brief FED channel, TKTOPOLOGY_INVALID if not connected
+   */
+  unsigned int findFedChannel ( unsigned int fedId, unsigned int fedChannel ) const ;
+
+  /** \brief PSU from its complete name, TKTOPOLOGY_INVALID if not found
+   */
+  unsigned int findPsu ( std::string psuName ) const ;
+
+ private:
+
+  /** Key of the FEC crate and FEC, ring, CCU, channel
+   */
+  typedef unsigned long long crateKeyType ;
+
+  struct hashCrateKey {
+    size_t operator() ( crateKeyType key ) const { return (size_t)(key ^ (key >> 32)) ; }
+  } ;
+
+  /** \brief Build the index from all the sources
+   */
+  void build ( ConnectionVector &connections, tkDcuInfoVector &dcuInfos, tkDcuPsuMapVector &dcuPsuMaps, deviceVector &dcuDevices ) ;
+
+  /** \brief Module of a DCU, created if it does not exist
+   */
+  unsigned int getModuleId ( tscType32 dcuHardId ) ;
+
+  /** \brief Set the FEC crate and key of a module, violation if the module or the key have already another one
+   */
+  void setFecKey ( unsigned int moduleId, unsigned int fecCrateId, keyType fecKey, const char *source ) ;
+
+  /** \brief Add a violation
+   */
+  void addViolation ( std::string violation ) ;
+
+  /** Versions
+   */
+  TkTopologyVersion version_ ;
+
+  /** Modules, FED channels, PSUs and modules of each PSU
+   */
+  std::vector<TkTopologyModule> modules_ ;
+  std::vector<TkTopologyFedChannel> fedChannels_ ;
+  std::vector<TkTopologyPsu> psus_ ;
+  std::vector<unsigned int> psuModules_ ;
+
+  /** Lookup tables
+   */
+  Sgi::hash_map<unsigned long, unsigned int> dcuHardIdIndex_ ;
+  Sgi::hash_map<unsigned long, unsigned int> detIdIndex_ ;
+  Sgi::hash_map<crateKeyType, unsigned int, hashCrateKey> fecKeyIndex_ ;
+  Sgi::hash_map<unsigned long, unsigned int> fedChannelIndex_ ;
+  std::map<std::string, unsigned int> psuIndex_ ;
+
+  /** Inconsistencies
+   */
+  std::vector<std::string> violations_ ;
+} ;
+
+#endif
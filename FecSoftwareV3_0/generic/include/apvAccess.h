@@ -21,6 +21,7 @@
 #define APVACCESS_H
 
 #include "deviceType.h"
+#include "KeyTypeTable.h"
 #include "deviceFrame.h"
 
 #include "FecAccess.h"
@@ -234,7 +235,7 @@ class apvAccess: public deviceAccess {
   
   /** \brief static method to upload from the hardware the devices
    */
-  static unsigned int getApvValuesMultipleFrames ( FecAccess &fecAccess, Sgi::hash_map<keyType, apvAccess *> &apvSet, deviceVector &apvVector,
+  static unsigned int getApvValuesMultipleFrames ( FecAccess &fecAccess, KeyTypeTable<apvAccess *> &apvSet, deviceVector &apvVector,
 						   std::list<FecExceptionHandler *> &errorList ) 
     throw (FecExceptionHandler) ;
 
@@ -21,6 +21,7 @@
 #define DCUACCESS_H
 
 #include "keyType.h"
+#include "KeyTypeTable.h"
 
 #include "FecExceptionHandler.h"
 
@@ -172,7 +173,7 @@ class dcuAccess: public deviceAccess {
 
   /** \brief readout a set of DCU
    */
-  static unsigned int getDcuValuesMultipleFrames ( FecAccess &fecAccess, Sgi::hash_map<keyType, dcuAccess *> &dcuSet, deviceVector &dcuVector,
+  static unsigned int getDcuValuesMultipleFrames ( FecAccess &fecAccess, KeyTypeTable<dcuAccess *> &dcuSet, deviceVector &dcuVector,
 						   std::list<FecExceptionHandler *> &errorList, bool ducHardIdOnly = false ) 
     throw (FecExceptionHandler) ;
 
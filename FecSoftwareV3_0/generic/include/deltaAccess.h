@@ -11,6 +11,7 @@ Copyright 2004, Wojciech BIALAS , CERN , Geneva , Switzerland
 #define DELTAACCESS_H
 
 #include "deviceType.h"
+#include "KeyTypeTable.h"
 #include "deviceFrame.h"
 
 #include "FecAccess.h"
@@ -215,7 +216,7 @@ class deltaAccess : public deviceAccess {
 
   /** \brief static method to retreive the data from a set of delta
    */
-  static unsigned int getDeltaValuesMultipleFrames ( FecAccess &fecAccess, Sgi::hash_map<keyType, deltaAccess *> &deltaSet, deviceVector &deltaVector,
+  static unsigned int getDeltaValuesMultipleFrames ( FecAccess &fecAccess, KeyTypeTable<deltaAccess *> &deltaSet, deviceVector &deltaVector,
 								  std::list<FecExceptionHandler *> &errorList ) 
     throw (FecExceptionHandler) ;
   
@@ -24,6 +24,7 @@ Copyright 2002 - 2003, Frederic DROUHIN - Universite de Haute-Alsace, Mulhouse-F
 
 #include "keyType.h"
 #include "FecExceptionHandler.h"
+#include "FecErrorRecorder.h"
 
 #include "hashMapDefinition.h"
 
@@ -62,6 +63,26 @@ typedef std::list<accessDeviceType> accessDeviceTypeList ;
 typedef Sgi::hash_map<keyType, std::list<accessDeviceType> > accessDeviceTypeListMap ;
 typedef Sgi::hash_map<unsigned short, accessDeviceType *> accessTransactionFrameMap ;
 
+// For pipelined memory channel transfers (scatter/gather), one element per segment of memory:
+//      - index: memory channel
+//      - accessType: read or write
+//      - AH, AL: position of the segment in the memory
+//      - size: number of bytes of the segment
+//      - values: input if it is a write command, output if it is a read command (size bytes)
+//      - e: FecExceptionHandler, output, NULL if ok, != NULL if it is not ok
+typedef struct {
+  keyType             index      ;  // Index of the memory channel
+  enumAccessModeType  accessType ;  // MODE_READ, MODE_WRITE
+  tscType8            AH         ;  // Position in the high memory
+  tscType8            AL         ;  // Position in the low memory
+  unsigned long       size       ;  // Number of bytes
+  tscType8           *values     ;  // Bytes to be written or read
+  FecExceptionHandler *e         ;  // In case of error
+
+} memoryAccessType ;
+
+typedef std::list<memoryAccessType> memoryAccessTypeList ;
+
 #include <iostream>
 #include <sstream>
 
@@ -153,6 +174,26 @@ class DeviceFrame {
     return (error) ;
   }
 
+  /** \brief Collect the errors of the multiple frame methods in a recorder
+   * The errors already recorded (FecErrorRecorder::getRecordedError) are only counted, the other exceptions are given to the recorder.
+   * \param vAccesses - list of accessDeviceType that contains the errors (cf deviceFrame.h data structure).
+   * \param errorRecorder - recorder of the errors
+   * \return number of errors
+   * \warning the field e of the accesses is set to NULL
+   */
+  static unsigned int decodeErrorFrame ( accessDeviceTypeList &vAccesses, FecErrorRecorder &errorRecorder ) {
+
+    unsigned int error = 0 ;
+    for (std::list<accessDeviceType>::iterator itAccessDevice = vAccesses.begin() ; itAccessDevice != vAccesses.end() ; itAccessDevice ++) {
+      if (itAccessDevice->e != NULL) {
+	error ++ ;
+	errorRecorder.addException (itAccessDevice->e) ;
+	itAccessDevice->e = NULL ;
+      }
+    }
+    return (error) ;
+  }
+
   /** Display the values for one access
    */
   static void displayAccessDeviceType ( accessDeviceType deviceAccess ) {
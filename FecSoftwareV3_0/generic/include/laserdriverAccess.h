@@ -21,6 +21,7 @@ Copyright 2002 - 2003, Frederic DROUHIN - Universite de Haute-Alsace, Mulhouse-F
 #define LASERDRIVERACCESS_H
 
 #include "deviceType.h"
+#include "KeyTypeTable.h"
 #include "deviceFrame.h"
 
 #include "FecAccess.h"
@@ -118,7 +119,7 @@ class laserdriverAccess: public deviceAccess {
 
   /** \brief static method to upload from the hardware the devices
    */
-  static unsigned int getLaserdriverValuesMultipleFrames ( FecAccess &fecAccess, Sgi::hash_map<keyType, laserdriverAccess *> &laserdriverSet, deviceVector &laserdriverVector,
+  static unsigned int getLaserdriverValuesMultipleFrames ( FecAccess &fecAccess, KeyTypeTable<laserdriverAccess *> &laserdriverSet, deviceVector &laserdriverVector,
 							   std::list<FecExceptionHandler *> &errorList ) 
     throw (FecExceptionHandler) ;
 };
@@ -77,6 +77,11 @@ class memoryAccess: public ccuChannelAccess {
                tscType8 *values,
                unsigned long size) ;
 
+  /** \brief Read and write segments of the memory with several frames in flight
+   */
+  void setBlockMemory ( std::list<memoryAccessType> &vAccesses,
+                        unsigned int maximumTransactions = MAXMEMORYTRANSACTIONS ) ;
+
   /** \brief Read modify write a value from the memory specified by the key in single byte
    */
   void write ( tscType8 AH, tscType8 AL, 
@@ -22,6 +22,7 @@ Mulhouse-France
 #define MUXACCESS_H
 
 #include "deviceType.h"
+#include "KeyTypeTable.h"
 #include "deviceFrame.h"
 
 #include "FecAccess.h"
@@ -88,7 +89,7 @@ class muxAccess: public deviceAccess {
 
   /** \brief static method to upload from the hardware the devices
    */
-  static unsigned int getMuxValuesMultipleFrames ( FecAccess &fecAccess, Sgi::hash_map<keyType, muxAccess *> &muxSet, deviceVector &muxVector, 
+  static unsigned int getMuxValuesMultipleFrames ( FecAccess &fecAccess, KeyTypeTable<muxAccess *> &muxSet, deviceVector &muxVector, 
 							      std::list<FecExceptionHandler *> &errorList ) 
     throw (FecExceptionHandler) ;
 
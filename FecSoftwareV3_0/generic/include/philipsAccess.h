@@ -22,6 +22,7 @@ Mulhouse-France
 #define PHILIPSACCESS_H
 
 #include "deviceType.h"
+#include "KeyTypeTable.h"
 #include "deviceFrame.h"
 
 #include "FecAccess.h"
@@ -89,7 +90,7 @@ class philipsAccess: public deviceAccess {
 
   /** \brief static method to upload from the hardware the devices
    */
-  static unsigned int getPhilipsValuesMultipleFrames ( FecAccess &fecAccess, Sgi::hash_map<keyType, philipsAccess *> &philipsSet, deviceVector &philipsVector,
+  static unsigned int getPhilipsValuesMultipleFrames ( FecAccess &fecAccess, KeyTypeTable<philipsAccess *> &philipsSet, deviceVector &philipsVector,
 						       std::list<FecExceptionHandler *> &errorList ) 
     throw (FecExceptionHandler) ;
 
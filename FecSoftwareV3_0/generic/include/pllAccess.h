@@ -21,6 +21,7 @@
 #define PLLACCESS_H
 
 #include "deviceType.h"
+#include "KeyTypeTable.h"
 #include "deviceFrame.h"
 
 #include "deviceAccess.h"
@@ -317,13 +318,13 @@ class pllAccess: public deviceAccess {
   /** \brief reset all PLL in parallel
    */
   static unsigned int setPllCheckGoingBitMultipleFrames ( FecAccess &fecAccess, std::list<FecExceptionHandler *> &errorList,
-							  Sgi::hash_map<keyType, pllAccess *> &pllSet, bool *errorGoingBit, 
+							  KeyTypeTable<pllAccess *> &pllSet, bool *errorGoingBit, 
 							  std::list<keyType> &pllErrorBefore, std::list<keyType> &pllErrorAfter, 
 							  bool noCheck = false, bool coldReset = true ) throw (FecExceptionHandler) ;
 
   /** \brief Display the register for a given set of PLL
    */
-  static void displayPllRegisters ( FecAccess &fecAccess, Sgi::hash_map<keyType, pllAccess *> &pllSet ) ;
+  static void displayPllRegisters ( FecAccess &fecAccess, KeyTypeTable<pllAccess *> &pllSet ) ;
 
   /** \brief Display the registers of the PLL
    */
@@ -331,7 +332,7 @@ class pllAccess: public deviceAccess {
 
   /** \brief static method to upload from the hardware the devices
    */
-  static unsigned int getPllValuesMultipleFrames ( FecAccess &fecAccess, Sgi::hash_map<keyType, pllAccess *> &pllSet, deviceVector &pllVector,
+  static unsigned int getPllValuesMultipleFrames ( FecAccess &fecAccess, KeyTypeTable<pllAccess *> &pllSet, deviceVector &pllVector,
 						   std::list<FecExceptionHandler *> &errorList ) 
     throw (FecExceptionHandler) ;
 
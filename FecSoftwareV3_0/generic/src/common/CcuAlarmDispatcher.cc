@@ -0,0 +1,357 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Copyright 2002 - 2003, Frederic DROUHIN - Universite de Haute-Alsace, Mulhouse-France
+*/
+#include <sys/time.h>   // For timestamps
+#include <time.h>       // For nanosleep
+
+#include "cmdDescription.h"
+#include "CcuAlarmDispatcher.h"
+
+// -------------------------------------------------------------------------------------
+//
+//                                     Queue
+//
+// -------------------------------------------------------------------------------------
+
+/**
+ * \param size - maximum number of events, rounded up to a power of 2
+ */
+CcuAlarmQueue::CcuAlarmQueue ( unsigned int size ): head_(0), tail_(0), lost_(0) {
+
+  unsigned int realSize = 1 ;
+  while (realSize < size) realSize <<= 1 ;
+  events_ = new CcuAlarmEvent[realSize] ;
+  mask_ = realSize - 1 ;
+}
+
+/** Delete the events
+ */
+CcuAlarmQueue::~CcuAlarmQueue ( ) {
+
+  delete[] events_ ;
+}
+
+/** Called by the dispatcher thread only
+ * \param event - event to be added
+ * \return false if the queue is full
+ */
+bool CcuAlarmQueue::push ( const CcuAlarmEvent &event ) {
+
+  unsigned int head = head_ ;
+  if (head - tail_ > mask_) {
+    lost_ ++ ;
+    return false ;
+  }
+
+  events_[head & mask_] = event ;
+  // The event must be written before the consumer sees the new position
+  __sync_synchronize() ;
+  head_ = head + 1 ;
+  return true ;
+}
+
+/** Called by the subscriber thread only
+ * \param event - event removed
+ * \return false if the queue is empty
+ */
+bool CcuAlarmQueue::pop ( CcuAlarmEvent &event ) {
+
+  unsigned int tail = tail_ ;
+  if (tail == head_) return false ;
+
+  __sync_synchronize() ;
+  event = events_[tail & mask_] ;
+  // The event must be read before the producer can overwrite it
+  __sync_synchronize() ;
+  tail_ = tail + 1 ;
+  return true ;
+}
+
+// -------------------------------------------------------------------------------------
+//
+//                                   Dispatcher
+//
+// -------------------------------------------------------------------------------------
+
+/** Create a dispatcher without ring and without subscriber
+ */
+CcuAlarmDispatcher::CcuAlarmDispatcher ( ):
+  nSubscribers_(0), running_(false), stopRequested_(false), minimumPeriod_(100), maximumPeriod_(10000), events_(0), errors_(0), unexpectedFrames_(0) {
+
+  pthread_mutex_init (&subscribeMutex_, NULL) ;
+}
+
+/** Stop the thread and delete the queues
+ */
+CcuAlarmDispatcher::~CcuAlarmDispatcher ( ) {
+
+  stop() ;
+
+  for (unsigned int i = 0 ; i < nSubscribers_ ; i ++) delete subscribers_[i].queue ;
+  pthread_mutex_destroy (&subscribeMutex_) ;
+}
+
+/**
+ * \param fecRingDevice - ring to be polled
+ * \exception FecExceptionHandler
+ * <ul>
+ * <li>TSCFEC_INVALIDOPERATION: the dispatcher is running or the ring is on another FEC
+ * </ul>
+ */
+void CcuAlarmDispatcher::addRing ( FecRingDevice *fecRingDevice ) throw (FecExceptionHandler) {
+
+  keyType index = buildFecRingKey(fecRingDevice->getFecSlot(), fecRingDevice->getRingSlot()) ;
+
+  if (running_) {
+    RAISEFECEXCEPTIONHANDLER_HARDPOSITION ( TSCFEC_INVALIDOPERATION,
+					    "Cannot add a ring to a CCU alarm dispatcher running",
+					    ERRORCODE,
+					    index ) ;
+  }
+
+  if (rings_.size() && (rings_[0]->getFecSlot() != fecRingDevice->getFecSlot())) {
+    RAISEFECEXCEPTIONHANDLER_HARDPOSITION ( TSCFEC_INVALIDOPERATION,
+					    "A CCU alarm dispatcher handles the rings of one FEC",
+					    ERRORCODE,
+					    index ) ;
+  }
+
+  rings_.push_back (fecRingDevice) ;
+}
+
+/**
+ * \param minimum - polling period in microseconds after a frame
+ * \param maximum - polling period in microseconds when no frame arrives
+ */
+void CcuAlarmDispatcher::setPollingPeriod ( unsigned long minimum, unsigned long maximum ) {
+
+  minimumPeriod_ = minimum ? minimum : 1 ;
+  maximumPeriod_ = maximum < minimumPeriod_ ? minimumPeriod_ : maximum ;
+}
+
+/**
+ * \param index - FEC/ring/CCU and channel 0 for the CCU alarm inputs or a PIA channel (0x30 to 0x33)
+ * \exception FecExceptionHandler
+ * <ul>
+ * <li>TSCFEC_FECPARAMETERNOTMANAGED: the ring is not handled by the dispatcher
+ * </ul>
+ */
+void CcuAlarmDispatcher::enableSource ( keyType index ) throw (FecExceptionHandler) {
+
+  for (std::vector<FecRingDevice *>::iterator it = rings_.begin() ; it != rings_.end() ; it ++) {
+    if (((*it)->getFecSlot() == getFecKey(index)) && ((*it)->getRingSlot() == getRingKey(index))) {
+
+      if (isPiaChannelCcu25(index)) (*it)->setPiaInterruptEnable (index) ;
+      else (*it)->setCcuAlarmsEnable (index, true, true, true, true) ;
+      return ;
+    }
+  }
+
+  RAISEFECEXCEPTIONHANDLER_HARDPOSITION ( TSCFEC_FECPARAMETERNOTMANAGED,
+					  "The ring is not handled by the CCU alarm dispatcher",
+					  ERRORCODE,
+					  index ) ;
+}
+
+/**
+ * \param index - source index
+ * \param mask - part of the index used for the filtering (CCUALARMFILTER...)
+ * \param types - types of the events delivered (enumCcuAlarmType combined)
+ * \param queueSize - maximum number of events waiting in the queue
+ * \return subscriber identifier
+ * \exception FecExceptionHandler
+ * <ul>
+ * <li>TSCFEC_INVALIDOPERATION: too many subscribers
+ * </ul>
+ */
+unsigned int CcuAlarmDispatcher::subscribe ( keyType index, keyType mask, unsigned int types, unsigned int queueSize ) throw (FecExceptionHandler) {
+
+  pthread_mutex_lock (&subscribeMutex_) ;
+
+  unsigned int subscriber = nSubscribers_ ;
+  if (subscriber >= MAXCCUALARMSUBSCRIBERS) {
+    pthread_mutex_unlock (&subscribeMutex_) ;
+    RAISEFECEXCEPTIONHANDLER ( TSCFEC_INVALIDOPERATION,
+			       "Too many subscribers for the CCU alarm dispatcher",
+			       ERRORCODE ) ;
+  }
+
+  subscribers_[subscriber].index = index & mask ;
+  subscribers_[subscriber].mask = mask ;
+  subscribers_[subscriber].types = types ;
+  subscribers_[subscriber].queue = new CcuAlarmQueue (queueSize) ;
+  subscribers_[subscriber].active = true ;
+
+  // The subscriber must be complete before the dispatcher thread sees it
+  __sync_synchronize() ;
+  nSubscribers_ = subscriber + 1 ;
+
+  pthread_mutex_unlock (&subscribeMutex_) ;
+
+  return subscriber ;
+}
+
+/** The queue is kept until the destruction of the dispatcher
+ * \param subscriber - subscriber identifier
+ */
+void CcuAlarmDispatcher::unsubscribe ( unsigned int subscriber ) {
+
+  if (subscriber < nSubscribers_) subscribers_[subscriber].active = false ;
+}
+
+/**
+ * \param subscriber - subscriber identifier
+ * \param event - next event
+ * \return false if no event is available
+ */
+bool CcuAlarmDispatcher::getEvent ( unsigned int subscriber, CcuAlarmEvent &event ) {
+
+  if (subscriber >= nSubscribers_) return false ;
+  return subscribers_[subscriber].queue->pop (event) ;
+}
+
+/**
+ * \param subscriber - subscriber identifier
+ * \return number of events lost because the queue was full
+ */
+unsigned long CcuAlarmDispatcher::getEventsLost ( unsigned int subscriber ) {
+
+  if (subscriber >= nSubscribers_) return 0 ;
+  return subscribers_[subscriber].queue->getLost() ;
+}
+
+/**
+ * \exception FecExceptionHandler
+ * <ul>
+ * <li>TSCFEC_INVALIDOPERATION: the thread cannot be created
+ * </ul>
+ */
+void CcuAlarmDispatcher::start ( ) throw (FecExceptionHandler) {
+
+  if (running_) return ;
+
+  stopRequested_ = false ;
+  running_ = true ;
+  if (pthread_create (&thread_, NULL, dispatcherThread, this) != 0) {
+
+    running_ = false ;
+    RAISEFECEXCEPTIONHANDLER ( TSCFEC_INVALIDOPERATION,
+			       "Cannot create the thread of the CCU alarm dispatcher",
+			       ERRORCODE ) ;
+  }
+}
+
+/** Stop the thread, the events already dispatched stay in the queues
+ */
+void CcuAlarmDispatcher::stop ( ) {
+
+  if (!running_) return ;
+
+  stopRequested_ = true ;
+  pthread_join (thread_, NULL) ;
+  running_ = false ;
+}
+
+/**
+ * \param ringIndex - FEC and ring of the frame
+ * \param frame - frame DST SRC LEN CHANNEL TRANSACTION DATA
+ * \param event - event decoded
+ * \return false if the channel is not the CCU node controller (0) or a PIA channel
+ */
+bool CcuAlarmDispatcher::decodeFrame ( keyType ringIndex, tscType8 *frame, CcuAlarmEvent &event ) {
+
+  event.index = buildCompleteKey(getFecKey(ringIndex), getRingKey(ringIndex), frame[1], frame[3], 0) ;
+  event.status = (frame[2] >= 3) ? frame[5] : 0 ;
+
+  struct timeval time ;
+  gettimeofday (&time, NULL) ;
+  event.timestamp = (unsigned long long)time.tv_sec * 1000000 + time.tv_usec ;
+
+  if (isPiaChannelCcu25(event.index)) event.type = PIAINTERRUPT ;
+  else if (getChannelKey(event.index) == 0) event.type = CCUALARMINPUT ;
+  else return false ;
+
+  return true ;
+}
+
+/**
+ * \param arg - dispatcher
+ */
+void *CcuAlarmDispatcher::dispatcherThread ( void *arg ) {
+
+  ((CcuAlarmDispatcher *)arg)->run() ;
+  return NULL ;
+}
+
+/** Poll all the rings, at most MAXCCUALARMFRAMES frames per ring and per cycle so a ring cannot starve the others
+ */
+void CcuAlarmDispatcher::run ( ) {
+
+  tscType8 frame[DD_USER_MAX_MSG_LENGTH*4] ;
+  unsigned long period = minimumPeriod_ ;
+
+  while (!stopRequested_) {
+
+    unsigned int nFrames = 0 ;
+    for (std::vector<FecRingDevice *>::iterator it = rings_.begin() ; it != rings_.end() ; it ++) {
+
+      keyType ringIndex = buildFecRingKey((*it)->getFecSlot(), (*it)->getRingSlot()) ;
+      try {
+	for (unsigned int i = 0 ; (i < MAXCCUALARMFRAMES) && (*it)->getCcuAlarmFrame (frame) ; i ++) {
+
+	  CcuAlarmEvent event ;
+	  if (decodeFrame (ringIndex, frame, event)) dispatch (event) ;
+	  else errors_ ++ ;
+	  nFrames ++ ;
+	}
+      }
+      catch (FecExceptionHandler &e) {
+	// A frame that is not an alarm is reported by the ring and lost, the next frames are read at the next cycle
+	if (e.getErrorCode() == TSCFEC_PROBLEMINFRAME) unexpectedFrames_ ++ ;
+	else errors_ ++ ;
+      }
+    }
+
+    // Adaptive polling
+    if (nFrames) period = minimumPeriod_ ;
+    else {
+      struct timespec req ; req.tv_sec = period / 1000000 ; req.tv_nsec = (period % 1000000) * 1000 ;
+      nanosleep (&req, NULL) ;
+      period = (period * 2 > maximumPeriod_) ? maximumPeriod_ : period * 2 ;
+    }
+  }
+}
+
+/**
+ * \param event - event to be delivered to the subscribers matching it
+ */
+void CcuAlarmDispatcher::dispatch ( const CcuAlarmEvent &event ) {
+
+  unsigned int nSubscribers = nSubscribers_ ;
+  __sync_synchronize() ;
+
+  for (unsigned int i = 0 ; i < nSubscribers ; i ++) {
+
+    CcuAlarmSubscriber &subscriber = subscribers_[i] ;
+    if (subscriber.active && (subscriber.types & event.type) && ((event.index & subscriber.mask) == subscriber.index))
+      subscriber.queue->push (event) ;
+  }
+
+  events_ ++ ;
+}
@@ -22,6 +22,8 @@
 
 #include <time.h>  // for time function
 
+
+#include "MemBufOutputSource.h"
 #include "XMLConnection.h"
 #include "ConnectionFactory.h"
 
@@ -33,7 +35,8 @@
  * \see addFileName to define the input file
  */
 ConnectionFactory::ConnectionFactory ( ): 
-  DeviceFactoryInterface ( ) {
+  DeviceFactoryInterface ( ),
+  dbStorage_ (NULL) {
 
 // #ifdef DATABASE
 //   if (databaseAccess) {
@@ -69,7 +72,8 @@ ConnectionFactory::ConnectionFactory ( ):
  */
 ConnectionFactory::ConnectionFactory ( std::string login, std::string password, std::string path, bool threaded ) 
     throw ( oracle::occi::SQLException ): 
-  DeviceFactoryInterface ( login, password, path, threaded ) {
+  DeviceFactoryInterface ( login, password, path, threaded ),
+  dbStorage_ (NULL) {
 
   setDatabaseAccess ( login, password, path ) ;
 }
@@ -78,7 +82,8 @@ ConnectionFactory::ConnectionFactory ( std::string login, std::string password,
  * \param dbAccess - database access
  */
 ConnectionFactory::ConnectionFactory ( DbConnectionsAccess *dbAccess ):
-  DeviceFactoryInterface ((DbCommonAccess *)dbAccess) {
+  DeviceFactoryInterface ((DbCommonAccess *)dbAccess),
+  dbStorage_ (NULL) {
 }
 
 #endif
@@ -109,6 +114,119 @@ void ConnectionFactory::clear ( std::string partitionName ) {
   //}
 }
 
+// ------------------------------------------------------------------------------------------------------
+// 
+// Storage methods
+//
+// ------------------------------------------------------------------------------------------------------
+
+/** Identifier of a connection in the storage: FED ID and FED channel
+ */
+static std::string getStorageRecordId ( ConnectionDescription *connection ) {
+
+  std::ostringstream id ;
+  id << connection->getFedId() << " " << connection->getFedChannel() ;
+  return id.str() ;
+}
+
+/** The connections of the partitions are downloaded from and uploaded to the storage instead of the database.
+ * The methods without partition still use the files.
+ * \param dbStorage - storage of the configuration, NULL to go back to the database or the files
+ * \warning the storage is not deleted by the factory
+ */
+void ConnectionFactory::setStorageAccess ( DbStorage *dbStorage ) {
+
+  dbStorage_ = dbStorage ;
+  initDbVersion_ = false ;
+}
+
+/** Retreive the connections of a version of a partition from the storage into the connections of this class.
+ * The download is not done again if the version and the mask are the ones already downloaded.
+ * \param versionMajor - major version, 0.0 for the version of the current state
+ * \param versionMinor - minor version
+ * \param maskVersionMajor - major version of the mask, not used with the version of the current state
+ * \param maskVersionMinor - minor version of the mask
+ * \param partitionName - partition name
+ * \param forceDbReload - download again the version
+ * \exception FecExceptionHandler if the partition or the version does not exist or if the XML cannot be parsed
+ */
+void ConnectionFactory::getStorageConnections ( unsigned int versionMajor, unsigned int versionMinor, unsigned int maskVersionMajor, unsigned int maskVersionMinor, std::string partitionName, bool forceDbReload )
+  throw (FecExceptionHandler ) {
+
+  DbStorageVersion version (versionMajor, versionMinor), mask (maskVersionMajor, maskVersionMinor) ;
+  if ((versionMajor == 0) && (versionMinor == 0)) {
+    version = dbStorage_->getVersion (partitionName, DBSTORAGE_CONNECTION) ;
+    mask = dbStorage_->getVersion (partitionName, DBSTORAGE_MASK) ;
+    if ((version.first == 0) && (version.second == 0)) {
+      std::stringstream msgError ; msgError << "no connection version for the partition " << partitionName ;
+      RAISEFECEXCEPTIONHANDLER (DB_NOVERSIONAVAILABLE, msgError.str(), ERRORCODE) ;
+    }
+  }
+
+  if (!forceDbReload && initDbVersion_ && (partitionName_ == partitionName) &&
+      (versionMajor_ == version.first) && (versionMinor_ == version.second) &&
+      (maskVersionMajor_ == mask.first) && (maskVersionMinor_ == mask.second)) return ;
+
+  // One record per connection between the header and the footer of the XML files
+  MemBufOutputSource memBufOS ;
+  memBufOS.generateHeader() ;
+  memBufOS.generateStartTag (COMMON_XML_SCHEME) ;
+  std::string xmlBuffer = DbStorage::getXMLBuffer (dbStorage_->getRecords (partitionName, DBSTORAGE_CONNECTION, version, mask), memBufOS.getOutputBuffer()->str(), "</ROWSET>") ;
+
+  XMLConnection xmlConnection ( (const XMLByte *)xmlBuffer.c_str() ) ;
+  ConnectionVector connectionVector = xmlConnection.getConnections ( ) ;
+
+  // The connections are not deleted by the XMLConnection
+  clear (partitionName) ;
+  connectionVector_ = connectionVector ;
+
+  versionMajor_ = version.first ;
+  versionMinor_ = version.second ;
+  maskVersionMajor_ = mask.first ;
+  maskVersionMinor_ = mask.second ;
+  partitionName_ = partitionName ;
+  initDbVersion_ = true ;
+
+#ifdef DEBUGMSGERROR
+  std::cout << "Partition " << partitionName_ << ": " << connectionVector_.size() << " connections in the version " << versionMajor_ << "." << versionMinor_ << " & mask " << maskVersionMajor_ << "." << maskVersionMinor_ << std::endl ;
+#endif
+}
+
+/** Upload the connections in a new version of a partition in the storage, the version becomes the one of the current state.
+ * The partition is created if it does not exist.
+ * \param connectionVector - connections to be uploaded
+ * \param partitionName - partition name
+ * \param versionMajor - major version created (output)
+ * \param versionMinor - minor version created (output)
+ * \param majorVersion - create a major version with all the connections, including the disabled connections downloaded, else a minor version with the connections given
+ * \exception FecExceptionHandler if a minor version is created without major version
+ */
+void ConnectionFactory::setStorageConnections ( ConnectionVector connectionVector, std::string partitionName, unsigned int *versionMajor, unsigned int *versionMinor, bool majorVersion )
+  throw (FecExceptionHandler ) {
+
+  // Created only if it does not exist, under the lock of the storage
+  dbStorage_->createPartition (partitionName) ;
+
+  // Complete a major version with the connections downloaded, the connections given replace the ones of the same FED channel
+  DbStorageRecords records ;
+  if (majorVersion) {
+    for (ConnectionVector::iterator itVDev = connectionVector_.begin() ; itVDev != connectionVector_.end() ; itVDev ++) {
+      MemBufOutputSource memBufOS ;
+      memBufOS.generateConnectionTag (ConnectionVector (1, *itVDev)) ;
+      records[getStorageRecordId (*itVDev)] = memBufOS.getOutputBuffer()->str() ;
+    }
+  }
+  for (ConnectionVector::iterator itDev = connectionVector.begin() ; itDev != connectionVector.end() ; itDev ++) {
+    MemBufOutputSource memBufOS ;
+    memBufOS.generateConnectionTag (ConnectionVector (1, *itDev)) ;
+    records[getStorageRecordId (*itDev)] = memBufOS.getOutputBuffer()->str() ;
+  }
+  DbStorageVersion version = dbStorage_->setRecords (partitionName, DBSTORAGE_CONNECTION, records, majorVersion) ;
+
+  *versionMajor = version.first ;
+  *versionMinor = version.second ;
+}
+
 // ------------------------------------------------------------------------------------------------------
 // 
 // XML file methods
@@ -372,6 +490,13 @@ void ConnectionFactory::getConnectionDescriptions ( bool fileUsed, unsigned int
   }
 #endif
 
+  // retreive the information from the storage
+  if ( getStorageUsed() && !fileUsed ) {
+
+    getStorageConnections ( versionMajor, versionMinor, maskVersionMajor, maskVersionMinor, partitionName, forceDbReload ) ;
+    outVector = ConnectionFactory::copy ( connectionVector_, allConnections ) ;
+  }
+  else
 #ifdef DATABASE
   // retreive the information from database
   if ( getDbUsed() && !fileUsed ) {
@@ -643,6 +768,11 @@ void ConnectionFactory::setConnectionDescriptions ( ConnectionVector connectionV
   
   if (connectionVector.empty()) RAISEFECEXCEPTIONHANDLER (NODATAAVAILABLE, NODATAAVAILABLE_MSG + " to be uploaded in DB", ERRORCODE) ;
   
+  if ( getStorageUsed() && (versionMajor != NULL) && (versionMinor != NULL) ) {
+
+    setStorageConnections ( connectionVector, partitionName, versionMajor, versionMinor, majorVersion ) ;
+  }
+  else
 #ifdef DATABASE
   if ( getDbUsed() && (versionMajor != NULL) && (versionMinor != NULL) ) {
 
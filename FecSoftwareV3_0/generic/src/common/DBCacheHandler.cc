@@ -19,7 +19,8 @@ using namespace std;
 				 unsigned int fedsize,
 				 unsigned int fecsize,
 				 unsigned int consize,
-				 bool commonmem)
+				 bool commonmem,
+				 unsigned int generations)
 
 {
   //
@@ -51,6 +52,7 @@ using namespace std;
 
 
   commonMemory_ = commonmem;
+  generations_ = generations;
 
 }
 
@@ -77,7 +79,7 @@ void DBCacheHandler::InitialiseShareMemory()
 	std::cout<<"Creating FED Share Memory with size"<<hex << FEDShareMemorySize_ << dec <<std::endl; 
 	try 
 	  {
-	    dbfedmem_ =  new TShare((char*) FEDShareMemoryName_.c_str(),TShare_CREATE,FEDShareMemorySize_);
+	    dbfedmem_ =  new TShare((char*) FEDShareMemoryName_.c_str(),TShare_CREATE,FEDShareMemorySize_,generations_);
 	    //dbfedstart_ = (char*) dbfedmem_->Attach();
 	  }
 	catch (std::string e)
@@ -93,7 +95,7 @@ void DBCacheHandler::InitialiseShareMemory()
 	try 
 	  {
 	    std::cout<<"Creating FEC Share Memory with size"<<hex << FECShareMemorySize_ << dec <<std::endl;
-	    dbfecmem_ =  new TShare((char*) FECShareMemoryName_.c_str(),TShare_CREATE,FECShareMemorySize_);
+	    dbfecmem_ =  new TShare((char*) FECShareMemoryName_.c_str(),TShare_CREATE,FECShareMemorySize_,generations_);
 	    //dbfecstart_ = (char*) dbfecmem_->Attach();
 	  }
 	catch (std::string e)
@@ -109,7 +111,7 @@ void DBCacheHandler::InitialiseShareMemory()
 	std::cout<<"Creating CON Share Memory with size"<<hex << CONShareMemorySize_ << dec <<std::endl;
 	try 
 	  {
-	    dbconmem_ =  new TShare((char*) CONShareMemoryName_.c_str(),TShare_CREATE,CONShareMemorySize_);
+	    dbconmem_ =  new TShare((char*) CONShareMemoryName_.c_str(),TShare_CREATE,CONShareMemorySize_,generations_);
 	    //dbconstart_ = (char*) dbconmem_->Attach();
 	  }
 	catch (std::string e)
@@ -211,6 +213,23 @@ unsigned long currentMillis = XERCES_CPP_NAMESPACE::XMLPlatformUtils::getCurrent
     dbfecstart_=0;dbfedstart_=0;dbconstart_=0;
 #endif
   curall_=0; //Reinitialise the default pointer
+
+  // With generations, the memories are filled in their next generation and published at the end.
+  // The updates not published (download error) are aborted when leaving, the readers are not blocked
+  char* fedStart = dbfedstart_;
+  char* fecStart = dbfecstart_;
+  char* conStart = dbconstart_;
+  TShareUpdate fedUpdate, fecUpdate, conUpdate;
+  if (generations_ > 1)
+    {
+      if (downloadFED_ && dbfedstart_ != NULL) fedStart = (char*) fedUpdate.Begin(dbfedmem_);
+      if (downloadFEC_ && dbfecstart_ != NULL) fecStart = (char*) fecUpdate.Begin(dbfecmem_);
+      if (downloadCON_ && dbconstart_ != NULL) conStart = (char*) conUpdate.Begin(dbconmem_);
+    }
+  char* fedEnd = fedStart;
+  char* fecEnd = fecStart;
+  char* conEnd = conStart;
+  char** allEnd = NULL; // end of the memory which contains curall_
   // Load FED part
 #ifdef OLDWAY
   if (downloadFED_)
@@ -228,7 +247,7 @@ unsigned long currentMillis = XERCES_CPP_NAMESPACE::XMLPlatformUtils::getCurrent
 #endif
   if (downloadFED_ && dbfedstart_ !=NULL)
     {
-      char* curfed=(char*)dbfedstart_;
+      char* curfed=(char*)fedStart;
       fedChanged_ =false;
 
       // Loop on Partitions
@@ -254,7 +273,8 @@ unsigned long currentMillis = XERCES_CPP_NAMESPACE::XMLPlatformUtils::getCurrent
 		}
 	    }
 	}
-      if (commonMemory_) curall_ = curfed;
+      if (commonMemory_) { curall_ = curfed; allEnd = &fedEnd; }
+      fedEnd = curfed;
     }
 
  currentMillis = XERCES_CPP_NAMESPACE::XMLPlatformUtils::getCurrentMillis();
@@ -279,7 +299,7 @@ unsigned long currentMillis = XERCES_CPP_NAMESPACE::XMLPlatformUtils::getCurrent
 #endif
   if (downloadFEC_ && (dbfecstart_ !=NULL || (commonMemory_ && curall_!=NULL)) )
     {
-      char* current=(char*)dbfecstart_;
+      char* current=(char*)fecStart;
       fecChanged_ = false;
       if (commonMemory_ && curall_!=NULL) current= curall_;
       for (unsigned int ipart=0;ipart<vPart.size();ipart++)
@@ -489,7 +509,12 @@ unsigned long currentMillis = XERCES_CPP_NAMESPACE::XMLPlatformUtils::getCurrent
 
 
 	}
-      if (commonMemory_) curall_ = current;
+      if (commonMemory_ && curall_!=NULL) { curall_ = current; *allEnd = current; }
+      else
+	{
+	  fecEnd = current;
+	  if (commonMemory_) { curall_ = current; allEnd = &fecEnd; }
+	}
 
     }
 #ifdef OLDWAY
@@ -512,9 +537,10 @@ unsigned long currentMillis = XERCES_CPP_NAMESPACE::XMLPlatformUtils::getCurrent
 
   if (downloadCON_ && (dbconstart_ !=NULL || (commonMemory_ && curall_!=NULL)) )
     {
-      char* current=(char*)dbconstart_;
+      char* current=(char*)conStart;
+      bool common = (commonMemory_ && curall_!=NULL);
 
-      if (commonMemory_ && curall_!=NULL) current= curall_;
+      if (common) current= curall_;
       for (unsigned int ipart=0;ipart<vPart.size();ipart++)
 	{
 	  
@@ -535,8 +561,15 @@ unsigned long currentMillis = XERCES_CPP_NAMESPACE::XMLPlatformUtils::getCurrent
 		}
 	    }
 	}
+      if (common) *allEnd = current;
+      else conEnd = current;
     }
 
+  // Publish the generations filled
+  if (fedUpdate.Started()) fedUpdate.Publish(fedEnd - fedStart);
+  if (fecUpdate.Started()) fecUpdate.Publish(fecEnd - fecStart);
+  if (conUpdate.Started()) conUpdate.Publish(conEnd - conStart);
+
 #ifdef OLDWAY
   this->Detach();
 #endif
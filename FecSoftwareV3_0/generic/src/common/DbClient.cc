@@ -113,6 +113,20 @@ void DbClient::purge()
 
    // Parsing
    char* current= (char*)start_;
+
+   // With generations, a consistent copy of the generation published is parsed
+   // (terminated by a null word), the writer is never blocked
+   // The buffer is freed whatever happens during the parsing
+   std::vector<char> snapshot;
+   if (dbmem_->HasGenerations())
+     {
+       unsigned int size = dbmem_->GetGenerationSize();
+       snapshot.resize(size+sizeof(int));
+       unsigned int length = dbmem_->ReadGeneration(&snapshot[0],size);
+       memset(&snapshot[length],0,sizeof(int));
+       current = &snapshot[0];
+     }
+
    int* ibuf = (int*) current;
    std::cout << " IBUF " << hex << ibuf[0] <<std::dec <<std::endl;
       while (((ibuf[0]>>24)&0xFF) == 0xdb )
@@ -224,7 +238,6 @@ void DbClient::purge()
 	  ibuf = (int*) current;
 	}
 
-
       if (vDevices_->size() <=0 && vPiaReset_->size()<=0 && vFed9Us_->size() <=0 && vConn_->size()<=0)       throw std::string("DbClient: Empty Share memory ");
 
 
@@ -0,0 +1,777 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <fstream>
+#include <sstream>
+
+#include "DbFileStorage.h"
+
+/** Files of the storage
+ */
+#define DBFILESTORAGE_INDEX "index"
+#define DBFILESTORAGE_LOCK  "lock"
+
+/** Strings are stored with their size: size:content
+ */
+static void writeString ( std::ostream &os, const std::string &value ) {
+
+  os << value.size() << ':' << value ;
+}
+
+/** Read a string written by writeString
+ */
+static bool readString ( std::istream &is, std::string &value ) {
+
+  std::string::size_type size = 0 ;
+  char separator = 0 ;
+  if (!(is >> size) || !is.get(separator) || (separator != ':')) return false ;
+  value.resize (size) ;
+  if (size > 0) is.read (&value[0], size) ;
+  return (bool)is ;
+}
+
+/** Raise an error on a file of the storage
+ */
+static void raiseFileError ( std::string message, std::string fileName ) throw (FecExceptionHandler) {
+
+  std::ostringstream msg ;
+  msg << message << " " << fileName ;
+  if (errno) msg << ": " << strerror(errno) ;
+  RAISEFECEXCEPTIONHANDLER ( FILEPROBLEMERROR, msg.str(), ERRORCODE ) ;
+}
+
+/** The directory is created if it does not exist
+ * \param directory - directory of the storage
+ * \param cacheSize - number of version files kept in memory, 0 to read the files each time
+ * \exception FecExceptionHandler if the directory or the index cannot be read
+ */
+DbFileStorage::DbFileStorage ( std::string directory, unsigned int cacheSize ) throw (FecExceptionHandler):
+  directory_(directory), currentState_(0), indexInode_(0), indexTime_(0), indexTimeNs_(0), indexSize_(0),
+  cacheSize_(cacheSize), cacheUse_(0), filesRead_(0) {
+
+  errno = 0 ;
+  if ((mkdir (directory_.c_str(), 0755) < 0) && (errno != EEXIST))
+    raiseFileError ("cannot create the storage directory", directory_) ;
+
+  pthread_rwlock_init (&rwlock_, NULL) ;
+  pthread_mutex_init (&cacheMutex_, NULL) ;
+
+  Lock lock (*this, false) ;
+}
+
+/** Nothing
+ */
+DbFileStorage::~DbFileStorage ( ) {
+
+  pthread_rwlock_destroy (&rwlock_) ;
+  pthread_mutex_destroy (&cacheMutex_) ;
+}
+
+/** Take the file lock (shared for the reads), then the read / write lock. The index is read again under
+ * the write lock if another process changed it.
+ * \param storage - storage
+ * \param write - the operation changes the storage
+ */
+DbFileStorage::Lock::Lock ( DbFileStorage &storage, bool write ) throw (FecExceptionHandler): storage_(storage) {
+
+  std::string fileName = storage_.directory_ + "/" DBFILESTORAGE_LOCK ;
+  errno = 0 ;
+  fd_ = open (fileName.c_str(), O_RDWR | O_CREAT, 0644) ;
+  if (fd_ < 0) raiseFileError ("cannot open the lock of the storage", fileName) ;
+  if (flock (fd_, write ? LOCK_EX : LOCK_SH) < 0) {
+    close (fd_) ;
+    raiseFileError ("cannot lock the storage", fileName) ;
+  }
+
+  pthread_rwlock_wrlock (&storage_.rwlock_) ;
+  try {
+    storage_.refreshIndex() ;
+  }
+  catch (FecExceptionHandler &e) {
+    pthread_rwlock_unlock (&storage_.rwlock_) ;
+    close (fd_) ;
+    throw ;
+  }
+  if (!write) {
+    // no other process can change the index while the shared file lock is held
+    pthread_rwlock_unlock (&storage_.rwlock_) ;
+    pthread_rwlock_rdlock (&storage_.rwlock_) ;
+  }
+}
+
+/** Release the locks
+ */
+DbFileStorage::Lock::~Lock ( ) {
+
+  pthread_rwlock_unlock (&storage_.rwlock_) ;
+  close (fd_) ;
+}
+
+/** The index is identified by its inode, its time and its size: a new index is always a new file.
+ * \exception FecExceptionHandler if the index cannot be read
+ */
+void DbFileStorage::refreshIndex ( ) throw (FecExceptionHandler) {
+
+  std::string fileName = directory_ + "/" DBFILESTORAGE_INDEX ;
+  struct stat info ;
+  if (stat (fileName.c_str(), &info) < 0) return ; // empty storage
+  if ((info.st_ino == indexInode_) && (info.st_mtime == indexTime_) && (info.st_mtim.tv_nsec == indexTimeNs_) && (info.st_size == indexSize_)) return ;
+
+  std::ifstream is (fileName.c_str()) ;
+  errno = 0 ;
+  if (!is) raiseFileError ("cannot read the index of the storage", fileName) ;
+
+  std::map<unsigned int, std::string> partitions ;
+  std::map<unsigned int, std::set<DbStorageVersion> > versions ;
+  std::map<unsigned int, State> states ;
+  std::map<unsigned int, Run> runs ;
+  unsigned int currentState = 0 ;
+
+  std::string type ;
+  bool ok = true ;
+  while (ok && (is >> type)) {
+    if (type == "P") {
+      unsigned int id ;
+      ok = (is >> id) && readString (is, partitions[id]) ;
+    }
+    else if (type == "V") {
+      unsigned int key ;
+      DbStorageVersion version ;
+      ok = (bool)(is >> key >> version.first >> version.second) ;
+      versions[key].insert(version) ;
+    }
+    else if (type == "S") {
+      unsigned int id, count ;
+      ok = (is >> id) && readString (is, states[id].name) && (is >> count) ;
+      for (unsigned int i = 0 ; ok && (i < count) ; i ++) {
+	unsigned int partitionId ;
+	ok = (bool)(is >> partitionId) ;
+	std::vector<DbStorageVersion> &stateVersions = states[id].versions[partitionId] ;
+	stateVersions.resize (DBSTORAGE_DATANUMBER) ;
+	for (unsigned int data = 0 ; ok && (data < DBSTORAGE_DATANUMBER) ; data ++)
+	  ok = (bool)(is >> stateVersions[data].first >> stateVersions[data].second) ;
+      }
+    }
+    else if (type == "C") {
+      ok = (bool)(is >> currentState) ;
+    }
+    else if (type == "R") {
+      unsigned int runNumber ;
+      Run run ;
+      ok = (is >> runNumber >> run.partitionId >> run.stateHistoryId >> run.runMode >> run.local >> run.stopped) && readString (is, run.comment) ;
+      runs[runNumber] = run ;
+    }
+    else ok = false ;
+  }
+
+  if (!ok) {
+    errno = 0 ;
+    raiseFileError ("corrupted index of the storage", fileName) ;
+  }
+
+  partitions_.swap (partitions) ;
+  versions_.swap (versions) ;
+  states_.swap (states) ;
+  runs_.swap (runs) ;
+  currentState_ = currentState ;
+
+  indexInode_ = info.st_ino ;
+  indexTime_ = info.st_mtime ;
+  indexTimeNs_ = info.st_mtim.tv_nsec ;
+  indexSize_ = info.st_size ;
+}
+
+/** \exception FecExceptionHandler if the index cannot be written
+ */
+void DbFileStorage::writeIndex ( ) throw (FecExceptionHandler) {
+
+  std::ostringstream os ;
+
+  for (std::map<unsigned int, std::string>::iterator it = partitions_.begin() ; it != partitions_.end() ; it ++) {
+    os << "P " << it->first << " " ; writeString (os, it->second) ; os << std::endl ;
+  }
+  for (std::map<unsigned int, std::set<DbStorageVersion> >::iterator it = versions_.begin() ; it != versions_.end() ; it ++) {
+    for (std::set<DbStorageVersion>::iterator version = it->second.begin() ; version != it->second.end() ; version ++)
+      os << "V " << it->first << " " << version->first << " " << version->second << std::endl ;
+  }
+  for (std::map<unsigned int, State>::iterator it = states_.begin() ; it != states_.end() ; it ++) {
+    os << "S " << it->first << " " ; writeString (os, it->second.name) ; os << " " << it->second.versions.size() ;
+    for (StateVersions::iterator partition = it->second.versions.begin() ; partition != it->second.versions.end() ; partition ++) {
+      os << " " << partition->first ;
+      for (unsigned int data = 0 ; data < DBSTORAGE_DATANUMBER ; data ++)
+	os << " " << partition->second[data].first << " " << partition->second[data].second ;
+    }
+    os << std::endl ;
+  }
+  os << "C " << currentState_ << std::endl ;
+  for (std::map<unsigned int, Run>::iterator it = runs_.begin() ; it != runs_.end() ; it ++) {
+    os << "R " << it->first << " " << it->second.partitionId << " " << it->second.stateHistoryId << " "
+       << it->second.runMode << " " << it->second.local << " " << it->second.stopped << " " ;
+    writeString (os, it->second.comment) ;
+    os << std::endl ;
+  }
+
+  std::string fileName = directory_ + "/" DBFILESTORAGE_INDEX ;
+  writeFile (fileName, os.str()) ;
+
+  // The index written is the one in memory
+  struct stat info ;
+  if (stat (fileName.c_str(), &info) == 0) {
+    indexInode_ = info.st_ino ;
+    indexTime_ = info.st_mtime ;
+    indexTimeNs_ = info.st_mtim.tv_nsec ;
+    indexSize_ = info.st_size ;
+  }
+}
+
+/** The temporary file is flushed on the disk before the rename, and the directory after it, so a file
+ * renamed is never found empty or partial after a crash
+ * \param fileName - file
+ * \param content - content of the file
+ * \exception FecExceptionHandler if the file cannot be written
+ */
+void DbFileStorage::writeFile ( std::string fileName, const std::string &content ) throw (FecExceptionHandler) {
+
+  std::ostringstream temporary ;
+  temporary << fileName << ".tmp." << getpid() ;
+
+  errno = 0 ;
+  int fd = open (temporary.str().c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644) ;
+  if (fd < 0) raiseFileError ("cannot create the file", temporary.str()) ;
+  const char *data = content.data() ;
+  size_t size = content.size() ;
+  while (size > 0) {
+    ssize_t written = write (fd, data, size) ;
+    if (written < 0) {
+      if (errno == EINTR) continue ;
+      break ;
+    }
+    data += written ;
+    size -= written ;
+  }
+  if ((size > 0) || (fsync (fd) < 0)) {
+    int writeError = errno ;
+    close (fd) ;
+    unlink (temporary.str().c_str()) ;
+    errno = writeError ;
+    raiseFileError ("cannot write the file", temporary.str()) ;
+  }
+  if (close (fd) < 0) {
+    unlink (temporary.str().c_str()) ;
+    raiseFileError ("cannot write the file", temporary.str()) ;
+  }
+
+  if (rename (temporary.str().c_str(), fileName.c_str()) < 0) {
+    unlink (temporary.str().c_str()) ;
+    raiseFileError ("cannot rename the file", fileName) ;
+  }
+
+  std::string directory = fileName.substr (0, fileName.rfind ('/')) ;
+  fd = open (directory.c_str(), O_RDONLY) ;
+  if ((fd < 0) || (fsync (fd) < 0)) {
+    if (fd >= 0) close (fd) ;
+    raiseFileError ("cannot flush the directory", directory) ;
+  }
+  close (fd) ;
+}
+
+/** \return the file name of a version
+ */
+std::string DbFileStorage::getVersionFileName ( unsigned int partitionId, DbStorageData data, DbStorageVersion version ) {
+
+  std::ostringstream fileName ;
+  fileName << directory_ << "/" << partitionId << "/" << data << "_" << version.first << "_" << version.second ;
+  return fileName.str() ;
+}
+
+/** \exception FecExceptionHandler if the file cannot be read
+ */
+void DbFileStorage::readVersion ( std::string fileName, DbStorageRecords &records ) throw (FecExceptionHandler) {
+
+  std::ifstream is (fileName.c_str(), std::ios::binary) ;
+  errno = 0 ;
+  if (!is) raiseFileError ("cannot read the version", fileName) ;
+  std::string id, xml ;
+  while (readString (is, id)) {
+    if (!readString (is, xml)) {
+      errno = 0 ;
+      raiseFileError ("corrupted version", fileName) ;
+    }
+    records[id] = xml ;
+  }
+}
+
+/** The versions are never changed so a file is read again only when it was dropped from the cache.
+ * The records are applied under the mutex of the cache so a version can be dropped by another reader.
+ * \param partitionId - partition
+ * \param data - data of the version
+ * \param version - version
+ * \param records - records updated
+ * \param remove - remove the identifiers of the version from records instead of adding its records
+ * \exception FecExceptionHandler if the file cannot be read
+ */
+void DbFileStorage::mergeVersion ( unsigned int partitionId, DbStorageData data, DbStorageVersion version, DbStorageRecords &records, bool remove ) throw (FecExceptionHandler) {
+
+  CacheKey key (partitionId * DBSTORAGE_DATANUMBER + data, version) ;
+  DbStorageRecords update ;
+  DbStorageRecords *stored = &update ;
+
+  pthread_mutex_lock (&cacheMutex_) ;
+  std::map<CacheKey, CachedVersion>::iterator cached = cache_.find (key) ;
+  if (cached == cache_.end()) {
+    // Read outside of the mutex, the other readers are not blocked by the file
+    pthread_mutex_unlock (&cacheMutex_) ;
+    readVersion (getVersionFileName (partitionId, data, version), update) ;
+    pthread_mutex_lock (&cacheMutex_) ;
+    filesRead_ ++ ;
+
+    cached = cache_.find (key) ;
+    if ((cached == cache_.end()) && (cacheSize_ > 0)) {
+      // Empty versions are kept too, drop the least recently used version when the cache is full
+      if (cache_.size() >= cacheSize_) {
+	std::map<CacheKey, CachedVersion>::iterator oldest = cache_.begin() ;
+	for (std::map<CacheKey, CachedVersion>::iterator it = cache_.begin() ; it != cache_.end() ; it ++)
+	  if (it->second.lastUse < oldest->second.lastUse) oldest = it ;
+	cache_.erase (oldest) ;
+      }
+      cached = cache_.insert (std::make_pair (key, CachedVersion())).first ;
+      cached->second.records.swap (update) ;
+    }
+  }
+  if (cached != cache_.end()) {
+    cached->second.lastUse = ++ cacheUse_ ;
+    stored = &cached->second.records ;
+  }
+
+  for (DbStorageRecords::const_iterator record = stored->begin() ; record != stored->end() ; record ++) {
+    if (remove) records.erase (record->first) ;
+    else records[record->first] = record->second ;
+  }
+  pthread_mutex_unlock (&cacheMutex_) ;
+}
+
+/** Number of versions in the cache, for the tests
+ */
+unsigned int DbFileStorage::getCachedVersions ( ) {
+
+  pthread_mutex_lock (&cacheMutex_) ;
+  unsigned int size = cache_.size() ;
+  pthread_mutex_unlock (&cacheMutex_) ;
+  return size ;
+}
+
+/** \exception FecExceptionHandler if the data is not valid
+ */
+void DbFileStorage::checkData ( DbStorageData data ) throw (FecExceptionHandler) {
+
+  if ((data < 0) || (data >= DBSTORAGE_DATANUMBER))
+    RAISEFECEXCEPTIONHANDLER ( DB_INVALIDOPERATION, "invalid type of data for the storage", ERRORCODE ) ;
+}
+
+/** \exception FecExceptionHandler if the partition does not exist
+ */
+unsigned int DbFileStorage::findPartitionId ( std::string partitionName ) throw (FecExceptionHandler) {
+
+  for (std::map<unsigned int, std::string>::iterator it = partitions_.begin() ; it != partitions_.end() ; it ++)
+    if (it->second == partitionName) return it->first ;
+
+  RAISEFECEXCEPTIONHANDLER ( DB_NODATAAVAILABLE, "the partition " + partitionName + " does not exist", ERRORCODE ) ;
+}
+
+/** \exception FecExceptionHandler if the state does not exist
+ */
+const DbFileStorage::State &DbFileStorage::findState ( unsigned int stateHistoryId ) throw (FecExceptionHandler) {
+
+  static const State emptyState ;
+  if (stateHistoryId == 0) return emptyState ;
+
+  std::map<unsigned int, State>::iterator it = states_.find (stateHistoryId) ;
+  if (it == states_.end()) {
+    std::ostringstream msg ;
+    msg << "the state " << stateHistoryId << " does not exist" ;
+    RAISEFECEXCEPTIONHANDLER ( DB_NODATAAVAILABLE, msg.str(), ERRORCODE ) ;
+  }
+  return it->second ;
+}
+
+/** The state added becomes the current state
+ * \return the identifier of the state
+ */
+unsigned int DbFileStorage::addState ( const State &state ) {
+
+  unsigned int stateHistoryId = states_.empty() ? 1 : states_.rbegin()->first + 1 ;
+  states_[stateHistoryId] = state ;
+  currentState_ = stateHistoryId ;
+  return stateHistoryId ;
+}
+
+/** \return the version in the state, 0.0 if the partition has no version in the state
+ */
+DbStorageVersion DbFileStorage::findVersion ( unsigned int stateHistoryId, unsigned int partitionId, DbStorageData data ) throw (FecExceptionHandler) {
+
+  checkData (data) ;
+  const State &state = findState (stateHistoryId) ;
+  StateVersions::const_iterator it = state.versions.find (partitionId) ;
+  if (it == state.versions.end()) return DbStorageVersion (0, 0) ;
+  return it->second[data] ;
+}
+
+/** The partition is searched under the exclusive lock, so several processes can create the same partition
+ * \return the identifier of the partition, the existing one if the partition already exists
+ * \exception FecExceptionHandler if the directory of the partition cannot be created
+ */
+unsigned int DbFileStorage::createPartition ( std::string partitionName ) throw (FecExceptionHandler) {
+
+  Lock lock (*this, true) ;
+
+  for (std::map<unsigned int, std::string>::iterator it = partitions_.begin() ; it != partitions_.end() ; it ++)
+    if (it->second == partitionName) return it->first ;
+
+  unsigned int partitionId = partitions_.empty() ? 1 : partitions_.rbegin()->first + 1 ;
+  partitions_[partitionId] = partitionName ;
+
+  std::ostringstream directory ;
+  directory << directory_ << "/" << partitionId ;
+  errno = 0 ;
+  if ((mkdir (directory.str().c_str(), 0755) < 0) && (errno != EEXIST))
+    raiseFileError ("cannot create the partition directory", directory.str()) ;
+
+  writeIndex() ;
+  return partitionId ;
+}
+
+unsigned int DbFileStorage::getPartitionId ( std::string partitionName ) throw (FecExceptionHandler) {
+
+  Lock lock (*this, false) ;
+  return findPartitionId (partitionName) ;
+}
+
+std::string DbFileStorage::getPartitionName ( unsigned int partitionId ) throw (FecExceptionHandler) {
+
+  Lock lock (*this, false) ;
+  std::map<unsigned int, std::string>::iterator it = partitions_.find (partitionId) ;
+  if (it == partitions_.end()) {
+    std::ostringstream msg ;
+    msg << "the partition " << partitionId << " does not exist" ;
+    RAISEFECEXCEPTIONHANDLER ( DB_NODATAAVAILABLE, msg.str(), ERRORCODE ) ;
+  }
+  return it->second ;
+}
+
+std::list<std::string> DbFileStorage::getAllPartitionNames ( ) throw (FecExceptionHandler) {
+
+  Lock lock (*this, false) ;
+  std::list<std::string> names ;
+  for (std::map<unsigned int, std::string>::iterator it = partitions_.begin() ; it != partitions_.end() ; it ++) names.push_back (it->second) ;
+  return names ;
+}
+
+std::list<std::string> DbFileStorage::getAllPartitionNamesFromCurrentState ( ) throw (FecExceptionHandler) {
+
+  Lock lock (*this, false) ;
+  std::list<std::string> names ;
+  const State &state = findState (currentState_) ;
+  for (StateVersions::const_iterator it = state.versions.begin() ; it != state.versions.end() ; it ++) names.push_back (partitions_[it->first]) ;
+  return names ;
+}
+
+std::list<std::string> DbFileStorage::getAllPartitionNames ( unsigned int runNumber ) throw (FecExceptionHandler) {
+
+  Lock lock (*this, false) ;
+  std::list<std::string> names ;
+  std::map<unsigned int, Run>::iterator it = runs_.find (runNumber) ;
+  if (it != runs_.end()) names.push_back (partitions_[it->second.partitionId]) ;
+  return names ;
+}
+
+/** A major version is the last major version + 1, a minor version is a minor version of the major version of the current state.
+ * The current state is copied with the new version.
+ * \param partitionName - partition
+ * \param data - type of data
+ * \param records - records of the version, only the records changed for a minor version
+ * \param major - major or minor version
+ * \return the version created
+ * \exception FecExceptionHandler if the partition does not exist or if a minor version is asked without major version
+ */
+DbStorageVersion DbFileStorage::setRecords ( std::string partitionName, DbStorageData data, const DbStorageRecords &records, bool major ) throw (FecExceptionHandler) {
+
+  checkData (data) ;
+  Lock lock (*this, true) ;
+
+  unsigned int partitionId = findPartitionId (partitionName) ;
+  std::set<DbStorageVersion> &versions = versions_[partitionId * DBSTORAGE_DATANUMBER + data] ;
+
+  DbStorageVersion version ;
+  if (major) {
+    version.first = versions.empty() ? 1 : versions.rbegin()->first + 1 ;
+    version.second = 0 ;
+  }
+  else {
+    DbStorageVersion current = findVersion (currentState_, partitionId, data) ;
+    if (current.first == 0)
+      RAISEFECEXCEPTIONHANDLER ( DB_NOVERSIONAVAILABLE, "no major version in the current state for a minor version of the partition " + partitionName, ERRORCODE ) ;
+    // last minor version of the major version, the major version itself exists
+    std::set<DbStorageVersion>::iterator last = versions.lower_bound (DbStorageVersion (current.first + 1, 0)) ;
+    last -- ;
+    version.first = current.first ;
+    version.second = last->second + 1 ;
+  }
+
+  std::ostringstream os ;
+  for (DbStorageRecords::const_iterator it = records.begin() ; it != records.end() ; it ++) {
+    writeString (os, it->first) ;
+    writeString (os, it->second) ;
+    os << std::endl ;
+  }
+  writeFile (getVersionFileName (partitionId, data, version), os.str()) ;
+
+  versions.insert (version) ;
+  State state = findState (currentState_) ;
+  std::vector<DbStorageVersion> &stateVersions = state.versions[partitionId] ;
+  stateVersions.resize (DBSTORAGE_DATANUMBER) ;
+  stateVersions[data] = version ;
+  state.name = "" ;
+  addState (state) ;
+
+  writeIndex() ;
+  return version ;
+}
+
+DbStorageVersion DbFileStorage::getVersion ( std::string partitionName, DbStorageData data ) throw (FecExceptionHandler) {
+
+  Lock lock (*this, false) ;
+  return findVersion (currentState_, findPartitionId (partitionName), data) ;
+}
+
+std::list<DbStorageVersion> DbFileStorage::getVersions ( std::string partitionName, DbStorageData data ) throw (FecExceptionHandler) {
+
+  checkData (data) ;
+  Lock lock (*this, false) ;
+  std::set<DbStorageVersion> &versions = versions_[findPartitionId (partitionName) * DBSTORAGE_DATANUMBER + data] ;
+  return std::list<DbStorageVersion> (versions.begin(), versions.end()) ;
+}
+
+/** The records of a version are the records of the major version updated by each minor version up to the version given.
+ * The identifiers of the records of the mask version are removed.
+ * \param partitionName - partition
+ * \param data - type of data
+ * \param version - version
+ * \param mask - mask version, 0.0 for no mask
+ * \exception FecExceptionHandler if a version does not exist
+ */
+DbStorageRecords DbFileStorage::getRecords ( std::string partitionName, DbStorageData data, DbStorageVersion version, DbStorageVersion mask ) throw (FecExceptionHandler) {
+
+  checkData (data) ;
+  Lock lock (*this, false) ;
+
+  unsigned int partitionId = findPartitionId (partitionName) ;
+  std::set<DbStorageVersion> &versions = versions_[partitionId * DBSTORAGE_DATANUMBER + data] ;
+  if (versions.find (version) == versions.end()) {
+    std::ostringstream msg ;
+    msg << "the version " << version.first << "." << version.second << " does not exist for the partition " << partitionName ;
+    RAISEFECEXCEPTIONHANDLER ( DB_NOVERSIONAVAILABLE, msg.str(), ERRORCODE ) ;
+  }
+
+  DbStorageRecords records ;
+  for (std::set<DbStorageVersion>::iterator it = versions.lower_bound (DbStorageVersion (version.first, 0)) ; (it != versions.end()) && (*it <= version) ; it ++) {
+    mergeVersion (partitionId, data, *it, records, false) ;
+  }
+
+  if (mask.first != 0) {
+    std::set<DbStorageVersion> &masks = versions_[partitionId * DBSTORAGE_DATANUMBER + DBSTORAGE_MASK] ;
+    if (masks.find (mask) == masks.end()) {
+      std::ostringstream msg ;
+      msg << "the mask version " << mask.first << "." << mask.second << " does not exist for the partition " << partitionName ;
+      RAISEFECEXCEPTIONHANDLER ( DB_NOVERSIONAVAILABLE, msg.str(), ERRORCODE ) ;
+    }
+    mergeVersion (partitionId, DBSTORAGE_MASK, mask, records, true) ;
+  }
+
+  return records ;
+}
+
+unsigned int DbFileStorage::getCurrentStateHistoryId ( ) throw (FecExceptionHandler) {
+
+  Lock lock (*this, false) ;
+  return currentState_ ;
+}
+
+/** \exception FecExceptionHandler if the name is already used
+ */
+unsigned int DbFileStorage::createStateHistory ( std::string stateHistoryName ) throw (FecExceptionHandler) {
+
+  Lock lock (*this, true) ;
+
+  for (std::map<unsigned int, State>::iterator it = states_.begin() ; it != states_.end() ; it ++)
+    if (!stateHistoryName.empty() && (it->second.name == stateHistoryName))
+      RAISEFECEXCEPTIONHANDLER ( DB_INVALIDOPERATION, "the state " + stateHistoryName + " already exists", ERRORCODE ) ;
+
+  State state = findState (currentState_) ;
+  state.name = stateHistoryName ;
+  unsigned int stateHistoryId = addState (state) ;
+
+  writeIndex() ;
+  return stateHistoryId ;
+}
+
+unsigned int DbFileStorage::getStateHistoryId ( std::string stateHistoryName ) throw (FecExceptionHandler) {
+
+  Lock lock (*this, false) ;
+  for (std::map<unsigned int, State>::iterator it = states_.begin() ; it != states_.end() ; it ++)
+    if (!stateHistoryName.empty() && (it->second.name == stateHistoryName)) return it->first ;
+
+  RAISEFECEXCEPTIONHANDLER ( DB_NODATAAVAILABLE, "the state " + stateHistoryName + " does not exist", ERRORCODE ) ;
+}
+
+std::list<std::string> DbFileStorage::getAllStateHistoryNames ( ) throw (FecExceptionHandler) {
+
+  Lock lock (*this, false) ;
+  std::list<std::string> names ;
+  for (std::map<unsigned int, State>::iterator it = states_.begin() ; it != states_.end() ; it ++)
+    if (!it->second.name.empty()) names.push_back (it->second.name) ;
+  return names ;
+}
+
+DbStorageVersion DbFileStorage::getVersion ( unsigned int stateHistoryId, std::string partitionName, DbStorageData data ) throw (FecExceptionHandler) {
+
+  Lock lock (*this, false) ;
+  return findVersion (stateHistoryId, findPartitionId (partitionName), data) ;
+}
+
+/** \exception FecExceptionHandler if the state does not exist
+ */
+unsigned int DbFileStorage::setCurrentState ( unsigned int stateHistoryId ) throw (FecExceptionHandler) {
+
+  Lock lock (*this, true) ;
+  findState (stateHistoryId) ;
+  currentState_ = stateHistoryId ;
+  writeIndex() ;
+  return currentState_ ;
+}
+
+/** \exception FecExceptionHandler if the state or the partition does not exist
+ */
+unsigned int DbFileStorage::setCurrentState ( std::string partitionName, unsigned int stateHistoryId ) throw (FecExceptionHandler) {
+
+  Lock lock (*this, true) ;
+
+  unsigned int partitionId = findPartitionId (partitionName) ;
+  const State &reference = findState (stateHistoryId) ;
+  State state = findState (currentState_) ;
+  state.name = "" ;
+  StateVersions::const_iterator it = reference.versions.find (partitionId) ;
+  if (it != reference.versions.end()) state.versions[partitionId] = it->second ;
+  else state.versions.erase (partitionId) ;
+  addState (state) ;
+
+  writeIndex() ;
+  return currentState_ ;
+}
+
+/** \exception FecExceptionHandler if the partition does not exist or if the run is already registered
+ */
+void DbFileStorage::setRun ( std::string partitionName, unsigned int runNumber, int runMode, int local, std::string comment ) throw (FecExceptionHandler) {
+
+  Lock lock (*this, true) ;
+
+  if (runs_.find (runNumber) != runs_.end()) {
+    std::ostringstream msg ;
+    msg << "the run " << runNumber << " is already registered" ;
+    RAISEFECEXCEPTIONHANDLER ( DB_INVALIDOPERATION, msg.str(), ERRORCODE ) ;
+  }
+
+  Run run ;
+  run.partitionId = findPartitionId (partitionName) ;
+  run.stateHistoryId = currentState_ ;
+  run.runMode = runMode ;
+  run.local = local ;
+  run.stopped = false ;
+  run.comment = comment ;
+  runs_[runNumber] = run ;
+
+  writeIndex() ;
+}
+
+/** \exception FecExceptionHandler if no run is started for the partition
+ */
+void DbFileStorage::stopRun ( std::string partitionName, std::string comment ) throw (FecExceptionHandler) {
+
+  Lock lock (*this, true) ;
+
+  unsigned int partitionId = findPartitionId (partitionName) ;
+  for (std::map<unsigned int, Run>::reverse_iterator it = runs_.rbegin() ; it != runs_.rend() ; it ++) {
+    if ((it->second.partitionId == partitionId) && !it->second.stopped) {
+      it->second.stopped = true ;
+      if (!comment.empty()) it->second.comment = comment ;
+      writeIndex() ;
+      return ;
+    }
+  }
+
+  RAISEFECEXCEPTIONHANDLER ( DB_INVALIDOPERATION, "no run started for the partition " + partitionName, ERRORCODE ) ;
+}
+
+unsigned int DbFileStorage::getCurrentRunNumber ( ) throw (FecExceptionHandler) {
+
+  Lock lock (*this, false) ;
+  return runs_.empty() ? 0 : runs_.rbegin()->first ;
+}
+
+unsigned int DbFileStorage::getRunStateHistoryId ( unsigned int runNumber ) throw (FecExceptionHandler) {
+
+  Lock lock (*this, false) ;
+  std::map<unsigned int, Run>::iterator it = runs_.find (runNumber) ;
+  if (it == runs_.end()) {
+    std::ostringstream msg ;
+    msg << "the run " << runNumber << " is not registered" ;
+    RAISEFECEXCEPTIONHANDLER ( DB_NODATAAVAILABLE, msg.str(), ERRORCODE ) ;
+  }
+  return it->second.stateHistoryId ;
+}
+
+/** \param runNumber - run
+ * \param allPartition - the state of the run becomes the current state, else only the partition of the run is taken from it
+ * \exception FecExceptionHandler if the run is not registered
+ */
+unsigned int DbFileStorage::copyStateForRunNumber ( unsigned int runNumber, bool allPartition ) throw (FecExceptionHandler) {
+
+  std::string partitionName ;
+  unsigned int stateHistoryId ;
+  {
+    Lock lock (*this, false) ;
+    std::map<unsigned int, Run>::iterator it = runs_.find (runNumber) ;
+    if (it == runs_.end()) {
+      std::ostringstream msg ;
+      msg << "the run " << runNumber << " is not registered" ;
+      RAISEFECEXCEPTIONHANDLER ( DB_NODATAAVAILABLE, msg.str(), ERRORCODE ) ;
+    }
+    partitionName = partitions_[it->second.partitionId] ;
+    stateHistoryId = it->second.stateHistoryId ;
+  }
+
+  if (allPartition) return setCurrentState (stateHistoryId) ;
+  else return setCurrentState (partitionName, stateHistoryId) ;
+}
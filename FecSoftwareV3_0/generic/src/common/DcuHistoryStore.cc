@@ -0,0 +1,534 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+#include <sys/stat.h>
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "dcuDescription.h"
+#include "DcuHistoryStore.h"
+
+/** Index of the segments closed: one line per segment "fileName timeStart timeStop points"
+ */
+#define DCUHISTORY_INDEX "segments.idx"
+
+/** Size of a point in a segment: DCU hard id, timestamp, value, channel, reserved
+ */
+#define DCUHISTORY_POINTSIZE 12
+
+/** Points read at once from a segment
+ */
+#define DCUHISTORY_READPOINTS 4096
+
+/** Lock of the mutex released on exception
+ */
+class DcuHistoryLock {
+public:
+  DcuHistoryLock ( pthread_mutex_t &mutex ): mutex_(mutex) { pthread_mutex_lock (&mutex_) ; }
+  ~DcuHistoryLock ( ) { pthread_mutex_unlock (&mutex_) ; }
+private:
+  pthread_mutex_t &mutex_ ;
+} ;
+
+/** Raise an error on a file of the history
+ */
+static void raiseFileError ( std::string message, std::string fileName ) throw (FecExceptionHandler) {
+
+  std::ostringstream msg ;
+  msg << message << " " << fileName ;
+  if (errno) msg << ": " << strerror(errno) ;
+  RAISEFECEXCEPTIONHANDLER ( FILEPROBLEMERROR, msg.str(), ERRORCODE ) ;
+}
+
+/** Name of a segment file
+ */
+static std::string getSegmentName ( unsigned int segmentNumber ) {
+
+  std::ostringstream fileName ;
+  fileName << "segment_" << segmentNumber << ".dcu" ;
+  return fileName.str() ;
+}
+
+/** Little endian coding of the points
+ */
+static inline void putWord ( unsigned char *buffer, tscType32 value ) {
+
+  buffer[0] = value & 0xFF ; buffer[1] = (value >> 8) & 0xFF ; buffer[2] = (value >> 16) & 0xFF ; buffer[3] = (value >> 24) & 0xFF ;
+}
+
+static inline tscType32 getWord ( const unsigned char *buffer ) {
+
+  return buffer[0] | (buffer[1] << 8) | (buffer[2] << 16) | ((tscType32)buffer[3] << 24) ;
+}
+
+/** Sort the points by time
+ */
+static bool sortPointByTime ( const DcuHistoryPoint &p1, const DcuHistoryPoint &p2 ) {
+
+  return p1.timeStamp < p2.timeStamp ;
+}
+
+/** The segments closed are read from the index. A segment written but not in the index (process stopped
+ * before the segment was closed) is added to the index, the new points go to a new segment.
+ * \param directory - directory of the history, created if it does not exist
+ * \param segmentPoints - number of points of a segment
+ * \exception FecExceptionHandler if the directory or the index cannot be read
+ */
+DcuHistoryStore::DcuHistoryStore ( std::string directory, unsigned int segmentPoints ) throw (FecExceptionHandler):
+  directory_(directory), segmentPoints_(segmentPoints ? segmentPoints : 1), maximumSilence_(3600),
+  segmentFile_(NULL), segmentNumber_(0), values_(0), points_(0), dcus_(0), significant_(0) {
+
+  errno = 0 ;
+  if ((mkdir (directory_.c_str(), 0755) < 0) && (errno != EEXIST))
+    raiseFileError ("cannot create the DCU history directory", directory_) ;
+
+  for (unsigned int i = 0 ; i < DCUHISTORY_CHANNELS ; i ++) deadband_[i] = deviation_[i] = 0 ;
+
+  // Segments closed
+  std::ifstream index ((directory_ + "/" DCUHISTORY_INDEX).c_str()) ;
+  Segment segment ;
+  while (index >> segment.fileName >> segment.timeStart >> segment.timeStop >> segment.points) {
+    segments_.push_back (segment) ;
+    unsigned int segmentNumber = 0 ;
+    if (sscanf (segment.fileName.c_str(), "segment_%u.dcu", &segmentNumber) == 1 && segmentNumber >= segmentNumber_)
+      segmentNumber_ = segmentNumber + 1 ;
+  }
+  index.close() ;
+
+  // Segments not closed
+  struct stat fileStat ;
+  while (stat ((directory_ + "/" + getSegmentName (segmentNumber_)).c_str(), &fileStat) == 0) {
+    segment.fileName = getSegmentName (segmentNumber_) ;
+    segment.timeStart = segment.timeStop = 0 ;
+    segment.points = 0 ;
+    segments_.push_back (segment) ;
+
+    std::vector<DcuHistoryPoint> points ;
+    readSegment (segment, 0, DCUHISTORY_CHANNELS, 0, 0xFFFFFFFF, points) ;
+    Segment &recovered = segments_.back() ;
+    for (std::vector<DcuHistoryPoint>::iterator it = points.begin() ; it != points.end() ; it ++) {
+      if (recovered.points == 0 || it->timeStamp < recovered.timeStart) recovered.timeStart = it->timeStamp ;
+      if (recovered.points == 0 || it->timeStamp > recovered.timeStop) recovered.timeStop = it->timeStamp ;
+      recovered.points ++ ;
+    }
+
+    std::ofstream indexFile ((directory_ + "/" DCUHISTORY_INDEX).c_str(), std::ios::app) ;
+    indexFile << recovered.fileName << " " << recovered.timeStart << " " << recovered.timeStop << " " << recovered.points << std::endl ;
+    if (!indexFile) raiseFileError ("cannot write the index of the DCU history", directory_ + "/" DCUHISTORY_INDEX) ;
+    segmentNumber_ ++ ;
+  }
+
+  pthread_mutex_init (&mutex_, NULL) ;
+}
+
+/** The errors are ignored
+ */
+DcuHistoryStore::~DcuHistoryStore ( ) {
+
+  try {
+    flush() ;
+    if (segmentFile_ != NULL) closeSegment() ;
+  }
+  catch (FecExceptionHandler &e) {
+    std::cerr << "DcuHistoryStore: " << e.what() << std::endl ;
+  }
+
+  pthread_mutex_destroy (&mutex_) ;
+}
+
+/**
+ * \param channel - channel
+ * \exception FecExceptionHandler if the channel does not exist
+ */
+void DcuHistoryStore::checkChannel ( int channel ) throw (FecExceptionHandler) {
+
+  if ((channel < 0) || (channel >= DCUHISTORY_CHANNELS)) {
+    std::ostringstream msg ;
+    msg << "invalid DCU channel " << channel ;
+    RAISEFECEXCEPTIONHANDLER ( TSCFEC_INVALIDOPERATION, msg.str(), ERRORCODE ) ;
+  }
+}
+
+/**
+ * \param deadband - deadband in ADC counts
+ * \param channel - channel, -1 for all channels
+ */
+void DcuHistoryStore::setDeadband ( tscType16 deadband, int channel ) throw (FecExceptionHandler) {
+
+  if (channel != -1) checkChannel (channel) ;
+
+  DcuHistoryLock lock (mutex_) ;
+  for (unsigned int i = 0 ; i < DCUHISTORY_CHANNELS ; i ++)
+    if ((channel == -1) || (channel == (int)i)) deadband_[i] = deadband ;
+}
+
+/**
+ * \param deviation - compression deviation in ADC counts
+ * \param channel - channel, -1 for all channels
+ */
+void DcuHistoryStore::setCompressionDeviation ( tscType16 deviation, int channel ) throw (FecExceptionHandler) {
+
+  if (channel != -1) checkChannel (channel) ;
+
+  DcuHistoryLock lock (mutex_) ;
+  for (unsigned int i = 0 ; i < DCUHISTORY_CHANNELS ; i ++)
+    if ((channel == -1) || (channel == (int)i)) deviation_[i] = deviation ;
+}
+
+/**
+ * \param dcu - DCU values
+ * \return true if the DCU is significant (first values, one channel out of its deadband or maximum silence reached)
+ */
+bool DcuHistoryStore::add ( dcuDescription &dcu ) throw (FecExceptionHandler) {
+
+  DcuHistoryLock lock (mutex_) ;
+  bool significant = addValues (dcu) ;
+  writeBuffer() ;
+  return significant ;
+}
+
+/**
+ * \param dcus - DCU values, the devices which are not DCUs are ignored
+ * \param significant - DCUs significant, the DCUs are not cloned
+ * \return number of DCUs significant
+ */
+unsigned int DcuHistoryStore::add ( deviceVector &dcus, deviceVector &significant ) throw (FecExceptionHandler) {
+
+  DcuHistoryLock lock (mutex_) ;
+  unsigned int number = 0 ;
+  for (deviceVector::iterator it = dcus.begin() ; it != dcus.end() ; it ++) {
+    if ((*it)->getDeviceType() != DCU) continue ;
+    if (addValues (*((dcuDescription *)*it))) {
+      significant.push_back (*it) ;
+      number ++ ;
+    }
+  }
+  writeBuffer() ;
+  return number ;
+}
+
+/** Deadband then swinging door compression on each channel: the door is the set of slopes from the last
+ * point stored which keep all the values held since within the deviation. The value held (last received)
+ * is stored when the line to the new value leaves the door or when the maximum silence is reached, so the
+ * line between two points stored is never farther than the deviation from the values received.
+ * \param dcu - DCU values
+ * \return true if the DCU is significant
+ */
+bool DcuHistoryStore::addValues ( dcuDescription &dcu ) throw (FecExceptionHandler) {
+
+  tscType32 dcuHardId = dcu.getDcuHardId() ;
+  tscType32 timeStamp = dcu.getTimeStamp() ;
+
+  Sgi::hash_map<unsigned long, DcuState>::iterator it = dcuStates_.find (dcuHardId) ;
+  if (it == dcuStates_.end()) {
+
+    // First values: stored and significant
+    DcuState &state = dcuStates_[dcuHardId] ;
+    for (unsigned int i = 0 ; i < DCUHISTORY_CHANNELS ; i ++) {
+      ChannelState &channel = state.channels[i] ;
+      tscType16 value = dcu.getDcuChannel (i) ;
+      channel.storedTime = channel.heldTime = timeStamp ;
+      channel.storedValue = channel.heldValue = channel.significantValue = value ;
+      channel.slopeMin = -HUGE_VAL ;
+      channel.slopeMax = HUGE_VAL ;
+      storePoint (dcuHardId, i, timeStamp, value) ;
+    }
+    state.lastTime = state.significantTime = timeStamp ;
+    values_ += DCUHISTORY_CHANNELS ;
+    dcus_ ++ ;
+    significant_ ++ ;
+    return true ;
+  }
+
+  DcuState &state = it->second ;
+  if (timeStamp <= state.lastTime) return false ;
+  state.lastTime = timeStamp ;
+  values_ += DCUHISTORY_CHANNELS ;
+  dcus_ ++ ;
+
+  bool significant = (timeStamp - state.significantTime >= maximumSilence_) ;
+  for (unsigned int i = 0 ; i < DCUHISTORY_CHANNELS ; i ++) {
+    ChannelState &channel = state.channels[i] ;
+    tscType16 value = dcu.getDcuChannel (i) ;
+
+    // Deadband
+    if (abs ((int)value - (int)channel.significantValue) > deadband_[i]) significant = true ;
+
+    // Maximum silence: the value held is stored
+    if ((timeStamp - channel.storedTime >= maximumSilence_) && (channel.heldTime != channel.storedTime)) {
+      storePoint (dcuHardId, i, channel.heldTime, channel.heldValue) ;
+      channel.storedTime = channel.heldTime ;
+      channel.storedValue = channel.heldValue ;
+      channel.slopeMin = -HUGE_VAL ;
+      channel.slopeMax = HUGE_VAL ;
+    }
+
+    // Swinging door: the line to the new value must stay in the door of the values held before
+    double deltaTime = timeStamp - channel.storedTime ;
+    double slope = ((double)value - channel.storedValue) / deltaTime ;
+    if ((slope < channel.slopeMin) || (slope > channel.slopeMax)) {
+      storePoint (dcuHardId, i, channel.heldTime, channel.heldValue) ;
+      channel.storedTime = channel.heldTime ;
+      channel.storedValue = channel.heldValue ;
+      channel.slopeMin = -HUGE_VAL ;
+      channel.slopeMax = HUGE_VAL ;
+      deltaTime = timeStamp - channel.storedTime ;
+    }
+    channel.slopeMax = std::min (channel.slopeMax, ((double)value + deviation_[i] - channel.storedValue) / deltaTime) ;
+    channel.slopeMin = std::max (channel.slopeMin, ((double)value - deviation_[i] - channel.storedValue) / deltaTime) ;
+    channel.heldTime = timeStamp ;
+    channel.heldValue = value ;
+  }
+
+  if (significant) {
+    for (unsigned int i = 0 ; i < DCUHISTORY_CHANNELS ; i ++) state.channels[i].significantValue = dcu.getDcuChannel (i) ;
+    state.significantTime = timeStamp ;
+    significant_ ++ ;
+  }
+
+  return significant ;
+}
+
+/**
+ * \param dcuHardId - DCU hardware id
+ * \param channel - channel
+ * \param timeStamp - time of the point
+ * \param value - value
+ */
+void DcuHistoryStore::storePoint ( tscType32 dcuHardId, unsigned int channel, tscType32 timeStamp, tscType16 value ) throw (FecExceptionHandler) {
+
+  if (segmentFile_ == NULL) {
+    Segment segment ;
+    segment.fileName = getSegmentName (segmentNumber_) ;
+    segment.timeStart = segment.timeStop = timeStamp ;
+    segment.points = 0 ;
+    errno = 0 ;
+    segmentFile_ = fopen ((directory_ + "/" + segment.fileName).c_str(), "ab") ;
+    if (segmentFile_ == NULL) raiseFileError ("cannot create the DCU history segment", directory_ + "/" + segment.fileName) ;
+    segments_.push_back (segment) ;
+  }
+
+  Segment &segment = segments_.back() ;
+  if (timeStamp < segment.timeStart) segment.timeStart = timeStamp ;
+  if (timeStamp > segment.timeStop) segment.timeStop = timeStamp ;
+  segment.points ++ ;
+  points_ ++ ;
+
+  unsigned char point[DCUHISTORY_POINTSIZE] ;
+  putWord (point, dcuHardId) ;
+  putWord (point + 4, timeStamp) ;
+  point[8] = value & 0xFF ;
+  point[9] = (value >> 8) & 0xFF ;
+  point[10] = channel ;
+  point[11] = 0 ;
+  buffer_.insert (buffer_.end(), point, point + DCUHISTORY_POINTSIZE) ;
+
+  if (segment.points >= segmentPoints_) closeSegment() ;
+}
+
+/** The points are written in the current segment and the file is flushed
+ */
+void DcuHistoryStore::writeBuffer ( ) throw (FecExceptionHandler) {
+
+  if (buffer_.empty() || (segmentFile_ == NULL)) return ;
+
+  errno = 0 ;
+  if ((fwrite (&buffer_[0], 1, buffer_.size(), segmentFile_) != buffer_.size()) || (fflush (segmentFile_) != 0))
+    raiseFileError ("cannot write the DCU history segment", directory_ + "/" + segments_.back().fileName) ;
+  buffer_.clear() ;
+}
+
+/** The segment is written, closed and appended to the index
+ */
+void DcuHistoryStore::closeSegment ( ) throw (FecExceptionHandler) {
+
+  writeBuffer() ;
+  fclose (segmentFile_) ;
+  segmentFile_ = NULL ;
+
+  const Segment &segment = segments_.back() ;
+  errno = 0 ;
+  std::ofstream index ((directory_ + "/" DCUHISTORY_INDEX).c_str(), std::ios::app) ;
+  index << segment.fileName << " " << segment.timeStart << " " << segment.timeStop << " " << segment.points << std::endl ;
+  if (!index) raiseFileError ("cannot write the index of the DCU history", directory_ + "/" DCUHISTORY_INDEX) ;
+  segmentNumber_ ++ ;
+}
+
+/** The values held are stored, the next values are compressed from them
+ */
+void DcuHistoryStore::flush ( ) throw (FecExceptionHandler) {
+
+  DcuHistoryLock lock (mutex_) ;
+  for (Sgi::hash_map<unsigned long, DcuState>::iterator it = dcuStates_.begin() ; it != dcuStates_.end() ; it ++) {
+    for (unsigned int i = 0 ; i < DCUHISTORY_CHANNELS ; i ++) {
+      ChannelState &channel = it->second.channels[i] ;
+      if (channel.heldTime == channel.storedTime) continue ;
+      storePoint (it->first, i, channel.heldTime, channel.heldValue) ;
+      channel.storedTime = channel.heldTime ;
+      channel.storedValue = channel.heldValue ;
+      channel.slopeMin = -HUGE_VAL ;
+      channel.slopeMax = HUGE_VAL ;
+    }
+  }
+  writeBuffer() ;
+}
+
+/**
+ * \param segment - segment
+ * \param dcuHardId - DCU hardware id, 0 for all
+ * \param channel - channel, DCUHISTORY_CHANNELS for all
+ * \param timeStart - start of the time range
+ * \param timeStop - end of the time range (excluded)
+ * \param points - points found
+ */
+void DcuHistoryStore::readSegment ( const Segment &segment, tscType32 dcuHardId, unsigned int channel, tscType32 timeStart, tscType32 timeStop,
+				    std::vector<DcuHistoryPoint> &points ) throw (FecExceptionHandler) {
+
+  std::string fileName = directory_ + "/" + segment.fileName ;
+  errno = 0 ;
+  FILE *file = fopen (fileName.c_str(), "rb") ;
+  if (file == NULL) raiseFileError ("cannot read the DCU history segment", fileName) ;
+
+  unsigned char buffer[DCUHISTORY_POINTSIZE * DCUHISTORY_READPOINTS] ;
+  size_t size ;
+  while ((size = fread (buffer, DCUHISTORY_POINTSIZE, DCUHISTORY_READPOINTS, file)) > 0) {
+    for (unsigned char *point = buffer ; point < buffer + size * DCUHISTORY_POINTSIZE ; point += DCUHISTORY_POINTSIZE) {
+      DcuHistoryPoint p ;
+      p.dcuHardId = getWord (point) ;
+      if (dcuHardId && (p.dcuHardId != dcuHardId)) continue ;
+      p.channel = point[10] ;
+      if ((channel != DCUHISTORY_CHANNELS) && (p.channel != channel)) continue ;
+      p.timeStamp = getWord (point + 4) ;
+      if ((p.timeStamp < timeStart) || (p.timeStamp >= timeStop)) continue ;
+      p.value = point[8] | (point[9] << 8) ;
+      points.push_back (p) ;
+    }
+  }
+  fclose (file) ;
+}
+
+/** The segments of the time range are read, the value held is added if it is not stored
+ * \param dcuHardId - DCU hardware id
+ * \param channel - channel
+ * \param timeStart - start of the time range
+ * \param timeStop - end of the time range (excluded)
+ * \param points - points found sorted by time
+ */
+void DcuHistoryStore::getPoints ( tscType32 dcuHardId, unsigned int channel, tscType32 timeStart, tscType32 timeStop, std::vector<DcuHistoryPoint> &points ) throw (FecExceptionHandler) {
+
+  checkChannel (channel) ;
+
+  DcuHistoryLock lock (mutex_) ;
+  writeBuffer() ;
+
+  for (std::vector<Segment>::iterator it = segments_.begin() ; it != segments_.end() ; it ++) {
+    if ((it->timeStop < timeStart) || (it->timeStart >= timeStop)) continue ;
+    readSegment (*it, dcuHardId, channel, timeStart, timeStop, points) ;
+  }
+
+  Sgi::hash_map<unsigned long, DcuState>::iterator it = dcuStates_.find (dcuHardId) ;
+  if (it != dcuStates_.end()) {
+    ChannelState &state = it->second.channels[channel] ;
+    if ((state.heldTime != state.storedTime) && (state.heldTime >= timeStart) && (state.heldTime < timeStop)) {
+      DcuHistoryPoint p ;
+      p.dcuHardId = dcuHardId ;
+      p.channel = channel ;
+      p.timeStamp = state.heldTime ;
+      p.value = state.heldValue ;
+      points.push_back (p) ;
+    }
+  }
+
+  std::stable_sort (points.begin(), points.end(), sortPointByTime) ;
+}
+
+/** Aggregate of points sorted by time
+ */
+static DcuHistoryAggregate buildAggregate ( tscType32 timeStart, tscType32 timeStop, std::vector<DcuHistoryPoint>::iterator first, std::vector<DcuHistoryPoint>::iterator last ) {
+
+  DcuHistoryAggregate aggregate ;
+  aggregate.timeStart = timeStart ;
+  aggregate.timeStop = timeStop ;
+  aggregate.points = last - first ;
+  aggregate.min = aggregate.max = aggregate.last = 0 ;
+  aggregate.mean = 0 ;
+  if (first == last) return aggregate ;
+
+  aggregate.min = aggregate.max = first->value ;
+  double sum = 0, integral = 0 ;
+  for (std::vector<DcuHistoryPoint>::iterator it = first ; it != last ; it ++) {
+    if (it->value < aggregate.min) aggregate.min = it->value ;
+    if (it->value > aggregate.max) aggregate.max = it->value ;
+    sum += it->value ;
+    if (it != first) integral += ((double)(it-1)->value + it->value) / 2 * (it->timeStamp - (it-1)->timeStamp) ;
+  }
+  aggregate.last = (last-1)->value ;
+
+  tscType32 duration = (last-1)->timeStamp - first->timeStamp ;
+  aggregate.mean = duration ? integral / duration : sum / aggregate.points ;
+
+  return aggregate ;
+}
+
+/**
+ * \param dcuHardId - DCU hardware id
+ * \param channel - channel
+ * \param timeStart - start of the time range
+ * \param timeStop - end of the time range (excluded)
+ * \return aggregate of the points of the time range
+ */
+DcuHistoryAggregate DcuHistoryStore::getAggregate ( tscType32 dcuHardId, unsigned int channel, tscType32 timeStart, tscType32 timeStop ) throw (FecExceptionHandler) {
+
+  std::vector<DcuHistoryPoint> points ;
+  getPoints (dcuHardId, channel, timeStart, timeStop, points) ;
+  return buildAggregate (timeStart, timeStop, points.begin(), points.end()) ;
+}
+
+/**
+ * \param dcuHardId - DCU hardware id
+ * \param channel - channel
+ * \param timeStart - start of the time range
+ * \param timeStop - end of the time range (excluded)
+ * \param window - size of the windows in seconds, the last window can be shorter
+ * \return aggregate of each window
+ */
+std::vector<DcuHistoryAggregate> DcuHistoryStore::getAggregates ( tscType32 dcuHardId, unsigned int channel, tscType32 timeStart, tscType32 timeStop, tscType32 window ) throw (FecExceptionHandler) {
+
+  if (window == 0) RAISEFECEXCEPTIONHANDLER ( TSCFEC_INVALIDOPERATION, "invalid window of 0 s for the DCU history", ERRORCODE ) ;
+
+  std::vector<DcuHistoryPoint> points ;
+  getPoints (dcuHardId, channel, timeStart, timeStop, points) ;
+
+  std::vector<DcuHistoryAggregate> aggregates ;
+  std::vector<DcuHistoryPoint>::iterator first = points.begin() ;
+  for (tscType32 start = timeStart ; (start < timeStop) && (start >= timeStart) ; start += window) {
+    tscType32 stop = (timeStop - start > window) ? start + window : timeStop ;
+    std::vector<DcuHistoryPoint>::iterator last = first ;
+    while ((last != points.end()) && (last->timeStamp < stop)) last ++ ;
+    aggregates.push_back (buildAggregate (start, stop, first, last)) ;
+    first = last ;
+  }
+
+  return aggregates ;
+}
@@ -0,0 +1,298 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Copyright 2002 - 2003, Frederic DROUHIN - Universite de Haute-Alsace, Mulhouse-France
+*/
+#include <algorithm>
+
+#include "apvDescription.h"
+#include "pllDescription.h"
+#include "muxDescription.h"
+#include "laserdriverDescription.h"
+#include "philipsDescription.h"
+
+#include "DeviceDescriptionPool.h"
+
+/** Empty pool
+ */
+DeviceDescriptionPool::DeviceDescriptionPool ( ) {
+}
+
+/** All the handles given before are not valid anymore
+ */
+void DeviceDescriptionPool::clear ( ) {
+
+  strings_.clear() ; stringIndex_.clear() ;
+  registers_.clear() ; registerIndex_.clear() ;
+}
+
+/**
+ * \param value - value to be stored
+ * \param values - values already stored
+ * \param index - handle of each value
+ * \return handle of the value
+ */
+internHandleType DeviceDescriptionPool::internValue ( const std::string &value, std::vector<std::string> &values, std::map<std::string, internHandleType> &index ) {
+
+  std::map<std::string, internHandleType>::iterator it = index.find (value) ;
+  if (it != index.end()) return it->second ;
+
+  internHandleType handle = values.size() ;
+  values.push_back (value) ;
+  index[value] = handle ;
+  return handle ;
+}
+
+/**
+ * \param value - string to be stored
+ * \return handle of the string
+ */
+internHandleType DeviceDescriptionPool::internString ( const std::string &value ) {
+
+  return internValue (value, strings_, stringIndex_) ;
+}
+
+/**
+ * \param handle - handle given by internString
+ * \return string
+ * \exception FecExceptionHandler
+ */
+const std::string &DeviceDescriptionPool::getString ( internHandleType handle ) throw (FecExceptionHandler) {
+
+  if (handle >= strings_.size())
+    RAISEFECEXCEPTIONHANDLER (CODECONSISTENCYERROR, "invalid string handle " + toString(handle), ERRORCODE) ;
+
+  return strings_[handle] ;
+}
+
+/**
+ * \param values - register values, the first byte is the device type
+ * \return handle of the values
+ */
+internHandleType DeviceDescriptionPool::internRegisters ( const std::string &values ) {
+
+  return internValue (values, registers_, registerIndex_) ;
+}
+
+/**
+ * \param handle - handle given by internRegisters
+ * \return register values
+ * \exception FecExceptionHandler
+ */
+const std::string &DeviceDescriptionPool::getRegisters ( internHandleType handle ) throw (FecExceptionHandler) {
+
+  if (handle >= registers_.size())
+    RAISEFECEXCEPTIONHANDLER (CODECONSISTENCYERROR, "invalid register handle " + toString(handle), ERRORCODE) ;
+
+  return registers_[handle] ;
+}
+
+/** The register values are stored in a string starting with the device type
+ * \param device - device to be stored
+ * \param interned - result
+ * \return false if the device type is not interned
+ */
+bool DeviceDescriptionPool::intern ( deviceDescription *device, internedDeviceType &interned ) {
+
+  std::string values (1, (char)device->getDeviceType()) ;
+
+  switch (device->getDeviceType()) {
+  case APV25: {
+    apvDescription *apv = (apvDescription *)device ;
+    tscType8 registers[] = { apv->getApvMode(), apv->getLatency(), apv->getMuxGain(), apv->getIpre(), apv->getIpcasc(),
+			     apv->getIpsf(), apv->getIsha(), apv->getIssf(), apv->getIpsp(), apv->getImuxin(), apv->getIcal(),
+			     apv->getIspare(), apv->getVfp(), apv->getVfs(), apv->getVpsp(), apv->getCdrv(), apv->getCsel(),
+			     apv->getApvError() } ;
+    values.append ((const char *)registers, sizeof(registers)) ;
+    break ;
+  }
+  case PLL: {
+    pllDescription *pll = (pllDescription *)device ;
+    tscType8 registers[] = { pll->getClockPhase(), pll->getTriggerDelay(), pll->getPllDac() } ;
+    values.append ((const char *)registers, sizeof(registers)) ;
+    break ;
+  }
+  case APVMUX: {
+    tscType16 resistor = ((muxDescription *)device)->getResistor() ;
+    values.push_back ((char)(resistor >> 8)) ;
+    values.push_back ((char)(resistor & 0xFF)) ;
+    break ;
+  }
+  case LASERDRIVER:
+  case DOH: {
+    laserdriverDescription *laserdriver = (laserdriverDescription *)device ;
+    tscType8 registers[] = { laserdriver->getBias0(), laserdriver->getBias1(), laserdriver->getBias2(),
+			     laserdriver->getGain0(), laserdriver->getGain1(), laserdriver->getGain2() } ;
+    values.append ((const char *)registers, sizeof(registers)) ;
+    break ;
+  }
+  case PHILIPS:
+    values.push_back ((char)((philipsDescription *)device)->getRegister()) ;
+    break ;
+  default:
+    return false ;
+  }
+
+  interned.accessKey = device->getKey() ;
+  interned.fecHardwareId = internString (device->getFecHardwareId()) ;
+  interned.registers = internRegisters (values) ;
+  interned.crateId = device->getCrateId() ;
+  interned.vmeControllerDaisyChainId = device->getVMEControllerDaisyChainId() ;
+  interned.deviceType = (tscType8)device->getDeviceType() ;
+  interned.enabled = device->getEnabled() ;
+
+  return true ;
+}
+
+/**
+ * \param src - devices to be stored
+ * \param dst - devices interned
+ * \param notInterned - if not NULL, the devices which are not interned are added (the pointers are copied)
+ * \param allDevices - also the devices disabled
+ */
+void DeviceDescriptionPool::intern ( deviceVector &src, internedDeviceVector &dst, deviceVector *notInterned, bool allDevices ) {
+
+  dst.reserve (dst.size() + src.size()) ;
+
+  internedDeviceType interned ;
+  for (deviceVector::iterator device = src.begin() ; device != src.end() ; device ++) {
+
+    if (!allDevices && !(*device)->isEnabled()) continue ;
+
+    if (intern (*device, interned)) dst.push_back (interned) ;
+    else if (notInterned != NULL) notInterned->push_back (*device) ;
+  }
+}
+
+/**
+ * \param interned - device interned by this pool
+ * \return new description
+ * \exception FecExceptionHandler
+ */
+deviceDescription *DeviceDescriptionPool::build ( const internedDeviceType &interned ) throw (FecExceptionHandler) {
+
+  const std::string &values = getRegisters (interned.registers) ;
+  const tscType8 *r = (const tscType8 *)values.data() + 1 ;
+  deviceDescription *device = NULL ;
+
+  switch (interned.deviceType) {
+  case APV25:
+    if (values.size() == 19)
+      device = new apvDescription (interned.accessKey, r[0], r[1], r[2], r[3], r[4], r[5], r[6], r[7], r[8],
+				   r[9], r[10], r[11], r[12], r[13], r[14], r[15], r[16], r[17]) ;
+    break ;
+  case PLL:
+    if (values.size() == 4)
+      device = new pllDescription (interned.accessKey, r[0], r[1], r[2]) ;
+    break ;
+  case APVMUX:
+    if (values.size() == 3)
+      device = new muxDescription (interned.accessKey, (tscType16)((r[0] << 8) | r[1])) ;
+    break ;
+  case LASERDRIVER:
+  case DOH:
+    if (values.size() == 7) {
+      device = new laserdriverDescription (interned.accessKey, r[0], r[1], r[2], r[3], r[4], r[5]) ;
+      if (interned.deviceType == DOH) device->setDeviceType (DOH) ;
+    }
+    break ;
+  case PHILIPS:
+    if (values.size() == 2)
+      device = new philipsDescription (interned.accessKey, r[0]) ;
+    break ;
+  }
+
+  if (device == NULL)
+    RAISEFECEXCEPTIONHANDLER (CODECONSISTENCYERROR, "register values do not match the device type " + toString((int)interned.deviceType), ERRORCODE) ;
+
+  device->setFecHardwareId (getString (interned.fecHardwareId), interned.crateId) ;
+  device->setVMEControllerDaisyChainId (interned.vmeControllerDaisyChainId) ;
+  device->setEnabled (interned.enabled) ;
+
+  return device ;
+}
+
+/**
+ * \param src - devices interned by this pool
+ * \param dst - descriptions built
+ * \exception FecExceptionHandler, the descriptions already built are kept in dst
+ */
+void DeviceDescriptionPool::build ( internedDeviceVector &src, deviceVector &dst ) throw (FecExceptionHandler) {
+
+  dst.reserve (dst.size() + src.size()) ;
+  for (internedDeviceVector::iterator device = src.begin() ; device != src.end() ; device ++)
+    dst.push_back (build (*device)) ;
+}
+
+/** The devices are matched by key and by type
+ * \param reference - reference values
+ * \param values - values to be compared
+ * \param differences - keys of the devices which are different or which are only in one of the vectors
+ * \return number of differences
+ */
+unsigned int DeviceDescriptionPool::compare ( internedDeviceVector &reference, internedDeviceVector &values, std::vector<keyType> &differences ) {
+
+  unsigned int nDifferences = 0 ;
+
+  // Sorted index of the reference: key, type, position
+  std::vector< std::pair<unsigned long long, unsigned int> > index (reference.size()) ;
+  for (unsigned int i = 0 ; i < reference.size() ; i ++)
+    index[i] = std::make_pair (((unsigned long long)reference[i].accessKey << 8) | reference[i].deviceType, i) ;
+  std::sort (index.begin(), index.end()) ;
+
+  std::vector<bool> found (reference.size(), false) ;
+  for (internedDeviceVector::iterator device = values.begin() ; device != values.end() ; device ++) {
+
+    std::pair<unsigned long long, unsigned int> value (((unsigned long long)device->accessKey << 8) | device->deviceType, 0) ;
+    std::vector< std::pair<unsigned long long, unsigned int> >::iterator it = std::lower_bound (index.begin(), index.end(), value) ;
+    if ((it == index.end()) || (it->first != value.first)) {
+      differences.push_back (device->accessKey) ;
+      nDifferences ++ ;
+    }
+    else {
+      found[it->second] = true ;
+      if (!equalRegisters (reference[it->second], *device)) {
+	differences.push_back (device->accessKey) ;
+	nDifferences ++ ;
+      }
+    }
+  }
+
+  for (unsigned int i = 0 ; i < reference.size() ; i ++) {
+    if (!found[i]) {
+      differences.push_back (reference[i].accessKey) ;
+      nDifferences ++ ;
+    }
+  }
+
+  return nDifferences ;
+}
+
+/**
+ * \return memory used by the values and the indexes in bytes
+ */
+unsigned long DeviceDescriptionPool::getMemorySize ( ) {
+
+  unsigned long size = 0 ;
+  // value in the vector and in the index, node of the map
+  for (std::vector<std::string>::iterator it = strings_.begin() ; it != strings_.end() ; it ++)
+    size += 2 * (sizeof(std::string) + it->capacity()) + sizeof(internHandleType) + 4*sizeof(void *) ;
+  for (std::vector<std::string>::iterator it = registers_.begin() ; it != registers_.end() ; it ++)
+    size += 2 * (sizeof(std::string) + it->capacity()) + sizeof(internHandleType) + 4*sizeof(void *) ;
+
+  return size ;
+}
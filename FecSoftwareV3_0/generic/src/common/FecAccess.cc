@@ -4186,6 +4186,57 @@ unsigned int FecAccess::setBlockDevices ( accessDeviceTypeListMap &hAccesses, st
   return (error) ;
 }
 
+/** Write a block of devices into the hardware for i2c or PIA channels, the errors of the frames are recorded without exceptions
+ * \param index - index of the ring
+ * \param vAccessDevices - list of frames
+ * \param errorRecorder - recorder of the errors, the errors of the ring are also given to the recorder
+ * \param piaChannel - by default false, used to set to false the force acknowledge
+ * \return number of errors
+ */
+unsigned int FecAccess::setBlockDevices ( keyType index, accessDeviceTypeList &vAccessDevices, FecErrorRecorder &errorRecorder, bool piaChannel ) {
+
+  unsigned int error = 0 ;
+
+  if (vAccessDevices.size()) {
+    try {
+      // Retreive the corresponding FecRingDevice
+      FecRingDevice *fec = getFecRingDevice ( index ) ;
+      fec->setBlockDevices (vAccessDevices, (forceChannelAck_ & !piaChannel), &errorRecorder ) ;
+    }
+    catch (FecExceptionHandler &e) {
+      errorRecorder.addException (e.clone()) ;
+      error ++ ;
+    }
+
+    // Collect the errors
+    error += DeviceFrame::decodeErrorFrame ( vAccessDevices, errorRecorder ) ;
+  }
+
+  return (error) ;
+}
+
+/** Send over the rings the multiple frames block, the errors of the frames are recorded without exceptions
+ * \param hAccesses - hash_table with the block for each ring
+ * \param errorRecorder - recorder of the errors, the errors of the rings are also given to the recorder
+ * \param piaChannel - by default false, used to set to false the force acknowledge
+ * \return the number of error
+ */
+unsigned int FecAccess::setBlockDevices ( accessDeviceTypeListMap &hAccesses, FecErrorRecorder &errorRecorder, bool piaChannel ) {
+
+  std::list<FecExceptionHandler *> errorList ; // not used
+
+  if ((fecRingEnable_.size() > 0) && (fecRingEnable_.begin()->second->getFecFirmwareVersion() >= MINFIRMWAREVERSION))
+    return setBlockDevicesParallel ( hAccesses, errorList, &errorRecorder, piaChannel, false ) ;
+
+  unsigned int error = 0 ;
+  for (accessDeviceTypeListMap::iterator vAccesses = hAccesses.begin() ; vAccesses != hAccesses.end() ; vAccesses ++) {
+    if (vAccesses->second.size() > 0)
+      error += setBlockDevices( buildFecRingKey(getFecKey(vAccesses->first),getRingKey(vAccesses->first)), vAccesses->second, errorRecorder, piaChannel ) ;
+  }
+
+  return (error) ;
+}
+
 /** Send over the ring the multiple frames block and decode the error afterwards. 
  * This method compare to the previous one make the send of the frames in parallel on several rings.
  * \param hAccesses - hash_table with the block for each ring
@@ -4194,6 +4245,19 @@ unsigned int FecAccess::setBlockDevices ( accessDeviceTypeListMap &hAccesses, st
  * \return the number of error
  */
 unsigned int FecAccess::setBlockDevicesParallel ( accessDeviceTypeListMap &hAccesses, std::list<FecExceptionHandler *> &errorList, bool piaChannel, bool debugMessageDisplay ) {
+
+  return setBlockDevicesParallel ( hAccesses, errorList, NULL, piaChannel, debugMessageDisplay ) ;
+}
+
+/** Send over the ring the multiple frames block in parallel on several rings and decode the error afterwards.
+ * \param hAccesses - hash_table with the block for each ring
+ * \param errorList - list of exceptions if no recorder is given
+ * \param errorRecorder - recorder of the errors or NULL
+ * \param piaChannel - used to set to false the force acknowledge
+ * \param debugMessageDisplay - display the accesses without error
+ * \return the number of error
+ */
+unsigned int FecAccess::setBlockDevicesParallel ( accessDeviceTypeListMap &hAccesses, std::list<FecExceptionHandler *> &errorList, FecErrorRecorder *errorRecorder, bool piaChannel, bool debugMessageDisplay ) {
   //std::cout << "FecAccess::setBlockDevicesParallel" << std::endl ; 
 
   unsigned int error = 0 ;
@@ -4240,7 +4304,8 @@ unsigned int FecAccess::setBlockDevicesParallel ( accessDeviceTypeListMap &hAcce
 	catch (FecExceptionHandler &e) {
 
 	  FecExceptionHandler *eClone = e.clone() ;
-	  errorList.push_back(eClone) ;
+	  if (errorRecorder != NULL) errorRecorder->addException(eClone) ;
+	  else errorList.push_back(eClone) ;
 
 	  endTransactionRing[getFecKey(vAccesses->first)][getRingKey(vAccesses->first)] = 1 ;
 	}
@@ -4282,7 +4347,7 @@ unsigned int FecAccess::setBlockDevicesParallel ( accessDeviceTypeListMap &hAcce
 	    if ( busy[getFecRingCcuChannelKey(itAccessDevice->index)] && 
 		 (time(NULL) > (busy[getFecRingCcuChannelKey(itAccessDevice->index)]+2)) ) {
 	      // Timeout on the direct acknowledge
-	      std::string errorMsg = "Timeout reached on the direct acknowledge" ;
+	      const char *errorMsg = "Timeout reached on the direct acknowledge" ;
 	      DD_TYPE_ERROR lcl_err = DD_WRITE_OPERATION_FAILED ;
 	      // timeout on the force acknowledge
 	      if (itAccessDevice->dAck != 0) {
@@ -4291,10 +4356,11 @@ unsigned int FecAccess::setBlockDevicesParallel ( accessDeviceTypeListMap &hAcce
 	      }
 	      
 	      // Set the error
-	      itAccessDevice->e = NEWFECEXCEPTIONHANDLER_HARDPOSITION (lcl_err,
-								       errorMsg,
-								       ERRORCODE,
-								       itAccessDevice->index) ;
+	      itAccessDevice->e = NEWFRAMEERROR (errorRecorder,
+						 lcl_err,
+						 errorMsg,
+						 ERRORCODE,
+						 itAccessDevice->index, *itAccessDevice, "Not filled", 0) ;
 
 	      busy[getFecRingCcuChannelKey(itAccessDevice->index)] = 0 ;
 
@@ -4432,7 +4498,8 @@ unsigned int FecAccess::setBlockDevicesParallel ( accessDeviceTypeListMap &hAcce
 #endif
 
 	      FecExceptionHandler *eClone = e.clone() ;
-	      errorList.push_back(eClone) ;
+	      if (errorRecorder != NULL) errorRecorder->addException(eClone) ;
+	      else errorList.push_back(eClone) ;
 	      
 	      endTransactionRing[getFecKey(vAccesses->first)][getRingKey(vAccesses->first)] = 1 ;
 	    }
@@ -4466,14 +4533,15 @@ unsigned int FecAccess::setBlockDevicesParallel ( accessDeviceTypeListMap &hAcce
 	  // **************************************************************************
 	  if (tnumSent[getFecKey(vAccesses->first)][getRingKey(vAccesses->first)].size()) {
 
-	    fecRingDevice->getBlockFrames (forceChannelAck_ && !piaChannel, tnumSent[getFecKey(vAccesses->first)][getRingKey(vAccesses->first)], busy, cptRead[getFecKey(vAccesses->first)][getRingKey(vAccesses->first)] ) ;
+	    fecRingDevice->getBlockFrames (forceChannelAck_ && !piaChannel, tnumSent[getFecKey(vAccesses->first)][getRingKey(vAccesses->first)], busy, cptRead[getFecKey(vAccesses->first)][getRingKey(vAccesses->first)], errorRecorder ) ;
 	    // fecRingDevice->checkRing() ;
 	  }
 	}
 	catch (FecExceptionHandler &e) {
 
 	  FecExceptionHandler *eClone = e.clone() ;
-	  errorList.push_back(eClone) ;
+	  if (errorRecorder != NULL) errorRecorder->addException(eClone) ;
+	  else errorList.push_back(eClone) ;
 
 	  endTransactionRing[getFecKey(vAccesses->first)][getRingKey(vAccesses->first)] = 1 ;
 	}
@@ -4503,7 +4571,8 @@ unsigned int FecAccess::setBlockDevicesParallel ( accessDeviceTypeListMap &hAcce
   for (accessDeviceTypeListMap::iterator vAccesses = hAccesses.begin() ; vAccesses != hAccesses.end() ; vAccesses ++) {
     if (vAccesses->second.size()) {
       // Collect the errors
-      error += DeviceFrame::decodeErrorFrame ( vAccesses->second, errorList, debugMessageDisplay ) ;
+      if (errorRecorder != NULL) error += DeviceFrame::decodeErrorFrame ( vAccesses->second, *errorRecorder ) ;
+      else error += DeviceFrame::decodeErrorFrame ( vAccesses->second, errorList, debugMessageDisplay ) ;
     }
   }
 
@@ -1460,7 +1460,7 @@ unsigned int FecAccessManager::downloadValuesMultipleFrames ( deviceVector *vDev
 
     // ---------------------------------------------------------------------------------------------------------------------------
     // Make the download and decode the errors
-    error += fecAccess_->setBlockDevices( vAccessDevices, errorList ) ;
+    error += setBlockDevices( vAccessDevices, errorList ) ;
 
     // Read out the DCU for tests
     //deviceVector dcuVector ;
@@ -1484,6 +1484,21 @@ unsigned int FecAccessManager::downloadValuesMultipleFrames ( deviceVector *vDev
   return (error) ;
 }
 
+/** When a ring fails, each frame gives an error: the errors are recorded without exception
+ * during the transfer and then given to the list: the errors of the rings and one exception per frame in error.
+ * \param vAccessDevices - block of frames for each ring
+ * \param errorList - list of exceptions, the exceptions must be deleted by the caller
+ * \return number of frames in error
+ */
+unsigned int FecAccessManager::setBlockDevices ( accessDeviceTypeListMap &vAccessDevices, std::list<FecExceptionHandler *> &errorList ) {
+
+  FecErrorRecorder errorRecorder ;
+  unsigned int error = fecAccess_->setBlockDevices( vAccessDevices, errorRecorder ) ;
+  if (error) errorRecorder.getErrorList ( errorList ) ;
+
+  return (error) ;
+}
+
 /** Download the values only for certain APV registers on all APVs
  * \param apvValues - parameters to be set (description)
  * \param apvMode - register of the APV (true = set it, false do not set it)
@@ -1554,7 +1569,7 @@ unsigned int FecAccessManager::downloadValuesMultipleFrames ( apvDescription apv
 
   // ---------------------------------------------------------------------------------------------------------------------------
   // Make the download and decode the errors
-  error += fecAccess_->setBlockDevices( vAccessDevices, errorList ) ;
+  error += setBlockDevices( vAccessDevices, errorList ) ;
 
   // Number of errors
   lastOperationNumberErrors_ = error ;
@@ -1587,7 +1602,7 @@ unsigned int FecAccessManager::downloadValuesMultipleFrames ( laserdriverDescrip
 
   // ---------------------------------------------------------------------------------------------------------------------------
   // Make the download and decode the errors
-  error += fecAccess_->setBlockDevices( vAccessDevices, errorList ) ;
+  error += setBlockDevices( vAccessDevices, errorList ) ;
 
   // Number of errors
   lastOperationNumberErrors_ = error ;
@@ -1620,7 +1635,7 @@ unsigned int FecAccessManager::downloadValuesMultipleFrames ( muxDescription mux
 
   // ---------------------------------------------------------------------------------------------------------------------------
   // Make the download and decode the errors
-  error += fecAccess_->setBlockDevices( vAccessDevices, errorList ) ;
+  error += setBlockDevices( vAccessDevices, errorList ) ;
 
   // Number of errors
   lastOperationNumberErrors_ = error ;
@@ -1653,7 +1668,7 @@ unsigned int FecAccessManager::downloadValuesMultipleFrames ( pllDescription pll
 
   // ---------------------------------------------------------------------------------------------------------------------------
   // Make the download and decode the errors
-  error += fecAccess_->setBlockDevices( vAccessDevices, errorList ) ;
+  error += setBlockDevices( vAccessDevices, errorList ) ;
 
   // Number of errors
   lastOperationNumberErrors_ = error ;
@@ -1691,7 +1706,7 @@ unsigned int FecAccessManager::downloadValuesMultipleFrames ( tscType8 delay,
 
   // ---------------------------------------------------------------------------------------------------------------------------
   // Make the download and decode the errors
-  error += fecAccess_->setBlockDevices( vAccessDevices, errorList ) ;
+  error += setBlockDevices( vAccessDevices, errorList ) ;
 
   // Number of errors
   lastOperationNumberErrors_ = error ;
@@ -0,0 +1,312 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+#include <stdio.h>
+
+#include <algorithm>
+#include <sstream>
+
+#include "hashMapDefinition.h"
+
+#include "apvDescription.h"
+#include "pllDescription.h"
+#include "muxDescription.h"
+#include "laserdriverDescription.h"
+#include "philipsDescription.h"
+#include "dcuDescription.h"
+#include "deltaDescription.h"
+#include "paceDescription.h"
+#include "kchipDescription.h"
+#include "gohDescription.h"
+#include "esMbResetDescription.h"
+#include "delay25Description.h"
+
+#include "FecDeviceDiff.h"
+
+/** Sort the differences by key then by device type
+ */
+static bool sortDiffByKey ( const deviceDiffType &d1, const deviceDiffType &d2 ) {
+
+  if (d1.index != d2.index) return d1.index < d2.index ;
+  return d1.deviceType < d2.deviceType ;
+}
+
+/** Devices are identified by their crate and their key, a hash table is used for the matching
+ */
+typedef unsigned long long crateKeyType ;
+
+struct hashCrateKey {
+  size_t operator() ( crateKeyType key ) const { return (size_t)(key ^ (key >> 32)) ; }
+} ;
+
+static inline crateKeyType buildCrateKey ( tscType16 crateId, keyType index ) {
+
+  return ((crateKeyType)crateId << 32) | index ;
+}
+
+/** Device added or removed
+ */
+static deviceDiffType buildDiff ( keyType index, enumDeviceType deviceType, enumDeviceDiff diff ) {
+
+  deviceDiffType device ;
+  device.index = index ;
+  device.deviceType = deviceType ;
+  device.diff = diff ;
+  return device ;
+}
+
+/** Nothing
+ */
+FecDeviceDiff::FecDeviceDiff ( ): added_(0), removed_(0), modified_(0), devices_(0) {
+}
+
+/**
+ * \param reference - old version
+ * \param values - new version
+ */
+FecDeviceDiff::FecDeviceDiff ( deviceVector &reference, deviceVector &values ): added_(0), removed_(0), modified_(0), devices_(0) {
+
+  compare (reference, values) ;
+}
+
+/**
+ * \param diff - device modified
+ * \param registerName - parameter name
+ * \param oldValue - old value
+ * \param newValue - new value
+ */
+void FecDeviceDiff::addRegister ( deviceDiffType &diff, const char *registerName, unsigned int oldValue, unsigned int newValue ) {
+
+  registerDiffType reg ;
+  reg.registerName = registerName ;
+  reg.oldValue = oldValue ;
+  reg.newValue = newValue ;
+  diff.registers.push_back (reg) ;
+}
+
+/** The register values of the pool start with the device type, each register is one byte
+ * except the resistor of the APV MUX (two bytes).
+ * \param oldDevice - device of the reference
+ * \param newDevice - device of the new version
+ * \param diff - registers changed
+ */
+void FecDeviceDiff::compareRegisters ( const internedDeviceType &oldDevice, const internedDeviceType &newDevice, deviceDiffType &diff ) {
+
+  if (oldDevice.fecHardwareId != newDevice.fecHardwareId) {
+    registerDiffType reg ;
+    reg.registerName = deviceDescription::FECPARAMETERNAMES[deviceDescription::FECHARDWAREID] ;
+    reg.oldValue = reg.newValue = 0 ;
+    reg.oldText = pool_.getString (oldDevice.fecHardwareId) ;
+    reg.newText = pool_.getString (newDevice.fecHardwareId) ;
+    diff.registers.push_back (reg) ;
+  }
+  if (oldDevice.vmeControllerDaisyChainId != newDevice.vmeControllerDaisyChainId)
+    addRegister (diff, deviceDescription::FECPARAMETERNAMES[deviceDescription::VMECONTROLLERDAISYCHAINID], oldDevice.vmeControllerDaisyChainId, newDevice.vmeControllerDaisyChainId) ;
+  if (oldDevice.enabled != newDevice.enabled)
+    addRegister (diff, deviceDescription::FECPARAMETERNAMES[deviceDescription::ENABLED], oldDevice.enabled, newDevice.enabled) ;
+
+  if (oldDevice.registers == newDevice.registers) return ;
+
+  const std::string &oldValues = pool_.getRegisters (oldDevice.registers) ;
+  const std::string &newValues = pool_.getRegisters (newDevice.registers) ;
+  const tscType8 *o = (const tscType8 *)oldValues.data() + 1 ;
+  const tscType8 *n = (const tscType8 *)newValues.data() + 1 ;
+
+  const char **names = NULL ;
+  unsigned int number = 0 ;
+  switch (newDevice.deviceType) {
+  case APV25: names = apvDescription::APVPARAMETERNAMES ; number = apvDescription::APVERROR + 1 ; break ;
+  case PLL: names = pllDescription::PLLPARAMETERNAMES ; number = pllDescription::PLLDAC + 1 ; break ;
+  case LASERDRIVER:
+  case DOH: names = laserdriverDescription::LASERDRIVERPARAMETERNAMES ; number = laserdriverDescription::GAIN2 + 1 ; break ;
+  case PHILIPS: names = philipsDescription::PHILIPSPARAMETERNAMES ; number = 1 ; break ;
+  case APVMUX:
+    addRegister (diff, muxDescription::MUXPARAMETERNAMES[muxDescription::RESISTOR], (o[0] << 8) | o[1], (n[0] << 8) | n[1]) ;
+    return ;
+  }
+
+  for (unsigned int i = 0 ; (i < number) && (i + 1 < oldValues.size()) && (i + 1 < newValues.size()) ; i ++)
+    if (o[i] != n[i]) addRegister (diff, names[i], o[i], n[i]) ;
+}
+
+/** The devices which are not interned are compared with the operator of their description.
+ * \param oldDevice - device of the reference
+ * \param newDevice - device of the new version, same type
+ * \return true if the devices are different or if the type cannot be compared (VFAT, CChip, TBB, ...)
+ */
+static bool otherDevicesDiffer ( deviceDescription *oldDevice, deviceDescription *newDevice ) {
+
+  switch (newDevice->getDeviceType()) {
+  case DCU: return *((dcuDescription *)oldDevice) != *((dcuDescription *)newDevice) ;
+  case DELTA: return *((deltaDescription *)oldDevice) != *((deltaDescription *)newDevice) ;
+  case PACE: return *((paceDescription *)oldDevice) != *((paceDescription *)newDevice) ;
+  case KCHIP: return *((kchipDescription *)oldDevice) != *((kchipDescription *)newDevice) ;
+  case GOH: return *((gohDescription *)oldDevice) != *((gohDescription *)newDevice) ;
+  case ESMBRESET: return !(*((esMbResetDescription *)oldDevice) == *((esMbResetDescription *)newDevice)) ;
+  case DELAY25: return *((delay25Description *)oldDevice) != *((delay25Description *)newDevice) ;
+  default: return true ;
+  }
+}
+
+/** The devices are matched by crate and key through a hash table, the devices with the same key and a different type
+ * are removed and added.
+ * \param reference - old version
+ * \param values - new version
+ * \return number of devices added, removed or modified
+ */
+unsigned int FecDeviceDiff::compare ( deviceVector &reference, deviceVector &values ) {
+
+  differences_.clear() ;
+  added_ = removed_ = modified_ = 0 ;
+  devices_ = values.size() ;
+  pool_.clear() ;
+
+  internedDeviceVector oldDevices, newDevices ;
+  deviceVector oldOthers, newOthers ;
+  pool_.intern (reference, oldDevices, &oldOthers) ;
+  pool_.intern (values, newDevices, &newOthers) ;
+
+  // Interned devices
+  Sgi::hash_map<crateKeyType, unsigned int, hashCrateKey> index ;
+  for (unsigned int i = 0 ; i < oldDevices.size() ; i ++) index[buildCrateKey (oldDevices[i].crateId, oldDevices[i].accessKey)] = i ;
+
+  std::vector<bool> found (oldDevices.size(), false) ;
+  for (internedDeviceVector::iterator device = newDevices.begin() ; device != newDevices.end() ; device ++) {
+
+    Sgi::hash_map<crateKeyType, unsigned int, hashCrateKey>::iterator it = index.find (buildCrateKey (device->crateId, device->accessKey)) ;
+    if ((it != index.end()) && (oldDevices[it->second].deviceType == device->deviceType)) {
+      found[it->second] = true ;
+      const internedDeviceType &oldDevice = oldDevices[it->second] ;
+      if (DeviceDescriptionPool::equalRegisters (oldDevice, *device) && (oldDevice.fecHardwareId == device->fecHardwareId) &&
+	  (oldDevice.vmeControllerDaisyChainId == device->vmeControllerDaisyChainId) &&
+	  (oldDevice.enabled == device->enabled)) continue ;
+
+      deviceDiffType diff = buildDiff (device->accessKey, (enumDeviceType)device->deviceType, DEVICEMODIFIED) ;
+      compareRegisters (oldDevice, *device, diff) ;
+      differences_.push_back (diff) ;
+      modified_ ++ ;
+    }
+    else {
+      differences_.push_back (buildDiff (device->accessKey, (enumDeviceType)device->deviceType, DEVICEADDED)) ;
+      added_ ++ ;
+    }
+  }
+  for (unsigned int i = 0 ; i < oldDevices.size() ; i ++) {
+    if (!found[i]) {
+      differences_.push_back (buildDiff (oldDevices[i].accessKey, (enumDeviceType)oldDevices[i].deviceType, DEVICEREMOVED)) ;
+      removed_ ++ ;
+    }
+  }
+
+  // Other devices: compared through their description, the DCUs also give their hardware id
+  Sgi::hash_map<crateKeyType, deviceDescription *, hashCrateKey> others ;
+  for (deviceVector::iterator device = oldOthers.begin() ; device != oldOthers.end() ; device ++)
+    others[buildCrateKey ((*device)->getCrateId(), (*device)->getKey())] = *device ;
+  for (deviceVector::iterator device = newOthers.begin() ; device != newOthers.end() ; device ++) {
+
+    Sgi::hash_map<crateKeyType, deviceDescription *, hashCrateKey>::iterator it = others.find (buildCrateKey ((*device)->getCrateId(), (*device)->getKey())) ;
+    if ((it == others.end()) || (it->second->getDeviceType() != (*device)->getDeviceType())) {
+      differences_.push_back (buildDiff ((*device)->getKey(), (*device)->getDeviceType(), DEVICEADDED)) ;
+      added_ ++ ;
+      continue ;
+    }
+
+    deviceDiffType diff = buildDiff ((*device)->getKey(), (*device)->getDeviceType(), DEVICEMODIFIED) ;
+    if ((*device)->getDeviceType() == DCU) {
+      tscType32 oldHardId = ((dcuDescription *)it->second)->getDcuHardId() ;
+      tscType32 newHardId = ((dcuDescription *)*device)->getDcuHardId() ;
+      if (oldHardId != newHardId) addRegister (diff, "dcuHardId", oldHardId, newHardId) ;
+    }
+    if (it->second->getEnabled() != (*device)->getEnabled())
+      addRegister (diff, deviceDescription::FECPARAMETERNAMES[deviceDescription::ENABLED], it->second->getEnabled(), (*device)->getEnabled()) ;
+    if (diff.registers.empty() && otherDevicesDiffer (it->second, *device)) {
+      registerDiffType reg ;
+      reg.registerName = "registers" ;
+      reg.oldValue = reg.newValue = 0 ;
+      reg.oldText = "reference" ;
+      reg.newText = "modified or not compared" ;
+      diff.registers.push_back (reg) ;
+    }
+    if (!diff.registers.empty()) {
+      differences_.push_back (diff) ;
+      modified_ ++ ;
+    }
+    others.erase (it) ;
+  }
+  for (Sgi::hash_map<crateKeyType, deviceDescription *, hashCrateKey>::iterator it = others.begin() ; it != others.end() ; it ++) {
+    differences_.push_back (buildDiff (it->second->getKey(), it->second->getDeviceType(), DEVICEREMOVED)) ;
+    removed_ ++ ;
+  }
+
+  std::sort (differences_.begin(), differences_.end(), sortDiffByKey) ;
+
+  return differences_.size() ;
+}
+
+/**
+ * \param deviceType - device type
+ * \return name of the type
+ */
+std::string FecDeviceDiff::getDeviceTypeName ( enumDeviceType deviceType ) {
+
+  switch (deviceType) {
+  case PLL: return "PLL" ;
+  case LASERDRIVER: return "AOH" ;
+  case DOH: return "DOH" ;
+  case DCU: return "DCU" ;
+  case PHILIPS: return "PHILIPS" ;
+  case APVMUX: return "APVMUX" ;
+  case APV25: return "APV25" ;
+  default: {
+    std::ostringstream name ;
+    name << "device type " << (int)deviceType ;
+    return name.str() ;
+  }
+  }
+}
+
+/** One line for the counts, one line per device with the registers changed: name old -> new
+ * \param maximum - maximum number of devices displayed, 0 for all
+ */
+std::string FecDeviceDiff::getSummary ( unsigned int maximum ) {
+
+  static const char *diffNames[] = { "added", "removed", "modified" } ;
+
+  std::ostringstream summary ;
+  summary << added_ << " device(s) added, " << removed_ << " removed, " << modified_ << " modified over " << devices_ << " device(s)" << std::endl ;
+
+  unsigned int displayed = 0 ;
+  for (std::vector<deviceDiffType>::iterator it = differences_.begin() ; it != differences_.end() ; it ++, displayed ++) {
+
+    if (maximum && (displayed == maximum)) {
+      summary << "... " << differences_.size() - displayed << " other device(s)" << std::endl ;
+      break ;
+    }
+
+    char msg[256] ;
+    decodeKey (msg, it->index) ;
+    summary << diffNames[it->diff] << " " << getDeviceTypeName (it->deviceType) << " " << msg ;
+    for (std::vector<registerDiffType>::iterator reg = it->registers.begin() ; reg != it->registers.end() ; reg ++) {
+      summary << (reg == it->registers.begin() ? ": " : ", ") << reg->registerName << " " ;
+      if (reg->oldText.empty() && reg->newText.empty()) summary << reg->oldValue << " -> " << reg->newValue ;
+      else summary << reg->oldText << " -> " << reg->newText ;
+    }
+    summary << std::endl ;
+  }
+
+  return summary.str() ;
+}
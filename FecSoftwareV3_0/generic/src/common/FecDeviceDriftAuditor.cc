@@ -0,0 +1,556 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Copyright 2002 - 2003, Frederic DROUHIN - Universite de Haute-Alsace, Mulhouse-France
+*/
+#include <sys/time.h>   // For timestamps
+#include <string.h>
+#include <sstream>
+
+#include "FecDeviceDriftAuditor.h"
+
+/** Register of an APV: name of the parameter, value in the reference, read and write on the hardware
+ */
+typedef struct {
+  const char *name ;
+  tscType8 (apvDescription::*reference) ( ) ;
+  tscType8 (apvAccess::*read) ( ) ;
+  void (apvAccess::*write) ( tscType8 ) ;
+} apvDriftRegisterType ;
+
+/** Registers compared by apvDescription::operator!=, the error register is read only
+ */
+static apvDriftRegisterType apvDriftRegisters[] = {
+  { "apvMode", &apvDescription::getApvMode, &apvAccess::getApvMode, &apvAccess::setApvMode },
+  { "latency", &apvDescription::getLatency, &apvAccess::getLatency, &apvAccess::setLatency },
+  { "muxGain", &apvDescription::getMuxGain, &apvAccess::getMuxGain, &apvAccess::setMuxGain },
+  { "ipre",    &apvDescription::getIpre,    &apvAccess::getIpre,    &apvAccess::setIpre    },
+  { "ipcasc",  &apvDescription::getIpcasc,  &apvAccess::getIpcasc,  &apvAccess::setIpcasc  },
+  { "ipsf",    &apvDescription::getIpsf,    &apvAccess::getIpsf,    &apvAccess::setIpsf    },
+  { "isha",    &apvDescription::getIsha,    &apvAccess::getIsha,    &apvAccess::setIsha    },
+  { "issf",    &apvDescription::getIssf,    &apvAccess::getIssf,    &apvAccess::setIssf    },
+  { "ipsp",    &apvDescription::getIpsp,    &apvAccess::getIpsp,    &apvAccess::setIpsp    },
+  { "imuxin",  &apvDescription::getImuxin,  &apvAccess::getImuxin,  &apvAccess::setImuxin  },
+  { "ical",    &apvDescription::getIcal,    &apvAccess::getIcal,    &apvAccess::setIcal    },
+  { "ispare",  &apvDescription::getIspare,  &apvAccess::getIspare,  &apvAccess::setIspare  },
+  { "vfp",     &apvDescription::getVfp,     &apvAccess::getVfp,     &apvAccess::setVfp     },
+  { "vfs",     &apvDescription::getVfs,     &apvAccess::getVfs,     &apvAccess::setVfs     },
+  { "vpsp",    &apvDescription::getVpsp,    &apvAccess::getVpsp,    &apvAccess::setVpsp    },
+  { "cdrv",    &apvDescription::getCdrv,    &apvAccess::getCdrv,    &apvAccess::setCdrv    },
+  { "csel",    &apvDescription::getCsel,    &apvAccess::getCsel,    &apvAccess::setCsel    }
+} ;
+
+#define APVDRIFTREGISTERS (sizeof(apvDriftRegisters)/sizeof(apvDriftRegisterType))
+
+/** Find an APV register in the table
+ * \return NULL if the register is not an APV register
+ */
+static apvDriftRegisterType *findApvDriftRegister ( const char *registerName ) {
+
+  for (unsigned int i = 0 ; i < APVDRIFTREGISTERS ; i ++)
+    if (!strcmp (apvDriftRegisters[i].name, registerName)) return &apvDriftRegisters[i] ;
+  return NULL ;
+}
+
+/** Only the devices of an existing ring are given
+ * \param devices - type and index of the APV, PLL, laserdriver, DOH, APV MUX and Philips
+ */
+void FecDeviceDriftFecAccess::getDevices ( std::vector< std::pair<enumDeviceType, keyType> > &devices ) {
+
+  std::vector< std::pair<enumDeviceType, keyType> > all ;
+  for (apvAccessedType::iterator it = fecAccessManager_->getApvAccesses().begin() ; it != fecAccessManager_->getApvAccesses().end() ; it ++)
+    all.push_back (std::make_pair(APV25, it->first)) ;
+  for (pllAccessedType::iterator it = fecAccessManager_->getPllAccesses().begin() ; it != fecAccessManager_->getPllAccesses().end() ; it ++)
+    all.push_back (std::make_pair(PLL, it->first)) ;
+  for (laserdriverAccessedType::iterator it = fecAccessManager_->getLaserdriverAccesses().begin() ; it != fecAccessManager_->getLaserdriverAccesses().end() ; it ++)
+    all.push_back (std::make_pair(LASERDRIVER, it->first)) ;
+  for (dohAccessedType::iterator it = fecAccessManager_->getDOHAccesses().begin() ; it != fecAccessManager_->getDOHAccesses().end() ; it ++)
+    all.push_back (std::make_pair(DOH, it->first)) ;
+  for (muxAccessedType::iterator it = fecAccessManager_->getApvMuxAccesses().begin() ; it != fecAccessManager_->getApvMuxAccesses().end() ; it ++)
+    all.push_back (std::make_pair(APVMUX, it->first)) ;
+  for (philipsAccessedType::iterator it = fecAccessManager_->getPhilipsAccesses().begin() ; it != fecAccessManager_->getPhilipsAccesses().end() ; it ++)
+    all.push_back (std::make_pair(PHILIPS, it->first)) ;
+
+  for (std::vector< std::pair<enumDeviceType, keyType> >::iterator it = all.begin() ; it != all.end() ; it ++)
+    if (getFecRingDevice (getFecKeyRingKey(it->second)) != NULL) devices.push_back (*it) ;
+}
+
+/**
+ * \param ringIndex - FEC and ring
+ * \return NULL if the ring does not exist
+ */
+FecRingDevice *FecDeviceDriftFecAccess::getFecRingDevice ( keyType ringIndex ) {
+
+  try {
+    return fecAccessManager_->getFecAccess()->getFecRingDevice (ringIndex) ;
+  }
+  catch (FecExceptionHandler &e) { }
+
+  return NULL ;
+}
+
+/**
+ * \param ringIndex - FEC and ring
+ * \return false if the ring is used by another thread (download, upload, scan)
+ */
+bool FecDeviceDriftFecAccess::tryLockRing ( keyType ringIndex ) {
+
+  FecRingDevice *fecRingDevice = getFecRingDevice (ringIndex) ;
+  return (fecRingDevice != NULL) && fecRingDevice->tryLockRing() ;
+}
+
+/**
+ * \param ringIndex - FEC and ring
+ */
+void FecDeviceDriftFecAccess::unlockRing ( keyType ringIndex ) {
+
+  FecRingDevice *fecRingDevice = getFecRingDevice (ringIndex) ;
+  if (fecRingDevice != NULL) fecRingDevice->unlockRing() ;
+}
+
+/** The APVs are read register by register. The PLL, laserdriver, DOH, APV MUX and Philips are read with getValues.
+ * \param deviceType - type of the device
+ * \param index - index of the device
+ * \param registers - registers compared with the reference
+ * \return false if the device has no reference or is not audited
+ * \exception FecExceptionHandler
+ */
+bool FecDeviceDriftFecAccess::readRegisters ( enumDeviceType deviceType, keyType index, std::vector<driftRegisterType> &registers ) throw (FecExceptionHandler) {
+
+  deviceAccess *access = fecAccessManager_->getAccess (deviceType, index) ;
+  if ((access == NULL) || (access->getDownloadedValues() == NULL)) return false ;
+
+  switch (deviceType) {
+  case APV25: {
+    apvAccess *device = (apvAccess *)access ;
+    apvDescription reference (*((apvDescription *)device->getDownloadedValues())) ;
+    for (unsigned int i = 0 ; i < APVDRIFTREGISTERS ; i ++) {
+      driftRegisterType reg = { apvDriftRegisters[i].name, (reference.*(apvDriftRegisters[i].reference))(), (device->*(apvDriftRegisters[i].read))() } ;
+      registers.push_back (reg) ;
+    }
+    break ;
+  }
+  case PLL: {
+    pllAccess *device = (pllAccess *)access ;
+    pllDescription *reference = (pllDescription *)device->getDownloadedValues() ;
+    pllDescription *values = device->getValues() ;
+    driftRegisterType clockPhase = { "clockPhase", reference->getClockPhase(), values->getClockPhase() } ;
+    driftRegisterType triggerDelay = { "triggerDelay", reference->getTriggerDelay(), values->getTriggerDelay() } ;
+    registers.push_back (clockPhase) ;
+    registers.push_back (triggerDelay) ;
+    delete values ;
+    break ;
+  }
+  case LASERDRIVER:
+  case DOH: {
+    laserdriverDescription *reference = (laserdriverDescription *)access->getDownloadedValues() ;
+    laserdriverDescription *values = (deviceType == DOH) ? ((DohAccess *)access)->getValues() : ((laserdriverAccess *)access)->getValues() ;
+    driftRegisterType gain = { "gain", reference->getGain(), values->getGain() } ;
+    driftRegisterType bias0 = { "bias0", reference->getBias0(), values->getBias0() } ;
+    driftRegisterType bias1 = { "bias1", reference->getBias1(), values->getBias1() } ;
+    driftRegisterType bias2 = { "bias2", reference->getBias2(), values->getBias2() } ;
+    registers.push_back (gain) ;
+    registers.push_back (bias0) ;
+    registers.push_back (bias1) ;
+    registers.push_back (bias2) ;
+    delete values ;
+    break ;
+  }
+  case APVMUX: {
+    muxAccess *device = (muxAccess *)access ;
+    muxDescription *reference = (muxDescription *)device->getDownloadedValues() ;
+    muxDescription *values = device->getValues() ;
+    driftRegisterType resistor = { "resistor", reference->getResistor(), values->getResistor() } ;
+    registers.push_back (resistor) ;
+    delete values ;
+    break ;
+  }
+  case PHILIPS: {
+    philipsAccess *device = (philipsAccess *)access ;
+    philipsDescription *reference = (philipsDescription *)device->getDownloadedValues() ;
+    philipsDescription *values = device->getValues() ;
+    driftRegisterType reg = { "register", reference->getRegister(), values->getRegister() } ;
+    registers.push_back (reg) ;
+    delete values ;
+    break ;
+  }
+  default:
+    return false ;
+  }
+
+  return true ;
+}
+
+/**
+ * \param deviceType - type of the device, only the APV registers can be written one by one
+ * \param index - index of the device
+ * \param registerName - parameter name of the register
+ * \param value - value to be written
+ * \exception FecExceptionHandler
+ */
+void FecDeviceDriftFecAccess::writeRegister ( enumDeviceType deviceType, keyType index, const char *registerName, unsigned int value ) throw (FecExceptionHandler) {
+
+  apvDriftRegisterType *reg = findApvDriftRegister (registerName) ;
+  apvAccess *device = (apvAccess *)fecAccessManager_->getAccess (deviceType, index) ;
+  if ((deviceType == APV25) && (reg != NULL) && (device != NULL)) (device->*(reg->write))((tscType8)value) ;
+}
+
+/**
+ * \param deviceType - type of the device
+ * \param index - index of the device
+ * \exception FecExceptionHandler
+ */
+void FecDeviceDriftFecAccess::writeDevice ( enumDeviceType deviceType, keyType index ) throw (FecExceptionHandler) {
+
+  deviceAccess *access = fecAccessManager_->getAccess (deviceType, index) ;
+  if ((access == NULL) || (access->getDownloadedValues() == NULL)) return ;
+
+  switch (deviceType) {
+  case APV25: {
+    apvDescription reference (*((apvDescription *)access->getDownloadedValues())) ;
+    ((apvAccess *)access)->setValues (reference) ;
+    break ;
+  }
+  case PLL: {
+    pllDescription reference (*((pllDescription *)access->getDownloadedValues())) ;
+    ((pllAccess *)access)->setValues (reference) ;
+    break ;
+  }
+  case LASERDRIVER: {
+    laserdriverDescription reference (*((laserdriverDescription *)access->getDownloadedValues())) ;
+    ((laserdriverAccess *)access)->setValues (reference) ;
+    break ;
+  }
+  case DOH: {
+    laserdriverDescription reference (*((laserdriverDescription *)access->getDownloadedValues())) ;
+    ((DohAccess *)access)->setValues (reference) ;
+    break ;
+  }
+  case APVMUX: {
+    muxDescription reference (*((muxDescription *)access->getDownloadedValues())) ;
+    ((muxAccess *)access)->setValues (reference) ;
+    break ;
+  }
+  case PHILIPS: {
+    philipsDescription reference (*((philipsDescription *)access->getDownloadedValues())) ;
+    ((philipsAccess *)access)->setValues (reference) ;
+    break ;
+  }
+  default:
+    break ;
+  }
+}
+
+/**
+ * \param access - access to the devices and their reference
+ * \param policy - action when a drift is found
+ */
+FecDeviceDriftAuditor::FecDeviceDriftAuditor ( FecDeviceDriftAccess &access, enumDriftPolicy policy ):
+  access_(access), policy_(policy), maximumRewrites_(DRIFTAUDITMAXREWRITES),
+  timeBudget_(DRIFTAUDITTIMEBUDGET), frameBudget_(DRIFTAUDITFRAMEBUDGET),
+  passes_(0), reads_(0), rewrites_(0), yields_(0) {
+
+  pthread_mutex_init (&driftMutex_, NULL) ;
+  rebuild ( ) ;
+}
+
+/** Delete the lock
+ */
+FecDeviceDriftAuditor::~FecDeviceDriftAuditor ( ) {
+
+  pthread_mutex_destroy (&driftMutex_) ;
+}
+
+/**
+ * \param policy - action when a drift is found
+ * \param maximumRewrites - after this number of rewrites of a register, the drift is only reported
+ */
+void FecDeviceDriftAuditor::setPolicy ( enumDriftPolicy policy, unsigned int maximumRewrites ) {
+
+  policy_ = policy ;
+  maximumRewrites_ = maximumRewrites ;
+}
+
+/**
+ * \param timeBudget - time in microseconds for one ring in one step
+ * \param frameBudget - number of register reads for one ring in one step
+ * \warning at least one device is audited on each ring not used by another thread
+ */
+void FecDeviceDriftAuditor::setBudget ( unsigned long timeBudget, unsigned int frameBudget ) {
+
+  timeBudget_ = timeBudget ;
+  frameBudget_ = frameBudget ;
+}
+
+/** Only the type and the index of the devices are kept, the accesses are retreived for each audit.
+ * The position in the rings is lost.
+ */
+void FecDeviceDriftAuditor::rebuild ( ) {
+
+  rings_.clear() ;
+
+  std::vector< std::pair<enumDeviceType, keyType> > devices ;
+  access_.getDevices (devices) ;
+
+  for (std::vector< std::pair<enumDeviceType, keyType> >::iterator it = devices.begin() ; it != devices.end() ; it ++) {
+
+    keyType ringIndex = getFecKeyRingKey(it->second) ;
+    if (rings_.find(ringIndex) == rings_.end()) {
+      ringAuditType ring ;
+      ring.cursor = 0 ;
+      ring.passes = 0 ;
+      rings_[ringIndex] = ring ;
+    }
+    rings_[ringIndex].devices.push_back (*it) ;
+  }
+}
+
+/**
+ * \return number of devices audited in all the rings
+ */
+unsigned int FecDeviceDriftAuditor::getNumberOfDevices ( ) {
+
+  unsigned int number = 0 ;
+  for (std::map<keyType, ringAuditType>::iterator it = rings_.begin() ; it != rings_.end() ; it ++)
+    number += it->second.devices.size() ;
+  return number ;
+}
+
+/** For each ring, the ring lock is taken for the audit of one device and released between two devices.
+ * If the lock is taken by another thread, the ring is skipped until the next step. Otherwise at least
+ * one device is audited whatever the budget.
+ * \param errorList - errors during the audit and drifts found for the first time (XDAQFEC_ERRORINCOMPARISON)
+ * \return number of devices audited
+ */
+unsigned int FecDeviceDriftAuditor::auditStep ( std::list<FecExceptionHandler *> &errorList ) {
+
+  unsigned int audited = 0 ;
+  unsigned long passes = 0 ;
+  bool first = true ;
+
+  for (std::map<keyType, ringAuditType>::iterator it = rings_.begin() ; it != rings_.end() ; it ++) {
+
+    ringAuditType &ring = it->second ;
+    unsigned long long start = getTime() ;
+    unsigned int frames = 0 ;
+    unsigned int devices = 0 ;
+
+    while ( (devices < ring.devices.size()) && ((devices == 0) || ((frames < frameBudget_) && ((getTime() - start) < timeBudget_))) ) {
+
+      // Configuration traffic on this ring
+      if (!access_.tryLockRing (it->first)) {
+	yields_ ++ ;
+	break ;
+      }
+
+      std::pair<enumDeviceType, keyType> &device = ring.devices[ring.cursor] ;
+      try {
+	frames += auditDevice (device.first, device.second, errorList) ;
+      }
+      catch (FecExceptionHandler &e) {
+	errorList.push_back (e.clone()) ;
+	frames ++ ;
+      }
+      access_.unlockRing (it->first) ;
+
+      devices ++ ; audited ++ ;
+      ring.cursor ++ ;
+      if (ring.cursor >= ring.devices.size()) {
+	ring.cursor = 0 ;
+	ring.passes ++ ;
+      }
+    }
+
+    if (first || (ring.passes < passes)) passes = ring.passes ;
+    first = false ;
+  }
+
+  passes_ = passes ;
+  return audited ;
+}
+
+/** The APV registers are written again one by one with the policy DRIFTREWRITEREGISTER, the other
+ * devices are downloaded completly. A device without reference is not audited.
+ * \param deviceType - type of the device
+ * \param index - index of the device
+ * \param errorList - drifts found for the first time
+ * \return number of registers read
+ * \exception FecExceptionHandler
+ */
+unsigned int FecDeviceDriftAuditor::auditDevice ( enumDeviceType deviceType, keyType index, std::list<FecExceptionHandler *> &errorList ) throw (FecExceptionHandler) {
+
+  std::vector<driftRegisterType> registers ;
+  if (!access_.readRegisters (deviceType, index, registers)) return 0 ;
+  reads_ += registers.size() ;
+
+  unsigned long long now = getTime() ;
+  std::vector<const char *> drifts ;
+
+  for (std::vector<driftRegisterType>::iterator it = registers.begin() ; it != registers.end() ; it ++) {
+
+    if (checkRegister (index, deviceType, it->name, it->expected, it->read, now, errorList)) {
+
+      if ((deviceType == APV25) && (policy_ == DRIFTREWRITEREGISTER)) {
+	std::vector<const char *> registerName (1, it->name) ;
+	if (acceptRewrite (index, registerName)) access_.writeRegister (deviceType, index, it->name, it->expected) ;
+      }
+      else drifts.push_back (it->name) ;
+    }
+  }
+
+  if (!drifts.empty() && (policy_ != DRIFTREPORT) && acceptRewrite (index, drifts))
+    access_.writeDevice (deviceType, index) ;
+
+  return registers.size() ;
+}
+
+/** A drift found for the first time is added in the error list as a warning
+ * \param index - device index
+ * \param deviceType - device type
+ * \param registerName - name of the register
+ * \param expected - value in the reference
+ * \param read - value read
+ * \param now - time of the audit
+ * \param errorList - drifts found for the first time
+ * \return true if the register is different from the reference
+ */
+bool FecDeviceDriftAuditor::checkRegister ( keyType index, enumDeviceType deviceType, const char *registerName,
+					    unsigned int expected, unsigned int read, unsigned long long now,
+					    std::list<FecExceptionHandler *> &errorList ) {
+
+  std::pair<keyType, std::string> driftKey (index, registerName) ;
+
+  pthread_mutex_lock (&driftMutex_) ;
+
+  std::map< std::pair<keyType, std::string>, deviceDriftType >::iterator it = drifts_.find (driftKey) ;
+  if (expected == read) {
+    if (it != drifts_.end()) it->second.active = false ;
+    pthread_mutex_unlock (&driftMutex_) ;
+    return false ;
+  }
+
+  bool firstSeen = (it == drifts_.end()) ;
+  if (firstSeen) {
+    deviceDriftType drift ;
+    drift.index = index ;
+    drift.deviceType = deviceType ;
+    drift.registerName = registerName ;
+    drift.firstSeen = now ;
+    drift.count = 0 ;
+    drift.rewrites = 0 ;
+    it = drifts_.insert (std::make_pair(driftKey, drift)).first ;
+  }
+  it->second.expected = expected ;
+  it->second.read = read ;
+  it->second.lastSeen = now ;
+  it->second.count ++ ;
+  it->second.active = true ;
+
+  pthread_mutex_unlock (&driftMutex_) ;
+
+  if (firstSeen) {
+    std::stringstream msgError ;
+    msgError << XDAQFEC_ERRORINCOMPARISON_MSG << " for the register " << registerName
+	     << " (expected 0x" << std::hex << expected << ", read 0x" << read << ")" ;
+    errorList.push_back (NEWFECEXCEPTIONHANDLER_HARDPOSITION (XDAQFEC_ERRORINCOMPARISON,
+							      msgError.str(),
+							      WARNINGCODE,
+							      index)) ;
+  }
+
+  return true ;
+}
+
+/**
+ * \param index - device index
+ * \param registerNames - registers to be written again
+ * \return false if one of the registers has already been written maximumRewrites_ times
+ */
+bool FecDeviceDriftAuditor::acceptRewrite ( keyType index, std::vector<const char *> &registerNames ) {
+
+  pthread_mutex_lock (&driftMutex_) ;
+
+  for (std::vector<const char *>::iterator it = registerNames.begin() ; it != registerNames.end() ; it ++) {
+    if (drifts_[std::make_pair(index, std::string(*it))].rewrites >= maximumRewrites_) {
+      pthread_mutex_unlock (&driftMutex_) ;
+      return false ;
+    }
+  }
+  for (std::vector<const char *>::iterator it = registerNames.begin() ; it != registerNames.end() ; it ++)
+    drifts_[std::make_pair(index, std::string(*it))].rewrites ++ ;
+
+  pthread_mutex_unlock (&driftMutex_) ;
+
+  rewrites_ ++ ;
+  return true ;
+}
+
+/**
+ * \param activeOnly - only the registers different in the last audit of the device
+ * \return copy of the drift database
+ */
+std::list<deviceDriftType> FecDeviceDriftAuditor::getDrifts ( bool activeOnly ) {
+
+  std::list<deviceDriftType> drifts ;
+
+  pthread_mutex_lock (&driftMutex_) ;
+  for (std::map< std::pair<keyType, std::string>, deviceDriftType >::iterator it = drifts_.begin() ; it != drifts_.end() ; it ++)
+    if (!activeOnly || it->second.active) drifts.push_back (it->second) ;
+  pthread_mutex_unlock (&driftMutex_) ;
+
+  return drifts ;
+}
+
+/**
+ * \param index - device index
+ * \param registerName - parameter name of the register
+ * \param drift - drift of the register
+ * \return false if no drift was found for this register
+ */
+bool FecDeviceDriftAuditor::getDrift ( keyType index, std::string registerName, deviceDriftType &drift ) {
+
+  bool found = false ;
+
+  pthread_mutex_lock (&driftMutex_) ;
+  std::map< std::pair<keyType, std::string>, deviceDriftType >::iterator it = drifts_.find (std::make_pair(index, registerName)) ;
+  if (it != drifts_.end()) {
+    drift = it->second ;
+    found = true ;
+  }
+  pthread_mutex_unlock (&driftMutex_) ;
+
+  return found ;
+}
+
+/** The counters of rewrites are also cleared
+ */
+void FecDeviceDriftAuditor::clearDrifts ( ) {
+
+  pthread_mutex_lock (&driftMutex_) ;
+  drifts_.clear() ;
+  pthread_mutex_unlock (&driftMutex_) ;
+}
+
+/**
+ * \return time in microseconds
+ */
+unsigned long long FecDeviceDriftAuditor::getTime ( ) {
+
+  struct timeval time ;
+  gettimeofday (&time, NULL) ;
+  return ((unsigned long long)time.tv_sec * 1000000 + time.tv_usec) ;
+}
@@ -28,6 +28,9 @@
 
 #include "FecFactory.h" // for static methods
 #include "FecDeviceFactory.h"
+#include "FecDeviceDiff.h"
+#include "hashMapDefinition.h"
+
 
 #ifdef DATABASE
 #include "DbFecAccess.h"
@@ -49,7 +52,10 @@
  * \see addFileName to define the input file
  */
 FecDeviceFactory::FecDeviceFactory ( ): 
-  DeviceFactoryInterface ( ) {
+  DeviceFactoryInterface ( ),
+  initDbVersion_ (false),
+  skipUnchangedUpload_ (false),
+  dbStorage_ (NULL) {
 
 // #ifdef DATABASE
 //   if (databaseAccess) {
@@ -86,7 +92,10 @@ FecDeviceFactory::FecDeviceFactory ( ):
  */
 FecDeviceFactory::FecDeviceFactory ( std::string login, std::string password, std::string path, bool threaded ) 
     throw ( oracle::occi::SQLException ): 
-  DeviceFactoryInterface ( login, password, path, threaded ) {
+  DeviceFactoryInterface ( login, password, path, threaded ),
+  initDbVersion_ (false),
+  skipUnchangedUpload_ (false),
+  dbStorage_ (NULL) {
 
   setDatabaseAccess ( login, password, path ) ;
   //tkRingDescription_.clear() ;
@@ -96,7 +105,10 @@ FecDeviceFactory::FecDeviceFactory ( std::string login, std::string password, st
  * \param dbAccess - database access
  */
 FecDeviceFactory::FecDeviceFactory ( DbFecAccess *dbAccess ):
-  DeviceFactoryInterface ((DbCommonAccess *)dbAccess) {
+  DeviceFactoryInterface ((DbCommonAccess *)dbAccess),
+  initDbVersion_ (false),
+  skipUnchangedUpload_ (false),
+  dbStorage_ (NULL) {
   //tkRingDescription_.clear() ;
 }
 
@@ -153,8 +165,8 @@ void FecDeviceFactory::addFileName ( std::string fileName ) {
 
   // All devices are deleted by the XMLFecDevice so nothing must be deleted
 
-#ifdef DATABASE
   initDbVersion_ = false ;
+#ifdef DATABASE
   useDatabase_ = false ;
 #endif
 
@@ -218,6 +230,142 @@ void FecDeviceFactory::setInputFileName ( std::string inputFileName, std::string
   FecDeviceFactory::addFileName (inputFileName, fecHardwareId) ;
 }
 
+// ------------------------------------------------------------------------------------------------------
+// 
+// Storage methods
+//
+// ------------------------------------------------------------------------------------------------------
+
+/** Identifier of a device in the storage: FEC hardware ID and key of the device
+ */
+static std::string getStorageRecordId ( deviceDescription *device ) {
+
+  std::ostringstream id ;
+  id << device->getFecHardwareId() << " 0x" << std::hex << device->getKey() ;
+  return id.str() ;
+}
+
+/** The devices of the partitions are downloaded from and uploaded to the storage instead of the database.
+ * The methods without partition still use the files.
+ * \param dbStorage - storage of the configuration, NULL to go back to the database or the files
+ * \warning the storage is not deleted by the factory
+ */
+void FecDeviceFactory::setStorageAccess ( DbStorage *dbStorage ) {
+
+  dbStorage_ = dbStorage ;
+  initDbVersion_ = false ;
+}
+
+/** Retreive the devices of a version of a partition from the storage into the devices of this class.
+ * The download is not done again if the version and the mask are the ones already downloaded.
+ * \param versionMajor - major version, 0.0 for the version of the current state
+ * \param versionMinor - minor version
+ * \param pMaskVersionMajor - major version of the mask, not used with the version of the current state
+ * \param pMaskVersionMinor - minor version of the mask
+ * \param partitionName - partition name
+ * \param forceDbReload - download again the version
+ * \exception FecExceptionHandler if the partition or the version does not exist or if the XML cannot be parsed
+ */
+void FecDeviceFactory::getStorageDevices ( unsigned int versionMajor, unsigned int versionMinor, unsigned int pMaskVersionMajor, unsigned int pMaskVersionMinor, std::string partitionName, bool forceDbReload )
+  throw (FecExceptionHandler ) {
+
+  DbStorageVersion version (versionMajor, versionMinor), mask (pMaskVersionMajor, pMaskVersionMinor) ;
+  if ((versionMajor == 0) && (versionMinor == 0)) {
+    version = dbStorage_->getVersion (partitionName, DBSTORAGE_FEC) ;
+    mask = dbStorage_->getVersion (partitionName, DBSTORAGE_MASK) ;
+    if ((version.first == 0) && (version.second == 0)) {
+      std::stringstream msgError ; msgError << "no version for the partition " << partitionName ;
+      RAISEFECEXCEPTIONHANDLER (DB_NOVERSIONAVAILABLE, msgError.str(), ERRORCODE) ;
+    }
+  }
+
+  if (!forceDbReload && initDbVersion_ && (partitionName_ == partitionName) &&
+      (versionMajor_ == version.first) && (versionMinor_ == version.second) &&
+      (maskVersionMajor_ == mask.first) && (maskVersionMinor_ == mask.second)) return ;
+
+  // One record per device between the header and the footer of the XML files
+  MemBufOutputSource memBufOS ;
+  memBufOS.generateHeader() ;
+  memBufOS.generateStartTag (COMMON_XML_SCHEME) ;
+  std::string xmlBuffer = DbStorage::getXMLBuffer (dbStorage_->getRecords (partitionName, DBSTORAGE_FEC, version, mask), memBufOS.getOutputBuffer()->str(), "</ROWSET>") ;
+
+  XMLFecDevice xmlFecDevice ( (const XMLByte *)xmlBuffer.c_str() ) ;
+  deviceVector vDevice = xmlFecDevice.getDevices ( ) ;
+
+  // The devices are not deleted by the XMLFecDevice
+  FecFactory::deleteVectorI (vFecDevices_) ;
+  vFecDevices_ = vDevice ;
+
+  versionMajor_ = version.first ;
+  versionMinor_ = version.second ;
+  maskVersionMajor_ = mask.first ;
+  maskVersionMinor_ = mask.second ;
+  partitionName_ = partitionName ;
+  initDbVersion_ = true ;
+
+#ifdef DEBUGMSGERROR
+  std::cout << "Partition " << partitionName_ << ": " << vFecDevices_.size() << " devices in the version " << versionMajor_ << "." << versionMinor_ << " & mask " << maskVersionMajor_ << "." << maskVersionMinor_ << std::endl ;
+#endif
+}
+
+/** The devices downloaded (vFecDevices_) are matched by key through a hash table
+ * \param devices - devices to be uploaded
+ * \return the devices followed by the devices downloaded whose key is not in the devices, as the disabled devices
+ */
+deviceVector FecDeviceFactory::completeWithDownloadedDevices ( deviceVector &devices ) {
+
+  deviceVector toBeUploaded = devices ;
+  Sgi::hash_map<keyType, bool> keys ;
+  for (deviceVector::iterator itDev = devices.begin() ; itDev != devices.end() ; itDev ++) keys[(*itDev)->getKey()] = true ;
+  for (deviceVector::iterator itVDev = vFecDevices_.begin() ; itVDev != vFecDevices_.end() ; itVDev ++) {
+    if (keys.find ((*itVDev)->getKey()) == keys.end()) toBeUploaded.push_back(*itVDev) ;
+  }
+
+  return toBeUploaded ;
+}
+
+/** Upload the devices in a new version of a partition in the storage, the version becomes the one of the current state.
+ * The partition is created if it does not exist.
+ * \param devices - devices to be uploaded
+ * \param partitionName - partition name
+ * \param versionMajor - major version created (output)
+ * \param versionMinor - minor version created (output)
+ * \param majorVersion - create a major version with all the devices, including the disabled devices downloaded, else a minor version with the devices given
+ * \warning if setSkipUnchangedUpload is set and the devices are identical to the version downloaded for this partition, no version is created and the current version is returned
+ * \exception FecExceptionHandler if a minor version is created without major version
+ */
+void FecDeviceFactory::setStorageDevices ( deviceVector devices, std::string partitionName, unsigned int *versionMajor, unsigned int *versionMinor, bool majorVersion )
+  throw (FecExceptionHandler ) {
+
+  // Complete all the devices with the disabled devices downloaded
+  deviceVector toBeUploaded = completeWithDownloadedDevices (devices) ;
+
+  DbStorageVersion version ;
+  if (skipUnchangedUpload_ && initDbVersion_ && (partitionName_ == partitionName) && !vFecDevices_.empty() &&
+      FecDeviceDiff (vFecDevices_, toBeUploaded).empty()) {
+
+    // Nothing changed compared to the version downloaded, no new version
+    version = dbStorage_->getVersion (partitionName, DBSTORAGE_FEC) ;
+  }
+  else {
+
+    // Created only if it does not exist, under the lock of the storage
+    dbStorage_->createPartition (partitionName) ;
+
+    DbStorageRecords records ;
+    deviceVector &vDevice = majorVersion ? toBeUploaded : devices ;
+    for (deviceVector::iterator device = vDevice.begin() ; device != vDevice.end() ; device ++) {
+      MemBufOutputSource memBufOS ;
+      memBufOS.generateDeviceTag (deviceVector (1, *device)) ;
+      records[getStorageRecordId (*device)] = memBufOS.getOutputBuffer()->str() ;
+    }
+    version = dbStorage_->setRecords (partitionName, DBSTORAGE_FEC, records, majorVersion) ;
+  }
+
+  *versionMajor = version.first ;
+  *versionMinor = version.second ;
+}
+
 // ------------------------------------------------------------------------------------------------------
 // 
 // Database methods
@@ -607,6 +755,19 @@ void FecDeviceFactory::getFecDeviceDescriptions ( bool fileUsed, unsigned int ve
   }
 #endif
 
+  // retreive the information from the storage
+  if ( getStorageUsed() && !fileUsed ) {
+
+    getStorageDevices ( versionMajor, versionMinor, pMaskVersionMajor, pMaskVersionMinor, partitionName, forceDbReload ) ;
+
+    // Only the devices of the FEC if it is specified
+    deviceVector vDevice ;
+    for (deviceVector::iterator device = vFecDevices_.begin() ; device != vFecDevices_.end() ; device ++) {
+      if ((fecHardwareId == "0") || ((*device)->getFecHardwareId() == fecHardwareId)) vDevice.push_back (*device) ;
+    }
+    outVector = FecFactory::copy ( vDevice, allDevices ) ;
+  }
+  else
 #ifdef DATABASE
   // retreive the information from database
   if ( getDbUsed() && !fileUsed ) {
@@ -784,6 +945,7 @@ void FecDeviceFactory::getFecDeviceDescriptions ( deviceVector &outVector, bool
  * \See creationPartition (deviceVector, int *, int *, std::string, std::string)
  * \warning if you create a minor version, the process will try to get the version for the partition if it is set
  * \warning the version uploaded is set automatically as the next version to be downloaded
+ * \warning if setSkipUnchangedUpload is set and the devices are identical to the version downloaded for this partition, no version is created and the current version is returned
  */
 void FecDeviceFactory::setFecDeviceDescriptions ( deviceVector devices, std::string partitionName, unsigned int *versionMajor, unsigned int *versionMinor, bool majorVersion, bool uploadVersion )
 #ifdef DATABASE
@@ -803,6 +965,11 @@ void FecDeviceFactory::setFecDeviceDescriptions ( deviceVector devices, std::str
   
   if (devices.empty()) RAISEFECEXCEPTIONHANDLER (NODATAAVAILABLE, NODATAAVAILABLE_MSG + " to be uploaded ", ERRORCODE) ;
   
+  if ( getStorageUsed() && (versionMajor != NULL) && (versionMinor != NULL) ) {
+
+    setStorageDevices ( devices, partitionName, versionMajor, versionMinor, majorVersion ) ;
+  }
+  else
 #ifdef DATABASE
   if ( getDbUsed() && (versionMajor != NULL) && (versionMinor != NULL) ) {
     
@@ -817,23 +984,31 @@ void FecDeviceFactory::setFecDeviceDescriptions ( deviceVector devices, std::str
     else std::cout << "New version minor" << std::endl ;
 #endif
 
+    // Nothing changed compared to the version downloaded, no new version
+    if (skipUnchangedUpload_ && initDbVersion_ && (partitionName_ == partitionName) && !vFecDevices_.empty()) {
+      deviceVector toBeUploaded = completeWithDownloadedDevices (devices) ;
+      FecDeviceDiff deviceDiff (vFecDevices_, toBeUploaded) ;
+      if (deviceDiff.empty()) {
+	unsigned int partitionId ;
+	unsigned int maskMajor, maskMinor ;
+	getPartitionVersion (partitionName,versionMajor,versionMinor,&maskMajor,&maskMinor,&partitionId) ;
+#ifdef DEBUGMSGERROR
+	std::cout << "No change compared to the version " << *versionMajor << "." << *versionMinor << ", no version created" << std::endl ;
+#endif
+	return ;
+      }
+#ifdef DEBUGMSGERROR
+      std::cout << deviceDiff.getSummary(20) ;
+#endif
+    }
+
     unsigned int versionUpdate = 0 ;
     if (majorVersion) versionUpdate = 1 ;        // upload in next major
     else if (uploadVersion) versionUpdate = 3 ;  // upload in 0.next minor
     else versionUpdate = 0 ;                     // current major . next minor
     // If the version to be created is a major version then all the devices should be added (even the disabled one)
     if (majorVersion && (devices.size() != vFecDevices_.size())) {
-      deviceVector toBeUploaded ;
-      for (deviceVector::iterator itDev = devices.begin() ; itDev != devices.end() ; itDev ++) {
-	toBeUploaded.push_back(*itDev) ;
-      }
-      for (deviceVector::iterator itVDev = vFecDevices_.begin() ; itVDev != vFecDevices_.end() ; itVDev ++) {
-	bool toBeAdded = true ;
-	for (deviceVector::iterator itDev = devices.begin() ; itDev != devices.end() ; itDev ++) {
-	  if ( ((*itVDev)->getKey()) == ((*itDev)->getKey()) ) toBeAdded = false ;
-	}
-	if (toBeAdded) toBeUploaded.push_back(*itVDev) ;
-      }
+      deviceVector toBeUploaded = completeWithDownloadedDevices (devices) ;
       xmlFecDevice.setDevices(toBeUploaded, partitionName, versionUpdate) ;
     }
     else {
@@ -854,17 +1029,7 @@ void FecDeviceFactory::setFecDeviceDescriptions ( deviceVector devices, std::str
 #endif
     {  
       // Complete all the devices with the disabled device
-      deviceVector toBeUploaded ;
-      for (deviceVector::iterator itDev = devices.begin() ; itDev != devices.end() ; itDev ++) {
-	toBeUploaded.push_back(*itDev) ;
-      }
-      for (deviceVector::iterator itVDev = vFecDevices_.begin() ; itVDev != vFecDevices_.end() ; itVDev ++) {
-	bool toBeAdded = true ;
-	for (deviceVector::iterator itDev = devices.begin() ; itDev != devices.end() ; itDev ++) {
-	  if ( ((*itVDev)->getKey()) == ((*itDev)->getKey()) ) toBeAdded = false ;
-	}
-	if (toBeAdded) toBeUploaded.push_back(*itVDev) ;
-      }
+      deviceVector toBeUploaded = completeWithDownloadedDevices (devices) ;
 
       // Upload in file
       XMLFecDevice xmlFecDevice ; 
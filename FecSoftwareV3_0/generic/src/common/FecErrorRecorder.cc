@@ -0,0 +1,215 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Copyright 2002 - 2003, Frederic DROUHIN - Universite de Haute-Alsace, Mulhouse-France
+*/
+#include <sys/time.h>
+
+#include <set>
+
+#include "stringConv.h"
+#include "FecErrorRecorder.h"
+
+/** Marker of the accesses in error
+ */
+FecExceptionHandler FecErrorRecorder::recordedError_ ;
+
+/**
+ * \param size - number of records kept, at least 1
+ */
+FecErrorRecorder::FecErrorRecorder ( unsigned int size ):
+  records_(size ? size : 1), recorded_(0) {
+}
+
+/** Delete the exceptions kept
+ */
+FecErrorRecorder::~FecErrorRecorder ( ) {
+
+  clear() ;
+}
+
+/** The buffer is kept
+ */
+void FecErrorRecorder::clear ( ) {
+
+  recorded_ = 0 ;
+  for (std::list<FecExceptionHandler *>::iterator it = exceptions_.begin() ; it != exceptions_.end() ; it ++) delete *it ;
+  exceptions_.clear() ;
+}
+
+/** No allocation: the record overwrites the oldest one when the buffer is full
+ * \param errorCode - error code
+ * \param errorMessage - static message
+ * \param faultSeverity - severity
+ * \param hardPosition - position of the error
+ * \param registerOffset - offset of the access
+ * \param transaction - transaction number of the access
+ * \param informationName - static name of the information or "Not filled"
+ * \param informationSup - information
+ * \param method - method (__PRETTY_FUNCTION__)
+ * \param sourceFileName - file (__FILE__)
+ * \param line - line (__LINE__)
+ * \return getRecordedError()
+ */
+FecExceptionHandler *FecErrorRecorder::record ( errorType errorCode, const char *errorMessage, errorType faultSeverity,
+						keyType hardPosition, unsigned short registerOffset, unsigned short transaction,
+						const char *informationName, unsigned int informationSup,
+						const char *method, const char *sourceFileName, unsigned int line ) {
+
+  struct timeval tv ;
+  gettimeofday (&tv, NULL) ;
+
+  fecErrorRecordType &record = records_[recorded_ % records_.size()] ;
+  record.timestamp = tv.tv_sec * 1000000ULL + tv.tv_usec ;
+  record.hardPosition = hardPosition ;
+  record.errorCode = errorCode ;
+  record.faultSeverity = faultSeverity ;
+  record.informationSup = informationSup ;
+  record.errorMessage = errorMessage ;
+  record.informationName = informationName ;
+  record.method = method ;
+  record.sourceFileName = sourceFileName ;
+  record.registerOffset = registerOffset ;
+  record.transaction = transaction ;
+  record.line = line ;
+
+  recorded_ ++ ;
+
+  return &recordedError_ ;
+}
+
+/**
+ * \param e - exception, deleted by the recorder. Nothing is done for NULL, getRecordedError or an exception already kept
+ * \return e
+ */
+FecExceptionHandler *FecErrorRecorder::addException ( FecExceptionHandler *e ) {
+
+  if ((e == NULL) || (e == &recordedError_)) return e ;
+
+  for (std::list<FecExceptionHandler *>::iterator it = exceptions_.begin() ; it != exceptions_.end() ; it ++)
+    if (*it == e) return e ;
+
+  exceptions_.push_back (e) ;
+  return e ;
+}
+
+/**
+ * \param errorCode - error code
+ * \param hardPosition - position of the error (ring)
+ * \return exception kept or NULL
+ */
+FecExceptionHandler *FecErrorRecorder::getException ( errorType errorCode, keyType hardPosition ) {
+
+  for (std::list<FecExceptionHandler *>::iterator it = exceptions_.begin() ; it != exceptions_.end() ; it ++)
+    if (((*it)->getErrorCode() == errorCode) && (*it)->getPositionGiven() && ((*it)->getHardPosition() == hardPosition)) return *it ;
+
+  return NULL ;
+}
+
+/**
+ * \param i - 0 for the oldest record kept
+ * \return record
+ * \exception FecExceptionHandler
+ */
+const fecErrorRecordType &FecErrorRecorder::getRecord ( unsigned int i ) throw (FecExceptionHandler) {
+
+  if (i >= getNumberOfRecords())
+    RAISEFECEXCEPTIONHANDLER (CODECONSISTENCYERROR, "error record " + toString(i) + " does not exist", ERRORCODE) ;
+
+  return records_[(getNumberOfLostRecords() + i) % records_.size()] ;
+}
+
+/**
+ * \param i - 0 for the oldest record kept
+ * \return message as given by FecExceptionHandler::what
+ * \exception FecExceptionHandler
+ */
+std::string FecErrorRecorder::getMessage ( unsigned int i ) throw (FecExceptionHandler) {
+
+  FecExceptionHandler *e = newException (getRecord (i)) ;
+  std::string message = e->what() ;
+  delete e ;
+
+  return message ;
+}
+
+/**
+ * \param record - error record
+ * \return new exception with the same content
+ */
+FecExceptionHandler *FecErrorRecorder::newException ( const fecErrorRecordType &record ) {
+
+  return new FecExceptionHandler (record.errorCode, record.errorMessage, record.faultSeverity,
+				  record.method, record.sourceFileName, record.line,
+				  record.hardPosition, record.informationName, record.informationSup) ;
+}
+
+/** The exceptions of the rings are given first (cloned), then the records from the oldest
+ * \param errorList - list of exceptions, the exceptions must be deleted by the caller
+ * \param oneErrorPerDevice - only the first record of each position
+ * \return number of exceptions added
+ */
+unsigned int FecErrorRecorder::getErrorList ( std::list<FecExceptionHandler *> &errorList, bool oneErrorPerDevice ) {
+
+  unsigned int added = 0 ;
+
+  for (std::list<FecExceptionHandler *>::iterator it = exceptions_.begin() ; it != exceptions_.end() ; it ++) {
+    errorList.push_back ((*it)->clone()) ;
+    added ++ ;
+  }
+
+  std::set<keyType> positions ;
+  for (unsigned int i = 0 ; i < getNumberOfRecords() ; i ++) {
+    const fecErrorRecordType &record = getRecord (i) ;
+    if (oneErrorPerDevice && !positions.insert(record.hardPosition).second) continue ;
+    errorList.push_back (newException (record)) ;
+    added ++ ;
+  }
+
+  if (getNumberOfLostRecords()) {
+    errorList.push_back (NEWFECEXCEPTIONHANDLER (TOOMUCHERROR,
+						 toString(getNumberOfLostRecords()) + " error records lost (buffer of " + toString(records_.size()) + " records)",
+						 WARNINGCODE)) ;
+    added ++ ;
+  }
+
+  return added ;
+}
+
+/** The first error with the highest severity is raised (FATALERRORCODE is the most severe)
+ * \exception FecExceptionHandler
+ */
+void FecErrorRecorder::raise ( ) throw (FecExceptionHandler) {
+
+  FecExceptionHandler *worst = NULL ;
+  for (std::list<FecExceptionHandler *>::iterator it = exceptions_.begin() ; it != exceptions_.end() ; it ++)
+    if ((worst == NULL) || ((*it)->getFaultSeverity() < worst->getFaultSeverity())) worst = *it ;
+
+  const fecErrorRecordType *worstRecord = NULL ;
+  for (unsigned int i = 0 ; i < getNumberOfRecords() ; i ++) {
+    const fecErrorRecordType &record = getRecord (i) ;
+    if ((worstRecord == NULL) || (record.faultSeverity < worstRecord->faultSeverity)) worstRecord = &record ;
+  }
+
+  if ((worst != NULL) && ((worstRecord == NULL) || (worst->getFaultSeverity() <= worstRecord->faultSeverity)))
+    throw FecExceptionHandler (*worst) ;
+
+  if (worstRecord != NULL)
+    throw FecExceptionHandler (worstRecord->errorCode, worstRecord->errorMessage, worstRecord->faultSeverity,
+			       worstRecord->method, worstRecord->sourceFileName, worstRecord->line,
+			       worstRecord->hardPosition, worstRecord->informationName, worstRecord->informationSup) ;
+}
@@ -0,0 +1,120 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "cmdDescription.h"
+#include "datatypes.h"
+#include "FecExceptionHandler.h"
+
+#include "FecPciBarModel.h"
+
+/** \param size - size of the registers in bytes
+ * \param fifoTransmitOffset - offset of the FIFO transmit
+ * \param fifoReceiveOffset - offset of the FIFO receive
+ * \param fifoReturnOffset - offset of the FIFO return
+ * \param loopback - the frames sent come back in the FIFO receive
+ */
+FecPciBarModel::FecPciBarModel ( unsigned int size, unsigned int fifoTransmitOffset, unsigned int fifoReceiveOffset,
+				 unsigned int fifoReturnOffset, bool loopback ):
+  FecPciBar (fifoTransmitOffset, fifoReceiveOffset, fifoReturnOffset),
+  image_((size + 3) / 4, 0), loopback_(loopback), reads_(0), writes_(0) {
+}
+
+/** \param offset - offset in bytes
+ * \return the word of the image
+ * \exception FecExceptionHandler if the offset is out of the registers or not aligned
+ */
+tscType32 &FecPciBarModel::word ( unsigned int offset ) {
+
+  if ((offset & 0x3) || ((offset >> 2) >= image_.size()))
+    RAISEFECEXCEPTIONHANDLER ( TSCFEC_INVALIDOPERATION,
+			       "access out of the registers of the PCI FEC",
+			       ERRORCODE ) ;
+  return image_[offset >> 2] ;
+}
+
+/** \param offset - offset in bytes
+ * \return the value of the register
+ */
+tscType32 FecPciBarModel::getRegister ( unsigned int offset ) {
+
+  return word (offset) ;
+}
+
+/** \param offset - offset in bytes
+ * \param value - value of the register
+ */
+void FecPciBarModel::setRegister ( unsigned int offset, tscType32 value ) {
+
+  word (offset) = value ;
+}
+
+/** Pop the first word of a FIFO, 0 if the FIFO is empty
+ */
+static tscType32 popFifo ( std::deque<tscType32> &fifo ) {
+
+  tscType32 value = 0 ;
+  if (!fifo.empty()) {
+    value = fifo.front() ;
+    fifo.pop_front() ;
+  }
+  return value ;
+}
+
+/** \param offset - offset in bytes
+ * \return the value read
+ */
+tscType32 FecPciBarModel::read ( unsigned int offset ) {
+
+  tscType32 &value = word (offset) ;
+  reads_ ++ ;
+
+  if (offset == fifoTransmitOffset_) return popFifo (fifoTransmit_) ;
+  if (offset == fifoReceiveOffset_) return popFifo (fifoReceive_) ;
+  if (offset == fifoReturnOffset_) return popFifo (fifoReturn_) ;
+
+  if (offset == DD_FEC_STAT0_OFFSET) {
+    tscType32 sr0 = value & ~(FEC_SR0_TRAEMPTY | FEC_SR0_RECEMPTY | FEC_SR0_RETEMPTY) ;
+    if (fifoTransmit_.empty()) sr0 |= FEC_SR0_TRAEMPTY ;
+    if (fifoReceive_.empty()) sr0 |= FEC_SR0_RECEMPTY ;
+    if (fifoReturn_.empty()) sr0 |= FEC_SR0_RETEMPTY ;
+    return sr0 ;
+  }
+
+  return value ;
+}
+
+/** \param offset - offset in bytes
+ * \param value - value written
+ */
+void FecPciBarModel::write ( unsigned int offset, tscType32 value ) {
+
+  tscType32 &reg = word (offset) ;
+  writes_ ++ ;
+
+  if (offset == fifoTransmitOffset_) fifoTransmit_.push_back (value) ;
+  else if (offset == fifoReceiveOffset_) fifoReceive_.push_back (value) ;
+  else if (offset == fifoReturnOffset_) fifoReturn_.push_back (value) ;
+  else {
+    // The send bit starts the emission of the frames of the FIFO transmit
+    if (loopback_ && (offset == DD_FEC_CTRL0_OFFSET) && (value & FEC_CR0_SEND) && !(reg & FEC_CR0_SEND)) {
+      fifoReceive_.insert (fifoReceive_.end(), fifoTransmit_.begin(), fifoTransmit_.end()) ;
+      fifoTransmit_.clear() ;
+    }
+    reg = value ;
+  }
+}
@@ -49,7 +49,7 @@ using std::hex;
  * \param init - initialise the FEC (with reset at the starting)
  */
 FecPciRingDevice::FecPciRingDevice (tscType8 fecSlot, tscType8 ringSlot, bool init, bool invertClockPolarity ) throw ( FecExceptionHandler ) :
-  FecRingDevice ( fecSlot, ringSlot, FECPCI ) {
+  FecRingDevice ( fecSlot, ringSlot, FECPCI ), bar_(NULL), mappedRegisters_(NULL) {
 
   // Build the name of the device driver
   char devicename[100] ;
@@ -87,6 +87,9 @@ FecPciRingDevice::FecPciRingDevice (tscType8 fecSlot, tscType8 ringSlot, bool in
   glue_plx_disable_irqs (deviceDescriptor_) ;
 #endif
 
+  // Access the registers without ioctl if the driver allows it
+  mapRegisters ( ) ;
+
   // Initialise or not the FEC
   FecRingDevice::setInitFecRingDevice ( init, invertClockPolarity ) ;
 
@@ -100,6 +103,9 @@ FecPciRingDevice::FecPciRingDevice (tscType8 fecSlot, tscType8 ringSlot, bool in
  */
 FecPciRingDevice::~FecPciRingDevice ( ) throw ( FecExceptionHandler )
 {
+  // The driver does not enable the IRQ while the registers are mapped
+  unmapRegisters ( ) ;
+
 #ifdef IRQMANAGER
   // Enable the IRQ
   glue_plx_enable_irqs (deviceDescriptor_) ;
@@ -111,6 +117,66 @@ FecPciRingDevice::~FecPciRingDevice ( ) throw ( FecExceptionHandler )
 }
 
 
+/******************************************************
+	REGISTERS MAPPING
+******************************************************/
+
+/** Map the registers of the FEC in the process. The mapping is not used if the driver
+ * refuses it (IRQ enabled, driver without mmap) or if the FIFOs are 16 bits FIFOs,
+ * converted by the glue.
+ */
+void FecPciRingDevice::mapRegisters ( ) {
+
+  if (bar_ != NULL) return ;
+
+  volatile void *registers ;
+  if (glue_fec_map_registers (deviceDescriptor_, &mapInfo_, &registers) != DD_RETURN_OK) return ;
+
+  if (mapInfo_.fifo_item_size != 32) {
+    glue_fec_unmap_registers (&mapInfo_, registers) ;
+    return ;
+  }
+
+  mappedRegisters_ = registers ;
+  bar_ = new FecPciMappedBar (registers, mapInfo_.fifotra_offset, mapInfo_.fiforec_offset, mapInfo_.fiforet_offset) ;
+
+#ifdef FECPCIRINGDEVICE_DEBUG
+  std::cout << "DEBUG : registers of the FEC mapped at " << (void *)registers << std::endl ;
+#endif
+}
+
+/** Release the mapping of the registers, the ioctl are used after
+ */
+void FecPciRingDevice::unmapRegisters ( ) {
+
+  if (bar_ == NULL) return ;
+
+  delete bar_ ;
+  bar_ = NULL ;
+  glue_fec_unmap_registers (&mapInfo_, mappedRegisters_) ;
+  mappedRegisters_ = NULL ;
+}
+
+/** Use or not the registers mapped in the process
+ * \param mapped - map the registers or use the ioctl
+ * \exception FecExceptionHandler if the driver refuses the mapping
+ */
+void FecPciRingDevice::setRegisterMapping ( bool mapped ) throw ( FecExceptionHandler ) {
+
+  if (!mapped) {
+    unmapRegisters ( ) ;
+    return ;
+  }
+
+  mapRegisters ( ) ;
+  if (bar_ == NULL) {
+    RAISEFECEXCEPTIONHANDLER_HARDPOSITION (DD_CANNOT_MAP_FEC_REGISTERS,
+					   "Unable to map the FEC registers",
+					   ERRORCODE,
+					   buildFecRingKey(getFecSlot(), getRingSlot())) ;
+  }
+}
+
 /******************************************************
 	CONTROL & STATUS RTEGISTERS ACCESS
 ******************************************************/
@@ -130,6 +196,11 @@ void FecPciRingDevice::setFecRingCR0 ( tscType16 ctrl0Value, bool force ) throw
   std::cout << "DEBUG : writing value 0x" << hex << ctrl0Value << std::endl ;
 #endif
 
+  if (bar_ != NULL) {
+    bar_->write (DD_FEC_CTRL0_OFFSET, ctrl0Value) ;
+    return ;
+  }
+
   DD_TYPE_ERROR lcl_err = glue_fec_set_ctrl0(deviceDescriptor_, ctrl0Value);
   if (lcl_err != DD_RETURN_OK) {
 
@@ -149,6 +220,8 @@ tscType16 FecPciRingDevice::getFecRingCR0( ) throw ( FecExceptionHandler ) {
 
   tscType32 ctrl0Value;
 
+  if (bar_ != NULL) return (tscType16)bar_->read (DD_FEC_CTRL0_OFFSET) ;
+
   DD_TYPE_ERROR lcl_err = glue_fec_get_ctrl0(deviceDescriptor_, (DD_FEC_REGISTER_DATA*)&ctrl0Value);
 #ifdef FECPCIRINGDEVICE_DEBUG
   std::cout << "DEBUG : reading value 0x" << hex << ctrl0Value << " from CRO" << std::endl ;
@@ -174,6 +247,11 @@ void FecPciRingDevice::setFecRingCR1( tscType16 ctrl1Value ) throw ( FecExceptio
   std::cout << "DEBUG : writing value 0x" << hex << ctrl1Value << " in CR1" << std::endl ;
 #endif
 
+  if (bar_ != NULL) {
+    bar_->write (DD_FEC_CTRL1_OFFSET, ctrl1Value) ;
+    return ;
+  }
+
 	
   DD_TYPE_ERROR lcl_err = glue_fec_set_ctrl1(deviceDescriptor_, ctrl1Value);
 
@@ -194,6 +272,8 @@ tscType16 FecPciRingDevice::getFecRingCR1( ) throw ( FecExceptionHandler ) {
 
   tscType32 ctrl1Value;
 
+  if (bar_ != NULL) return (tscType16)bar_->read (DD_FEC_CTRL1_OFFSET) ;
+
   DD_TYPE_ERROR lcl_err = glue_fec_get_ctrl1(deviceDescriptor_, (DD_FEC_REGISTER_DATA*)&ctrl1Value);
 
 #ifdef FECPCIRINGDEVICE_DEBUG
@@ -217,6 +297,9 @@ tscType16 FecPciRingDevice::getFecRingCR1( ) throw ( FecExceptionHandler ) {
 tscType32 FecPciRingDevice::getFecRingSR0( ) throw ( FecExceptionHandler ) {
 
   tscType32 sr0Value;
+
+  // 16 bits as the value given by the driver
+  if (bar_ != NULL) return (bar_->read (DD_FEC_STAT0_OFFSET) & 0xFFFF) ;
   
   DD_TYPE_ERROR lcl_err = glue_fec_get_status0(deviceDescriptor_, (DD_FEC_REGISTER_DATA*)&sr0Value);
 
@@ -242,6 +325,8 @@ tscType16 FecPciRingDevice::getFecRingSR1( ) throw ( FecExceptionHandler ) {
 
   tscType32 sr1Value;
 
+  if (bar_ != NULL) return (tscType16)bar_->read (DD_FEC_STAT1_OFFSET) ;
+
   DD_TYPE_ERROR lcl_err = glue_fec_get_status1(deviceDescriptor_, (DD_FEC_REGISTER_DATA*)&sr1Value);
 
 #ifdef FECPCIRINGDEVICE_DEBUG
@@ -264,6 +349,8 @@ tscType16 FecPciRingDevice::getFecFirmwareVersion( ) throw ( FecExceptionHandler
 
   tscType16 fecVersion ;
 
+  if (bar_ != NULL) return (tscType16)bar_->read (DD_FEC_FIRMWARE_VERSION_OFFSET) ;
+
   DD_TYPE_ERROR lcl_err = glue_fec_get_firmware_version(deviceDescriptor_, (DD_FEC_REGISTER_DATA*)&fecVersion);
 
 #ifdef FECPCIRINGDEVICE_DEBUG
@@ -292,6 +379,7 @@ tscType32 FecPciRingDevice::getFifoReceive( ) throw ( FecExceptionHandler ) {
 
   DD_FEC_FIFO_DATA_32 fiforec_value;
 
+  if (bar_ != NULL) return bar_->read (bar_->getFifoReceiveOffset()) ;
 
   DD_TYPE_ERROR lcl_err = glue_fec_get_native_fiforec_item_32(deviceDescriptor_, &fiforec_value);
 
@@ -320,6 +408,11 @@ void FecPciRingDevice::setFifoReceive( tscType32 fiforec_value )throw ( FecExcep
   std::cout << "DEBUG : writing value 0x" << hex << fiforecValue << " to fifo receive" << std::endl ;
 #endif
 
+  if (bar_ != NULL) {
+    bar_->write (bar_->getFifoReceiveOffset(), fiforec_value) ;
+    return ;
+  }
+
   DD_TYPE_ERROR lcl_err = glue_fec_set_native_fiforec_item_32(deviceDescriptor_, fiforec_value);
   if (lcl_err != DD_RETURN_OK) {
     RAISEFECEXCEPTIONHANDLER_HARDPOSITION (lcl_err,
@@ -336,6 +429,8 @@ tscType8 FecPciRingDevice::getFifoReturn( ) throw ( FecExceptionHandler ) {
 
   DD_FEC_FIFO_DATA_32 fiforet_value;
 
+  if (bar_ != NULL) return (tscType8)bar_->read (bar_->getFifoReturnOffset()) ;
+
   DD_TYPE_ERROR lcl_err = glue_fec_get_native_fiforet_item_32(deviceDescriptor_, &fiforet_value);
 
 #ifdef FECPCIRINGDEVICE_DEBUG
@@ -363,6 +458,11 @@ void FecPciRingDevice::setFifoReturn( tscType8 fiforet_value )throw ( FecExcepti
   std::cout << "DEBUG : writing value 0x" << hex << fiforet_value << " to fifo return" << std::endl ;
 #endif
 
+  if (bar_ != NULL) {
+    bar_->write (bar_->getFifoReturnOffset(), fiforet_value) ;
+    return ;
+  }
+
   DD_TYPE_ERROR lcl_err = glue_fec_set_native_fiforet_item_32(deviceDescriptor_, fiforet_value);
   if (lcl_err != DD_RETURN_OK) {
     RAISEFECEXCEPTIONHANDLER_HARDPOSITION (lcl_err,
@@ -381,6 +481,8 @@ tscType32 FecPciRingDevice::getFifoTransmit( ) throw ( FecExceptionHandler ) {
 
   DD_FEC_FIFO_DATA_32 fifotra_value;
 
+  if (bar_ != NULL) return bar_->read (bar_->getFifoTransmitOffset()) ;
+
   DD_TYPE_ERROR lcl_err = glue_fec_get_native_fifotra_item_32(deviceDescriptor_, &fifotra_value);
 
 #ifdef FECPCIRINGDEVICE_DEBUG
@@ -407,6 +509,11 @@ void FecPciRingDevice::setFifoTransmit( tscType32 fifotra_value )throw ( FecExce
   std::cout << "DEBUG : writing value 0x" << hex << fiforet_value << " to fifo transmit" << std::endl ;
 #endif
 
+  if (bar_ != NULL) {
+    bar_->write (bar_->getFifoTransmitOffset(), fifotra_value) ;
+    return ;
+  }
+
   DD_TYPE_ERROR lcl_err = glue_fec_set_native_fifotra_item_32(deviceDescriptor_, fifotra_value);
 
   if (lcl_err != DD_RETURN_OK) {
@@ -420,8 +527,28 @@ void FecPciRingDevice::setFifoTransmit( tscType32 fifotra_value )throw ( FecExce
 
 
 
+/** Write a set of words in the FIFO transmit, without any call per word when the registers are mapped
+ * \param value - words to be written
+ * \param count - number of words
+ */
+void FecPciRingDevice::setFifoTransmit ( tscType32 *value, int count ) throw ( FecExceptionHandler ) {
 
+  if (bar_ != NULL) bar_->writeFifo (bar_->getFifoTransmitOffset(), value, count) ;
+  else FecRingDevice::setFifoTransmit (value, count) ;
+}
 
+/** Read a set of words from the FIFO receive, without any call per word when the registers are mapped
+ * \param value - words read
+ * \param count - number of words
+ * \return value
+ */
+tscType32* FecPciRingDevice::getFifoReceive ( tscType32 *value, int count ) throw ( FecExceptionHandler ) {
+
+  if (bar_ != NULL) bar_->readFifo (bar_->getFifoReceiveOffset(), value, count) ;
+  else FecRingDevice::getFifoReceive (value, count) ;
+
+  return value ;
+}
 
 /******************************************************
 		HARD RESET
@@ -481,12 +608,18 @@ void FecPciRingDevice::setIRQ ( bool enable, tscType8 level ) throw (FecExceptio
   DD_TYPE_ERROR lcl_err ;
 
   if (enable) {
+    // The driver reads the FIFO receive in its IRQ handler: the mapping is released first
+    unmapRegisters ( ) ;
+
     // Enable the IRQ
     lcl_err = glue_plx_enable_irqs (deviceDescriptor_) ;
   }
   else {
     // Disable the IRQ
     lcl_err = glue_plx_disable_irqs (deviceDescriptor_) ;
+
+    // Registers can be mapped again
+    if (lcl_err == DD_RETURN_OK) mapRegisters ( ) ;
   }
 
   if (lcl_err != DD_RETURN_OK) {
@@ -29,6 +29,7 @@
 #include <string.h>     // For memcpy function
 #include <iostream> 
 #include <iomanip>
+#include <map>
 
 #include "stringConv.h"
 
@@ -77,6 +78,20 @@
 //#define RECALCULATETIMEOUT
 //#define DEBUGTIMING
 
+/** Take the ring lock for the time of a transaction (released on return and on exception)
+ */
+class FecRingTransactionLock {
+ public:
+  FecRingTransactionLock ( FecRingDevice *fecRingDevice ): fecRingDevice_(fecRingDevice) {
+    pthread_mutex_lock (&fecRingDevice_->ringMutex_) ;
+  }
+  ~FecRingTransactionLock ( ) {
+    pthread_mutex_unlock (&fecRingDevice_->ringMutex_) ;
+  }
+ private:
+  FecRingDevice *fecRingDevice_ ;
+} ;
+
 // -------------------------------------------------------------------------------------
 //
 //                              Constructors and destructor
@@ -98,6 +113,20 @@ FecRingDevice::FecRingDevice ( tscType8 fecSlot, tscType8 ringSlot, enumFecBusTy
   receiveFifoDepth_  = 0 ; // no transmit fifo..
   returnFifoDepth_ = 0 ; // no return fifo
   firmwareVersion_ = 0x0 ; // unknown
+
+  // No transaction number used before setInitFecRingDevice
+  for (int i = 0 ; i <= MAXTRANSACTIONNUMBER ; i ++) busyTransactionNumber[i] = false ;
+
+  // Lock for the transactions, recursive since the block methods can call each other
+  pthread_mutexattr_t mutexAttr ;
+  pthread_mutexattr_init (&mutexAttr) ;
+  pthread_mutexattr_settype (&mutexAttr, PTHREAD_MUTEX_RECURSIVE) ;
+  pthread_mutex_init (&ringMutex_, &mutexAttr) ;
+  pthread_mutexattr_destroy (&mutexAttr) ;
+
+  // CCU alarms received during the transactions
+  pthread_mutex_init (&alarmFramesMutex_, NULL) ;
+  alarmFramesLost_ = 0 ;
 }
 
 /**
@@ -252,6 +281,9 @@ FecRingDevice::~FecRingDevice ( ) {
     delete p->second ; // Remove all the accesses for the CCU device
 
   ccuMapAccess_.clear() ;
+
+  pthread_mutex_destroy (&ringMutex_) ;
+  pthread_mutex_destroy (&alarmFramesMutex_) ;
 }
 
 // -------------------------------------------------------------------------------------
@@ -513,6 +545,9 @@ unsigned int FecRingDevice::getReturnFifoDepth () {
 void FecRingDevice::writeFrame ( tscType8 *frame, bool ignoreDirectAck ) 
   throw (FecExceptionHandler) {
 
+  // No CCU alarm read by another thread during the transaction
+  FecRingTransactionLock ringLock (this) ;
+
 #ifdef DEBUGMSGERROR
   tscType16 fecSR0D = getFecRingSR0() ;
   std::cout << "===============================> FecRingDevice(" << std::dec << (int)getFecSlot() << "." << (int)getRingSlot() << ")::writeFrame: begin and the SR0 is " << std::hex << fecSR0D << std::endl ;
@@ -1371,6 +1406,9 @@ void FecRingDevice::writeFrame ( tscType8 *frame, bool ignoreDirectAck )
 void FecRingDevice::writeFrameDelayed ( tscType8 *frame, bool ignoreDirectAck ) 
   throw (FecExceptionHandler) {
 
+  // No CCU alarm read by another thread during the transaction
+  FecRingTransactionLock ringLock (this) ;
+
 #ifdef DEBUGMSGERROR
   tscType16 fecSR0D = getFecRingSR0() ;
   std::cout << "===============================> FecRingDevice(" << std::dec << (int)getFecSlot() << "." << (int)getRingSlot() << ")::writeFrameDelayed: begin and the SR0 is " << std::hex << fecSR0D << std::endl ;
@@ -2203,6 +2241,9 @@ void FecRingDevice::writeFrameDelayed ( tscType8 *frame, bool ignoreDirectAck )
 void FecRingDevice::readFrame ( tscType8 transaction, tscType8 *frame, tscType8 expectedSize )
   throw (FecExceptionHandler) {
 
+  // No CCU alarm read by another thread during the transaction
+  FecRingTransactionLock ringLock (this) ;
+
   tscType16 fecSR0 ;
 
 #ifdef DEBUGMSGERROR
@@ -3168,6 +3209,9 @@ void FecRingDevice::checkFifoReceive ( int display ) {
 	    std::cerr << std::endl ;
 	  }
 
+	  // CCU alarms and PIA interrupts are kept for getCcuAlarmFrame
+	  if (isCcuAlarmFrame(frame)) pushCcuAlarmFrame(frame) ;
+
 	  loopCnt ++ ;
 	}
       }
@@ -6164,6 +6208,151 @@ void FecRingDevice::setPiaClearInterrupts ( keyType index ) throw (FecExceptionH
   }  
 }
 
+/** Return a CCU alarm or PIA interrupt frame if one is available. The frames received during a transaction
+ * (setBlockDevices) are returned first. Then, if no transaction is running on the ring, one frame is read
+ * from the FIFO receive. This method never waits: it is used by the CcuAlarmDispatcher thread.
+ * \param frame - frame received in 8 bits length
+ * \return true if a frame has been returned
+ * \exception FecExceptionHandler
+ * \exception FecExceptionHandler with TSCFEC_PROBLEMINFRAME and the frame if a frame which is not an alarm is read
+ * in the FIFO receive: no transaction is waiting for it and it cannot be put back in the FIFO
+ * \warning The size of the frame must be DD_USER_MAX_MSG_LENGTH*4
+ */
+bool FecRingDevice::getCcuAlarmFrame ( tscType8 frame[DD_USER_MAX_MSG_LENGTH*4] ) throw (FecExceptionHandler) {
+
+  // Frames received during a transaction
+  pthread_mutex_lock (&alarmFramesMutex_) ;
+  if (!alarmFrames_.empty()) {
+    std::vector<tscType8> &alarmFrame = alarmFrames_.front() ;
+    for (unsigned int i = 0 ; i < alarmFrame.size() ; i ++) frame[i] = alarmFrame[i] ;
+    alarmFrames_.pop_front() ;
+    pthread_mutex_unlock (&alarmFramesMutex_) ;
+    return true ;
+  }
+  pthread_mutex_unlock (&alarmFramesMutex_) ;
+
+  // The ring is used by another thread
+  if (pthread_mutex_trylock (&ringMutex_) != 0) return false ;
+
+  bool alarm = false, unexpected = false ;
+  try {
+    // A frame is waited by a write/read frame done on another thread
+    tscType32 fecSR0 = getFecRingSR0() ;
+    if (!isTransactionPending() && !(fecSR0 & FEC_SR0_RECEMPTY) && (fecSR0 & FEC_SR0_LINKINITIALIZED)) {
+
+      // Retreive the size
+      tscType32 c[DD_USER_MAX_MSG_LENGTH] ;
+      c[0] = getFifoReceive() ;
+      tscType32 realSize = (c[0] >> 8) & 0xFF ;
+      tscType8 word2 = c[0]  & 0xFF ;
+      if (realSize & FEC_LENGTH_2BYTES) {
+	realSize = ((realSize & 0x7F) << 8) + word2 + 1 ;
+      }
+
+      // +3 => Dst, Src, Length  ; +1 => status after the frame
+      tscType32 realSize32 = (realSize+3+1)/4 ;
+      if ( ((realSize+3+1) % 4) != 0 ) realSize32 += 1 ;
+
+      if (realSize32 > DD_USER_MAX_MSG_LENGTH) {
+
+	// Corrupted frame, the FIFO is emptied
+	checkFifoReceive ( ) ;
+      }
+      else {
+
+	for (tscType32 i = 1 ; i < realSize32 ; i ++) c[i] = getFifoReceive() ;
+
+	int cpt = 0 ;
+	for (tscType32 i = 0 ; i < realSize32 ; i ++) {
+	  frame[cpt++] = (c[i] >> 24) & 0xFF ;
+	  frame[cpt++] = (c[i] >> 16) & 0xFF ;
+	  frame[cpt++] = (c[i] >>  8) & 0xFF ;
+	  frame[cpt++] = (c[i])       & 0xFF ;
+	}
+	alarm = isCcuAlarmFrame (frame) ;
+	unexpected = !alarm ;
+      }
+
+      // clean up interrupts
+      if (getFecRingSR0() & FEC_SR0_RECEMPTY) setFecRingCR1 (FEC_CR1_CLEARIRQ) ;
+    }
+  }
+  catch (FecExceptionHandler &e) {
+    pthread_mutex_unlock (&ringMutex_) ;
+    throw e ;
+  }
+
+  pthread_mutex_unlock (&ringMutex_) ;
+
+  // Answer to a transaction which is not waited anymore (timeout) or frame not requested
+  if (unexpected) {
+    bool twoBytes = frame[2] & FEC_LENGTH_2BYTES ;
+    RAISEFECEXCEPTIONHANDLER_FECRING ( TSCFEC_PROBLEMINFRAME,
+				       "Frame received while no transaction is waiting for it",
+				       ERRORCODE,
+				       buildCompleteKey(getFecSlot(),getRingSlot(),frame[1],twoBytes ? frame[4] : frame[3],0),
+				       "transaction number", twoBytes ? frame[5] : frame[4],
+				       NULL, frame, NULL, NULL) ;
+  }
+
+  return alarm ;
+}
+
+/** The lock is recursive so the frame transactions done by the thread which holds it are not blocked.
+ * The other threads wait for the release of the lock to send their frames.
+ * \return false if the ring is used by another thread
+ */
+bool FecRingDevice::tryLockRing ( ) {
+
+  return (pthread_mutex_trylock (&ringMutex_) == 0) ;
+}
+
+/** Release the lock taken by tryLockRing
+ */
+void FecRingDevice::unlockRing ( ) {
+
+  pthread_mutex_unlock (&ringMutex_) ;
+}
+
+/** A CCU alarm or a PIA interrupt is a frame sent by a CCU to the FEC with the transaction number 0:
+ * DST (FEC) SRC (CCU) LEN CHANNEL TRANSACTION (0) DATA...
+ * \param frame - frame in 8 bits length
+ * \return true if the frame is an alarm
+ */
+bool FecRingDevice::isCcuAlarmFrame ( tscType8 *frame ) {
+
+  return ( (frame[0] == FRAMEFECNUMBER) && (frame[1] != FRAMEFECNUMBER) &&
+	   !(frame[2] & FEC_LENGTH_2BYTES) && (frame[2] >= 2) && (frame[4] == 0) ) ;
+}
+
+/** Keep a CCU alarm frame received during a transaction, the oldest frame is lost if too many frames are waiting
+ * \param frame - frame in 8 bits length
+ */
+void FecRingDevice::pushCcuAlarmFrame ( tscType8 *frame ) {
+
+  // DST SRC LEN + data + status
+  std::vector<tscType8> alarmFrame (frame, frame + frame[2] + 3 + 1) ;
+
+  pthread_mutex_lock (&alarmFramesMutex_) ;
+  if (alarmFrames_.size() >= MAXCCUALARMFRAMES) {
+    alarmFrames_.pop_front() ;
+    alarmFramesLost_ ++ ;
+  }
+  alarmFrames_.push_back (alarmFrame) ;
+  pthread_mutex_unlock (&alarmFramesMutex_) ;
+}
+
+/** 
+ * \return true if a transaction number is allocated (a frame is waiting for its answer)
+ */
+bool FecRingDevice::isTransactionPending ( ) {
+
+  for (int i = 1 ; i <= MAXTRANSACTIONNUMBER ; i ++)
+    if (busyTransactionNumber[i]) return true ;
+
+  return false ;
+}
+
 // -------------------------------------------------------------------------------------
 //
 //                                For the I2C channel registers 
@@ -7695,8 +7884,8 @@ void FecRingDevice::writeIntoMemory ( keyType index,
 
     // Already downloaded
     downloaded = counter ;
-    AL = (al+ah*255+downloaded) & 0xFF ;
-    AH = ((al+ah*255+downloaded) & 0xFF00) >> 8 ;
+    AL = (al+ah*256+downloaded) & 0xFF ;
+    AH = ((al+ah*256+downloaded) & 0xFF00) >> 8 ;
 
     try {
       // Write it
@@ -7804,8 +7993,8 @@ void FecRingDevice::writeIntoMemory2BytesLength ( keyType index,
       
       // Already downloaded
       downloaded = counter ;
-      AL = (al+ah*255+downloaded) & 0xFF ;
-      AH = ((al+ah*255+downloaded) & 0xFF00) >> 8 ;
+      AL = (al+ah*256+downloaded) & 0xFF ;
+      AH = ((al+ah*256+downloaded) & 0xFF00) >> 8 ;
 
       // Write it
       try {
@@ -8069,11 +8258,395 @@ void FecRingDevice::readFromMemory ( keyType index,
     values[counter-1] &= ~DD_FIFOTRA_EOFRAME_MASK ;
 
     // New position in memory
-    AL = (al+ah*255+counter) & 0xFF ;
-    AH = ((al+ah*255+counter) & 0xFF00) >> 8 ;
+    AL = (al+ah*256+counter) & 0xFF ;
+    AH = ((al+ah*256+counter) & 0xFF00) >> 8 ;
   }
 }
 
+/** Transaction of a block memory transfer: one frame (a part of a segment) waiting for its answers
+ */
+typedef struct {
+  std::list<memoryAccessType>::iterator access ; // segment
+  unsigned long offset ;                         // position of the frame in the segment
+  unsigned long length ;                         // number of bytes in the frame
+  unsigned int words ;                           // 32 bits words expected in the FIFO receive
+  bool dAck ;                                    // direct acknowledge received
+} memoryTransactionType ;
+
+/** Convert a frame of 8 bits words into 32 bits words and add them to a buffer
+ * \param frame - frame (destination, source, length, ...)
+ * \param size - number of bytes in the frame
+ * \param toBeTransmited - buffer
+ * \return number of 32 bits words added
+ */
+static unsigned int packMemoryFrame ( tscType8 *frame, unsigned int size, tscType32 *toBeTransmited ) {
+
+  unsigned int size32 = (size+3) / 4 ;
+  for (unsigned int i = 0, cpt = 0 ; i < size32 ; i ++, cpt += 4) 
+    toBeTransmited[i] = (frame[cpt] << 24) | (frame[cpt+1] << 16) | (frame[cpt+2] << 8) | frame[cpt+3] ;
+
+  return size32 ;
+}
+
+/** Number of 32 bits words in the FIFO receive for a frame of size bytes followed by the status
+ */
+#define MEMORYFRAMEWORDS(size) (((size)+1+3)/4)
+
+/** Read and write segments of memory channels (scatter/gather). Each segment is cut in frames
+ * like in writeIntoMemory/readFromMemory but the frames are not sent one by one: up to maximumTransactions
+ * frames, each with its own transaction number, are sent together with the FIFO block accessors and new frames
+ * are sent as soon as the answers of the previous ones are received. The answers can arrive in any order, they
+ * are put back in the segment with the transaction number.
+ * \param vAccesses - list of segments (see memoryAccessType in deviceFrame.h), the error of each segment is set in the field e
+ * \param maximumTransactions - maximum number of frames waiting for an answer (MAXMEMORYTRANSACTIONS by default)
+ * \exception FecExceptionHandler
+ * <ul>
+ * <li>TSCFEC_SR0NOTNOMINAL: ring lost
+ * <li>DD_FIFOTRA_RUNNING_FLAG_IS_ALWAYS_ON: the frames cannot be sent
+ * </ul>
+ * \warning the exceptions set in the segments must be deleted by the caller
+ * \warning as for writeIntoMemory, the status of the direct acknowledge of the write frames is not checked
+ */
+void FecRingDevice::setBlockMemory ( std::list<memoryAccessType> &vAccesses, 
+                                     unsigned int maximumTransactions ) 
+  throw (FecExceptionHandler) {
+
+  // No CCU alarm read by another thread during the transaction
+  FecRingTransactionLock ringLock (this) ;
+
+  // Check the indexes before any error is set in the segments: nothing to be deleted if one is wrong
+  for (std::list<memoryAccessType>::iterator it = vAccesses.begin() ; it != vAccesses.end() ; it ++) 
+    basicCheckError (it->index) ;
+
+  // Check the segments
+  for (std::list<memoryAccessType>::iterator it = vAccesses.begin() ; it != vAccesses.end() ; it ++) {
+
+    it->e = NULL ;
+    if ((unsigned long)((it->AH << 8) | it->AL) + it->size > MAXMEMORYBYTESADDRESS) {
+      it->e = NEWFECEXCEPTIONHANDLER_INFOSUP ( TSCFEC_INVALIDOPERATION,
+					       "Too many bytes to be accessed in the memory channel",
+					       ERRORCODE,
+					       it->index,
+					       "Size", it->size ) ;
+    }
+  }
+
+  if (maximumTransactions == 0) maximumTransactions = 1 ;
+  if (maximumTransactions > MAXTRANSACTIONNUMBER) maximumTransactions = MAXTRANSACTIONNUMBER ;
+
+  // Size of the frames, same as writeIntoMemory2BytesLength and readFromMemory
+  // the write frames must fit in the FIFO transmit and the direct acknowledges in the FIFO receive
+  unsigned long maxWriteFrame = DD_USER_MAX_MSG_LENGTH*4 ;
+  if (maxWriteFrame > transmitFifoDepth_*4) maxWriteFrame = transmitFifoDepth_*4 ;
+  if (maxWriteFrame > receiveFifoDepth_*4 - 4) maxWriteFrame = receiveFifoDepth_*4 - 4 ;
+  unsigned long maxWriteLength = maxWriteFrame - 9 ; // Dest / Src / LengthH / LengthL / Channel / Transaction / Command / AH / AL
+  unsigned long maxReadLength = DD_USER_MAX_MSG_LENGTH - 6 ;
+#ifdef BUGMEMORY2BYTES
+  maxReadLength -= 2 ; // Memory bus channel error, lenh-lenl has to be increased by 2
+#endif
+
+  std::map<tscType8, memoryTransactionType> tnumSent ;        // frames waiting for an answer
+  unsigned int fifoRecWord = 0 ;                               // words expected in the FIFO receive
+  std::list<memoryAccessType>::iterator itAccess = vAccesses.begin() ; // next segment to be sent
+  unsigned long offset = 0 ;                                   // position in this segment
+  tscType32 toBeTransmited[MAXFECFIFOWORD] ;
+  tscType32 frameReceived[MAXFECFIFOWORD] ;
+  tscType16 fecSR0 ;
+
+  while ((itAccess != vAccesses.end()) || !tnumSent.empty()) {
+
+    /* ************************************************************************************ */
+    /*              Build the frames until the number of transactions or FIFOs are full     */
+    /* ************************************************************************************ */
+    unsigned int wordFifo = 0 ;
+    while ((itAccess != vAccesses.end()) && (tnumSent.size() < maximumTransactions)) {
+
+      // Segment finished or in error
+      if ((offset >= itAccess->size) || (itAccess->e != NULL)) {
+	itAccess ++ ;
+	offset = 0 ;
+	continue ;
+      }
+
+      unsigned long address = ((itAccess->AH << 8) | itAccess->AL) + offset ;
+      tscType8 frame[DD_USER_MAX_MSG_LENGTH*4] ;
+      unsigned int size, words ;
+      unsigned long length ;
+
+      if (itAccess->accessType == MODE_WRITE) {
+
+	// Dest / Src / Length(s) / Channel / Transaction / Command / AH / AL / DW[length]
+	length = (itAccess->size - offset) > maxWriteLength ? maxWriteLength : (itAccess->size - offset) ;
+	unsigned int sizet = length + 5, pos = 3 ;
+	frame[0] = getCcuKey(itAccess->index) ; frame[1] = FRAMEFECNUMBER ;
+	if (sizet > FEC_UPPERLIMIT_LENGTH) {
+	  frame[2] = FEC_LENGTH_2BYTES | ((sizet & 0xFF00) >> 8) ;
+	  frame[pos++] = sizet & 0xFF ;
+	}
+	else frame[2] = sizet ;
+	frame[pos++] = getChannelKey(itAccess->index) ;
+	frame[pos++] = 0 ; // transaction number
+	frame[pos++] = CMD_CHANNELMEMMULTIPLEBYTEWRITE ;
+	frame[pos++] = (address & 0xFF00) >> 8 ;
+	frame[pos++] = address & 0xFF ;
+	memcpy (&frame[pos], &itAccess->values[offset], length*sizeof(tscType8)) ;
+	size = pos + length ;
+
+	// direct acknowledge
+	words = MEMORYFRAMEWORDS(size) ;
+      }
+      else {
+
+	// Dest / Src / Length / Channel / Transaction / Command / AH / AL / LENH / LENL
+	length = (itAccess->size - offset) > maxReadLength ? maxReadLength : (itAccess->size - offset) ;
+	tscType16 lengthAsked = length ;
+#ifdef BUGMEMORY2BYTES
+	lengthAsked += 2 ; // Memory bus channel error, lenh-lenl has to be increased by 2
+#endif
+	frame[0] = getCcuKey(itAccess->index) ; frame[1] = FRAMEFECNUMBER ;
+	frame[3] = getChannelKey(itAccess->index) ;
+	frame[4] = 0 ; // transaction number
+	frame[5] = CMD_CHANNELMEMMULTIPLEBYTEREAD ;
+	frame[6] = (address & 0xFF00) >> 8 ;
+	frame[7] = address & 0xFF ;
+	if (lengthAsked > FEC_UPPERLIMIT_LENGTH) {
+	  frame[2] = 7 ;
+	  frame[8] = ((lengthAsked & 0xFF00) >> 8) | FEC_LENGTH_2BYTES ;
+	  frame[9] = lengthAsked & 0xFF ;
+	}
+	else {
+	  frame[2] = 6 ;
+	  frame[8] = lengthAsked ;
+	}
+	size = frame[2] + 3 ;
+
+	// direct acknowledge + answer: Dest / Src / Length(s) / Channel / Transaction / DATA[length]
+	words = MEMORYFRAMEWORDS(size) + MEMORYFRAMEWORDS(length + 5 + (length + 2 > FEC_UPPERLIMIT_LENGTH ? 1 : 0)) ;
+      }
+
+      // FIFOs full
+      if ( (wordFifo + (size+3)/4 > transmitFifoDepth_) || (fifoRecWord + words > receiveFifoDepth_) ) break ;
+
+      // next transaction number
+      tscType8 tnum = getNextTransactionNumber() ;
+      if (tnum == 0) {
+
+	// Nothing in flight so nothing will release a transaction number
+	if (tnumSent.empty() && !wordFifo) {
+	  itAccess->e = NEWFECEXCEPTIONHANDLER_HARDPOSITION ( DD_NO_MORE_FREE_TRANSACTION_NUMBER,
+							      "No more transaction number available, all are in used",
+							      ERRORCODE,
+							      itAccess->index ) ;
+	  continue ;
+	}
+	break ;
+      }
+      frame[(frame[2] & FEC_LENGTH_2BYTES) ? 5 : 4] = tnum ;
+
+      wordFifo += packMemoryFrame (frame, size, &toBeTransmited[wordFifo]) ;
+      fifoRecWord += words ;
+
+      memoryTransactionType transaction = { itAccess, offset, length, words, false } ;
+      tnumSent[tnum] = transaction ;
+      offset += length ;
+    }
+
+    /* ************************************************************************************ */
+    /*              Send the frames and wait for the end of the FIFO transmit               */
+    /* ************************************************************************************ */
+    if (wordFifo) {
+
+      // Fill the FIFO transmit, clear the errors and send the frames
+      sendFifoTransmit (toBeTransmited, wordFifo) ;
+
+      unsigned long watchdog = 0 ;
+      fecSR0 = getFecRingSR0() ;
+      while ( ((fecSR0 & FEC_SR0_TRARUN) || (!(fecSR0 & FEC_SR0_TRAEMPTY))) && (watchdog++ < loopInTimeWriteFrame_) && (fecSR0 & FEC_SR0_LINKINITIALIZED) ) {
+	fecSR0 = getFecRingSR0() ;
+      }
+
+      if ( (fecSR0 & FEC_SR0_TRARUN) || !(fecSR0 & FEC_SR0_LINKINITIALIZED) ) {
+
+	// Release all the transaction number used
+	for (std::map<tscType8, memoryTransactionType>::iterator it = tnumSent.begin() ; it != tnumSent.end() ; it ++) 
+	  releaseTransactionNumber (it->first) ;
+
+	if (!(fecSR0 & FEC_SR0_LINKINITIALIZED)) {
+	  RAISEFECEXCEPTIONHANDLER_INFOSUP ( TSCFEC_SR0NOTNOMINAL,
+					     "Fails on sending a frame, ring lost",
+					     CRITICALERRORCODE,
+					     buildFecRingKey(getFecSlot(), getRingSlot()),
+					     "FEC status register 0", fecSR0 ) ;
+	}
+	else {
+	  RAISEFECEXCEPTIONHANDLER_INFOSUP ( DD_FIFOTRA_RUNNING_FLAG_IS_ALWAYS_ON,
+					     "FIFO transmit running bit is always on (CR0[3])",
+					     CRITICALERRORCODE,
+					     buildFecRingKey(getFecSlot(), getRingSlot()),
+					     "FEC status register 0", fecSR0 ) ;
+	}
+      }
+
+      // More frames can be sent
+      if ( (itAccess != vAccesses.end()) && (tnumSent.size() < maximumTransactions) && 
+	   (getFecRingSR0() & FEC_SR0_RECEMPTY) ) continue ;
+    }
+
+    /* ************************************************************************************ */
+    /*              Wait for at least one frame in the FIFO receive                         */
+    /* ************************************************************************************ */
+    if (tnumSent.empty()) continue ;
+
+    unsigned long watchdog = 0 ;
+    fecSR0 = getFecRingSR0() ;
+    while ( (fecSR0 & FEC_SR0_RECEMPTY) && (watchdog++ < loopInTimeReadFrame_) && (fecSR0 & FEC_SR0_LINKINITIALIZED) ) {
+      fecSR0 = getFecRingSR0() ;
+    }
+
+    if ( (fecSR0 & FEC_SR0_RECEMPTY) || !(fecSR0 & FEC_SR0_LINKINITIALIZED) ) {
+
+      // No answer for the frames in flight: the segments are in error
+      for (std::map<tscType8, memoryTransactionType>::iterator it = tnumSent.begin() ; it != tnumSent.end() ; it ++) {
+
+	if (it->second.access->e == NULL) {
+	  if (!(fecSR0 & FEC_SR0_LINKINITIALIZED)) 
+	    it->second.access->e = NEWFECEXCEPTIONHANDLER_INFOSUP ( TSCFEC_SR0NOTNOMINAL,
+								    "Fails on sending a frame, ring lost",
+								    CRITICALERRORCODE,
+								    buildFecRingKey(getFecSlot(), getRingSlot()),
+								    "FEC status register 0", fecSR0 ) ;
+	  else if (it->second.dAck)
+	    it->second.access->e = NEWFECEXCEPTIONHANDLER_HARDPOSITION ( DD_CANNOT_READ_DATA,
+									 "Unable to read a frame, timeout reached",
+									 ERRORCODE,
+									 it->second.access->index ) ;
+	  else
+	    it->second.access->e = NEWFECEXCEPTIONHANDLER_HARDPOSITION ( DD_WRITE_OPERATION_FAILED,
+									 "Timeout reached on the direct acknowledge",
+									 ERRORCODE,
+									 it->second.access->index ) ;
+	}
+	releaseTransactionNumber (it->first) ;
+      }
+      tnumSent.clear() ;
+      fifoRecWord = 0 ;
+
+      if (!(fecSR0 & FEC_SR0_LINKINITIALIZED)) {
+	RAISEFECEXCEPTIONHANDLER_INFOSUP ( TSCFEC_SR0NOTNOMINAL,
+					   "Fails on reading a frame, ring lost",
+					   CRITICALERRORCODE,
+					   buildFecRingKey(getFecSlot(), getRingSlot()),
+					   "FEC status register 0", fecSR0 ) ;
+      }
+      continue ;
+    }
+
+    /* ************************************************************************************ */
+    /*              Read all the frames in the FIFO receive                                 */
+    /* ************************************************************************************ */
+    while (!((fecSR0 = getFecRingSR0()) & FEC_SR0_RECEMPTY)) {
+
+      // Wait for the end of the reception of the frame
+      watchdog = 0 ;
+      while ( (fecSR0 & FEC_SR0_RECRUN) && (watchdog++ < loopInTimeReadFrame_) ) fecSR0 = getFecRingSR0() ;
+
+      // Size of the frame
+      frameReceived[0] = getFifoReceive() ;
+      unsigned int realSize = (frameReceived[0] >> 8) & 0xFF ;
+      if (realSize & FEC_LENGTH_2BYTES) realSize = ((realSize & 0x7F) << 8) + (frameReceived[0] & 0xFF) + 1 ;
+      unsigned int realSize32 = MEMORYFRAMEWORDS(realSize+3) ;
+
+      if (realSize32 > MAXFECFIFOWORD) {
+
+	std::cerr << __func__ << ": the frame received has an incorrect size (size = " << std::dec << realSize << ")" << std::endl ;
+
+	// emptied the FIFO, the frames in flight are lost and will be in timeout
+	checkFifoReceive ( ) ;
+	break ;
+      }
+
+      getFifoReceive (frameReceived+1, realSize32-1) ;
+      tscType8 frame[MAXFECFIFOWORD*4] ;
+      for (unsigned int i = 0, cpt = 0 ; i < realSize32 ; i ++) {
+	frame[cpt++] = (frameReceived[i] >> 24) & 0xFF ;
+	frame[cpt++] = (frameReceived[i] >> 16) & 0xFF ;
+	frame[cpt++] = (frameReceived[i] >>  8) & 0xFF ;
+	frame[cpt++] = (frameReceived[i])       & 0xFF ;
+      }
+
+      // CCU alarms and PIA interrupts are kept for getCcuAlarmFrame
+      if (isCcuAlarmFrame(frame)) {
+	pushCcuAlarmFrame(frame) ;
+	continue ;
+      }
+
+      // Transaction and channel
+      bool twoBytes = frame[2] & FEC_LENGTH_2BYTES ;
+      tscType8 tnum = frame[twoBytes ? 5 : 4] ;
+      keyType checkIndex = buildCompleteKey(getFecSlot(), getRingSlot(), frame[0] != FRAMEFECNUMBER ? frame[0] : frame[1], frame[twoBytes ? 4 : 3], 0) ;
+
+      std::map<tscType8, memoryTransactionType>::iterator it = tnumSent.find(tnum) ;
+      if ( (it == tnumSent.end()) || (checkIndex != getFecRingCcuChannelKey(it->second.access->index)) ) {
+
+	std::cerr << "*************************************** ERROR ****************************************" << std::endl ;
+	std::cerr << __func__ << ": bad frame received, the transaction number " << std::dec << (int)tnum 
+		  << " does not correspond to any memory transaction sent" << std::endl ;
+	std::cerr << "**************************************************************************************" << std::endl ;
+	continue ;
+      }
+
+      memoryTransactionType &transaction = it->second ;
+      bool finished = false ;
+
+      if (frame[0] != FRAMEFECNUMBER) { 
+
+	// Direct acknowledge
+	transaction.dAck = true ;
+	if (transaction.access->accessType == MODE_WRITE) finished = true ;
+	else if (frame[realSize+3] != FECACKNOERROR32) {
+	  
+	  if (transaction.access->e == NULL)
+	    transaction.access->e = NEWFECEXCEPTIONHANDLER_INFOSUP ( DD_DATA_CORRUPT_ON_WRITE,
+								     "Bad direct acknowledge status",
+								     ERRORCODE,
+								     transaction.access->index,
+								     "direct acknowledge", frame[realSize+3] ) ;
+	  finished = true ;
+	}
+      }
+      else {
+
+	// Answer: Channel / Transaction / DATA
+	unsigned int length = twoBytes ? (((frame[2] & 0x7F) << 8) | frame[3]) - 2 : frame[2] - 2 ;
+	if (length != transaction.length) {
+
+	  if (transaction.access->e == NULL) 
+	    transaction.access->e = NEWFECEXCEPTIONHANDLER_INFOSUP ( TSCFEC_PROBLEMINFRAME,
+								     "Memory channel read error in multiple byte mode, the size expected is different than the size received",
+								     ERRORCODE,
+								     transaction.access->index,
+								     "Frame size", length ) ;
+	}
+	else memcpy (&transaction.access->values[transaction.offset], &frame[twoBytes ? 6 : 5], length*sizeof(tscType8)) ;
+
+	finished = true ;
+      }
+
+      if (finished) {
+	fifoRecWord -= transaction.words ;
+	releaseTransactionNumber (tnum) ;
+	tnumSent.erase (it) ;
+      }
+    }
+
+    //clean up interrupts and unset the DATATOFEC bit in SR0
+    setFecRingCR1 (FEC_CR1_CLEARIRQ) ;
+  }
+
+  // Clear errors on FEC and CCU
+  setFecRingCR1 ( FEC_CR1_CLEARIRQ | FEC_CR1_CLEARERRORS ) ;
+}
+
 // -------------------------------------------------------------------------------------
 //
 //                                For the trigger channel
@@ -8278,6 +8851,23 @@ void FecRingDevice::setFifoTransmit ( tscType32 *value, int count ) throw (FecEx
   for(i=0;i<count;i++) setFifoTransmit(value[i]) ;
 }
   
+/** Send the frames of a block: fill the FIFO transmit, clear the errors and toggle the send bit
+ * of the control register 0. The FECs with a costly access (USB) send these accesses in one transfer.
+ * \param value - words of the frames (array)
+ * \param count - number of words
+ */
+void FecRingDevice::sendFifoTransmit ( tscType32 *value, int count ) throw (FecExceptionHandler) {
+
+  // Fill the FIFO transmit
+  setFifoTransmit (value, count) ;
+
+  // Clear the error bit
+  setFecRingCR1 ( DD_FEC_CLEAR_ERRORS ) ;
+  // Toggle the send bit of CTRLO with RMW operation
+  setFecRingCR0 ( FEC_CR0_SEND | FEC_CR0_ENABLEFEC, CMD_OR ) ;
+  setFecRingCR0 ( FEC_CR0_SEND | FEC_CR0_ENABLEFEC, CMD_XOR ) ;
+}
+
 /** read a set of words from the FIFO transmit
  * \param value - value to be read
  * \param count - number of value to be read
@@ -8483,11 +9073,17 @@ unsigned int FecRingDevice::buildPIAFrame ( accessDeviceType b, tscType32 *toBeT
 /** This methods takes an array of values to be set and send it over the ring. It collects afterwards the direct acknoledge and return an array of exceptions or null or no problems arrives. Please note that the array of exceptions must be deleted by the remote user of the method. This methods make also a sort in the array depending of the CCU/channel to be accessed.
  * \warning All the accessDeviceType must be initialise with dAck = 0 and sent = false
  * \warning if this method encounters a register problem, the rest of the registers will be sent and the same exception (pointer point of view) is set in all the request to that device. So do not delete directly all the exception from the list returned
+ * \param vAccessDevices - list of frames
+ * \param forceAcknowledge - force acknowledge for the i2c channels
+ * \param errorRecorder - recorder of the frame errors, NULL to create an exception for each frame
  */
-void FecRingDevice::setBlockDevices ( std::list<accessDeviceType> &vAccessDevices, bool forceAcknowledge ) throw (FecExceptionHandler) {
+void FecRingDevice::setBlockDevices ( std::list<accessDeviceType> &vAccessDevices, bool forceAcknowledge, FecErrorRecorder *errorRecorder ) throw (FecExceptionHandler) {
+
+  // No CCU alarm read by another thread during the transaction
+  FecRingTransactionLock ringLock (this) ;
 
   if (firmwareVersion_ >= MINFIRMWAREVERSION) {
-    setBlockDevicesBltMode(vAccessDevices, forceAcknowledge) ;
+    setBlockDevicesBltMode(vAccessDevices, forceAcknowledge, errorRecorder) ;
     return ;
   }
 
@@ -8535,7 +9131,6 @@ void FecRingDevice::setBlockDevices ( std::list<accessDeviceType> &vAccessDevice
   // No busy channel
   for (std::list<accessDeviceType>::iterator itAccessDevice = vAccessDevices.begin() ; itAccessDevice != vAccessDevices.end() ; itAccessDevice ++) {
     busy[getFecRingCcuChannelKey(itAccessDevice->index)] = 0 ;
-    errorDevice[itAccessDevice->index] = NULL ;
 
 #ifdef DEBUGMSGERRORMF
     char msg[80] ;
@@ -8632,10 +9227,10 @@ void FecRingDevice::setBlockDevices ( std::list<accessDeviceType> &vAccessDevice
 		  std::cerr << "Device " << msg << std::endl ;
 #endif
 		  
-		  itAccessDevice->e = NEWFECEXCEPTIONHANDLER_HARDPOSITION ( DD_CANNOT_READ_DATA,
+		  itAccessDevice->e = NEWFRAMEERROR ( errorRecorder, DD_CANNOT_READ_DATA,
 							       "Unable to read a frame or the direct acknowledge, timeout reached",
 							       ERRORCODE,
-							       itAccessDevice->index ) ;
+							       itAccessDevice->index, *itAccessDevice, "Not filled", 0 ) ;
 
 #ifdef DEBUGMSGERRORMF
 		  std::cerr << itAccessDevice->e->what() << std::endl ;
@@ -8650,10 +9245,10 @@ void FecRingDevice::setBlockDevices ( std::list<accessDeviceType> &vAccessDevice
 		  std::cerr << "Device = " << msg << std::endl ;
 #endif
 		
-		  itAccessDevice->e = NEWFECEXCEPTIONHANDLER_HARDPOSITION ( DD_CANNOT_READ_DATA,
+		  itAccessDevice->e = NEWFRAMEERROR ( errorRecorder, DD_CANNOT_READ_DATA,
 									    "Unable to read a frame or the force acknowledge, timeout reached",
 									    ERRORCODE,
-									    itAccessDevice->index ) ;
+									    itAccessDevice->index, *itAccessDevice, "Not filled", 0 ) ;
 
 #ifdef DEBUGMSGERRORMF
 		  std::cerr << itAccessDevice->e->what() << std::endl ;
@@ -8748,20 +9343,14 @@ void FecRingDevice::setBlockDevices ( std::list<accessDeviceType> &vAccessDevice
     /* **************************************************************************************************************************** */ 
     if (itemSent) {
 
-      // Fill the FIFO transmit
-      setFifoTransmit(toBeTransmited,wordFifo); 
-
 #ifdef DEBUGMSGERRORMF
       for (int frameS = 0 ; frameS < wordFifo ; frameS ++) {
 	std::cout << std::hex << toBeTransmited[frameS] << std::endl ;
       }
 #endif
 
-      // Clear the error bit
-      setFecRingCR1 ( DD_FEC_CLEAR_ERRORS ) ;
-      // Toggle the send bit of CTRLO with RMW operation
-      setFecRingCR0 ( FEC_CR0_SEND | FEC_CR0_ENABLEFEC, CMD_OR ) ;
-      setFecRingCR0 ( FEC_CR0_SEND | FEC_CR0_ENABLEFEC, CMD_XOR ) ;
+      // Fill the FIFO transmit, clear the errors and send the frames
+      sendFifoTransmit(toBeTransmited,wordFifo); 
 
 #ifdef DEBUGMSGERRORMF
       std::cout << "Send " << itemSent << " frames over the ring" << std::endl ;
@@ -8875,17 +9464,17 @@ void FecRingDevice::setBlockDevices ( std::list<accessDeviceType> &vAccessDevice
 	      // permanent error
 	      FecExceptionHandler *e ;
 	      if (!(fecSR0 & FEC_SR0_LINKINITIALIZED)) {
-		e = NEWFECEXCEPTIONHANDLER_INFOSUP ( TSCFEC_SR0NOTNOMINAL,
+		e = NEWRINGERROR ( errorRecorder, TSCFEC_SR0NOTNOMINAL,
 						     "Fails on sending a frame, ring lost",
 						     CRITICALERRORCODE,
 						     buildFecRingKey(getFecSlot(), getRingSlot()),
 						     "FEC status register 0", fecSR0 ) ;
 	      }
 	      else {
-		e = NEWFECEXCEPTIONHANDLER_HARDPOSITION ( DD_WRITE_OPERATION_FAILED,
+		e = NEWFRAMEERROR ( errorRecorder, DD_WRITE_OPERATION_FAILED,
 							  "Timeout reached on the direct acknowledge",
 							  ERRORCODE,
-							  p->second->index ) ;
+							  p->second->index, *p->second, "Not filled", 0 ) ;
 	      }
 
 	      p->second->e = e ;
@@ -8976,7 +9565,7 @@ void FecRingDevice::setBlockDevices ( std::list<accessDeviceType> &vAccessDevice
 		p->second->sent = false ; // not sent
 	      else {
 		// permanent error
-		p->second->e = NEWFECEXCEPTIONHANDLER_INFOSUP ( DD_TOO_LONG_FRAME_LENGTH,
+		p->second->e = NEWRINGERROR ( errorRecorder, DD_TOO_LONG_FRAME_LENGTH,
 								"Size in frame is bigger than the FIFO size",
 								CRITICALERRORCODE,
 								buildFecRingKey(getFecSlot(), getRingSlot()),
@@ -9034,13 +9623,18 @@ void FecRingDevice::setBlockDevices ( std::list<accessDeviceType> &vAccessDevice
 	/*                                           And check if it is a direct ack. or force ack. or read answer                      */
 	/* **************************************************************************************************************************** */ 	
 	// Check if a frame with this transaction number has been sent and check if the index received is the same than the index expected (sent)
+	// CCU alarms and PIA interrupts are not related to a transaction, they are kept for getCcuAlarmFrame
 	keyType checkIndex = 0 ;
 	if (frame[0] != FRAMEFECNUMBER)
 	  checkIndex = buildCompleteKey(getFecSlot(),getRingSlot(),frame[0],frame[2] & FEC_LENGTH_2BYTES ? frame[4] : frame[3], 0) ;
 	else
 	  checkIndex = buildCompleteKey(getFecSlot(),getRingSlot(),frame[1],frame[2] & FEC_LENGTH_2BYTES ? frame[4] : frame[3], 0) ;
 
-	if ((tnumSent.find(tnum) != tnumSent.end()) && (checkIndex == getFecRingCcuChannelKey(tnumSent[tnum]->index))) {
+	if (realSize32 && isCcuAlarmFrame(frame)) {
+
+	  pushCcuAlarmFrame(frame) ;
+	}
+	else if ((tnumSent.find(tnum) != tnumSent.end()) && (checkIndex == getFecRingCcuChannelKey(tnumSent[tnum]->index))) {
 
 #ifdef DEBUGMSGERRORMF
 	  char msg[80] ;
@@ -9079,10 +9673,10 @@ void FecRingDevice::setBlockDevices ( std::list<accessDeviceType> &vAccessDevice
 // 	      else 
 	      {
 		// Frame not ok => error
-		tnumSent[tnum]->e = NEWFECEXCEPTIONHANDLER_INFOSUP ( DD_DATA_CORRUPT_ON_WRITE,
+		tnumSent[tnum]->e = NEWFRAMEERROR ( errorRecorder, DD_DATA_CORRUPT_ON_WRITE,
 								     "Bad status in read frame",
 								     ERRORCODE,
-								     tnumSent[tnum]->index,
+								     tnumSent[tnum]->index, *tnumSent[tnum],
 								     "Status of read frame", frame[frame[2] +3] ) ;
 
 #ifdef DEBUGMSGERRORMF
@@ -9132,10 +9726,10 @@ void FecRingDevice::setBlockDevices ( std::list<accessDeviceType> &vAccessDevice
 	      
 		// Error in size
 		if (frame[2] != 3) {
-		  tnumSent[tnum]->e = NEWFECEXCEPTIONHANDLER_INFOSUP ( TSCFEC_PROBLEMINFRAME,
+		  tnumSent[tnum]->e = NEWFRAMEERROR ( errorRecorder, TSCFEC_PROBLEMINFRAME,
 								       "The size expected is different than the size received (bad size in frame, should be 3)",
 								       ERRORCODE,
-								       tnumSent[tnum]->index,
+								       tnumSent[tnum]->index, *tnumSent[tnum],
 								       "Frame size", frame[2] ) ;
 
 #ifdef DEBUGMSGERRORMF
@@ -9144,10 +9738,10 @@ void FecRingDevice::setBlockDevices ( std::list<accessDeviceType> &vAccessDevice
 		}
 		else {
 		  // Error in status
-		  tnumSent[tnum]->e = NEWFECEXCEPTIONHANDLER_INFOSUP ( DD_DATA_CORRUPT_ON_WRITE,
+		  tnumSent[tnum]->e = NEWFRAMEERROR ( errorRecorder, DD_DATA_CORRUPT_ON_WRITE,
 								       "Write mode, the force acknowledge is not correct",
 								       ERRORCODE,
-								       tnumSent[tnum]->index,
+								       tnumSent[tnum]->index, *tnumSent[tnum],
 								       "Status of read frame", frame[5] ) ;
 
 #ifdef DEBUGMSGERRORMF
@@ -9176,17 +9770,17 @@ void FecRingDevice::setBlockDevices ( std::list<accessDeviceType> &vAccessDevice
 	      
 		// Not an error from the device driver
 		if (frame[2] != 4) {
-		  tnumSent[tnum]->e = NEWFECEXCEPTIONHANDLER_INFOSUP ( TSCFEC_PROBLEMINFRAME,
+		  tnumSent[tnum]->e = NEWFRAMEERROR ( errorRecorder, TSCFEC_PROBLEMINFRAME,
 								       "The size expected is different than the size received (bad size in frame, should be 4)",
 								       ERRORCODE,
-								       tnumSent[tnum]->index,
+								       tnumSent[tnum]->index, *tnumSent[tnum],
 								       "Frame size", frame[2] ) ;
 		}
 		else {
-		  tnumSent[tnum]->e =  NEWFECEXCEPTIONHANDLER_INFOSUP ( DD_DATA_CORRUPT_ON_WRITE,
+		  tnumSent[tnum]->e =  NEWFRAMEERROR ( errorRecorder, DD_DATA_CORRUPT_ON_WRITE,
 									"Bad direct acknowledge status",
 									ERRORCODE,
-									tnumSent[tnum]->index,
+									tnumSent[tnum]->index, *tnumSent[tnum],
 									"direct acknowledge", frame[realSize +3] ) ;
 		}
 
@@ -9303,10 +9897,10 @@ void FecRingDevice::setBlockDevices ( std::list<accessDeviceType> &vAccessDevice
 	  std::cerr << "Device " << msg << std::endl ;
 #endif    
 
-	  p->second->e = NEWFECEXCEPTIONHANDLER_HARDPOSITION ( DD_WRITE_OPERATION_FAILED,
+	  p->second->e = NEWFRAMEERROR ( errorRecorder, DD_WRITE_OPERATION_FAILED,
 							       "Timeout reached on the direct acknowledge",
 							       ERRORCODE,
-							       p->second->index ) ;
+							       p->second->index, *p->second, "Not filled", 0 ) ;
 	
 #ifdef DEBUGMSGERRORMF
 	  std::cerr << p->second->e->what() << std::endl ;
@@ -9329,10 +9923,10 @@ void FecRingDevice::setBlockDevices ( std::list<accessDeviceType> &vAccessDevice
 	    std::cerr << "Device = " << msg << std::endl ;
 #endif
 	    
-	    p->second->e = NEWFECEXCEPTIONHANDLER_HARDPOSITION ( DD_READ_FRAME_CORRUPTED,
+	    p->second->e = NEWFRAMEERROR ( errorRecorder, DD_READ_FRAME_CORRUPTED,
 								 "Unable to read a frame, timeout reached",
 								 ERRORCODE,
-								 p->second->index ) ;
+								 p->second->index, *p->second, "Not filled", 0 ) ;
 	    
 #ifdef DEBUGMSGERRORMF
 	    std::cerr << p->second->e->what() << std::endl ;
@@ -9418,9 +10012,10 @@ void FecRingDevice::setBlockDevices ( std::list<accessDeviceType> &vAccessDevice
  * \param tnumSent - all the transaction number used
  * \param busy - busy channels
  * \param cptRead - number of read expected (or force acknowledge or read requests)
+ * \param errorRecorder - recorder of the frame errors, NULL to create an exception for each frame
  */
 void FecRingDevice::getBlockFrames ( bool forceChannelAck, accessTransactionFrameMap &tnumSent,
-				     Sgi::hash_map<keyType, int> & busy, unsigned int & cptRead )
+				     Sgi::hash_map<keyType, int> & busy, unsigned int & cptRead, FecErrorRecorder *errorRecorder )
   throw (FecExceptionHandler) {
   
   //#define DEBUGMSGERROR_DISPLAYMULTIPLEFRAMES 
@@ -9646,7 +10241,12 @@ void FecRingDevice::getBlockFrames ( bool forceChannelAck, accessTransactionFram
 	  checkIndex = buildCompleteKey(getFecSlot(),getRingSlot(),frame[1],frame[2] & FEC_LENGTH_2BYTES ? frame[4] : frame[3], 0) ;
 	
 	// Is the frame related to a transaction already sent and is the index is coherent
-	if ((tnumSent.find(tnum) != tnumSent.end()) && (checkIndex == getFecRingCcuChannelKey(tnumSent[tnum]->index))) {
+	// CCU alarms and PIA interrupts are not related to a transaction, they are kept for getCcuAlarmFrame
+	if (realSize32 && isCcuAlarmFrame(frame)) {
+
+	  pushCcuAlarmFrame(frame) ;
+	}
+	else if ((tnumSent.find(tnum) != tnumSent.end()) && (checkIndex == getFecRingCcuChannelKey(tnumSent[tnum]->index))) {
 
 	  // -------------------------------------------------
 	  // Direct acknowledge analysis
@@ -9663,10 +10263,10 @@ void FecRingDevice::getBlockFrames ( bool forceChannelAck, accessTransactionFram
 	    if (frame[frame[2] + 3] != FECACKNOERROR32) { // bad direct acknowledge
 	    
 	      // Frame not ok => error
-	      tnumSent[tnum]->e = NEWFECEXCEPTIONHANDLER_INFOSUP ( DD_DATA_CORRUPT_ON_WRITE,
+	      tnumSent[tnum]->e = NEWFRAMEERROR ( errorRecorder, DD_DATA_CORRUPT_ON_WRITE,
 								   "Bad status in frame",
 								   ERRORCODE,
-								   tnumSent[tnum]->index,
+								   tnumSent[tnum]->index, *tnumSent[tnum],
 								   "Status of frame", frame[frame[2] +3] ) ;
 		  
 #ifdef DEBUGMSGERRORMF
@@ -9722,19 +10322,28 @@ void FecRingDevice::getBlockFrames ( bool forceChannelAck, accessTransactionFram
 
 	      // Not an error from the device driver
 	      if (frame[2] != sizeExpected) {
-		std::stringstream msgError ; msgError << "Size expected is not correct: " << std::dec << (int)frame[2] << " / " << sizeExpected ;
-		tnumSent[tnum]->e = NEWFECEXCEPTIONHANDLER_INFOSUP (TSCFEC_PROBLEMINFRAME,
-								    msgError.str(),
-								    ERRORCODE,
-								    tnumSent[tnum]->index,
-								    "Size in frame", frame[2]) ;
+		if (errorRecorder != NULL) {
+		  tnumSent[tnum]->e = NEWFRAMEERROR ( errorRecorder, TSCFEC_PROBLEMINFRAME,
+						      "Size expected is not correct",
+						      ERRORCODE,
+						      tnumSent[tnum]->index, *tnumSent[tnum],
+						      "Size in frame", frame[2] ) ;
+		}
+		else {
+		  std::stringstream msgError ; msgError << "Size expected is not correct: " << std::dec << (int)frame[2] << " / " << sizeExpected ;
+		  tnumSent[tnum]->e = NEWFECEXCEPTIONHANDLER_INFOSUP (TSCFEC_PROBLEMINFRAME,
+								      msgError.str(),
+								      ERRORCODE,
+								      tnumSent[tnum]->index,
+								      "Size in frame", frame[2]) ;
+		}
 	      }
 	      else {
-		tnumSent[tnum]->e = NEWFECEXCEPTIONHANDLER_INFOSUP (TSCFEC_BADFACKORREADANS,
+		tnumSent[tnum]->e = NEWFRAMEERROR ( errorRecorder, TSCFEC_BADFACKORREADANS,
 								    "Status of the force acknowledge is not correct",
 								    ERRORCODE,
-								    tnumSent[tnum]->index,
-								    "Status of the FACK", frame[positionFrameStatus]) ;
+								    tnumSent[tnum]->index, *tnumSent[tnum],
+								    "Status of the FACK", frame[positionFrameStatus] ) ;
 
 	      }
 
@@ -9836,10 +10445,10 @@ void FecRingDevice::getBlockFrames ( bool forceChannelAck, accessTransactionFram
 	  if ((p->second->accessType == MODE_READ) || forceChannelAck) cptRead -- ;
 	  countFrameTemp ++ ;
 
-	  p->second->e = NEWFECEXCEPTIONHANDLER_HARDPOSITION ( CODECONSISTENCYERROR,
+	  p->second->e = NEWFRAMEERROR ( errorRecorder, CODECONSISTENCYERROR,
 							       "frame has not been sent over the ring for unknown reason",
 							       ERRORCODE,
-							       p->second->index ) ;
+							       p->second->index, *p->second, "Not filled", 0 ) ;
 
 	  std::cerr << "The following frame has not been sent for unknown reason" << std::endl ;
 	  DeviceFrame::displayAccessDeviceType(*p->second) ;
@@ -9853,17 +10462,17 @@ void FecRingDevice::getBlockFrames ( bool forceChannelAck, accessTransactionFram
 
 	  tscType16 fecSR0 =getFecRingSR0() ; 
 	  if (!(fecSR0 & FEC_SR0_LINKINITIALIZED)) {
-	    p->second->e = NEWFECEXCEPTIONHANDLER_INFOSUP ( TSCFEC_SR0NOTNOMINAL,
+	    p->second->e = NEWRINGERROR ( errorRecorder, TSCFEC_SR0NOTNOMINAL,
 							    "Fails on sending a frame, ring lost",
 							    CRITICALERRORCODE,
 							    buildFecRingKey(getFecSlot(), getRingSlot()),
 							    "FEC status register 0", fecSR0 ) ;
 	  }
 	  else {
-	    p->second->e = NEWFECEXCEPTIONHANDLER_INFOSUP (  DD_WRITE_OPERATION_FAILED,
+	    p->second->e = NEWFRAMEERROR ( errorRecorder, DD_WRITE_OPERATION_FAILED,
 							     "Timeout reached on the direct acknowledge",
 							     ERRORCODE,
-							     p->second->index,
+							     p->second->index, *p->second,
 							     "FEC status register 0", fecSR0 ) ;
 	  }
 
@@ -9882,25 +10491,27 @@ void FecRingDevice::getBlockFrames ( bool forceChannelAck, accessTransactionFram
 
 	  cptRead -- ;
 
-	  p->second->e = NEWFECEXCEPTIONHANDLER_HARDPOSITION ( DD_CANNOT_READ_DATA,
+	  p->second->e = NEWFRAMEERROR ( errorRecorder, DD_CANNOT_READ_DATA,
 							       "Unable to read a frame or the force acknowledge, timeout reached",
 							       ERRORCODE,
-							       p->second->index ) ;
+							       p->second->index, *p->second, "Not filled", 0 ) ;
 
 #ifdef DEBUGMSGERROR_DISPLAYMULTIPLEFRAMES
 	  std::cerr << p->second->e->what() << std::endl ;
 #endif
 
- 	  // ??????????????????????????????????????????????????????????????????
- 	  std::cerr << p->second->e->what() << std::endl ;
- 	  std::cerr << "CCU 0x" << std::hex << (int)getCcuKey(p->second->index) << std::endl ;
- 	  std::cerr << "FEC CR0 = " << std::hex << (int)getFecRingCR0() << std::endl ;
- 	  std::cerr << "FEC SR0 = " << std::hex << (int)getFecRingSR0() << std::endl ;
- 	  std::cerr << "FEC SR1 = " << std::hex << (int)getFecRingSR1() << std::endl ;
- 	  std::cerr << "CCU SRA = " << std::hex << (int)getCcuSRA(p->second->index) << std::endl ;
- 	  std::cerr << "CCU CRE = " << std::hex << (int)getCcuCRE(p->second->index) << std::endl ;
- 	  std::cerr << "CCU SRE = " << std::hex << (int)getCcuSRE(p->second->index) << std::endl ;
- 	  std::cerr << "Channel enabled 0x" << std::hex << getChannelKey(p->second->index) << ": " << isChannelEnabled(p->second->index) << std::endl ;
+	  // Registers dumped for each frame only when the errors are not recorded
+	  if (errorRecorder == NULL) {
+	    std::cerr << p->second->e->what() << std::endl ;
+	    std::cerr << "CCU 0x" << std::hex << (int)getCcuKey(p->second->index) << std::endl ;
+	    std::cerr << "FEC CR0 = " << std::hex << (int)getFecRingCR0() << std::endl ;
+	    std::cerr << "FEC SR0 = " << std::hex << (int)getFecRingSR0() << std::endl ;
+	    std::cerr << "FEC SR1 = " << std::hex << (int)getFecRingSR1() << std::endl ;
+	    std::cerr << "CCU SRA = " << std::hex << (int)getCcuSRA(p->second->index) << std::endl ;
+	    std::cerr << "CCU CRE = " << std::hex << (int)getCcuCRE(p->second->index) << std::endl ;
+	    std::cerr << "CCU SRE = " << std::hex << (int)getCcuSRE(p->second->index) << std::endl ;
+	    std::cerr << "Channel enabled 0x" << std::hex << getChannelKey(p->second->index) << ": " << isChannelEnabled(p->second->index) << std::endl ;
+	  }
 
 	  // Release the transaction number used
 	  releaseTransactionNumber (p->second->tnum) ;
@@ -9958,10 +10569,16 @@ void FecRingDevice::getBlockFrames ( bool forceChannelAck, accessTransactionFram
 /** This methods takes an array of values to be set and send it over the ring. It collects afterwards the direct acknoledge and return an array of exceptions or null or no problems arrives. Please note that the array of exceptions must be deleted by the remote user of the method. This methods make also a sort in the array depending of the CCU/channel to be accessed.
  * \warning All the accessDeviceType must be initialise with dAck = 0 and sent = false
  * \warning if this method encounters a register problem, the rest of the registers will be sent and the same exception (pointer point of view) is set in all the request to that device. So do not delete directly all the exception from the list returned
+ * \param vAccessDevices - list of frames
+ * \param forceAcknowledge - force acknowledge for the i2c channels
+ * \param errorRecorder - recorder of the frame errors, NULL to create an exception for each frame
  */
-void FecRingDevice::setBlockDevicesBltMode ( std::list<accessDeviceType> &vAccessDevices, bool forceAcknowledge )
+void FecRingDevice::setBlockDevicesBltMode ( std::list<accessDeviceType> &vAccessDevices, bool forceAcknowledge, FecErrorRecorder *errorRecorder )
   throw (FecExceptionHandler) {
 
+  // No CCU alarm read by another thread during the transaction
+  FecRingTransactionLock ringLock (this) ;
+
   //#define DEBUGMSGERROR_DISPLAYMULTIPLEFRAMES 
   //#define DEBUGMSGERRORMF
 
@@ -10004,7 +10621,6 @@ void FecRingDevice::setBlockDevicesBltMode ( std::list<accessDeviceType> &vAcces
   // No busy channel
   for (std::list<accessDeviceType>::iterator itAccessDevice = vAccessDevices.begin() ; itAccessDevice != vAccessDevices.end() ; itAccessDevice ++) {
     busy[getFecRingCcuChannelKey(itAccessDevice->index)] = 0 ;
-    errorDevice[itAccessDevice->index] = NULL ;
 
 #ifdef DEBUGMSGERRORMF
     char msg[80] ;
@@ -10098,10 +10714,10 @@ void FecRingDevice::setBlockDevicesBltMode ( std::list<accessDeviceType> &vAcces
 		  std::cerr << "Device " << msg << std::endl ;
 #endif
 		  
-		  itAccessDevice->e = NEWFECEXCEPTIONHANDLER_HARDPOSITION ( DD_WRITE_OPERATION_FAILED,
+		  itAccessDevice->e = NEWFRAMEERROR ( errorRecorder, DD_WRITE_OPERATION_FAILED,
 									    "Timeout reached on the direct acknowledge",
 									    ERRORCODE,
-									    itAccessDevice->index ) ;
+									    itAccessDevice->index, *itAccessDevice, "Not filled", 0 ) ;
 
 #ifdef DEBUGMSGERRORMF
 		  std::cerr << itAccessDevice->e->what() << std::endl ;
@@ -10116,10 +10732,10 @@ void FecRingDevice::setBlockDevicesBltMode ( std::list<accessDeviceType> &vAcces
 		  std::cerr << "Device = " << msg << std::endl ;
 #endif
 		
-		  itAccessDevice->e = NEWFECEXCEPTIONHANDLER_HARDPOSITION ( DD_CANNOT_READ_DATA,
+		  itAccessDevice->e = NEWFRAMEERROR ( errorRecorder, DD_CANNOT_READ_DATA,
 									    "Unable to read a frame or the force acknowledge, timeout reached",
 									    ERRORCODE,
-									    itAccessDevice->index ) ;
+									    itAccessDevice->index, *itAccessDevice, "Not filled", 0 ) ;
 
 #ifdef DEBUGMSGERRORMF
 		  std::cerr << itAccessDevice->e->what() << std::endl ;
@@ -10220,18 +10836,12 @@ void FecRingDevice::setBlockDevicesBltMode ( std::list<accessDeviceType> &vAcces
 
     if (itemSent) {
 
-      // Fill the FIFO transmit
-      setFifoTransmit(toBeTransmited,wordFifo); 
-
       //for (unsigned int  i = 0 ; i < wordFifo ; i ++) {
       //std::cout << __func__ << ": 0x" << std::hex << std::setw(8) << std::setfill('0') << toBeTransmited[i] << std::endl ;
       //}
 
-      // Clear the error bit
-      setFecRingCR1 ( DD_FEC_CLEAR_ERRORS ) ;
-      // Toggle the send bit of CTRLO with RMW operation
-      setFecRingCR0 ( FEC_CR0_SEND | FEC_CR0_ENABLEFEC, CMD_OR ) ;
-      setFecRingCR0 ( FEC_CR0_SEND | FEC_CR0_ENABLEFEC, CMD_XOR ) ;
+      // Fill the FIFO transmit, clear the errors and send the frames
+      sendFifoTransmit(toBeTransmited,wordFifo); 
 
 #ifdef DEBUGMSGERRORMF
       std::cout << "Send " << itemSent << " frames over the ring" << std::endl ;
@@ -10290,7 +10900,7 @@ void FecRingDevice::setBlockDevicesBltMode ( std::list<accessDeviceType> &vAcces
       // **************************************************************************
       // Read all the frames from the FIFO receive and manage the differents errors
       // **************************************************************************
-      getBlockFrames (forceAcknowledge, tnumSent, busy, cptRead) ;
+      getBlockFrames (forceAcknowledge, tnumSent, busy, cptRead, errorRecorder) ;
       // Number of frames sent and acknowledged
       countFrame += tnumSent.size() ;
     }
@@ -32,6 +32,7 @@ using std::hex;
 
 
 #include "fec_usb.h" 
+#include "fec_usb_defines.h"
 #include "FecUsbRingDevice.h"
 
 
@@ -76,6 +77,16 @@ FecUsbRingDevice::FecUsbRingDevice (std::string serial, tscType8 fecSlot, tscTyp
 				      "Error code returned by the ioctl", -device_) ;
   }
 	
+  FECUSB_TYPE_ERROR error = fec_usb_pipe_open(device_, FECUSB_PIPE_MAX_IN_FLIGHT, &pipe_) ;
+  if (error != FECUSB_RETURN_OK) {
+
+    RAISEFECEXCEPTIONHANDLER_INFOSUP (TSCFEC_FECDDNOTOPEN,
+				      TSCFEC_FECDDNOTOPEN_MSG,
+				      FATALERRORCODE,
+				      buildFecRingKey (fecSlot, ringSlot),
+				      "Error code returned by the USB pipe", error) ;
+  }
+
   //Check here if board is a FEC or something else --> Exception to raise in this last case
 
   // Initialise or not the FEC
@@ -92,6 +103,8 @@ FecUsbRingDevice::FecUsbRingDevice (std::string serial, tscType8 fecSlot, tscTyp
  */
 FecUsbRingDevice::~FecUsbRingDevice ( ) throw ( FecExceptionHandler ) {
 
+  fec_usb_pipe_close(pipe_) ;
+
 //   if (device_ != -1) { 
 
 //     FECUSB_TYPE_ERROR status = fec_usb_close(device_) ;  
@@ -577,6 +590,49 @@ void FecUsbRingDevice::setFifoTransmit ( tscType32 *value, int count )
     }
 }
 
+/** Fill the FIFO transmit, clear the errors and toggle the send bit of the control register 0.
+ * Each access is a USB round trip when it is done alone, the FIFO, CR1 and the read of CR0 are sent
+ * in one transfer and the two writes of CR0 in a second one.
+ * \param value - words of the frames (array)
+ * \param count - number of words
+ */
+void FecUsbRingDevice::sendFifoTransmit ( tscType32 *value, int count ) 
+  throw (FecExceptionHandler) {
+
+  fecusbType32 ctrl1Value = DD_FEC_CLEAR_ERRORS ;
+  fecusbType32 ctrl0Value = 0 ;
+
+  // Fill the FIFO transmit, clear the errors and read CR0
+  FECUSB_TYPE_ERROR error = fec_usb_pipe_write(pipe_, FECUSB_OPER_WRITE, pipe_->fifo_transmit, (fecusbType32 *)value, count) ;
+  if (error == FECUSB_RETURN_OK) error = fec_usb_pipe_write(pipe_, FECUSB_OPER_WRITE, FECUSB_CTRL1_OFFSET, &ctrl1Value, 1) ;
+  if (error == FECUSB_RETURN_OK) error = fec_usb_pipe_read(pipe_, FECUSB_OPER_READ, FECUSB_CTRL0_OFFSET, &ctrl0Value, 1) ;
+  FECUSB_TYPE_ERROR flushError = fec_usb_pipe_flush(pipe_) ;
+  if (error == FECUSB_RETURN_OK) error = flushError ;
+
+  if (error == FECUSB_RETURN_OK) {
+
+    // Toggle the send bit with the clock polarity managed as in setFecRingCR0
+    fecusbType32 toggle[2] = { (ctrl0Value & 0xFFFF) | FEC_CR0_SEND | FEC_CR0_ENABLEFEC, 
+			       (ctrl0Value & 0xFFFF) & ~(FEC_CR0_SEND | FEC_CR0_ENABLEFEC) } ;
+    for (int i = 0 ; i < 2 ; i ++) {
+      if (invertClockPolarity_) toggle[i] |= FEC_CR0_POLARITY ;
+      else toggle[i] &= (~FEC_CR0_POLARITY) ;
+      if (error == FECUSB_RETURN_OK) error = fec_usb_pipe_write(pipe_, FECUSB_OPER_WRITE, FECUSB_CTRL0_OFFSET, &toggle[i], 1) ;
+    }
+    flushError = fec_usb_pipe_flush(pipe_) ;
+    if (error == FECUSB_RETURN_OK) error = flushError ;
+  }
+
+  if (error != FECUSB_RETURN_OK)
+    {
+      RAISEFECEXCEPTIONHANDLER_INFOSUP (TSCFEC_USBACCESSPROBLEM,
+					TSCFEC_USBACCESSPROBLEM_MSG + ": unable to send the frames of the FIFO transmit",
+					ERRORCODE,
+					buildFecRingKey(getFecSlot(), getRingSlot()),
+					"USB error", error) ;
+    }
+}
+
 /** get a word from the FIFO transmit
  */
 tscType32* FecUsbRingDevice::getFifoTransmit ( tscType32 *value, int count ) 
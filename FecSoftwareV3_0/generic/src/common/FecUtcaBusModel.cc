@@ -0,0 +1,229 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <unistd.h> // for usleep
+
+#include "FecUtcaBusModel.h"
+
+/** Node of a ring
+ */
+static std::string ringPath ( const char *prefix, unsigned int ring, const char *suffix ) {
+
+  std::string path = prefix ;
+  path.append(1, '0' + ring) ;
+  path.append(suffix) ;
+  return path ;
+}
+
+/** \param minRing - first ring
+ * \param maxRing - last ring
+ * \param roundTripTime - duration of a dispatch in microseconds
+ */
+FecUtcaBusModel::FecUtcaBusModel ( unsigned int minRing, unsigned int maxRing, unsigned long roundTripTime ):
+  minRing_(minRing), roundTripTime_(roundTripTime), roundTrips_(0), accesses_(0), words_(0) {
+
+  pthread_mutex_init (&mutex_, NULL) ;
+
+  rings_.resize(maxRing - minRing + 1) ;
+  for (unsigned int ring = minRing ; ring <= maxRing ; ring ++) {
+    RingState &state = rings_[ring - minRing] ;
+    state.readData = 0 ;
+    state.accessPending = false ;
+    state.ackDelay = state.ackDelayLeft = 0 ;
+
+    addNode (ringPath("FEC_Rd_Wr.control.ring", ring, ".CR0"), REGISTER, ring) ;
+    addNode (ringPath("FEC_Rd_Wr.control.ring", ring, ".CR1"), REGISTER, ring) ;
+    addNode (ringPath("FEC_Rd.status.ring", ring, ".SR0"), STATUS, ring) ;
+    addNode (ringPath("FEC_Rd.status.ring", ring, ".SR1"), STATUS, ring) ;
+    addNode (ringPath("FIFO.ring", ring, ".TRA"), TRANSMITFIFO, ring) ;
+    addNode (ringPath("FIFO.ring", ring, ".REC"), RECEIVEFIFO, ring) ;
+    addNode (ringPath("FEC_Rd.rec_fifo_words_nb.ring", ring, ""), RECEIVEWORDS, ring) ;
+    state.addressNode   = addNode (ringPath("FEC_Rd_Wr.ring", ring, ".mfec_address"), REGISTER, ring) ;
+    state.writeDataNode = addNode (ringPath("FEC_Rd_Wr.ring", ring, ".mfec_write_data"), REGISTER, ring) ;
+    addNode (ringPath("FEC_Rd_Wr.ring", ring, ".access_mode"), ACCESSMODE, ring) ;
+    addNode (ringPath("FEC_Rd_Wr.ring", ring, ".access_request"), ACCESSREQUEST, ring) ;
+    addNode (ringPath("FEC_Rd_Wr.ring", ring, ".aclr_n"), REGISTER, ring) ;
+    addNode (ringPath("FEC_Rd.access_ack.ring", ring, ""), ACCESSACK, ring) ;
+    addNode (ringPath("FEC_Rd.mfec_read_data.ring", ring, ""), READDATA, ring) ;
+  }
+  addNode ("FEC_Rd_Wr.fec_tx_clk_shift", REGISTER, minRing) ;
+  addNode ("FEC_Rd_Wr.fec_rx_clk_shift", REGISTER, minRing) ;
+  addNode ("FEC_Rd.mfec_version", STATUS, minRing) ;
+  addNode ("FEC_Rd.monitoring", STATUS, minRing) ;
+}
+
+/** Destroy the mutex
+ */
+FecUtcaBusModel::~FecUtcaBusModel ( ) {
+
+  pthread_mutex_destroy (&mutex_) ;
+}
+
+/** \param path - path of the node
+ * \param type - behaviour
+ * \param ring - ring of the node
+ * \return the id of the node
+ */
+unsigned int FecUtcaBusModel::addNode ( const std::string &path, NodeType type, unsigned int ring ) {
+
+  unsigned int node = types_.size() ;
+  types_.push_back(type) ;
+  nodeRings_.push_back(ring) ;
+  values_.push_back(0) ;
+  nodeIds_[path] = node ;
+  return node ;
+}
+
+/** \param path - path of the node
+ * \return the id of the node
+ * \exception FecExceptionHandler if the node does not exist
+ */
+unsigned int FecUtcaBusModel::getNodeId ( const std::string &path ) throw (FecExceptionHandler) {
+
+  std::map<std::string, unsigned int>::iterator it = nodeIds_.find(path) ;
+  if (it == nodeIds_.end())
+    RAISEFECEXCEPTIONHANDLER ( TSCFEC_INVALIDOPERATION,
+			       "node " + path + " does not exist in the uTCA FEC",
+			       ERRORCODE ) ;
+  return it->second ;
+}
+
+/** \param path - path of the node
+ * \return the value stored
+ */
+tscType32 FecUtcaBusModel::getRegister ( const std::string &path ) throw (FecExceptionHandler) {
+
+  return values_[getNodeId(path)] ;
+}
+
+/** \param path - path of the node
+ * \param value - value stored
+ */
+void FecUtcaBusModel::setRegister ( const std::string &path, tscType32 value ) throw (FecExceptionHandler) {
+
+  values_[getNodeId(path)] = value ;
+}
+
+/** \param node - node id
+ * \param value - word written
+ */
+void FecUtcaBusModel::writeNode ( unsigned int node, tscType32 value ) throw (FecExceptionHandler) {
+
+  RingState &state = rings_[nodeRings_[node] - minRing_] ;
+
+  switch (types_[node]) {
+  case REGISTER:
+    values_[node] = value ;
+    break ;
+  case TRANSMITFIFO:
+    state.transmitFifo.push_back(value) ;
+    break ;
+  case ACCESSMODE:
+    // The access is done on the local bus, the acknowledge comes after the delay
+    values_[node] = value ;
+    if (value == 1) state.localRegisters[values_[state.addressNode]] = values_[state.writeDataNode] ;
+    else state.readData = state.localRegisters[values_[state.addressNode]] ;
+    state.accessPending = true ;
+    state.ackDelayLeft = state.ackDelay ;
+    break ;
+  case ACCESSREQUEST:
+    values_[node] = value ;
+    if (value == 0) state.accessPending = false ;
+    else state.ackDelayLeft = 0 ;
+    break ;
+  default:
+    RAISEFECEXCEPTIONHANDLER ( TSCFEC_INVALIDOPERATION,
+			       "write of a read only node of the uTCA FEC",
+			       ERRORCODE ) ;
+  }
+}
+
+/** \param node - node id
+ * \return word read
+ */
+tscType32 FecUtcaBusModel::readNode ( unsigned int node ) throw (FecExceptionHandler) {
+
+  RingState &state = rings_[nodeRings_[node] - minRing_] ;
+  tscType32 value = 0 ;
+
+  switch (types_[node]) {
+  case REGISTER:
+  case STATUS:
+  case ACCESSMODE:
+  case ACCESSREQUEST:
+    value = values_[node] ;
+    break ;
+  case RECEIVEFIFO:
+    if (!state.receiveFifo.empty()) {
+      value = state.receiveFifo.front() ;
+      state.receiveFifo.pop_front() ;
+    }
+    break ;
+  case RECEIVEWORDS:
+    value = state.receiveFifo.size() ;
+    break ;
+  case ACCESSACK:
+    if (state.accessPending) {
+      if (state.ackDelayLeft > 0) state.ackDelayLeft -- ;
+      else value = 1 ;
+    }
+    break ;
+  case READDATA:
+    value = state.readData ;
+    break ;
+  default:
+    RAISEFECEXCEPTIONHANDLER ( TSCFEC_INVALIDOPERATION,
+			       "read of a write only node of the uTCA FEC",
+			       ERRORCODE ) ;
+  }
+
+  return value ;
+}
+
+/** \param accesses - accesses to be done
+ * \param writeValues - words written
+ * \param readValues - words read
+ */
+void FecUtcaBusModel::dispatch ( const std::vector<FecUtcaAccess> &accesses, const std::vector<tscType32> &writeValues,
+				 std::vector<tscType32> &readValues ) throw (FecExceptionHandler) {
+
+  pthread_mutex_lock (&mutex_) ;
+  if (roundTripTime_) usleep (roundTripTime_) ;
+  roundTrips_ ++ ;
+
+  try {
+    for (std::vector<FecUtcaAccess>::const_iterator it = accesses.begin() ; it != accesses.end() ; it ++) {
+      if (it->node >= types_.size())
+	RAISEFECEXCEPTIONHANDLER ( TSCFEC_INVALIDOPERATION,
+				   "unknown node of the uTCA FEC",
+				   ERRORCODE ) ;
+      accesses_ ++ ;
+      words_ += it->count ;
+      for (unsigned int i = 0 ; i < it->count ; i ++) {
+	if (it->type == FECUTCAWRITE) writeNode (it->node, writeValues[it->offset + i]) ;
+	else readValues[it->offset + i] = readNode (it->node) ;
+      }
+    }
+  }
+  catch (FecExceptionHandler &e) {
+    pthread_mutex_unlock (&mutex_) ;
+    throw ;
+  }
+
+  pthread_mutex_unlock (&mutex_) ;
+}
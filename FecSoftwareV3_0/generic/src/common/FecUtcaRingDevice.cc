@@ -16,6 +16,7 @@
   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 */
 
+#include <algorithm>
 #include <iostream>
 
 #include <unistd.h> // for usleep
@@ -48,6 +49,86 @@ using namespace std;
 //static members have to be declared
 //std::string FecUtcaRingDevice::strUhalConnectionFile_, FecUtcaRingDevice::strBoardId_;
 uhal::HwInterface *FecUtcaRingDevice::hwBoard=NULL;
+FecUtcaUhalBus *FecUtcaRingDevice::uhalBus=NULL;
+
+/******************************************************
+		uHAL TRANSACTIONS
+******************************************************/
+
+FecUtcaUhalBus::FecUtcaUhalBus ( uhal::HwInterface &hwBoard ): hwBoard_(hwBoard) {
+  pthread_mutex_init (&mutex_, NULL) ;
+}
+
+FecUtcaUhalBus::~FecUtcaUhalBus ( ) {
+  pthread_mutex_destroy (&mutex_) ;
+}
+
+/** Resolve a node once, the node is kept by uHAL for the life of hwBoard
+ */
+unsigned int FecUtcaUhalBus::getNodeId ( const std::string &path ) throw (FecExceptionHandler) {
+  pthread_mutex_lock (&mutex_) ;
+  std::map<std::string, unsigned int>::iterator it = nodeIds_.find(path) ;
+  if (it != nodeIds_.end()) {
+    unsigned int node = it->second ;
+    pthread_mutex_unlock (&mutex_) ;
+    return node ;
+  }
+  const uhal::Node *pNode = NULL ;
+  try {
+    pNode = &hwBoard_.getNode(path) ;
+  } catch (std::exception &e) {
+    pthread_mutex_unlock (&mutex_) ;
+    RAISEFECEXCEPTIONHANDLER ( TSCFEC_REGISTERACCESS,
+                               "node " + path + " not found in the uHAL address table: " + e.what(),
+                               FATALERRORCODE ) ;
+  }
+  unsigned int node = nodes_.size() ;
+  nodes_.push_back(pNode) ;
+  nodeIds_[path] = node ;
+  pthread_mutex_unlock (&mutex_) ;
+  return node ;
+}
+
+/** Queue all the accesses in uHAL then dispatch once
+ */
+void FecUtcaUhalBus::dispatch ( const std::vector<FecUtcaAccess> &accesses, const std::vector<tscType32> &writeValues,
+                                std::vector<tscType32> &readValues ) throw (FecExceptionHandler) {
+  std::vector<uhal::ValWord<uint32_t> > words ;
+  std::vector<unsigned int> wordOffsets ;
+  std::vector<uhal::ValVector<uint32_t> > blocks ;
+  std::vector<unsigned int> blockOffsets ;
+
+  pthread_mutex_lock (&mutex_) ;
+  try {
+    for (std::vector<FecUtcaAccess>::const_iterator it = accesses.begin() ; it != accesses.end() ; it ++) {
+      const uhal::Node &node = *nodes_[it->node] ;
+      bool block = (it->count > 1) && (node.getMode() == uhal::defs::NON_INCREMENTAL) ;
+      if (it->type == FECUTCAWRITE) {
+        if (block) node.writeBlock(std::vector<uint32_t>(writeValues.begin() + it->offset, writeValues.begin() + it->offset + it->count)) ;
+        else for (unsigned int i = 0 ; i < it->count ; i ++) node.write(writeValues[it->offset + i]) ;
+      }
+      else if (block) {
+        blocks.push_back(node.readBlock(it->count)) ;
+        blockOffsets.push_back(it->offset) ;
+      }
+      else for (unsigned int i = 0 ; i < it->count ; i ++) {
+        words.push_back(node.read()) ;
+        wordOffsets.push_back(it->offset + i) ;
+      }
+    }
+    hwBoard_.dispatch() ;
+  } catch (std::exception &e) {
+    pthread_mutex_unlock (&mutex_) ;
+    RAISEFECEXCEPTIONHANDLER ( TSCFEC_REGISTERACCESS,
+                               std::string("uHAL transaction failed: ") + e.what(),
+                               ERRORCODE ) ;
+  }
+  pthread_mutex_unlock (&mutex_) ;
+
+  for (unsigned int i = 0 ; i < words.size() ; i ++) readValues[wordOffsets[i]] = words[i].value() ;
+  for (unsigned int i = 0 ; i < blocks.size() ; i ++)
+    std::copy(blocks[i].begin(), blocks[i].end(), readValues.begin() + blockOffsets[i]) ;
+}
 
 /******************************************************
 		CONSTRUCTOR - DESTRUCTOR
@@ -65,6 +146,12 @@ FecUtcaRingDevice::FecUtcaRingDevice (tscType8 fecSlot, tscType8 ringSlot, bool
       //RAISEFECEXCEPTIONHANDLER (code, msg, FATALERRORCODE);
   //}
   useNonIncBlocks=false;
+  if (uhalBus == NULL)
+    RAISEFECEXCEPTIONHANDLER_HARDPOSITION (TSCFEC_REGISTERACCESS,
+                                           "The uHAL connection is not configured (FecUtcaRingDevice::configureUhal)",
+                                           FATALERRORCODE,
+                                           buildFecRingKey(fecSlot, ringSlot)) ;
+  transport = new FecUtcaRingTransport (*uhalBus, ringSlot) ;
   fecHardReset ();
   // Initialise or not the FEC
   try{
@@ -93,6 +180,7 @@ FecUtcaRingDevice::FecUtcaRingDevice (tscType8 fecSlot, tscType8 ringSlot, bool
 FecUtcaRingDevice::~FecUtcaRingDevice ( ) throw ( FecExceptionHandler )
 {
     //delete hwBoard;
+    delete transport;
 }
 
 void FecUtcaRingDevice::configureUhal (const std::string& connectionFile, const std::string& boardId){
@@ -105,9 +193,12 @@ void FecUtcaRingDevice::configureUhal (const std::string& connectionFile, const
         //strBoardId_ = boardId;
         uhal::ConnectionManager lConnectionManager ( strUhalConnectionFile );
         hwBoard = new uhal::HwInterface(lConnectionManager.getDevice ( boardId ));
+        uhalBus = new FecUtcaUhalBus(*hwBoard);
 }
 
 void FecUtcaRingDevice::releaseUhal (){
+        delete uhalBus;
+        uhalBus=NULL;
         delete hwBoard;
         hwBoard=NULL;
 }
@@ -390,11 +481,7 @@ void FecUtcaRingDevice::setFifoTransmit( tscType32 fifotra_value )throw ( FecExc
 					   ERRORCODE,
 					   buildFecRingKey(getFecSlot(), getRingSlot())) ;
   }*/
-  string strPath="FIFO.ring";
-  strPath.append(1,'0'+getRingSlot());
-  strPath.append(".TRA");
-  hwBoard->getNode(strPath.c_str()).write(fifotra_value);
-  hwBoard->dispatch();
+  transport->writeTransmitFifo(&fifotra_value, 1);
 
 
 #ifdef FECUTCARINGDEVICE_DEBUG
@@ -403,6 +490,34 @@ void FecUtcaRingDevice::setFifoTransmit( tscType32 fifotra_value )throw ( FecExc
 
 }
 
+/** write a set of words in the FIFO transmit, the frames built by setBlockDevices are sent in one IPbus round trip
+ * \param value - values to be written (array)
+ * \param count - number of values
+ */
+void FecUtcaRingDevice::setFifoTransmit ( tscType32 *value, int count ) throw (FecExceptionHandler) {
+
+  transport->writeTransmitFifo(value, count);
+
+#ifdef FECUTCARINGDEVICE_DEBUG
+  std::cout << "DEBUG : writing " << dec << count << " values to fifo transmit (ring "<<(int)getRingSlot()<<")" << std::endl ;
+#endif
+}
+
+/** read a set of words from the FIFO receive in one IPbus round trip
+ * \param value - values read (array)
+ * \param count - number of values
+ * \return pointer to the array of value ( = value )
+ */
+tscType32* FecUtcaRingDevice::getFifoReceive ( tscType32 *value, int count ) throw (FecExceptionHandler) {
+
+  transport->readReceiveFifo(value, count);
+
+#ifdef FECUTCARINGDEVICE_DEBUG
+  std::cout << "DEBUG : reading " << dec << count << " values from fifo receive (ring "<<(int)getRingSlot()<<")" << std::endl ;
+#endif
+  return value;
+}
+
 
 
 
@@ -418,26 +533,8 @@ void FecUtcaRingDevice::fecHardReset ( ) throw ( FecExceptionHandler ) {
 #ifdef FECUTCARINGDEVICE_DEBUG
   std::cout << "DEBUG: Hard reset"<< std::endl ;
 #endif
-// init reset
-  for (uint8_t uRing=minUtcaFecRing; uRing<=maxUtcaFecRing; uRing++){
-    string strWrite="FEC_Rd_Wr.ring";
-    strWrite.append(1,'0'+uRing);
-    hwBoard->getNode(strWrite+".aclr_n").write(0);              // 0 : reset FSM ctrl
-  }
-//init shift clock
-  hwBoard->getNode("FEC_Rd_Wr.fec_tx_clk_shift").write(1);    // 0:0° / 1:180°
-  hwBoard->getNode("FEC_Rd_Wr.fec_rx_clk_shift").write(1);    // 0:0° / 1:180°
-  hwBoard->dispatch();
-  usleep(100000);
-
-
-// reset released
-  for (uint8_t uRing=minUtcaFecRing; uRing<=maxUtcaFecRing; uRing++){
-    string strWrite="FEC_Rd_Wr.ring";
-    strWrite.append(1,'0'+uRing);
-    hwBoard->getNode(strWrite+".aclr_n").write(1);              // 0 : reset FSM ctrl
-  }
-  hwBoard->dispatch();
+// init reset and shift clock, reset released after 100 ms
+  FecUtcaRingTransport::hardReset(*uhalBus, minUtcaFecRing, maxUtcaFecRing);
 
 #ifdef IRQMANAGER
 #endif
@@ -460,87 +557,24 @@ void FecUtcaRingDevice::setIRQ ( bool enable, tscType8 level ) throw (FecExcepti
 #endif
 }
 
+/** The command and the reads of its acknowledge and data are batched by the transport
+ */
 bool FecUtcaRingDevice::sendCommand(uint32_t uCmd, tscType32 uSetValue, tscType32 *pGetValue) {
-    uhal::ValWord<uint32_t> lVal, lRet;
-    string strWrite="FEC_Rd_Wr.ring";
-    strWrite.append(1,'0'+getRingSlot());
-    hwBoard->getNode(strWrite+".mfec_address").write(uCmd);
-    hwBoard->getNode(strWrite+".mfec_write_data").write(uSetValue);
-    hwBoard->getNode(strWrite+".access_mode").write(pGetValue==NULL ? 1 : 0); 
-    hwBoard->dispatch();
-    string strAccessAck="FEC_Rd.access_ack.ring";
-    strAccessAck.append(1,'0'+getRingSlot());
-    uint32_t nTry=0;
-    do{//Wait for access acknowledge
-    	lVal=hwBoard->getNode(strAccessAck).read();
-    	hwBoard->dispatch();
-        if (lVal==0){
-            usleep(100000);
-            hwBoard->getNode(strWrite+".access_request").write(1);
-            if (++nTry > 10)
-                    return true;
-        }
-    } while (lVal==0); 
-
-    uhal::ValWord<uint32_t> AccessACK_read = hwBoard->getNode(strAccessAck).read();
-    hwBoard->dispatch();
-    if (pGetValue!=NULL){
-        if (AccessACK_read == 1) {
-                string strRead="FEC_Rd.mfec_read_data.ring";
-                strRead.append(1,'0'+getRingSlot());
-                lRet=hwBoard->getNode(strRead).read();
-        } else 
-                return true;
-    }
-    hwBoard->getNode(strWrite+".access_request").write(0);// 0: no access request,1: access to perform
-    hwBoard->dispatch();
-    nTry=0;
-    do{//Wait for access acknowledge
-    	lVal=hwBoard->getNode(strAccessAck).read();
-    	hwBoard->dispatch();
-        if (lVal!=0){
-            usleep(10000);
-            hwBoard->getNode(strWrite+".access_request").write(1);
-            if (++nTry > 100)
-                    return true;
-        }
-    } while (lVal!=0); 
-    if (pGetValue!=NULL)
-        *pGetValue=lRet.value();
-
-    return false;
+    return transport->sendCommand(uCmd, uSetValue, pGetValue);
 }
 
 tscType32 FecUtcaRingDevice::readRegisterValue(char cRegType, char cRegNum){
-  uhal::ValWord<tscType32> value;
-  string strPath;
+  tscType32 value;
   switch (cRegType){
-          case 'S':strPath= "FEC_Rd.status.ring";break;
-          case 'C':strPath= "FEC_Rd_Wr.control.ring";break;
-          default :strPath= "FIFO.ring";break;//R
+          case 'S':value = transport->readRegister(cRegNum=='0' ? FecUtcaRingTransport::SR0 : FecUtcaRingTransport::SR1);break;
+          case 'C':value = transport->readRegister(cRegNum=='0' ? FecUtcaRingTransport::CR0 : FecUtcaRingTransport::CR1);break;
+          default :transport->readReceiveFifo(&value, 1);break;//R
   }
-  strPath.append(1,'0'+getRingSlot());
-  strPath.append(".");
-  switch (cRegType){
-          case 'R':strPath.append("REC");break;
-          default:
-                strPath.append(1, cRegType);
-                strPath.append("R");
-                strPath.append(1, cRegNum);
-  }
-  value = hwBoard->getNode(strPath.c_str()).read();
-  hwBoard->dispatch();
-
   return value;
 }
 
 void FecUtcaRingDevice::setControlRegister(char cRegNum, tscType16 uValue){
-        string strPath = "FEC_Rd_Wr.control.ring";
-        strPath.append(1,'0'+getRingSlot());
-        strPath.append(".CR");
-        strPath.append(1, cRegNum);
-        hwBoard->getNode(strPath.c_str()).write(uValue);
-        hwBoard->dispatch();
+        transport->writeRegister(cRegNum=='0' ? FecUtcaRingTransport::CR0 : FecUtcaRingTransport::CR1, uValue);
 }
 
 
@@ -569,19 +603,11 @@ std::string FecUtcaRingDevice::getFecFirmwareStringVersion( ) {
 }
 
 std::vector<uint32_t> FecUtcaRingDevice::readBlockReceiveFifo(){
-        string strPath= "FEC_Rd.rec_fifo_words_nb.ring";
-        strPath.append(1,'0'+getRingSlot());
-        uhal::ValWord<uint32_t> value = hwBoard->getNode(strPath.c_str()).read();
-        hwBoard->dispatch();
-        strPath= "FIFO.ring";
-        strPath.append(1,'0'+getRingSlot());
-        strPath.append(".REC");
-        uhal::ValVector<uint32_t> vvcRet = hwBoard->getNode(strPath.c_str()).readBlock(value);
+        std::vector<uint32_t> vRet = transport->readReceiveFifo();
 #ifdef FECUTCARINGDEVICE_DEBUG
-  std::cout << "DEBUG : Read block of "<<value.value()<< " values from receive fifo (ring "<<(int)getRingSlot()<<")" << std::endl ;
+  std::cout << "DEBUG : Read block of "<<vRet.size()<< " values from receive fifo (ring "<<(int)getRingSlot()<<")" << std::endl ;
 #endif
-        hwBoard->dispatch();
-        return vvcRet.value();
+        return vRet;
 }
 
 uint8_t FecUtcaRingDevice::getMonitoringStatus(bool bTx) {
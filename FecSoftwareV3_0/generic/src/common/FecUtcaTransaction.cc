@@ -0,0 +1,322 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <unistd.h> // for usleep
+
+#include "FecUtcaTransaction.h"
+
+/******************************************************
+		FecUtcaValue
+******************************************************/
+
+/** \return true if the read has been done by the last dispatch of the transaction
+ */
+bool FecUtcaValue::isValid ( ) const {
+
+  return (transaction_ != NULL) && transaction_->valid_ && (transaction_->generation_ == dispatch_) &&
+    (offset_ + count_ <= transaction_->readValues_.size()) ;
+}
+
+/** \param i - position of the word in the block
+ * \return the word read
+ * \exception FecExceptionHandler if the read has not been done or i is out of the block
+ */
+tscType32 FecUtcaValue::value ( unsigned int i ) const throw (FecExceptionHandler) {
+
+  if (!isValid())
+    RAISEFECEXCEPTIONHANDLER ( TSCFEC_INVALIDOPERATION,
+			       "the read has not been dispatched or a later dispatch has been done",
+			       ERRORCODE ) ;
+
+  if (i >= count_)
+    RAISEFECEXCEPTIONHANDLER ( TSCFEC_INVALIDOPERATION,
+			       "position out of the block read",
+			       ERRORCODE ) ;
+
+  return transaction_->readValues_[offset_ + i] ;
+}
+
+/** \param values - array of size() words
+ * \exception FecExceptionHandler if the read has not been done
+ */
+void FecUtcaValue::copy ( tscType32 *values ) const throw (FecExceptionHandler) {
+
+  if (!isValid())
+    RAISEFECEXCEPTIONHANDLER ( TSCFEC_INVALIDOPERATION,
+			       "the read has not been dispatched or a later dispatch has been done",
+			       ERRORCODE ) ;
+
+  for (unsigned int i = 0 ; i < count_ ; i ++) values[i] = transaction_->readValues_[offset_ + i] ;
+}
+
+/******************************************************
+		FecUtcaTransaction
+******************************************************/
+
+/** \param bus - bus used for the dispatches
+ */
+FecUtcaTransaction::FecUtcaTransaction ( FecUtcaBus &bus ):
+  bus_(bus), readCount_(0), generation_(0), valid_(false), dispatches_(0) {
+}
+
+/** \param node - node id
+ * \param value - word to be written
+ */
+void FecUtcaTransaction::write ( unsigned int node, tscType32 value ) {
+
+  writeBlock (node, &value, 1) ;
+}
+
+/** \param node - node id
+ * \param values - words to be written
+ * \param count - number of words
+ */
+void FecUtcaTransaction::writeBlock ( unsigned int node, const tscType32 *values, unsigned int count ) {
+
+  if (count == 0) return ;
+
+  FecUtcaAccess access ;
+  access.type   = FECUTCAWRITE ;
+  access.node   = node ;
+  access.offset = writeValues_.size() ;
+  access.count  = count ;
+  accesses_.push_back(access) ;
+  writeValues_.insert(writeValues_.end(), values, values + count) ;
+}
+
+/** \param node - node id
+ * \param count - number of words
+ * \return the future of the words read
+ */
+FecUtcaValue FecUtcaTransaction::readBlock ( unsigned int node, unsigned int count ) {
+
+  FecUtcaAccess access ;
+  access.type   = FECUTCAREAD ;
+  access.node   = node ;
+  access.offset = readCount_ ;
+  access.count  = count ;
+  if (count > 0) accesses_.push_back(access) ;
+  readCount_ += count ;
+
+  return FecUtcaValue (this, access.offset, count, generation_ + 1) ;
+}
+
+/** The queue is empty after the dispatch, even if it failed.
+ * \exception FecExceptionHandler from the bus
+ */
+void FecUtcaTransaction::dispatch ( ) throw (FecExceptionHandler) {
+
+  if (accesses_.empty()) return ;
+
+  std::vector<tscType32> readValues (readCount_, 0) ;
+  generation_ ++ ;
+  valid_ = false ;
+  try {
+    bus_.dispatch (accesses_, writeValues_, readValues) ;
+  }
+  catch (FecExceptionHandler &e) {
+    accesses_.clear() ; writeValues_.clear() ; readCount_ = 0 ;
+    throw ;
+  }
+
+  accesses_.clear() ; writeValues_.clear() ; readCount_ = 0 ;
+  readValues_.swap(readValues) ;
+  valid_ = true ;
+  dispatches_ ++ ;
+}
+
+/******************************************************
+		FecUtcaRingTransport
+******************************************************/
+
+/** \param prefix - path up to the ring
+ * \param ring - ring
+ * \param suffix - path after the ring
+ */
+std::string FecUtcaRingTransport::getNodePath ( const char *prefix, unsigned int ring, const char *suffix ) {
+
+  std::string path = prefix ;
+  path.append(1, '0' + ring) ;
+  path.append(suffix) ;
+  return path ;
+}
+
+/** \param bus - bus of the FEC
+ * \param ring - ring
+ * \exception FecExceptionHandler if a node does not exist
+ */
+FecUtcaRingTransport::FecUtcaRingTransport ( FecUtcaBus &bus, unsigned int ring ) throw (FecExceptionHandler):
+  transaction_(bus) {
+
+  registerNodes_[CR0] = bus.getNodeId (getNodePath("FEC_Rd_Wr.control.ring", ring, ".CR0")) ;
+  registerNodes_[CR1] = bus.getNodeId (getNodePath("FEC_Rd_Wr.control.ring", ring, ".CR1")) ;
+  registerNodes_[SR0] = bus.getNodeId (getNodePath("FEC_Rd.status.ring", ring, ".SR0")) ;
+  registerNodes_[SR1] = bus.getNodeId (getNodePath("FEC_Rd.status.ring", ring, ".SR1")) ;
+  transmitFifoNode_     = bus.getNodeId (getNodePath("FIFO.ring", ring, ".TRA")) ;
+  receiveFifoNode_      = bus.getNodeId (getNodePath("FIFO.ring", ring, ".REC")) ;
+  receiveFifoWordsNode_ = bus.getNodeId (getNodePath("FEC_Rd.rec_fifo_words_nb.ring", ring, "")) ;
+  addressNode_       = bus.getNodeId (getNodePath("FEC_Rd_Wr.ring", ring, ".mfec_address")) ;
+  writeDataNode_     = bus.getNodeId (getNodePath("FEC_Rd_Wr.ring", ring, ".mfec_write_data")) ;
+  accessModeNode_    = bus.getNodeId (getNodePath("FEC_Rd_Wr.ring", ring, ".access_mode")) ;
+  accessRequestNode_ = bus.getNodeId (getNodePath("FEC_Rd_Wr.ring", ring, ".access_request")) ;
+  accessAckNode_     = bus.getNodeId (getNodePath("FEC_Rd.access_ack.ring", ring, "")) ;
+  readDataNode_      = bus.getNodeId (getNodePath("FEC_Rd.mfec_read_data.ring", ring, "")) ;
+}
+
+/** \param reg - register
+ * \return the value read
+ */
+tscType32 FecUtcaRingTransport::readRegister ( Register reg ) throw (FecExceptionHandler) {
+
+  FecUtcaValue value = transaction_.read (registerNodes_[reg]) ;
+  transaction_.dispatch() ;
+  return value.value() ;
+}
+
+/** \param reg - control register
+ * \param value - value to be written
+ * \exception FecExceptionHandler if the register is a status register
+ */
+void FecUtcaRingTransport::writeRegister ( Register reg, tscType32 value ) throw (FecExceptionHandler) {
+
+  if ((reg != CR0) && (reg != CR1))
+    RAISEFECEXCEPTIONHANDLER ( TSCFEC_INVALIDOPERATION,
+			       "the status registers cannot be written",
+			       ERRORCODE ) ;
+
+  transaction_.write (registerNodes_[reg], value) ;
+  transaction_.dispatch() ;
+}
+
+/** \param values - words to be written
+ * \param count - number of words
+ */
+void FecUtcaRingTransport::writeTransmitFifo ( const tscType32 *values, unsigned int count ) throw (FecExceptionHandler) {
+
+  transaction_.writeBlock (transmitFifoNode_, values, count) ;
+  transaction_.dispatch() ;
+}
+
+/** \param values - words read
+ * \param count - number of words
+ */
+void FecUtcaRingTransport::readReceiveFifo ( tscType32 *values, unsigned int count ) throw (FecExceptionHandler) {
+
+  FecUtcaValue words = transaction_.readBlock (receiveFifoNode_, count) ;
+  transaction_.dispatch() ;
+  if (count > 0) words.copy (values) ;
+}
+
+/** The size of the block must be known before it is read: two round trips, one if the FIFO is empty.
+ * \return the content of the FIFO receive
+ */
+std::vector<tscType32> FecUtcaRingTransport::readReceiveFifo ( ) throw (FecExceptionHandler) {
+
+  FecUtcaValue size = transaction_.read (receiveFifoWordsNode_) ;
+  transaction_.dispatch() ;
+
+  std::vector<tscType32> values (size.value()) ;
+  if (!values.empty()) readReceiveFifo (&values[0], values.size()) ;
+  return values ;
+}
+
+/** The acknowledge is read in the same packet as the access. If the FEC is not done when the packet
+ * arrives, it is read again at once, then with the waits and the retries of the request of the
+ * original protocol.
+ * \param command - address of the register
+ * \param setValue - value written
+ * \param getValue - value read, NULL for a write
+ * \return true if the FEC did not acknowledge the access
+ */
+bool FecUtcaRingTransport::sendCommand ( tscType32 command, tscType32 setValue, tscType32 *getValue ) throw (FecExceptionHandler) {
+
+  // Command and acknowledge
+  transaction_.write (addressNode_, command) ;
+  transaction_.write (writeDataNode_, setValue) ;
+  transaction_.write (accessModeNode_, getValue == NULL ? 1 : 0) ;
+  FecUtcaValue ack = transaction_.read (accessAckNode_) ;
+  transaction_.dispatch() ;
+  tscType32 ackValue = ack.value() ;
+
+  if (ackValue == 0) {
+    ack = transaction_.read (accessAckNode_) ;
+    transaction_.dispatch() ;
+    ackValue = ack.value() ;
+  }
+  unsigned int nTry = 0 ;
+  while (ackValue == 0) {
+    usleep(100000) ;
+    transaction_.write (accessRequestNode_, 1) ;
+    if (++nTry > 10) return true ;
+    ack = transaction_.read (accessAckNode_) ;
+    transaction_.dispatch() ;
+    ackValue = ack.value() ;
+  }
+  if ((getValue != NULL) && (ackValue != 1)) return true ;
+
+  // Data, end of the request and acknowledge
+  FecUtcaValue data ;
+  if (getValue != NULL) data = transaction_.read (readDataNode_) ;
+  transaction_.write (accessRequestNode_, 0) ;   // 0: no access request,1: access to perform
+  ack = transaction_.read (accessAckNode_) ;
+  transaction_.dispatch() ;
+  tscType32 dataValue = (getValue != NULL) ? data.value() : 0 ;
+  ackValue = ack.value() ;
+
+  if (ackValue != 0) {
+    ack = transaction_.read (accessAckNode_) ;
+    transaction_.dispatch() ;
+    ackValue = ack.value() ;
+  }
+  nTry = 0 ;
+  while (ackValue != 0) {
+    usleep(10000) ;
+    transaction_.write (accessRequestNode_, 1) ;
+    if (++nTry > 100) return true ;
+    ack = transaction_.read (accessAckNode_) ;
+    transaction_.dispatch() ;
+    ackValue = ack.value() ;
+  }
+
+  if (getValue != NULL) *getValue = dataValue ;
+  return false ;
+}
+
+/** \param bus - bus of the FEC
+ * \param minRing - first ring
+ * \param maxRing - last ring
+ */
+void FecUtcaRingTransport::hardReset ( FecUtcaBus &bus, unsigned int minRing, unsigned int maxRing ) throw (FecExceptionHandler) {
+
+  FecUtcaTransaction transaction (bus) ;
+  std::vector<unsigned int> resetNodes ;
+  for (unsigned int ring = minRing ; ring <= maxRing ; ring ++)
+    resetNodes.push_back (bus.getNodeId (getNodePath("FEC_Rd_Wr.ring", ring, ".aclr_n"))) ;
+
+  // init reset
+  for (unsigned int i = 0 ; i < resetNodes.size() ; i ++) transaction.write (resetNodes[i], 0) ;   // 0 : reset FSM ctrl
+  // init shift clock
+  transaction.write (bus.getNodeId ("FEC_Rd_Wr.fec_tx_clk_shift"), 1) ;   // 0:0° / 1:180°
+  transaction.write (bus.getNodeId ("FEC_Rd_Wr.fec_rx_clk_shift"), 1) ;   // 0:0° / 1:180°
+  transaction.dispatch() ;
+  usleep(100000) ;
+
+  // reset released
+  for (unsigned int i = 0 ; i < resetNodes.size() ; i ++) transaction.write (resetNodes[i], 1) ;
+  transaction.dispatch() ;
+}
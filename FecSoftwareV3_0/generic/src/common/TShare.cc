@@ -2,6 +2,10 @@
 #include <stdio.h>
 #include <string.h>
 #include <errno.h>
+#include <signal.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
 #include "TShare.h"
 
 # include <sys/types.h>
@@ -49,9 +53,15 @@ void clrshm(int ie,void *arg)
 //}
 
 
-TShare::TShare(char *cdev,int type,int size) throw (std::string)
+TShare::TShare(char *cdev,int type,int size,unsigned int generations) throw (std::string)
 {
   fSize=size;
+  fHeader=NULL;
+  fWriting=0;
+  if (generations > TSHAREMAXGENERATIONS)
+    throw std::string("TShare: too many generations");
+  if (type == TShare_CREATE && generations > 1)
+    fSize = TSHAREHEADERSIZE + generations*size;
   memset(fName,0,256);
   strncpy(fName,cdev,strlen(cdev));
 
@@ -114,10 +124,34 @@ TShare::TShare(char *cdev,int type,int size) throw (std::string)
         }
 
       //  on_exit(rmsem,(void*)&fSemid);
+
+      // Empty generations, the magic number is set last for the process opening the memory
+      if (generations > 1)
+	{
+	  fHeader = (TShareHeader*) shmat(fShmid, 0, 0);
+	  if (fHeader == (TShareHeader*) -1)
+	    {
+	      fHeader = NULL;
+	      perror("TShare: shmat");
+	      throw std::string("TShare: shmat problem");
+	    }
+	  memset((void*)fHeader,0,TSHAREHEADERSIZE);
+	  fHeader->generations = generations;
+	  fHeader->size = size;
+	  __sync_synchronize();
+	  fHeader->magic = TSHAREMAGIC;
+	  __sync_synchronize();
+	}
     }
 } 
 TShare::~TShare() throw (std::string)
 {
+  if (fHeader != NULL)
+    {
+      AbortUpdate();
+      shmdt((const void*)fHeader);
+      fHeader = NULL;
+    }
   if (isServer)
     {
       struct shmid_ds *shm_ds=0;
@@ -145,7 +179,8 @@ void TShare::Lock() throw (std::string)
   bool retry = (nretry>1);
   (fSembuf[0]).sem_num = 0;
   (fSembuf[0]).sem_op = -1;
-  (fSembuf[0]).sem_flg = 0;
+  // Released by the system if the process dies with the lock
+  (fSembuf[0]).sem_flg = SEM_UNDO;
   
   if((semop( fSemid, fSembuf, 1) <0))
     {
@@ -167,7 +202,7 @@ void TShare::Unlock() throw (std::string)
   bool retry = (nretry>1);
   (fSembuf[0]).sem_num = 0;
   (fSembuf[0]).sem_op = 1;
-  (fSembuf[0]).sem_flg = 0;
+  (fSembuf[0]).sem_flg = SEM_UNDO;
 
  
   if((semop( fSemid, fSembuf, 1) <0))
@@ -211,3 +246,167 @@ void TShare::Detach(const void* ad) throw (std::string)
     throw std::string("TShare::Detach(const void* ) shmdt problem found ");
    }
 }
+
+TShareHeader* TShare::GetHeader() throw (std::string)
+{
+  if (fHeader == NULL)
+    {
+      TShareHeader* header = (TShareHeader*) shmat(fShmid, 0, 0);
+      if (header == (TShareHeader*) -1)
+	{
+	  perror("Error in TShare::GetHeader() --> ");
+	  throw std::string("TShare::GetHeader() shmat problem found ");
+	}
+      __sync_synchronize();
+      if (header->magic != TSHAREMAGIC)
+	{
+	  shmdt((const void*)header);
+	  return NULL;
+	}
+      fHeader = header;
+    }
+  return fHeader;
+}
+
+bool TShare::HasGenerations() throw (std::string)
+{
+  return (GetHeader() != NULL);
+}
+
+unsigned int TShare::GetGenerationSize() throw (std::string)
+{
+  TShareHeader* h = GetHeader();
+  if (h == NULL) return 0;
+  return h->size;
+}
+
+unsigned int TShare::GetVersion() throw (std::string)
+{
+  TShareHeader* h = GetHeader();
+  if (h == NULL) return 0;
+  return h->version;
+}
+
+/**
+   The writer is identified by its thread id, unique in the system, so that
+   two threads of the same process are excluded as two processes are
+ */
+static pid_t WriterId()
+{
+  return (pid_t) syscall(SYS_gettid);
+}
+
+void* TShare::BeginUpdate() throw (std::string)
+{
+  TShareHeader* h = GetHeader();
+  if (h == NULL) throw std::string("TShare::BeginUpdate() memory without generation");
+
+  pid_t me = WriterId();
+  pid_t owner = __sync_val_compare_and_swap(&h->writer, 0, me);
+  if (owner != 0 && owner != me)
+    {
+      // Another writer is alive (kill accepts a thread id)
+      if (kill(owner, 0) == 0 || errno != ESRCH)
+	throw std::string("TShare::BeginUpdate() update in progress in another thread or process");
+      // The writer died during its update, the generation published is still valid
+      if (!__sync_bool_compare_and_swap(&h->writer, owner, me))
+	throw std::string("TShare::BeginUpdate() update taken back by another thread or process");
+      __sync_fetch_and_add(&h->recoveries, 1);
+      printf("TShare: update of %s taken back after the death of thread %d\n", fName, owner);
+    }
+
+  // Close the generations left in writing by an update not published
+  for (unsigned int i = 0; i < h->generations; i++)
+    if (h->sequence[i] & 1) __sync_fetch_and_add(&h->sequence[i], 1);
+
+  fWriting = (h->current + 1) % h->generations;
+  __sync_fetch_and_add(&h->sequence[fWriting], 1);
+  __sync_synchronize();
+
+  return (char*)h + TSHAREHEADERSIZE + fWriting*h->size;
+}
+
+void TShare::Publish(unsigned int length) throw (std::string)
+{
+  TShareHeader* h = GetHeader();
+  if (h == NULL || h->writer != WriterId())
+    throw std::string("TShare::Publish() no update in progress");
+  if (length > h->size)
+    {
+      AbortUpdate();
+      throw std::string("TShare::Publish() length bigger than the generation");
+    }
+
+  h->length[fWriting] = length;
+  __sync_synchronize();
+  __sync_fetch_and_add(&h->sequence[fWriting], 1);
+  __sync_synchronize();
+  h->current = fWriting;
+  __sync_fetch_and_add(&h->version, 1);
+  __sync_bool_compare_and_swap(&h->writer, WriterId(), 0);
+}
+
+void TShare::AbortUpdate() throw (std::string)
+{
+  TShareHeader* h = GetHeader();
+  if (h == NULL || h->writer != WriterId()) return;
+
+  if (h->sequence[fWriting] & 1) __sync_fetch_and_add(&h->sequence[fWriting], 1);
+  __sync_bool_compare_and_swap(&h->writer, WriterId(), 0);
+}
+
+unsigned int TShare::ReadGeneration(void* buffer,unsigned int size,unsigned int maxRetry) throw (std::string)
+{
+  TShareHeader* h = GetHeader();
+  if (h == NULL) throw std::string("TShare::ReadGeneration() memory without generation");
+
+  for (unsigned int retry = 0; retry < maxRetry; retry++)
+    {
+      unsigned int g = h->current;
+      __sync_synchronize();
+      unsigned int s1 = h->sequence[g];
+      __sync_synchronize();
+      if (s1 & 1)
+	{
+	  sched_yield();
+	  continue;
+	}
+      unsigned int length = h->length[g];
+      if (length <= size) memcpy(buffer, (char*)h + TSHAREHEADERSIZE + g*h->size, length);
+      __sync_synchronize();
+      if (h->sequence[g] != s1) continue;
+      if (length > size) throw std::string("TShare::ReadGeneration() buffer too small");
+      return length;
+    }
+  throw std::string("TShare::ReadGeneration() generation modified during all the reads");
+}
+
+const void* TShare::GetGeneration(unsigned int &sequence,unsigned int &length) throw (std::string)
+{
+  TShareHeader* h = GetHeader();
+  if (h == NULL) throw std::string("TShare::GetGeneration() memory without generation");
+
+  unsigned int g;
+  do
+    {
+      g = h->current;
+      __sync_synchronize();
+      sequence = h->sequence[g];
+      __sync_synchronize();
+      if (sequence & 1) sched_yield();
+    }
+  while (sequence & 1);
+  length = h->length[g];
+  return (char*)h + TSHAREHEADERSIZE + g*h->size;
+}
+
+bool TShare::ValidateGeneration(const void* generation,unsigned int sequence) throw (std::string)
+{
+  TShareHeader* h = GetHeader();
+  if (h == NULL) throw std::string("TShare::ValidateGeneration() memory without generation");
+
+  unsigned int g = ((const char*)generation - ((char*)h + TSHAREHEADERSIZE)) / h->size;
+  if (g >= h->generations) return false;
+  __sync_synchronize();
+  return (h->sequence[g] == sequence);
+}
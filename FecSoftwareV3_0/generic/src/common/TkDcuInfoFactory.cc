@@ -32,7 +32,7 @@
  */
 TkDcuInfoFactory::TkDcuInfoFactory ( ):
   DeviceFactoryInterface ( ),
-  initDbVersion_(false), partitionName_("NONE"), versionMajor_(0), versionMinor_(0) {
+  initDbVersion_(false), partitionName_("NONE"), versionMajor_(0), versionMinor_(0), dbStorage_(NULL) {
 
 // #ifdef DATABASE
 //   if (databaseAccess) {
@@ -69,7 +69,7 @@ TkDcuInfoFactory::TkDcuInfoFactory ( ):
 TkDcuInfoFactory::TkDcuInfoFactory ( std::string login, std::string password, std::string path, bool threaded ) throw ( oracle::occi::SQLException ): 
   
   DeviceFactoryInterface ( login, password, path, threaded ), 
-  initDbVersion_(false), partitionName_("NONE"), versionMajor_(0), versionMinor_(0) {
+  initDbVersion_(false), partitionName_("NONE"), versionMajor_(0), versionMinor_(0), dbStorage_(NULL) {
 
   setDatabaseAccess ( login, password, path ) ;
 }
@@ -79,7 +79,7 @@ TkDcuInfoFactory::TkDcuInfoFactory ( std::string login, std::string password, st
  */
 TkDcuInfoFactory::TkDcuInfoFactory ( DbTkDcuInfoAccess *dbAccess ):
   DeviceFactoryInterface ((DbAccess *)dbAccess),
-  initDbVersion_(false), partitionName_("NONE"), versionMajor_(0), versionMinor_(0) {
+  initDbVersion_(false), partitionName_("NONE"), versionMajor_(0), versionMinor_(0), dbStorage_(NULL) {
 }
 
 #endif
@@ -112,6 +112,117 @@ void TkDcuInfoFactory::deleteHashMapTkDcuInfo ( ) {
   vDcuInfo_.clear() ;
 }
 
+// ------------------------------------------------------------------------------------------------------
+// 
+// Storage methods
+//
+// ------------------------------------------------------------------------------------------------------
+
+/** Identifier of a DCU info in the storage: DCU hardware ID
+ */
+static std::string getStorageRecordId ( TkDcuInfo *dcuInfo ) {
+
+  std::ostringstream id ;
+  id << "0x" << std::hex << dcuInfo->getDcuHardId() ;
+  return id.str() ;
+}
+
+/** The DCU infos of the partitions are downloaded from and uploaded to the storage instead of the database.
+ * The methods without partition still use the files.
+ * \param dbStorage - storage of the configuration, NULL to go back to the database or the files
+ * \warning the storage is not deleted by the factory
+ */
+void TkDcuInfoFactory::setStorageAccess ( DbStorage *dbStorage ) {
+
+  dbStorage_ = dbStorage ;
+  initDbVersion_ = false ;
+}
+
+/** Retreive the DCU infos of a version of a partition from the storage and merge them in the DCU infos of this class.
+ * The download is not done again if the version is the one already downloaded. The DCU infos are not masked.
+ * \param partitionName - partition name, ALL for the DCU infos uploaded without partition
+ * \param majorVersionId - major version, 0.0 for the version of the current state
+ * \param minorVersionId - minor version
+ * \param cleanCache - delete the DCU infos already downloaded
+ * \param forceDbReload - download again the version
+ * \exception FecExceptionHandler if the partition or the version does not exist or if the XML cannot be parsed
+ */
+void TkDcuInfoFactory::getStorageDcuInfos ( std::string partitionName, unsigned int majorVersionId, unsigned int minorVersionId, bool cleanCache, bool forceDbReload )
+  throw (FecExceptionHandler ) {
+
+  DbStorageVersion version (majorVersionId, minorVersionId) ;
+  if ((majorVersionId == 0) && (minorVersionId == 0)) {
+    version = dbStorage_->getVersion (partitionName, DBSTORAGE_DCUINFO) ;
+    if ((version.first == 0) && (version.second == 0)) {
+      std::stringstream msgError ; msgError << "no DCU info version for the partition " << partitionName ;
+      RAISEFECEXCEPTIONHANDLER (DB_NOVERSIONAVAILABLE, msgError.str(), ERRORCODE) ;
+    }
+  }
+
+  if (!forceDbReload && initDbVersion_ && (partitionName_ == partitionName) &&
+      (versionMajor_ == version.first) && (versionMinor_ == version.second)) return ;
+
+  // One record per DCU info between the header and the footer of the XML files
+  MemBufOutputSource memBufOS ;
+  memBufOS.generateHeader() ;
+  memBufOS.generateStartTag (DCUCONVERSION_XML_SCHEME) ;
+  std::string xmlBuffer = DbStorage::getXMLBuffer (dbStorage_->getRecords (partitionName, DBSTORAGE_DCUINFO, version, DbStorageVersion (0, 0)), memBufOS.getOutputBuffer()->str(), "</ROWSET>") ;
+
+  XMLTkDcuInfo xmlTkDcuInfo ( (const XMLByte *)xmlBuffer.c_str() ) ;
+  tkDcuInfoVector vDcuInfoVector = xmlTkDcuInfo.getDcuInfos() ;
+
+  // delete the previous data only if asked (default)
+  if (cleanCache) deleteHashMapTkDcuInfo () ;
+  for (tkDcuInfoVector::iterator device = vDcuInfoVector.begin() ; device != vDcuInfoVector.end() ; device ++) {
+    if (vDcuInfo_.find((*device)->getDcuHardId()) != vDcuInfo_.end()) delete vDcuInfo_[(*device)->getDcuHardId()] ;
+    vDcuInfo_[(*device)->getDcuHardId()] = *device ;
+  }
+
+  versionMajor_ = version.first ;
+  versionMinor_ = version.second ;
+  partitionName_ = partitionName ;
+  initDbVersion_ = true ;
+
+#ifdef DEBUGMSGERROR
+  std::cout << "Partition " << partitionName_ << ": " << vDcuInfoVector.size() << " DCU infos in the version " << versionMajor_ << "." << versionMinor_ << std::endl ;
+#endif
+}
+
+/** Upload the DCU infos in a new version of a partition in the storage, the version becomes the one of the current state.
+ * The partition is created if it does not exist.
+ * \param vInfo - DCU infos to be uploaded
+ * \param partitionName - partition name
+ * \param versionMajor - major version created (output)
+ * \param versionMinor - minor version created (output)
+ * \param majorVersion - create a major version with all the DCU infos, including the ones downloaded for this partition, else a minor version with the DCU infos given
+ * \exception FecExceptionHandler if a minor version is created without major version
+ */
+void TkDcuInfoFactory::setStorageDcuInfos ( tkDcuInfoVector vInfo, std::string partitionName, unsigned int *versionMajor, unsigned int *versionMinor, bool majorVersion )
+  throw (FecExceptionHandler ) {
+
+  // Created only if it does not exist, under the lock of the storage
+  dbStorage_->createPartition (partitionName) ;
+
+  // The hash_map can merge several partitions (cleanCache), a major version is only completed with the DCU infos of the same partition
+  DbStorageRecords records ;
+  if (majorVersion && initDbVersion_ && (partitionName_ == partitionName)) {
+    for (Sgi::hash_map<unsigned long, TkDcuInfo *>::iterator itr = vDcuInfo_.begin() ; itr != vDcuInfo_.end() ; itr ++) {
+      MemBufOutputSource memBufOS ;
+      memBufOS.generateTkDcuInfoTag (tkDcuInfoVector (1, itr->second)) ;
+      records[getStorageRecordId (itr->second)] = memBufOS.getOutputBuffer()->str() ;
+    }
+  }
+  for (tkDcuInfoVector::iterator device = vInfo.begin() ; device != vInfo.end() ; device ++) {
+    MemBufOutputSource memBufOS ;
+    memBufOS.generateTkDcuInfoTag (tkDcuInfoVector (1, *device)) ;
+    records[getStorageRecordId (*device)] = memBufOS.getOutputBuffer()->str() ;
+  }
+  DbStorageVersion version = dbStorage_->setRecords (partitionName, DBSTORAGE_DCUINFO, records, majorVersion) ;
+
+  *versionMajor = version.first ;
+  *versionMinor = version.second ;
+}
+
 // ------------------------------------------------------------------------------------------------------
 // 
 // XML file methods
@@ -891,6 +1002,7 @@ tkVersionVector &TkDcuInfoFactory::getAllMaskVersions (std::string partitionName
 }
 
 
+#endif
 
 /** Retreive the descriptions for the given devices from the input
  * \param partitionName - The name of the partition
@@ -900,6 +1012,12 @@ tkVersionVector &TkDcuInfoFactory::getAllMaskVersions (std::string partitionName
 void TkDcuInfoFactory::addDetIdPartition ( std::string partitionName, unsigned int majorVersionId, unsigned int minorVersionId, bool cleanCache, bool forceDbReload )
   throw (FecExceptionHandler) {
 
+  if (getStorageUsed()) {
+    getStorageDcuInfos (partitionName, majorVersionId, minorVersionId, cleanCache, forceDbReload) ;
+    return ;
+  }
+
+#ifdef DATABASE
   // check if the partition should be re-downloaded
   if (forceDbReload) initDbVersion_ = false ;
   if (initDbVersion_) {
@@ -975,6 +1093,9 @@ void TkDcuInfoFactory::addDetIdPartition ( std::string partitionName, unsigned i
 #endif
 
   // All devices are deleted by the XMLFecDevice so nothing must be deleted
+#else
+  RAISEFECEXCEPTIONHANDLER (DB_NOTCONNECTED, DB_NOTCONNECTED_MSG, FATALERRORCODE) ;
+#endif
 }
 
 /** Retreive the descriptions for all the known dcu_ids of the given version
@@ -989,6 +1110,12 @@ void TkDcuInfoFactory::addAllDetId( unsigned int majorVersionId, unsigned int mi
 
   std::string partitionName = "ALL" ;
 
+  if (getStorageUsed()) {
+    getStorageDcuInfos (partitionName, majorVersionId, minorVersionId, cleanCache, forceDbReload) ;
+    return ;
+  }
+
+#ifdef DATABASE
   // check if the partition should be re-downloaded
   if (forceDbReload) initDbVersion_ = false ;
   if (initDbVersion_) {
@@ -1069,8 +1196,10 @@ void TkDcuInfoFactory::addAllDetId( unsigned int majorVersionId, unsigned int mi
 #endif
   
   // All devices are deleted by the XMLFecDevice so nothing must be deleted
-}
+#else
+  RAISEFECEXCEPTIONHANDLER (DB_NOTCONNECTED, DB_NOTCONNECTED_MSG, FATALERRORCODE) ;
 #endif
+}
 
 /** Retreive the descriptions for the given devices from the map. The database or file are not accessed
  * \param dcuHardId - The DCU ID of the detector
@@ -1106,6 +1235,15 @@ void TkDcuInfoFactory::setTkDcuInfo ( tkDcuInfoVector vDcuInfo )
   if (vDcuInfo.empty())
     RAISEFECEXCEPTIONHANDLER( NODATAAVAILABLE, NODATAAVAILABLE_MSG + " to be uploaded in file", ERRORCODE) ;
 
+  if (getStorageUsed()) {
+
+    // Without partition the DCU infos are added to the ones of all partitions (ALL as for addAllDetId)
+    dbStorage_->createPartition ("ALL") ;
+    bool majorVersion = (dbStorage_->getVersion ("ALL", DBSTORAGE_DCUINFO).first == 0) ;
+    unsigned int versionMajor, versionMinor ;
+    setStorageDcuInfos (vDcuInfo, "ALL", &versionMajor, &versionMinor, majorVersion) ;
+  }
+  else
 #ifdef DATABASE
   if (getDbUsed()) {
 
@@ -1147,6 +1285,31 @@ void TkDcuInfoFactory::createNewDcuInfoVersion() throw (FecExceptionHandler){
 }
 #endif
 
+/** Upload the description in a new version of a partition in the storage
+ * \param vInfo - a vector of DCU infos
+ * \param partitionName - partition name
+ * \param versionMajor - major version created (output)
+ * \param versionMinor - minor version created (output)
+ * \param majorVersion - create a major version (default) else a minor version
+ * \warning the database and the files do not version the DCU infos by partition: without storage the DCU infos are uploaded as with setTkDcuInfo(vInfo) and the version is 0.0
+ */
+void TkDcuInfoFactory::setTkDcuInfo ( tkDcuInfoVector vInfo, std::string partitionName, unsigned int *versionMajor, unsigned int *versionMinor, bool majorVersion ) 
+  throw ( FecExceptionHandler ) {
+
+  if (getStorageUsed()) {
+
+    if (vInfo.empty())
+      RAISEFECEXCEPTIONHANDLER( NODATAAVAILABLE, NODATAAVAILABLE_MSG + " to be uploaded", ERRORCODE) ;
+
+    setStorageDcuInfos (vInfo, partitionName, versionMajor, versionMinor, majorVersion) ;
+  }
+  else {
+
+    setTkDcuInfo (vInfo) ;
+    *versionMajor = *versionMinor = 0 ;
+  }
+}
+
 /** Upload the description in the output (database or file)
  * \param vInfo - a hash_map of conversion factors
  */
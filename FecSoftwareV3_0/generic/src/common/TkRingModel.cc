@@ -0,0 +1,217 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Copyright 2002 - 2003, Frederic DROUHIN - Universite de Haute-Alsace, Mulhouse-France
+*/
+#include "cmdDescription.h"
+#include "deviceType.h"
+#include "TkRingModel.h"
+
+/** FEC status register 0 of a closed ring with empty FIFOs
+ */
+#define TKRINGMODELSR0CLOSED 0x0C90
+
+/** \brief Create the model from the CCUs of a ring, all CCUs alive and all links correct
+ * \param tkRing - ring description with the CCUs in the ring order
+ */
+TkRingModel::TkRingModel ( TkRingDescription &tkRing ):
+  ringKey_(tkRing.getKey()), dummy_(tkRing.hasDummyCcu()), dummyInverted_(tkRing.isDummyInverted()),
+  transientFailures_(0), reconfigurations_(0), fecSR0_(TKRINGMODELSR0CLOSED & ~FEC_SR0_LINKINITIALIZED) {
+
+  ccuVector *vCcu = tkRing.getCcuVector() ;
+  for (ccuVector::iterator it = vCcu->begin() ; it != vCcu->end() ; it ++) ccuKeys_.push_back((*it)->getKey()) ;
+  nNormalCcus_ = ccuKeys_.size() - (dummy_ ? 1 : 0) ;
+
+  inputB_.resize(ccuKeys_.size(), false) ;
+  outputB_.resize(ccuKeys_.size(), false) ;
+  fecOutputA_ = fecInputA_ = true ;
+  clearFaults() ;
+}
+
+/** \brief Declare a CCU dead: it does not receive nor forward the token
+ * \exception FecExceptionHandler if the CCU is not in the ring
+ */
+void TkRingModel::setCcuDead ( keyType ccuKey, bool dead ) throw (FecExceptionHandler) {
+
+  alive_[findCcu(ccuKey)] = !dead ;
+}
+
+/** \brief Break the link going into one input of a CCU
+ * \param ccuKey - CCU
+ * \param inputA - input A or B of the CCU
+ * \param broken - broken or repaired
+ * \exception FecExceptionHandler if the CCU is not in the ring
+ */
+void TkRingModel::setInputLinkBroken ( keyType ccuKey, bool inputA, bool broken ) throw (FecExceptionHandler) {
+
+  if (inputA) inputABroken_[findCcu(ccuKey)] = broken ;
+  else inputBBroken_[findCcu(ccuKey)] = broken ;
+}
+
+/** \brief Break the link going into one input of the FEC
+ */
+void TkRingModel::setFecInputLinkBroken ( bool inputA, bool broken ) {
+
+  if (inputA) fecInputABroken_ = broken ;
+  else fecInputBBroken_ = broken ;
+}
+
+/** \brief The next reconfigurations fail whatever the configuration (unstable ring)
+ */
+void TkRingModel::setTransientFailures ( unsigned int number ) {
+
+  transientFailures_ = number ;
+}
+
+/** \brief All the CCUs alive and all the links correct
+ */
+void TkRingModel::clearFaults ( ) {
+
+  alive_.assign(ccuKeys_.size(), true) ;
+  inputABroken_.assign(ccuKeys_.size(), false) ;
+  inputBBroken_.assign(ccuKeys_.size(), false) ;
+  fecInputABroken_ = fecInputBBroken_ = false ;
+  transientFailures_ = 0 ;
+}
+
+/** \brief Apply the ports computed by TkRingDescription::computeRedundancy and follow the token
+ * \return the FEC status register 0
+ * \exception FecExceptionHandler if the ring given is not reconfigurable
+ */
+tscType16 TkRingModel::fecRingReconfigure ( TkRingDescription &tkRing ) throw (FecExceptionHandler) {
+
+  if (!tkRing.isReconfigurable()) {
+    RAISEFECEXCEPTIONHANDLER_HARDPOSITION ( TSCFEC_INVALIDOPERATION,
+					    "It is not possible to reconfigure a ring with the given pattern of enabled CCUs/DOHs: "
+					    + tkRing.getReconfigurationProblem(),
+					    ERRORCODE,
+					    ringKey_ ) ;
+  }
+  tkRing.computeRedundancy() ;
+
+  reconfigurations_ ++ ;
+
+  // The ring reset puts all the CCUs on the ports A, then the CCUs enabled are programmed (if alive)
+  inputB_.assign(ccuKeys_.size(), false) ;
+  outputB_.assign(ccuKeys_.size(), false) ;
+  ccuVector *vCcu = tkRing.getCcuVector() ;
+  for (ccuVector::iterator it = vCcu->begin() ; it != vCcu->end() ; it ++) {
+    if (!(*it)->getEnabled()) continue ;
+    unsigned int index = findCcu((*it)->getKey()) ;
+    if (!alive_[index]) continue ;
+    inputB_[index] = (*it)->getInputB() ;
+    outputB_[index] = (*it)->getOutputB() ;
+  }
+  fecOutputA_ = tkRing.getInputAUsed() ;
+  fecInputA_ = tkRing.getOutputAUsed() ;
+
+  bool closed = followToken() ;
+  if (transientFailures_) {
+    transientFailures_ -- ;
+    closed = false ;
+  }
+  if (!closed) path_.clear() ;
+
+  fecSR0_ = closed ? TKRINGMODELSR0CLOSED : (TKRINGMODELSR0CLOSED & ~FEC_SR0_LINKINITIALIZED) ;
+  return fecSR0_ ;
+}
+
+/** \brief Return the CCUs on the path of the token if the ring is closed
+ */
+std::list<keyType> *TkRingModel::getCcuList ( ) throw (FecExceptionHandler) {
+
+  return new std::list<keyType>(path_) ;
+}
+
+/** Find the index of a CCU (the dummy is the last one)
+ */
+unsigned int TkRingModel::findCcu ( keyType ccuKey ) throw (FecExceptionHandler) {
+
+  for (unsigned int i = 0 ; i < ccuKeys_.size() ; i ++)
+    if (getCcuKey(ccuKeys_[i]) == getCcuKey(ccuKey)) return i ;
+
+  RAISEFECEXCEPTIONHANDLER_HARDPOSITION ( TSCFEC_FECPARAMETERNOTMANAGED,
+					  "CCU not present in the ring model",
+					  ERRORCODE,
+					  ccuKey ) ;
+}
+
+/** Follow the token from the FEC, return true if it comes back on the input selected by the FEC.
+ * Each step has one or two destinations (node, input A), the first destination alive and listening
+ * on this input through a correct link receives the token.
+ */
+bool TkRingModel::followToken ( ) {
+
+  path_.clear() ;
+
+  int dummyNode = dummy_ ? (int)nNormalCcus_ : NONODE ;
+  int destination[2] ;
+  bool destinationA[2] ;
+  unsigned int nDestinations ;
+
+  // FEC output
+  if (fecOutputA_) {
+    destination[0] = 0 ; destinationA[0] = true ; nDestinations = 1 ;
+  }
+  else {
+    destination[0] = 0 ; destinationA[0] = false ;
+    destination[1] = 1 ; destinationA[1] = false ; nDestinations = 2 ;
+  }
+
+  std::vector<bool> visited (ccuKeys_.size(), false) ;
+  while (true) {
+
+    int node = NONODE ;
+    for (unsigned int i = 0 ; (i < nDestinations) && (node == NONODE) ; i ++) {
+      if (destination[i] == FECNODE) {
+	bool broken = destinationA[i] ? fecInputABroken_ : fecInputBBroken_ ;
+	if ((fecInputA_ == destinationA[i]) && !broken) return true ;
+      }
+      else if (destination[i] >= 0) {
+	unsigned int index = destination[i] ;
+	bool broken = destinationA[i] ? inputABroken_[index] : inputBBroken_[index] ;
+	if (alive_[index] && !broken && (inputB_[index] != destinationA[i])) {
+	  node = destination[i] ;
+	}
+      }
+    }
+
+    // Nobody received the token or it loops
+    if ((node == NONODE) || visited[node]) return false ;
+    visited[node] = true ;
+    path_.push_back(ccuKeys_[node]) ;
+
+    // CCU output
+    nDestinations = 1 ;
+    if (node == dummyNode) {
+      destination[0] = FECNODE ; destinationA[0] = false ;
+    }
+    else if (!outputB_[node]) {
+      destination[0] = (node + 1 < (int)nNormalCcus_) ? node + 1 : FECNODE ;
+      destinationA[0] = true ;
+    }
+    else if (node + 2 < (int)nNormalCcus_) {
+      destination[0] = node + 2 ; destinationA[0] = false ;
+    }
+    else {
+      // Before last CCU goes to the dummy input B, last CCU goes to the dummy input A (or swapped)
+      destination[0] = dummyNode ;
+      destinationA[0] = (node == (int)nNormalCcus_ - 1) ;
+      if (dummyInverted_) destinationA[0] = !destinationA[0] ;
+    }
+  }
+}
@@ -0,0 +1,422 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Copyright 2002 - 2003, Frederic DROUHIN - Universite de Haute-Alsace, Mulhouse-France
+*/
+#include <algorithm>
+
+#include "cmdDescription.h"
+#include "deviceType.h"
+#include "TkRingRedundancyPlanner.h"
+
+/** Error bits of the CCU status register A that point to a problem on the ring
+ */
+#define CCU_SRA_RINGERRORS (CCU_SRA_CRC_ERROR | CCU_SRA_IN_ERROR | CCU_SRA_PAR_ERROR | CCU_SRA_ISEQ_ERROR | CCU_SRA_ICMD_ERROR)
+
+/** Suspicion given to the first CCU missing after a CCU which answered, the ring is broken here or just before
+ */
+#define SUSPICIONBREAK    4
+/** Suspicion given to the last CCU which answered before the break
+ */
+#define SUSPICIONBEFORE   2
+/** Suspicion given to a CCU with errors in its status register A
+ */
+#define SUSPICIONSRA      2
+/** Suspicion given to any CCU missing in the scan
+ */
+#define SUSPICIONMISSING  1
+/** Suspicion given to a CCU not using the ports of the current configuration
+ */
+#define SUSPICIONSRC      1
+
+/** \brief Create a planner without symptoms, 1 try for each configuration
+ */
+TkRingRedundancyPlanner::TkRingRedundancyPlanner ( ): tries_(1), maximumConfigurations_(0) {
+
+  reset() ;
+}
+
+/** \brief Clear the symptoms, the plan and the attempts
+ */
+void TkRingRedundancyPlanner::reset ( ) {
+
+  fecSR0_ = 0 ;
+  fecSR0Set_ = false ;
+  ccuList_.clear() ;
+  ccuListSet_ = false ;
+  ccuStatus_.clear() ;
+  ccuOrder_.clear() ;
+  suspicion_.clear() ;
+  configurations_.clear() ;
+  attempts_.clear() ;
+}
+
+// ***********************************************************************************************
+// Symptoms
+// ***********************************************************************************************
+
+/** \brief Set the FEC status register 0 read on the broken ring
+ */
+void TkRingRedundancyPlanner::setFecSR0 ( tscType16 fecSR0 ) {
+
+  fecSR0_ = fecSR0 ;
+  fecSR0Set_ = true ;
+}
+
+/** \brief Set the CCUs found by a scan of the ring (FecAccess::getCcuList)
+ */
+void TkRingRedundancyPlanner::setCcuList ( const std::list<keyType> &ccuList ) {
+
+  ccuList_ = ccuList ;
+  ccuListSet_ = true ;
+}
+
+/** \brief Set the status registers of a CCU that answered
+ * \param ccuKey - CCU key
+ * \param sra - CCU status register A, the error bits make the CCU suspect
+ * \param src - CCU status register C, a CCU not using the ports of the current configuration is suspect
+ */
+void TkRingRedundancyPlanner::setCcuStatus ( keyType ccuKey, tscType8 sra, tscType8 src ) {
+
+  ccuStatus_[getCcuKey(ccuKey)] = (tscType16)sra | ((tscType16)src << 8) ;
+}
+
+// ***********************************************************************************************
+// Plan
+// ***********************************************************************************************
+
+/** \brief Number of times each configuration is applied before trying the next one (at least 1)
+ */
+void TkRingRedundancyPlanner::setTries ( unsigned int tries ) {
+
+  tries_ = tries ? tries : 1 ;
+}
+
+/** \brief Maximum number of configurations tried by apply, 0 for all of them
+ */
+void TkRingRedundancyPlanner::setMaximumConfigurations ( unsigned int maximum ) {
+
+  maximumConfigurations_ = maximum ;
+}
+
+/** \brief Check the symptoms against the ring
+ * \return true if the SR0 is not correct or if one of the enabled CCUs is missing in the scan.
+ * Without any symptom the recovery is considered as needed.
+ */
+bool TkRingRedundancyPlanner::isRecoveryNeeded ( TkRingDescription &tkRing ) {
+
+  if (!fecSR0Set_ && !ccuListSet_) return true ;
+  if (fecSR0Set_ && !isFecSR0Correct(fecSR0_)) return true ;
+  if (ccuListSet_ && !isCcuListCorrect(tkRing, ccuList_)) return true ;
+
+  return false ;
+}
+
+/** \brief Enumerate and rank the configurations of the ring
+ * \param tkRing - ring with the CCUs in the ring order, its current configuration is not part of the plan
+ * \return the configurations, best first
+ * \exception FecExceptionHandler if the ring has not enough CCUs to be reconfigured
+ */
+const std::vector<TkRingRedundancyPlanner::Configuration> &TkRingRedundancyPlanner::plan ( TkRingDescription &tkRing ) throw (FecExceptionHandler) {
+
+  configurations_.clear() ;
+
+  unsigned int nNormalCcus = getNumberOfNormalCcus(tkRing) ;
+  if (nNormalCcus < 3) {
+    RAISEFECEXCEPTIONHANDLER_HARDPOSITION ( TSCFEC_INVALIDOPERATION,
+					    "Not enough CCUs in the ring to find a redundancy configuration",
+					    ERRORCODE,
+					    tkRing.getKey() ) ;
+  }
+
+  computeSuspicion(tkRing) ;
+
+  // Enumerate all the possibilities, the validation of each of them is done by TkRingDescription::isReconfigurable
+  Configuration current = getConfiguration(tkRing) ;
+  Configuration configuration ;
+  configuration.bypassed_.resize(nNormalCcus, false) ;
+  enumerate(tkRing, configuration, 0, current) ;
+
+  // Restore the ring as it was given
+  setConfiguration(tkRing, current) ;
+
+  std::stable_sort(configurations_.begin(), configurations_.end(), isBetter) ;
+
+  return configurations_ ;
+}
+
+/** \brief Apply the configurations of the plan until the ring is recovered
+ * \param access - access to the ring
+ * \param tkRing - ring description, set to the configuration that worked or left unchanged if none worked
+ * \return true if the ring is recovered (or if it did not need a recovery)
+ * \exception FecExceptionHandler if the ring has not enough CCUs to be reconfigured
+ */
+bool TkRingRedundancyPlanner::apply ( TkRingAccess &access, TkRingDescription &tkRing ) throw (FecExceptionHandler) {
+
+  attempts_.clear() ;
+  if (!isRecoveryNeeded(tkRing)) return true ;
+
+  Configuration current = getConfiguration(tkRing) ;
+  plan(tkRing) ;
+
+  unsigned int nConfigurations = configurations_.size() ;
+  if (maximumConfigurations_ && (maximumConfigurations_ < nConfigurations)) nConfigurations = maximumConfigurations_ ;
+
+  for (unsigned int i = 0 ; i < nConfigurations ; i ++) {
+    for (unsigned int counter = 0 ; counter < tries_ ; counter ++) {
+
+      setConfiguration(tkRing, configurations_[i]) ;
+
+      Attempt attempt ;
+      attempt.configuration_ = i ;
+      attempt.fecSR0_ = 0 ;
+      attempt.ccusFound_ = 0 ;
+      attempt.verified_ = false ;
+      try {
+	attempt.fecSR0_ = access.fecRingReconfigure(tkRing) ;
+
+	// -------------------------------------
+	// the ring is closed, check that the CCUs expected are here
+	if (isFecSR0Correct(attempt.fecSR0_)) {
+	  std::list<keyType> *ccuList = access.getCcuList() ;
+	  if (ccuList != NULL) {
+	    attempt.ccusFound_ = ccuList->size() ;
+	    attempt.verified_ = isCcuListCorrect(tkRing, *ccuList) ;
+	    if (!attempt.verified_) attempt.error_ = "the CCUs found by the scan do not match the CCUs kept" ;
+	    delete ccuList ;
+	  }
+	}
+      }
+      catch (FecExceptionHandler &e) {
+	attempt.error_ = e.what() ;
+      }
+
+      attempts_.push_back(attempt) ;
+      if (attempt.verified_) return true ;
+    }
+  }
+
+  // Nothing worked, put back the ring description as it was
+  setConfiguration(tkRing, current) ;
+
+  return false ;
+}
+
+/** \brief Return the suspicion on a CCU computed from the symptoms by the last plan
+ */
+unsigned int TkRingRedundancyPlanner::getSuspicion ( keyType ccuKey ) {
+
+  for (unsigned int i = 0 ; i < ccuOrder_.size() && i < suspicion_.size() ; i ++) {
+    if (ccuOrder_[i] == getCcuKey(ccuKey)) return suspicion_[i] ;
+  }
+
+  return 0 ;
+}
+
+/** \brief Display the plan and the attempts into a stream
+ */
+void TkRingRedundancyPlanner::display ( std::ostream &flux, TkRingDescription &tkRing ) {
+
+  flux << configurations_.size() << " configurations found for the ring" << std::endl ;
+  for (unsigned int i = 0 ; i < configurations_.size() ; i ++) {
+    flux << std::dec << i << ": " ;
+    display(flux, tkRing, configurations_[i]) ;
+    flux << std::endl ;
+  }
+  for (std::vector<Attempt>::iterator it = attempts_.begin() ; it != attempts_.end() ; it ++) {
+    flux << "Configuration " << std::dec << it->configuration_ << ": SR0 = 0x" << std::hex << it->fecSR0_ << std::dec
+	 << ", " << it->ccusFound_ << " CCUs found" << (it->verified_ ? ", ring recovered" : "") ;
+    if (it->error_.size()) flux << " (" << it->error_ << ")" ;
+    flux << std::endl ;
+  }
+}
+
+// ***********************************************************************************************
+// Static method
+// ***********************************************************************************************
+
+/** \brief Set the ring description to a configuration (enabled CCUs and FEC input/output)
+ * The ports of the CCUs are computed if the configuration is valid.
+ */
+void TkRingRedundancyPlanner::setConfiguration ( TkRingDescription &tkRing, const Configuration &configuration ) {
+
+  ccuVector *vCcu = tkRing.getCcuVector() ;
+  unsigned int nNormalCcus = getNumberOfNormalCcus(tkRing) ;
+  for (unsigned int i = 0 ; i < nNormalCcus && i < configuration.bypassed_.size() ; i ++)
+    (*vCcu)[i]->setEnabled(!configuration.bypassed_[i]) ;
+
+  // The dummy CCU is only used with the FEC input B
+  if (tkRing.hasDummyCcu()) vCcu->back()->setEnabled(!configuration.outputAUsed_) ;
+
+  tkRing.setInputAUsed(configuration.inputAUsed_) ;
+  tkRing.setOutputAUsed(configuration.outputAUsed_) ;
+  tkRing.computeRedundancy() ;
+}
+
+/** \brief Get the configuration currently set in a ring description
+ */
+TkRingRedundancyPlanner::Configuration TkRingRedundancyPlanner::getConfiguration ( TkRingDescription &tkRing ) {
+
+  Configuration configuration ;
+  ccuVector *vCcu = tkRing.getCcuVector() ;
+  unsigned int nNormalCcus = getNumberOfNormalCcus(tkRing) ;
+  configuration.ccusKept_ = 0 ;
+  for (unsigned int i = 0 ; i < nNormalCcus ; i ++) {
+    configuration.bypassed_.push_back(!(*vCcu)[i]->getEnabled()) ;
+    if ((*vCcu)[i]->getEnabled()) configuration.ccusKept_ ++ ;
+  }
+  configuration.inputAUsed_ = tkRing.getInputAUsed() ;
+  configuration.outputAUsed_ = tkRing.getOutputAUsed() ;
+  configuration.suspicion_ = 0 ;
+  configuration.portsB_ = (configuration.inputAUsed_ ? 0 : 1) + (configuration.outputAUsed_ ? 0 : 1) ;
+
+  return configuration ;
+}
+
+/** \brief Check that the CCUs kept by the ring, and only them, are in the list
+ * The dummy CCU is not checked.
+ */
+bool TkRingRedundancyPlanner::isCcuListCorrect ( TkRingDescription &tkRing, const std::list<keyType> &ccuList ) {
+
+  ccuVector *vCcu = tkRing.getCcuVector() ;
+  unsigned int nNormalCcus = getNumberOfNormalCcus(tkRing) ;
+  for (unsigned int i = 0 ; i < nNormalCcus ; i ++) {
+    bool found = false ;
+    for (std::list<keyType>::const_iterator it = ccuList.begin() ; (it != ccuList.end()) && !found ; it ++)
+      if (getCcuKey(*it) == getCcuKey((*vCcu)[i]->getKey())) found = true ;
+    if (found != (*vCcu)[i]->getEnabled()) return false ;
+  }
+
+  return true ;
+}
+
+/** \brief Display a configuration in the same format as TkRingDescription::display
+ */
+void TkRingRedundancyPlanner::display ( std::ostream &flux, TkRingDescription &tkRing, const Configuration &configuration ) {
+
+  ccuVector *vCcu = tkRing.getCcuVector() ;
+  flux << "FEC->" << (configuration.inputAUsed_ ? "A " : "B ") ;
+  for (unsigned int i = 0 ; i < configuration.bypassed_.size() && i < vCcu->size() ; i ++) {
+    if (!configuration.bypassed_[i]) flux << "CCU_" << std::dec << (int)getCcuKey((*vCcu)[i]->getKey()) << " " ;
+  }
+  if (!configuration.outputAUsed_ && tkRing.hasDummyCcu()) flux << "CCU_" << std::dec << (int)getCcuKey(vCcu->back()->getKey()) << " " ;
+  flux << (configuration.outputAUsed_ ? "A" : "B") << "->FEC"
+       << " (" << configuration.ccusKept_ << " CCUs kept, suspicion " << configuration.suspicion_ << ")" ;
+}
+
+// ***********************************************************************************************
+// Private methods
+// ***********************************************************************************************
+
+/** Enumerate recursively the bypass patterns with no two consecutive CCUs bypassed.
+ * The patterns bypassing a CCU are generated first so that for the same number of CCUs and the same
+ * suspicion the CCUs close to the FEC are bypassed first.
+ */
+void TkRingRedundancyPlanner::enumerate ( TkRingDescription &tkRing, Configuration &configuration, unsigned int position, const Configuration &current ) {
+
+  if (position < configuration.bypassed_.size()) {
+    if ((position == 0) || !configuration.bypassed_[position-1]) {
+      configuration.bypassed_[position] = true ;
+      enumerate(tkRing, configuration, position+1, current) ;
+    }
+    configuration.bypassed_[position] = false ;
+    enumerate(tkRing, configuration, position+1, current) ;
+    return ;
+  }
+
+  configuration.ccusKept_ = 0 ;
+  configuration.suspicion_ = 0 ;
+  for (unsigned int i = 0 ; i < configuration.bypassed_.size() ; i ++) {
+    if (configuration.bypassed_[i]) configuration.suspicion_ += suspicion_[i] ;
+    else configuration.ccusKept_ ++ ;
+  }
+
+  // For each pattern the four FEC input/output combinations
+  for (int ports = 0 ; ports < 4 ; ports ++) {
+    configuration.inputAUsed_  = !(ports & 0x1) ;
+    configuration.outputAUsed_ = !(ports & 0x2) ;
+    configuration.portsB_ = (configuration.inputAUsed_ ? 0 : 1) + (configuration.outputAUsed_ ? 0 : 1) ;
+
+    // The configuration that failed is not tried again
+    if ((configuration.inputAUsed_ == current.inputAUsed_) && (configuration.outputAUsed_ == current.outputAUsed_) &&
+	(configuration.bypassed_ == current.bypassed_)) continue ;
+
+    setConfiguration(tkRing, configuration) ;
+    if (tkRing.isReconfigurable()) configurations_.push_back(configuration) ;
+  }
+}
+
+/** Compute the suspicion for each CCU of the ring from the symptoms
+ */
+void TkRingRedundancyPlanner::computeSuspicion ( TkRingDescription &tkRing ) {
+
+  ccuVector *vCcu = tkRing.getCcuVector() ;
+  unsigned int nNormalCcus = getNumberOfNormalCcus(tkRing) ;
+
+  suspicion_.assign(nNormalCcus, 0) ;
+  ccuOrder_.clear() ;
+  for (unsigned int i = 0 ; i < nNormalCcus ; i ++) ccuOrder_.push_back(getCcuKey((*vCcu)[i]->getKey())) ;
+
+  // The ports of the CCUs are known only if the current configuration is valid
+  bool portsKnown = tkRing.computeRedundancy() ;
+
+  bool previousFound = true ; // the FEC
+  for (unsigned int i = 0 ; i < nNormalCcus ; i ++) {
+
+    bool found = false ;
+    for (std::list<keyType>::iterator it = ccuList_.begin() ; (it != ccuList_.end()) && !found ; it ++)
+      if (getCcuKey(*it) == ccuOrder_[i]) found = true ;
+
+    if (ccuListSet_ && !found) {
+      suspicion_[i] += SUSPICIONMISSING ;
+      // A break after a CCU that answered: this CCU or the link into it
+      if (previousFound && !ccuList_.empty()) {
+	suspicion_[i] += SUSPICIONBREAK ;
+	if (i > 0) suspicion_[i-1] += SUSPICIONBEFORE ;
+      }
+    }
+    previousFound = found ;
+
+    std::map<keyType, tscType16>::iterator status = ccuStatus_.find(ccuOrder_[i]) ;
+    if (status != ccuStatus_.end()) {
+      tscType8 sra = status->second & 0xFF ;
+      tscType8 src = status->second >> 8 ;
+      if (sra & CCU_SRA_RINGERRORS) suspicion_[i] += SUSPICIONSRA ;
+      if (portsKnown && (*vCcu)[i]->getEnabled() &&
+	  ((((src & CCU_SRC_INPUTPORT) != 0) != (*vCcu)[i]->getInputB()) ||
+	   (((src & CCU_SRC_OUTPUTPORT) != 0) != (*vCcu)[i]->getOutputB()))) suspicion_[i] += SUSPICIONSRC ;
+    }
+  }
+}
+
+/** Sort the configuration: more CCUs kept, then the most suspect CCUs bypassed, then the less FEC ports B used
+ */
+bool TkRingRedundancyPlanner::isBetter ( const Configuration &c1, const Configuration &c2 ) {
+
+  if (c1.ccusKept_ != c2.ccusKept_) return (c1.ccusKept_ > c2.ccusKept_) ;
+  if (c1.suspicion_ != c2.suspicion_) return (c1.suspicion_ > c2.suspicion_) ;
+  return (c1.portsB_ < c2.portsB_) ;
+}
+
+/** Return the number of CCUs of the ring without the dummy CCU
+ */
+unsigned int TkRingRedundancyPlanner::getNumberOfNormalCcus ( TkRingDescription &tkRing ) {
+
+  unsigned int nNormalCcus = tkRing.getNumberOfCcus() ;
+  if (tkRing.hasDummyCcu() && nNormalCcus) nNormalCcus -- ;
+  return nNormalCcus ;
+}
@@ -0,0 +1,377 @@
+/*
+  This file is part of Fec Software project.
+
+  Fec Software is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  Fec Software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Fec Software; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+
+#include "dcuDescription.h"
+#include "TkTopologyIndex.h"
+
+/** FED id and channel in one word
+ */
+#define TKTOPOLOGY_FEDKEY(fedId,fedChannel) (((unsigned long)(fedId) << 8) | ((fedChannel) & 0xFF))
+
+/** Connection of a module before the FED channels are grouped by module
+ */
+typedef struct {
+  unsigned int moduleId ;
+  TkTopologyFedChannel fedChannel ;
+} connectionType ;
+
+/** Sort the connections by module then by APV address
+ */
+static bool sortConnectionByModule ( const connectionType &c1, const connectionType &c2 ) {
+
+  if (c1.moduleId != c2.moduleId) return c1.moduleId < c2.moduleId ;
+  return c1.fedChannel.apvAddress < c2.fedChannel.apvAddress ;
+}
+
+/**
+ * \param connections - connections
+ * \param dcuInfos - DCU infos
+ * \param dcuPsuMaps - DCU-PSU map (control and power groups)
+ * \param dcuDevices - FEC devices, only the DCUs are used
+ * \param version - versions of the sources
+ */
+TkTopologyIndex::TkTopologyIndex ( ConnectionVector &connections, tkDcuInfoVector &dcuInfos, tkDcuPsuMapVector &dcuPsuMaps,
+				   deviceVector &dcuDevices, const TkTopologyVersion &version ):
+  version_(version) {
+
+  build (connections, dcuInfos, dcuPsuMaps, dcuDevices) ;
+}
+
+/**
+ * \param connections - connections
+ * \param dcuInfos - DCU infos from TkDcuInfoFactory::getInfos
+ * \param dcuPsuMaps - DCU-PSU map (control and power groups)
+ * \param dcuDevices - FEC devices, only the DCUs are used
+ * \param version - versions of the sources
+ */
+TkTopologyIndex::TkTopologyIndex ( ConnectionVector &connections, Sgi::hash_map<unsigned long, TkDcuInfo *> &dcuInfos, tkDcuPsuMapVector &dcuPsuMaps,
+				   deviceVector &dcuDevices, const TkTopologyVersion &version ):
+  version_(version) {
+
+  tkDcuInfoVector vDcuInfos ;
+  for (Sgi::hash_map<unsigned long, TkDcuInfo *>::iterator it = dcuInfos.begin() ; it != dcuInfos.end() ; it ++) vDcuInfos.push_back (it->second) ;
+  build (connections, vDcuInfos, dcuPsuMaps, dcuDevices) ;
+}
+
+/**
+ * \param violation - inconsistency found
+ */
+void TkTopologyIndex::addViolation ( std::string violation ) {
+
+#ifdef DEBUGMSGERROR
+  std::cerr << "TkTopologyIndex: " << violation << std::endl ;
+#endif
+
+  violations_.push_back (violation) ;
+}
+
+/**
+ * \param dcuHardId - DCU hardware id
+ * \return module identifier
+ */
+unsigned int TkTopologyIndex::getModuleId ( tscType32 dcuHardId ) {
+
+  Sgi::hash_map<unsigned long, unsigned int>::iterator it = dcuHardIdIndex_.find (dcuHardId) ;
+  if (it != dcuHardIdIndex_.end()) return it->second ;
+
+  TkTopologyModule module ;
+  module.dcuHardId = dcuHardId ;
+  module.detId = 0 ;
+  module.fecCrateId = TKTOPOLOGY_INVALID ;
+  module.fecKey = TKTOPOLOGY_INVALID ;
+  module.psuId = TKTOPOLOGY_INVALID ;
+  module.apvNumber = 0 ;
+  module.fibreLength = 0 ;
+  module.firstFedChannel = module.fedChannelNumber = 0 ;
+  modules_.push_back (module) ;
+
+  dcuHardIdIndex_[dcuHardId] = modules_.size() - 1 ;
+  return modules_.size() - 1 ;
+}
+
+/**
+ * \param moduleId - module
+ * \param fecCrateId - FEC crate
+ * \param fecKey - FEC, ring, CCU, channel (the address is ignored)
+ * \param source - source of the key for the violations
+ */
+void TkTopologyIndex::setFecKey ( unsigned int moduleId, unsigned int fecCrateId, keyType fecKey, const char *source ) {
+
+  TkTopologyModule &module = modules_[moduleId] ;
+  fecKey = getFecRingCcuChannelKey (fecKey) ;
+
+  if (module.fecKey != TKTOPOLOGY_INVALID) {
+    if ((module.fecCrateId != fecCrateId) || (module.fecKey != fecKey)) {
+      char msg1[MAXCHARDECODEKEY], msg2[MAXCHARDECODEKEY] ;
+      decodeKey (msg1, module.fecKey) ;
+      decodeKey (msg2, fecKey) ;
+      std::ostringstream violation ;
+      violation << "DCU " << module.dcuHardId << " on crate " << module.fecCrateId << " " << msg1
+		<< " and on crate " << fecCrateId << " " << msg2 << " in the " << source ;
+      addViolation (violation.str()) ;
+    }
+    return ;
+  }
+
+  crateKeyType index = ((crateKeyType)fecCrateId << 32) | fecKey ;
+  Sgi::hash_map<crateKeyType, unsigned int, hashCrateKey>::iterator it = fecKeyIndex_.find (index) ;
+  if (it != fecKeyIndex_.end()) {
+    char msg[MAXCHARDECODEKEY] ;
+    decodeKey (msg, fecKey) ;
+    std::ostringstream violation ;
+    violation << "DCUs " << modules_[it->second].dcuHardId << " and " << module.dcuHardId << " on crate " << fecCrateId << " " << msg
+	      << " in the " << source ;
+    addViolation (violation.str()) ;
+    return ;
+  }
+
+  module.fecCrateId = fecCrateId ;
+  module.fecKey = fecKey ;
+  fecKeyIndex_[index] = moduleId ;
+}
+
+/** Each source is read once, in the order DCU infos, DCU descriptions, connections, DCU-PSU map. When two
+ * sources disagree, the value already set is kept and a violation is added.
+ * \param connections - connections
+ * \param dcuInfos - DCU infos
+ * \param dcuPsuMaps - DCU-PSU map
+ * \param dcuDevices - FEC devices, only the DCUs are used
+ */
+void TkTopologyIndex::build ( ConnectionVector &connections, tkDcuInfoVector &dcuInfos, tkDcuPsuMapVector &dcuPsuMaps, deviceVector &dcuDevices ) {
+
+  modules_.reserve (dcuInfos.size() + dcuPsuMaps.size() / 4) ;
+
+  // DCU infos: det id, number of APVs, fibre length
+  for (tkDcuInfoVector::iterator it = dcuInfos.begin() ; it != dcuInfos.end() ; it ++) {
+
+    unsigned int moduleId = getModuleId ((*it)->getDcuHardId()) ;
+    TkTopologyModule &module = modules_[moduleId] ;
+    if ((module.detId != 0) || (module.apvNumber != 0)) {
+      std::ostringstream violation ;
+      violation << "DCU " << module.dcuHardId << " defined twice in the DCU infos" ;
+      addViolation (violation.str()) ;
+      continue ;
+    }
+
+    module.apvNumber = (*it)->getApvNumber() ;
+    module.fibreLength = (*it)->getFibreLength() ;
+    tscType32 detId = (*it)->getDetId() ;
+    if (detId == 0) continue ;
+
+    Sgi::hash_map<unsigned long, unsigned int>::iterator det = detIdIndex_.find (detId) ;
+    if (det != detIdIndex_.end()) {
+      std::ostringstream violation ;
+      violation << "det id " << detId << " on DCUs " << modules_[det->second].dcuHardId << " and " << module.dcuHardId ;
+      addViolation (violation.str()) ;
+    }
+    else {
+      module.detId = detId ;
+      detIdIndex_[detId] = moduleId ;
+    }
+  }
+
+  // DCU descriptions: FEC crate and key of all DCUs, CCU DCUs included
+  for (deviceVector::iterator it = dcuDevices.begin() ; it != dcuDevices.end() ; it ++) {
+    if ((*it)->getDeviceType() != DCU) continue ;
+    dcuDescription *dcu = (dcuDescription *)*it ;
+    setFecKey (getModuleId (dcu->getDcuHardId()), dcu->getCrateId(), dcu->getKey(), "DCU descriptions") ;
+  }
+
+  // Connections: FEC crate and key, FED channels
+  std::vector<connectionType> moduleConnections ;
+  moduleConnections.reserve (connections.size()) ;
+  for (ConnectionVector::iterator it = connections.begin() ; it != connections.end() ; it ++) {
+
+    ConnectionDescription *connection = *it ;
+    if (connection->getDcuHardId() == 0) {
+      char msg[MAXCHARDECODEKEY] ;
+      decodeKey (msg, connection->getKey()) ;
+      std::ostringstream violation ;
+      violation << "connection FED " << connection->getFedId() << " channel " << connection->getFedChannel() << " on " << msg << " without DCU" ;
+      addViolation (violation.str()) ;
+      continue ;
+    }
+
+    unsigned long fedKey = TKTOPOLOGY_FEDKEY (connection->getFedId(), connection->getFedChannel()) ;
+    if (fedChannelIndex_.find (fedKey) != fedChannelIndex_.end()) {
+      std::ostringstream violation ;
+      violation << "FED " << connection->getFedId() << " channel " << connection->getFedChannel() << " connected twice" ;
+      addViolation (violation.str()) ;
+      continue ;
+    }
+    fedChannelIndex_[fedKey] = moduleConnections.size() ;
+
+    unsigned int moduleId = getModuleId (connection->getDcuHardId()) ;
+    if (modules_[moduleId].detId == 0) {
+      std::ostringstream violation ;
+      violation << "DCU " << connection->getDcuHardId() << " connected to FED " << connection->getFedId() << " channel " << connection->getFedChannel() << " without DCU info" ;
+      addViolation (violation.str()) ;
+    }
+    setFecKey (moduleId, connection->getFecCrateId(), connection->getKey(), "connections") ;
+
+    connectionType moduleConnection ;
+    moduleConnection.moduleId = moduleId ;
+    moduleConnection.fedChannel.fedId = connection->getFedId() ;
+    moduleConnection.fedChannel.fedChannel = connection->getFedChannel() ;
+    moduleConnection.fedChannel.apvAddress = connection->getApvAddress() ;
+    moduleConnection.fedChannel.moduleId = moduleId ;
+    moduleConnections.push_back (moduleConnection) ;
+  }
+
+  // FED channels grouped by module
+  std::sort (moduleConnections.begin(), moduleConnections.end(), sortConnectionByModule) ;
+  fedChannels_.reserve (moduleConnections.size()) ;
+  for (std::vector<connectionType>::iterator it = moduleConnections.begin() ; it != moduleConnections.end() ; it ++) {
+    TkTopologyModule &module = modules_[it->moduleId] ;
+    if (module.fedChannelNumber == 0) module.firstFedChannel = fedChannels_.size() ;
+    module.fedChannelNumber ++ ;
+    fedChannelIndex_[TKTOPOLOGY_FEDKEY(it->fedChannel.fedId, it->fedChannel.fedChannel)] = fedChannels_.size() ;
+    fedChannels_.push_back (it->fedChannel) ;
+  }
+  for (std::vector<TkTopologyModule>::iterator it = modules_.begin() ; it != modules_.end() ; it ++) {
+    if (it->apvNumber && (it->fedChannelNumber * 2 > it->apvNumber)) {
+      std::ostringstream violation ;
+      violation << "DCU " << it->dcuHardId << " with " << it->apvNumber << " APVs connected to " << it->fedChannelNumber << " FED channels" ;
+      addViolation (violation.str()) ;
+    }
+  }
+
+  // DCU-PSU map
+  std::vector<unsigned int> psuOfModules ;
+  for (tkDcuPsuMapVector::iterator it = dcuPsuMaps.begin() ; it != dcuPsuMaps.end() ; it ++) {
+
+    std::string psuName = (*it)->getPsuName() ;
+    unsigned int psuId ;
+    std::map<std::string, unsigned int>::iterator psu = psuIndex_.find (psuName) ;
+    if (psu != psuIndex_.end()) psuId = psu->second ;
+    else {
+      TkTopologyPsu newPsu ;
+      newPsu.psuName = psuName ;
+      newPsu.psuType = (*it)->getPsuType() ;
+      newPsu.firstModule = newPsu.moduleNumber = 0 ;
+      psuId = psus_.size() ;
+      psus_.push_back (newPsu) ;
+      psuIndex_[psuName] = psuId ;
+    }
+
+    unsigned int moduleId = getModuleId ((*it)->getDcuHardId()) ;
+    TkTopologyModule &module = modules_[moduleId] ;
+    if (module.psuId != TKTOPOLOGY_INVALID) {
+      if (module.psuId != psuId) {
+	std::ostringstream violation ;
+	violation << "DCU " << module.dcuHardId << " on the PSUs " << psus_[module.psuId].psuName << " and " << psuName ;
+	addViolation (violation.str()) ;
+      }
+      continue ;
+    }
+    module.psuId = psuId ;
+    psus_[psuId].moduleNumber ++ ;
+    psuOfModules.push_back (moduleId) ;
+
+    keyType fecIndex = (*it)->getFecIndex() ;
+    if (fecIndex && (module.fecKey != TKTOPOLOGY_INVALID) && (getFecRingCcuChannelKey(fecIndex) != module.fecKey)) {
+      char msg1[MAXCHARDECODEKEY], msg2[MAXCHARDECODEKEY] ;
+      decodeKey (msg1, module.fecKey) ;
+      decodeKey (msg2, fecIndex) ;
+      std::ostringstream violation ;
+      violation << "DCU " << module.dcuHardId << " on " << msg1 << " and on " << msg2 << " in the DCU-PSU map" ;
+      addViolation (violation.str()) ;
+    }
+  }
+
+  // Modules grouped by PSU
+  unsigned int position = 0 ;
+  for (std::vector<TkTopologyPsu>::iterator it = psus_.begin() ; it != psus_.end() ; it ++) {
+    it->firstModule = position ;
+    position += it->moduleNumber ;
+    it->moduleNumber = 0 ;
+  }
+  psuModules_.resize (position) ;
+  for (std::vector<unsigned int>::iterator it = psuOfModules.begin() ; it != psuOfModules.end() ; it ++) {
+    TkTopologyPsu &psu = psus_[modules_[*it].psuId] ;
+    psuModules_[psu.firstModule + psu.moduleNumber] = *it ;
+    psu.moduleNumber ++ ;
+  }
+}
+
+/**
+ * \param dcuHardId - DCU hardware id
+ * \return module identifier or TKTOPOLOGY_INVALID
+ */
+unsigned int TkTopologyIndex::findModuleByDcuHardId ( tscType32 dcuHardId ) const {
+
+  Sgi::hash_map<unsigned long, unsigned int>::const_iterator it = dcuHardIdIndex_.find (dcuHardId) ;
+  return (it == dcuHardIdIndex_.end()) ? TKTOPOLOGY_INVALID : it->second ;
+}
+
+/**
+ * \param detId - det id
+ * \return module identifier or TKTOPOLOGY_INVALID
+ */
+unsigned int TkTopologyIndex::findModuleByDetId ( tscType32 detId ) const {
+
+  Sgi::hash_map<unsigned long, unsigned int>::const_iterator it = detIdIndex_.find (detId) ;
+  return (it == detIdIndex_.end()) ? TKTOPOLOGY_INVALID : it->second ;
+}
+
+/**
+ * \param fecCrateId - FEC crate
+ * \param fecKey - FEC, ring, CCU, channel (the address is ignored)
+ * \return module identifier or TKTOPOLOGY_INVALID
+ */
+unsigned int TkTopologyIndex::findModuleByFecKey ( unsigned int fecCrateId, keyType fecKey ) const {
+
+  crateKeyType index = ((crateKeyType)fecCrateId << 32) | getFecRingCcuChannelKey(fecKey) ;
+  Sgi::hash_map<crateKeyType, unsigned int, hashCrateKey>::const_iterator it = fecKeyIndex_.find (index) ;
+  return (it == fecKeyIndex_.end()) ? TKTOPOLOGY_INVALID : it->second ;
+}
+
+/**
+ * \param fedId - FED id
+ * \param fedChannel - FED channel
+ * \return FED channel identifier or TKTOPOLOGY_INVALID
+ */
+unsigned int TkTopologyIndex::findFedChannel ( unsigned int fedId, unsigned int fedChannel ) const {
+
+  Sgi::hash_map<unsigned long, unsigned int>::const_iterator it = fedChannelIndex_.find (TKTOPOLOGY_FEDKEY(fedId,fedChannel)) ;
+  return (it == fedChannelIndex_.end()) ? TKTOPOLOGY_INVALID : it->second ;
+}
+
+/**
+ * \param fedId - FED id
+ * \param fedChannel - FED channel
+ * \return module identifier or TKTOPOLOGY_INVALID
+ */
+unsigned int TkTopologyIndex::findModuleByFedChannel ( unsigned int fedId, unsigned int fedChannel ) const {
+
+  unsigned int fedChannelId = findFedChannel (fedId, fedChannel) ;
+  return (fedChannelId == TKTOPOLOGY_INVALID) ? TKTOPOLOGY_INVALID : fedChannels_[fedChannelId].moduleId ;
+}
+
+/**
+ * \param psuName - complete PSU name (TkDcuPsuMap::getPsuName)
+ * \return PSU identifier or TKTOPOLOGY_INVALID
+ */
+unsigned int TkTopologyIndex::findPsu ( std::string psuName ) const {
+
+  std::map<std::string, unsigned int>::const_iterator it = psuIndex_.find (psuName) ;
+  return (it == psuIndex_.end()) ? TKTOPOLOGY_INVALID : it->second ;
+}
@@ -83,6 +83,7 @@ XMLCommonFec::XMLCommonFec ( const XMLByte* buffer, bool toBeDeleted ) throw (Fe
   domImplementation_(NULL),
   parser_(NULL),
   domCountErrorHandler_(NULL),
+  xmlBuffer_(NULL),
   domDocument_(NULL),
   toBeDeleted_(toBeDeleted)
 {
@@ -677,7 +677,7 @@ void apvAccess::getBlockWriteValues ( apvDescription apvValues, std::list<access
  * \return number of errors
  * \warning if a problem occurs in one channel then 0 is set in the corresponding registers
  */
-unsigned int apvAccess::getApvValuesMultipleFrames ( FecAccess &fecAccess, Sgi::hash_map<keyType, apvAccess *> &apvSet, deviceVector &apvVector,
+unsigned int apvAccess::getApvValuesMultipleFrames ( FecAccess &fecAccess, KeyTypeTable<apvAccess *> &apvSet, deviceVector &apvVector,
 						     std::list<FecExceptionHandler *> &errorList ) 
   throw (FecExceptionHandler) {
 
@@ -690,7 +690,7 @@ unsigned int apvAccess::getApvValuesMultipleFrames ( FecAccess &fecAccess, Sgi::
   // -------------------------------------------------------------------
   // read all the registers
   accessDeviceTypeListMap vAccessesApv ;
-  for ( Sgi::hash_map<keyType, apvAccess *>::iterator itApv = apvSet.begin() ; itApv != apvSet.end() ; itApv ++ ) {
+  for ( KeyTypeTable<apvAccess *>::iterator itApv = apvSet.begin() ; itApv != apvSet.end() ; itApv ++ ) {
 
     accessDeviceType apvErr = { itApv->second->getKey(), RALMODE, MODE_READ, APV25_ERR_REG + APV25_READ, 0, false, 0, 0, 0, NULL} ;
     vAccessesApv[getFecRingKey(itApv->second->getKey())].push_back(apvErr) ;
@@ -452,7 +452,7 @@ bool dcuAccess::getSeuStatus() throw (FecExceptionHandler) {
  * \warning if DCU hard id is not read (hardware problem) then the value 0xFFFFFFFF is set
  * \warning if a problem occurs in one channel then 0 is set in the corresponding channel
  */
-unsigned int dcuAccess::getDcuValuesMultipleFrames ( FecAccess &fecAccess, Sgi::hash_map<keyType, dcuAccess *> &dcuSet, deviceVector &dcuVector,
+unsigned int dcuAccess::getDcuValuesMultipleFrames ( FecAccess &fecAccess, KeyTypeTable<dcuAccess *> &dcuSet, deviceVector &dcuVector,
 						     std::list<FecExceptionHandler *> &errorList, bool dcuHardIdOnly ) 
   throw (FecExceptionHandler) {
 
@@ -469,7 +469,7 @@ unsigned int dcuAccess::getDcuValuesMultipleFrames ( FecAccess &fecAccess, Sgi::
   std::cerr << "DCUDEBUG  Start of Read the DCU hard Id" << std::endl;
 #endif  
   accessDeviceTypeListMap vAccessesDcuHardId ;
-  for ( Sgi::hash_map<keyType, dcuAccess *>::iterator itDcu = dcuSet.begin() ; itDcu != dcuSet.end() ; itDcu ++ ) {
+  for ( KeyTypeTable<dcuAccess *>::iterator itDcu = dcuSet.begin() ; itDcu != dcuSet.end() ; itDcu ++ ) {
 
     // tscType32 chipaddh = accessToFec_->readOffset(accessKey_, CHIPADDH) ;
     accessDeviceType chipaddh = { itDcu->second->getKey(), NORMALMODE, MODE_READ, CHIPADDH, 0, false, 0, 0, 0, NULL} ;
@@ -548,7 +548,7 @@ unsigned int dcuAccess::getDcuValuesMultipleFrames ( FecAccess &fecAccess, Sgi::
     // -------------------------------------------------------------------
     // Set the TREG before reading a channel
     accessDeviceTypeListMap vAccessesTreg ;
-    for ( Sgi::hash_map<keyType, dcuAccess *>::iterator itDcu = dcuSet.begin() ; itDcu != dcuSet.end() ; itDcu ++ ) {
+    for ( KeyTypeTable<dcuAccess *>::iterator itDcu = dcuSet.begin() ; itDcu != dcuSet.end() ; itDcu ++ ) {
     
       if (deviceDescriptionsMap.find(itDcu->second->getKey()) != deviceDescriptionsMap.end()) {
 	// accessToFec_->writeOffset(accessKey_, TREG, 0x10); 
@@ -571,7 +571,7 @@ unsigned int dcuAccess::getDcuValuesMultipleFrames ( FecAccess &fecAccess, Sgi::
       // Start the digitization
       accessDeviceTypeListMap vAccessesDigitisation ;
       
-      for ( Sgi::hash_map<keyType, dcuAccess *>::iterator itDcu = dcuSet.begin() ; itDcu != dcuSet.end() ; itDcu ++ ) {
+      for ( KeyTypeTable<dcuAccess *>::iterator itDcu = dcuSet.begin() ; itDcu != dcuSet.end() ; itDcu ++ ) {
 	if (itDcu->second->getChannelEnabled(channel)) {
 	  
 	  if (deviceDescriptionsMap.find(itDcu->second->getKey()) != deviceDescriptionsMap.end()) {
@@ -592,7 +592,7 @@ unsigned int dcuAccess::getDcuValuesMultipleFrames ( FecAccess &fecAccess, Sgi::
       // -------------------------------------------------------------------
       // Check that the digitisation is finished or not
       accessDeviceTypeListMap vAccessesFinished ;
-      for ( Sgi::hash_map<keyType, dcuAccess *>::iterator itDcu = dcuSet.begin() ; itDcu != dcuSet.end() ; itDcu ++ ) {
+      for ( KeyTypeTable<dcuAccess *>::iterator itDcu = dcuSet.begin() ; itDcu != dcuSet.end() ; itDcu ++ ) {
 	if (itDcu->second->getChannelEnabled(channel)) {
 	  
 	  if (deviceDescriptionsMap.find(itDcu->second->getKey()) != deviceDescriptionsMap.end()) {
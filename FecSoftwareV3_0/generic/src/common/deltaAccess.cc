@@ -433,7 +433,7 @@ void deltaAccess::getBlockWriteValues ( class deltaDescription& deltaValues, acc
  * \return number of errors
  * \warning if a problem occurs in one channel then 0 is set in the corresponding registers
  */
-unsigned int deltaAccess::getDeltaValuesMultipleFrames ( FecAccess &fecAccess, Sgi::hash_map<keyType, deltaAccess *> &deltaSet, deviceVector &deltaVector,
+unsigned int deltaAccess::getDeltaValuesMultipleFrames ( FecAccess &fecAccess, KeyTypeTable<deltaAccess *> &deltaSet, deviceVector &deltaVector,
 							 std::list<FecExceptionHandler *> &errorList ) 
   throw (FecExceptionHandler) {
 
@@ -446,7 +446,7 @@ unsigned int deltaAccess::getDeltaValuesMultipleFrames ( FecAccess &fecAccess, S
   // -------------------------------------------------------------------
   // read all the registers
   accessDeviceTypeListMap vAccessesDelta ;
-  for ( Sgi::hash_map<keyType, deltaAccess *>::iterator itDelta = deltaSet.begin() ; itDelta != deltaSet.end() ; itDelta ++ ) {
+  for ( KeyTypeTable<deltaAccess *>::iterator itDelta = deltaSet.begin() ; itDelta != deltaSet.end() ; itDelta ++ ) {
 
     for(int i = 0 ; i < DELTA_REG_NUM ; i++) { 
       // accessToFec_->read (accessKey_, (reg<<1) | DELTA_READ)
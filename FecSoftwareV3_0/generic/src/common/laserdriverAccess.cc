@@ -241,7 +241,7 @@ void laserdriverAccess::getBlockWriteValues ( laserdriverDescription laserdriver
  * \return number of errors
  * \warning if a problem occurs in one channel then 0 is set in the corresponding registers
  */
-unsigned int laserdriverAccess::getLaserdriverValuesMultipleFrames ( FecAccess &fecAccess, Sgi::hash_map<keyType, laserdriverAccess *> &laserdriverSet, deviceVector &laserdriverVector,
+unsigned int laserdriverAccess::getLaserdriverValuesMultipleFrames ( FecAccess &fecAccess, KeyTypeTable<laserdriverAccess *> &laserdriverSet, deviceVector &laserdriverVector,
 								      std::list<FecExceptionHandler *> &errorList ) throw (FecExceptionHandler) {
 
   // hash_map with the classification of the devices per ring
@@ -253,7 +253,7 @@ unsigned int laserdriverAccess::getLaserdriverValuesMultipleFrames ( FecAccess &
   // -------------------------------------------------------------------
   // read all the registers
   accessDeviceTypeListMap vAccessesLaserdriver ;
-  for ( Sgi::hash_map<keyType, laserdriverAccess *>::iterator itLaserdriver = laserdriverSet.begin() ; itLaserdriver != laserdriverSet.end() ; itLaserdriver ++ ) {
+  for ( KeyTypeTable<laserdriverAccess *>::iterator itLaserdriver = laserdriverSet.begin() ; itLaserdriver != laserdriverSet.end() ; itLaserdriver ++ ) {
 
     accessDeviceType gainR = { itLaserdriver->second->getKey(), NORMALMODE, MODE_READ, GAINSELECTION, 0, false, 0, 0, 0, NULL} ;
     vAccessesLaserdriver[getFecRingKey(itLaserdriver->second->getKey())].push_back(gainR) ;
@@ -124,6 +124,23 @@ void memoryAccess::write ( tscType8 AH, tscType8 AL,
   fecRingDevice_->writeIntoMemory (accessKey_, AH, AL, values, size) ;
 }
 
+/**
+ * Read and write segments of the memory (scatter/gather) with several frames in flight
+ * \param vAccesses - segments of memory, the index is set to the one of this channel
+ * \param maximumTransactions - maximum number of frames waiting for an answer
+ * \exception FecExceptionHandler
+ * \warning the errors are given for each segment (field e), they must be deleted by the caller
+ * \see FecRingDevice::setBlockMemory
+ */
+void memoryAccess::setBlockMemory ( std::list<memoryAccessType> &vAccesses,
+                                    unsigned int maximumTransactions ) {
+
+  for (std::list<memoryAccessType>::iterator it = vAccesses.begin() ; it != vAccesses.end() ; it ++)
+    it->index = accessKey_ ;
+
+  fecRingDevice_->setBlockMemory (vAccesses, maximumTransactions) ;
+}
+
 /** Read modify write a value from the memory specified by the key in single byte
  * \param AH - Position in the high memory
  * \param AL - Position in the low memory
@@ -153,7 +153,7 @@ void muxAccess::getBlockWriteValues ( muxDescription muxValues, std::list<access
  * \return number of errors
  * \warning if a problem occurs in one channel then 0 is set in the corresponding registers
  */
-unsigned int muxAccess::getMuxValuesMultipleFrames ( FecAccess &fecAccess, Sgi::hash_map<keyType, muxAccess *> &muxSet, deviceVector &muxVector,
+unsigned int muxAccess::getMuxValuesMultipleFrames ( FecAccess &fecAccess, KeyTypeTable<muxAccess *> &muxSet, deviceVector &muxVector,
 						     std::list<FecExceptionHandler *> &errorList ) 
   throw (FecExceptionHandler) {
 
@@ -166,7 +166,7 @@ unsigned int muxAccess::getMuxValuesMultipleFrames ( FecAccess &fecAccess, Sgi::
   // -------------------------------------------------------------------
   // read all the registers
   accessDeviceTypeListMap vAccessesMux ;
-  for ( Sgi::hash_map<keyType, muxAccess *>::iterator itMux = muxSet.begin() ; itMux != muxSet.end() ; itMux ++ ) {
+  for ( KeyTypeTable<muxAccess *>::iterator itMux = muxSet.begin() ; itMux != muxSet.end() ; itMux ++ ) {
 
     accessDeviceType muxResistor = { itMux->second->getKey(), RALMODE, MODE_READ, MUX_RES_REG + MUX_READ, 0, false, 0, 0, 0, NULL} ;
     vAccessesMux[getFecRingKey(itMux->second->getKey())].push_back(muxResistor) ;
@@ -152,7 +152,7 @@ void philipsAccess::getBlockWriteValues ( philipsDescription philipsValues, std:
  * \return number of errors
  * \warning if a problem occurs in one channel then 0 is set in the corresponding registers
  */
-unsigned int philipsAccess::getPhilipsValuesMultipleFrames ( FecAccess &fecAccess, Sgi::hash_map<keyType, philipsAccess *> &philipsSet, deviceVector &philipsVector,
+unsigned int philipsAccess::getPhilipsValuesMultipleFrames ( FecAccess &fecAccess, KeyTypeTable<philipsAccess *> &philipsSet, deviceVector &philipsVector,
 							     std::list<FecExceptionHandler *> &errorList ) throw (FecExceptionHandler) {
 
   // hash_map with the classification of the devices per ring
@@ -164,7 +164,7 @@ unsigned int philipsAccess::getPhilipsValuesMultipleFrames ( FecAccess &fecAcces
   // -------------------------------------------------------------------
   // read all the registers
   accessDeviceTypeListMap vAccessesPhilips ;
-  for ( Sgi::hash_map<keyType, philipsAccess *>::iterator itPhilips = philipsSet.begin() ; itPhilips != philipsSet.end() ; itPhilips ++ ) {
+  for ( KeyTypeTable<philipsAccess *>::iterator itPhilips = philipsSet.begin() ; itPhilips != philipsSet.end() ; itPhilips ++ ) {
 
     accessDeviceType philipsResistor = { itPhilips->second->getKey(), RALMODE, MODE_READ, 0, 0, false, 0, 0, 0, NULL} ;
     vAccessesPhilips[getFecRingKey(itPhilips->second->getKey())].push_back(philipsResistor) ;
@@ -743,7 +743,7 @@ bool  pllAccess::getSeuStatus ( ) throw (FecExceptionHandler) {
  * \see pllReset and pllInit
  */
 unsigned int pllAccess::setPllCheckGoingBitMultipleFrames ( FecAccess &fecAccess, std::list<FecExceptionHandler *> &errorList,
-							    Sgi::hash_map<keyType, pllAccess *> &pllSet, bool *errorGoingBit, 
+							    KeyTypeTable<pllAccess *> &pllSet, bool *errorGoingBit, 
 							    std::list<keyType> &pllErrorBefore, std::list<keyType> &pllErrorAfter, 
 							    bool noCheck, bool coldReset ) throw (FecExceptionHandler) {
 
@@ -762,7 +762,7 @@ unsigned int pllAccess::setPllCheckGoingBitMultipleFrames ( FecAccess &fecAccess
     // ----------------------------------------------------------------------------------------------
     // Read the control register 1 of all PLLsInit of the PLL
     accessDeviceTypeListMap vAccessesCtrl1 ;
-    for ( Sgi::hash_map<keyType, pllAccess *>::iterator itPll = pllSet.begin() ; itPll != pllSet.end() ; itPll ++ ) {
+    for ( KeyTypeTable<pllAccess *>::iterator itPll = pllSet.begin() ; itPll != pllSet.end() ; itPll ++ ) {
       if (((pllDescription *)(itPll->second->getDownloadedValues()))->getInit()) {
 	accessDeviceType readCtrl1 = { itPll->second->getKey(), NORMALMODE, MODE_READ, CNTRL_1, 0, false, 0, 0, 0, NULL} ;
 	vAccessesCtrl1[getFecRingKey(itPll->second->getKey())].push_back (readCtrl1) ;
@@ -810,7 +810,7 @@ unsigned int pllAccess::setPllCheckGoingBitMultipleFrames ( FecAccess &fecAccess
   }
   // ------------------------------------------------ reset all PLLs
   else {
-    for ( Sgi::hash_map<keyType, pllAccess *>::iterator itPll = pllSet.begin() ; itPll != pllSet.end() ; itPll ++ ) {
+    for ( KeyTypeTable<pllAccess *>::iterator itPll = pllSet.begin() ; itPll != pllSet.end() ; itPll ++ ) {
       pllToBeReseted.push_back (itPll->second->getKey()) ;
     }
   }
@@ -989,9 +989,9 @@ unsigned int pllAccess::setPllCheckGoingBitMultipleFrames ( FecAccess &fecAccess
  * \param fecAccess - hardware access
  * \param pllSet - set of PLL
  */
-void pllAccess::displayPllRegisters ( FecAccess &fecAccess, Sgi::hash_map<keyType, pllAccess *> &pllSet ) {
+void pllAccess::displayPllRegisters ( FecAccess &fecAccess, KeyTypeTable<pllAccess *> &pllSet ) {
 
-  for ( Sgi::hash_map<keyType, pllAccess *>::iterator itPll = pllSet.begin() ; itPll != pllSet.end() ; itPll ++ ) {
+  for ( KeyTypeTable<pllAccess *>::iterator itPll = pllSet.begin() ; itPll != pllSet.end() ; itPll ++ ) {
 
     try {
       int ctrl1 = itPll->second->getCNTRL1() ;
@@ -1074,7 +1074,7 @@ void pllAccess::getBlockWriteValues ( pllDescription pllValues, accessDeviceType
  * \return number of errors
  * \warning if a problem occurs in one channel then 0 is set in the corresponding registers
  */
-unsigned int pllAccess::getPllValuesMultipleFrames ( FecAccess &fecAccess, Sgi::hash_map<keyType, pllAccess *> &pllSet, deviceVector &pllVector,
+unsigned int pllAccess::getPllValuesMultipleFrames ( FecAccess &fecAccess, KeyTypeTable<pllAccess *> &pllSet, deviceVector &pllVector,
 						      std::list<FecExceptionHandler *> &errorList ) 
   throw (FecExceptionHandler) {
 
@@ -1089,7 +1089,7 @@ unsigned int pllAccess::getPllValuesMultipleFrames ( FecAccess &fecAccess, Sgi::
   accessDeviceTypeListMap vAccessesClockPhase ;
   accessDeviceTypeListMap vAccessesTriggerDelay ; 
 
-  for ( Sgi::hash_map<keyType, pllAccess *>::iterator itPll = pllSet.begin() ; itPll != pllSet.end() ; itPll ++ ) {
+  for ( KeyTypeTable<pllAccess *>::iterator itPll = pllSet.begin() ; itPll != pllSet.end() ; itPll ++ ) {
 
     // Read all CTRL2
     accessDeviceType ctrl2 = { itPll->second->getKey(), NORMALMODE, MODE_READ, CNTRL_2, 0, false, 0, 0, 0, NULL} ;
@@ -0,0 +1,302 @@
+#include "Fed9UVmeDevice.hh"
+#include "Fed9UHalInterface.hh"
+#include "Fed9UDescription.hh"
+#include "Fed9UAddress.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace Fed9U;
+using namespace std;
+
+/**Simulation of the registers of one FED at the level of the items of the HAL address table.
+   The serial commands written to ARGUMENT (or ARGUMENT_BLT) are executed when WRITE is written: the payload of a write
+   command is stored for its FPGA and designator and returned in ARGUMENT by a read command with the same designator.
+   The pedestal and cluster threshold RAMs of the FE FPGAs are addressed with the designator 14 and accessed with the
+   designator 13, the address going up after each access. A command to the broadcast FPGA 15 goes to the eight FE FPGAs.
+   Every word transferred counts as one VME cycle.*/
+class Fed9USimulatedFed : public Fed9UHalItemAccess {
+public:
+  Fed9USimulatedFed() : _cycles(0) {
+    for (u32 i = 0; i < ARGUMENT_WORDS; ++i) _argument[i] = 0;
+  }
+
+  void write(const string &item, u32 data, bool masked, u32 offset) {
+    ++_cycles;
+    if (item == "WRITE") {
+      if (_argumentBlt.size()) {
+	for (u32 i = 0; i < _argumentBlt.size() && _argumentBlt[i]; i += 1 + payloadWords(_argumentBlt[i])) execute(&_argumentBlt[i]);
+	_argumentBlt.clear();
+      } else {
+	execute(&_argument[0]);
+      }
+    } else if (item == "READ") {
+      //A register never written reads as 0.
+      vector<u32> payload(read(data));
+      for (u32 i = 0; i < ARGUMENT_WORDS; ++i) _argument[i] = i < payload.size() ? payload[i] : 0;
+    } else if (item == "ARGUMENT") {
+      if (offset/4 < ARGUMENT_WORDS) _argument[offset/4] = data;
+    } else {
+      _registers[make_pair(item, offset)] = data;
+    }
+  }
+
+  u32 read(const string &item, bool masked, u32 offset) {
+    ++_cycles;
+    //The serial commands are executed at once.
+    if (item == "STATUS_SERIAL") return 1;
+    //The System ACE status register tells that the firmware is loaded, a reload from the compact flash then succeeds.
+    if (item == "SYS_ACE_CONTROL" && offset == SYS_ACE_STATUS) return 0x80;
+    if (item == "ARGUMENT") return offset/4 < ARGUMENT_WORDS ? _argument[offset/4] : 0;
+    map<pair<string, u32>, u32>::const_iterator i(_registers.find(make_pair(item, offset)));
+    return i == _registers.end() ? 0 : i->second;
+  }
+
+  void writeBlock(const string &item, const char *buffer, u32 length, u32 offset) {
+    _cycles += length/4;
+    const u32 *words = reinterpret_cast<const u32 *>(buffer);
+    if (item == "ARGUMENT_BLT") {
+      _argumentBlt.assign(words, words + length/4);
+      _argumentBlt.push_back(0);
+    }
+  }
+
+  void readBlock(const string &item, char *buffer, u32 length, u32 offset) {
+    _cycles += length/4;
+    for (u32 i = 0; i < length; ++i) buffer[i] = 0;
+  }
+
+  unsigned long getCycles() const { return _cycles; }
+
+private:
+  static const u32 ARGUMENT_WORDS = 512;
+  static const u32 BROADCAST_FPGA = 15;
+  static const u32 RAM_ADDRESS = 14;
+  static const u32 RAM_DATA = 13;
+  static const u32 SYS_ACE_STATUS = 0x02<<2;
+
+  static u32 payloadWords(u32 header) { return ((header & 0xffff) + 31)/32; }
+  static u32 key(u32 fpga, u32 designator, u32 address) { return (fpga<<24) | (designator<<16) | address; }
+
+  void execute(const u32 *command) {
+    u32 fpga = (command[0]>>24) & 0x1f, designator = (command[0]>>17) & 0x1f;
+    vector<u32> payload(command + 1, command + 1 + payloadWords(command[0]));
+    for (u32 f = (fpga == BROADCAST_FPGA ? 1 : fpga); f <= (fpga == BROADCAST_FPGA ? 8 : fpga); ++f) {
+      if (designator == RAM_DATA) _payloads[key(f, designator, _ramAddresses[f]++)] = payload;
+      else {
+	if (designator == RAM_ADDRESS) _ramAddresses[f] = payload[0]>>20;
+	_payloads[key(f, designator, 0)] = payload;
+      }
+    }
+  }
+
+  vector<u32> read(u32 header) {
+    u32 fpga = (header>>24) & 0x1f, designator = (header>>17) & 0x1f;
+    if (designator == RAM_DATA) return _payloads[key(fpga, designator, _ramAddresses[fpga]++)];
+    return _payloads[key(fpga, designator, 0)];
+  }
+
+  u32 _argument[ARGUMENT_WORDS];
+  vector<u32> _argumentBlt;
+  map<pair<string, u32>, u32> _registers;
+  map<u32, vector<u32> > _payloads;
+  map<u32, u32> _ramAddresses;
+  unsigned long _cycles;
+};
+
+/**Changes one frame threshold or one pedestal of the description.*/
+static void changeDescription(Fed9UDescription &description, bool threshold) {
+  Fed9UAddress addr;
+  if (threshold) {
+    addr.setFedChannel(rand() % CHANNELS_PER_FED);
+    description.setFrameThreshold(addr, (rand() % 32) * 32);
+  } else {
+    addr.setFedStrip(rand() % STRIPS_PER_FED);
+    description.getFedStrips().getStrip(addr).setPedestal(rand() % 1024);
+  }
+}
+
+/**Runs loads changing one value each and checks that the local settings follow the description.*/
+static int runLoads(Fed9UVmeDevice &device, Fed9UDescription &description, unsigned int loads, const char *name) {
+  for (unsigned int i = 0; i < loads; ++i) {
+    changeDescription(description, i % 2);
+    device.loadDescription(description);
+    if (!(device.getFed9UVMEDeviceDescription() == description)) {
+      cerr << "ERROR: " << name << ": the local settings differ from the description after load " << i << endl;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/**Loads the description once more and tells whether the FED was read back.*/
+static bool readBackOnLoad(Fed9UVmeDevice &device, const Fed9UDescription &description) {
+  u32 readBacks = device.getRegisterShadow().getReadBacks();
+  device.loadDescription(description);
+  return device.getRegisterShadow().getReadBacks() != readBacks;
+}
+
+/**
+ * Runs Fed9UVmeDevice::loadDescription on a simulated FED and counts the VME cycles with and without the register shadow.
+ * It checks that a reset, a firmware reload or a new description forces a read-back and that a frame threshold changed
+ * behind the back of the device is found by the spot checks.
+ * \param -loads <number of loads> -period <loads between full read-backs>
+ */
+int main(int argc, char **argv) {
+
+  unsigned int loads = 100, period = 16;
+  for (int i = 1; i < argc; ++i) {
+    string param(argv[i]);
+    if ((param == "-loads") && (i < argc-1)) {
+      loads = atoi(argv[i+1]);
+      ++i;
+    }
+    else if ((param == "-period") && (i < argc-1)) {
+      period = atoi(argv[i+1]);
+      ++i;
+    }
+    else {
+      cerr << argv[0] << " -loads <number of loads> -period <loads between full read-backs>" << endl;
+      return -1;
+    }
+  }
+
+  int error = 0;
+  try {
+    srand(1);
+    Fed9UDescription description;
+    //Any hardware ID but the crate scan ones, the device then makes no access when it is constructed.
+    description.setFedHardwareId(100);
+    description.setFedId(123);
+    Fed9UAddress addr;
+    for (u32 channel = 0; channel < CHANNELS_PER_FED; ++channel) description.setFrameThreshold(addr.setFedChannel(channel), (rand() % 32) * 32);
+    //The FED stores the cluster thresholds, which are the threshold factors times the noise.
+    for (u32 strip = 0; strip < STRIPS_PER_FED; ++strip) {
+      Fed9UStripDescription &stripDescription = description.getFedStrips().getStrip(addr.setFedStrip(strip));
+      stripDescription.setPedestal(rand() % 1024);
+      stripDescription.setNoise(2.0);
+    }
+
+    //-------------------------------------------------------------------------
+    //Cycles with and without the shadow for the same loads
+    Fed9USimulatedFed fed, referenceFed;
+    Fed9UHalInterface::setItemAccess(0, &fed);
+    Fed9UVmeDevice device(description);
+    Fed9UHalInterface::setItemAccess(0, &referenceFed);
+    Fed9UVmeDevice reference(description);
+    Fed9UHalInterface::setItemAccess(0, NULL);
+    device.getRegisterShadow().setFullCheckPeriod(period);
+    reference.getRegisterShadow().setFullCheckPeriod(0);
+    //The FEDs are configured, then the first load reads them back.
+    device.setFed9UVMEDeviceDescription(description, true);
+    reference.setFed9UVMEDeviceDescription(description, true);
+    device.loadDescription(description);
+    reference.loadDescription(description);
+    unsigned long cycles = fed.getCycles(), referenceCycles = referenceFed.getCycles();
+    u32 readBacks = device.getRegisterShadow().getReadBacks();
+
+    Fed9UDescription referenceDescription(description);
+    unsigned int seed = rand();
+    srand(seed);
+    error += runLoads(device, description, loads, "shadow");
+    srand(seed);
+    error += runLoads(reference, referenceDescription, loads, "read-back");
+    cycles = fed.getCycles() - cycles;
+    referenceCycles = referenceFed.getCycles() - referenceCycles;
+    if (reference.getRegisterShadow().getReadBacksSkipped() != 0) {
+      cerr << "ERROR: the shadow was used with a full check period of 0" << endl;
+      ++error;
+    }
+    //The first load read back the FED, the next one is due after period loads.
+    unsigned int expected = period > 1 ? loads / period : loads;
+    if (device.getRegisterShadow().getReadBacks() - readBacks != expected) {
+      cerr << "ERROR: " << device.getRegisterShadow().getReadBacks() - readBacks << " read-backs instead of " << expected << endl;
+      ++error;
+    }
+    cout << "Read-back on every load: " << referenceCycles << " cycles" << endl;
+    cout << "Shadow registers: " << cycles << " cycles, " << device.getRegisterShadow().getReadBacksSkipped() << " read-backs skipped, "
+	 << referenceCycles - cycles << " cycles saved" << endl;
+    //Most of the cycles left are the writes of the whole FE units and strips done by each load.
+    if (period >= 16 && loads >= 100 && cycles * 2 > referenceCycles) {
+      cerr << "ERROR: the shadow saves less than half of the cycles" << endl;
+      ++error;
+    }
+
+    //-------------------------------------------------------------------------
+    //The resets, the firmware reload and a new description force a read-back
+    //No more full checks, the shadow is trusted after the next load.
+    device.getRegisterShadow().setFullCheckPeriod(0x10000);
+    readBackOnLoad(device, description);
+    if (readBackOnLoad(device, description)) {
+      cerr << "ERROR: the FED was read back with a trusted shadow" << endl;
+      ++error;
+    }
+    device.sendFedReset(false);
+    if (!readBackOnLoad(device, description)) {
+      cerr << "ERROR: no read-back after sendFedReset" << endl;
+      ++error;
+    }
+    device.beFpgaSoftReset();
+    if (!readBackOnLoad(device, description)) {
+      cerr << "ERROR: no read-back after beFpgaSoftReset" << endl;
+      ++error;
+    }
+    device.feFpgaSoftReset(addr.setFedFeUnit(Fed9UAddress::FEBROADCAST));
+    if (!readBackOnLoad(device, description)) {
+      cerr << "ERROR: no read-back after feFpgaSoftReset" << endl;
+      ++error;
+    }
+    device.reloadFpgaFirmwareFromCompactFlash(0);
+    if (!readBackOnLoad(device, description)) {
+      cerr << "ERROR: no read-back after reloadFpgaFirmwareFromCompactFlash" << endl;
+      ++error;
+    }
+    device.resetSystemAce();
+    if (!readBackOnLoad(device, description)) {
+      cerr << "ERROR: no read-back after resetSystemAce" << endl;
+      ++error;
+    }
+    device.setFed9UVMEDeviceDescription(description, false);
+    if (!readBackOnLoad(device, description)) {
+      cerr << "ERROR: no read-back after setFed9UVMEDeviceDescription" << endl;
+      ++error;
+    }
+
+    //-------------------------------------------------------------------------
+    //A frame threshold changed by another device on the same FED is found by the spot checks alone, within one load
+    //per FE unit.
+    u16 threshold = description.getFrameThreshold(addr.setFedChannel(5 * CHANNELS_PER_FEUNIT + 3));
+    Fed9UHalInterface::setItemAccess(0, &fed);
+    Fed9UVmeDevice other(description);
+    Fed9UHalInterface::setItemAccess(0, NULL);
+    other.setFrameThreshold(addr, threshold ^ 32);
+    u32 failures = device.getRegisterShadow().getSpotCheckFailures();
+    unsigned int load = 0;
+    for ( ; load < FEUNITS_PER_FED && device.getRegisterShadow().getSpotCheckFailures() == failures; ++load) {
+      changeDescription(description, false);
+      device.loadDescription(description);
+    }
+    if (device.getRegisterShadow().getSpotCheckFailures() != failures + 1) {
+      cerr << "ERROR: threshold changed on the FED not found after " << load << " loads" << endl;
+      ++error;
+    }
+    //The threshold is written again by the load that read it back.
+    if (device.getFrameThreshold(addr) != threshold) {
+      cerr << "ERROR: the threshold changed on the FED was not restored" << endl;
+      ++error;
+    }
+  }
+  catch (const exception &e) {
+    cerr << "ERROR: " << e.what() << endl;
+    ++error;
+  }
+
+  if (error) cerr << error << " error(s)" << endl;
+  else cout << "All tests passed" << endl;
+
+  return error ? -1 : 0;
+}
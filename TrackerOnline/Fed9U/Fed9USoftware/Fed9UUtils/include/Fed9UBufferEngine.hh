@@ -0,0 +1,162 @@
+#ifndef H_Fed9UBufferEngine
+#define H_Fed9UBufferEngine
+
+#include "TypeDefs.hh"
+
+#include <pthread.h>
+
+#include <iosfwd>
+#include <vector>
+
+namespace Fed9U {
+
+  class Fed9URawBufferWriter;
+  class Fed9USignalModel;
+
+  /**
+   * \brief  Generates synthetic FED events at a high rate in several threads, for the load testing of event consumers.
+   *
+   * The caller gives a set of buffers (slots). Each generation thread takes a free slot, fills the strips of the next
+   * event with the signal model, writes the event into the slot with a Fed9URawBufferWriter and queues the slot. The
+   * consumer takes the slots with pop and gives them back with release. The free and the ready slots are kept in two
+   * bounded lock-free queues, nothing is allocated or locked once the generation is started.
+   *
+   * The random generator of each event is seeded from the seed of the engine and the event number, so the events do not
+   * depend on the number of threads and the strips an event was made from can be generated again with getTruth.
+   * The events are numbered from 1 and can come out of pop in a slightly different order when several threads are used.
+   */
+  class Fed9UBufferEngine {
+  public:
+
+    /**
+     * \brief Constructor. The writer and the model are used by all the threads and must stay valid until the engine is stopped.
+     */
+    Fed9UBufferEngine(const Fed9URawBufferWriter& writer, const Fed9USignalModel& model, u64 seed = 1);
+
+    /**
+     * \brief Destructor. Stops the generation.
+     */
+    ~Fed9UBufferEngine();
+
+    /**
+     * \brief  Size of the events, and the minimum size of the slots, in 32 bit words.
+     */
+    u32 getBufferSize() const;
+
+    /**
+     * \brief  Starts the generation threads.
+     * \param  buffers Memory for the slots, slots * slotWords words aligned on 64 bits. It must not be used by the caller
+     *         until the engine is stopped, except for reading the slots returned by pop.
+     * \param  slots Number of slots, at least one more than the number of threads to keep the consumer busy.
+     * \param  slotWords Size of a slot in 32 bit words, at least getBufferSize() and even.
+     * \param  threads Number of generation threads. If zero the number of online processors is used.
+     * \param  events Number of events to generate, zero to generate until stop is called.
+     * \throw  ICUtils::ICException If the engine is already started, the buffers are not aligned or a thread cannot be created.
+     */
+    void start(u32* buffers, u32 slots, u32 slotWords, u16 threads = 0, u32 events = 0);
+
+    /**
+     * \brief  Takes the next event without waiting.
+     * \param  eventNumber Set to the number of the event.
+     * \return const u32* Event of getBufferSize() words, or NULL if no event is ready.
+     */
+    const u32* tryPop(u32& eventNumber);
+
+    /**
+     * \brief  Takes the next event, waiting for it if needed.
+     * \return const u32* Event, or NULL once all the events have been generated and taken, or the engine is stopped.
+     */
+    const u32* pop(u32& eventNumber);
+
+    /**
+     * \brief Gives back to the engine a slot returned by pop or tryPop, once the consumer has finished with the event.
+     */
+    void release(const u32* event);
+
+    /**
+     * \brief Stops the generation threads and waits for them. The events not taken are discarded.
+     */
+    void stop();
+
+    /**
+     * \brief  Number of events generated since start.
+     */
+    u32 getEventsGenerated() const { return _generated; }
+
+    /**
+     * \brief  Strips an event was generated from.
+     * \param  eventNumber Event number returned by pop.
+     * \param  strips Filled with STRIPS_PER_FED values indexed by the internal FED strip number, in physical order.
+     */
+    void getTruth(u32 eventNumber, u16* strips) const;
+
+    /**
+     * \brief  Self check of an event: decodes it with Fed9UEvent and compares the header, the CRC and the strips with the truth.
+     *
+     * Fed9UEvent only decodes the FULL DEBUG header format, the events with an APV ERROR header are reported as errors.
+     * \param  event Event returned by pop.
+     * \param  eventNumber Event number returned by pop.
+     * \param  report Description of the differences found.
+     * \return bool True if the event is the same as the truth.
+     */
+    bool checkEvent(const u32* event, u32 eventNumber, std::ostream& report) const;
+
+  private:
+
+    /**
+     * \brief Bounded multi-producer multi-consumer queue of slot numbers, with a sequence number per cell (D. Vyukov).
+     */
+    class SlotQueue {
+    public:
+      void init(u32 capacity);
+      bool push(u32 slot, u32 eventNumber);
+      bool pop(u32& slot, u32& eventNumber);
+    private:
+      struct Cell {
+	volatile u32 _sequence;
+	u32 _slot;
+	u32 _eventNumber;
+      };
+      std::vector<Cell> _cells;
+      u32 _mask;
+      volatile u32 _enqueue;
+      char _padding[64];       //!< Keeps the producers and the consumers on different cache lines.
+      volatile u32 _dequeue;
+    };
+
+    /**
+     * \brief Context passed to each generation thread.
+     */
+    struct Worker {
+      Fed9UBufferEngine* _owner;
+      pthread_t _thread;
+    };
+
+    static void* workerThread(void* arg);
+    void generate();
+
+    // Prevent copying, the workers hold a pointer to this object.
+    Fed9UBufferEngine(const Fed9UBufferEngine&);
+    Fed9UBufferEngine& operator=(const Fed9UBufferEngine&);
+
+    const Fed9URawBufferWriter& _writer;
+    const Fed9USignalModel& _model;
+    u64 _seed;
+
+    u32* _buffers;
+    u32 _slots;
+    u32 _slotWords;
+    u32 _events;                 //!< Number of events to generate, zero for no limit.
+    volatile u32 _nextEvent;     //!< Last event number taken by a generation thread.
+    volatile u32 _generated;
+    volatile u32 _running;       //!< Number of generation threads still running.
+    volatile bool _stop;
+
+    SlotQueue _free;
+    SlotQueue _ready;
+    std::vector<Worker> _workers;
+  };
+
+}
+
+#endif // H_Fed9UBufferEngine
@@ -0,0 +1,162 @@
+#ifndef H_Fed9UCfDeployer
+#define H_Fed9UCfDeployer
+
+#include "Fed9UCfImage.hh"
+
+#include <pthread.h>
+
+#include <string>
+#include <vector>
+
+namespace Fed9U {
+
+  /**
+   * \brief  Compact flash card of a FED written by Fed9UCfDeployer.
+   *
+   * Fed9UVmeCfTarget implements it for a Fed9UVmeDevice, a test can implement it with an in memory card.
+   * The methods are called from the deployment thread of the FED and may throw.
+   */
+  class Fed9UCfTarget {
+  public:
+    virtual ~Fed9UCfTarget() {}
+
+    /**
+     * \brief Writes Fed9UCfImage::CLUSTER_BYTES bytes to a cluster of the card.
+     */
+    virtual void writeCluster(u32 cluster, const u8* data) = 0;
+
+    /**
+     * \brief Reads Fed9UCfImage::CLUSTER_BYTES bytes from a cluster of the card.
+     */
+    virtual void readCluster(u32 cluster, u8* data) = 0;
+
+    /**
+     * \brief Reloads the FPGA firmware from a revision of the card.
+     */
+    virtual void reloadFirmware(u32 revision) = 0;
+
+    /**
+     * \brief Firmware versions running on the FED.
+     */
+    virtual Fed9UCfFirmwareVersions getFirmwareVersions() = 0;
+  };
+
+  /**
+   * \brief  Deployment state of one FED. It is kept between calls to Fed9UCfDeployer::deploy so that an interrupted
+   *         deployment resumes from the last cluster that was verified.
+   */
+  struct Fed9UCfDeployStatus {
+    Fed9UCfDeployStatus() : _imageChecksum(0), _clustersDone(0), _rewrites(0), _reloaded(false), _versionsMatch(false) {}
+
+    u32 _imageChecksum;  //!< Checksum of the image that _clustersDone refers to.
+    u32 _clustersDone;   //!< Clusters written and verified, the next deployment starts from this cluster.
+    u32 _rewrites;       //!< Clusters written again after the read back did not match.
+    bool _reloaded;      //!< True if the firmware was reloaded from the card.
+    bool _versionsMatch; //!< True if the firmware versions after the reload are those of the image header.
+    Fed9UCfFirmwareVersions _versions; //!< Firmware versions read after the reload.
+    std::string _error;  //!< Error that stopped the deployment of the FED, empty if none.
+  };
+
+  /**
+   * \brief  Writes a compact flash image to several FEDs at the same time and reloads their firmware.
+   *
+   * Each FED is written in its own thread, one cluster at a time. Each cluster is read back and compared with the
+   * checksum of the image, a cluster that does not match is written again up to getMaxRewrites() times. Once all the
+   * FEDs hold the full image their firmware is reloaded from getRevision(), again one thread per FED, and the versions
+   * read from the FEDs are compared with those in the image header. No FED is reloaded unless all the FEDs hold the
+   * full image, so that a crate is not left running different firmwares.
+   */
+  class Fed9UCfDeployer {
+  public:
+
+    /**
+     * \brief Constructor. The image must stay valid for the life of the deployer.
+     */
+    explicit Fed9UCfDeployer(const Fed9UCfImage& image);
+
+    /**
+     * \brief Adds a FED, it must stay valid for the life of the deployer.
+     */
+    Fed9UCfDeployer& addFed(Fed9UCfTarget& target);
+
+    /**
+     * \brief  Deploys the image to all the FEDs.
+     * \param  status Resized to the number of FEDs. The status of a FED from an earlier call for the same image is used
+     *         to resume its deployment from the last verified cluster. It is updated as the deployment progresses.
+     * \return u32 Number of FEDs whose deployment failed or whose firmware versions after the reload do not match the image.
+     */
+    u32 deploy(std::vector<Fed9UCfDeployStatus>& status);
+
+    /**
+     * \brief Asks the running deployment to stop once the cluster being written to each FED is done. It can be called
+     *        from a signal handler. The next call to deploy clears it.
+     */
+    void stop() { _stopRequested = true; }
+
+    u32 getRevision() const { return _revision; }
+    /**
+     * \brief Revision to reload the firmware from, 0 by default.
+     */
+    Fed9UCfDeployer& setRevision(u32 revision);
+
+    bool getVerify() const { return _verify; }
+    /**
+     * \brief If true, the default, each cluster is read back after it is written.
+     */
+    Fed9UCfDeployer& setVerify(bool verify) { _verify = verify; return *this; }
+
+    u32 getMaxRewrites() const { return _maxRewrites; }
+    Fed9UCfDeployer& setMaxRewrites(u32 rewrites) { _maxRewrites = rewrites; return *this; }
+
+    bool getReload() const { return _reload; }
+    /**
+     * \brief If true, the default, the firmware is reloaded once the image is on all the FEDs.
+     */
+    Fed9UCfDeployer& setReload(bool reload) { _reload = reload; return *this; }
+
+    /**
+     * \brief Clusters written and read back by the last deployment, summed over the FEDs.
+     */
+    u32 getClustersWritten() const { return _clustersWritten; }
+    u32 getClustersRead() const { return _clustersRead; }
+
+  private:
+
+    /**
+     * \brief Context passed to the thread of a FED.
+     */
+    struct FedDeployment {
+      Fed9UCfDeployer* _owner;
+      Fed9UCfTarget* _target;
+      Fed9UCfDeployStatus* _status;
+      pthread_t _thread;
+    };
+
+    static void* writeThread(void* arg);
+    static void* reloadThread(void* arg);
+    void write(FedDeployment& fed);
+    void reload(FedDeployment& fed);
+
+    /**
+     * \brief Runs a thread function for each FED and waits for them, runs it in this thread if a thread cannot be created.
+     */
+    void runAll(void* (*function)(void*));
+
+    // Prevent copying, the threads hold a pointer to this object.
+    Fed9UCfDeployer(const Fed9UCfDeployer&);
+    Fed9UCfDeployer& operator=(const Fed9UCfDeployer&);
+
+    const Fed9UCfImage& _image;
+    std::vector<FedDeployment> _feds;
+    u32 _revision;
+    bool _verify;
+    u32 _maxRewrites;
+    bool _reload;
+    volatile bool _stopRequested;
+    volatile u32 _clustersWritten;
+    volatile u32 _clustersRead;
+  };
+
+}
+
+#endif // H_Fed9UCfDeployer
@@ -0,0 +1,99 @@
+#ifndef H_Fed9UCfImage
+#define H_Fed9UCfImage
+
+#include "TypeDefs.hh"
+
+#include <istream>
+#include <string>
+#include <vector>
+
+namespace Fed9U {
+
+  /**
+   * \brief  Firmware versions of the FPGAs of a FED, as stored for each revision in the header of a compact flash image.
+   */
+  struct Fed9UCfFirmwareVersions {
+    Fed9UCfFirmwareVersions() : _fe(0), _delay(0), _be(0), _vme(0) {}
+
+    u32 _fe;
+    u32 _delay;
+    u32 _be;
+    u32 _vme;
+  };
+
+  /**
+   * \brief  A compact flash (.ace) image, parsed and checked once so that it can be written to several FEDs.
+   *
+   * The file has the layout written by Fed9UVmeDevice::getCfImageFile: a header of firmware versions up to the line
+   * "END OF FILE HEADER", the compact flash data, and the line "END OF FILE". The data are split in clusters of 256 sectors
+   * of 512 bytes, the unit in which the System ACE writes the card, the last cluster is padded with zeros. A CRC-32 is
+   * computed for each cluster so that the clusters read back from a card can be checked.
+   */
+  class Fed9UCfImage {
+  public:
+    static const u32 SECTOR_BYTES = 512;
+    static const u32 SECTORS_PER_CLUSTER = 256;
+    static const u32 CLUSTER_BYTES = SECTOR_BYTES * SECTORS_PER_CLUSTER;
+    //Clusters on a 64MB card.
+    static const u32 MAX_CLUSTERS = 488;
+
+    /**
+     * \brief  Reads the image from an .ace file.
+     * \throw  ICUtils::ICException If the file cannot be read or is not a complete .ace file.
+     */
+    explicit Fed9UCfImage(const std::string& fileName);
+
+    /**
+     * \brief  Reads the image from a stream opened in binary mode.
+     * \throw  ICUtils::ICException If the stream does not hold a complete .ace file.
+     */
+    explicit Fed9UCfImage(std::istream& is);
+
+    /**
+     * \brief  The file header, as returned by Fed9UVmeDevice::setCfImageFile.
+     */
+    const std::string& getFirmwareInfo() const { return _firmwareInfo; }
+
+    /**
+     * \brief  The firmware versions stored in a revision, false if the header does not list the revision.
+     */
+    bool getFirmwareVersions(u32 revision, Fed9UCfFirmwareVersions& versions) const;
+
+    /**
+     * \brief  Number of bytes of compact flash data, before padding.
+     */
+    u32 getDataSize() const { return _dataSize; }
+
+    u32 getClusterCount() const { return _checksums.size(); }
+
+    /**
+     * \brief  Returns the CLUSTER_BYTES bytes of a cluster.
+     */
+    const u8* getCluster(u32 cluster) const { return &_data[cluster * CLUSTER_BYTES]; }
+
+    u32 getClusterChecksum(u32 cluster) const { return _checksums[cluster]; }
+
+    /**
+     * \brief  CRC-32 of all the clusters, identifies the image.
+     */
+    u32 getChecksum() const { return _checksum; }
+
+    /**
+     * \brief  CRC-32 of a block of data, as used for the cluster checksums.
+     */
+    static u32 checksum(const u8* data, u32 bytes, u32 crc = 0);
+
+  private:
+    void parse(std::istream& is);
+
+    std::string _firmwareInfo;
+    std::vector<std::pair<u32, Fed9UCfFirmwareVersions> > _revisions;
+    std::vector<u8> _data;
+    u32 _dataSize;
+    std::vector<u32> _checksums;
+    u32 _checksum;
+  };
+
+}
+
+#endif // H_Fed9UCfImage
@@ -0,0 +1,104 @@
+#ifndef H_Fed9UConfigVerifier
+#define H_Fed9UConfigVerifier
+
+#include "TypeDefs.hh"
+#include "Fed9UAddress.hh"
+
+#include <iosfwd>
+#include <vector>
+
+namespace Fed9U {
+
+  class Fed9UDescription;
+
+  /**
+   * \brief  A setting read back from a FED that differs from its description.
+   */
+  struct Fed9UConfigMismatch {
+
+    /**
+     * \brief Settings compared by Fed9UConfigVerifier. The comment gives the part of _address that is set.
+     */
+    enum Field {
+      TRIGGER_SOURCE,             //!< FED
+      TEST_REGISTER,              //!< FED
+      READ_ROUTE,                 //!< FED
+      HEADER_FORMAT,              //!< FED
+      BE_FPGA_DISABLE,            //!< FED
+      FED_ID,                     //!< FED
+      FE_UNIT_DISABLE,            //!< FE unit
+      SCOPE_LENGTH,               //!< FED
+      OPTO_RX_INPUT_OFFSET,       //!< FE unit
+      OPTO_RX_OUTPUT_OFFSET,      //!< FE unit
+      OPTO_RX_CAPACITOR,          //!< FE unit
+      CM_MEDIAN_OVERRIDE_DISABLE, //!< FE unit
+      CM_MEDIAN_OVERRIDE,         //!< FE unit and APV in the FE unit
+      FRAME_THRESHOLD,            //!< FED channel
+      ADC_DFSEN,                  //!< FED channel
+      ADC_DFSVAL,                 //!< FED channel
+      ADC_S1,                     //!< FED channel
+      ADC_S2,                     //!< FED channel
+      APV_DISABLE,                //!< FED channel and APV
+      PEDESTAL,                   //!< FED channel, APV and strip
+      STRIP_DISABLE,              //!< FED channel, APV and strip
+      HIGH_THRESHOLD,             //!< FED channel, APV and strip
+      LOW_THRESHOLD,              //!< FED channel, APV and strip
+      FIELDS
+    };
+
+    Fed9UConfigMismatch(Field field, const Fed9UAddress& address, u32 expected, u32 actual) :
+      _field(field), _address(address), _expected(expected), _actual(actual) {}
+
+    Field _field;
+    Fed9UAddress _address;
+    u32 _expected;    //!< Value in the description.
+    u32 _actual;      //!< Value read from the FED.
+  };
+
+  /**
+   * \brief  Compares the settings read back from a FED with its description, setting by setting.
+   *
+   * The settings are compared as the FED stores them, for instance the frame thresholds in steps of 32. The list of
+   * differences can be printed in the text form of Fed9UVmeDevice::frontEndCheck, or used to correct the settings found.
+   */
+  class Fed9UConfigVerifier {
+  public:
+
+    /**
+     * \brief Groups of settings to compare.
+     */
+    enum Section {
+      BACK_END = 0x1,            //!< BE FPGA registers and FE unit enables.
+      CM_MEDIAN_OVERRIDE = 0x2,  //!< Common mode median overrides.
+      FRONT_END = 0x4,           //!< Scope length, OptoRx, frame thresholds, ADC controls and APV disables.
+      STRIPS = 0x8,              //!< Pedestals, disabled strips and cluster thresholds.
+      ALL = 0xF
+    };
+
+    /**
+     * \brief  Compares two descriptions.
+     * \param  expected Description loaded in the FED.
+     * \param  actual Settings read back from the FED.
+     * \param  sections Section bits to compare.
+     * \param  adcsOn False if the FED is stopped: its ADCs are then off and the ADC controls and the APV disables are not compared.
+     *         The ADC controls of the channel pairs with all their APVs disabled are never compared.
+     * \param  mismatches The differences are added at the end.
+     * \return u32 Number of differences found.
+     */
+    static u32 compare(const Fed9UDescription& expected, const Fed9UDescription& actual, u32 sections, bool adcsOn,
+		       std::vector<Fed9UConfigMismatch>& mismatches);
+
+    /**
+     * \brief  Name of a setting, as used by print.
+     */
+    static const char* getFieldName(Fed9UConfigMismatch::Field field);
+
+    /**
+     * \brief Writes one line per difference, with the external numbering of the FE units, channels, APVs and strips.
+     */
+    static void print(std::ostream& os, const std::vector<Fed9UConfigMismatch>& mismatches);
+  };
+
+}
+
+#endif // H_Fed9UConfigVerifier
@@ -0,0 +1,184 @@
+#ifndef H_Fed9UDelayScanEngine
+#define H_Fed9UDelayScanEngine
+
+#include "TypeDefs.hh"
+
+#include <pthread.h>
+
+#include <string>
+#include <vector>
+
+namespace Fed9U {
+
+  /**
+   * \brief  FED whose channel delays are scanned by Fed9UDelayScanEngine.
+   *
+   * Fed9UVmeDelayScanTarget implements it for a Fed9UVmeDevice, a test can implement it with a synthetic response.
+   */
+  class Fed9UDelayScanTarget {
+  public:
+    virtual ~Fed9UDelayScanTarget() {}
+
+    /**
+     * \brief Programs a delay on each of the channels.
+     * \param fedChannels Internal FED channel numbers.
+     * \param nanoDelays Delay of each channel in nano seconds, range 0-399.
+     */
+    virtual void setDelays(const std::vector<u16>& fedChannels, const std::vector<u16>& nanoDelays) = 0;
+
+    /**
+     * \brief Waits for the delays to settle, calls fed9Uwait.
+     */
+    virtual void wait(u32 microseconds);
+  };
+
+  /**
+   * \brief  Measurement taken by Fed9UDelayScanEngine at each step, for instance the height of the tick mark in scope
+   *         mode or a spy channel sample.
+   *
+   * The value must rise when the sampling point moves onto the tick mark. measure is called from the scan thread of each
+   * FED, concurrently for different FEDs.
+   */
+  class Fed9UDelayScanProbe {
+  public:
+    virtual ~Fed9UDelayScanProbe() {}
+
+    /**
+     * \brief Measures the channels of a FED.
+     * \param fed Index of the FED in the engine, in the order of addFed.
+     * \param fedChannels Internal FED channel numbers.
+     * \param values Resized by the caller to the number of channels, filled with one value per channel.
+     */
+    virtual void measure(u32 fed, const std::vector<u16>& fedChannels, std::vector<float>& values) = 0;
+  };
+
+  /**
+   * \brief  Result of a delay scan for one channel.
+   */
+  struct Fed9UDelayScanResult {
+    Fed9UDelayScanResult() : _fedChannel(0), _found(false), _edge(0), _optimalDelay(0), _baseline(0), _peak(0) {}
+
+    u16 _fedChannel;     //!< Internal FED channel number.
+    bool _found;         //!< False if no rising edge was found, the other values are then not valid.
+    u16 _edge;           //!< First delay in nano seconds at which the measurement is above the mid point of the baseline and the peak.
+    u16 _optimalDelay;   //!< Delay to program in nano seconds, the edge plus the sampling point.
+    float _baseline;     //!< Lowest value measured in the coarse pass.
+    float _peak;         //!< Highest value measured in the coarse pass.
+  };
+
+  /**
+   * \brief  Finds the delay of each channel of several FEDs from the rising edge of the tick mark.
+   *
+   * All the scanned channels of a FED are stepped together: the coarse pass programs the same delay on all of them every
+   * getCoarseStep() nano seconds over the 0-399 ns range and at 399 ns, then each channel bisects its own edge to the nano second, the
+   * channels still being programmed and measured together. Each FED is scanned in its own thread.
+   *
+   * After programming a step the engine waits getSettleMin(), measures, and measures again after waiting twice as long
+   * each time until two measurements agree within getSettleTolerance() on all channels, or getSettleMax() has been waited.
+   */
+  class Fed9UDelayScanEngine {
+  public:
+
+    /**
+     * \brief Constructor. The probe must stay valid for the life of the engine.
+     */
+    explicit Fed9UDelayScanEngine(Fed9UDelayScanProbe& probe);
+
+    /**
+     * \brief Adds a FED to scan.
+     * \param target FED, it must stay valid for the life of the engine.
+     * \param fedChannels Internal FED channel numbers to scan, all the channels if empty.
+     */
+    Fed9UDelayScanEngine& addFed(Fed9UDelayScanTarget& target, const std::vector<u16>& fedChannels = std::vector<u16>());
+
+    /**
+     * \brief  Scans all the FEDs, one thread per FED.
+     * \param  results Resized to the number of FEDs, element i holds one result per scanned channel of FED i.
+     * \param  errors Resized to the number of FEDs, element i holds the error that stopped the scan of FED i or is empty.
+     * \return u32 Number of FEDs with an error or a channel without an edge.
+     */
+    u32 scan(std::vector<std::vector<Fed9UDelayScanResult> >& results, std::vector<std::string>& errors);
+
+    u16 getCoarseStep() const { return _coarseStep; }
+    Fed9UDelayScanEngine& setCoarseStep(u16 nanoSeconds);
+
+    u16 getSamplingPoint() const { return _samplingPoint; }
+    /**
+     * \brief Position of the sampling point after the rising edge, 15 ns by default. The optimal delay is moved back by
+     *        whole 25 ns clock cycles if it is outside the 0-399 ns range.
+     */
+    Fed9UDelayScanEngine& setSamplingPoint(u16 nanoSeconds) { _samplingPoint = nanoSeconds; return *this; }
+
+    u32 getSettleMin() const { return _settleMin; }
+    u32 getSettleMax() const { return _settleMax; }
+    float getSettleTolerance() const { return _settleTolerance; }
+    /**
+     * \brief Adaptive settle time. The defaults are 1 ms, 500 ms (the fixed wait of Fed9UVmeDevice::scanDelayValues) and 2.
+     */
+    Fed9UDelayScanEngine& setSettle(u32 minMicroseconds, u32 maxMicroseconds, float tolerance);
+
+    float getMinimumHeight() const { return _minimumHeight; }
+    /**
+     * \brief Smallest difference between the peak and the baseline for an edge to be searched, 50 by default.
+     */
+    Fed9UDelayScanEngine& setMinimumHeight(float height) { _minimumHeight = height; return *this; }
+
+    bool getApplyOptimal() const { return _applyOptimal; }
+    /**
+     * \brief If true, the default, the optimal delays of the channels with an edge are programmed at the end of the scan.
+     */
+    Fed9UDelayScanEngine& setApplyOptimal(bool apply) { _applyOptimal = apply; return *this; }
+
+    /**
+     * \brief  Statistics of the last scan, summed over the FEDs: steps programmed, measurements and time waited.
+     */
+    u32 getSteps() const { return _steps; }
+    u32 getMeasurements() const { return _measurements; }
+    u64 getWaitTime() const { return _waitTime; }
+
+  private:
+
+    /**
+     * \brief Context passed to the scan thread of a FED.
+     */
+    struct FedScan {
+      Fed9UDelayScanEngine* _owner;
+      u32 _fed;
+      Fed9UDelayScanTarget* _target;
+      std::vector<u16> _fedChannels;
+      std::vector<Fed9UDelayScanResult>* _results;
+      std::string* _error;
+      pthread_t _thread;
+    };
+
+    static void* scanThread(void* arg);
+    void scanFed(FedScan& fedScan);
+
+    /**
+     * \brief Programs the delays and measures the channels once they have settled.
+     */
+    void step(FedScan& fedScan, const std::vector<u16>& fedChannels, const std::vector<u16>& nanoDelays, std::vector<float>& values);
+
+    // Prevent copying, the threads hold a pointer to this object.
+    Fed9UDelayScanEngine(const Fed9UDelayScanEngine&);
+    Fed9UDelayScanEngine& operator=(const Fed9UDelayScanEngine&);
+
+    Fed9UDelayScanProbe& _probe;
+    std::vector<FedScan> _feds;
+
+    u16 _coarseStep;
+    u16 _samplingPoint;
+    u32 _settleMin;
+    u32 _settleMax;
+    float _settleTolerance;
+    float _minimumHeight;
+    bool _applyOptimal;
+
+    volatile u32 _steps;
+    volatile u32 _measurements;
+    volatile u64 _waitTime;
+  };
+
+}
+
+#endif // H_Fed9UDelayScanEngine
@@ -817,6 +817,8 @@ namespace Fed9U {
     u16 _bxOffset;
     // <NAC date="24/04/2007">
     friend bool operator == (const Fed9UDescription& l, const Fed9UDescription& r);
+    // The binary streamer needs direct access to the fixed size character arrays.
+    friend class Fed9UDescriptionBinary;
   };
   
   // <NAC date="24/04/2007"> Operator to compare descriptions
@@ -0,0 +1,167 @@
+#ifndef H_Fed9UDescriptionBinary
+#define H_Fed9UDescriptionBinary
+
+#include "TypeDefs.hh"
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// This version number must be incremented whenever a change is made to the
+// layout of a section in the binary description format. Sections can be added
+// without changing it, older readers skip section identifiers they do not know.
+#define FED9U_BINARY_DESCRIPTION_VERSION 1
+#define FED9U_BINARY_DESCRIPTION_MAGIC   0x46394244 //!< "F9BD" when read as a little endian word.
+
+namespace Fed9U {
+
+  class Fed9UDescription;
+  class Fed9UFrontEndDescription;
+  class Fed9UStripDescription;
+
+  /**
+   * \brief  Appends little endian encoded values to a byte buffer.
+   *
+   * All multibyte values are written least significant byte first, independent of the host byte order.
+   * Floats are written as their IEEE 754 bit pattern.
+   */
+  class Fed9UBinaryWriter {
+  public:
+    explicit Fed9UBinaryWriter(std::vector<u8>& buffer) : _buffer(buffer) {}
+
+    Fed9UBinaryWriter& putU8(u8 value) { _buffer.push_back(value); return *this; }
+    Fed9UBinaryWriter& putBool(bool value) { _buffer.push_back(value ? 1 : 0); return *this; }
+    Fed9UBinaryWriter& putU16(u16 value);
+    Fed9UBinaryWriter& putU32(u32 value);
+    Fed9UBinaryWriter& putFloat(float value);
+    Fed9UBinaryWriter& putString(const std::string& value);
+    Fed9UBinaryWriter& putBytes(const u8* data, u32 size);
+
+    /**
+     * \brief  Overwrites a previously reserved 32 bit word, used to back fill section lengths.
+     * \param  offset Byte offset in the buffer of the word.
+     * \param  value Value to write.
+     */
+    void patchU32(u32 offset, u32 value);
+
+    u32 size() const { return static_cast<u32>(_buffer.size()); }
+
+  private:
+    std::vector<u8>& _buffer;
+  };
+
+  /**
+   * \brief  Reads little endian values written by Fed9UBinaryWriter.
+   *
+   * Every access is range checked and a Fed9UDescriptionException with code ERROR_BINARY_FORMAT is
+   * thrown if the buffer is too short.
+   */
+  class Fed9UBinaryReader {
+  public:
+    Fed9UBinaryReader(const u8* buffer, u32 size) : _buffer(buffer), _size(size), _pos(0) {}
+
+    u8 getU8();
+    bool getBool() { return getU8() != 0; }
+    u16 getU16();
+    u32 getU32();
+    float getFloat();
+    std::string getString();
+    void getBytes(u8* data, u32 size);
+    void skip(u32 size);
+
+    u32 position() const { return _pos; }
+    u32 remaining() const { return _size - _pos; }
+    const u8* current() const { return _buffer + _pos; }
+
+  private:
+    void require(u32 size) const;
+
+    const u8* _buffer;
+    u32 _size;
+    u32 _pos;
+  };
+
+  /**
+   * \brief  Schema versioned, endian defined binary encoding of a complete Fed9UDescription.
+   *
+   * The ASCII streamers in Fed9UDescription copy the object almost field by field and break
+   * whenever the layout of any member changes, while the XML path is large and slow to parse.
+   * This encoding is a header (magic, schema version, payload length, checksum) followed by
+   * a list of tagged, length prefixed sections. The strip table is stored with a run length
+   * flag for the threshold factors, which are usually identical from strip to strip.
+   *
+   * Decoding is done into an existing description so that fields which are not part of the
+   * encoding (there are none in version 1) keep their values.
+   */
+  class Fed9UDescriptionBinary {
+  public:
+
+    /**
+     * \brief Section identifiers. Values must never be reused.
+     */
+    enum Section { SECTION_GLOBAL = 1, SECTION_TEMP_CONTROL = 2, SECTION_TTCRX = 3, SECTION_VOLTAGE_CONTROL = 4,
+		   SECTION_FRONT_END = 5, SECTION_STRIPS = 6, SECTION_EPROM = 7 };
+
+    /**
+     * \brief Masks used to select which sections are written by encode.
+     */
+    enum SectionMask { MASK_GLOBAL = 1 << SECTION_GLOBAL, MASK_TEMP_CONTROL = 1 << SECTION_TEMP_CONTROL,
+		       MASK_TTCRX = 1 << SECTION_TTCRX, MASK_VOLTAGE_CONTROL = 1 << SECTION_VOLTAGE_CONTROL,
+		       MASK_FRONT_END = 1 << SECTION_FRONT_END, MASK_STRIPS = 1 << SECTION_STRIPS, MASK_EPROM = 1 << SECTION_EPROM,
+		       MASK_SETTINGS = MASK_GLOBAL | MASK_TEMP_CONTROL | MASK_TTCRX | MASK_VOLTAGE_CONTROL | MASK_EPROM,
+		       MASK_ALL = MASK_SETTINGS | MASK_FRONT_END | MASK_STRIPS };
+
+    /**
+     * \brief  Encodes the description, replacing the contents of the buffer.
+     * \param  description Description to encode.
+     * \param  buffer Filled with the binary representation.
+     * \param  sections Bit mask of the sections to write. A partial encoding only updates those sections when decoded.
+     */
+    static void encode(const Fed9UDescription& description, std::vector<u8>& buffer, u32 sections = MASK_ALL);
+
+    /**
+     * \brief  Decodes a buffer created by encode.
+     * \param  buffer Start of the binary representation.
+     * \param  size Number of bytes available in the buffer.
+     * \param  description Description that is updated from the buffer.
+     * \return u32 Number of bytes consumed, allows several descriptions to be concatenated.
+     * \throw  Fed9UDescriptionException If the buffer is corrupt, truncated or of an unsupported version.
+     */
+    static u32 decode(const u8* buffer, u32 size, Fed9UDescription& description);
+
+    /**
+     * \brief Writes the binary representation to a stream. The stream should be opened in binary mode.
+     */
+    static void saveDescription(const Fed9UDescription& description, std::ostream& os);
+
+    /**
+     * \brief Reads one binary description from a stream written by saveDescription.
+     */
+    static void loadDescription(std::istream& is, Fed9UDescription& description);
+
+    /**
+     * \name Element encoders, shared with Fed9UDescriptionDiff.
+     */
+    //@{
+    static void encodeFrontEnd(const Fed9UFrontEndDescription& fe, Fed9UBinaryWriter& writer);
+    static void decodeFrontEnd(Fed9UBinaryReader& reader, Fed9UFrontEndDescription& fe);
+    static void encodeStrip(const Fed9UStripDescription& strip, Fed9UBinaryWriter& writer);
+    static Fed9UStripDescription decodeStrip(Fed9UBinaryReader& reader);
+    //@}
+
+    /**
+     * \brief  32 bit FNV-1a hash used as the payload checksum.
+     */
+    static u32 checksum(const u8* data, u32 size);
+
+  private:
+    static void encodeGlobal(const Fed9UDescription& description, Fed9UBinaryWriter& writer);
+    static void decodeGlobal(Fed9UBinaryReader& reader, Fed9UDescription& description);
+    static void encodeStrips(const Fed9UDescription& description, Fed9UBinaryWriter& writer);
+    static void decodeStrips(Fed9UBinaryReader& reader, Fed9UDescription& description);
+
+  };
+
+}
+
+#endif // H_Fed9UDescriptionBinary
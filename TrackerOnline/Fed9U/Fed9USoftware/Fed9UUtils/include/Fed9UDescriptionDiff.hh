@@ -0,0 +1,116 @@
+#ifndef H_Fed9UDescriptionDiff
+#define H_Fed9UDescriptionDiff
+
+#include "Fed9UFrontEndDescription.hh"
+#include "Fed9UStripDescription.hh"
+#include "Fed9UAddress.hh"
+#include "TypeDefs.hh"
+
+#include <iosfwd>
+#include <utility>
+#include <vector>
+
+#define FED9U_BINARY_DIFF_MAGIC 0x46394444 //!< "F9DD" when read as a little endian word.
+
+namespace Fed9U {
+
+  class Fed9UDescription;
+
+  /**
+   * \brief  Structural difference between two versions of a Fed9UDescription.
+   *
+   * The difference is recorded at the granularity at which the FED is configured: the FED wide
+   * settings (including TTCrx, voltage monitor, temperature controls and EPROM), FE unit settings,
+   * channel settings, APV settings and strip settings. Channel pair settings (ADC controls and the
+   * fake event random seed and mask) mark both channels of the pair as changed.
+   *
+   * The diff only holds the new values of the items that changed and can be applied as a patch
+   * to any description, in which case only those items are modified. It can be stored using the
+   * same little endian encoding as Fed9UDescriptionBinary.
+   */
+  class Fed9UDescriptionDiff {
+  public:
+
+    /**
+     * \brief Creates an empty diff.
+     */
+    Fed9UDescriptionDiff();
+
+    /**
+     * \brief Creates the diff that transforms from into to.
+     */
+    Fed9UDescriptionDiff(const Fed9UDescription& from, const Fed9UDescription& to);
+
+    /**
+     * \brief Replaces the contents with the diff that transforms from into to.
+     */
+    void compare(const Fed9UDescription& from, const Fed9UDescription& to);
+
+    /**
+     * \brief  True if the two descriptions compared were identical.
+     */
+    bool empty() const;
+
+    /**
+     * \brief  True if any FED wide setting changed.
+     */
+    bool getGlobalChanged() const { return !_settings.empty(); }
+
+    /**
+     * \name Changed items.
+     *
+     * The addresses returned use the internal numbering.
+     */
+    //@{
+    std::vector<Fed9UAddress> getChangedFeUnits() const;
+    std::vector<Fed9UAddress> getChangedChannels() const;
+    std::vector<Fed9UAddress> getChangedApvs() const;
+    std::vector<Fed9UAddress> getChangedStrips() const;
+    //@}
+
+    /**
+     * \brief  Applies the new values held in the diff to a description.
+     * \param  description Description to patch, normally one equal to the from description.
+     */
+    void apply(Fed9UDescription& description) const;
+
+    /**
+     * \brief Encodes the diff, replacing the contents of the buffer.
+     */
+    void encode(std::vector<u8>& buffer) const;
+
+    /**
+     * \brief  Decodes a diff written by encode.
+     * \return u32 Number of bytes consumed.
+     */
+    u32 decode(const u8* buffer, u32 size);
+
+    /**
+     * \brief Writes a human readable summary of the changed items.
+     */
+    void printSummary(std::ostream& os) const;
+
+  private:
+
+    /**
+     * \brief Holds the new settings of a FE unit along with masks of which parts of it changed.
+     */
+    struct FeUnitChange {
+      u16 _feUnit;
+      bool _unitChanged;   //!< FE unit wide settings, such as OptoRx and disable flags, changed.
+      u16 _channelMask;    //!< Bit per FE unit channel.
+      u32 _apvMask;        //!< Bit per FE unit APV.
+      Fed9UFrontEndDescription _to;
+    };
+
+    std::vector<u8> _settings;                                        //!< Partial binary description holding the FED wide settings, empty if unchanged.
+    std::vector<FeUnitChange> _feUnits;
+    std::vector<std::pair<u16, Fed9UStripDescription> > _strips;     //!< Pairs of FED strip number and new strip settings.
+
+  };
+
+  std::ostream& operator<<(std::ostream& os, const Fed9UDescriptionDiff& diff);
+
+}
+
+#endif // H_Fed9UDescriptionDiff
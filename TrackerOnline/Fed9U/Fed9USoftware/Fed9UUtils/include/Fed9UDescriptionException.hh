@@ -11,6 +11,8 @@ namespace Fed9U {
 
 #define FED9U_DESCRIPTION_EXCEPTION_CODES_LIST \
   IC_DEF_ERROR(ERROR_NO_ADDRESS_TABLE, "ERROR: The Address table was not found.")  \
+  IC_DEF_ERROR(ERROR_BINARY_FORMAT, "ERROR: The binary description buffer is corrupt or truncated.")  \
+  IC_DEF_ERROR(ERROR_BINARY_VERSION, "ERROR: The binary description schema version is not supported.")  \
 
 
   IC_EXCEPTION_CLASS_BEGIN(Fed9UDescriptionException, FED9U_DESCRIPTION_EXCEPTION_CODES_LIST)
@@ -0,0 +1,183 @@
+#ifndef H_Fed9UEventIntegrity
+#define H_Fed9UEventIntegrity
+
+#include "TypeDefs.hh"
+
+#include <cstddef>
+
+namespace Fed9U {
+
+  class Fed9UDescription;
+
+  /**
+   * \brief  Every violation found in one FED event by Fed9UEventIntegrityChecker.
+   *
+   * The FE units and channels are numbered as in the event header: position f = 0 is FE-FPGA 8, the first one in the
+   * header, and channel c is the channel c + 1 given to Fed9UEventUnitStreamLine::getChannelStatus. The FE unit masks
+   * have one bit per position, the channel masks one bit per FED channel at bit f * 12 + c. The methods take the
+   * FE-FPGA number (1 - 8) and the channel number (1 - 12), as in Fed9UEventStreamLine.
+   */
+  struct Fed9UEventIntegrity {
+
+    /**
+     * \brief Event level violations.
+     */
+    enum {
+      ERROR_TRUNCATED = 0x01,   //!< The buffer ends before the DAQ trailer, the checks after this point were not done.
+      ERROR_HEADER = 0x02,      //!< Header format unknown, nothing else was checked.
+      ERROR_EVENT_TYPE = 0x04,  //!< Tracker event type unknown.
+      ERROR_TRAILER = 0x08,     //!< No DAQ trailer marker after the payload.
+      ERROR_LENGTH = 0x10,      //!< Length in the DAQ trailer differs from the length of the event.
+      ERROR_CRC = 0x20,         //!< CRC in the DAQ trailer differs from the CRC calculated.
+      ERROR_FE_UNIT = 0x40,     //!< At least one of the FE unit masks is set.
+      ERROR_CHANNEL = 0x80      //!< At least one of the channel masks is set.
+    };
+
+    /**
+     * \brief Violations of the FE units.
+     */
+    enum FeViolation {
+      FE_MISSING,       //!< FE unit enabled in the description but not in the event.
+      FE_OVERFLOW,      //!< FE overflow register.
+      FE_LENGTH,        //!< Length in the FULL DEBUG header differs from the length of the channels in the payload.
+      APV_ADDRESS,      //!< APV address error register: pipeline address differs from the APV emulator.
+      FE_VIOLATIONS
+    };
+
+    /**
+     * \brief Violations of the channels.
+     */
+    enum ChannelViolation {
+      UNLOCKED,         //!< Lock failed.
+      OUT_OF_SYNC,      //!< Out of synch.
+      APV_ERROR,        //!< APV error bit of one of the APVs. In APV ERROR mode all the channel errors are reported here.
+      APV_HEADER,       //!< Wrong header of one of the APVs.
+      CHANNEL_VIOLATIONS
+    };
+
+    u32 _errors;                          //!< ERROR_* bits.
+    u8 _feUnits[FE_VIOLATIONS];           //!< FE unit masks.
+    u64 _channels[CHANNEL_VIOLATIONS][2]; //!< Channel masks.
+
+    Fed9UEventIntegrity() { clear(); }
+
+    void clear();
+
+    bool isOk() const { return _errors == 0; }
+
+    bool getFeUnitError(FeViolation violation, u32 feUnit) const {
+      return (_feUnits[violation] >> (FEUNITS_PER_FED - feUnit)) & 0x1;
+    }
+
+    bool getChannelError(ChannelViolation violation, u32 feUnit, u32 channel) const {
+      u32 bit = (FEUNITS_PER_FED - feUnit) * CHANNELS_PER_FEUNIT + channel - 1;
+      return (_channels[violation][bit / 64] >> (bit % 64)) & 0x1;
+    }
+  };
+
+  /**
+   * \brief  Non-throwing check of the integrity of FED events.
+   *
+   * The checks of Fed9UEventStreamLine::checkEvent and checkChannelStatuses are done in one pass on the buffer, without
+   * exceptions and without stopping at the first problem: DAQ length and CRC, event type, FE overflow, APV address error,
+   * the lengths of the FE units and the status of the 96 channels. The status bits of the 12 channels of an FE unit are
+   * read as a 64-bit word and an FE unit without error is accepted with a single comparison.
+   *
+   * A checker only reads its configuration, so one object can be shared by several threads.
+   */
+  class Fed9UEventIntegrityChecker {
+  public:
+
+    /**
+     * \brief Constructor.
+     * \param description If set, only the FE units and the channels with both APVs enabled in the description are
+     *        checked, and an FE unit enabled in the description but not in the event is reported.
+     * \param checkCrc The CRC is the most expensive check, it can be disabled.
+     */
+    explicit Fed9UEventIntegrityChecker(const Fed9UDescription* description = NULL, bool checkCrc = true);
+
+    /**
+     * \brief  Checks an event.
+     * \param  buffer FED buffer, as read from the FED or created by Fed9UBufferGenerator.
+     * \param  words Size of the buffer in 32 bit words, nothing is read after this size.
+     * \param  integrity Cleared then filled with the violations found.
+     * \return bool True if no violation was found.
+     */
+    bool check(const u32* buffer, u32 words, Fed9UEventIntegrity& integrity) const;
+
+  private:
+
+    bool _checkCrc;
+    bool _checkDisabled;   //!< Report the FE units of the description disabled in the event.
+    bool _checkStatus;     //!< False if the description is in scope mode.
+    u8 _feUnits;           //!< FE units checked, one bit per position.
+    u64 _channels[2];      //!< Channels checked.
+  };
+
+  /**
+   * \brief  Histograms of the violations found by Fed9UEventIntegrityChecker.
+   *
+   * Each counter is a number of events: events with a given ERROR_* bit, events where a given FE unit or channel had a
+   * violation. A statistics object is not locked, each thread of a monitoring consumer fills its own object and the
+   * objects are added with merge.
+   */
+  class Fed9UEventErrorStatistics {
+  public:
+
+    Fed9UEventErrorStatistics() { reset(); }
+
+    /**
+     * \brief Adds the violations of an event.
+     */
+    void add(const Fed9UEventIntegrity& integrity);
+
+    /**
+     * \brief Adds the counters of another object.
+     */
+    void merge(const Fed9UEventErrorStatistics& statistics);
+
+    void reset();
+
+    u32 getEvents() const { return _events; }
+
+    /**
+     * \brief Number of events with a ERROR_* bit, or with any error if error is 0.
+     */
+    u32 getEventErrors(u32 error = 0) const;
+
+    /**
+     * \brief Number of events with a violation on an FE-FPGA (1 - 8).
+     */
+    u32 getFeUnitErrors(Fed9UEventIntegrity::FeViolation violation, u32 feUnit) const {
+      return _feUnits[violation][FEUNITS_PER_FED - feUnit];
+    }
+
+    /**
+     * \brief Number of events with a violation on a channel (1 - 12) of an FE-FPGA (1 - 8).
+     */
+    u32 getChannelErrors(Fed9UEventIntegrity::ChannelViolation violation, u32 feUnit, u32 channel) const {
+      return _channels[violation][(FEUNITS_PER_FED - feUnit) * CHANNELS_PER_FEUNIT + channel - 1];
+    }
+
+    /**
+     * \brief Number of events with a violation on any channel of an FE-FPGA (1 - 8).
+     */
+    u32 getFeUnitChannelErrors(Fed9UEventIntegrity::ChannelViolation violation, u32 feUnit) const {
+      return _feUnitChannels[violation][FEUNITS_PER_FED - feUnit];
+    }
+
+  private:
+
+    enum { EVENT_ERRORS = 8 };
+
+    u32 _events;
+    u32 _errorEvents;
+    u32 _eventErrors[EVENT_ERRORS];
+    u32 _feUnits[Fed9UEventIntegrity::FE_VIOLATIONS][FEUNITS_PER_FED];
+    u32 _feUnitChannels[Fed9UEventIntegrity::CHANNEL_VIOLATIONS][FEUNITS_PER_FED];
+    u32 _channels[Fed9UEventIntegrity::CHANNEL_VIOLATIONS][CHANNELS_PER_FED];
+  };
+
+}
+
+#endif // H_Fed9UEventIntegrity
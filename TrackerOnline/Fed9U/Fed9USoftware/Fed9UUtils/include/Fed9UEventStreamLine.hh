@@ -12,6 +12,7 @@
 #include "Fed9UFakeBufferCreator.hh"
 #include "Fed9UEventUnitStreamLine.hh"
 #include "Fed9UEventStreamLineException.hh"
+#include "Fed9UEventIntegrity.hh"
 #include <iosfwd>
 #include <vector>
 #include <iostream>
@@ -327,6 +328,11 @@ namespace Fed9U {
     // TODO event length code only valid for fake data - needs updating for real data.
     void checkEvent() const;
 
+    /** Non-throwing version of checkEvent and checkChannelStatuses, see Fed9UEventIntegrityChecker.  All the violations found
+	are returned in integrity.  The channels are selected with the FED description if one was given.  Returns true if the
+	event has no violation.*/
+    bool checkIntegrity(Fed9UEventIntegrity & integrity) const;
+
     /** Allows the Event mode to be set externally.  Needed when using Fake Events.*/
     void setEventDataMode(Fed9UEventDataMode mode) {_mode = mode;}
     Fed9UEventDataMode getDataMode() {return _mode;}
@@ -0,0 +1,168 @@
+#ifndef H_Fed9UPedestalAnalyser
+#define H_Fed9UPedestalAnalyser
+
+#include "TypeDefs.hh"
+
+#include <pthread.h>
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace Fed9U {
+
+  class Fed9UEvent;
+  class Fed9UStrips;
+
+  /**
+   * \brief  Multi-threaded pedestal, noise and common mode analysis of virgin raw FED events.
+   *
+   * Events given with addEvent are analysed in the buffer of the caller, events read from a stream with addEvents are
+   * analysed in batches. Each worker thread owns a fixed subset of the FE units,
+   * so the per strip statistics are only ever updated by one thread and need no locking. For each strip the mean and
+   * variance of the raw samples are accumulated with Welford's method, as are the mean and variance after the common
+   * mode of the APV (the median of the strips with the running pedestals subtracted) is removed for that event.
+   *
+   * At the end of the run writeStrips sets the pedestals, the common mode corrected noise and the disable flags in a
+   * Fed9UStrips table. A strip is disabled if it never received data, or if its noise is outside the limits relative to
+   * the median noise of its APV.
+   */
+  class Fed9UPedestalAnalyser {
+  public:
+
+    /**
+     * \brief Constructor.
+     * \param threads Number of worker threads, at most one per FE unit. If zero the number of online processors is used.
+     *        With one thread the analysis is done in the calling thread.
+     * \param batchSize Number of events queued before they are analysed.
+     */
+    explicit Fed9UPedestalAnalyser(u16 threads = 0, u16 batchSize = 32);
+
+    /**
+     * \brief Destructor. Stops the worker threads, any queued events that have not been analysed are discarded.
+     */
+    ~Fed9UPedestalAnalyser();
+
+    /**
+     * \brief  Analyses a FED buffer in place, the buffer is not copied and is not used after the call.
+     * \param  buffer FED buffer, as read from the FED or created by Fed9UBufferGenerator.
+     * \param  words Size of the buffer in 32 bit words.
+     * \throw  ICUtils::ICException If the buffer is not a valid event or the analysis failed.
+     */
+    void addEvent(const u32* buffer, u32 words);
+
+    /**
+     * \brief  Queues all the events in a stream of binary event records, as read by the Fed9UEvent stream constructor.
+     *         The records are read directly into the buffers of the batch, which are reused for every batch.
+     * \param  is Input stream opened in binary mode.
+     * \return u32 Number of events read.
+     */
+    u32 addEvents(std::istream& is);
+
+    /**
+     * \brief Analyses any queued events. Called automatically when the batch is full, by addEvent and by writeStrips.
+     */
+    void flush();
+
+    /**
+     * \brief Clears all the accumulated statistics and the queued events.
+     */
+    void reset();
+
+    /**
+     * \brief  Number of events analysed so far.
+     */
+    u32 getEvents() const { return _events; }
+
+    /**
+     * \brief  Number of worker threads used.
+     */
+    u16 getThreads() const { return _threads; }
+
+    /**
+     * \brief Sets the noise limits used to disable strips.
+     * \param low A strip with a noise below this fraction of the median noise on its APV is disabled as dead.
+     * \param high A strip with a noise above this multiple of the median noise on its APV is disabled as noisy.
+     */
+    void setNoiseLimits(float low, float high) { _lowNoiseLimit = low; _highNoiseLimit = high; }
+
+    /**
+     * \name Results, indexed by the internal FED strip number.
+     */
+    //@{
+    float getPedestal(u16 fedStrip) const { return _raw[fedStrip]._mean; }
+    float getRawNoise(u16 fedStrip) const { return _raw[fedStrip].sigma(); }
+    float getNoise(u16 fedStrip) const { return _corrected[fedStrip].sigma(); }
+    u32 getEntries(u16 fedStrip) const { return _raw[fedStrip]._entries; }
+    //@}
+
+    /**
+     * \brief  Writes the pedestals, noise and disable flags into a strip table, leaving the threshold factors unchanged.
+     * \param  strips Strip table to update.
+     * \return u32 Number of strips that were disabled.
+     */
+    u32 writeStrips(Fed9UStrips& strips);
+
+  private:
+
+    /**
+     * \brief Running mean and sum of squared differences from the mean.
+     */
+    struct Welford {
+      Welford() : _entries(0), _mean(0.0), _m2(0.0) {}
+      void add(double x) {
+	++_entries;
+	const double delta = x - _mean;
+	_mean += delta / _entries;
+	_m2 += delta * (x - _mean);
+      }
+      float sigma() const;
+      u32 _entries;
+      double _mean;
+      double _m2;
+    };
+
+    /**
+     * \brief Context passed to each worker thread.
+     */
+    struct Worker {
+      Fed9UPedestalAnalyser* _owner;
+      u16 _index;
+      pthread_t _thread;
+    };
+
+    static void* workerThread(void* arg);
+    void analyse(u16 worker);
+    void analyseFeUnit(const Fed9UEvent& event, u16 feUnit);
+    void stopWorkers();
+    void clearQueue();
+
+    // Prevent copying, the workers hold a pointer to this object.
+    Fed9UPedestalAnalyser(const Fed9UPedestalAnalyser&);
+    Fed9UPedestalAnalyser& operator=(const Fed9UPedestalAnalyser&);
+
+    u16 _threads;
+    u16 _batchSize;
+    u32 _events;
+    float _lowNoiseLimit, _highNoiseLimit;
+
+    std::vector<Welford> _raw;         //!< Statistics of the raw samples for each strip.
+    std::vector<Welford> _corrected;   //!< Statistics of the common mode subtracted samples for each strip.
+
+    std::vector<std::vector<u32> > _buffers; //!< Buffers of the events read from a stream, one per place in the batch.
+    std::vector<Fed9UEvent*> _queue;          //!< Events reused for every batch, one per place in the batch.
+    u16 _queued;                              //!< Number of events of the current batch initialised on their buffers.
+
+    std::vector<Worker> _workers;
+    pthread_mutex_t _mutex;
+    pthread_cond_t _start;      //!< Signalled when a new batch is ready.
+    pthread_cond_t _finished;   //!< Signalled when the last worker finishes a batch.
+    u32 _generation;            //!< Incremented for every batch.
+    u16 _busy;                  //!< Number of workers still analysing the current batch.
+    bool _stop;
+    std::string _error;         //!< First error reported by a worker during the current batch.
+  };
+
+}
+
+#endif // H_Fed9UPedestalAnalyser
@@ -0,0 +1,61 @@
+#ifndef H_Fed9URawBufferWriter
+#define H_Fed9URawBufferWriter
+
+#include "TypeDefs.hh"
+
+namespace Fed9U {
+
+  class Fed9UBufferDescription;
+
+  /**
+   * \brief  Writes virgin raw and processed raw FED buffers directly into memory provided by the caller.
+   *
+   * The buffers have the layout of the ones made by Fed9UBufferCreatorRaw and Fed9UBufferCreatorProcRaw (VME word order,
+   * 0xED tracker header), with the event number, the APV address error register (no error) and the CRC filled in.
+   * The settings are taken once from a Fed9UBufferDescription and the writer holds no per event state, so one writer can
+   * be used by several threads at the same time.
+   */
+  class Fed9URawBufferWriter {
+  public:
+
+    /**
+     * \brief  Constructor.
+     * \param  description Header format, tracker event type, DAQ mode, packet code and bunch crossing of the events, as
+     *         set by Fed9UBufferCreatorRaw or Fed9UBufferCreatorProcRaw. The strip data of the description is not used.
+     * \throw  ICUtils::ICException If the packet code is not a raw data mode or the header format is unknown.
+     */
+    explicit Fed9URawBufferWriter(const Fed9UBufferDescription& description);
+
+    /**
+     * \brief  Size of the buffers written, in 32 bit words.
+     */
+    u32 getBufferSize() const { return _words; }
+
+    /**
+     * \brief  Writes an event.
+     * \param  strips STRIPS_PER_FED ADC values in physical strip order, as taken by Fed9UBufferGenerator::generateFed9UBuffer.
+     *         In virgin raw mode they are dis-ordered into the APV-MUX order while being written.
+     * \param  eventNumber Event number written in the DAQ header (24 bits).
+     * \param  buffer Buffer of at least getBufferSize() words, aligned on 64 bits.
+     * \return u32 Number of 32 bit words written.
+     */
+    u32 write(const u16* strips, u32 eventNumber, u32* buffer) const;
+
+  private:
+
+    /**
+     * \brief  CRC of a buffer in VME order, the same as calculateFEDBufferCRC but taking a word at a time.
+     */
+    u16 calculateCrc(const u32* buffer) const;
+
+    u32 _words;
+    u32 _header[4];         //!< DAQ and tracker header, the event number is added in the first word.
+    u8 _headerFormat;
+    u8 _packetCode;
+    bool _disorder;          //!< Samples written in APV-MUX order.
+    u16 _crcTable[4][256];   //!< CRC of a byte followed by 0 to 3 zero bytes.
+  };
+
+}
+
+#endif // H_Fed9URawBufferWriter
@@ -0,0 +1,87 @@
+#ifndef H_Fed9URegisterShadow
+#define H_Fed9URegisterShadow
+
+#include "TypeDefs.hh"
+
+namespace Fed9U {
+
+  /**
+   * \brief  Decides when the settings a Fed9UVmeDevice has written to its FED can be trusted instead of being read back.
+   *
+   * Each setter of Fed9UVmeDevice writes the value to the FED and to its local Fed9UDescription, which is therefore a
+   * shadow of the FED registers. The shadow is trusted once the whole FED state has been read back, and stays trusted
+   * while the registers are only changed through the device. A reset, a firmware reload or a failed spot check
+   * invalidates it, and a full read-back is forced every getFullCheckPeriod() loads to catch changes made behind the
+   * back of the device. The generation counter changes each time the shadow changes or loses its trust, so that a
+   * caller can tell whether a copy of the description is still current.
+   */
+  class Fed9URegisterShadow {
+  public:
+
+    /**
+     * \brief Constructor. The shadow is not trusted until synchronized is called.
+     * \param fullCheckPeriod One load in fullCheckPeriod reads back the FED even if the shadow is trusted. 0 or 1 always reads it back.
+     */
+    explicit Fed9URegisterShadow(u32 fullCheckPeriod = 16);
+
+    /**
+     * \brief  Called at the start of a load to decide whether the FED has to be read back.
+     * \return bool True if the shadow can be used after a spot check, false if the FED must be read back.
+     */
+    bool useShadow();
+
+    /**
+     * \brief The whole FED state has been read back into the shadow, which becomes trusted.
+     */
+    void synchronized();
+
+    /**
+     * \brief Values have been written to the FED and to the shadow.
+     */
+    void written() { ++_generation; }
+
+    /**
+     * \brief The FED registers may differ from the shadow, after a reset, a firmware reload or a change of the description
+     *        that was not written to the FED.
+     */
+    void invalidate();
+
+    /**
+     * \brief The spot check done after useShadow returned true found a difference. The shadow is invalidated and the load
+     *        is counted as a read-back.
+     */
+    void spotCheckFailed();
+
+    /**
+     * \brief  FE unit to spot check in the current load, each one in turn.
+     */
+    u16 getSpotCheckFeUnit() const { return _spotChecks % FEUNITS_PER_FED; }
+
+    bool isTrusted() const { return _trusted; }
+    u32 getGeneration() const { return _generation; }
+
+    u32 getFullCheckPeriod() const { return _fullCheckPeriod; }
+    Fed9URegisterShadow& setFullCheckPeriod(u32 fullCheckPeriod) { _fullCheckPeriod = fullCheckPeriod; return *this; }
+
+    /**
+     * \brief  Statistics since construction: loads that read back the FED, loads that used the shadow and spot checks that failed.
+     */
+    u32 getReadBacks() const { return _readBacks; }
+    u32 getReadBacksSkipped() const { return _readBacksSkipped; }
+    u32 getSpotCheckFailures() const { return _spotCheckFailures; }
+
+  private:
+
+    u32 _fullCheckPeriod;
+    u32 _generation;
+    u32 _loadsSinceFullCheck;
+    u32 _spotChecks;
+    u32 _readBacks;
+    u32 _readBacksSkipped;
+    u32 _spotCheckFailures;
+    bool _trusted;
+  };
+
+}
+
+#endif // H_Fed9URegisterShadow
@@ -1,10 +1,16 @@
 #ifndef FED9USISTRIPREORDERING_H
 #define FED9USISTRIPREORDERING_H
 
+#include "TypeDefs.hh"
+
 #include<vector>
 
 namespace Fed9U {
 
+  class Fed9UEvent;
+  class Fed9UEventChannel;
+  class Fed9UStrips;
+
   //using.*std::vector;
 
   /**
@@ -16,6 +22,11 @@ namespace Fed9U {
    * provides a method to re-order a FED channel worth of data. There is also a method
    * to do the reverse, which dis-orders the data to emulate the ordering done in the APV MUX chip.
    * The re-ordering algorithm implemented here is the same as the re-ordering algorithm in the FED 9U.
+   *
+   * The vector based methods compute the ordering for each strip. For bulk processing the orderings are also provided
+   * as precomputed permutation tables for a single APV and for a whole FED channel (two interleaved APVs), along with
+   * methods that apply them to caller provided buffers and a single pass which converts the virgin raw data of a complete
+   * event to pedestal subtracted strips in physical order.
    */
   class Fed9USiStripReordering {
 
@@ -48,9 +59,75 @@ namespace Fed9U {
      */
     void disOrderingAlgorithm(const std::vector<unsigned short> &apvInput, std::vector<unsigned short> &apvOutput);
 
-  private:
+    /**
+     * \brief Re-orders the samples of a FED channel, as read out in virgin raw mode, into physical strip order.
+     * \param raw Contains the 256 samples of the channel, with the two APVs interleaved and in APV-MUX order.
+     * \param physical Filled with the 256 strips of the channel, APV0 strips followed by APV1 strips. Must not overlap raw.
+     */
+    static void reOrderChannel(const u16* raw, u16* physical);
+
+    /**
+     * \brief Re-orders the 256 samples of a FED channel in place.
+     */
+    static void reOrderChannel(u16* samples);
+
+    /**
+     * \brief Dis-orders the strips of a FED channel into the interleaved APV-MUX order output by the APVs.
+     * \param physical Contains the 256 strips of the channel in physical order.
+     * \param raw Filled with the 256 samples in the order they are read out in virgin raw mode. Must not overlap physical.
+     */
+    static void disOrderChannel(const u16* physical, u16* raw);
+
+    /**
+     * \brief Dis-orders the 256 strips of a FED channel in place.
+     */
+    static void disOrderChannel(u16* samples);
+
+    /**
+     * \brief  Unpacks, re-orders and pedestal subtracts the strip data of a complete event in a single pass.
+     * \param  event Event taken in one of the virgin raw or processed raw modes, including the 10 and 8 bit packed variants.
+     * \param  pedestals Pedestal for each FED strip, indexed by the internal FED strip number. If NULL no pedestals are subtracted.
+     * \param  strips Filled with STRIPS_PER_FED values indexed by the internal FED strip number. Strips of FE units or channels
+     *         not present in the event are set to zero.
+     * \return u16 Number of channels that were unpacked.
+     * \throw  std::invalid_argument If a channel is not a raw data packet or does not contain 256 samples.
+     *
+     * Processed raw data is already re-ordered and pedestal subtracted by the FED, and is only unpacked.
+     */
+    static u16 reOrderEvent(const Fed9UEvent& event, const i16* pedestals, i16* strips);
+
+    /**
+     * \brief Unpacks, re-orders and pedestal subtracts a single channel of an event, as done for each channel by reOrderEvent.
+     * \param channel Channel taken in one of the raw data modes.
+     * \param pedestals Pedestals of the 256 channel strips in physical order. If NULL no pedestals are subtracted.
+     * \param strips Filled with the 256 channel strips in physical order.
+     * \throw std::invalid_argument If the channel is not a raw data packet or does not contain 256 samples.
+     */
+    static void reOrderEventChannel(const Fed9UEventChannel& channel, const i16* pedestals, i16* strips);
+
+    /**
+     * \brief Copies the pedestals of all the FED strips into a table suitable for reOrderEvent.
+     * \param strips Strip settings to take the pedestals from.
+     * \param pedestals Filled with STRIPS_PER_FED pedestals indexed by internal FED strip number.
+     */
+    static void getPedestals(const Fed9UStrips& strips, i16* pedestals);
 
     static const unsigned short NUMBER_OF_APV_STRIPS = 128; //!< Number of strips on an APV.
+    static const unsigned short NUMBER_OF_CHANNEL_SAMPLES = 256; //!< Number of samples in a FED channel in raw data modes.
+
+    /**
+     * \name Permutation tables.
+     *
+     * For the re-ordering tables the physical strip i is found at position TABLE[i] of the APV-MUX ordered data. For the
+     * dis-ordering tables the APV-MUX ordered sample i is found at position TABLE[i] of the physically ordered data. Each is
+     * the inverse of the other. The channel tables include the interleaving of the two APVs.
+     */
+    //@{
+    static const u16 APV_REORDER_TABLE[NUMBER_OF_APV_STRIPS];
+    static const u16 APV_DISORDER_TABLE[NUMBER_OF_APV_STRIPS];
+    static const u16 CHANNEL_REORDER_TABLE[NUMBER_OF_CHANNEL_SAMPLES];
+    static const u16 CHANNEL_DISORDER_TABLE[NUMBER_OF_CHANNEL_SAMPLES];
+    //@}
  
   };
   
@@ -0,0 +1,115 @@
+#ifndef H_Fed9USignalModel
+#define H_Fed9USignalModel
+
+#include "TypeDefs.hh"
+
+#include <vector>
+
+namespace Fed9U {
+
+  /**
+   * \brief  Small and fast pseudo random number generator (xorshift64*) for the generation of synthetic events.
+   *
+   * The generator is seeded for each event from a run seed and the event number, so an event is the same whichever
+   * thread generates it and can be generated again to get the truth it was made from.
+   */
+  class Fed9URandom {
+  public:
+
+    explicit Fed9URandom(u64 seed = 1, u32 event = 0) { setSeed(seed, event); }
+
+    /**
+     * \brief Restarts the sequence for an event of a run.
+     */
+    void setSeed(u64 seed, u32 event);
+
+    u64 next() {
+      _state ^= _state >> 12;
+      _state ^= _state << 25;
+      _state ^= _state >> 27;
+      return _state * 0x2545F4914F6CDD1DULL;
+    }
+
+    /**
+     * \brief Uniform integer in [0, n).
+     */
+    u32 uniform(u32 n) { return static_cast<u32>(((next() >> 32) * n) >> 32); }
+
+    /**
+     * \brief Uniform value in [0, 1).
+     */
+    double uniform() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+
+    /**
+     * \brief Normal distribution with a mean of 0 and a sigma of 1 (Box-Muller).
+     */
+    double gaussian();
+
+  private:
+    u64 _state;
+  };
+
+  /**
+   * \brief  Interface of the signal models used by Fed9UBufferEngine to fill the strips of an event.
+   *
+   * The same model is used by all the generation threads, generate must not modify the model. All the random numbers
+   * are taken from the generator passed in, which is seeded for the event.
+   */
+  class Fed9USignalModel {
+  public:
+
+    virtual ~Fed9USignalModel() {}
+
+    /**
+     * \brief Fills the ADC values of all the strips of a FED.
+     * \param random Generator seeded for the event.
+     * \param strips STRIPS_PER_FED values indexed by the internal FED strip number, in physical strip order as taken by
+     *        Fed9UBufferGenerator::generateFed9UBuffer. The values must fit in 10 bits.
+     */
+    virtual void generate(Fed9URandom& random, u16* strips) const = 0;
+  };
+
+  /**
+   * \brief  Pedestals, gaussian noise and clusters injected at random positions.
+   *
+   * The noise is taken from a table of quantised gaussian values built by the constructor, so one random number gives
+   * the noise of five strips. A cluster is a group of adjacent strips of one APV with the charge shared between them.
+   */
+  class Fed9UPedestalNoiseModel : public Fed9USignalModel {
+  public:
+
+    /**
+     * \brief Constructor.
+     * \param pedestal Pedestal of all the strips.
+     * \param noise Sigma of the noise in ADC counts.
+     * \param clusters Number of clusters injected in each event.
+     * \param charge Mean charge of a cluster in ADC counts, the charge of each cluster is spread by 20%.
+     */
+    Fed9UPedestalNoiseModel(u16 pedestal = 200, float noise = 2.0, u16 clusters = 0, u16 charge = 100);
+
+    /**
+     * \brief Sets a pedestal for each strip, indexed by the internal FED strip number.
+     */
+    Fed9UPedestalNoiseModel& setPedestals(const std::vector<u16>& pedestals);
+
+    /**
+     * \brief Sets the width of the clusters, which are between 1 and maxWidth strips wide (3 by default).
+     */
+    Fed9UPedestalNoiseModel& setMaxClusterWidth(u16 maxWidth);
+
+    void generate(Fed9URandom& random, u16* strips) const;
+
+  private:
+
+    static const u32 NOISE_BITS = 12;   //!< Size of the noise table as a power of 2.
+
+    std::vector<u16> _pedestals;
+    std::vector<i16> _noise;    //!< Quantised gaussian noise values.
+    u16 _clusters;
+    u16 _charge;
+    u16 _maxWidth;
+  };
+
+}
+
+#endif // H_Fed9USignalModel
@@ -54,42 +54,10 @@ namespace Fed9U {
       unsigned short chansPerFed = mFed9UEventInfo.getChannelsPerFeUnit() * mFed9UEventInfo.getFeUnitsPerFed();
       unsigned short stripsPerFed = stripsPerChannel * chansPerFed;
       ICUTILS_VERIFY(bufferData.size()==stripsPerFed)(bufferData.size())(stripsPerFed).error();
-      //First make two vectors which contain the 1st and 2nd APV. We also have to take into account the interleaving here
-      //(ie. the data from the APV is interleaved, as well as being disordered).
-      std::vector<unsigned short> apv1;
-      std::vector<unsigned short> apv2;
-      apv1.reserve(stripsPerApv);
-      apv2.reserve(stripsPerApv);
-      //Make new large vector to hold dis-ordered, interleaved data.
-      std::vector<unsigned short> newFed9UBufferData;
-      //Ordering object
-      Fed9U::Fed9USiStripReordering theFed9USiStripReordering;
-      //Copy the data from each channel into the two vectors, dis-order them, and interleave them.
+      //Each channel holds the data from two APVs, which is interleaved as well as being disordered.
+      ICUTILS_VERIFY(stripsPerChannel==Fed9USiStripReordering::NUMBER_OF_CHANNEL_SAMPLES)(stripsPerChannel).error();
       for (int chan=0; chan<chansPerFed; ++chan) {
-	for (int i = 0; i<stripsPerChannel; ++i) {
-	  if (i<stripsPerApv) { //Get first APV data
-	    apv1.push_back(bufferData[i+(chan*stripsPerChannel)]);
-	  }
-	  else { //Get second APV data
-	    apv2.push_back(bufferData[i+(chan*stripsPerChannel)]);
-	  }
-	}
-	//Now dis-order
-	std::vector<unsigned short> disOrderedData1;
-	std::vector<unsigned short> disOrderedData2;
-	theFed9USiStripReordering.disOrderingAlgorithm(apv1, disOrderedData1);
-	theFed9USiStripReordering.disOrderingAlgorithm(apv2, disOrderedData2);
-	apv1.clear();
-	apv2.clear();
-	//Interleave data into new large vector
-	for (int i = 0; i<stripsPerChannel; ++i) {
-	  if ((i%2)==0) {
-	    bufferData[i+(chan*stripsPerChannel)] = disOrderedData1[i/2];
-	  }
-	  else {
-	    bufferData[i+(chan*stripsPerChannel)] = disOrderedData2[(i-1)/2];
-	  }
-	}
+	Fed9USiStripReordering::disOrderChannel(&bufferData[chan*stripsPerChannel]);
       }
     } 
     catch (std::exception &e) {
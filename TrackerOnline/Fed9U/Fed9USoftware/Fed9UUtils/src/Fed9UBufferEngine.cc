@@ -0,0 +1,222 @@
+#include "Fed9UBufferEngine.hh"
+#include "Fed9URawBufferWriter.hh"
+#include "Fed9USignalModel.hh"
+#include "Fed9UEvent.hh"
+#include "Fed9USiStripReordering.hh"
+#include "ICAssert.hh"
+#include "ICException.hh"
+
+#include <sched.h>
+#include <unistd.h>
+
+#include <exception>
+#include <iostream>
+
+namespace Fed9U {
+
+  using std::vector;
+
+  void Fed9UBufferEngine::SlotQueue::init(u32 capacity) {
+    u32 size = 1;
+    while (size < capacity) size <<= 1;
+    _cells.resize(size);
+    for (u32 i = 0; i < size; ++i) _cells[i]._sequence = i;
+    _mask = size - 1;
+    _enqueue = _dequeue = 0;
+  }
+
+  bool Fed9UBufferEngine::SlotQueue::push(u32 slot, u32 eventNumber) {
+    u32 position = _enqueue;
+    Cell* cell;
+    for (;;) {
+      cell = &_cells[position & _mask];
+      const i32 difference = static_cast<i32>(cell->_sequence - position);
+      if (difference == 0) {
+	if (__sync_bool_compare_and_swap(&_enqueue, position, position + 1)) break;
+      } else if (difference < 0) {
+	return false;
+      }
+      position = _enqueue;
+    }
+    cell->_slot = slot;
+    cell->_eventNumber = eventNumber;
+    __sync_synchronize();
+    cell->_sequence = position + 1;
+    return true;
+  }
+
+  bool Fed9UBufferEngine::SlotQueue::pop(u32& slot, u32& eventNumber) {
+    u32 position = _dequeue;
+    Cell* cell;
+    for (;;) {
+      cell = &_cells[position & _mask];
+      const i32 difference = static_cast<i32>(cell->_sequence - (position + 1));
+      if (difference == 0) {
+	if (__sync_bool_compare_and_swap(&_dequeue, position, position + 1)) break;
+      } else if (difference < 0) {
+	return false;
+      }
+      position = _dequeue;
+    }
+    slot = cell->_slot;
+    eventNumber = cell->_eventNumber;
+    __sync_synchronize();
+    cell->_sequence = position + _mask + 1;
+    return true;
+  }
+
+  Fed9UBufferEngine::Fed9UBufferEngine(const Fed9URawBufferWriter& writer, const Fed9USignalModel& model, u64 seed) :
+    _writer(writer), _model(model), _seed(seed),
+    _buffers(NULL), _slots(0), _slotWords(0), _events(0), _nextEvent(0), _generated(0), _running(0), _stop(false)
+  {
+  }
+
+  Fed9UBufferEngine::~Fed9UBufferEngine() {
+    stop();
+  }
+
+  u32 Fed9UBufferEngine::getBufferSize() const {
+    return _writer.getBufferSize();
+  }
+
+  void Fed9UBufferEngine::start(u32* buffers, u32 slots, u32 slotWords, u16 threads, u32 events) {
+    ICUTILS_VERIFY(_workers.empty()).error().msg("The engine is already started");
+    ICUTILS_VERIFY(buffers != NULL && reinterpret_cast<unsigned long>(buffers) % 8 == 0 && slots > 0).error()
+      .msg("The slots must be aligned on 64 bits");
+    ICUTILS_VERIFY(slotWords >= getBufferSize() && slotWords % 2 == 0)(slotWords)(getBufferSize()).error()
+      .msg("The slots are too small for the events");
+
+    if (threads == 0) {
+      long processors = sysconf(_SC_NPROCESSORS_ONLN);
+      threads = processors > 0 ? static_cast<u16>(processors) : 1;
+    }
+
+    _buffers = buffers;
+    _slots = slots;
+    _slotWords = slotWords;
+    _events = events;
+    _nextEvent = 0;
+    _generated = 0;
+    _stop = false;
+    _free.init(slots);
+    _ready.init(slots);
+    for (u32 slot = 0; slot < slots; ++slot) _free.push(slot, 0);
+
+    _workers.resize(threads);
+    _running = threads;
+    for (u16 i = 0; i < threads; ++i) {
+      _workers[i]._owner = this;
+      if (pthread_create(&_workers[i]._thread, NULL, workerThread, &_workers[i]) != 0) {
+	__sync_fetch_and_sub(&_running, threads - i);
+	_workers.resize(i);
+	stop();
+	ICUTILS_VERIFY(false)(i).error().msg("Cannot create the generation threads");
+      }
+    }
+  }
+
+  void* Fed9UBufferEngine::workerThread(void* arg) {
+    Worker* worker = static_cast<Worker*>(arg);
+    worker->_owner->generate();
+    return NULL;
+  }
+
+  void Fed9UBufferEngine::generate() {
+    vector<u16> strips(STRIPS_PER_FED);
+    Fed9URandom random;
+    u32 slot, unused;
+    while (!_stop && !(_events && _nextEvent >= _events)) {
+      //Take the slot before the event number, so that the events are queued close to their order.
+      if (!_free.pop(slot, unused)) {
+	sched_yield();
+	continue;
+      }
+      const u32 eventNumber = __sync_add_and_fetch(&_nextEvent, 1);
+      if (_events && eventNumber > _events) {
+	_free.push(slot, 0);
+	break;
+      }
+      random.setSeed(_seed, eventNumber);
+      _model.generate(random, &strips[0]);
+      _writer.write(&strips[0], eventNumber, _buffers + slot * _slotWords);
+      __sync_fetch_and_add(&_generated, 1);
+      _ready.push(slot, eventNumber);
+    }
+    __sync_fetch_and_sub(&_running, 1);
+  }
+
+  const u32* Fed9UBufferEngine::tryPop(u32& eventNumber) {
+    u32 slot;
+    if (!_ready.pop(slot, eventNumber)) return NULL;
+    return _buffers + slot * _slotWords;
+  }
+
+  const u32* Fed9UBufferEngine::pop(u32& eventNumber) {
+    for (;;) {
+      const u32* event = tryPop(eventNumber);
+      if (event) return event;
+      //The threads queue their last event before they finish, so a last attempt is enough.
+      if (_running == 0) return _stop ? NULL : tryPop(eventNumber);
+      sched_yield();
+    }
+  }
+
+  void Fed9UBufferEngine::release(const u32* event) {
+    ICUTILS_VERIFY(event >= _buffers && event < _buffers + _slots * _slotWords && (event - _buffers) % _slotWords == 0).error()
+      .msg("The event was not returned by pop");
+    _free.push((event - _buffers) / _slotWords, 0);
+  }
+
+  void Fed9UBufferEngine::stop() {
+    _stop = true;
+    for (u32 i = 0; i < _workers.size(); ++i) pthread_join(_workers[i]._thread, NULL);
+    _workers.clear();
+    //Discard the events that were not taken.
+    u32 slot, eventNumber;
+    while (_ready.pop(slot, eventNumber)) _free.push(slot, 0);
+  }
+
+  void Fed9UBufferEngine::getTruth(u32 eventNumber, u16* strips) const {
+    Fed9URandom random(_seed, eventNumber);
+    _model.generate(random, strips);
+  }
+
+  bool Fed9UBufferEngine::checkEvent(const u32* event, u32 eventNumber, std::ostream& report) const {
+    vector<u16> truth(STRIPS_PER_FED);
+    vector<i16> strips(STRIPS_PER_FED);
+    getTruth(eventNumber, &truth[0]);
+    bool ok = true;
+    try {
+      Fed9UEvent decoded(const_cast<u32*>(event), NULL, getBufferSize());
+      if (decoded.getEventNumber() != (eventNumber & 0xFFFFFF)) {
+	report << "Event " << eventNumber << ": event number " << decoded.getEventNumber() << " in the DAQ header" << std::endl;
+	ok = false;
+      }
+      if (decoded.getCrc() != decoded.calcCrc()) {
+	report << "Event " << eventNumber << ": CRC 0x" << std::hex << decoded.getCrc() << " calculated 0x" << decoded.calcCrc() << std::dec << std::endl;
+	ok = false;
+      }
+      if (decoded.getTotalLength() * 2 != getBufferSize()) {
+	report << "Event " << eventNumber << ": length " << decoded.getTotalLength() << " in the DAQ trailer" << std::endl;
+	ok = false;
+      }
+      const u16 channels = Fed9USiStripReordering::reOrderEvent(decoded, NULL, &strips[0]);
+      if (channels != CHANNELS_PER_FED) {
+	report << "Event " << eventNumber << ": " << channels << " channels decoded" << std::endl;
+	ok = false;
+      }
+      for (u32 i = 0; i < STRIPS_PER_FED; ++i) {
+	if (strips[i] != static_cast<i16>(truth[i])) {
+	  report << "Event " << eventNumber << ": strip " << i << " is " << strips[i] << " instead of " << truth[i] << std::endl;
+	  ok = false;
+	  break;
+	}
+      }
+    } catch (std::exception& e) {
+      report << "Event " << eventNumber << ": " << e.what() << std::endl;
+      ok = false;
+    }
+    return ok;
+  }
+
+}
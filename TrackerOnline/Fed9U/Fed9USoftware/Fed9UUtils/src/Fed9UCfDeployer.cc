@@ -0,0 +1,164 @@
+#include "Fed9UCfDeployer.hh"
+#include "ICAssert.hh"
+#include "ICException.hh"
+
+#include <exception>
+#include <sstream>
+
+namespace Fed9U {
+
+  using std::vector;
+  using std::string;
+
+  namespace {
+
+    /**
+     * Fed9UVmeDevice::setCfFileHeader writes the delay FPGA version under the BE FPGA label and the other way round,
+     * so those two versions are compared in either order.
+     */
+    bool versionsMatch(const Fed9UCfFirmwareVersions& expected, const Fed9UCfFirmwareVersions& actual) {
+      return expected._fe == actual._fe && expected._vme == actual._vme
+	&& ((expected._delay == actual._delay && expected._be == actual._be) || (expected._delay == actual._be && expected._be == actual._delay));
+    }
+
+  }
+
+  Fed9UCfDeployer::Fed9UCfDeployer(const Fed9UCfImage& image) :
+    _image(image), _revision(0), _verify(true), _maxRewrites(2), _reload(true), _stopRequested(false), _clustersWritten(0), _clustersRead(0)
+  {
+  }
+
+  Fed9UCfDeployer& Fed9UCfDeployer::addFed(Fed9UCfTarget& target) {
+    FedDeployment fed;
+    fed._owner = this;
+    fed._target = &target;
+    fed._status = NULL;
+    _feds.push_back(fed);
+    return *this;
+  }
+
+  Fed9UCfDeployer& Fed9UCfDeployer::setRevision(u32 revision) {
+    ICUTILS_VERIFY(revision < 8)(revision).error().msg("The revision is invalid.");
+    _revision = revision;
+    return *this;
+  }
+
+  u32 Fed9UCfDeployer::deploy(vector<Fed9UCfDeployStatus>& status) {
+    status.resize(_feds.size());
+    _stopRequested = false;
+    _clustersWritten = _clustersRead = 0;
+    for (u32 fed = 0; fed < _feds.size(); ++fed) {
+      Fed9UCfDeployStatus& fedStatus = status[fed];
+      //The progress of another image cannot be resumed.
+      if (fedStatus._imageChecksum != _image.getChecksum() || fedStatus._clustersDone > _image.getClusterCount()) {
+	fedStatus = Fed9UCfDeployStatus();
+	fedStatus._imageChecksum = _image.getChecksum();
+      }
+      fedStatus._reloaded = fedStatus._versionsMatch = false;
+      fedStatus._error.clear();
+      _feds[fed]._status = &fedStatus;
+    }
+
+    runAll(writeThread);
+
+    bool allWritten = true;
+    for (u32 fed = 0; fed < _feds.size(); ++fed) allWritten = allWritten && status[fed]._clustersDone == _image.getClusterCount();
+    if (_reload && allWritten) runAll(reloadThread);
+
+    u32 failedFeds = 0;
+    for (u32 fed = 0; fed < _feds.size(); ++fed) {
+      const Fed9UCfDeployStatus& fedStatus = status[fed];
+      if (fedStatus._clustersDone != _image.getClusterCount() || !fedStatus._error.empty() || (fedStatus._reloaded && !fedStatus._versionsMatch)) ++failedFeds;
+    }
+    return failedFeds;
+  }
+
+  void Fed9UCfDeployer::runAll(void* (*function)(void*)) {
+    vector<bool> running(_feds.size(), false);
+    for (u32 fed = 0; fed < _feds.size(); ++fed) {
+      if (pthread_create(&_feds[fed]._thread, NULL, function, &_feds[fed]) == 0) running[fed] = true;
+      else function(&_feds[fed]);
+    }
+    for (u32 fed = 0; fed < _feds.size(); ++fed) {
+      if (running[fed]) pthread_join(_feds[fed]._thread, NULL);
+    }
+  }
+
+  void* Fed9UCfDeployer::writeThread(void* arg) {
+    FedDeployment& fed = *static_cast<FedDeployment*>(arg);
+    try {
+      fed._owner->write(fed);
+    }
+    catch (const ICUtils::ICException& e) {
+      fed._status->_error = e.what();
+    }
+    catch (const std::exception& e) {
+      fed._status->_error = e.what();
+    }
+    catch (...) {
+      fed._status->_error = "Caught unknown exception.";
+    }
+    return NULL;
+  }
+
+  void* Fed9UCfDeployer::reloadThread(void* arg) {
+    FedDeployment& fed = *static_cast<FedDeployment*>(arg);
+    try {
+      fed._owner->reload(fed);
+    }
+    catch (const ICUtils::ICException& e) {
+      fed._status->_error = e.what();
+    }
+    catch (const std::exception& e) {
+      fed._status->_error = e.what();
+    }
+    catch (...) {
+      fed._status->_error = "Caught unknown exception.";
+    }
+    return NULL;
+  }
+
+  void Fed9UCfDeployer::write(FedDeployment& fed) {
+    Fed9UCfDeployStatus& status = *fed._status;
+    vector<u8> readBack(_verify ? Fed9UCfImage::CLUSTER_BYTES : 0);
+    while (status._clustersDone < _image.getClusterCount()) {
+      if (_stopRequested) {
+	std::ostringstream msg;
+	msg << "Deployment stopped after cluster " << status._clustersDone << ".";
+	status._error = msg.str();
+	return;
+      }
+      const u32 cluster = status._clustersDone;
+      bool verified = false;
+      for (u32 attempt = 0; !verified; ++attempt) {
+	ICUTILS_VERIFY(attempt <= _maxRewrites)(cluster)(attempt).error().msg("The cluster read back from the compact flash does not match the image.");
+	if (attempt > 0) ++status._rewrites;
+	fed._target->writeCluster(cluster, _image.getCluster(cluster));
+	__sync_fetch_and_add(&_clustersWritten, 1);
+	if (!_verify) break;
+	fed._target->readCluster(cluster, &readBack[0]);
+	__sync_fetch_and_add(&_clustersRead, 1);
+	verified = Fed9UCfImage::checksum(&readBack[0], Fed9UCfImage::CLUSTER_BYTES) == _image.getClusterChecksum(cluster);
+      }
+      ++status._clustersDone;
+    }
+  }
+
+  void Fed9UCfDeployer::reload(FedDeployment& fed) {
+    Fed9UCfDeployStatus& status = *fed._status;
+    fed._target->reloadFirmware(_revision);
+    status._reloaded = true;
+    status._versions = fed._target->getFirmwareVersions();
+    Fed9UCfFirmwareVersions expected;
+    //An image without a header entry for the revision cannot be checked.
+    status._versionsMatch = !_image.getFirmwareVersions(_revision, expected) || versionsMatch(expected, status._versions);
+    if (!status._versionsMatch) {
+      std::ostringstream msg;
+      msg << std::hex << "The firmware versions after the reload do not match the image: FE " << status._versions._fe << " delay "
+	  << status._versions._delay << " BE " << status._versions._be << " VME " << status._versions._vme << ", image FE " << expected._fe
+	  << " delay " << expected._delay << " BE " << expected._be << " VME " << expected._vme << ".";
+      status._error = msg.str();
+    }
+  }
+
+}
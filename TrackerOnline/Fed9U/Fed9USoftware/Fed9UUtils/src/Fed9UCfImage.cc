@@ -0,0 +1,123 @@
+#include "Fed9UCfImage.hh"
+#include "ICAssert.hh"
+#include "ICException.hh"
+
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+namespace Fed9U {
+
+  using std::string;
+
+  namespace {
+
+    /**
+     * Table of the reflected CRC-32 polynomial 0xedb88320, filled before main is called.
+     */
+    struct CrcTable {
+      CrcTable() {
+	for (u32 n = 0; n < 256; ++n) {
+	  u32 c = n;
+	  for (u32 k = 0; k < 8; ++k) c = (c & 1) ? 0xedb88320 ^ (c >> 1) : c >> 1;
+	  _table[n] = c;
+	}
+      }
+      u32 _table[256];
+    };
+    const CrcTable CRC_TABLE;
+
+    const string END_OF_FILE("END OF FILE");
+    const string END_OF_HEADER("END OF FILE HEADER");
+    //Longest header accepted, as in Fed9UVmeDevice::removeCfFileHeaderAndMarkers.
+    const u32 MAX_HEADER_LINES = 80;
+
+  }
+
+  Fed9UCfImage::Fed9UCfImage(const string& fileName) : _dataSize(0), _checksum(0) {
+    std::ifstream file(fileName.c_str(), std::ios::binary);
+    ICUTILS_VERIFY(file.good())(fileName).error().msg("The Compact Flash image cannot be opened.");
+    parse(file);
+  }
+
+  Fed9UCfImage::Fed9UCfImage(std::istream& is) : _dataSize(0), _checksum(0) {
+    parse(is);
+  }
+
+  bool Fed9UCfImage::getFirmwareVersions(u32 revision, Fed9UCfFirmwareVersions& versions) const {
+    for (u32 i = 0; i < _revisions.size(); ++i) {
+      if (_revisions[i].first == revision) {
+	versions = _revisions[i].second;
+	return true;
+      }
+    }
+    return false;
+  }
+
+  u32 Fed9UCfImage::checksum(const u8* data, u32 bytes, u32 crc) {
+    crc = ~crc;
+    for (u32 i = 0; i < bytes; ++i) crc = CRC_TABLE._table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    return ~crc;
+  }
+
+  void Fed9UCfImage::parse(std::istream& is) {
+    const string content((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+
+    //The file must end with the end of file marker, the data end at the new line written before it.
+    string::size_type end = content.size();
+    if (end > 0 && content[end - 1] == '\n') --end;
+    ICUTILS_VERIFY(end >= END_OF_FILE.size() && content.compare(end - END_OF_FILE.size(), END_OF_FILE.size(), END_OF_FILE) == 0)
+      (content.size()).error().msg("The compact flash file image is incomplete.");
+    end -= END_OF_FILE.size();
+    if (end > 0 && content[end - 1] == '\n') --end;
+
+    //The header holds the firmware versions of each revision, up to the end of header marker.
+    std::ostringstream firmwareInfo;
+    string::size_type start = 0;
+    bool endOfHeader = false;
+    u32 revision = 0;
+    bool inRevision = false;
+    for (u32 lines = 0; lines < MAX_HEADER_LINES && !endOfHeader && start < content.size(); ++lines) {
+      string::size_type newLine = content.find('\n', start);
+      if (newLine == string::npos) newLine = content.size();
+      const string line(content, start, newLine - start);
+      start = newLine + 1;
+      if (line == END_OF_HEADER) {
+	endOfHeader = true;
+	break;
+      }
+      firmwareInfo << line << '\n';
+      if (line.compare(0, 9, "Revision:") == 0) {
+	revision = std::atoi(line.c_str() + 9);
+	inRevision = true;
+	_revisions.push_back(std::make_pair(revision, Fed9UCfFirmwareVersions()));
+      } else if (inRevision && line.find('$') != string::npos) {
+	const u32 version = std::strtoul(line.c_str() + line.find('$') + 1, NULL, 16);
+	Fed9UCfFirmwareVersions& versions = _revisions.back().second;
+	if (line.find("DELAY FPGA") != string::npos) versions._delay = version;
+	else if (line.find("VME FPGA") != string::npos) versions._vme = version;
+	else if (line.find("BE FPGA") != string::npos) versions._be = version;
+	else if (line.find("FE FPGA") != string::npos) versions._fe = version;
+      }
+    }
+    ICUTILS_VERIFY(endOfHeader && start <= end)(MAX_HEADER_LINES).error().msg("Failed to find the end of the file header.");
+    _firmwareInfo = firmwareInfo.str();
+
+    //The System ACE is written 16 bit words at a time, an odd last byte is not written.
+    _dataSize = (end - start) & ~1;
+    ICUTILS_VERIFY(_dataSize > 0 && _dataSize <= MAX_CLUSTERS * CLUSTER_BYTES)(_dataSize)(MAX_CLUSTERS * CLUSTER_BYTES)
+      .error().msg("The compact flash image data do not fit on the card.");
+    const u32 clusters = (_dataSize + CLUSTER_BYTES - 1) / CLUSTER_BYTES;
+    _data.assign(clusters * CLUSTER_BYTES, 0);
+    content.copy(reinterpret_cast<char*>(&_data[0]), _dataSize, start);
+
+    _checksums.resize(clusters);
+    _checksum = 0;
+    for (u32 cluster = 0; cluster < clusters; ++cluster) {
+      _checksums[cluster] = checksum(getCluster(cluster), CLUSTER_BYTES);
+      _checksum = checksum(getCluster(cluster), CLUSTER_BYTES, _checksum);
+    }
+  }
+
+}
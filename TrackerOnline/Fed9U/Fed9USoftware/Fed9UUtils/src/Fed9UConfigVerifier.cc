@@ -0,0 +1,167 @@
+#include "Fed9UConfigVerifier.hh"
+#include "Fed9UDescription.hh"
+#include "Fed9UStrips.hh"
+#include "Fed9UStripDescription.hh"
+
+#include <iostream>
+
+namespace Fed9U {
+
+  using std::vector;
+
+  namespace {
+
+    void add(vector<Fed9UConfigMismatch>& mismatches, Fed9UConfigMismatch::Field field, const Fed9UAddress& address, u32 expected, u32 actual) {
+      if (expected != actual) mismatches.push_back(Fed9UConfigMismatch(field, address, expected, actual));
+    }
+
+    /**
+     * Frame threshold as stored by the FED, in steps of 32 rounded as in Fed9UVmeDevice::setFrameThreshold.
+     */
+    u32 storedFrameThreshold(u16 threshold) {
+      return 32 * static_cast<u32>(static_cast<float>(threshold)/32.0 + 0.5);
+    }
+
+    const char* const FIELD_NAMES[Fed9UConfigMismatch::FIELDS] = {
+      "trigger source", "test register", "BE FPGA read route", "header format", "BE FPGA disable", "FED ID", "FE unit disable",
+      "scope length", "OptoRx input offset", "OptoRx output offset", "OptoRx capacitor", "median override disable", "median override",
+      "frame threshold", "ADC dfsen", "ADC dfsval", "ADC s1", "ADC s2", "APV disable",
+      "pedestal", "strip disable", "high cluster threshold", "low cluster threshold"
+    };
+
+  }
+
+  u32 Fed9UConfigVerifier::compare(const Fed9UDescription& expected, const Fed9UDescription& actual, u32 sections, bool adcsOn,
+				   vector<Fed9UConfigMismatch>& mismatches) {
+    const u32 before = mismatches.size();
+    const Fed9UAddress fed;
+
+    if (sections & BACK_END) {
+      add(mismatches, Fed9UConfigMismatch::TRIGGER_SOURCE, fed, expected.getTriggerSource(), actual.getTriggerSource());
+      add(mismatches, Fed9UConfigMismatch::TEST_REGISTER, fed, expected.getTestRegister(), actual.getTestRegister());
+      add(mismatches, Fed9UConfigMismatch::READ_ROUTE, fed, expected.getBeFpgaReadRoute(), actual.getBeFpgaReadRoute());
+      add(mismatches, Fed9UConfigMismatch::HEADER_FORMAT, fed, expected.getHeaderFormatType(), actual.getHeaderFormatType());
+      add(mismatches, Fed9UConfigMismatch::BE_FPGA_DISABLE, fed, expected.getFedBeFpgaDisable(), actual.getFedBeFpgaDisable());
+      add(mismatches, Fed9UConfigMismatch::FED_ID, fed, expected.getFedId(), actual.getFedId());
+      for (u32 feUnit = 0; feUnit < FEUNITS_PER_FED; ++feUnit) {
+	Fed9UAddress addr;
+	addr.setFedFeUnit(feUnit);
+	add(mismatches, Fed9UConfigMismatch::FE_UNIT_DISABLE, addr, expected.getFedFeUnitDisable(addr), actual.getFedFeUnitDisable(addr));
+      }
+    }
+
+    if (sections & FRONT_END) {
+      add(mismatches, Fed9UConfigMismatch::SCOPE_LENGTH, fed, expected.getScopeLength(), actual.getScopeLength());
+      for (u32 feUnit = 0; feUnit < FEUNITS_PER_FED; ++feUnit) {
+	Fed9UAddress addr;
+	addr.setFedFeUnit(feUnit);
+	add(mismatches, Fed9UConfigMismatch::OPTO_RX_INPUT_OFFSET, addr, expected.getOptoRxInputOffset(addr), actual.getOptoRxInputOffset(addr));
+	add(mismatches, Fed9UConfigMismatch::OPTO_RX_OUTPUT_OFFSET, addr, expected.getOptoRxOutputOffset(addr), actual.getOptoRxOutputOffset(addr));
+	add(mismatches, Fed9UConfigMismatch::OPTO_RX_CAPACITOR, addr, expected.getOptoRxCapacitor(addr), actual.getOptoRxCapacitor(addr));
+      }
+    }
+
+    if (sections & (CM_MEDIAN_OVERRIDE | FRONT_END)) {
+      for (u32 feUnit = 0; feUnit < FEUNITS_PER_FED; ++feUnit) {
+	Fed9UAddress addr;
+	addr.setFedFeUnit(feUnit);
+	bool expectedDisable, actualDisable;
+	const vector<u16> expectedMedians(expected.getCmMedianOverride(addr, expectedDisable));
+	const vector<u16> actualMedians(actual.getCmMedianOverride(addr, actualDisable));
+	add(mismatches, Fed9UConfigMismatch::CM_MEDIAN_OVERRIDE_DISABLE, addr, expectedDisable, actualDisable);
+	for (u32 apv = 0; apv < APVS_PER_FEUNIT && apv < expectedMedians.size() && apv < actualMedians.size(); ++apv) {
+	  add(mismatches, Fed9UConfigMismatch::CM_MEDIAN_OVERRIDE, Fed9UAddress(addr).setFeUnitApv(apv), expectedMedians[apv], actualMedians[apv]);
+	}
+      }
+    }
+
+    if (sections & FRONT_END) {
+      //The ADC of a channel pair is off when the four APVs of the pair are disabled. Channel c is paired with channel channelPair[c].
+      const u16 channelPair[CHANNELS_PER_FEUNIT] = {3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8};
+      for (u32 channel = 0; channel < CHANNELS_PER_FED; ++channel) {
+	Fed9UAddress addr;
+	addr.setFedChannel(channel);
+	add(mismatches, Fed9UConfigMismatch::FRAME_THRESHOLD, addr, storedFrameThreshold(expected.getFrameThreshold(addr)), actual.getFrameThreshold(addr));
+
+	const u8 pair = channel - channel % CHANNELS_PER_FEUNIT + channelPair[channel % CHANNELS_PER_FEUNIT];
+	const bool pairDisabled = expected.getApvDisable(Fed9UAddress(static_cast<u8>(channel), 0)) && expected.getApvDisable(Fed9UAddress(static_cast<u8>(channel), 1))
+	  && expected.getApvDisable(Fed9UAddress(pair, 0)) && expected.getApvDisable(Fed9UAddress(pair, 1));
+	if (adcsOn && !pairDisabled) {
+	  const Fed9UAdcControls expectedAdc(expected.getAdcControls(addr)), actualAdc(actual.getAdcControls(addr));
+	  add(mismatches, Fed9UConfigMismatch::ADC_DFSEN, addr, expectedAdc._dfsen, actualAdc._dfsen);
+	  add(mismatches, Fed9UConfigMismatch::ADC_DFSVAL, addr, expectedAdc._dfsval, actualAdc._dfsval);
+	  add(mismatches, Fed9UConfigMismatch::ADC_S1, addr, expectedAdc._s1, actualAdc._s1);
+	  add(mismatches, Fed9UConfigMismatch::ADC_S2, addr, expectedAdc._s2, actualAdc._s2);
+	}
+      }
+      if (adcsOn) {
+	for (u32 apv = 0; apv < APVS_PER_FED; ++apv) {
+	  Fed9UAddress addr;
+	  addr.setFedApv(apv);
+	  add(mismatches, Fed9UConfigMismatch::APV_DISABLE, addr, expected.getApvDisable(addr), actual.getApvDisable(addr));
+	}
+      }
+    }
+
+    if (sections & STRIPS) {
+      const Fed9UStrips& expectedStrips = expected.getFedStrips();
+      const Fed9UStrips& actualStrips = actual.getFedStrips();
+      for (u32 strip = 0; strip < STRIPS_PER_FED; ++strip) {
+	Fed9UAddress addr;
+	addr.setFedStrip(strip);
+	const Fed9UStripDescription& e = expectedStrips.getStrip(addr);
+	const Fed9UStripDescription& a = actualStrips.getStrip(addr);
+	add(mismatches, Fed9UConfigMismatch::PEDESTAL, addr, e.getPedestal(), a.getPedestal());
+	add(mismatches, Fed9UConfigMismatch::STRIP_DISABLE, addr, e.getDisable(), a.getDisable());
+	add(mismatches, Fed9UConfigMismatch::HIGH_THRESHOLD, addr, e.getHighThreshold(), a.getHighThreshold());
+	add(mismatches, Fed9UConfigMismatch::LOW_THRESHOLD, addr, e.getLowThreshold(), a.getLowThreshold());
+      }
+    }
+
+    return mismatches.size() - before;
+  }
+
+  const char* Fed9UConfigVerifier::getFieldName(Fed9UConfigMismatch::Field field) {
+    return field < Fed9UConfigMismatch::FIELDS ? FIELD_NAMES[field] : "unknown setting";
+  }
+
+  void Fed9UConfigVerifier::print(std::ostream& os, const vector<Fed9UConfigMismatch>& mismatches) {
+    for (vector<Fed9UConfigMismatch>::const_iterator it = mismatches.begin(); it != mismatches.end(); ++it) {
+      const Fed9UAddress& addr = it->_address;
+      os << "The " << getFieldName(it->_field) << " setting on the FED does not match that in the theLocalFedSettings";
+      switch (it->_field) {
+      case Fed9UConfigMismatch::FE_UNIT_DISABLE:
+      case Fed9UConfigMismatch::OPTO_RX_INPUT_OFFSET:
+      case Fed9UConfigMismatch::OPTO_RX_OUTPUT_OFFSET:
+      case Fed9UConfigMismatch::OPTO_RX_CAPACITOR:
+      case Fed9UConfigMismatch::CM_MEDIAN_OVERRIDE_DISABLE:
+	os << ", FE unit " << static_cast<int>(addr.getExternalFedFeUnit());
+	break;
+      case Fed9UConfigMismatch::CM_MEDIAN_OVERRIDE:
+	os << ", FE unit " << static_cast<int>(addr.getExternalFedFeUnit()) << " APV " << static_cast<int>(addr.getExternalFeUnitApv());
+	break;
+      case Fed9UConfigMismatch::FRAME_THRESHOLD:
+      case Fed9UConfigMismatch::ADC_DFSEN:
+      case Fed9UConfigMismatch::ADC_DFSVAL:
+      case Fed9UConfigMismatch::ADC_S1:
+      case Fed9UConfigMismatch::ADC_S2:
+	os << ", channel " << static_cast<int>(addr.getExternalFedChannel());
+	break;
+      case Fed9UConfigMismatch::APV_DISABLE:
+	os << ", channel " << static_cast<int>(addr.getExternalFedChannel()) << " APV " << static_cast<int>(addr.getExternalChannelApv());
+	break;
+      case Fed9UConfigMismatch::PEDESTAL:
+      case Fed9UConfigMismatch::STRIP_DISABLE:
+      case Fed9UConfigMismatch::HIGH_THRESHOLD:
+      case Fed9UConfigMismatch::LOW_THRESHOLD:
+	os << ", channel " << static_cast<int>(addr.getExternalFedChannel()) << " APV " << static_cast<int>(addr.getExternalChannelApv())
+	   << " strip " << static_cast<int>(addr.getExternalApvStrip());
+	break;
+      default:
+	break;
+      }
+      os << ": FED " << it->_actual << ", description " << it->_expected << std::endl;
+    }
+  }
+
+}
@@ -0,0 +1,210 @@
+#include "Fed9UDelayScanEngine.hh"
+#include "Fed9UWait.hh"
+#include "ICAssert.hh"
+#include "ICException.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+
+namespace Fed9U {
+
+  using std::vector;
+  using std::string;
+
+  namespace {
+    //The delay range of a channel, 16 coarse steps of 25 ns.
+    const u16 MAX_DELAY = 400;
+    //The FED clock period, used to move the optimal delay back into range.
+    const u16 CLOCK_PERIOD = 25;
+  }
+
+  void Fed9UDelayScanTarget::wait(u32 microseconds) {
+    fed9Uwait(microseconds);
+  }
+
+  Fed9UDelayScanEngine::Fed9UDelayScanEngine(Fed9UDelayScanProbe& probe) :
+    _probe(probe), _coarseStep(CLOCK_PERIOD), _samplingPoint(15), _settleMin(1000), _settleMax(500000), _settleTolerance(2.0),
+    _minimumHeight(50.0), _applyOptimal(true), _steps(0), _measurements(0), _waitTime(0)
+  {
+  }
+
+  Fed9UDelayScanEngine& Fed9UDelayScanEngine::addFed(Fed9UDelayScanTarget& target, const vector<u16>& fedChannels) {
+    FedScan fedScan;
+    fedScan._owner = this;
+    fedScan._fed = _feds.size();
+    fedScan._target = &target;
+    fedScan._fedChannels = fedChannels;
+    if (fedScan._fedChannels.empty()) {
+      for (u16 channel = 0; channel < CHANNELS_PER_FED; ++channel) fedScan._fedChannels.push_back(channel);
+    }
+    for (u32 i = 0; i < fedScan._fedChannels.size(); ++i) {
+      ICUTILS_VERIFY(fedScan._fedChannels[i] < CHANNELS_PER_FED)(fedScan._fedChannels[i]).error().msg("Invalid FED channel");
+    }
+    fedScan._results = NULL;
+    fedScan._error = NULL;
+    _feds.push_back(fedScan);
+    return *this;
+  }
+
+  Fed9UDelayScanEngine& Fed9UDelayScanEngine::setCoarseStep(u16 nanoSeconds) {
+    ICUTILS_VERIFY(nanoSeconds > 1 && nanoSeconds < MAX_DELAY)(nanoSeconds).error().msg("Invalid coarse step");
+    _coarseStep = nanoSeconds;
+    return *this;
+  }
+
+  Fed9UDelayScanEngine& Fed9UDelayScanEngine::setSettle(u32 minMicroseconds, u32 maxMicroseconds, float tolerance) {
+    ICUTILS_VERIFY(minMicroseconds <= maxMicroseconds)(minMicroseconds)(maxMicroseconds).error().msg("Invalid settle times");
+    _settleMin = minMicroseconds;
+    _settleMax = maxMicroseconds;
+    _settleTolerance = tolerance;
+    return *this;
+  }
+
+  u32 Fed9UDelayScanEngine::scan(vector<vector<Fed9UDelayScanResult> >& results, vector<string>& errors) {
+    results.assign(_feds.size(), vector<Fed9UDelayScanResult>());
+    errors.assign(_feds.size(), string());
+    _steps = _measurements = 0;
+    _waitTime = 0;
+
+    vector<bool> running(_feds.size(), false);
+    for (u32 fed = 0; fed < _feds.size(); ++fed) {
+      _feds[fed]._results = &results[fed];
+      _feds[fed]._error = &errors[fed];
+      if (pthread_create(&_feds[fed]._thread, NULL, scanThread, &_feds[fed]) == 0) running[fed] = true;
+      else scanThread(&_feds[fed]);
+    }
+
+    u32 failedFeds = 0;
+    for (u32 fed = 0; fed < _feds.size(); ++fed) {
+      if (running[fed]) pthread_join(_feds[fed]._thread, NULL);
+      bool failed = !errors[fed].empty();
+      for (u32 i = 0; i < results[fed].size(); ++i) failed = failed || !results[fed][i]._found;
+      if (failed) ++failedFeds;
+    }
+    return failedFeds;
+  }
+
+  void* Fed9UDelayScanEngine::scanThread(void* arg) {
+    FedScan& fedScan = *static_cast<FedScan*>(arg);
+    try {
+      fedScan._owner->scanFed(fedScan);
+    }
+    catch (const ICUtils::ICException& e) {
+      *fedScan._error = e.what();
+    }
+    catch (const std::exception& e) {
+      *fedScan._error = e.what();
+    }
+    catch (...) {
+      *fedScan._error = "Caught unknown exception.";
+    }
+    return NULL;
+  }
+
+  void Fed9UDelayScanEngine::step(FedScan& fedScan, const vector<u16>& fedChannels, const vector<u16>& nanoDelays, vector<float>& values) {
+    fedScan._target->setDelays(fedChannels, nanoDelays);
+    __sync_fetch_and_add(&_steps, 1);
+
+    values.resize(fedChannels.size());
+    vector<float> previous(fedChannels.size());
+    u32 wait = _settleMin, waited = 0;
+    bool settled = false;
+    fedScan._target->wait(wait);
+    waited += wait;
+    _probe.measure(fedScan._fed, fedChannels, values);
+    __sync_fetch_and_add(&_measurements, 1);
+    while (!settled && waited < _settleMax) {
+      previous.swap(values);
+      //Wait twice as long as the last time, without going over the maximum.
+      wait = std::min(waited > 0 ? waited : 1, _settleMax - waited);
+      fedScan._target->wait(wait);
+      waited += wait;
+      _probe.measure(fedScan._fed, fedChannels, values);
+      __sync_fetch_and_add(&_measurements, 1);
+      settled = true;
+      for (u32 i = 0; i < values.size() && settled; ++i) settled = std::fabs(values[i] - previous[i]) <= _settleTolerance;
+    }
+    __sync_fetch_and_add(&_waitTime, static_cast<u64>(waited));
+  }
+
+  void Fed9UDelayScanEngine::scanFed(FedScan& fedScan) {
+    const vector<u16>& channels = fedScan._fedChannels;
+    const u32 nChannels = channels.size();
+    vector<Fed9UDelayScanResult>& results = *fedScan._results;
+    results.assign(nChannels, Fed9UDelayScanResult());
+    for (u32 i = 0; i < nChannels; ++i) results[i]._fedChannel = channels[i];
+
+    //Coarse pass: the same delay on all the channels. The last delay of the range is always measured so that an edge
+    //after the last coarse step can still be bracketed.
+    vector<u16> coarseDelays;
+    for (u16 delay = 0; delay < MAX_DELAY; delay += _coarseStep) coarseDelays.push_back(delay);
+    if (coarseDelays.back() != MAX_DELAY - 1) coarseDelays.push_back(MAX_DELAY - 1);
+    vector<vector<float> > coarseValues(coarseDelays.size());
+    for (u32 s = 0; s < coarseDelays.size(); ++s) {
+      step(fedScan, channels, vector<u16>(nChannels, coarseDelays[s]), coarseValues[s]);
+    }
+
+    //The threshold of each channel is the mid point of its baseline and peak. The first rising crossing is bracketed
+    //by the delays low, below the threshold, and high, above it.
+    vector<float> threshold(nChannels);
+    vector<u16> low(nChannels), high(nChannels);
+    vector<u32> active;
+    for (u32 i = 0; i < nChannels; ++i) {
+      Fed9UDelayScanResult& result = results[i];
+      result._baseline = result._peak = coarseValues[0][i];
+      for (u32 s = 1; s < coarseDelays.size(); ++s) {
+	result._baseline = std::min(result._baseline, coarseValues[s][i]);
+	result._peak = std::max(result._peak, coarseValues[s][i]);
+      }
+      if (result._peak - result._baseline < _minimumHeight) continue;
+      threshold[i] = (result._baseline + result._peak) / 2;
+      for (u32 s = 0; s + 1 < coarseDelays.size(); ++s) {
+	if (coarseValues[s][i] < threshold[i] && coarseValues[s+1][i] >= threshold[i]) {
+	  low[i] = coarseDelays[s];
+	  high[i] = coarseDelays[s+1];
+	  result._found = true;
+	  break;
+	}
+      }
+      if (result._found) active.push_back(i);
+    }
+
+    //Fine pass: each channel bisects its own bracket, all the channels still searching are stepped together.
+    vector<u16> stepChannels, stepDelays;
+    vector<float> values;
+    while (true) {
+      stepChannels.clear();
+      stepDelays.clear();
+      vector<u32> stepping;
+      for (u32 a = 0; a < active.size(); ++a) {
+	const u32 i = active[a];
+	if (high[i] - low[i] <= 1) continue;
+	stepping.push_back(i);
+	stepChannels.push_back(channels[i]);
+	stepDelays.push_back((low[i] + high[i]) / 2);
+      }
+      if (stepping.empty()) break;
+      step(fedScan, stepChannels, stepDelays, values);
+      for (u32 j = 0; j < stepping.size(); ++j) {
+	const u32 i = stepping[j];
+	if (values[j] >= threshold[i]) high[i] = stepDelays[j];
+	else low[i] = stepDelays[j];
+      }
+    }
+
+    stepChannels.clear();
+    stepDelays.clear();
+    for (u32 a = 0; a < active.size(); ++a) {
+      Fed9UDelayScanResult& result = results[active[a]];
+      result._edge = high[active[a]];
+      u32 optimal = result._edge + _samplingPoint;
+      while (optimal >= MAX_DELAY) optimal -= CLOCK_PERIOD;
+      result._optimalDelay = optimal;
+      stepChannels.push_back(result._fedChannel);
+      stepDelays.push_back(result._optimalDelay);
+    }
+    if (_applyOptimal && !stepChannels.empty()) fedScan._target->setDelays(stepChannels, stepDelays);
+  }
+
+}
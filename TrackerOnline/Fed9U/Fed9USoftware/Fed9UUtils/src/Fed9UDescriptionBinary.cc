@@ -0,0 +1,520 @@
+#include "Fed9UDescriptionBinary.hh"
+#include "Fed9UDescription.hh"
+#include "Fed9UDescriptionException.hh"
+#include "ICAssert.hh"
+
+#include <iostream>
+#include <cstring>
+
+namespace Fed9U {
+
+  /**************************************************************************************************
+   * Fed9UBinaryWriter
+   *************************************************************************************************/
+
+  Fed9UBinaryWriter& Fed9UBinaryWriter::putU16(u16 value) {
+    _buffer.push_back(static_cast<u8>(value & 0xFF));
+    _buffer.push_back(static_cast<u8>((value >> 8) & 0xFF));
+    return *this;
+  }
+
+  Fed9UBinaryWriter& Fed9UBinaryWriter::putU32(u32 value) {
+    _buffer.push_back(static_cast<u8>(value & 0xFF));
+    _buffer.push_back(static_cast<u8>((value >> 8) & 0xFF));
+    _buffer.push_back(static_cast<u8>((value >> 16) & 0xFF));
+    _buffer.push_back(static_cast<u8>((value >> 24) & 0xFF));
+    return *this;
+  }
+
+  Fed9UBinaryWriter& Fed9UBinaryWriter::putFloat(float value) {
+    u32 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return putU32(bits);
+  }
+
+  Fed9UBinaryWriter& Fed9UBinaryWriter::putString(const std::string& value) {
+    ICUTILS_VERIFY(value.size() <= 0xFFFF)(value.size()).error().msg("String is too long to be stored in a binary description");
+    putU16(static_cast<u16>(value.size()));
+    return putBytes(reinterpret_cast<const u8*>(value.data()), static_cast<u32>(value.size()));
+  }
+
+  Fed9UBinaryWriter& Fed9UBinaryWriter::putBytes(const u8* data, u32 size) {
+    _buffer.insert(_buffer.end(), data, data + size);
+    return *this;
+  }
+
+  void Fed9UBinaryWriter::patchU32(u32 offset, u32 value) {
+    _buffer[offset]   = static_cast<u8>(value & 0xFF);
+    _buffer[offset+1] = static_cast<u8>((value >> 8) & 0xFF);
+    _buffer[offset+2] = static_cast<u8>((value >> 16) & 0xFF);
+    _buffer[offset+3] = static_cast<u8>((value >> 24) & 0xFF);
+  }
+
+  /**************************************************************************************************
+   * Fed9UBinaryReader
+   *************************************************************************************************/
+
+  void Fed9UBinaryReader::require(u32 size) const {
+    ICUTILS_VERIFYX(size <= _size - _pos, Fed9UDescriptionException)(size)(_pos)(_size).error()
+      .code(Fed9UDescriptionException::ERROR_BINARY_FORMAT).msg("Binary description buffer is truncated");
+  }
+
+  u8 Fed9UBinaryReader::getU8() {
+    require(1);
+    return _buffer[_pos++];
+  }
+
+  u16 Fed9UBinaryReader::getU16() {
+    require(2);
+    u16 value = static_cast<u16>(_buffer[_pos] | (_buffer[_pos+1] << 8));
+    _pos += 2;
+    return value;
+  }
+
+  u32 Fed9UBinaryReader::getU32() {
+    require(4);
+    u32 value = static_cast<u32>(_buffer[_pos]) | (static_cast<u32>(_buffer[_pos+1]) << 8) |
+      (static_cast<u32>(_buffer[_pos+2]) << 16) | (static_cast<u32>(_buffer[_pos+3]) << 24);
+    _pos += 4;
+    return value;
+  }
+
+  float Fed9UBinaryReader::getFloat() {
+    u32 bits = getU32();
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+  std::string Fed9UBinaryReader::getString() {
+    u16 length = getU16();
+    require(length);
+    std::string value(reinterpret_cast<const char*>(_buffer + _pos), length);
+    _pos += length;
+    return value;
+  }
+
+  void Fed9UBinaryReader::getBytes(u8* data, u32 size) {
+    require(size);
+    memcpy(data, _buffer + _pos, size);
+    _pos += size;
+  }
+
+  void Fed9UBinaryReader::skip(u32 size) {
+    require(size);
+    _pos += size;
+  }
+
+  /**************************************************************************************************
+   * Fed9UDescriptionBinary
+   *************************************************************************************************/
+
+  namespace {
+
+    //The header is the magic word, the schema version, a reserved flags word, the payload length and the payload checksum.
+    const u32 HEADER_SIZE = 4 + 2 + 2 + 4 + 4;
+
+    //Flags used in the per strip flag byte.
+    const u8 STRIP_DISABLE        = 0x01;
+    const u8 STRIP_FACTORS_REPEAT = 0x02;
+
+    std::string charArrayToString(const char* array, size_t maxSize) {
+      size_t length = 0;
+      while (length < maxSize && array[length] != 0) ++length;
+      return std::string(array, length);
+    }
+
+    void stringToCharArray(const std::string& value, char* array, size_t maxSize) {
+      memset(array, 0, maxSize);
+      memcpy(array, value.data(), (value.size() > maxSize) ? maxSize : value.size());
+    }
+
+    //Starts a section and returns the offset of its length word, which is filled in by endSection.
+    u32 beginSection(Fed9UBinaryWriter& writer, u16 section) {
+      writer.putU16(section);
+      u32 lengthOffset = writer.size();
+      writer.putU32(0);
+      return lengthOffset;
+    }
+
+    void endSection(Fed9UBinaryWriter& writer, u32 lengthOffset) {
+      writer.patchU32(lengthOffset, writer.size() - lengthOffset - 4);
+    }
+
+    void encodeTempControl(const Fed9UTempControl& tempControl, Fed9UBinaryWriter& writer) {
+      writer.putU32(tempControl.getLm82High()).putU32(tempControl.getFpgaHigh()).putU32(tempControl.getCritical());
+    }
+
+    // Fed9UTempControl has a copy constructor but no assignment operator, so it is set in place
+    void decodeTempControl(Fed9UBinaryReader& reader, Fed9UTempControl& tempControl) {
+      tempControl.setLm82High(reader.getU32());
+      tempControl.setFpgaHigh(reader.getU32());
+      tempControl.setCritical(reader.getU32());
+    }
+
+  }
+
+  u32 Fed9UDescriptionBinary::checksum(const u8* data, u32 size) {
+    u32 hash = 2166136261U;
+    for (u32 i = 0; i < size; ++i) {
+      hash ^= data[i];
+      hash *= 16777619U;
+    }
+    return hash;
+  }
+
+  void Fed9UDescriptionBinary::encodeGlobal(const Fed9UDescription& d, Fed9UBinaryWriter& writer) {
+    writer.putString(charArrayToString(d._name, sizeof(d._name)))
+      .putString(charArrayToString(d._fed9UAddressTable, sizeof(d._fed9UAddressTable)))
+      .putString(charArrayToString(d._fakeEventFile, sizeof(d._fakeEventFile)))
+      .putU32(static_cast<u32>(d._busAdaptorType))
+      .putU32(d._feFirmwareVersion)
+      .putU32(d._beFirmwareVersion)
+      .putU32(d._vmeFirmwareVersion)
+      .putU32(d._delayFirmwareVersion)
+      .putU32(d._fedVersion)
+      .putU32(d._epromVersion)
+      .putU32(d._baseAddress)
+      .putU16(d._testRegister)
+      .putU16(d._beUnit)
+      .putBool(d._fedDisable)
+      .putU16(d._fedId)
+      .putU32(d._fedHardwareId)
+      .putU32(static_cast<u32>(d._triggerSource))
+      .putU32(static_cast<u32>(d._readRoute))
+      .putU32(static_cast<u32>(d._clockMode))
+      .putU32(static_cast<u32>(d._fed9UDaqMode))
+      .putU32(static_cast<u32>(d._fed9UDaqSuperMode))
+      .putU16(d._scopeLength)
+      .putU16(d._crateNumber)
+      .putU16(d._vmeControllerDaisyChainId)
+      .putU16(d._globalFineSkew)
+      .putU16(d._globalCoarseSkew)
+      .putU16(d._optoRXResistor)
+      .putU16(d._fakeEventTriggerDelay)
+      .putU16(d._eventType)
+      .putU16(d._fov)
+      .putU32(static_cast<u32>(d._headerType))
+      .putU16(d._bxOffset);
+  }
+
+  void Fed9UDescriptionBinary::decodeGlobal(Fed9UBinaryReader& reader, Fed9UDescription& d) {
+    stringToCharArray(reader.getString(), d._name, sizeof(d._name));
+    stringToCharArray(reader.getString(), d._fed9UAddressTable, sizeof(d._fed9UAddressTable));
+    stringToCharArray(reader.getString(), d._fakeEventFile, sizeof(d._fakeEventFile));
+    d._busAdaptorType = static_cast<Fed9UHalBusAdaptor>(reader.getU32());
+    d._feFirmwareVersion = reader.getU32();
+    d._beFirmwareVersion = reader.getU32();
+    d._vmeFirmwareVersion = reader.getU32();
+    d._delayFirmwareVersion = reader.getU32();
+    d._fedVersion = reader.getU32();
+    d._epromVersion = reader.getU32();
+    d._baseAddress = reader.getU32();
+    d._testRegister = reader.getU16();
+    d._beUnit = reader.getU16();
+    d._fedDisable = reader.getBool();
+    d._fedId = reader.getU16();
+    d._fedHardwareId = reader.getU32();
+    d._triggerSource = static_cast<Fed9UTrigSource>(reader.getU32());
+    d._readRoute = static_cast<Fed9UReadRoute>(reader.getU32());
+    d._clockMode = static_cast<Fed9UClockSource>(reader.getU32());
+    d._fed9UDaqMode = static_cast<Fed9UDaqMode>(reader.getU32());
+    d._fed9UDaqSuperMode = static_cast<Fed9UDaqSuperMode>(reader.getU32());
+    d._scopeLength = reader.getU16();
+    d._crateNumber = reader.getU16();
+    d._vmeControllerDaisyChainId = reader.getU16();
+    d._globalFineSkew = reader.getU16();
+    d._globalCoarseSkew = reader.getU16();
+    d._optoRXResistor = reader.getU16();
+    d._fakeEventTriggerDelay = reader.getU16();
+    d._eventType = reader.getU16();
+    d._fov = reader.getU16();
+    d._headerType = static_cast<Fed9UHeaderFormat>(reader.getU32());
+    d._bxOffset = reader.getU16();
+  }
+
+  void Fed9UDescriptionBinary::encodeFrontEnd(const Fed9UFrontEndDescription& fe, Fed9UBinaryWriter& writer) {
+    for (u32 ch = 0; ch < CHANNELS_PER_FEUNIT; ++ch) {
+      writer.putU16(fe._fineDelay[ch]).putU16(fe._coarseDelay[ch]).putU16(fe._trimDacOffset[ch])
+	.putU16(fe._channelThreshold[ch]).putU16(fe._channelBufferOccupancy[ch]).putBool(fe._complement[ch]);
+    }
+    for (u32 pair = 0; pair < CHANNELS_PER_FEUNIT/2; ++pair) {
+      const Fed9UAdcControls& adc = fe._adcControls[pair];
+      writer.putU8( (adc._dfsen ? 0x1 : 0) | (adc._dfsval ? 0x2 : 0) | (adc._s1 ? 0x4 : 0) | (adc._s2 ? 0x8 : 0) );
+      writer.putU16(fe._fakeEventRandomSeed[pair]).putU16(fe._fakeEventRandomMask[pair]);
+    }
+    for (u32 apv = 0; apv < APVS_PER_FEUNIT; ++apv) {
+      writer.putBool(fe._apvDisable[apv]).putBool(fe._apvFakeEventDisable[apv]).putU16(fe._medianOverride[apv]);
+    }
+    writer.putU16(fe._optoRxOffset).putU16(fe._optoRxCapacitor).putBool(fe._medianOverrideDisable).putBool(fe._feUnitDisable);
+    encodeTempControl(fe._tempControl, writer);
+  }
+
+  void Fed9UDescriptionBinary::decodeFrontEnd(Fed9UBinaryReader& reader, Fed9UFrontEndDescription& fe) {
+    for (u32 ch = 0; ch < CHANNELS_PER_FEUNIT; ++ch) {
+      fe._fineDelay[ch] = reader.getU16();
+      fe._coarseDelay[ch] = reader.getU16();
+      fe._trimDacOffset[ch] = reader.getU16();
+      fe._channelThreshold[ch] = reader.getU16();
+      fe._channelBufferOccupancy[ch] = reader.getU16();
+      fe._complement[ch] = reader.getBool();
+    }
+    for (u32 pair = 0; pair < CHANNELS_PER_FEUNIT/2; ++pair) {
+      u8 adc = reader.getU8();
+      fe._adcControls[pair] = Fed9UAdcControls(adc & 0x1, adc & 0x2, adc & 0x4, adc & 0x8);
+      fe._fakeEventRandomSeed[pair] = reader.getU16();
+      fe._fakeEventRandomMask[pair] = reader.getU16();
+    }
+    for (u32 apv = 0; apv < APVS_PER_FEUNIT; ++apv) {
+      fe._apvDisable[apv] = reader.getBool();
+      fe._apvFakeEventDisable[apv] = reader.getBool();
+      fe._medianOverride[apv] = reader.getU16();
+    }
+    fe._optoRxOffset = reader.getU16();
+    fe._optoRxCapacitor = reader.getU16();
+    fe._medianOverrideDisable = reader.getBool();
+    fe._feUnitDisable = reader.getBool();
+    decodeTempControl(reader, fe._tempControl);
+  }
+
+  void Fed9UDescriptionBinary::encodeStrip(const Fed9UStripDescription& strip, Fed9UBinaryWriter& writer) {
+    writer.putU16(static_cast<u16>(strip.getPedestal())).putU8(strip.getDisable() ? STRIP_DISABLE : 0).putFloat(strip.getNoise())
+      .putFloat(strip.getHighThresholdFactor()).putFloat(strip.getLowThresholdFactor());
+  }
+
+  Fed9UStripDescription Fed9UDescriptionBinary::decodeStrip(Fed9UBinaryReader& reader) {
+    i16 pedestal = static_cast<i16>(reader.getU16());
+    u8 flags = reader.getU8();
+    float noise = reader.getFloat();
+    float high = reader.getFloat();
+    float low = reader.getFloat();
+    return Fed9UStripDescription(pedestal, high, low, noise, flags & STRIP_DISABLE);
+  }
+
+  void Fed9UDescriptionBinary::encodeStrips(const Fed9UDescription& d, Fed9UBinaryWriter& writer) {
+    writer.putU32(STRIPS_PER_FED);
+    Fed9UAddress addr;
+    float lastHigh = 0, lastLow = 0;
+    for (u32 strip = 0; strip < STRIPS_PER_FED; ++strip) {
+      const Fed9UStripDescription& s = d._strips.getStrip(addr.setFedStrip(static_cast<u16>(strip)));
+      u8 flags = s.getDisable() ? STRIP_DISABLE : 0;
+      //The factors are compared bitwise so that the round trip is exact.
+      float high = s.getHighThresholdFactor(), low = s.getLowThresholdFactor();
+      bool repeat = (strip != 0) && !memcmp(&high, &lastHigh, sizeof(float)) && !memcmp(&low, &lastLow, sizeof(float));
+      if (repeat) flags |= STRIP_FACTORS_REPEAT;
+      writer.putU16(static_cast<u16>(s.getPedestal())).putU8(flags).putFloat(s.getNoise());
+      if (!repeat) {
+	writer.putFloat(high).putFloat(low);
+	lastHigh = high;
+	lastLow = low;
+      }
+    }
+  }
+
+  void Fed9UDescriptionBinary::decodeStrips(Fed9UBinaryReader& reader, Fed9UDescription& d) {
+    u32 count = reader.getU32();
+    ICUTILS_VERIFYX(count == STRIPS_PER_FED, Fed9UDescriptionException)(count).error()
+      .code(Fed9UDescriptionException::ERROR_BINARY_FORMAT).msg("Unexpected number of strips in binary description");
+    Fed9UAddress addr;
+    float high = 0, low = 0;
+    for (u32 strip = 0; strip < STRIPS_PER_FED; ++strip) {
+      i16 pedestal = static_cast<i16>(reader.getU16());
+      u8 flags = reader.getU8();
+      float noise = reader.getFloat();
+      if (!(flags & STRIP_FACTORS_REPEAT)) {
+	high = reader.getFloat();
+	low = reader.getFloat();
+      }
+      d._strips.setStrip(addr.setFedStrip(static_cast<u16>(strip)), Fed9UStripDescription(pedestal, high, low, noise, flags & STRIP_DISABLE));
+    }
+  }
+
+  void Fed9UDescriptionBinary::encode(const Fed9UDescription& d, std::vector<u8>& buffer, u32 sections) {
+    buffer.clear();
+    buffer.reserve(HEADER_SIZE + 200*1024);
+    Fed9UBinaryWriter writer(buffer);
+    writer.putU32(FED9U_BINARY_DESCRIPTION_MAGIC).putU16(FED9U_BINARY_DESCRIPTION_VERSION).putU16(0).putU32(0).putU32(0);
+
+    u32 section = 0;
+    if (sections & MASK_GLOBAL) {
+      section = beginSection(writer, SECTION_GLOBAL);
+      encodeGlobal(d, writer);
+      endSection(writer, section);
+    }
+
+    if (sections & MASK_TEMP_CONTROL) {
+      section = beginSection(writer, SECTION_TEMP_CONTROL);
+      encodeTempControl(d._beTempControl, writer);
+      encodeTempControl(d._vmeTempControl, writer);
+      endSection(writer, section);
+    }
+
+    if (sections & MASK_TTCRX) {
+      section = beginSection(writer, SECTION_TTCRX);
+      const Fed9UTtcrxDescription& ttc = d._ttcrxDescription;
+      Fed9UTtcrxCounterReset reset = ttc.getCounterReset();
+      writer.putBool(reset._errorCounters).putBool(reset._bunchCount).putBool(reset._eventCount).putBool(reset._status)
+	.putU16(ttc.getL1AcceptCoarseDelay()).putU16(ttc.getBrcstStrTwoCoarseDelay())
+	.putU16(ttc.getClockDesOneFineDelay()).putU16(ttc.getClockDesTwoFineDelay())
+	.putU16(ttc.getDllPumpCurrent()).putU16(ttc.getPllPumpCurrent())
+	.putU16(ttc.getIacId()).putU16(ttc.getI2cId()).putU16(ttc.getCounterOperation())
+	.putBool(ttc.getHammingCheckingDisable()).putBool(ttc.getDeskewedClock2Selected()).putBool(ttc.getDeskewedClock2Disable())
+	.putBool(ttc.getClockL1AcceptDisable()).putBool(ttc.getParrallelOutputDisable()).putBool(ttc.getSerialBDisable())
+	.putBool(ttc.getNonDeskewedClockDisable());
+      endSection(writer, section);
+    }
+
+    if (sections & MASK_VOLTAGE_CONTROL) {
+      section = beginSection(writer, SECTION_VOLTAGE_CONTROL);
+      const Fed9UVoltageControl& volt = d._voltageController;
+      writer.putBool(volt.getStandBy()).putBool(volt.getResetStatusRegister())
+	.putFloat(volt.get2Point5VoltMax()).putFloat(volt.get2Point5VoltMin())
+	.putFloat(volt.get3Point3VoltMax()).putFloat(volt.get3Point3VoltMin())
+	.putFloat(volt.get5VoltMax()).putFloat(volt.get5VoltMin())
+	.putFloat(volt.get12VoltMax()).putFloat(volt.get12VoltMin())
+	.putFloat(volt.getCoreVoltageMax()).putFloat(volt.getCoreVoltageMin())
+	.putFloat(volt.getSupplyVoltageMax()).putFloat(volt.getSupplyVoltageMin())
+	.putU16(static_cast<u16>(volt.getExternalTempMax())).putU16(static_cast<u16>(volt.getExternalTempMin()))
+	.putU16(static_cast<u16>(volt.getInternalTempMax())).putU16(static_cast<u16>(volt.getInternalTempMin()))
+	.putU16(static_cast<u16>(volt.getTempOffset())).putBool(volt.getOffsetTempSelect());
+      endSection(writer, section);
+    }
+
+    if (sections & MASK_FRONT_END) {
+      for (u16 fe = 0; fe < FEUNITS_PER_FED; ++fe) {
+	section = beginSection(writer, SECTION_FRONT_END);
+	writer.putU16(fe);
+	encodeFrontEnd(d._feParams[fe], writer);
+	endSection(writer, section);
+      }
+    }
+
+    if (sections & MASK_STRIPS) {
+      section = beginSection(writer, SECTION_STRIPS);
+      encodeStrips(d, writer);
+      endSection(writer, section);
+    }
+
+    if (sections & MASK_EPROM) {
+      section = beginSection(writer, SECTION_EPROM);
+      const Fed9UEpromDescription& eprom = d._epromDescription;
+      writer.putU32(eprom.getEpromVersion()).putU32(eprom.getEpromSize());
+      for (u32 offset = 0; offset < eprom.getEpromSize(); ++offset) {
+	writer.putU8(eprom[offset]);
+      }
+      endSection(writer, section);
+    }
+
+    u32 payloadSize = writer.size() - HEADER_SIZE;
+    writer.patchU32(8, payloadSize);
+    writer.patchU32(12, checksum(&buffer[HEADER_SIZE], payloadSize));
+  }
+
+  u32 Fed9UDescriptionBinary::decode(const u8* buffer, u32 size, Fed9UDescription& d) {
+    Fed9UBinaryReader header(buffer, size);
+    u32 magic = header.getU32();
+    ICUTILS_VERIFYX(magic == FED9U_BINARY_DESCRIPTION_MAGIC, Fed9UDescriptionException)(magic).error()
+      .code(Fed9UDescriptionException::ERROR_BINARY_FORMAT).msg("Buffer does not contain a binary Fed9UDescription");
+    u16 version = header.getU16();
+    ICUTILS_VERIFYX(version <= FED9U_BINARY_DESCRIPTION_VERSION, Fed9UDescriptionException)(version)(FED9U_BINARY_DESCRIPTION_VERSION).error()
+      .code(Fed9UDescriptionException::ERROR_BINARY_VERSION).msg("Binary description was written by a newer schema version");
+    header.getU16();
+    u32 payloadSize = header.getU32();
+    u32 expectedChecksum = header.getU32();
+    ICUTILS_VERIFYX(payloadSize <= header.remaining(), Fed9UDescriptionException)(payloadSize)(header.remaining()).error()
+      .code(Fed9UDescriptionException::ERROR_BINARY_FORMAT).msg("Binary description buffer is truncated");
+    u32 actualChecksum = checksum(header.current(), payloadSize);
+    ICUTILS_VERIFYX(actualChecksum == expectedChecksum, Fed9UDescriptionException)(actualChecksum)(expectedChecksum).error()
+      .code(Fed9UDescriptionException::ERROR_BINARY_FORMAT).msg("Binary description checksum mismatch");
+
+    Fed9UBinaryReader reader(header.current(), payloadSize);
+    while (reader.remaining() != 0) {
+      u16 id = reader.getU16();
+      u32 length = reader.getU32();
+      Fed9UBinaryReader section(reader.current(), length);
+      reader.skip(length);
+      switch (id) {
+      case SECTION_GLOBAL:
+	decodeGlobal(section, d);
+	break;
+      case SECTION_TEMP_CONTROL:
+	decodeTempControl(section, d._beTempControl);
+	decodeTempControl(section, d._vmeTempControl);
+	break;
+      case SECTION_TTCRX: {
+	Fed9UTtcrxCounterReset reset;
+	reset._errorCounters = section.getBool();
+	reset._bunchCount = section.getBool();
+	reset._eventCount = section.getBool();
+	reset._status = section.getBool();
+	u16 l1a = section.getU16(), brcst = section.getU16(), desOne = section.getU16(), desTwo = section.getU16();
+	u16 dll = section.getU16(), pll = section.getU16(), iac = section.getU16(), i2c = section.getU16(), counterOp = section.getU16();
+	bool hamming = section.getBool(), clock2Sel = section.getBool(), clock2Dis = section.getBool(), l1aDis = section.getBool();
+	bool parallelDis = section.getBool(), serialBDis = section.getBool(), nonDeskewedDis = section.getBool();
+	d._ttcrxDescription = Fed9UTtcrxDescription(reset, l1a, brcst, desOne, desTwo, dll, pll, iac, i2c, counterOp,
+						    hamming, clock2Sel, clock2Dis, l1aDis, parallelDis, serialBDis, nonDeskewedDis);
+	break;
+      }
+      case SECTION_VOLTAGE_CONTROL: {
+	bool standBy = section.getBool(), resetStatus = section.getBool();
+	float v[12];
+	for (u32 i = 0; i < 12; ++i) v[i] = section.getFloat();
+	i16 t[5];
+	for (u32 i = 0; i < 5; ++i) t[i] = static_cast<i16>(section.getU16());
+	bool offsetSelect = section.getBool();
+	d._voltageController = Fed9UVoltageControl(standBy, resetStatus, v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7], v[8], v[9], v[10], v[11],
+						   t[0], t[1], t[2], t[3], t[4], offsetSelect);
+	break;
+      }
+      case SECTION_FRONT_END: {
+	u16 fe = section.getU16();
+	ICUTILS_VERIFYX(fe < FEUNITS_PER_FED, Fed9UDescriptionException)(fe).error()
+	  .code(Fed9UDescriptionException::ERROR_BINARY_FORMAT).msg("FE unit number out of range in binary description");
+	decodeFrontEnd(section, d._feParams[fe]);
+	break;
+      }
+      case SECTION_STRIPS:
+	decodeStrips(section, d);
+	break;
+      case SECTION_EPROM: {
+	u32 epromVersion = section.getU32();
+	u32 epromSize = section.getU32();
+	Fed9UEpromDescription eprom(epromVersion);
+	ICUTILS_VERIFYX(epromSize == eprom.getEpromSize(), Fed9UDescriptionException)(epromSize)(eprom.getEpromSize()).error()
+	  .code(Fed9UDescriptionException::ERROR_BINARY_FORMAT).msg("Unexpected EPROM size in binary description");
+	for (u32 offset = 0; offset < epromSize; ++offset) {
+	  eprom[offset] = section.getU8();
+	}
+	d._epromDescription = eprom;
+	break;
+      }
+      default:
+	//Unknown sections were added by a later schema and are skipped.
+	break;
+      }
+    }
+    return HEADER_SIZE + payloadSize;
+  }
+
+  void Fed9UDescriptionBinary::saveDescription(const Fed9UDescription& description, std::ostream& os) {
+    std::vector<u8> buffer;
+    encode(description, buffer);
+    os.write(reinterpret_cast<const char*>(&buffer[0]), buffer.size());
+  }
+
+  void Fed9UDescriptionBinary::loadDescription(std::istream& is, Fed9UDescription& description) {
+    std::vector<u8> buffer(HEADER_SIZE);
+    is.read(reinterpret_cast<char*>(&buffer[0]), HEADER_SIZE);
+    ICUTILS_VERIFYX(is.gcount() == static_cast<std::streamsize>(HEADER_SIZE), Fed9UDescriptionException)(is.gcount()).error()
+      .code(Fed9UDescriptionException::ERROR_BINARY_FORMAT).msg("Could not read binary description header");
+    Fed9UBinaryReader header(&buffer[0], HEADER_SIZE);
+    header.skip(8);
+    u32 payloadSize = header.getU32();
+    buffer.resize(HEADER_SIZE + payloadSize);
+    is.read(reinterpret_cast<char*>(&buffer[HEADER_SIZE]), payloadSize);
+    ICUTILS_VERIFYX(is.gcount() == static_cast<std::streamsize>(payloadSize), Fed9UDescriptionException)(is.gcount())(payloadSize).error()
+      .code(Fed9UDescriptionException::ERROR_BINARY_FORMAT).msg("Could not read binary description payload");
+    decode(&buffer[0], static_cast<u32>(buffer.size()), description);
+  }
+
+}
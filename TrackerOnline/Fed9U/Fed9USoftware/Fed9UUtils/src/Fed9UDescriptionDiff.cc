@@ -0,0 +1,274 @@
+#include "Fed9UDescriptionDiff.hh"
+#include "Fed9UDescriptionBinary.hh"
+#include "Fed9UDescription.hh"
+#include "Fed9UDescriptionException.hh"
+#include "ICAssert.hh"
+
+#include <iostream>
+
+namespace Fed9U {
+
+  namespace {
+
+    bool channelEqual(const Fed9UFrontEndDescription& l, const Fed9UFrontEndDescription& r, u32 ch) {
+      const u32 pair = ch / 2;
+      return l._fineDelay[ch] == r._fineDelay[ch] &&
+	l._coarseDelay[ch] == r._coarseDelay[ch] &&
+	l._trimDacOffset[ch] == r._trimDacOffset[ch] &&
+	l._channelThreshold[ch] == r._channelThreshold[ch] &&
+	l._channelBufferOccupancy[ch] == r._channelBufferOccupancy[ch] &&
+	l._complement[ch] == r._complement[ch] &&
+	l._adcControls[pair] == r._adcControls[pair] &&
+	l._fakeEventRandomSeed[pair] == r._fakeEventRandomSeed[pair] &&
+	l._fakeEventRandomMask[pair] == r._fakeEventRandomMask[pair];
+    }
+
+    void copyChannel(Fed9UFrontEndDescription& to, const Fed9UFrontEndDescription& from, u32 ch) {
+      const u32 pair = ch / 2;
+      to._fineDelay[ch] = from._fineDelay[ch];
+      to._coarseDelay[ch] = from._coarseDelay[ch];
+      to._trimDacOffset[ch] = from._trimDacOffset[ch];
+      to._channelThreshold[ch] = from._channelThreshold[ch];
+      to._channelBufferOccupancy[ch] = from._channelBufferOccupancy[ch];
+      to._complement[ch] = from._complement[ch];
+      to._adcControls[pair] = from._adcControls[pair];
+      to._fakeEventRandomSeed[pair] = from._fakeEventRandomSeed[pair];
+      to._fakeEventRandomMask[pair] = from._fakeEventRandomMask[pair];
+    }
+
+    bool apvEqual(const Fed9UFrontEndDescription& l, const Fed9UFrontEndDescription& r, u32 apv) {
+      return l._apvDisable[apv] == r._apvDisable[apv] &&
+	l._apvFakeEventDisable[apv] == r._apvFakeEventDisable[apv] &&
+	l._medianOverride[apv] == r._medianOverride[apv];
+    }
+
+    void copyApv(Fed9UFrontEndDescription& to, const Fed9UFrontEndDescription& from, u32 apv) {
+      to._apvDisable[apv] = from._apvDisable[apv];
+      to._apvFakeEventDisable[apv] = from._apvFakeEventDisable[apv];
+      to._medianOverride[apv] = from._medianOverride[apv];
+    }
+
+    bool unitEqual(const Fed9UFrontEndDescription& l, const Fed9UFrontEndDescription& r) {
+      return l._optoRxOffset == r._optoRxOffset &&
+	l._optoRxCapacitor == r._optoRxCapacitor &&
+	l._medianOverrideDisable == r._medianOverrideDisable &&
+	l._feUnitDisable == r._feUnitDisable &&
+	l._tempControl == r._tempControl;
+    }
+
+    void copyUnit(Fed9UFrontEndDescription& to, const Fed9UFrontEndDescription& from) {
+      to._optoRxOffset = from._optoRxOffset;
+      to._optoRxCapacitor = from._optoRxCapacitor;
+      to._medianOverrideDisable = from._medianOverrideDisable;
+      to._feUnitDisable = from._feUnitDisable;
+      // Fed9UTempControl has no assignment operator
+      to._tempControl.setLm82High(from._tempControl.getLm82High()).setFpgaHigh(from._tempControl.getFpgaHigh())
+	.setCritical(from._tempControl.getCritical());
+    }
+
+  }
+
+  Fed9UDescriptionDiff::Fed9UDescriptionDiff() {
+  }
+
+  Fed9UDescriptionDiff::Fed9UDescriptionDiff(const Fed9UDescription& from, const Fed9UDescription& to) {
+    compare(from, to);
+  }
+
+  void Fed9UDescriptionDiff::compare(const Fed9UDescription& from, const Fed9UDescription& to) {
+    _settings.clear();
+    _feUnits.clear();
+    _strips.clear();
+
+    //The FED wide settings are compared through their binary encoding, which covers every field exactly.
+    std::vector<u8> fromSettings;
+    Fed9UDescriptionBinary::encode(from, fromSettings, Fed9UDescriptionBinary::MASK_SETTINGS);
+    Fed9UDescriptionBinary::encode(to, _settings, Fed9UDescriptionBinary::MASK_SETTINGS);
+    if (fromSettings == _settings) {
+      _settings.clear();
+    }
+
+    Fed9UAddress addr;
+    for (u16 fe = 0; fe < FEUNITS_PER_FED; ++fe) {
+      addr.setFedFeUnit(fe);
+      FeUnitChange change;
+      change._feUnit = fe;
+      change._to = to.getFrontEndDescription(addr);
+      const Fed9UFrontEndDescription fromFe = from.getFrontEndDescription(addr);
+      change._unitChanged = !unitEqual(fromFe, change._to);
+      change._channelMask = 0;
+      change._apvMask = 0;
+      for (u32 ch = 0; ch < CHANNELS_PER_FEUNIT; ++ch) {
+	if (!channelEqual(fromFe, change._to, ch)) change._channelMask |= (1 << ch);
+      }
+      for (u32 apv = 0; apv < APVS_PER_FEUNIT; ++apv) {
+	if (!apvEqual(fromFe, change._to, apv)) change._apvMask |= (1 << apv);
+      }
+      if (change._unitChanged || change._channelMask || change._apvMask) {
+	_feUnits.push_back(change);
+      }
+    }
+
+    const Fed9UStrips& fromStrips = from.getFedStrips();
+    const Fed9UStrips& toStrips = to.getFedStrips();
+    for (u32 strip = 0; strip < STRIPS_PER_FED; ++strip) {
+      addr.setFedStrip(static_cast<u16>(strip));
+      const Fed9UStripDescription& toStrip = toStrips.getStrip(addr);
+      if (fromStrips.getStrip(addr) != toStrip) {
+	_strips.push_back(std::make_pair(static_cast<u16>(strip), toStrip));
+      }
+    }
+  }
+
+  bool Fed9UDescriptionDiff::empty() const {
+    return _settings.empty() && _feUnits.empty() && _strips.empty();
+  }
+
+  std::vector<Fed9UAddress> Fed9UDescriptionDiff::getChangedFeUnits() const {
+    std::vector<Fed9UAddress> result;
+    for (std::vector<FeUnitChange>::const_iterator it = _feUnits.begin(); it != _feUnits.end(); ++it) {
+      if (it->_unitChanged) result.push_back(Fed9UAddress().setFedFeUnit(it->_feUnit));
+    }
+    return result;
+  }
+
+  std::vector<Fed9UAddress> Fed9UDescriptionDiff::getChangedChannels() const {
+    std::vector<Fed9UAddress> result;
+    for (std::vector<FeUnitChange>::const_iterator it = _feUnits.begin(); it != _feUnits.end(); ++it) {
+      for (u32 ch = 0; ch < CHANNELS_PER_FEUNIT; ++ch) {
+	if (it->_channelMask & (1 << ch)) result.push_back(Fed9UAddress().setFedFeUnit(it->_feUnit).setFeUnitChannel(ch));
+      }
+    }
+    return result;
+  }
+
+  std::vector<Fed9UAddress> Fed9UDescriptionDiff::getChangedApvs() const {
+    std::vector<Fed9UAddress> result;
+    for (std::vector<FeUnitChange>::const_iterator it = _feUnits.begin(); it != _feUnits.end(); ++it) {
+      for (u32 apv = 0; apv < APVS_PER_FEUNIT; ++apv) {
+	if (it->_apvMask & (1 << apv)) result.push_back(Fed9UAddress().setFedFeUnit(it->_feUnit).setFeUnitApv(apv));
+      }
+    }
+    return result;
+  }
+
+  std::vector<Fed9UAddress> Fed9UDescriptionDiff::getChangedStrips() const {
+    std::vector<Fed9UAddress> result;
+    result.reserve(_strips.size());
+    for (std::vector<std::pair<u16, Fed9UStripDescription> >::const_iterator it = _strips.begin(); it != _strips.end(); ++it) {
+      result.push_back(Fed9UAddress().setFedStrip(it->first));
+    }
+    return result;
+  }
+
+  void Fed9UDescriptionDiff::apply(Fed9UDescription& description) const {
+    if (!_settings.empty()) {
+      Fed9UDescriptionBinary::decode(&_settings[0], static_cast<u32>(_settings.size()), description);
+    }
+
+    Fed9UAddress addr;
+    for (std::vector<FeUnitChange>::const_iterator it = _feUnits.begin(); it != _feUnits.end(); ++it) {
+      addr.setFedFeUnit(it->_feUnit);
+      Fed9UFrontEndDescription fe = description.getFrontEndDescription(addr);
+      if (it->_unitChanged) copyUnit(fe, it->_to);
+      for (u32 ch = 0; ch < CHANNELS_PER_FEUNIT; ++ch) {
+	if (it->_channelMask & (1 << ch)) copyChannel(fe, it->_to, ch);
+      }
+      for (u32 apv = 0; apv < APVS_PER_FEUNIT; ++apv) {
+	if (it->_apvMask & (1 << apv)) copyApv(fe, it->_to, apv);
+      }
+      description.setFrontEndDescription(addr, fe);
+    }
+
+    Fed9UStrips& strips = description.getFedStrips();
+    for (std::vector<std::pair<u16, Fed9UStripDescription> >::const_iterator it = _strips.begin(); it != _strips.end(); ++it) {
+      strips.setStrip(addr.setFedStrip(it->first), it->second);
+    }
+  }
+
+  void Fed9UDescriptionDiff::encode(std::vector<u8>& buffer) const {
+    buffer.clear();
+    Fed9UBinaryWriter writer(buffer);
+    writer.putU32(FED9U_BINARY_DIFF_MAGIC).putU16(FED9U_BINARY_DESCRIPTION_VERSION).putU16(0);
+    writer.putU32(static_cast<u32>(_settings.size()));
+    if (!_settings.empty()) writer.putBytes(&_settings[0], static_cast<u32>(_settings.size()));
+    writer.putU16(static_cast<u16>(_feUnits.size()));
+    for (std::vector<FeUnitChange>::const_iterator it = _feUnits.begin(); it != _feUnits.end(); ++it) {
+      writer.putU16(it->_feUnit).putBool(it->_unitChanged).putU16(it->_channelMask).putU32(it->_apvMask);
+      Fed9UDescriptionBinary::encodeFrontEnd(it->_to, writer);
+    }
+    writer.putU32(static_cast<u32>(_strips.size()));
+    for (std::vector<std::pair<u16, Fed9UStripDescription> >::const_iterator it = _strips.begin(); it != _strips.end(); ++it) {
+      writer.putU16(it->first);
+      Fed9UDescriptionBinary::encodeStrip(it->second, writer);
+    }
+  }
+
+  u32 Fed9UDescriptionDiff::decode(const u8* buffer, u32 size) {
+    Fed9UBinaryReader reader(buffer, size);
+    u32 magic = reader.getU32();
+    ICUTILS_VERIFYX(magic == FED9U_BINARY_DIFF_MAGIC, Fed9UDescriptionException)(magic).error()
+      .code(Fed9UDescriptionException::ERROR_BINARY_FORMAT).msg("Buffer does not contain a binary Fed9UDescriptionDiff");
+    u16 version = reader.getU16();
+    ICUTILS_VERIFYX(version <= FED9U_BINARY_DESCRIPTION_VERSION, Fed9UDescriptionException)(version).error()
+      .code(Fed9UDescriptionException::ERROR_BINARY_VERSION).msg("Binary diff was written by a newer schema version");
+    reader.getU16();
+
+    std::vector<u8> settings(reader.getU32());
+    if (!settings.empty()) reader.getBytes(&settings[0], static_cast<u32>(settings.size()));
+
+    std::vector<FeUnitChange> feUnits(reader.getU16());
+    for (std::vector<FeUnitChange>::iterator it = feUnits.begin(); it != feUnits.end(); ++it) {
+      it->_feUnit = reader.getU16();
+      ICUTILS_VERIFYX(it->_feUnit < FEUNITS_PER_FED, Fed9UDescriptionException)(it->_feUnit).error()
+	.code(Fed9UDescriptionException::ERROR_BINARY_FORMAT).msg("FE unit number out of range in binary diff");
+      it->_unitChanged = reader.getBool();
+      it->_channelMask = reader.getU16();
+      it->_apvMask = reader.getU32();
+      Fed9UDescriptionBinary::decodeFrontEnd(reader, it->_to);
+    }
+
+    std::vector<std::pair<u16, Fed9UStripDescription> > strips(reader.getU32());
+    for (std::vector<std::pair<u16, Fed9UStripDescription> >::iterator it = strips.begin(); it != strips.end(); ++it) {
+      it->first = reader.getU16();
+      ICUTILS_VERIFYX(it->first < STRIPS_PER_FED, Fed9UDescriptionException)(it->first).error()
+	.code(Fed9UDescriptionException::ERROR_BINARY_FORMAT).msg("Strip number out of range in binary diff");
+      it->second = Fed9UDescriptionBinary::decodeStrip(reader);
+    }
+
+    _settings.swap(settings);
+    _feUnits.swap(feUnits);
+    _strips.swap(strips);
+    return reader.position();
+  }
+
+  void Fed9UDescriptionDiff::printSummary(std::ostream& os) const {
+    if (empty()) {
+      os << "No differences" << std::endl;
+      return;
+    }
+    if (getGlobalChanged()) {
+      os << "FED settings changed" << std::endl;
+    }
+    std::vector<Fed9UAddress> items = getChangedFeUnits();
+    for (std::vector<Fed9UAddress>::const_iterator it = items.begin(); it != items.end(); ++it) {
+      os << "FE unit " << static_cast<u16>(it->getExternalFedFeUnit()) << " changed" << std::endl;
+    }
+    items = getChangedChannels();
+    for (std::vector<Fed9UAddress>::const_iterator it = items.begin(); it != items.end(); ++it) {
+      os << "FE unit " << static_cast<u16>(it->getExternalFedFeUnit()) << " channel " << static_cast<u16>(it->getExternalFeUnitChannel()) << " changed" << std::endl;
+    }
+    items = getChangedApvs();
+    for (std::vector<Fed9UAddress>::const_iterator it = items.begin(); it != items.end(); ++it) {
+      os << "FE unit " << static_cast<u16>(it->getExternalFedFeUnit()) << " channel " << static_cast<u16>(it->getExternalFeUnitChannel())
+	 << " APV " << static_cast<u16>(it->getExternalChannelApv()) << " changed" << std::endl;
+    }
+    os << _strips.size() << " strips changed" << std::endl;
+  }
+
+  std::ostream& operator<<(std::ostream& os, const Fed9UDescriptionDiff& diff) {
+    diff.printSummary(os);
+    return os;
+  }
+
+}
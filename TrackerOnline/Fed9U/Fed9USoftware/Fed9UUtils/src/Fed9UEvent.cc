@@ -884,7 +884,6 @@ namespace Fed9U {
           } else { // Proc raw, VR, SCOPE, etc. use samples to return number of samples
         //ret.resize(samples());
         for (u16 i = 0; i < samples(); i++) {
-          std::cout << i << " " << destBuf[i] << std::endl;
           destBuf[i] = _data.getu16(i*2+3);
         }
       }    
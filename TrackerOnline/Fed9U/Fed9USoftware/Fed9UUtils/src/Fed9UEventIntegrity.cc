@@ -0,0 +1,273 @@
+#include "Fed9UEventIntegrity.hh"
+#include "Fed9UDescription.hh"
+#include "Fed9UAddress.hh"
+#include "Fed9UCrc.hh"
+
+#include <cstring>
+
+namespace Fed9U {
+
+  namespace {
+
+    /**
+     * Tracker event types accepted by Fed9UEventStreamLine::checkEvent.
+     */
+    bool isKnownEventType(u8 type) {
+      switch (type) {
+      case 1: case 2: case 3: case 6: case 7: case 10: case 11: case 12: case 13:
+	return true;
+      default:
+	return false;
+      }
+    }
+
+    /**
+     * 64-bit word of the FE header in the order used by Fed9UEventUnitStreamLine::getFeUnitHeader: the byte 0 of the
+     * status is the byte 0 of the second 32-bit word.
+     */
+    inline u64 getHeaderWord(const u32* words) {
+      return static_cast<u64>(words[1]) | (static_cast<u64>(words[0]) << 32);
+    }
+
+    /**
+     * Gathers the bit k of the 12 channel fields of a FE unit status into a 12-bit mask.
+     * The status is given as 64 + 64 bits, the fields are width bits wide.
+     */
+    inline u32 gatherChannels(u64 low, u64 high, u32 width, u32 k) {
+      u32 mask = 0;
+      for (u32 c = 0; c < CHANNELS_PER_FEUNIT; ++c) {
+	u32 bit = c * width + k;
+	mask |= static_cast<u32>(((bit < 64) ? (low >> bit) : (high >> (bit - 64))) & 0x1) << c;
+      }
+      return mask;
+    }
+
+    /**
+     * Sets the 12 bits of the channels of the FE unit at position f in a 96-bit channel mask.
+     */
+    inline void setChannels(u64* mask, u32 f, u32 channels) {
+      u32 bit = f * CHANNELS_PER_FEUNIT;
+      if (bit < 64) {
+	mask[0] |= static_cast<u64>(channels) << bit;
+	if (bit + CHANNELS_PER_FEUNIT > 64) {mask[1] |= static_cast<u64>(channels) >> (64 - bit);}
+      } else {
+	mask[1] |= static_cast<u64>(channels) << (bit - 64);
+      }
+    }
+
+    /**
+     * Returns the 12 bits of the channels of the FE unit at position f in a 96-bit channel mask.
+     */
+    inline u32 getChannels(const u64* mask, u32 f) {
+      u32 bit = f * CHANNELS_PER_FEUNIT;
+      u64 channels = (bit < 64) ? (mask[0] >> bit) : (mask[1] >> (bit - 64));
+      if ((bit < 64) && (bit + CHANNELS_PER_FEUNIT > 64)) {channels |= mask[1] << (64 - bit);}
+      return static_cast<u32>(channels) & 0xFFF;
+    }
+
+  }
+
+  void Fed9UEventIntegrity::clear() {
+    _errors = 0;
+    memset(_feUnits, 0, sizeof(_feUnits));
+    memset(_channels, 0, sizeof(_channels));
+  }
+
+  Fed9UEventIntegrityChecker::Fed9UEventIntegrityChecker(const Fed9UDescription* description, bool checkCrc) :
+    _checkCrc(checkCrc), _checkDisabled(false), _checkStatus(true), _feUnits(0xFF) {
+    _channels[0] = ~0ULL;
+    _channels[1] = (1ULL << (CHANNELS_PER_FED - 64)) - 1;
+
+    if (description != NULL) {
+      // same selection as Fed9UEventStreamLine::checkChannelStatuses
+      _checkDisabled = true;
+      _checkStatus = description->getDaqMode() != FED9U_MODE_SCOPE;
+      _feUnits = 0;
+      _channels[0] = _channels[1] = 0;
+      Fed9UAddress addr;
+      for (u32 f = 0; f < FEUNITS_PER_FED; ++f) {
+	if (description->getFedFeUnitDisable(addr.setFedFeUnit(f))) {continue;}
+	_feUnits |= 1 << f;
+	u32 channels = 0;
+	for (u32 c = 0; c < CHANNELS_PER_FEUNIT; ++c) {
+	  if ( !description->getApvDisable(addr.setFeUnitChannel(c).setChannelApv(true)) &&
+	       !description->getApvDisable(addr.setChannelApv(false)) ) {
+	    channels |= 1 << c;
+	  }
+	}
+	setChannels(_channels, f, channels);
+      }
+    }
+  }
+
+  bool Fed9UEventIntegrityChecker::check(const u32* buffer, u32 words, Fed9UEventIntegrity& integrity) const {
+
+    integrity.clear();
+    const u8* bytes = reinterpret_cast<const u8*>(buffer);
+    const u32 totalBytes = words * 4;
+
+    // DAQ header and tracker-specific header, the decision is the same as in Fed9UEventStreamLine::Init
+    if (words < 4) {
+      integrity._errors |= Fed9UEventIntegrity::ERROR_TRUNCATED;
+      return false;
+    }
+    const bool legacy = (bytes[11] != 0xED) && (bytes[11] != 0xC5);
+    const bool oldVme = (bytes[11] != 0xC5);
+    const u32 headerFormat = legacy ? static_cast<u32>(FED9U_HEADER_FULLDEBUG) : static_cast<u32>(bytes[10] >> 4);
+    const u8 eventType = legacy ? 0 : (bytes[10] & 0xF);
+    const u8 feEnable = legacy ? 0xFF : bytes[15];
+    if ((headerFormat != FED9U_HEADER_FULLDEBUG) && (headerFormat != FED9U_HEADER_APVERROR)) {
+      integrity._errors |= Fed9UEventIntegrity::ERROR_HEADER;
+      return false;
+    }
+    if (!legacy) {
+      if (!isKnownEventType(eventType)) {integrity._errors |= Fed9UEventIntegrity::ERROR_EVENT_TYPE;}
+      integrity._feUnits[Fed9UEventIntegrity::FE_OVERFLOW] = bytes[14] & feEnable;
+      integrity._feUnits[Fed9UEventIntegrity::APV_ADDRESS] = ~bytes[8] & feEnable;
+    }
+    if (_checkDisabled) {integrity._feUnits[Fed9UEventIntegrity::FE_MISSING] = _feUnits & ~feEnable;}
+
+    const u32 feHeader = legacy ? 2 : 4;
+    const bool fullDebug = (headerFormat == FED9U_HEADER_FULLDEBUG);
+    const u32 payload = feHeader + (fullDebug ? FEUNITS_PER_FED * 4 : (FEUNITS_PER_FED * 3) / 4);
+    if (words < payload) {
+      integrity._errors |= Fed9UEventIntegrity::ERROR_TRUNCATED;
+      return false;
+    }
+
+    // Channel statuses, an FE unit without error is accepted with one comparison
+    const u8 checkedUnits = feEnable & _feUnits;
+    if (_checkStatus && (eventType != 1)) {
+      u64 apvErrorHeader[3] = { 0, 0, 0 };
+      if (!fullDebug) {
+	for (u32 i = 0; i < 3; ++i) {apvErrorHeader[i] = getHeaderWord(buffer + feHeader + 2 * i);}
+      }
+      for (u32 f = 0; f < FEUNITS_PER_FED; ++f) {
+	if (!((checkedUnits >> f) & 0x1)) {continue;}
+	const u32 checked = getChannels(_channels, f);
+	if (fullDebug) {
+	  const u32* fe = buffer + feHeader + 4 * f;
+	  const u64 low = ~getHeaderWord(fe);
+	  const u64 high = ~fe[3] & 0xFF;
+	  if ((low | high) == 0) {continue;}
+	  setChannels(integrity._channels[Fed9UEventIntegrity::APV_ERROR], f, checked & (gatherChannels(low, high, 6, 0) | gatherChannels(low, high, 6, 2)));
+	  setChannels(integrity._channels[Fed9UEventIntegrity::APV_HEADER], f, checked & (gatherChannels(low, high, 6, 1) | gatherChannels(low, high, 6, 3)));
+	  setChannels(integrity._channels[Fed9UEventIntegrity::OUT_OF_SYNC], f, checked & gatherChannels(low, high, 6, 4));
+	  setChannels(integrity._channels[Fed9UEventIntegrity::UNLOCKED], f, checked & gatherChannels(low, high, 6, 5));
+	} else {
+	  // 2 bits per channel, the 24 bits of the FE unit may be in two 64-bit words
+	  const u32 bit = f * 24, shift = bit % 64;
+	  u64 status = apvErrorHeader[bit / 64] >> shift;
+	  if (shift > 40) {status |= apvErrorHeader[bit / 64 + 1] << (64 - shift);}
+	  status = ~status & 0xFFFFFF;
+	  if (status == 0) {continue;}
+	  setChannels(integrity._channels[Fed9UEventIntegrity::APV_ERROR], f, checked & (gatherChannels(status, 0, 2, 0) | gatherChannels(status, 0, 2, 1)));
+	}
+      }
+    }
+
+    // Lengths of the FE units, as in Fed9UEventUnitStreamLine (channel lengths are read in the payload)
+    u32 offset = payload * 4;
+    for (u32 f = 0; f < FEUNITS_PER_FED; ++f) {
+      if (!((feEnable >> f) & 0x1)) {continue;}
+      u32 unitLength = 0;
+      for (u32 c = 0; c < CHANNELS_PER_FEUNIT; ++c) {
+	const u32 location = offset + unitLength;
+	if ((location | 3) >= totalBytes) {
+	  integrity._errors |= Fed9UEventIntegrity::ERROR_TRUNCATED;
+	  break;
+	}
+	unitLength += ((bytes[(location + 1) ^ 3] & 0xF) << 8) | bytes[location ^ 3];
+      }
+      if (integrity._errors & Fed9UEventIntegrity::ERROR_TRUNCATED) {break;}
+      if (fullDebug && !legacy && ((buffer[feHeader + 4 * f + 2] >> 16) != (unitLength & 0xFFFF))) {
+	integrity._feUnits[Fed9UEventIntegrity::FE_LENGTH] |= 1 << f;
+      }
+      offset += unitLength;
+      if (offset % 8) {offset += 8 - (offset % 8);}
+    }
+
+    // DAQ trailer, skipping the words with the continuation bit
+    if (!(integrity._errors & Fed9UEventIntegrity::ERROR_TRUNCATED)) {
+      const u32 bufferLength = offset;
+      u32 trailer = offset;
+      while ((trailer + 8 <= totalBytes) && (bytes[trailer + (oldVme ? 4 : 0)] & 0x8)) {trailer += 8;}
+      if (trailer + 8 > totalBytes) {
+	integrity._errors |= Fed9UEventIntegrity::ERROR_TRUNCATED;
+      } else {
+	const u8* t = bytes + trailer;
+	if ((t[oldVme ? 3 : 7] >> 4) != 0xA) {integrity._errors |= Fed9UEventIntegrity::ERROR_TRAILER;}
+	const u32 length = oldVme ? (t[0] | (t[1] << 8) | (t[2] << 16)) : (t[4] | (t[5] << 8) | (t[6] << 16));
+	if (8 * length != bufferLength + 8) {integrity._errors |= Fed9UEventIntegrity::ERROR_LENGTH;}
+	if (_checkCrc) {
+	  const u16 crc = oldVme ? (t[6] | (t[7] << 8)) : (t[2] | (t[3] << 8));
+	  if ((bufferLength + 8 <= totalBytes) && (crc != calculateFEDBufferCRC(bytes, bufferLength + 8, oldVme))) {
+	    integrity._errors |= Fed9UEventIntegrity::ERROR_CRC;
+	  }
+	}
+      }
+    }
+
+    for (u32 v = 0; v < Fed9UEventIntegrity::FE_VIOLATIONS; ++v) {
+      if (integrity._feUnits[v]) {integrity._errors |= Fed9UEventIntegrity::ERROR_FE_UNIT;}
+    }
+    for (u32 v = 0; v < Fed9UEventIntegrity::CHANNEL_VIOLATIONS; ++v) {
+      if (integrity._channels[v][0] | integrity._channels[v][1]) {integrity._errors |= Fed9UEventIntegrity::ERROR_CHANNEL;}
+    }
+    return integrity.isOk();
+  }
+
+  void Fed9UEventErrorStatistics::add(const Fed9UEventIntegrity& integrity) {
+    ++_events;
+    if (integrity.isOk()) {return;}
+    ++_errorEvents;
+    for (u32 i = 0; i < EVENT_ERRORS; ++i) {
+      if ((integrity._errors >> i) & 0x1) {++_eventErrors[i];}
+    }
+    for (u32 v = 0; v < Fed9UEventIntegrity::FE_VIOLATIONS; ++v) {
+      for (u32 f = 0; f < FEUNITS_PER_FED; ++f) {
+	if ((integrity._feUnits[v] >> f) & 0x1) {++_feUnits[v][f];}
+      }
+    }
+    for (u32 v = 0; v < Fed9UEventIntegrity::CHANNEL_VIOLATIONS; ++v) {
+      for (u32 w = 0; w < 2; ++w) {
+	for (u64 mask = integrity._channels[v][w]; mask != 0; mask &= mask - 1) {
+	  ++_channels[v][64 * w + __builtin_ctzll(mask)];
+	}
+      }
+      for (u32 f = 0; f < FEUNITS_PER_FED; ++f) {
+	if (getChannels(integrity._channels[v], f)) {++_feUnitChannels[v][f];}
+      }
+    }
+  }
+
+  void Fed9UEventErrorStatistics::merge(const Fed9UEventErrorStatistics& statistics) {
+    _events += statistics._events;
+    _errorEvents += statistics._errorEvents;
+    for (u32 i = 0; i < EVENT_ERRORS; ++i) {_eventErrors[i] += statistics._eventErrors[i];}
+    for (u32 v = 0; v < Fed9UEventIntegrity::FE_VIOLATIONS; ++v) {
+      for (u32 f = 0; f < FEUNITS_PER_FED; ++f) {_feUnits[v][f] += statistics._feUnits[v][f];}
+    }
+    for (u32 v = 0; v < Fed9UEventIntegrity::CHANNEL_VIOLATIONS; ++v) {
+      for (u32 f = 0; f < FEUNITS_PER_FED; ++f) {_feUnitChannels[v][f] += statistics._feUnitChannels[v][f];}
+      for (u32 c = 0; c < CHANNELS_PER_FED; ++c) {_channels[v][c] += statistics._channels[v][c];}
+    }
+  }
+
+  void Fed9UEventErrorStatistics::reset() {
+    _events = _errorEvents = 0;
+    memset(_eventErrors, 0, sizeof(_eventErrors));
+    memset(_feUnits, 0, sizeof(_feUnits));
+    memset(_feUnitChannels, 0, sizeof(_feUnitChannels));
+    memset(_channels, 0, sizeof(_channels));
+  }
+
+  u32 Fed9UEventErrorStatistics::getEventErrors(u32 error) const {
+    if (error == 0) {return _errorEvents;}
+    for (u32 i = 0; i < EVENT_ERRORS; ++i) {
+      if (error == (1U << i)) {return _eventErrors[i];}
+    }
+    return 0;
+  }
+
+}
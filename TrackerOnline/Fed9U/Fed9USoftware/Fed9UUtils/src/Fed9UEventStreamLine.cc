@@ -345,6 +345,11 @@ namespace Fed9U {
     }
   }
 
+  bool Fed9UEventStreamLine::checkIntegrity(Fed9UEventIntegrity & integrity) const {
+    Fed9UEventIntegrityChecker checker(_fedDescription);
+    return checker.check(_buffer, (_bufferLength + _rubbish + 8) / 4, integrity);
+  }
+
   // JEC 10/08/06 - return the number of FE-units
   u32 Fed9UEventStreamLine::enabledFeUnits() const {
     u32 numberOfEnabledFeUnits = 0;
@@ -35,7 +35,6 @@ namespace Fed9U {
       _trimDacOffset[i] = trim;
       _channelThreshold[i] = channelThreshold;
       _channelBufferOccupancy[i] = channelBufferOccupancy;
-      _adcControls[i] = adcControls;
       _complement[i] = complement;
     }
     for(int i=0; i<APVS_PER_FEUNIT; i++) {  
@@ -46,6 +45,7 @@ namespace Fed9U {
       _medianOverride[i] = median;
     }  
     for (int i=0; i<CHANNELS_PER_FEUNIT/2; i++) {
+      _adcControls[i] = adcControls;
       _fakeEventRandomSeed[i] = fakeEventRandomSeed;
       _fakeEventRandomMask[i] = fakeEventRandomMask;
     }
@@ -160,9 +160,9 @@ namespace Fed9U {
       if (l._channelThreshold[c] != r._channelThreshold[c]) return false;
       if (l._channelBufferOccupancy[c] != r._channelBufferOccupancy[c]) return false;
       if (l._complement[c] != r._complement[c]) return false;
-      if (l._adcControls[c] != r._adcControls[c]) return false;
     }
     for (int cp=0; cp<CHANNELS_PER_FEUNIT/2; cp++) {
+      if (l._adcControls[cp] != r._adcControls[cp]) return false;
       if (l._fakeEventRandomSeed[cp] != r._fakeEventRandomSeed[cp]) return false;
       if (l._fakeEventRandomMask[cp] != r._fakeEventRandomMask[cp]) return false;
     }
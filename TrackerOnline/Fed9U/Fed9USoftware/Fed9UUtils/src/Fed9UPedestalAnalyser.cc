@@ -0,0 +1,265 @@
+#include "Fed9UPedestalAnalyser.hh"
+#include "Fed9UEvent.hh"
+#include "Fed9USiStripReordering.hh"
+#include "Fed9UStrips.hh"
+#include "ICAssert.hh"
+#include "ICException.hh"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <iostream>
+
+namespace Fed9U {
+
+  using std::vector;
+
+  namespace {
+
+    /**
+     * Number of events accumulated before the common mode corrected noise is measured.
+     */
+    const u32 COMMON_MODE_WARMUP = 20;
+
+    /**
+     * Median of a buffer, which is partially sorted by the call.
+     */
+    float median(float* values, u32 size) {
+      float* middle = values + size / 2;
+      std::nth_element(values, middle, values + size);
+      if (size % 2) return *middle;
+      return 0.5 * (*middle + *std::max_element(values, middle));
+    }
+
+  }
+
+  float Fed9UPedestalAnalyser::Welford::sigma() const {
+    return _entries > 1 ? std::sqrt(_m2 / (_entries - 1)) : 0.0;
+  }
+
+  Fed9UPedestalAnalyser::Fed9UPedestalAnalyser(u16 threads, u16 batchSize) :
+    _threads(threads), _batchSize(batchSize ? batchSize : 1), _events(0),
+    _lowNoiseLimit(0.5), _highNoiseLimit(2.0),
+    _raw(STRIPS_PER_FED), _corrected(STRIPS_PER_FED),
+    _queued(0), _generation(0), _busy(0), _stop(false)
+  {
+    //The events are constructed once and initialised on the buffer of each event queued.
+    _queue.reserve(_batchSize);
+    for (u16 i = 0; i < _batchSize; ++i) _queue.push_back(new Fed9UEvent());
+
+    if (_threads == 0) {
+      long processors = sysconf(_SC_NPROCESSORS_ONLN);
+      _threads = processors > 0 ? static_cast<u16>(std::min<long>(processors, FEUNITS_PER_FED)) : 1;
+    }
+    if (_threads > FEUNITS_PER_FED) _threads = FEUNITS_PER_FED;
+
+    pthread_mutex_init(&_mutex, NULL);
+    pthread_cond_init(&_start, NULL);
+    pthread_cond_init(&_finished, NULL);
+
+    if (_threads > 1) {
+      _workers.resize(_threads);
+      for (u16 i = 0; i < _threads; ++i) {
+	_workers[i]._owner = this;
+	_workers[i]._index = i;
+	if (pthread_create(&_workers[i]._thread, NULL, workerThread, &_workers[i]) != 0) {
+	  //Fall back to analysing in the calling thread.
+	  _workers.resize(i);
+	  stopWorkers();
+	  _threads = 1;
+	  break;
+	}
+      }
+    }
+  }
+
+  Fed9UPedestalAnalyser::~Fed9UPedestalAnalyser() {
+    stopWorkers();
+    for (vector<Fed9UEvent*>::iterator it = _queue.begin(); it != _queue.end(); ++it) {
+      delete *it;
+    }
+    pthread_cond_destroy(&_finished);
+    pthread_cond_destroy(&_start);
+    pthread_mutex_destroy(&_mutex);
+  }
+
+  void Fed9UPedestalAnalyser::addEvent(const u32* buffer, u32 words) {
+    //Events already queued from a stream are analysed first, then this event is analysed directly in the buffer of the caller.
+    flush();
+    //Fed9UEvent only reads the buffer.
+    _queue[0]->Init(const_cast<u32*>(buffer), NULL, words);
+    _queued = 1;
+    flush();
+  }
+
+  u32 Fed9UPedestalAnalyser::addEvents(std::istream& is) {
+    u32 events = 0;
+    //The buffers are never reallocated while events refer to them, as the queue is flushed before all of them are used.
+    if (_buffers.size() < _batchSize) _buffers.resize(_batchSize);
+    while (is) {
+      //Each record is a file type byte, which must be zero for a binary buffer, followed by the buffer size in bytes and the buffer.
+      u8 fileType = 0;
+      u32 size = 0;
+      if (!is.read(reinterpret_cast<char*>(&fileType), 1)) break;
+      is.read(reinterpret_cast<char*>(&size), 4);
+      ICUTILS_VERIFY(is && fileType == 0 && size % 4 == 0 && size > 0)(static_cast<u16>(fileType))(size).error()
+	.msg("Stream does not contain binary FED buffers");
+      //The record is read into the buffer of its place in the batch, which keeps its memory from one batch to the next.
+      vector<u32>& buffer = _buffers[_queued];
+      buffer.resize(size / 4);
+      is.read(reinterpret_cast<char*>(&buffer[0]), size);
+      ICUTILS_VERIFY(is)(size).error().msg("FED buffer truncated in stream");
+      _queue[_queued]->Init(&buffer[0], NULL, size / 4);
+      ++_queued;
+      ++events;
+      if (_queued >= _batchSize) flush();
+    }
+    return events;
+  }
+
+  void Fed9UPedestalAnalyser::flush() {
+    if (_queued == 0) return;
+
+    if (_workers.empty()) {
+      analyse(0);
+    } else {
+      pthread_mutex_lock(&_mutex);
+      _error.clear();
+      _busy = static_cast<u16>(_workers.size());
+      ++_generation;
+      pthread_cond_broadcast(&_start);
+      while (_busy) pthread_cond_wait(&_finished, &_mutex);
+      pthread_mutex_unlock(&_mutex);
+    }
+
+    _events += _queued;
+    clearQueue();
+    if (!_error.empty()) {
+      std::string error;
+      error.swap(_error);
+      THROW(ICUtils::ICException(error));
+    }
+  }
+
+  void Fed9UPedestalAnalyser::reset() {
+    clearQueue();
+    _events = 0;
+    std::fill(_raw.begin(), _raw.end(), Welford());
+    std::fill(_corrected.begin(), _corrected.end(), Welford());
+  }
+
+  u32 Fed9UPedestalAnalyser::writeStrips(Fed9UStrips& strips) {
+    flush();
+
+    u32 disabled = 0;
+    Fed9UAddress addr;
+    vector<float> noise;
+    noise.reserve(STRIPS_PER_APV);
+    for (u32 apv = 0; apv < APVS_PER_FED; ++apv) {
+      const u32 first = apv * STRIPS_PER_APV;
+      noise.clear();
+      for (u32 i = 0; i < STRIPS_PER_APV; ++i) {
+	if (_corrected[first + i]._entries > 1) noise.push_back(_corrected[first + i].sigma());
+      }
+      const float apvMedian = noise.empty() ? 0.0 : median(&noise[0], noise.size());
+
+      for (u32 i = 0; i < STRIPS_PER_APV; ++i) {
+	const u32 strip = first + i;
+	Fed9UStripDescription& description = strips.getStrip(addr.setFedStrip(static_cast<u16>(strip)));
+	const float stripNoise = _corrected[strip].sigma();
+	const bool disable = _raw[strip]._entries == 0 ||
+	  (apvMedian > 0.0 && (stripNoise < _lowNoiseLimit * apvMedian || stripNoise > _highNoiseLimit * apvMedian));
+	description.setPedestal(static_cast<i16>(std::floor(_raw[strip]._mean + 0.5)));
+	description.setNoise(stripNoise);
+	description.setDisable(disable);
+	if (disable) ++disabled;
+      }
+    }
+    return disabled;
+  }
+
+  void* Fed9UPedestalAnalyser::workerThread(void* arg) {
+    Worker* worker = static_cast<Worker*>(arg);
+    Fed9UPedestalAnalyser& owner = *worker->_owner;
+    u32 seen = 0;
+    pthread_mutex_lock(&owner._mutex);
+    while (true) {
+      while (!owner._stop && owner._generation == seen) pthread_cond_wait(&owner._start, &owner._mutex);
+      if (owner._stop) break;
+      seen = owner._generation;
+      pthread_mutex_unlock(&owner._mutex);
+
+      std::string error;
+      try {
+	owner.analyse(worker->_index);
+      } catch (const std::exception& e) {
+	error = e.what();
+      } catch (...) {
+	error = "Unknown exception in Fed9UPedestalAnalyser worker thread";
+      }
+
+      pthread_mutex_lock(&owner._mutex);
+      if (!error.empty() && owner._error.empty()) owner._error = error;
+      if (--owner._busy == 0) pthread_cond_signal(&owner._finished);
+    }
+    pthread_mutex_unlock(&owner._mutex);
+    return NULL;
+  }
+
+  void Fed9UPedestalAnalyser::analyse(u16 worker) {
+    const u16 step = _workers.empty() ? 1 : _threads;
+    for (u16 event = 0; event < _queued; ++event) {
+      for (u16 fe = worker; fe < FEUNITS_PER_FED && fe < _queue[event]->feUnits(); fe += step) {
+	analyseFeUnit(*_queue[event], fe);
+      }
+    }
+  }
+
+  void Fed9UPedestalAnalyser::analyseFeUnit(const Fed9UEvent& event, u16 feUnit) {
+    const Fed9UEventUnit& unit = event.feUnit(feUnit);
+    i16 samples[STRIPS_PER_CHANNEL];
+    float residuals[STRIPS_PER_APV];
+    for (u16 ch = 0; ch < unit.channels() && ch < CHANNELS_PER_FEUNIT; ++ch) {
+      Fed9USiStripReordering::reOrderEventChannel(unit.channel(ch), NULL, samples);
+      for (u16 apv = 0; apv < APVS_PER_CHANNEL; ++apv) {
+	const u32 first = ((feUnit * CHANNELS_PER_FEUNIT + ch) * APVS_PER_CHANNEL + apv) * STRIPS_PER_APV;
+	const i16* apvSamples = samples + apv * STRIPS_PER_APV;
+	Welford* raw = &_raw[first];
+	Welford* corrected = &_corrected[first];
+
+	//The common mode is found relative to the pedestals accumulated so far, which are too poor to use for the first few events.
+	const bool haveCommonMode = raw[0]._entries >= COMMON_MODE_WARMUP;
+	for (u16 i = 0; i < STRIPS_PER_APV; ++i) {
+	  residuals[i] = apvSamples[i] - raw[i]._mean;
+	  raw[i].add(apvSamples[i]);
+	}
+	if (haveCommonMode) {
+	  const float commonMode = median(residuals, STRIPS_PER_APV);
+	  for (u16 i = 0; i < STRIPS_PER_APV; ++i) {
+	    corrected[i].add(apvSamples[i] - commonMode);
+	  }
+	}
+      }
+    }
+  }
+
+  void Fed9UPedestalAnalyser::stopWorkers() {
+    pthread_mutex_lock(&_mutex);
+    _stop = true;
+    pthread_cond_broadcast(&_start);
+    pthread_mutex_unlock(&_mutex);
+    for (vector<Worker>::iterator it = _workers.begin(); it != _workers.end(); ++it) {
+      pthread_join(it->_thread, NULL);
+    }
+    _workers.clear();
+    _stop = false;
+  }
+
+  void Fed9UPedestalAnalyser::clearQueue() {
+    //The events are kept for the next batch.
+    _queued = 0;
+  }
+
+}
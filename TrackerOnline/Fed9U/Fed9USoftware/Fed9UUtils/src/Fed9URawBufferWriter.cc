@@ -0,0 +1,125 @@
+#include "Fed9URawBufferWriter.hh"
+#include "Fed9UBufferDescription.hh"
+#include "Fed9UEventInfo.hh"
+#include "Fed9USiStripReordering.hh"
+#include "ICAssert.hh"
+#include "ICException.hh"
+
+namespace Fed9U {
+
+  namespace {
+
+    const u32 HEADER_WORDS = 4;
+    const u32 FULL_DEBUG_FE_HEADER_WORDS = 4 * FEUNITS_PER_FED;
+    const u32 APV_ERROR_FE_HEADER_WORDS = 6;
+    const u32 TRAILER_WORDS = 2;
+
+    const u16 CHANNEL_BYTES = 3 + 2 * STRIPS_PER_CHANNEL;     //!< Length, packet code and samples.
+    const u16 FE_BYTES = CHANNEL_BYTES * CHANNELS_PER_FEUNIT;
+    const u16 PADDED_FE_BYTES = (FE_BYTES + 7) & ~7;
+
+    inline u32 swapBytes(u32 x) {
+      return (x >> 24) | ((x >> 8) & 0xFF00) | ((x << 8) & 0xFF0000) | (x << 24);
+    }
+
+  }
+
+  Fed9URawBufferWriter::Fed9URawBufferWriter(const Fed9UBufferDescription& description) {
+    Fed9UEventInfo info;
+    _headerFormat = description.getHeaderFormat();
+    _packetCode = description.getPacketCode();
+    ICUTILS_VERIFY(_headerFormat == info.getTrackerSpecialHeaderFullDebugMode() || _headerFormat == info.getTrackerSpecialHeaderApvErrorMode())
+      (static_cast<u16>(_headerFormat)).error().msg("Unknown header format");
+    ICUTILS_VERIFY(_packetCode & (info.getVirginRawModeCode() | info.getProcessedRawModeCode()))(static_cast<u16>(_packetCode))
+      .error().msg("Only the virgin raw and processed raw modes can be written");
+    _disorder = (_packetCode & info.getVirginRawModeCode()) != 0;
+
+    const u32 feHeaderWords = _headerFormat == info.getTrackerSpecialHeaderFullDebugMode() ? FULL_DEBUG_FE_HEADER_WORDS : APV_ERROR_FE_HEADER_WORDS;
+    _words = HEADER_WORDS + feHeaderWords + FEUNITS_PER_FED * PADDED_FE_BYTES / 4 + TRAILER_WORDS;
+
+    _header[0] = (0x50 | (description.getMode() & 0xF)) << 24;
+    _header[1] = ((description.getBunchCrossing() & 0xFFF) << 20) | 0x1218;
+    //Tracker header as written by Fed9UBufferHeader, with all the FE units agreeing with the APV emulator.
+    _header[2] = (0xED << 24) | ((_headerFormat & 0xF) << 20) | ((description.trackerEventType() & 0xF) << 16) | 0xFF;
+    _header[3] = 0xFF << 24;
+
+    //Same polynomial (0x8005) and initial value as calculateFEDBufferCRC.
+    for (u32 byte = 0; byte < 256; ++byte) {
+      u16 crc = byte << 8;
+      for (u32 bit = 0; bit < 8; ++bit) crc = (crc & 0x8000) ? (crc << 1) ^ 0x8005 : crc << 1;
+      _crcTable[0][byte] = crc;
+    }
+    for (u32 k = 1; k < 4; ++k) {
+      for (u32 byte = 0; byte < 256; ++byte) {
+	const u16 previous = _crcTable[k - 1][byte];
+	_crcTable[k][byte] = (previous << 8) ^ _crcTable[0][previous >> 8];
+      }
+    }
+  }
+
+  u16 Fed9URawBufferWriter::calculateCrc(const u32* buffer) const {
+    //In VME order the most significant byte of each word comes first in the data stream.
+    u16 crc = 0xFFFF;
+    for (u32 i = 0; i < _words; ++i) {
+      const u32 word = buffer[i];
+      crc = _crcTable[3][((crc >> 8) ^ (word >> 24)) & 0xFF] ^ _crcTable[2][(crc ^ (word >> 16)) & 0xFF]
+	^ _crcTable[1][(word >> 8) & 0xFF] ^ _crcTable[0][word & 0xFF];
+    }
+    return crc;
+  }
+
+  u32 Fed9URawBufferWriter::write(const u16* strips, u32 eventNumber, u32* buffer) const {
+    buffer[0] = _header[0] | (eventNumber & 0xFFFFFF);
+    buffer[1] = _header[1];
+    buffer[2] = _header[2];
+    buffer[3] = _header[3];
+
+    u32 word = HEADER_WORDS;
+    if (_headerFormat == FED9U_HEADER_FULLDEBUG) {
+      for (u32 fe = 0; fe < FEUNITS_PER_FED; ++fe) {
+	buffer[word++] = 0xFFFFFFFF;
+	buffer[word++] = 0xFFFFFFFF;
+	buffer[word++] = static_cast<u32>(FE_BYTES) << 16;
+	buffer[word++] = 0xFFFF;
+      }
+    } else {
+      for (u32 i = 0; i < APV_ERROR_FE_HEADER_WORDS; ++i) buffer[word++] = 0xFFFFFFFF;
+    }
+
+    //The payload is written as a byte stream, then each 32 bit word is swapped into the VME order.
+    u32* payload = buffer + word;
+    u8* p = reinterpret_cast<u8*>(payload);
+    const u16* table = _disorder ? Fed9USiStripReordering::CHANNEL_DISORDER_TABLE : 0;
+    for (u32 fe = 0; fe < FEUNITS_PER_FED; ++fe) {
+      u8* feStart = p;
+      for (u32 channel = 0; channel < CHANNELS_PER_FEUNIT; ++channel, strips += STRIPS_PER_CHANNEL) {
+	p[0] = CHANNEL_BYTES & 0xFF;
+	p[1] = CHANNEL_BYTES >> 8;
+	p[2] = _packetCode;
+	p += 3;
+	if (table) {
+	  for (u32 i = 0; i < STRIPS_PER_CHANNEL; ++i, p += 2) {
+	    const u16 value = strips[table[i]];
+	    p[0] = value & 0xFF;
+	    p[1] = value >> 8;
+	  }
+	} else {
+	  for (u32 i = 0; i < STRIPS_PER_CHANNEL; ++i, p += 2) {
+	    p[0] = strips[i] & 0xFF;
+	    p[1] = strips[i] >> 8;
+	  }
+	}
+      }
+      while (p < feStart + PADDED_FE_BYTES) *p++ = 0;
+    }
+    const u32 payloadWords = FEUNITS_PER_FED * PADDED_FE_BYTES / 4;
+    for (u32 i = 0; i < payloadWords; ++i) payload[i] = swapBytes(payload[i]);
+    word += payloadWords;
+
+    buffer[word] = (0xA0 << 24) | ((_words / 2) & 0xFFFFFF);
+    buffer[word + 1] = 0;
+    buffer[word + 1] = static_cast<u32>(calculateCrc(buffer)) << 16;
+    return _words;
+  }
+
+}
@@ -0,0 +1,40 @@
+#include "Fed9URegisterShadow.hh"
+
+namespace Fed9U {
+
+  Fed9URegisterShadow::Fed9URegisterShadow(u32 fullCheckPeriod) :
+    _fullCheckPeriod(fullCheckPeriod), _generation(0), _loadsSinceFullCheck(0), _spotChecks(0),
+    _readBacks(0), _readBacksSkipped(0), _spotCheckFailures(0), _trusted(false)
+  {
+  }
+
+  bool Fed9URegisterShadow::useShadow() {
+    if (!_trusted || _loadsSinceFullCheck + 1 >= _fullCheckPeriod) {
+      ++_readBacks;
+      return false;
+    }
+    ++_loadsSinceFullCheck;
+    ++_spotChecks;
+    ++_readBacksSkipped;
+    return true;
+  }
+
+  void Fed9URegisterShadow::synchronized() {
+    _trusted = true;
+    _loadsSinceFullCheck = 0;
+    ++_generation;
+  }
+
+  void Fed9URegisterShadow::invalidate() {
+    _trusted = false;
+    ++_generation;
+  }
+
+  void Fed9URegisterShadow::spotCheckFailed() {
+    --_readBacksSkipped;
+    ++_readBacks;
+    ++_spotCheckFailures;
+    invalidate();
+  }
+
+}
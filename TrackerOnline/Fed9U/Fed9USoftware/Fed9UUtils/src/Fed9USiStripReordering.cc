@@ -1,5 +1,8 @@
 #include "Fed9USiStripReordering.hh"
+#include "Fed9UEvent.hh"
+#include "Fed9UStrips.hh"
 
+#include <cstring>
 #include <stdexcept>
 
 namespace Fed9U {
@@ -7,6 +10,68 @@ namespace Fed9U {
   //using std::invalid_argument;
   
   const unsigned short Fed9USiStripReordering::NUMBER_OF_APV_STRIPS;
+  const unsigned short Fed9USiStripReordering::NUMBER_OF_CHANNEL_SAMPLES;
+
+  //The tables below are generated from the index arithmetic in reOrderingAlgorithm and disOrderingAlgorithm.
+  const u16 Fed9USiStripReordering::APV_REORDER_TABLE[NUMBER_OF_APV_STRIPS] = {
+      0,  16,  32,  48,  64,  80,  96, 112,   4,  20,  36,  52,  68,  84, 100, 116,
+      8,  24,  40,  56,  72,  88, 104, 120,  12,  28,  44,  60,  76,  92, 108, 124,
+      1,  17,  33,  49,  65,  81,  97, 113,   5,  21,  37,  53,  69,  85, 101, 117,
+      9,  25,  41,  57,  73,  89, 105, 121,  13,  29,  45,  61,  77,  93, 109, 125,
+      2,  18,  34,  50,  66,  82,  98, 114,   6,  22,  38,  54,  70,  86, 102, 118,
+     10,  26,  42,  58,  74,  90, 106, 122,  14,  30,  46,  62,  78,  94, 110, 126,
+      3,  19,  35,  51,  67,  83,  99, 115,   7,  23,  39,  55,  71,  87, 103, 119,
+     11,  27,  43,  59,  75,  91, 107, 123,  15,  31,  47,  63,  79,  95, 111, 127
+  };
+
+  const u16 Fed9USiStripReordering::APV_DISORDER_TABLE[NUMBER_OF_APV_STRIPS] = {
+      0,  32,  64,  96,   8,  40,  72, 104,  16,  48,  80, 112,  24,  56,  88, 120,
+      1,  33,  65,  97,   9,  41,  73, 105,  17,  49,  81, 113,  25,  57,  89, 121,
+      2,  34,  66,  98,  10,  42,  74, 106,  18,  50,  82, 114,  26,  58,  90, 122,
+      3,  35,  67,  99,  11,  43,  75, 107,  19,  51,  83, 115,  27,  59,  91, 123,
+      4,  36,  68, 100,  12,  44,  76, 108,  20,  52,  84, 116,  28,  60,  92, 124,
+      5,  37,  69, 101,  13,  45,  77, 109,  21,  53,  85, 117,  29,  61,  93, 125,
+      6,  38,  70, 102,  14,  46,  78, 110,  22,  54,  86, 118,  30,  62,  94, 126,
+      7,  39,  71, 103,  15,  47,  79, 111,  23,  55,  87, 119,  31,  63,  95, 127
+  };
+
+  const u16 Fed9USiStripReordering::CHANNEL_REORDER_TABLE[NUMBER_OF_CHANNEL_SAMPLES] = {
+      0,  32,  64,  96, 128, 160, 192, 224,   8,  40,  72, 104, 136, 168, 200, 232,
+     16,  48,  80, 112, 144, 176, 208, 240,  24,  56,  88, 120, 152, 184, 216, 248,
+      2,  34,  66,  98, 130, 162, 194, 226,  10,  42,  74, 106, 138, 170, 202, 234,
+     18,  50,  82, 114, 146, 178, 210, 242,  26,  58,  90, 122, 154, 186, 218, 250,
+      4,  36,  68, 100, 132, 164, 196, 228,  12,  44,  76, 108, 140, 172, 204, 236,
+     20,  52,  84, 116, 148, 180, 212, 244,  28,  60,  92, 124, 156, 188, 220, 252,
+      6,  38,  70, 102, 134, 166, 198, 230,  14,  46,  78, 110, 142, 174, 206, 238,
+     22,  54,  86, 118, 150, 182, 214, 246,  30,  62,  94, 126, 158, 190, 222, 254,
+      1,  33,  65,  97, 129, 161, 193, 225,   9,  41,  73, 105, 137, 169, 201, 233,
+     17,  49,  81, 113, 145, 177, 209, 241,  25,  57,  89, 121, 153, 185, 217, 249,
+      3,  35,  67,  99, 131, 163, 195, 227,  11,  43,  75, 107, 139, 171, 203, 235,
+     19,  51,  83, 115, 147, 179, 211, 243,  27,  59,  91, 123, 155, 187, 219, 251,
+      5,  37,  69, 101, 133, 165, 197, 229,  13,  45,  77, 109, 141, 173, 205, 237,
+     21,  53,  85, 117, 149, 181, 213, 245,  29,  61,  93, 125, 157, 189, 221, 253,
+      7,  39,  71, 103, 135, 167, 199, 231,  15,  47,  79, 111, 143, 175, 207, 239,
+     23,  55,  87, 119, 151, 183, 215, 247,  31,  63,  95, 127, 159, 191, 223, 255
+  };
+
+  const u16 Fed9USiStripReordering::CHANNEL_DISORDER_TABLE[NUMBER_OF_CHANNEL_SAMPLES] = {
+      0, 128,  32, 160,  64, 192,  96, 224,   8, 136,  40, 168,  72, 200, 104, 232,
+     16, 144,  48, 176,  80, 208, 112, 240,  24, 152,  56, 184,  88, 216, 120, 248,
+      1, 129,  33, 161,  65, 193,  97, 225,   9, 137,  41, 169,  73, 201, 105, 233,
+     17, 145,  49, 177,  81, 209, 113, 241,  25, 153,  57, 185,  89, 217, 121, 249,
+      2, 130,  34, 162,  66, 194,  98, 226,  10, 138,  42, 170,  74, 202, 106, 234,
+     18, 146,  50, 178,  82, 210, 114, 242,  26, 154,  58, 186,  90, 218, 122, 250,
+      3, 131,  35, 163,  67, 195,  99, 227,  11, 139,  43, 171,  75, 203, 107, 235,
+     19, 147,  51, 179,  83, 211, 115, 243,  27, 155,  59, 187,  91, 219, 123, 251,
+      4, 132,  36, 164,  68, 196, 100, 228,  12, 140,  44, 172,  76, 204, 108, 236,
+     20, 148,  52, 180,  84, 212, 116, 244,  28, 156,  60, 188,  92, 220, 124, 252,
+      5, 133,  37, 165,  69, 197, 101, 229,  13, 141,  45, 173,  77, 205, 109, 237,
+     21, 149,  53, 181,  85, 213, 117, 245,  29, 157,  61, 189,  93, 221, 125, 253,
+      6, 134,  38, 166,  70, 198, 102, 230,  14, 142,  46, 174,  78, 206, 110, 238,
+     22, 150,  54, 182,  86, 214, 118, 246,  30, 158,  62, 190,  94, 222, 126, 254,
+      7, 135,  39, 167,  71, 199, 103, 231,  15, 143,  47, 175,  79, 207, 111, 239,
+     23, 151,  55, 183,  87, 215, 119, 247,  31, 159,  63, 191,  95, 223, 127, 255
+  };
 
 
   void Fed9USiStripReordering::reOrderingAlgorithm(const std::vector<unsigned short> &apvOutput, std::vector<unsigned short> &fedOutput) {
@@ -45,6 +110,136 @@ namespace Fed9U {
       apvOutput.push_back(apvInput[newPlace]);   
     }
   }
-  
-  
+
+
+  void Fed9USiStripReordering::reOrderChannel(const u16* raw, u16* physical) {
+    for (u16 i = 0; i < NUMBER_OF_CHANNEL_SAMPLES; ++i) {
+      physical[i] = raw[CHANNEL_REORDER_TABLE[i]];
+    }
+  }
+
+
+  void Fed9USiStripReordering::reOrderChannel(u16* samples) {
+    u16 raw[NUMBER_OF_CHANNEL_SAMPLES];
+    std::memcpy(raw, samples, sizeof(raw));
+    reOrderChannel(raw, samples);
+  }
+
+
+  void Fed9USiStripReordering::disOrderChannel(const u16* physical, u16* raw) {
+    for (u16 i = 0; i < NUMBER_OF_CHANNEL_SAMPLES; ++i) {
+      raw[i] = physical[CHANNEL_DISORDER_TABLE[i]];
+    }
+  }
+
+
+  void Fed9USiStripReordering::disOrderChannel(u16* samples) {
+    u16 physical[NUMBER_OF_CHANNEL_SAMPLES];
+    std::memcpy(physical, samples, sizeof(physical));
+    disOrderChannel(physical, samples);
+  }
+
+
+  void Fed9USiStripReordering::reOrderEventChannel(const Fed9UEventChannel& channel, const i16* pedestals, i16* strips) {
+    u16 samples[NUMBER_OF_CHANNEL_SAMPLES];
+    const Fed9UEventIterator& data = channel.getIterator();
+    //The event buffer is stored in 32 bit words with the bytes swapped, so the data is read directly from the underlying
+    //buffer rather than through the range checked iterator. The channel header is 3 bytes (length and packet code).
+    const Fed9UEventIterator word = data.normalize();
+    const u8* buffer = word.getPtr();
+    const u32 offset = (data - Fed9UEventIterator(const_cast<u8*>(buffer))) + 3;
+    const u32 length = data.size() < 3 ? 0 : data.size() - 3;
+    const u8 packetCode = data.size() < 3 ? 0 : data[2];
+
+    bool ordered = false;
+    u32 expected = 0;
+    switch (packetCode) {
+    case FED9U_PACKET_PROCRAW:
+      ordered = true; expected = 2 * NUMBER_OF_CHANNEL_SAMPLES; break;
+    case FED9U_PACKET_VIRGRAW:
+      expected = 2 * NUMBER_OF_CHANNEL_SAMPLES; break;
+    case FED9U_PACKET_PROCRAW_10BIT:
+      ordered = true; expected = 10 * NUMBER_OF_CHANNEL_SAMPLES / 8; break;
+    case FED9U_PACKET_VIRGRAW_10BIT:
+      expected = 10 * NUMBER_OF_CHANNEL_SAMPLES / 8; break;
+    case FED9U_PACKET_PROCRAW_8BIT_LO: case FED9U_PACKET_PROCRAW_8BIT_HI_LO:
+      ordered = true; expected = NUMBER_OF_CHANNEL_SAMPLES; break;
+    case FED9U_PACKET_VIRGRAW_8BIT_LO: case FED9U_PACKET_VIRGRAW_8BIT_HI_LO:
+      expected = NUMBER_OF_CHANNEL_SAMPLES; break;
+    default:
+      throw std::invalid_argument("ERROR. Channel is not in a raw data mode in Fed9USiStripReordering::reOrderEventChannel.");
+    }
+    if (length != expected) {
+      throw std::invalid_argument("ERROR. Channel does not contain 256 samples in Fed9USiStripReordering::reOrderEventChannel.");
+    }
+
+    //Unpack, the byte at offset n in the event is at buffer[n^3].
+    switch (packetCode) {
+    case FED9U_PACKET_PROCRAW: case FED9U_PACKET_VIRGRAW:
+      for (u32 i = 0, n = offset; i < NUMBER_OF_CHANNEL_SAMPLES; ++i, n += 2) {
+        samples[i] = buffer[n ^ 3] | (buffer[(n+1) ^ 3] << 8);
+      }
+      break;
+    case FED9U_PACKET_PROCRAW_10BIT: case FED9U_PACKET_VIRGRAW_10BIT:
+      //Four 10 bit samples are packed, most significant bit first, into every five bytes.
+      for (u32 i = 0, n = offset; i < NUMBER_OF_CHANNEL_SAMPLES; i += 4, n += 5) {
+        const u16 b0 = buffer[n ^ 3], b1 = buffer[(n+1) ^ 3], b2 = buffer[(n+2) ^ 3], b3 = buffer[(n+3) ^ 3], b4 = buffer[(n+4) ^ 3];
+        samples[i]   = (b0 << 2) | (b1 >> 6);
+        samples[i+1] = ((b1 & 0x3f) << 4) | (b2 >> 4);
+        samples[i+2] = ((b2 & 0x0f) << 6) | (b3 >> 2);
+        samples[i+3] = ((b3 & 0x03) << 8) | b4;
+      }
+      break;
+    case FED9U_PACKET_PROCRAW_8BIT_LO: case FED9U_PACKET_VIRGRAW_8BIT_LO:
+      for (u32 i = 0, n = offset; i < NUMBER_OF_CHANNEL_SAMPLES; ++i, ++n) {
+        samples[i] = buffer[n ^ 3] << 2;
+      }
+      break;
+    default:
+      for (u32 i = 0, n = offset; i < NUMBER_OF_CHANNEL_SAMPLES; ++i, ++n) {
+        samples[i] = buffer[n ^ 3] << 1;
+      }
+      break;
+    }
+
+    if (ordered) {
+      for (u16 i = 0; i < NUMBER_OF_CHANNEL_SAMPLES; ++i) {
+        strips[i] = samples[i];
+      }
+    } else if (pedestals) {
+      for (u16 i = 0; i < NUMBER_OF_CHANNEL_SAMPLES; ++i) {
+        strips[i] = samples[CHANNEL_REORDER_TABLE[i]] - pedestals[i];
+      }
+    } else {
+      for (u16 i = 0; i < NUMBER_OF_CHANNEL_SAMPLES; ++i) {
+        strips[i] = samples[CHANNEL_REORDER_TABLE[i]];
+      }
+    }
+  }
+
+
+  u16 Fed9USiStripReordering::reOrderEvent(const Fed9UEvent& event, const i16* pedestals, i16* strips) {
+    std::memset(strips, 0, STRIPS_PER_FED * sizeof(*strips));
+
+    u16 channels = 0;
+    for (u16 fe = 0; fe < event.feUnits() && fe < FEUNITS_PER_FED; ++fe) {
+      const Fed9UEventUnit& unit = event.feUnit(fe);
+      for (u16 ch = 0; ch < unit.channels() && ch < CHANNELS_PER_FEUNIT; ++ch) {
+	const u32 first = (fe * CHANNELS_PER_FEUNIT + ch) * NUMBER_OF_CHANNEL_SAMPLES;
+	reOrderEventChannel(unit.channel(ch), pedestals ? pedestals + first : NULL, strips + first);
+	++channels;
+      }
+    }
+    return channels;
+  }
+
+
+  void Fed9USiStripReordering::getPedestals(const Fed9UStrips& strips, i16* pedestals) {
+    Fed9UAddress addr;
+    for (u32 strip = 0; strip < STRIPS_PER_FED; ++strip) {
+      pedestals[strip] = strips.getStrip(addr.setFedStrip(static_cast<u16>(strip))).getPedestal();
+    }
+  }
+
+
 } //End of Fed9U namespace.
@@ -0,0 +1,86 @@
+#include "Fed9USignalModel.hh"
+#include "Fed9USiStripReordering.hh"
+#include "ICAssert.hh"
+#include "ICException.hh"
+
+#include <cmath>
+
+namespace Fed9U {
+
+  namespace {
+
+    /**
+     * splitmix64, used to turn the run seed and event number into a well mixed state.
+     */
+    u64 mix(u64 x) {
+      x += 0x9E3779B97F4A7C15ULL;
+      x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+      x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+      return x ^ (x >> 31);
+    }
+
+    const u16 MAX_ADC = 1023;
+
+  }
+
+  void Fed9URandom::setSeed(u64 seed, u32 event) {
+    _state = mix(mix(seed) ^ event);
+    //The state of xorshift must never be zero.
+    if (_state == 0) _state = 0x9E3779B97F4A7C15ULL;
+  }
+
+  double Fed9URandom::gaussian() {
+    double u = uniform();
+    while (u == 0.0) u = uniform();
+    return std::sqrt(-2.0 * std::log(u)) * std::cos(2.0 * M_PI * uniform());
+  }
+
+  Fed9UPedestalNoiseModel::Fed9UPedestalNoiseModel(u16 pedestal, float noise, u16 clusters, u16 charge) :
+    _pedestals(STRIPS_PER_FED, pedestal), _noise(1 << NOISE_BITS), _clusters(clusters), _charge(charge), _maxWidth(3)
+  {
+    //The table is filled from a fixed seed, the models of all the runs have the same noise distribution.
+    Fed9URandom random(0x5EED);
+    for (u32 i = 0; i < _noise.size(); ++i) {
+      _noise[i] = static_cast<i16>(std::floor(noise * random.gaussian() + 0.5));
+    }
+  }
+
+  Fed9UPedestalNoiseModel& Fed9UPedestalNoiseModel::setPedestals(const std::vector<u16>& pedestals) {
+    ICUTILS_VERIFY(pedestals.size() == STRIPS_PER_FED)(pedestals.size()).error().msg("One pedestal per FED strip is required");
+    _pedestals = pedestals;
+    return *this;
+  }
+
+  Fed9UPedestalNoiseModel& Fed9UPedestalNoiseModel::setMaxClusterWidth(u16 maxWidth) {
+    ICUTILS_VERIFY(maxWidth >= 1 && maxWidth <= Fed9USiStripReordering::NUMBER_OF_APV_STRIPS)(maxWidth).error();
+    _maxWidth = maxWidth;
+    return *this;
+  }
+
+  void Fed9UPedestalNoiseModel::generate(Fed9URandom& random, u16* strips) const {
+    const u32 mask = (1 << NOISE_BITS) - 1;
+    const u32 perWord = 64 / NOISE_BITS;
+    const i16* noise = &_noise[0];
+    const u16* pedestals = &_pedestals[0];
+
+    for (u32 strip = 0; strip < STRIPS_PER_FED; ) {
+      u64 bits = random.next();
+      for (u32 i = 0; i < perWord && strip < STRIPS_PER_FED; ++i, ++strip, bits >>= NOISE_BITS) {
+	i32 value = pedestals[strip] + noise[bits & mask];
+	strips[strip] = value < 0 ? 0 : (value > MAX_ADC ? MAX_ADC : value);
+      }
+    }
+
+    for (u16 c = 0; c < _clusters; ++c) {
+      const u32 width = 1 + random.uniform(_maxWidth);
+      const u32 apv = random.uniform(APVS_PER_FED);
+      const u32 first = apv * STRIPS_PER_APV + random.uniform(STRIPS_PER_APV - width + 1);
+      const double charge = _charge * (1.0 + 0.2 * random.gaussian());
+      for (u32 strip = first; strip < first + width; ++strip) {
+	i32 value = strips[strip] + static_cast<i32>(charge / width);
+	strips[strip] = value < 0 ? 0 : (value > MAX_ADC ? MAX_ADC : value);
+      }
+    }
+  }
+
+}
@@ -105,6 +105,27 @@ namespace Fed9U {
   //using.*std::vector;
   //using.*std::string;
 
+/**Access to the items of the HAL address table of one FED. When one is given to Fed9UHalInterface::setItemAccess for a crate,
+   the Fed9UHalInterface objects of this crate use it instead of a HAL VMEDevice, without address table nor bus adaptor.
+   A simulation of the FED registers can then run Fed9UVmeBase and Fed9UVmeDevice without a crate. This is for the tests only.*/
+class Fed9UHalItemAccess
+{
+public:
+  virtual ~Fed9UHalItemAccess() {}
+
+  /**Write to an item at a byte offset. masked is true for a write through the mask of the item.*/
+  virtual void write(const std::string &item, u32 data, bool masked, u32 offset) = 0;
+
+  /**Read an item at a byte offset. masked is true for a read through the mask of the item.*/
+  virtual u32 read(const std::string &item, bool masked, u32 offset) = 0;
+
+  /**Block write of length bytes to an item, from a byte offset.*/
+  virtual void writeBlock(const std::string &item, const char *buffer, u32 length, u32 offset) = 0;
+
+  /**Block read of length bytes from an item, from a byte offset.*/
+  virtual void readBlock(const std::string &item, char *buffer, u32 length, u32 offset) = 0;
+};
+
 class Fed9UHalInterface
 {
 public:
@@ -184,6 +205,11 @@ public:
                          u32 length) throw (Fed9UVmeBaseException);
   void resetBus() throw (Fed9UVmeBaseException);
 
+  /**Method which sets the item access used by the Fed9UHalInterface objects constructed afterwards for a crate, instead of
+     the HAL address table and bus adaptor. NULL restores the HAL access. The item access is not deleted.
+     This is for the tests only, it must never be called in a crate.*/
+  static void setItemAccess(unsigned short crateNumber, Fed9UHalItemAccess *access);
+
 private:
   static std::vector<VMEAddressTableASCIIReader *> addressTableReader;
   static std::vector<VMEAddressTable *>  addressTable;
@@ -191,7 +217,10 @@ private:
   static std::vector<u32> countDevices;
   static pthread_mutex_t busAdaptorMutex;
 
+  static std::vector<Fed9UHalItemAccess *> itemAccesses;
+
   VMEDevice* fedv1Device; 
+  Fed9UHalItemAccess *itemAccess;
   u32 adaptorNumber;
   bool mLockedMutex;
   Fed9UHalBusAdaptor busAdaptorType_;
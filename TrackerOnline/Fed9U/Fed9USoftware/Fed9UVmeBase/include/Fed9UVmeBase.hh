@@ -779,6 +779,14 @@ public:
      The default offset is zero. The memory space used is 0x900 to 0x97f inclusive. Memory is a FIFO.*/
   u32 vmeCommandSysAceDataRead(u32 offset = 0) throw (Fed9UVmeBaseException);
 
+  /**Block transfer to the System ACE data buffers. Each of the words holds one 16 bit data word in its lower bits, as for
+     vmeCommandSysAceDataWrite. The words are written from the start of the data buffer area, which maps to the same FIFO,
+     so up to 32 words can be written at a time.*/
+  void vmeCommandSysAceDataBlockWrite(const u32* words, u32 count) throw (Fed9UVmeBaseException);
+
+  /**Block transfer from the System ACE data buffers, the counterpart of vmeCommandSysAceDataBlockWrite.*/
+  void vmeCommandSysAceDataBlockRead(u32* words, u32 count) throw (Fed9UVmeBaseException);
+
   /**Enables one to write to the System ACE control registers.
      The control registers occupy 0x880 to 0x8ff inclusive. The default offset is zero.*/
   void vmeCommandSysAceControlWrite(u32 arguments, u32 offset = 0) throw (Fed9UVmeBaseException);
@@ -32,12 +32,22 @@ namespace Fed9U {
   std::vector<u32> Fed9UHalInterface::countDevices(10,0); // use this if we want to have multiple bus adaptors for daisy chained or multiple pci cards, 
   //default max number of cards on one pc is set to 10 (this is way too high )
   pthread_mutex_t Fed9UHalInterface::busAdaptorMutex = PTHREAD_MUTEX_INITIALIZER;
+  std::vector<Fed9UHalItemAccess *> Fed9UHalInterface::itemAccesses(FED9U_HAL_INTERFACE_MAX_ADAPTORS,reinterpret_cast<Fed9UHalItemAccess *>(NULL));
 
   
   // u32 Fed9UHalInterface::countDevices = 0; // use this if we don't want to have multiple bus adaptors for daisy chained or multiple pci cards
   //Constructor.
   //The address table location base address are passed to the constructor. The crate number is also optionally passed.
-  Fed9UHalInterface::Fed9UHalInterface(u32 baseAddress, const std::string& theAddressTable, Fed9UHalBusAdaptor adaptorType, unsigned short crateNumber) : fedv1Device(NULL) , adaptorNumber(crateNumber),busAdaptorType_(adaptorType) {
+  Fed9UHalInterface::Fed9UHalInterface(u32 baseAddress, const std::string& theAddressTable, Fed9UHalBusAdaptor adaptorType, unsigned short crateNumber) : fedv1Device(NULL) , itemAccess(NULL), adaptorNumber(crateNumber),busAdaptorType_(adaptorType) {
+
+    //A simulation of the FED registers replaces the address table and the bus adaptor of the crate.
+    //setItemAccess writes it under the bus adaptor mutex.
+    if (crateNumber < itemAccesses.size()) {
+      pthread_mutex_lock(&busAdaptorMutex);
+      itemAccess = itemAccesses[crateNumber];
+      pthread_mutex_unlock(&busAdaptorMutex);
+      if (itemAccess) return;
+    }
 
     //Protect ourselves against exceptions that could be thrown and prevent the mutex from being released.
     try {
@@ -233,6 +243,9 @@ namespace Fed9U {
 
 
   Fed9UHalInterface::~Fed9UHalInterface() {
+    //Nothing was created for a simulated FED.
+    if (itemAccess) return;
+
     //Lock the shared resources before destructing the object.
     int errLock( pthread_mutex_lock(&busAdaptorMutex) );
 
@@ -269,6 +282,8 @@ namespace Fed9U {
 #ifdef DEBUG_HAL_INTERFACE
       std::cout << "************ write register **************" << std::endl;
 #endif
+      if (itemAccess) itemAccess->write(fedRegister, data, false, offset);
+      else
 #if FED9U_XDAQ_VERSION >= 37
       fedv1Device->unmaskedWrite(fedRegister.c_str(), data, verifyFlag, static_cast<u16>(offset));
 #else
@@ -299,6 +314,8 @@ namespace Fed9U {
 					     u32 length, 
 					     HalVerifyOption verifyFlag) throw (Fed9UVmeBaseException) {
     try {
+      if (itemAccess) itemAccess->writeBlock(fedRegister, reinterpret_cast<const char*>(buffer), length, offset);
+      else
 #if FED9U_XDAQ_VERSION >= 37
       //<JEC date=13/9/07> KH change for SLC4/GCC3.4
       //      fedv1Device->writeBlock( fedRegister.c_str(), length, reinterpret_cast<char*>(buffer), verifyFlag, HAL_DO_INCREMENT, static_cast<u16>(offset) );
@@ -331,7 +348,8 @@ namespace Fed9U {
 #ifdef DEBUG_HAL_INTERFACE
       std::cout << "************ write register **************" << std::endl;
 #endif
-      fedv1Device->write(fedRegister.c_str(), data, verifyFlag);
+      if (itemAccess) itemAccess->write(fedRegister, data, true, 0);
+      else fedv1Device->write(fedRegister.c_str(), data, verifyFlag);
     }
     catch(HardwareAccessException &e) {
       std::string theErrorMessage = "HardwareAccessException caught in Fed9UHalInterface::maskedWriteRegister. Register is: " + fedRegister;
@@ -372,15 +390,18 @@ namespace Fed9U {
       
       std::vector<u32>::const_iterator i;
       for (i=commandLong.begin(); i!=commandLong.end(); ++i) {   //Loop over all the u32 words
-	fedv1Device->unmaskedWrite("ARGUMENT",*i,HAL_NO_VERIFY,offset);
+	if (itemAccess) itemAccess->write("ARGUMENT", *i, false, offset);
+	else fedv1Device->unmaskedWrite("ARGUMENT",*i,HAL_NO_VERIFY,offset);
 	offset = offset + 0x04; //Increment by 32-bits (ie. 4-bytes). 
       }
       //Clear the next register in the ARGUMENT area after the command+data has been written.
-      fedv1Device->unmaskedWrite("ARGUMENT",0,HAL_NO_VERIFY,offset);
+      if (itemAccess) itemAccess->write("ARGUMENT", 0, false, offset);
+      else fedv1Device->unmaskedWrite("ARGUMENT",0,HAL_NO_VERIFY,offset);
       offset = 0x0;
       
       //Subtract 1 from #no of words and write this to WRITE area.
-      fedv1Device->unmaskedWrite("WRITE",commandLong.size()-1,HAL_NO_VERIFY,offset); 
+      if (itemAccess) itemAccess->write("WRITE", commandLong.size()-1, false, offset);
+      else fedv1Device->unmaskedWrite("WRITE",commandLong.size()-1,HAL_NO_VERIFY,offset); 
       //std::cout << " length of command = " << dec << commandLong.size() << std::endl;
 
       // now we poll the fed to make sure that it is ready for the next command
@@ -455,7 +476,8 @@ namespace Fed9U {
       //std::cout << "Writing block in hal!!" << std::endl;
       blockWriteRegister(std::string("ARGUMENT_BLT"), command, offset, length*4, HAL_NO_VERIFY);
       //std::cout << "Wrote block in hal!!" << std::endl;
-      fedv1Device->unmaskedWrite("WRITE", length-1, HAL_NO_VERIFY, 0); //TODO JF might not need to subtract 1 from the length!!!!!!!!!!!!11
+      if (itemAccess) itemAccess->write("WRITE", length-1, false, 0);
+      else fedv1Device->unmaskedWrite("WRITE", length-1, HAL_NO_VERIFY, 0); //TODO JF might not need to subtract 1 from the length!!!!!!!!!!!!11
       //std::cout << "Wrote serial command go in hal" << std::endl;
 
       // now we poll the fed to make sure that it is ready for the next command
@@ -638,7 +660,8 @@ namespace Fed9U {
 #ifdef DEBUG_HAL_INTERFACE
 	std::cout << "************ write register **************" << std::endl;
 #endif
-	fedv1Device->unmaskedWrite("READ",commandLong,HAL_NO_VERIFY,offset);
+	if (itemAccess) itemAccess->write("READ", commandLong, false, offset);
+	else fedv1Device->unmaskedWrite("READ",commandLong,HAL_NO_VERIFY,offset);
       }
       catch(HardwareAccessException &e) {
 	RETHROW(e, Fed9UVmeBaseException(Fed9UVmeBaseException::ERROR_FED9UHALINTERFACE,"HardwareAccessException caught in Fed9UHalInterface::readSerialCommand."));
@@ -659,7 +682,8 @@ namespace Fed9U {
 #ifdef DEBUG_HAL_INTERFACE
 	  std::cout << "************ read register **************" << std::endl;
 #endif
-	  fedv1Device->unmaskedRead("ARGUMENT",&tempRead,offset);
+	  if (itemAccess) tempRead = itemAccess->read("ARGUMENT", false, offset);
+	  else fedv1Device->unmaskedRead("ARGUMENT",&tempRead,offset);
 	  readArguments.push_back(tempRead);
 	  //	  std::cout << "serial command value read back = " << hex << tempRead << dec << std::endl;
 	  offset = offset + 0x04; //Offset by 4 bytes.
@@ -737,7 +761,8 @@ namespace Fed9U {
 #ifdef DEBUG_HAL_INTERFACE
 	  std::cout << "************ read register **************" << std::endl;
 #endif
-	  fedv1Device->unmaskedRead("ARGUMENT",&tempRead,offset);
+	  if (itemAccess) tempRead = itemAccess->read("ARGUMENT", false, offset);
+	  else fedv1Device->unmaskedRead("ARGUMENT",&tempRead,offset);
 	  readArguments.push_back(tempRead);
 	  //std::cout << "serial command value read back = " << hex << tempRead << dec << std::endl;
 	  offset = offset + 0x04; //Offset by 4 bytes.
@@ -776,6 +801,8 @@ namespace Fed9U {
 #ifdef DEBUG_HAL_INTERFACE
 	  std::cout << "************ read register **************" << std::endl;
 #endif
+	  if (itemAccess) readArguments = itemAccess->read(fedRegister, false, offset);
+	  else
 #if FED9U_XDAQ_VERSION >= 37
 	  //<JEC date=13/9/07>  KH change for SLC4/GCC3.4
 	  //	  fedv1Device->unmaskedRead(fedRegister.c_str(), &static_cast<uint32_t>(readArguments), static_cast<u16>(offset));
@@ -803,6 +830,8 @@ namespace Fed9U {
     void Fed9UHalInterface::maskedReadRegister(const std::string &fedRegister, u32 &readArguments) throw (Fed9UVmeBaseException)
       {
 	try {
+	  if (itemAccess) readArguments = itemAccess->read(fedRegister, true, 0);
+	  else
 #if FED9U_XDAQ_VERSION >= 37
 	  //<JEC date=13/9/07>  KH change for SLC4/GCC3.4
 	  //	  fedv1Device->read(fedRegister.c_str(), &static_cast<uint32_t>(readArguments));
@@ -841,7 +870,8 @@ namespace Fed9U {
 	  std::cout << "************ bLOCK READ register **************" << std::endl;
 #endif
 	  //Do a block read from an offset. Length will specify the size of the block to read.
-	  fedv1Device->readBlock(fedRegister.c_str(), length, readArguments, HAL_DO_INCREMENT, offset);
+	  if (itemAccess) itemAccess->readBlock(fedRegister, readArguments, length, offset);
+	  else fedv1Device->readBlock(fedRegister.c_str(), length, readArguments, HAL_DO_INCREMENT, offset);
 	}
 	catch(HardwareAccessException &e) {
 	  std::string theErrorMessage = "HardwareAccessException caught in Fed9UHalInterface::blockReadRegister. Register is: " + fedRegister;
@@ -859,8 +889,8 @@ namespace Fed9U {
 
    void Fed9UHalInterface::resetBus() throw (Fed9UVmeBaseException) 
    {
-     if (1==0) {
-       //do nothing
+     if (itemAccess) {
+       //no bus for a simulated FED
      }
 #ifdef BUILD_SBS620
      else if (busAdaptorType_ == FED9U_HAL_BUS_ADAPTOR_SBS ) {
@@ -896,8 +926,14 @@ namespace Fed9U {
      }
 #endif
    }
-}
 
+  void Fed9UHalInterface::setItemAccess(unsigned short crateNumber, Fed9UHalItemAccess *access) {
+    ICUTILS_VERIFYX(crateNumber < itemAccesses.size(),Fed9UVmeBaseException)(crateNumber).code(Fed9UVmeBaseException::ERROR_FED9UHALINTERFACE).error().msg("Crate number too large in Fed9UHalInterface::setItemAccess.");
+    pthread_mutex_lock(&busAdaptorMutex);
+    itemAccesses[crateNumber] = access;
+    pthread_mutex_unlock(&busAdaptorMutex);
+  }
+}
   
   
   
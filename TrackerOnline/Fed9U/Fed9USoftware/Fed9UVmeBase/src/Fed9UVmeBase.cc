@@ -3115,6 +3115,35 @@ void Fed9UVmeBase::feCommandLoadSuperModeReg(unsigned short selectedFpga,
     
   }
 
+  //Block transfer to the System ACE data buffers, one 16 bit data word in each 32 bit word.
+  //The data buffer area maps to a single FIFO, so the incrementing addresses of the block transfer all reach it.
+  void Fed9UVmeBase::vmeCommandSysAceDataBlockWrite(const u32* words, u32 count) throw (Fed9UVmeBaseException) 
+  {
+    try {
+      theFed9UHalInterface.blockWriteRegister("SYS_ACE_DATA_BLT", reinterpret_cast<const u8*>(words), 0, count * sizeof(u32), HAL_NO_VERIFY);
+    }
+    catch (std::exception &e) {
+      RETHROW(e, Fed9UVmeBaseException(Fed9UVmeBaseException::ERROR_FED9UVMEBASE, "std::exception caught in Fed9UVmeBase::vmeCommandSysAceDataBlockWrite."));
+    }
+    catch (...) {
+      THROW(Fed9UVmeBaseException(Fed9UVmeBaseException::ERROR_FED9UVMEBASE, "Unknown exception caught in Fed9UVmeBase::vmeCommandSysAceDataBlockWrite."));
+    }
+  }
+
+  //Block transfer from the System ACE data buffers, one 16 bit data word in each 32 bit word.
+  void Fed9UVmeBase::vmeCommandSysAceDataBlockRead(u32* words, u32 count) throw (Fed9UVmeBaseException) 
+  {
+    try {
+      theFed9UHalInterface.blockReadRegister("SYS_ACE_DATA_BLT", reinterpret_cast<char*>(words), 0, count * sizeof(u32));
+    }
+    catch (std::exception &e) {
+      RETHROW(e, Fed9UVmeBaseException(Fed9UVmeBaseException::ERROR_FED9UVMEBASE, "std::exception caught in Fed9UVmeBase::vmeCommandSysAceDataBlockRead."));
+    }
+    catch (...) {
+      THROW(Fed9UVmeBaseException(Fed9UVmeBaseException::ERROR_FED9UVMEBASE, "Unknown exception caught in Fed9UVmeBase::vmeCommandSysAceDataBlockRead."));
+    }
+  }
+
   //Enables one to write to the System ACE control registers.
   //The control registers occupy 0x880 to 0x8ff inclusive. The default offset is zero.
   void Fed9UVmeBase::vmeCommandSysAceControlWrite(u32 arguments, u32 offset) throw (Fed9UVmeBaseException) 
@@ -0,0 +1,42 @@
+#ifndef H_Fed9UVmeCfTarget
+#define H_Fed9UVmeCfTarget
+
+#include "Fed9UCfDeployer.hh"
+#include "Fed9UVmeDevice.hh"
+
+namespace Fed9U {
+
+  /**
+   * \brief  Writes a compact flash image with Fed9UCfDeployer to the card of a Fed9UVmeDevice.
+   *
+   * The clusters are transferred with Fed9UVmeDevice::writeCfCluster and readCfCluster, and the firmware is reloaded with
+   * Fed9UVmeDevice::reloadFpgaFirmwareFromCompactFlash.
+   */
+  class Fed9UVmeCfTarget : public Fed9UCfTarget {
+  public:
+    explicit Fed9UVmeCfTarget(Fed9UVmeDevice& fed) : _fed(fed) {}
+
+    void writeCluster(u32 cluster, const u8* data) { _fed.writeCfCluster(cluster, data); }
+
+    void readCluster(u32 cluster, u8* data) { _fed.readCfCluster(cluster, data); }
+
+    void reloadFirmware(u32 revision) { _fed.reloadFpgaFirmwareFromCompactFlash(revision); }
+
+    Fed9UCfFirmwareVersions getFirmwareVersions() {
+      Fed9UCfFirmwareVersions versions;
+      versions._fe = _fed.getFeFirmwareVersion();
+      versions._delay = _fed.getDelayFirmwareVersion();
+      versions._be = _fed.getBeFirmwareVersion();
+      versions._vme = _fed.getVmeFirmwareVersion();
+      return versions;
+    }
+
+    Fed9UVmeDevice& getFed() { return _fed; }
+
+  private:
+    Fed9UVmeDevice& _fed;
+  };
+
+}
+
+#endif // H_Fed9UVmeCfTarget
@@ -0,0 +1,29 @@
+#ifndef H_Fed9UVmeDelayScanTarget
+#define H_Fed9UVmeDelayScanTarget
+
+#include "Fed9UDelayScanEngine.hh"
+#include "Fed9UVmeDevice.hh"
+
+namespace Fed9U {
+
+  /**
+   * \brief  Scans the delays of a FED with Fed9UDelayScanEngine through a Fed9UVmeDevice.
+   *
+   * The delays are written with Fed9UVmeDevice::setDelays, once per delay chip at each step. The measurement is left to
+   * the Fed9UDelayScanProbe given to the engine, for instance the tick mark height in scope mode.
+   */
+  class Fed9UVmeDelayScanTarget : public Fed9UDelayScanTarget {
+  public:
+    explicit Fed9UVmeDelayScanTarget(Fed9UVmeDevice& fed) : _fed(fed) {}
+
+    void setDelays(const std::vector<u16>& fedChannels, const std::vector<u16>& nanoDelays) { _fed.setDelays(fedChannels, nanoDelays); }
+
+    Fed9UVmeDevice& getFed() { return _fed; }
+
+  private:
+    Fed9UVmeDevice& _fed;
+  };
+
+}
+
+#endif // H_Fed9UVmeDelayScanTarget
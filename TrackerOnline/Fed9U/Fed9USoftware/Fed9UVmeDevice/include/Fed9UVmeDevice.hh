@@ -5,6 +5,8 @@
 #include "Fed9UVmeDeviceException.hh"
 //#include "Fed9UEvent.hh"
 #include "Fed9UDescription.hh"
+#include "Fed9URegisterShadow.hh"
+#include "Fed9UConfigVerifier.hh"
 #include "TypeDefs.hh"
 #include "StopWatch.hh"
 
@@ -468,6 +470,18 @@ namespace Fed9U {
      */
     Fed9UVmeDevice& setDelay(const Fed9UAddress& fedChannel, u16 coarseDelay, u16 fineDelay) throw (Fed9UVmeDeviceException);
 
+    /**
+     * \brief  Sets the nano second delays of several FED channels, writing each delay chip once.
+     * \param  fedChannels Internal FED channel numbers.
+     * \param  nanoDelays Delay of each channel in nano seconds. Range: 0-399.
+     * \return Self reference.
+     * \throw  Fed9UVmeDeviceException Thrown if a delay is out of range or the two vectors differ in size.
+     *
+     * Used by Fed9UDelayScanEngine through Fed9UVmeDelayScanTarget to step all the channels of a FED together, the engine
+     * measures the tick mark at each step and scans several FEDs at the same time.
+     */
+    Fed9UVmeDevice& setDelays(const std::vector<u16>& fedChannels, const std::vector<u16>& nanoDelays) throw (Fed9UVmeDeviceException);
+
     /**
      * \copydoc Fed9UABC::setApvDisable
      * \throw   Fed9UVmeDeviceException Catches all errors from internal method calls and
@@ -1421,7 +1435,8 @@ namespace Fed9U {
      *         by called methods and rethrow as this type.
      *
      * Once the upload is complete then firmware will not be reloaded and it must be done by a call to
-     * reloadFpgaFirmwareFromCompactFlash. This member function is thread safe.
+     * reloadFpgaFirmwareFromCompactFlash. This member function is thread safe. Fed9UCfDeployer writes an image to several
+     * FEDs at the same time, verifies it and reloads the firmware.
      */
     std::string setCfImageFile(const std::string& cfInputImageFilePath, bool testCf = false, bool setGlobalFirmware = false) throw (Fed9UVmeDeviceException);
 
@@ -1457,6 +1472,29 @@ namespace Fed9U {
      */
     Fed9UVmeDevice& getCfImageFile(u32 mbToReadFromCf, std::string cfOutputImageFile = "UseBinary", u32 maxRev=8) throw (Fed9UVmeDeviceException);
 
+    /**
+     * \brief  Writes one cluster of 256 sectors (128KB) to the compact flash card using block transfers.
+     * \param  cluster Cluster number on the card, the first sector written is 256 times the cluster number.
+     * \param  data The 128KB to write.
+     * \return Self reference.
+     * \throw  Fed9UVmeDeviceException Thrown if the System ACE does not grant a lock, does not become ready or if the
+     *         block transfer fails. All errors are caught and rethrown as this type.
+     *
+     * Used by Fed9UCfDeployer through Fed9UVmeCfTarget to write a Fed9UCfImage to several FEDs at the same time. Unlike
+     * setCfImageFile it does not wait a second after selecting the sectors, the data buffer is polled instead, and each
+     * 32 byte data buffer is written with a single block transfer. The firmware is not reloaded.
+     */
+    Fed9UVmeDevice& writeCfCluster(u32 cluster, const u8* data) throw (Fed9UVmeDeviceException);
+
+    /**
+     * \brief  Reads one cluster of 256 sectors (128KB) from the compact flash card using block transfers.
+     * \param  cluster Cluster number on the card.
+     * \param  data Filled with the 128KB read.
+     * \return Self reference.
+     * \throw  Fed9UVmeDeviceException As for writeCfCluster.
+     */
+    Fed9UVmeDevice& readCfCluster(u32 cluster, u8* data) throw (Fed9UVmeDeviceException);
+
 
     /**
      * \brief  A method to write data to the compact flash (CF) card in the event the system ace control gets locked in a
@@ -1663,15 +1701,25 @@ namespace Fed9U {
      * A true will enable the CF to be read from and a false to be written to. The sector
      * count has a maximum value of 256 and a minimum of 1. The LBA is a pointer to the first 0.5KB block
      * of memory on the CF card that the read/write should start from. It has a maximum value of 128,000
-     * on a 64MB CF card.
+     * on a 64MB CF card. The settle time is waited after the command is sent, in micro seconds.
      */
-    Fed9UVmeDevice& setDataRegionToReadOrWrite(u32 lba, u32 sectorCount, bool read) throw (Fed9UVmeDeviceException);
+    Fed9UVmeDevice& setDataRegionToReadOrWrite(u32 lba, u32 sectorCount, bool read, u32 settleTime = 1000000) throw (Fed9UVmeDeviceException);
 
     /**
      * This polls the data buffer to ensure it is ready to be read.
      */
     Fed9UVmeDevice& checkDataBufferReady() throw (Fed9UVmeDeviceException);
 
+    /**
+     * Resets the Compact Flash (CF) without reloading the firmware and releases the lock granted in getCompactFlashLock.
+     */
+    Fed9UVmeDevice& releaseCompactFlashLock() throw (Fed9UVmeDeviceException);
+
+    /**
+     * Reads or writes one cluster of the CF card for readCfCluster and writeCfCluster.
+     */
+    Fed9UVmeDevice& transferCfCluster(u32 cluster, u8* data, bool read) throw (Fed9UVmeDeviceException);
+
     /**
      * \brief  Scans the available revisions on the CF cards to look for alternate firmware version
      *         and then records the details to the compact flash image file header.
@@ -2078,6 +2126,37 @@ namespace Fed9U {
      */
     const Fed9UVmeDevice& fedCheck()  const throw (Fed9UVmeDeviceException);
 
+    /**
+     * \brief  Reads back the settings compared by Fed9UConfigVerifier.
+     *
+     * The registers are read with one command per FE unit (frame thresholds, OptoRx, ADC controls and APV disables),
+     * one command for all the FE unit enables and one per APV for the strip data. The settings that are not read
+     * back are copied from the local description.
+     * \param  fedSettings Description filled with the settings found on the FED.
+     * \param  sections Fed9UConfigVerifier::Section bits to read back.
+     * \return Self reference.
+     */
+    const Fed9UVmeDevice& readConfiguration(Fed9UDescription& fedSettings, u32 sections = Fed9UConfigVerifier::ALL) const throw (Fed9UVmeDeviceException);
+
+    /**
+     * \brief  Compares the settings on the FED with the local description.
+     * \param  mismatches The differences found are added at the end.
+     * \param  sections Fed9UConfigVerifier::Section bits to compare.
+     * \return u32 Number of differences found.
+     */
+    u32 verifyConfiguration(std::vector<Fed9UConfigMismatch>& mismatches, u32 sections = Fed9UConfigVerifier::ALL) const throw (Fed9UVmeDeviceException);
+
+    /**
+     * \brief  Calls verifyConfiguration on several FEDs, each one in its own thread.
+     * \param  feds FEDs to verify, typically those of a crate.
+     * \param  sections Fed9UConfigVerifier::Section bits to compare.
+     * \param  mismatches Resized to the number of FEDs, element i holds the differences found on feds[i].
+     * \param  errors Resized to the number of FEDs, element i holds the error that stopped the verification of feds[i] or is empty.
+     * \return u32 Number of FEDs with a difference or an error.
+     */
+    static u32 verifyConfigurations(const std::vector<Fed9UVmeDevice*>& feds, u32 sections, std::vector<std::vector<Fed9UConfigMismatch> >& mismatches,
+				    std::vector<std::string>& errors);
+
     // JEC 10-04-06
     /** This method can be used to dump out all read/write FE & BE register information.
      *  Output is in the form of an ostream object, so can be used either to dump to
@@ -2113,6 +2192,16 @@ namespace Fed9U {
     Fed9UVmeDevice& loadDescription(const Fed9UDescription& newDescription) throw (Fed9UVmeDeviceException);
     // </NAC>
 
+    /**
+     * Returns the shadow register model used by loadDescription.
+     *
+     * When the shadow is trusted loadDescription compares the new description with the local one after a spot check
+     * of a few registers, instead of reading the whole FED state back with updateLocalDescriptionFromFed. The local
+     * description is invalidated by the resets and the firmware reloads. It must also be invalidated by the caller if
+     * the description returned by getFed9UVMEDeviceDescription is modified without writing the FED.
+     */
+    Fed9URegisterShadow& getRegisterShadow() { return _shadow; }
+
     /**
      * Returns a const  reference to the local Fed Settings Fed9UDescription object.
      */
@@ -2344,6 +2433,13 @@ namespace Fed9U {
     bool _isStarted;  // !< this variable is set to true when the method start() is called and false when stop() is called
   private:
 
+    /**
+     * Reads the trigger source, the FED ID and the frame thresholds of one FE unit, and compares them with theLocalFedSettings.
+     */
+    bool spotCheckShadow() const throw (Fed9UVmeDeviceException);
+
+    Fed9URegisterShadow _shadow; //!< Trust in theLocalFedSettings as a copy of the FED registers.
+
     /**
      * Fed9UVmeBase has a read/write switch depending on what the method is to do.
      */
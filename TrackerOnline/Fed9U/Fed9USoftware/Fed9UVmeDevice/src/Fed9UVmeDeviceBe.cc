@@ -548,6 +548,7 @@ namespace Fed9U {
   Fed9UVmeDevice& Fed9UVmeDevice::beFpgaSoftReset() throw (Fed9UVmeDeviceException) {
     try {
       theFed->beCommandSoftReset();
+      _shadow.invalidate();
       return *this;
     }
     catch (const ICUtils::ICException& e) {
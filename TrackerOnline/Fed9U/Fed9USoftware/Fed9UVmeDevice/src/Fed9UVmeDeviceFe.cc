@@ -696,6 +696,7 @@ namespace Fed9U {
   Fed9UVmeDevice& Fed9UVmeDevice::feFpgaSoftReset(const Fed9UAddress& feFpga) throw (Fed9UVmeDeviceException) {
     try {
       theFed->feCommandSoftReset(feFpga.getFirmwareFedFeUnit());
+      _shadow.invalidate();
       return *this;
     }
     catch (const ICUtils::ICException& e) {
@@ -992,6 +993,36 @@ namespace Fed9U {
   }
 
 
+  Fed9UVmeDevice& Fed9UVmeDevice::setDelays(const vector<u16>& fedChannels, const vector<u16>& nanoDelays) throw (Fed9UVmeDeviceException) {
+    try {
+      ICUTILS_VERIFY(fedChannels.size() == nanoDelays.size())(fedChannels.size())(nanoDelays.size()).error().msg("One delay is needed per channel");
+      //setDelay writes the four channels of a delay chip from the local description, so the description is updated
+      //for all the channels first and each delay chip is then written once, with the last of its channels given.
+      vector<i32> lastChannelOnChip(DELAY_CHIPS_PER_FED, -1);
+      for (u32 i = 0; i < fedChannels.size(); ++i) {
+	ICUTILS_VERIFY(fedChannels[i] < CHANNELS_PER_FED && nanoDelays[i] < 400)(fedChannels[i])(nanoDelays[i]).error().msg("An invalid delay setting has been passed");
+	theLocalFedSettings.setDelay(Fed9UAddress(static_cast<u8>(fedChannels[i])), nanoDelays[i]/25, nanoDelays[i]%25);
+	lastChannelOnChip[fedChannels[i]/CHANNELS_PER_DELAY_CHIP] = i;
+      }
+      for (u32 delayChip = 0; delayChip < DELAY_CHIPS_PER_FED; ++delayChip) {
+	if (lastChannelOnChip[delayChip] < 0) continue;
+	const u32 i = lastChannelOnChip[delayChip];
+	setDelay(Fed9UAddress(static_cast<u8>(fedChannels[i])), nanoDelays[i]/25, nanoDelays[i]%25);
+      }
+      return *this;
+    }
+    catch (const ICUtils::ICException& e) {
+      RETHROW(e, Fed9UVmeDeviceException(Fed9UVmeDeviceException::ERROR_FED9UVMEDEVICE, "error in Fed9UVmeDevice::setDelays."));
+    }
+    catch (const std::exception &e) {
+      RETHROW(e, Fed9UVmeDeviceException(Fed9UVmeDeviceException::ERROR_FED9UVMEDEVICE, "Caught std::exception."));
+    }
+    catch (...) {
+      THROW(Fed9UVmeDeviceException(Fed9UVmeDeviceException::ERROR_FED9UVMEDEVICE, "Caught unknown exception."));
+    }
+  }
+
+
   Fed9UVmeDevice& Fed9UVmeDevice::setApvDisable(const Fed9UAddress& fedApv, bool apvDisable) throw (Fed9UVmeDeviceException) {
     try {
       u16 fpgaApv_ = fedApv.getFeUnitApv();
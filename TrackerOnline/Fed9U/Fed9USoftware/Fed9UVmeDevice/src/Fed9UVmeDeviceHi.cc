@@ -20,6 +20,7 @@
 #include <cstdio>
 #include <fstream>
 #include <string>
+#include <pthread.h>
 
 namespace Fed9U {
   using std::ostringstream;
@@ -120,6 +121,7 @@ namespace Fed9U {
   Fed9UVmeDevice& Fed9UVmeDevice::sendFedReset(bool doWait) throw (Fed9UVmeDeviceException) {
     try {
       theFed->vmeCommandSoftwareReset(doWait);
+      _shadow.invalidate();
       return *this;
     }
     catch (const ICUtils::ICException& e) {
@@ -764,6 +766,7 @@ namespace Fed9U {
 	}
 	theLocalFedSettings.getFedStrips().setApvStrips(addr, apvStripDescriptions);
       }
+      _shadow.synchronized();
       return *this;
     }
     catch (const ICUtils::ICException& e) {
@@ -1365,26 +1368,11 @@ namespace Fed9U {
    */
   const Fed9UVmeDevice& Fed9UVmeDevice::backEndCheck() const throw (Fed9UVmeDeviceException) {
     try {
-
-      ICUTILS_VERIFY(getTriggerSource() == theLocalFedSettings.getTriggerSource())(getTriggerSource())(theLocalFedSettings.getTriggerSource()).msg("The trigger source setting on the FED does not match that in the theLocalFedSettings");
-
-      ICUTILS_VERIFY(getTestRegister() == theLocalFedSettings.getTestRegister())(getTestRegister())(theLocalFedSettings.getTestRegister()).msg("The getTestRegister() setting on the FED does not match that in the theLocalFedSettings");
-
-      for (u32 feFpga_ = 0; feFpga_ < FEUNITS_PER_FED; feFpga_++) {
-	Fed9UAddress feFpga;
-	feFpga.setFedFeUnit(feFpga_);
-
-	ICUTILS_VERIFY(getFedFeUnitDisable(feFpga) == theLocalFedSettings.getFedFeUnitDisable(feFpga))(static_cast<int>(feFpga.getExternalFedFeUnit()))(getFedFeUnitDisable(feFpga))(theLocalFedSettings.getFedFeUnitDisable(feFpga)).msg("The getFedFeUnitDisable() setting on the FED does not match that in the theLocalFedSettings");
-      }
-
-      ICUTILS_VERIFY(getBeFpgaReadRoute() == theLocalFedSettings.getBeFpgaReadRoute())(getBeFpgaReadRoute())(theLocalFedSettings.getBeFpgaReadRoute()).msg("The getBeFpgaReadRoute() setting on the FED does not match that in the theLocalFedSettings");
-
-       ICUTILS_VERIFY(getHeaderFormatType() == theLocalFedSettings.getHeaderFormatType())(getHeaderFormatType())(theLocalFedSettings.getHeaderFormatType()).msg("The getHeaderFormatType() setting on the FED does not match that in the theLocalFedSettings");
-
-      ICUTILS_VERIFY(getFedBeFpgaDisable() == theLocalFedSettings.getFedBeFpgaDisable())(getFedBeFpgaDisable())(theLocalFedSettings.getFedBeFpgaDisable()).msg("The getFedBeFpgaDisableFlag() setting on the FED does not match that in the theLocalFedSettings");
-
-      ICUTILS_VERIFY(getFedId() == theLocalFedSettings.getFedId())(getFedId())(theLocalFedSettings.getFedId()).msg("The getFedId() setting on the FED does not match that in the theLocalFedSettings");
-
+      vector<Fed9UConfigMismatch> mismatches;
+      verifyConfiguration(mismatches, Fed9UConfigVerifier::BACK_END);
+      stringstream errorMessage;
+      Fed9UConfigVerifier::print(errorMessage, mismatches);
+      ICUTILS_VERIFY(mismatches.empty()).msg(errorMessage.str().c_str()).error();
       return *this;
     }
     catch (const ICUtils::ICException& e) {
@@ -1398,216 +1386,17 @@ namespace Fed9U {
     }
   }
 
-
-
-
-
-
-
   /**
    * This method can be used to compare the values of the Fed9UDescrition to those on the FED for the FE FPGA.
+   * The strip data is also compared unless only the common mode median overrides are requested.
    */
   const Fed9UVmeDevice& Fed9UVmeDevice::frontEndCheck(bool CMMedianOverridOnly) const throw (Fed9UVmeDeviceException) {
     try {
+      vector<Fed9UConfigMismatch> mismatches;
+      verifyConfiguration(mismatches, CMMedianOverridOnly ? Fed9UConfigVerifier::CM_MEDIAN_OVERRIDE : Fed9UConfigVerifier::FRONT_END | Fed9UConfigVerifier::STRIPS);
       stringstream errorMessage;
-      try {
-	ICUTILS_VERIFY(getScopeLength() == theLocalFedSettings.getScopeLength())(getScopeLength())(theLocalFedSettings.getScopeLength()).msg("The Scope Length setting on the FED does not match that in the theLocalFedSettings").error();
-      }
-      catch (ICUtils::ICException & e) {
-	errorMessage << e.what() << endl;
-      }
-      
-      for (u32 feFpga_ = 0; feFpga_ < FEUNITS_PER_FED; ++feFpga_) {
-	Fed9UAddress addr;
-	addr.setFedFeUnit(feFpga_);
-	
-	//u16 inputOffset  = getOptoRxInputOffset(addr);
-	//u16 outputOffset = getOptoRxOutputOffset(addr);
-	//u16 capacitor    = getOptoRxCapacitor(addr);
-	
-	try {
-	  //ICUTILS_VERIFY(inputOffset == theLocalFedSettings.getOptoRxInputOffset(addr))(static_cast<int>(Fed9UAddress().setFedFeUnit(feFpga_).getExternalFedFeUnit()))(inputOffset)(theLocalFedSettings.getOptoRxInputOffset(addr)).msg("The setting OptoRxInputOffsets on the FED does not match that in the theLocalFedSettings").error();
-	}
-	catch (ICUtils::ICException & e) {
-	  errorMessage << e.what() << endl;
-	}
-	
-	try {
-	  //ICUTILS_VERIFY(outputOffset == theLocalFedSettings.getOptoRxOutputOffset(addr))(static_cast<int>(Fed9UAddress().setFedFeUnit(feFpga_).getExternalFedFeUnit()))(outputOffset)(theLocalFedSettings.getOptoRxOutputOffset(addr)).msg("The setting OptoRxOutputOffsets on the FED does not match that in the theLocalFedSettings").error();
-	}
-	catch (ICUtils::ICException & e) {
-	  errorMessage << e.what() << endl;
-	}
-	
-	try {
-	  //ICUTILS_VERIFY(capacitor == theLocalFedSettings.getOptoRxCapacitor(addr))(static_cast<int>(Fed9UAddress().setFedFeUnit(feFpga_).getExternalFedFeUnit()))(capacitor)(theLocalFedSettings.getOptoRxCapacitor(addr)).msg("The setting OptoRxCapacitor on the FED does not match that in the theLocalFedSettings").error();
-	}
-	catch (ICUtils::ICException & e) {
-	  errorMessage << e.what() << endl;
-	}
-	
-	bool medianOverrideDisable;
-	vector<u16> medianValues = getCmMedianOverride(addr, medianOverrideDisable);
-	bool descriptionMedianOverrideDisable;
-	vector<u16> descriptionMedianValues = theLocalFedSettings.getCmMedianOverride(addr, descriptionMedianOverrideDisable);
-	try {
-	  ICUTILS_VERIFY(medianOverrideDisable == descriptionMedianOverrideDisable)(static_cast<int>(Fed9UAddress().setFedFeUnit(feFpga_).getExternalFedFeUnit()))(medianOverrideDisable)(descriptionMedianOverrideDisable).msg("The setting median over-ride disable setting on the FED does not match that in the theLocalFedSettings").error();
-	}
-	catch (ICUtils::ICException & e) {
-	  errorMessage << e.what() << endl;
-	}
-	
-	for (u32 fpgaApv_ = 0; fpgaApv_ < APVS_PER_FEUNIT; ++fpgaApv_) {
-	  try {
-	    ICUTILS_VERIFY(medianValues[fpgaApv_] == descriptionMedianValues[fpgaApv_])(static_cast<int>(Fed9UAddress().setFeUnitApv(fpgaApv_).getExternalFeUnitApv()))(medianValues[fpgaApv_])(descriptionMedianValues[fpgaApv_]).msg("The median over-ride value on the FED does not match that in the theLocalFedSettings").error();
-	  }
-	  catch (ICUtils::ICException & e) {
-	    errorMessage << e.what() << endl;
-	  }
-	}
-	
-      }
-
-
-// if we only want to check Median Override values we verify here and return
-      if(CMMedianOverridOnly) {
-        ICUTILS_VERIFY(errorMessage.str().size() == 0).msg(errorMessage.str().c_str()).error();
-        return *this;
-      }
-      // the following map is used to map a channel number directly to it's paired channel number, i.e. channel 0 maps to 3 since 3 is stored at location 0 in the map.
-      const u16 channelPairMap[12] = {3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8};
-
-      Fed9UAddress tempAddress;
-
-      for (u32 fedChannel_ = 0; fedChannel_ < CHANNELS_PER_FED; ++fedChannel_) {
-	Fed9UAddress addr;
-	
-	addr.setFedChannel(fedChannel_);
-	
-	//If all the APVs on an ADC channel pair are disabled then the ADC is off so we will not match description, but it should be set to 0.
-	tempAddress.setFedChannel(fedChannel_); //note you have to set the actual channel to ensure you get the write set of 4 apvs below <JRF> BUG FIX 18/10/2006
-	Fed9UAddress apv0(tempAddress.getFedChannel(), 0);
-	Fed9UAddress apv1(tempAddress.getFedChannel(), 1);
-	tempAddress.setFedChannel(channelPairMap[fedChannel_%12]);
-	Fed9UAddress apv2( tempAddress.getFedChannel(), 0 );
-	Fed9UAddress apv3( tempAddress.getFedChannel(), 1 );
-	const bool channelPairDisabled=( theLocalFedSettings.getApvDisable(apv0) && theLocalFedSettings.getApvDisable(apv1) && theLocalFedSettings.getApvDisable(apv2) && theLocalFedSettings.getApvDisable(apv3) );
-	
-	
-	
-	try {
-	  ICUTILS_VERIFY(getFrameThreshold(addr) == theLocalFedSettings.getFrameThreshold(addr))(static_cast<int>(Fed9UAddress().setFedChannel(fedChannel_).getExternalFedChannel()))(getFrameThreshold(addr))(theLocalFedSettings.getFrameThreshold(addr)).msg("The setting frame thresholds on the FED does not match that in the theLocalFedSettings").error();
-	}
-	catch (ICUtils::ICException & e) {
-	  errorMessage << e.what() << endl;
-	}
-	
-	if (_isStarted && !channelPairDisabled) {// note that when the fed is stopped all adcs are off to conserve power, also if all apvs on a channel pair are disabled then the adc is disabled 
-
-	  Fed9UAdcControls theFedAdcControl( getAdcControls(addr) );
-	  Fed9UAdcControls theLocalFedAdcSettings( theLocalFedSettings.getAdcControls(addr) );
-	  
-	  try {
-	    ICUTILS_VERIFY(theFedAdcControl._dfsen == theLocalFedAdcSettings._dfsen)(static_cast<int>(Fed9UAddress().setFedChannel(fedChannel_).getExternalFedChannel()))(theFedAdcControl._dfsen)(theLocalFedAdcSettings._dfsen).msg("The ADC control setting dfsen on the FED does not match that in the theLocalFedAdcSettings").error();
-	  }
-	  catch (ICUtils::ICException & e) {
-	    errorMessage << e.what() << endl;
-	  }	  
-	  try {
-	    ICUTILS_VERIFY(theFedAdcControl._dfsval == theLocalFedAdcSettings._dfsval)(static_cast<int>(Fed9UAddress().setFedChannel(fedChannel_).getExternalFedChannel()))(theFedAdcControl._dfsval)(theLocalFedAdcSettings._dfsval).msg("The ADC control setting dfsval on the FED does not match that in the theLocalFedAdcSettings").error();
-	  }
-	  catch (ICUtils::ICException & e) {
-	    errorMessage << e.what() << endl;
-	  }
-	  try {
-	    ICUTILS_VERIFY(theFedAdcControl._s1 == theLocalFedAdcSettings._s1)(static_cast<int>(Fed9UAddress().setFedChannel(fedChannel_).getExternalFedChannel()))(theFedAdcControl._s1)(theLocalFedAdcSettings._s1).msg("The ADC control setting s1 on the FED does not match that in the theLocalFedAdcSettings").error();
-	  }
-	  catch (ICUtils::ICException & e) {
-	    errorMessage << e.what() << endl;
-	  }
-	  
-	  try {
-	    ICUTILS_VERIFY(theFedAdcControl._s2 == theLocalFedAdcSettings._s2)(static_cast<int>(Fed9UAddress().setFedChannel(fedChannel_).getExternalFedChannel()))(theFedAdcControl._s2)(theLocalFedAdcSettings._s2).msg("The ADC control setting s2 on the FED does not match that in the theLocalFedAdcSettings").error();
-	  }
-	  catch (ICUtils::ICException & e) {
-	    errorMessage << e.what() << endl;
-	  }
-	}
-      }
-      
-      for (u32 fedApv_ = 0; fedApv_ < APVS_PER_FED; fedApv_++) {
-	Fed9UAddress addr;
-	addr.setFedApv(fedApv_);
-	
-	vector<u16> pedestals(128,0);
-	vector<bool> disableStrips(128,0);
-	u16 numberValidStrips;
-	getPedsAndDisabledStrips(addr, pedestals, disableStrips, numberValidStrips);
-	
-	vector<u16> highThresholds(128,0);
-	vector<u16> lowThresholds(128,0);
-	getClusterThresholds(addr, highThresholds, lowThresholds);
-	
-	vector<Fed9UStripDescription> apvStripDescription( theLocalFedSettings.getFedStrips().getApvStrips(addr) );
-	
-	for (u32 apvStrip_ = 0; apvStrip_ < STRIPS_PER_APV; apvStrip_++) {
-	  addr.setApvStrip(apvStrip_);
-	  
-	  try {
-	    ICUTILS_VERIFY(pedestals[apvStrip_] == apvStripDescription[apvStrip_].getPedestal())
-	      (static_cast<int>(addr.getExternalFedChannel()))
-	      (static_cast<int>(addr.getExternalChannelApv()))
-	      (static_cast<int>(addr.getExternalApvStrip()))
-	      (pedestals[apvStrip_])
-	      (apvStripDescription[apvStrip_].getPedestal()).msg("The pedestal settings on the FED does not match that in the theLocalFedSettings").error();
-	  }
-	  catch (ICUtils::ICException & e) {
-	    errorMessage << e.what() << endl;
-	  }
-	  
-	  try {
-	    ICUTILS_VERIFY(disableStrips[apvStrip_] == apvStripDescription[apvStrip_].getDisable())
-	      (static_cast<int>(addr.getExternalFedChannel()))
-	      (static_cast<int>(addr.getExternalChannelApv()))
-	      (static_cast<int>(addr.getExternalApvStrip()))
-	      (static_cast<int>(disableStrips[apvStrip_]))
-	      (apvStripDescription[apvStrip_].getDisable()).msg("The valid channel setting on the FED does not match that in the theLocalFedSettings").error();
-	  }
-	  catch (ICUtils::ICException & e) {
-	    errorMessage << e.what() << endl;
-	  }
-	  
-	  try {
-	    ICUTILS_VERIFY(highThresholds[apvStrip_] == apvStripDescription[apvStrip_].getHighThreshold())
-	      (static_cast<int>(addr.getExternalFedChannel()))
-	      (static_cast<int>(addr.getExternalChannelApv()))
-	      (static_cast<int>(addr.getExternalApvStrip()))
-	      (highThresholds[apvStrip_])
-	      (apvStripDescription[apvStrip_].getHighThreshold()).msg("The high threshold settings on the FED does not match that in the theLocalFedSettings").error();
-	  }
-	  catch (ICUtils::ICException & e) {
-	    errorMessage << e.what() << endl;
-	  }
-	  
-	  try {
-	    ICUTILS_VERIFY(lowThresholds[apvStrip_] == apvStripDescription[apvStrip_].getLowThreshold())(static_cast<int>(Fed9UAddress().setApvStrip(apvStrip_).getExternalApvStrip()))(lowThresholds[apvStrip_])(apvStripDescription[apvStrip_].getLowThreshold()).msg("The low threhold settings on the FED does not match that in the theLocalFedSettings").error();
-	  }
-	  catch (ICUtils::ICException & e) {
-	    errorMessage << e.what() << endl;
-	  }
-	}
-
-	if (_isStarted) {// note that when the fed is stopped all adcs are off to conserve power 	
-	  try {
-	    ICUTILS_VERIFY(getApvDisable(addr) == theLocalFedSettings.getApvDisable(addr))(static_cast<int>(Fed9UAddress().setFedApv(fedApv_).getExternalFedApv()))(getApvDisable(addr))(theLocalFedSettings.getApvDisable(addr)).msg("The setting APV disable flag on the FED does not match that in the theLocalFedSettings").error();
-	  }
-	  catch (ICUtils::ICException & e) {
-	    errorMessage << e.what() << endl;
-	  }
-	}
-
-      }
-      ICUTILS_VERIFY(errorMessage.str().size() == 0).msg(errorMessage.str().c_str()).error();      
+      Fed9UConfigVerifier::print(errorMessage, mismatches);
+      ICUTILS_VERIFY(mismatches.empty()).msg(errorMessage.str().c_str()).error();
       return *this;
     }
     catch (const ICUtils::ICException& e) {
@@ -1813,10 +1602,12 @@ namespace Fed9U {
    */
   const Fed9UVmeDevice& Fed9UVmeDevice::fedCheck() const throw (Fed9UVmeDeviceException) {
     try {
-      //cout << "Begin Front end check" << endl;
-      frontEndCheck();
-      //cout << "Begin back end check" << endl;
-      backEndCheck();
+      //The FE and BE FPGA settings are read back and compared in one pass.
+      vector<Fed9UConfigMismatch> mismatches;
+      verifyConfiguration(mismatches, Fed9UConfigVerifier::ALL);
+      stringstream errorMessage;
+      Fed9UConfigVerifier::print(errorMessage, mismatches);
+      ICUTILS_VERIFY(mismatches.empty()).msg(errorMessage.str().c_str()).error();
       //cout << "Begin vme check" << endl;
       vmeCheck();
       //cout << "Begin high level check" << endl;
@@ -1838,6 +1629,194 @@ namespace Fed9U {
     }
   }
 
+  const Fed9UVmeDevice& Fed9UVmeDevice::readConfiguration(Fed9UDescription& fedSettings, u32 sections) const throw (Fed9UVmeDeviceException) {
+    try {
+      fedSettings = theLocalFedSettings;
+
+      if (sections & Fed9UConfigVerifier::BACK_END) {
+	fedSettings.setTriggerSource( getTriggerSource() );
+	fedSettings.setTestRegister( getTestRegister() );
+	fedSettings.setBeFpgaReadRoute( getBeFpgaReadRoute() );
+	fedSettings.setHeaderFormatType( getHeaderFormatType() );
+	fedSettings.setFedBeFpgaDisable( getFedBeFpgaDisable() );
+	fedSettings.setFedId( getFedId() );
+	//One bit per FE unit, set if the FE unit is enabled.
+	u32 feFpgaEnable = 0;
+	theFed->beCommandFeEnableReg(READ, dummyWord, feFpgaEnable);
+	for (u32 feFpga_ = 0; feFpga_ < FEUNITS_PER_FED; ++feFpga_) {
+	  Fed9UAddress addr;
+	  addr.setFedFeUnit(feFpga_);
+	  fedSettings.setFedFeUnitDisable(addr, !((feFpgaEnable >> feFpga_) & 0x1));
+	}
+      }
+
+      if (sections & (Fed9UConfigVerifier::CM_MEDIAN_OVERRIDE | Fed9UConfigVerifier::FRONT_END)) {
+	for (u32 feFpga_ = 0; feFpga_ < FEUNITS_PER_FED; ++feFpga_) {
+	  Fed9UAddress addr;
+	  addr.setFedFeUnit(feFpga_);
+	  bool medianOverrideDisable;
+	  vector<u16> medianValues = getCmMedianOverride(addr, medianOverrideDisable);
+	  fedSettings.setCmMedianOverride(addr, medianOverrideDisable, medianValues);
+	}
+      }
+
+      if (sections & Fed9UConfigVerifier::FRONT_END) {
+	fedSettings.setScopeLength( getScopeLength() );
+	//The ADC bit shifts are those of getAdcControls.
+	const u16 bitShiftValue[12] = {20, 16, 16, 20, 12, 8, 8, 12, 4, 0, 0, 4};
+	for (u32 feFpga_ = 0; feFpga_ < FEUNITS_PER_FED; ++feFpga_) {
+	  Fed9UAddress addr;
+	  addr.setFedFeUnit(feFpga_);
+	  const u16 feFirmware = addr.getFirmwareFedFeUnit();
+
+	  vector<u32> optoRxSettings;
+	  theFed->feCommandOptoControl(feFirmware, READ, dummyVector, optoRxSettings);
+	  fedSettings.setOptoRxInputOffset( addr, optoRxSettings[0] & 0xf );
+	  fedSettings.setOptoRxOutputOffset( addr, (optoRxSettings[0] >> 4) & 0x3 );
+	  fedSettings.setOptoRxCapacitor( addr, (optoRxSettings[0] >> 6) & 0x3 );
+
+	  vector<u32> threshValues(CHANNELS_PER_FEUNIT, 0);
+	  theFed->feCommandLoadThresh(feFirmware, READ, dummyVector, threshValues);
+	  vector<u32> adcSettings;
+	  theFed->feCommandAdcControl(feFirmware, READ, dummyVector, adcSettings);
+	  for (u32 fpgaChannel_ = 0; fpgaChannel_ < CHANNELS_PER_FEUNIT; ++fpgaChannel_) {
+	    addr.setFeUnitChannel(fpgaChannel_);
+	    fedSettings.setFrameThreshold(addr, 32 * threshValues[fpgaChannel_]);
+	    Fed9UAdcControls adcControls;
+	    adcControls._dfsen  = ( adcSettings[0] >> (bitShiftValue[fpgaChannel_]+3) ) & 0x1;
+	    adcControls._dfsval = ( adcSettings[0] >> (bitShiftValue[fpgaChannel_]+2) ) & 0x1;
+	    adcControls._s1     = ( adcSettings[0] >> (bitShiftValue[fpgaChannel_]+1) ) & 0x1;
+	    adcControls._s2     = ( adcSettings[0] >>  bitShiftValue[fpgaChannel_]    ) & 0x1;
+	    fedSettings.setAdcControls(addr, adcControls);
+	  }
+
+	  //Bit (APVS_PER_FEUNIT-1 - APV) of the tick register is set if the APV is enabled.
+	  vector<u32> apvAll;
+	  theFed->feCommandLoadTick(feFirmware, READ, dummyVector, apvAll);
+	  for (u32 fpgaApv_ = 0; fpgaApv_ < APVS_PER_FEUNIT; ++fpgaApv_) {
+	    Fed9UAddress apv;
+	    apv.setFedFeUnit(feFpga_).setFeUnitApv(fpgaApv_);
+	    fedSettings.setApvDisable(apv, !((apvAll[0] >> (APVS_PER_FEUNIT-1 - fpgaApv_)) & 0x1));
+	  }
+	}
+      }
+
+      if (sections & Fed9UConfigVerifier::STRIPS) {
+	for (u32 fedApv_ = 0; fedApv_ < APVS_PER_FED; ++fedApv_) {
+	  Fed9UAddress addr;
+	  addr.setFedApv(fedApv_);
+
+	  //The strip data comes back in the APV order, the number of valid strips is not needed here.
+	  vector<u16> disOrderedPeds(STRIPS_PER_APV, 0), disOrderedValStrips(STRIPS_PER_APV, 0);
+	  getPedsAndDisabledStripData(addr, disOrderedPeds, disOrderedValStrips);
+	  vector<u16> pedestals, validStrips;
+	  reOrderingAlgorithm(disOrderedPeds, pedestals);
+	  reOrderingAlgorithm(disOrderedValStrips, validStrips);
+
+	  vector<u16> highThresholds(STRIPS_PER_APV, 0), lowThresholds(STRIPS_PER_APV, 0);
+	  getClusterData(addr, highThresholds, lowThresholds);
+
+	  vector<Fed9UStripDescription> apvStripDescriptions(STRIPS_PER_APV);
+	  for (u32 apvStrip_ = 0; apvStrip_ < STRIPS_PER_APV; ++apvStrip_) {
+	    apvStripDescriptions[apvStrip_].setPedestal( pedestals[apvStrip_] );
+	    apvStripDescriptions[apvStrip_].setDisable( !validStrips[apvStrip_] );
+	    apvStripDescriptions[apvStrip_].setLowThreshold( lowThresholds[apvStrip_] );
+	    apvStripDescriptions[apvStrip_].setHighThreshold( highThresholds[apvStrip_] );
+	  }
+	  fedSettings.getFedStrips().setApvStrips(addr, apvStripDescriptions);
+	}
+      }
+      return *this;
+    }
+    catch (const ICUtils::ICException& e) {
+      RETHROW(e, Fed9UVmeDeviceException(Fed9UVmeDeviceException::ERROR_FED9UVMEDEVICE, "error in Fed9UVmeDevice::readConfiguration."));
+    }
+    catch (const std::exception &e) {
+      RETHROW(e, Fed9UVmeDeviceException(Fed9UVmeDeviceException::ERROR_FED9UVMEDEVICE, "Caught std::exception."));
+    }
+    catch (...) {
+      THROW(Fed9UVmeDeviceException(Fed9UVmeDeviceException::ERROR_FED9UVMEDEVICE, "Caught unknown exception."));
+    }
+  }
+
+  u32 Fed9UVmeDevice::verifyConfiguration(vector<Fed9UConfigMismatch>& mismatches, u32 sections) const throw (Fed9UVmeDeviceException) {
+    try {
+      Fed9UDescription fedSettings;
+      readConfiguration(fedSettings, sections);
+      //When the FED is stopped all the ADCs are off to conserve power.
+      return Fed9UConfigVerifier::compare(theLocalFedSettings, fedSettings, sections, _isStarted, mismatches);
+    }
+    catch (const ICUtils::ICException& e) {
+      RETHROW(e, Fed9UVmeDeviceException(Fed9UVmeDeviceException::ERROR_FED9UVMEDEVICE, "error in Fed9UVmeDevice::verifyConfiguration."));
+    }
+    catch (const std::exception &e) {
+      RETHROW(e, Fed9UVmeDeviceException(Fed9UVmeDeviceException::ERROR_FED9UVMEDEVICE, "Caught std::exception."));
+    }
+    catch (...) {
+      THROW(Fed9UVmeDeviceException(Fed9UVmeDeviceException::ERROR_FED9UVMEDEVICE, "Caught unknown exception."));
+    }
+  }
+
+  namespace {
+
+    /**
+     * Arguments and results of the verification of one FED by Fed9UVmeDevice::verifyConfigurations.
+     */
+    struct ConfigVerification {
+      const Fed9UVmeDevice* _fed;
+      u32 _sections;
+      vector<Fed9UConfigMismatch>* _mismatches;
+      string* _error;
+    };
+
+    void* verifyConfigurationThread(void* param) {
+      ConfigVerification& verification = *static_cast<ConfigVerification*>(param);
+      try {
+	verification._fed->verifyConfiguration(*verification._mismatches, verification._sections);
+      }
+      catch (const ICUtils::ICException& e) {
+	*verification._error = e.what();
+      }
+      catch (const std::exception &e) {
+	*verification._error = e.what();
+      }
+      catch (...) {
+	*verification._error = "Caught unknown exception.";
+      }
+      return NULL;
+    }
+
+  }
+
+  u32 Fed9UVmeDevice::verifyConfigurations(const vector<Fed9UVmeDevice*>& feds, u32 sections, vector<vector<Fed9UConfigMismatch> >& mismatches,
+					   vector<string>& errors) {
+    mismatches.assign(feds.size(), vector<Fed9UConfigMismatch>());
+    errors.assign(feds.size(), string());
+    vector<ConfigVerification> verifications(feds.size());
+    vector<pthread_t> threads(feds.size());
+    vector<bool> running(feds.size(), false);
+
+    for (u32 fed = 0; fed < feds.size(); ++fed) {
+      ConfigVerification verification = { feds[fed], sections, &mismatches[fed], &errors[fed] };
+      verifications[fed] = verification;
+      if (feds[fed] == NULL) {
+	errors[fed] = "No FED given.";
+      } else if (pthread_create(&threads[fed], NULL, &verifyConfigurationThread, &verifications[fed]) == 0) {
+	running[fed] = true;
+      } else {
+	Fed9UMessage<Fed9UDebugLevel>(FED9U_DEBUG_LEVEL_DETAILED) << "Thread creation failed, verifying the FED in the calling thread." << endl;
+	verifyConfigurationThread(&verifications[fed]);
+      }
+    }
+
+    u32 failedFeds = 0;
+    for (u32 fed = 0; fed < feds.size(); ++fed) {
+      if (running[fed]) pthread_join(threads[fed], NULL);
+      if (!mismatches[fed].empty() || !errors[fed].empty()) ++failedFeds;
+    }
+    return failedFeds;
+  }
+
   // JEC 10-04-06
   // dumpChoice = 1 BE registers only
   // dumpChoice = 2 FE registers only
@@ -1928,6 +1907,8 @@ namespace Fed9U {
 
       //delete &theLocalFedSettings;
       theLocalFedSettings = newFed9UDescription;//*new Fed9UDescription(newFed9UDescription);
+      //The new settings are not on the FED yet, and init resets it.
+      _shadow.invalidate();
 
       if (initFed) {
 	init();
@@ -1968,10 +1949,17 @@ namespace Fed9U {
       //save state
       bool wasStarted = _isStarted;
       bool resetDone = false;
-      //update the description from the FED
+      //update the description from the FED, unless the registers written by this object can be trusted
       try {
-        updateLocalDescriptionFromFed();
+        bool readBack = !_shadow.useShadow();
+        if (!readBack && !spotCheckShadow()) {
+          Fed9UMessage<Fed9UDebugLevel>(FED9U_DEBUG_LEVEL_DETAILED) << "The FED registers differ from the local description, it will be read back.\n";
+          _shadow.spotCheckFailed();
+          readBack = true;
+        }
+        if (readBack) updateLocalDescriptionFromFed();
       } catch (const ICUtils::ICException& e) {
+        _shadow.invalidate();
         ostringstream errorUpdateDescription;
         errorUpdateDescription << "Exception caught while updating local description from FED. " << std::endl;
         errorUpdateDescription << e.what() << std::endl;
@@ -1983,6 +1971,7 @@ namespace Fed9U {
       //if not the change to the new description
       Fed9UDescription oldDescription = theLocalFedSettings;
       theLocalFedSettings = newDescription;
+      _shadow.written();
       Fed9UAddress addr;
       //update settings on Fed
       if (newDescription.getTtcrx() != oldDescription.getTtcrx()) setTtcrx(theLocalFedSettings.getTtcrx());
@@ -2056,18 +2045,49 @@ namespace Fed9U {
       if (wasStarted) start();
       return *this;
     } 
+    //The new settings may have been written in part.
     catch (const ICUtils::ICException& e) {
+      _shadow.invalidate();
       RETHROW(e, Fed9UVmeDeviceException(Fed9UVmeDeviceException::ERROR_FED9UVMEDEVICE, "error in Fed9UVmeDevice::loadDescription."));
     }
     catch (const std::exception &e) {
+      _shadow.invalidate();
       RETHROW(e, Fed9UVmeDeviceException(Fed9UVmeDeviceException::ERROR_FED9UVMEDEVICE, "Caught std::exception."));
     }
     catch (...) {
+      _shadow.invalidate();
       THROW(Fed9UVmeDeviceException(Fed9UVmeDeviceException::ERROR_FED9UVMEDEVICE, "Caught unknown exception."));
     }
   }
   // </NAC>
 
+  bool Fed9UVmeDevice::spotCheckShadow() const throw (Fed9UVmeDeviceException) {
+    try {
+      if (getTriggerSource() != theLocalFedSettings.getTriggerSource()) return false;
+      if (getFedId() != theLocalFedSettings.getFedId()) return false;
+      //The thresholds of the twelve channels of a FE unit are read in a single command.
+      Fed9UAddress addr;
+      addr.setFedFeUnit(_shadow.getSpotCheckFeUnit());
+      vector<u32> thresholds(CHANNELS_PER_FEUNIT, 0);
+      theFed->feCommandLoadThresh(addr.getFirmwareFedFeUnit(), READ, dummyVector, thresholds);
+      for (u32 channel = 0; channel < CHANNELS_PER_FEUNIT; ++channel) {
+	addr.setFeUnitChannel(channel);
+	//The FED stores the threshold in steps of 32, rounded as in setFrameThreshold.
+	if (thresholds[channel] != static_cast<u32>(static_cast<float>(theLocalFedSettings.getFrameThreshold(addr))/32.0 + 0.5)) return false;
+      }
+      return true;
+    }
+    catch (const ICUtils::ICException& e) {
+      RETHROW(e, Fed9UVmeDeviceException(Fed9UVmeDeviceException::ERROR_FED9UVMEDEVICE, "error in Fed9UVmeDevice::spotCheckShadow."));
+    }
+    catch (const std::exception &e) {
+      RETHROW(e, Fed9UVmeDeviceException(Fed9UVmeDeviceException::ERROR_FED9UVMEDEVICE, "Caught std::exception."));
+    }
+    catch (...) {
+      THROW(Fed9UVmeDeviceException(Fed9UVmeDeviceException::ERROR_FED9UVMEDEVICE, "Caught unknown exception."));
+    }
+  }
+
   /**
    * This method is used to ensure that either the FE FPGA DAQ mode is the same on all the FE FPGAs and that
    * the BE FPGA is in the same mode as the FE FPGAs.
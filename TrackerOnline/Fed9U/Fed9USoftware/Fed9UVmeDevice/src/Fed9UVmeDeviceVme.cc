@@ -625,6 +625,8 @@ namespace Fed9U {
    */
   Fed9UVmeDevice& Fed9UVmeDevice::resetSystemAce() throw (Fed9UVmeDeviceException) {
     try {
+      //The firmware is reloaded and all the FPGA registers are lost, even if the reset fails.
+      _shadow.invalidate();
       setSysAceWordMode();
       //First get the existing configuration settings.
       //This is the word address. The byte address is 0x18.
@@ -657,6 +659,8 @@ namespace Fed9U {
   Fed9UVmeDevice& Fed9UVmeDevice::reloadFpgaFirmwareFromCompactFlash(u32 revision) throw (Fed9UVmeDeviceException) {
     try {
       ICUTILS_VERIFY(revision < 8)(revision).error().msg("The config address is invalid.");
+      //All the FPGA registers are lost, even if the reload fails.
+      _shadow.invalidate();
       std::cout << "Reloading firmware!!!!!!!!!!!!!!!! 1: " << theLocalFedSettings.getFedHardwareId() << std::endl;
       setSysAceWordMode();
       std::cout << "Reloading firmware!!!!!!!!!!!!!!!! 2: " << theLocalFedSettings.getFedHardwareId()  << std::endl;
@@ -2255,9 +2259,9 @@ namespace Fed9U {
    * A true will enable the CF to be read from and a false to be written to. The sector count has
    * a maximum value of 256 and a minimum of 1. The LBA is a pointer to the first 0.5KB block of
    * memory on the CF card that the read/write should start from. It has a maximum value of 128,000
-   * on a 64MB CF card.
+   * on a 64MB CF card. The settle time is waited after the command is sent, in micro seconds.
    */
-  Fed9UVmeDevice& Fed9UVmeDevice::setDataRegionToReadOrWrite(u32 lba, u32 sectorCount, bool read) throw (Fed9UVmeDeviceException) {
+  Fed9UVmeDevice& Fed9UVmeDevice::setDataRegionToReadOrWrite(u32 lba, u32 sectorCount, bool read, u32 settleTime) throw (Fed9UVmeDeviceException) {
     try {
       ICUTILS_VERIFY( (sectorCount >= 1) && (sectorCount <= 256) && (lba <= 128000) )(sectorCount)(lba).error().msg("Either the sector count or the logical block address (lba) is invalid.");
 
@@ -2299,7 +2303,7 @@ namespace Fed9U {
       Fed9UMessage<Fed9UDebugLevel>(FED9U_DEBUG_LEVEL_DETAILED) << msg.str();
       msg.str("");
       //Wait to allow the data buffer to get ready.
-      fed9Uwait(1000000);
+      if (settleTime) fed9Uwait(settleTime);
       return *this;
     } catch (const ICUtils::ICException& e) {
       RETHROW(e, Fed9UVmeDeviceException(Fed9UVmeDeviceException::ERROR_FED9USYSTEMACE, "error in Fed9UVmeDevice::setDataRegionToReadOrWrite."));
@@ -2350,6 +2354,114 @@ namespace Fed9U {
     }
   }
 
+  /**
+   * Resets the Compact Flash (CF) without reloading the firmware and releases the lock granted in getCompactFlashLock.
+   */
+  Fed9UVmeDevice& Fed9UVmeDevice::releaseCompactFlashLock() throw (Fed9UVmeDeviceException) {
+    try {
+      u32 regAddr(0x0c);
+      u32 data( theFed->vmeCommandSysAceControlRead(regAddr) );
+      //Ensure we won't reload after reset.
+      data &= ~0x0010;
+      //Reset
+      data |=  0x0080;
+      theFed->vmeCommandSysAceControlWrite(data, regAddr);
+      //Both lock request and force lock request bits are cleared, once the reset has had the time to complete.
+      fed9Uwait(10000);
+      data &= ~0x0003;
+      theFed->vmeCommandSysAceControlWrite(data, regAddr);
+      //Check that the lock is released
+      u32 maxLoops = 100;
+      u32 loops    = 0;
+      while (theFed->vmeCommandSysAceControlRead(0x02) & 0x0002) {
+	//The MPU lock has not been realeased. Try again.
+	data &= ~0x0003;
+	theFed->vmeCommandSysAceControlWrite(data, regAddr);
+	ICUTILS_VERIFY(loops++ < maxLoops)(theFed->vmeCommandSysAceControlRead(0x02) & 0x0002).error().msg("Could not release the MPU lock on the CF");
+      }
+      return *this;
+    } catch (const ICUtils::ICException& e) {
+      RETHROW(e, Fed9UVmeDeviceException(Fed9UVmeDeviceException::ERROR_FED9USYSTEMACE, "error in Fed9UVmeDevice::releaseCompactFlashLock."));
+    }
+    catch (const std::exception &e) {
+      RETHROW(e, Fed9UVmeDeviceException(Fed9UVmeDeviceException::ERROR_FED9UVMEDEVICE, "Caught std::exception."));
+    }
+    catch (...) {
+      THROW(Fed9UVmeDeviceException(Fed9UVmeDeviceException::ERROR_FED9UVMEDEVICE, "Caught unknown exception."));
+    }
+  }
+
+  Fed9UVmeDevice& Fed9UVmeDevice::transferCfCluster(u32 cluster, u8* data, bool read) throw (Fed9UVmeDeviceException) {
+    try {
+      //A cluster is 256 sectors of 512 bytes, transferred through the 32 byte data buffer of the System ACE.
+      const u32 sectorCount = 256;
+      const u32 totalBuffers = sectorCount * 512 / 32;
+      //Each 16 bit word of a data buffer is carried in the lower bits of a 32 bit VME word.
+      const u32 wordsPerBuffer = 16;
+      u32 words[wordsPerBuffer];
+
+      setSysAceWordMode();
+      getCompactFlashLock();
+      //The lock is released and the reset bit cleared whatever happens, so that the transfer can be tried again.
+      try {
+	checkCfReadyForCommands();
+	//The data buffer is polled before each transfer, so there is no need to wait once the sectors are selected.
+	setDataRegionToReadOrWrite(cluster * sectorCount, sectorCount, read, 0);
+	//Prevent CF card from reloading when done.
+	u32 regAddr(0x0c);
+	u32 control( theFed->vmeCommandSysAceControlRead(regAddr) );
+	//Set reset bit.
+	control |=  0x0080;
+	//Set CFGSTART bit low to ensure we don't restart after reset.
+	control &= ~0x0010;
+	theFed->vmeCommandSysAceControlWrite(control, regAddr);
+
+	for (u32 bufferNumber = 0; bufferNumber < totalBuffers; ++bufferNumber) {
+	  checkDataBufferReady();
+	  u8* bytes = data + bufferNumber * 2 * wordsPerBuffer;
+	  if (read) {
+	    theFed->vmeCommandSysAceDataBlockRead(words, wordsPerBuffer);
+	    for (u32 wordNumber = 0; wordNumber < wordsPerBuffer; ++wordNumber) {
+	      bytes[2 * wordNumber]     = words[wordNumber] & 0xff;
+	      bytes[2 * wordNumber + 1] = (words[wordNumber] >> 8) & 0xff;
+	    }
+	  } else {
+	    for (u32 wordNumber = 0; wordNumber < wordsPerBuffer; ++wordNumber) {
+	      words[wordNumber] = bytes[2 * wordNumber] | (bytes[2 * wordNumber + 1] << 8);
+	    }
+	    theFed->vmeCommandSysAceDataBlockWrite(words, wordsPerBuffer);
+	  }
+	}
+      } catch (...) {
+	try {
+	  releaseCompactFlashLock();
+	} catch (...) {
+	  //The first error is the one reported.
+	}
+	throw;
+      }
+      releaseCompactFlashLock();
+      return *this;
+    } catch (const ICUtils::ICException& e) {
+      RETHROW(e, Fed9UVmeDeviceException(Fed9UVmeDeviceException::ERROR_FED9USYSTEMACE, "error in Fed9UVmeDevice::transferCfCluster."));
+    }
+    catch (const std::exception &e) {
+      RETHROW(e, Fed9UVmeDeviceException(Fed9UVmeDeviceException::ERROR_FED9UVMEDEVICE, "Caught std::exception."));
+    }
+    catch (...) {
+      THROW(Fed9UVmeDeviceException(Fed9UVmeDeviceException::ERROR_FED9UVMEDEVICE, "Caught unknown exception."));
+    }
+  }
+
+  Fed9UVmeDevice& Fed9UVmeDevice::writeCfCluster(u32 cluster, const u8* data) throw (Fed9UVmeDeviceException) {
+    //The data are only read when writing to the card.
+    return transferCfCluster(cluster, const_cast<u8*>(data), WRITE);
+  }
+
+  Fed9UVmeDevice& Fed9UVmeDevice::readCfCluster(u32 cluster, u8* data) throw (Fed9UVmeDeviceException) {
+    return transferCfCluster(cluster, data, READ);
+  }
+
   vector<string> Fed9UVmeDevice::setCfFileHeader(u32 maxRev)  throw (Fed9UVmeDeviceException) {
     try {
       std::ostringstream msg;